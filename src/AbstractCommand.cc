@@ -62,6 +62,7 @@
 #include "DownloadContext.h"
 #include "wallclock.h"
 #include "NameResolver.h"
+#include "DNSCache.h"
 #include "uri.h"
 #include "FileEntry.h"
 #include "error_code.h"
@@ -70,6 +71,7 @@
 #ifdef ENABLE_ASYNC_DNS
 #  include "AsyncNameResolver.h"
 #  include "AsyncNameResolverMan.h"
+#  include "DNSRefreshCommand.h"
 #endif // ENABLE_ASYNC_DNS
 
 namespace aria2 {
@@ -100,6 +102,9 @@ AbstractCommand::AbstractCommand(
   if (socket_ && socket_->isOpen()) {
     setReadCheckSocket(socket_);
   }
+  if (socketRecvBuffer_) {
+    socketRecvBuffer_->setCommand(this);
+  }
   if (incNumConnection_) {
     requestGroup->increaseStreamConnection();
   }
@@ -114,8 +119,14 @@ AbstractCommand::~AbstractCommand()
 {
   disableReadCheckSocket();
   disableWriteCheckSocket();
+  if (socketRecvBuffer_) {
+    socketRecvBuffer_->unsetCommand(this);
+  }
 #ifdef ENABLE_ASYNC_DNS
   asyncNameResolverMan_->disableNameResolverCheck(e_, this);
+  if (e_->getDNSCache()->cancelResolution(this)) {
+    e_->setNoWait(true);
+  }
 #endif // ENABLE_ASYNC_DNS
   requestGroup_->decreaseNumCommand();
   requestGroup_->decreaseStreamCommand();
@@ -158,6 +169,14 @@ bool AbstractCommand::shouldProcess() const
     return true;
   }
 
+#ifdef HAVE_LIBNGHTTP2
+  // An HTTP/2 stream has no socket to check: the session command
+  // wakes us up when the stream receives something.
+  if (socketRecvBuffer_ && socketRecvBuffer_->getHttp2Stream()) {
+    return socketRecvBuffer_->hasPendingData();
+  }
+#endif // HAVE_LIBNGHTTP2
+
 #ifdef ENABLE_ASYNC_DNS
   const auto resolverChecked = asyncNameResolverMan_->resolverChecked();
   if (resolverChecked && asyncNameResolverMan_->getStatus() != 0) {
@@ -765,41 +784,83 @@ std::string AbstractCommand::resolveHostname(std::vector<std::string>& addrs,
     return hostname;
   }
 
-  e_->findAllCachedIPAddresses(std::back_inserter(addrs), hostname, port);
-  if (!addrs.empty()) {
-    auto ipaddr = addrs.front();
-    A2_LOG_INFO(fmt(MSG_DNS_CACHE_HIT, getCuid(), hostname.c_str(),
-                    strjoin(std::begin(addrs), std::end(addrs), ", ").c_str()));
-    return ipaddr;
+  bool resolving = false;
+#ifdef ENABLE_ASYNC_DNS
+  resolving = asyncNameResolverMan_->started();
+#endif // ENABLE_ASYNC_DNS
+  if (!resolving) {
+    std::string error;
+    switch (e_->getDNSCache()->lookup(addrs, error, hostname, port)) {
+    case DNSCache::DNS_CACHE_STALE:
+#ifdef ENABLE_ASYNC_DNS
+      if (getOption()->getAsBool(PREF_ASYNC_DNS)) {
+        e_->addCommand(
+            make_unique<DNSRefreshCommand>(e_->newCUID(), hostname, port, e_));
+      }
+#endif // ENABLE_ASYNC_DNS
+      // Without asynchronous DNS, refreshing would block the event
+      // loop.  The stale entry is used until it becomes obsolete, and
+      // then the hostname is resolved as usual.
+    // fall through
+    case DNSCache::DNS_CACHE_HIT: {
+      auto ipaddr = addrs.front();
+      A2_LOG_INFO(
+          fmt(MSG_DNS_CACHE_HIT, getCuid(), hostname.c_str(),
+              strjoin(std::begin(addrs), std::end(addrs), ", ").c_str()));
+      return ipaddr;
+    }
+    case DNSCache::DNS_CACHE_NEGATIVE:
+      onNameResolutionFailure(hostname, error);
+      break;
+    case DNSCache::DNS_CACHE_MISS:
+      break;
+    }
   }
 
   std::string ipaddr;
+  // TTL of the response in seconds, or -1 if it is unknown.
+  int ttl = -1;
 #ifdef ENABLE_ASYNC_DNS
   if (getOption()->getAsBool(PREF_ASYNC_DNS)) {
+    auto& dnsCache = e_->getDNSCache();
     if (!asyncNameResolverMan_->started()) {
+      std::string error;
+      if (dnsCache->takeResolutionError(this, error)) {
+        onNameResolutionFailure(hostname, error);
+      }
+      // If another command is resolving the same hostname, wait for
+      // its result instead of sending the same queries.
+      if (!dnsCache->acquireResolution(hostname, port, this)) {
+        return A2STR::NIL;
+      }
       asyncNameResolverMan_->startAsync(hostname, e_, this);
     }
     switch (asyncNameResolverMan_->getStatus()) {
-    case -1:
-      if (!isProxyRequest(req_->getProtocol(), getOption())) {
-        e_->getRequestGroupMan()
-            ->getOrCreateServerStat(req_->getHost(), req_->getProtocol())
-            ->setError();
+    case -1: {
+      const auto& error = asyncNameResolverMan_->getLastError();
+      if (asyncNameResolverMan_->notFound()) {
+        dnsCache->putNegative(hostname, port, error);
       }
-      throw DL_ABORT_EX2(fmt(MSG_NAME_RESOLUTION_FAILED, getCuid(),
-                             hostname.c_str(),
-                             asyncNameResolverMan_->getLastError().c_str()),
-                         error_code::NAME_RESOLVE_ERROR);
+      if (dnsCache->finishResolution(hostname, port, error)) {
+        e_->setNoWait(true);
+      }
+      onNameResolutionFailure(hostname, error);
+      break;
+    }
     case 0:
       return A2STR::NIL;
 
     case 1:
       asyncNameResolverMan_->getResolvedAddress(addrs);
       if (addrs.empty()) {
+        if (dnsCache->finishResolution(hostname, port, "No address returned")) {
+          e_->setNoWait(true);
+        }
         throw DL_ABORT_EX2(fmt(MSG_NAME_RESOLUTION_FAILED, getCuid(),
                                hostname.c_str(), "No address returned"),
                            error_code::NAME_RESOLVE_ERROR);
       }
+      ttl = asyncNameResolverMan_->getTtl();
       break;
     }
   }
@@ -811,17 +872,40 @@ std::string AbstractCommand::resolveHostname(std::vector<std::string>& addrs,
     if (e_->getOption()->getAsBool(PREF_DISABLE_IPV6)) {
       res.setFamily(AF_INET);
     }
-    res.resolve(addrs, hostname);
+    try {
+      res.resolve(addrs, hostname);
+    }
+    catch (RecoverableException& ex) {
+      if (res.notFound()) {
+        e_->getDNSCache()->putNegative(hostname, port, ex.what());
+      }
+      throw;
+    }
   }
   A2_LOG_INFO(fmt(MSG_NAME_RESOLUTION_COMPLETE, getCuid(), hostname.c_str(),
                   strjoin(std::begin(addrs), std::end(addrs), ", ").c_str()));
-  for (const auto& addr : addrs) {
-    e_->cacheIPAddress(hostname, addr, port);
+  e_->getDNSCache()->put(hostname, addrs, port, std::chrono::seconds(ttl));
+  // The waiting commands find the addresses in the cache.
+  if (e_->getDNSCache()->finishResolution(hostname, port, A2STR::NIL)) {
+    e_->setNoWait(true);
   }
   ipaddr = e_->findCachedIPAddress(hostname, port);
   return ipaddr;
 }
 
+void AbstractCommand::onNameResolutionFailure(const std::string& hostname,
+                                              const std::string& error)
+{
+  if (!isProxyRequest(req_->getProtocol(), getOption())) {
+    e_->getRequestGroupMan()
+        ->getOrCreateServerStat(req_->getHost(), req_->getProtocol())
+        ->setError();
+  }
+  throw DL_ABORT_EX2(fmt(MSG_NAME_RESOLUTION_FAILED, getCuid(),
+                         hostname.c_str(), error.c_str()),
+                     error_code::NAME_RESOLVE_ERROR);
+}
+
 void AbstractCommand::prepareForNextAction(
     std::unique_ptr<CheckIntegrityEntry> checkEntry)
 {
@@ -832,16 +916,10 @@ void AbstractCommand::prepareForNextAction(
   e_->setNoWait(true);
 }
 
-bool AbstractCommand::checkIfConnectionEstablished(
-    const std::shared_ptr<SocketCore>& socket,
-    const std::string& connectedHostname, const std::string& connectedAddr,
-    uint16_t connectedPort)
+void AbstractCommand::onConnectionFailure(
+    const std::string& error, const std::string& connectedHostname,
+    const std::string& connectedAddr, uint16_t connectedPort)
 {
-  std::string error = socket->getSocketError();
-  if (error.empty()) {
-    return true;
-  }
-
   // See also InitiateConnectionCommand::executeInternal()
   e_->markBadIPAddress(connectedHostname, connectedAddr, connectedPort);
   if (e_->findCachedIPAddress(connectedHostname, connectedPort).empty()) {
@@ -862,7 +940,6 @@ bool AbstractCommand::checkIfConnectionEstablished(
   e_->addCommand(
       InitiateConnectionCommandFactory::createInitiateConnectionCommand(
           getCuid(), req_, fileEntry_, requestGroup_, e_));
-  return false;
 }
 
 const std::string&
@@ -929,8 +1006,7 @@ const std::shared_ptr<PieceStorage>& AbstractCommand::getPieceStorage() const
 
 void AbstractCommand::checkSocketRecvBuffer()
 {
-  if (socketRecvBuffer_->bufferEmpty() &&
-      socket_->getRecvBufferedLength() == 0) {
+  if (!socketRecvBuffer_->hasPendingData()) {
     return;
   }
 
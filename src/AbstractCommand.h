@@ -138,6 +138,11 @@ public:
   std::string resolveHostname(std::vector<std::string>& addrs,
                               const std::string& hostname, uint16_t port);
 
+  // Marks the server as erroneous and throws DlAbortEx for the failed
+  // resolution of hostname.
+  void onNameResolutionFailure(const std::string& hostname,
+                               const std::string& error);
+
   void tryReserved();
 
   void setReadCheckSocket(const std::shared_ptr<SocketCore>& socket);
@@ -174,15 +179,15 @@ public:
 
   void prepareForNextAction(std::unique_ptr<CheckIntegrityEntry> checkEntry);
 
-  // Check if socket is connected. If socket is not connected and
+  // Handles the failure to connect to connectedAddr with error.  If
   // there are other addresses to try, command is created using
   // InitiateConnectionCommandFactory and it is pushed to
-  // DownloadEngine and returns false. If no addresses left, DlRetryEx
-  // exception is thrown.
-  bool checkIfConnectionEstablished(const std::shared_ptr<SocketCore>& socket,
-                                    const std::string& connectedHostname,
-                                    const std::string& connectedAddr,
-                                    uint16_t connectedPort);
+  // DownloadEngine. If no addresses left, DlRetryEx exception is
+  // thrown.
+  void onConnectionFailure(const std::string& error,
+                           const std::string& connectedHostname,
+                           const std::string& connectedAddr,
+                           uint16_t connectedPort);
 
   /*
    * Returns true if proxy for the procol indicated by Request::getProtocol()
@@ -41,8 +41,11 @@
 #include <fcntl.h>
 
 #include <cerrno>
+#include <cstdlib>
 #include <cstring>
 #include <cassert>
+#include <vector>
+#include <algorithm>
 
 #include "File.h"
 #include "util.h"
@@ -53,6 +56,7 @@
 #include "DownloadFailureException.h"
 #include "error_code.h"
 #include "LogFactory.h"
+#include "a2functional.h"
 
 namespace aria2 {
 
@@ -66,8 +70,18 @@ AbstractDiskWriter::AbstractDiskWriter(const std::string& filename)
       readOnly_(false),
       enableMmap_(false),
       mapaddr_(nullptr),
-      maplen_(0)
-
+      maplen_(0),
+      enableDirectIO_(false)
+#ifdef HAVE_O_DIRECT
+      ,
+      directFd_(A2_BAD_FD)
+#endif // HAVE_O_DIRECT
+      ,
+      dirtyBegin_(0),
+      dirtyEnd_(0),
+      writebackBegin_(0),
+      writebackEnd_(0),
+      writebackError_(0)
 {
 }
 
@@ -128,8 +142,34 @@ void AbstractDiskWriter::openFile(int64_t totalLength)
   }
 }
 
+namespace {
+// Writes the data of |fd| to the disk, including the disk's write
+// cache, and waits for it.  Returns false on error.
+#ifdef __MINGW32__
+bool syncData(HANDLE fd) { return FlushFileBuffers(fd); }
+#else  // !__MINGW32__
+bool syncData(int fd)
+{
+#  ifdef HAVE_FDATASYNC
+  return fdatasync(fd) == 0;
+#  else  // !HAVE_FDATASYNC
+  return fsync(fd) == 0;
+#  endif // !HAVE_FDATASYNC
+}
+#endif // !__MINGW32__
+} // namespace
+
 void AbstractDiskWriter::closeFile()
 {
+  // The data not waited for yet are synchronized now, so that
+  // waitWriteback() need not open the file again.  A failure is
+  // reported by waitWriteback().
+  if (fd_ != A2_BAD_FD &&
+      (dirtyBegin_ < dirtyEnd_ || writebackBegin_ < writebackEnd_) &&
+      !syncData(fd_)) {
+    writebackError_ = fileError();
+  }
+  dirtyBegin_ = dirtyEnd_ = writebackBegin_ = writebackEnd_ = 0;
 #if defined(HAVE_MMAP) || defined(__MINGW32__)
   if (mapaddr_) {
     int errNum = 0;
@@ -156,6 +196,9 @@ void AbstractDiskWriter::closeFile()
     maplen_ = 0;
   }
 #endif // HAVE_MMAP || defined __MINGW32__
+#ifdef HAVE_O_DIRECT
+  closeDirectFile();
+#endif // HAVE_O_DIRECT
   if (fd_ != A2_BAD_FD) {
 #ifdef __MINGW32__
     CloseHandle(fd_);
@@ -263,7 +306,9 @@ ssize_t AbstractDiskWriter::writeDataInternal(const unsigned char* data,
   }
   else {
     ssize_t writtenLength = 0;
+#ifndef HAVE_PWRITE
     seek(offset);
+#endif // !HAVE_PWRITE
     while ((size_t)writtenLength < len) {
 #ifdef __MINGW32__
       DWORD nwrite;
@@ -276,13 +321,27 @@ ssize_t AbstractDiskWriter::writeDataInternal(const unsigned char* data,
       }
 #else  // !__MINGW32__
       ssize_t ret = 0;
+#  ifdef HAVE_PWRITE
+      // pwrite saves the lseek system call for each write.
+      while ((ret = pwrite(fd_, data + writtenLength, len - writtenLength,
+                           offset + writtenLength)) == -1 &&
+             errno == EINTR)
+        ;
+#  else  // !HAVE_PWRITE
       while ((ret = write(fd_, data + writtenLength, len - writtenLength)) ==
                  -1 &&
              errno == EINTR)
         ;
+#  endif // !HAVE_PWRITE
       if (ret == -1) {
         return -1;
       }
+      if (ret == 0) {
+        // No progress for a non-empty buffer.  Retrying would spin
+        // forever, so treat it as a full device.
+        errno = ENOSPC;
+        return -1;
+      }
       writtenLength += ret;
 #endif // !__MINGW32__
     }
@@ -290,6 +349,53 @@ ssize_t AbstractDiskWriter::writeDataInternal(const unsigned char* data,
   }
 }
 
+#ifdef HAVE_PWRITEV
+ssize_t AbstractDiskWriter::writeDataVectorInternal(const a2iovec* iov,
+                                                    size_t iovcnt,
+                                                    int64_t offset)
+{
+  // pwritev may write less than requested.  The written buffers are
+  // skipped and the partially written one is adjusted in a copy of
+  // |iov|.
+  std::vector<a2iovec> v(iov, iov + iovcnt);
+  auto first = std::begin(v);
+  auto last = std::end(v);
+  ssize_t writtenLength = 0;
+  for (;;) {
+    for (; first != last && first->A2IOVEC_LEN == 0; ++first)
+      ;
+    if (first == last) {
+      break;
+    }
+    ssize_t ret;
+    while ((ret = pwritev(fd_, &*first,
+                          std::min(last - first,
+                                   static_cast<ptrdiff_t>(A2_IOV_MAX)),
+                          offset + writtenLength)) == -1 &&
+           errno == EINTR)
+      ;
+    if (ret == -1) {
+      return -1;
+    }
+    if (ret == 0) {
+      // See writeDataInternal().
+      errno = ENOSPC;
+      return -1;
+    }
+    writtenLength += ret;
+    for (; ret > 0 && static_cast<size_t>(ret) >= first->A2IOVEC_LEN;
+         ++first) {
+      ret -= first->A2IOVEC_LEN;
+    }
+    if (ret > 0) {
+      first->A2IOVEC_BASE = static_cast<char*>(first->A2IOVEC_BASE) + ret;
+      first->A2IOVEC_LEN -= ret;
+    }
+  }
+  return writtenLength;
+}
+#endif // HAVE_PWRITEV
+
 ssize_t AbstractDiskWriter::readDataInternal(unsigned char* data, size_t len,
                                              int64_t offset)
 {
@@ -441,26 +547,244 @@ bool isDiskFullError(int errNum)
 }
 } // namespace
 
+#ifdef HAVE_O_DIRECT
+namespace {
+// O_DIRECT requires the file offset, the length and the buffer
+// address to be aligned to the logical block size of the device.
+// 4096 satisfies both 512 byte and 4KiB sector devices.
+constexpr size_t DIRECT_IO_ALIGNMENT = 4_k;
+constexpr size_t DIRECT_IO_BUFFER_LENGTH = 1_m;
+
+struct DirectIOBuffer {
+  unsigned char* data;
+  DirectIOBuffer() : data(nullptr)
+  {
+    void* p;
+    if (posix_memalign(&p, DIRECT_IO_ALIGNMENT, DIRECT_IO_BUFFER_LENGTH) == 0) {
+      data = static_cast<unsigned char*>(p);
+    }
+  }
+  ~DirectIOBuffer() { free(data); }
+};
+
+// Returns the aligned buffer where the data is staged before it is
+// written with O_DIRECT.  Files are written in the main thread only,
+// so one buffer is shared by all files.
+unsigned char* getDirectIOBuffer()
+{
+  static DirectIOBuffer buf;
+  return buf.data;
+}
+} // namespace
+
+namespace {
+// Copies |len| bytes from |iov| to |dest|.  The copy starts at
+// |iov[idx]| + |off|, and |idx| and |off| are advanced past the
+// copied bytes.
+void gather(unsigned char* dest, size_t len, const a2iovec* iov, size_t& idx,
+            size_t& off)
+{
+  while (len > 0) {
+    auto n = std::min(len, static_cast<size_t>(iov[idx].A2IOVEC_LEN) - off);
+    memcpy(dest, static_cast<const char*>(iov[idx].A2IOVEC_BASE) + off, n);
+    dest += n;
+    len -= n;
+    off += n;
+    if (off == iov[idx].A2IOVEC_LEN) {
+      ++idx;
+      off = 0;
+    }
+  }
+}
+} // namespace
+
+bool AbstractDiskWriter::openDirectFile()
+{
+  if (directFd_ != A2_BAD_FD) {
+    return true;
+  }
+  int fd;
+  while ((fd = a2open(utf8ToWChar(filename_).c_str(),
+                      O_WRONLY | O_BINARY | O_DIRECT, OPEN_MODE)) == -1 &&
+         errno == EINTR)
+    ;
+  if (fd == -1) {
+    int errNum = errno;
+    A2_LOG_WARN(fmt("Opening file %s with O_DIRECT failed: %s. Direct I/O is "
+                    "disabled for this file.",
+                    filename_.c_str(), util::safeStrerror(errNum).c_str()));
+    enableDirectIO_ = false;
+    return false;
+  }
+  util::make_fd_cloexec(fd);
+  directFd_ = fd;
+  return true;
+}
+
+void AbstractDiskWriter::closeDirectFile()
+{
+  if (directFd_ != A2_BAD_FD) {
+    close(directFd_);
+    directFd_ = A2_BAD_FD;
+  }
+}
+
+ssize_t AbstractDiskWriter::writeDataDirect(const a2iovec* iov, size_t iovcnt,
+                                            int64_t offset, size_t len)
+{
+  // [first, last) is the block aligned part of [offset, offset + len),
+  // which is written with O_DIRECT.  The unaligned head and tail are
+  // written through the OS buffer cache, so the file never grows
+  // beyond the written data and no truncation is needed afterwards.
+  const int64_t alignment = DIRECT_IO_ALIGNMENT;
+  int64_t first = (offset + alignment - 1) / alignment * alignment;
+  int64_t last = (offset + static_cast<int64_t>(len)) / alignment * alignment;
+  if (first >= last) {
+    return 0;
+  }
+  auto buf = getDirectIOBuffer();
+  if (!buf || !openDirectFile()) {
+    return 0;
+  }
+  size_t idx = 0;
+  size_t off = 0;
+  if (offset < first) {
+    unsigned char head[DIRECT_IO_ALIGNMENT];
+    gather(head, first - offset, iov, idx, off);
+    if (writeDataInternal(head, first - offset, offset) < 0) {
+      return -1;
+    }
+  }
+  for (auto pos = first; pos < last;) {
+    auto n = std::min(static_cast<int64_t>(DIRECT_IO_BUFFER_LENGTH),
+                      last - pos);
+    gather(buf, n, iov, idx, off);
+    for (ssize_t written = 0; written < n;) {
+      ssize_t ret;
+      while ((ret = pwrite(directFd_, buf + written, n - written,
+                           pos + written)) == -1 &&
+             errno == EINTR)
+        ;
+      if (ret == -1) {
+        if (errno == EINVAL) {
+          // The file system accepted O_DIRECT in open(2), but does not
+          // support it or requires larger alignment.
+          A2_LOG_WARN(fmt("Writing file %s with O_DIRECT failed: %s. Direct "
+                          "I/O is disabled for this file.",
+                          filename_.c_str(),
+                          util::safeStrerror(errno).c_str()));
+          enableDirectIO_ = false;
+          closeDirectFile();
+          return 0;
+        }
+        return -1;
+      }
+      written += ret;
+    }
+    pos += n;
+  }
+  auto tail = offset + static_cast<int64_t>(len) - last;
+  if (tail > 0) {
+    unsigned char data[DIRECT_IO_ALIGNMENT];
+    gather(data, tail, iov, idx, off);
+    if (writeDataInternal(data, tail, last) < 0) {
+      return -1;
+    }
+  }
+  return len;
+}
+#endif // HAVE_O_DIRECT
+
+bool AbstractDiskWriter::tryWriteDataDirect(const a2iovec* iov, size_t iovcnt,
+                                            int64_t offset, size_t len)
+{
+#ifdef HAVE_O_DIRECT
+  if (enableDirectIO_ && !mapaddr_) {
+    auto rv = writeDataDirect(iov, iovcnt, offset, len);
+    if (rv < 0) {
+      throwOnWriteError();
+    }
+    return rv > 0;
+  }
+#endif // HAVE_O_DIRECT
+  return false;
+}
+
+void AbstractDiskWriter::addDirtyRange(int64_t offset, int64_t len)
+{
+  if (len == 0) {
+    return;
+  }
+  if (dirtyBegin_ < dirtyEnd_) {
+    dirtyBegin_ = std::min(dirtyBegin_, offset);
+    dirtyEnd_ = std::max(dirtyEnd_, offset + len);
+  }
+  else {
+    dirtyBegin_ = offset;
+    dirtyEnd_ = offset + len;
+  }
+}
+
 void AbstractDiskWriter::writeData(const unsigned char* data, size_t len,
                                    int64_t offset)
 {
+  addDirtyRange(offset, len);
   ensureMmapWrite(len, offset);
-  if (writeDataInternal(data, len, offset) < 0) {
-    int errNum = fileError();
-    // If the error indicates disk full situation, throw
-    // DownloadFailureException and abort download instantly.
-    if (isDiskFullError(errNum)) {
-      throw DOWNLOAD_FAILURE_EXCEPTION3(
-          errNum,
-          fmt(EX_FILE_WRITE, filename_.c_str(), fileStrerror(errNum).c_str()),
-          error_code::NOT_ENOUGH_DISK_SPACE);
+  if (enableDirectIO_) {
+    a2iovec iov;
+    iov.A2IOVEC_BASE =
+        reinterpret_cast<char*>(const_cast<unsigned char*>(data));
+    iov.A2IOVEC_LEN = len;
+    if (tryWriteDataDirect(&iov, 1, offset, len)) {
+      return;
     }
-    else {
-      throw DL_ABORT_EX3(
-          errNum,
-          fmt(EX_FILE_WRITE, filename_.c_str(), fileStrerror(errNum).c_str()),
-          error_code::FILE_IO_ERROR);
+  }
+  if (writeDataInternal(data, len, offset) < 0) {
+    throwOnWriteError();
+  }
+}
+
+void AbstractDiskWriter::writeDataVector(const a2iovec* iov, size_t iovcnt,
+                                         int64_t offset)
+{
+  size_t len = 0;
+  for (size_t i = 0; i < iovcnt; ++i) {
+    len += iov[i].A2IOVEC_LEN;
+  }
+  addDirtyRange(offset, len);
+  ensureMmapWrite(len, offset);
+  if (tryWriteDataDirect(iov, iovcnt, offset, len)) {
+    return;
+  }
+#ifdef HAVE_PWRITEV
+  if (!mapaddr_) {
+    if (writeDataVectorInternal(iov, iovcnt, offset) < 0) {
+      throwOnWriteError();
     }
+    return;
+  }
+#endif // HAVE_PWRITEV
+  // Without pwritev, or if the file is mapped into memory, the buffers
+  // are written one by one.
+  DiskWriter::writeDataVector(iov, iovcnt, offset);
+}
+
+void AbstractDiskWriter::throwOnWriteError()
+{
+  int errNum = fileError();
+  // If the error indicates disk full situation, throw
+  // DownloadFailureException and abort download instantly.
+  if (isDiskFullError(errNum)) {
+    throw DOWNLOAD_FAILURE_EXCEPTION3(
+        errNum,
+        fmt(EX_FILE_WRITE, filename_.c_str(), fileStrerror(errNum).c_str()),
+        error_code::NOT_ENOUGH_DISK_SPACE);
+  }
+  else {
+    throw DL_ABORT_EX3(
+        errNum,
+        fmt(EX_FILE_WRITE, filename_.c_str(), fileStrerror(errNum).c_str()),
+        error_code::FILE_IO_ERROR);
   }
 }
 
@@ -583,6 +907,13 @@ void AbstractDiskWriter::disableReadOnly() { readOnly_ = false; }
 
 void AbstractDiskWriter::enableMmap() { enableMmap_ = true; }
 
+void AbstractDiskWriter::enableDirectIO()
+{
+#ifdef HAVE_O_DIRECT
+  enableDirectIO_ = true;
+#endif // HAVE_O_DIRECT
+}
+
 void AbstractDiskWriter::dropCache(int64_t len, int64_t offset)
 {
 #ifdef HAVE_POSIX_FADVISE
@@ -600,6 +931,78 @@ void AbstractDiskWriter::flushOSBuffers()
 #else  // !__MINGW32__
   fsync(fd_);
 #endif // __MINGW32__
+  dirtyBegin_ = dirtyEnd_ = writebackBegin_ = writebackEnd_ = 0;
+}
+
+void AbstractDiskWriter::startWriteback()
+{
+  if (dirtyBegin_ >= dirtyEnd_) {
+    return;
+  }
+#ifdef HAVE_SYNC_FILE_RANGE
+  if (fd_ != A2_BAD_FD) {
+    // An error is reported by waitWriteback().
+    sync_file_range(fd_, dirtyBegin_, dirtyEnd_ - dirtyBegin_,
+                    SYNC_FILE_RANGE_WRITE);
+  }
+#endif // HAVE_SYNC_FILE_RANGE
+  if (writebackBegin_ < writebackEnd_) {
+    writebackBegin_ = std::min(writebackBegin_, dirtyBegin_);
+    writebackEnd_ = std::max(writebackEnd_, dirtyEnd_);
+  }
+  else {
+    writebackBegin_ = dirtyBegin_;
+    writebackEnd_ = dirtyEnd_;
+  }
+  dirtyBegin_ = dirtyEnd_ = 0;
+}
+
+bool AbstractDiskWriter::waitWriteback()
+{
+  int errNum = writebackError_;
+  writebackError_ = 0;
+  if (errNum == 0) {
+    // closeFile() leaves nothing to wait for.
+    if (writebackBegin_ >= writebackEnd_ || fd_ == A2_BAD_FD) {
+      return false;
+    }
+    // The range is forgotten even if this fails, so that the caller
+    // does not fail on it again.  It is expected to fall back to a
+    // full flush.
+    writebackBegin_ = writebackEnd_ = 0;
+    if (syncData(fd_)) {
+      return true;
+    }
+    errNum = fileError();
+  }
+  throw DL_ABORT_EX3(
+      errNum,
+      fmt(EX_FILE_WRITE, filename_.c_str(), fileStrerror(errNum).c_str()),
+      error_code::FILE_IO_ERROR);
+}
+
+int64_t AbstractDiskWriter::seekData(int64_t offset)
+{
+#if defined(SEEK_DATA) && !defined(__MINGW32__)
+  if (fd_ == A2_BAD_FD) {
+    return offset;
+  }
+  auto r = a2lseek(fd_, offset, SEEK_DATA);
+  if (r == -1) {
+    // ENXIO means that there is no data at or after |offset|, so the
+    // rest of the file is a hole.
+    if (errno == ENXIO) {
+      a2_struct_stat st;
+      if (a2fstat(fd_, &st) == 0) {
+        return std::max(offset, static_cast<int64_t>(st.st_size));
+      }
+    }
+    return offset;
+  }
+  return r;
+#else  // !SEEK_DATA || __MINGW32__
+  return offset;
+#endif // !SEEK_DATA || __MINGW32__
 }
 
 } // namespace aria2
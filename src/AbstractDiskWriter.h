@@ -58,14 +58,56 @@ private:
   unsigned char* mapaddr_;
   int64_t maplen_;
 
+  bool enableDirectIO_;
+#ifdef HAVE_O_DIRECT
+  // The file opened with O_DIRECT, which is used to write the block
+  // aligned part of the data.  Opened on first use.
+  int directFd_;
+#endif // HAVE_O_DIRECT
+
+  // [dirtyBegin_, dirtyEnd_) covers the data written since the last
+  // startWriteback(), and [writebackBegin_, writebackEnd_) the data
+  // being written back since then.  A range is empty if its end is
+  // not greater than its beginning.
+  int64_t dirtyBegin_;
+  int64_t dirtyEnd_;
+  int64_t writebackBegin_;
+  int64_t writebackEnd_;
+  // The error with which closeFile() failed to synchronize the data,
+  // which the next waitWriteback() reports.  0 if none.
+  int writebackError_;
+
   ssize_t writeDataInternal(const unsigned char* data, size_t len,
                             int64_t offset);
   ssize_t readDataInternal(unsigned char* data, size_t len, int64_t offset);
+#ifdef HAVE_PWRITEV
+  ssize_t writeDataVectorInternal(const a2iovec* iov, size_t iovcnt,
+                                  int64_t offset);
+#endif // HAVE_PWRITEV
 
   void seek(int64_t offset);
 
   void ensureMmapWrite(size_t len, int64_t offset);
 
+  void throwOnWriteError();
+
+  void addDirtyRange(int64_t offset, int64_t len);
+
+#ifdef HAVE_O_DIRECT
+  bool openDirectFile();
+
+  void closeDirectFile();
+
+  ssize_t writeDataDirect(const a2iovec* iov, size_t iovcnt, int64_t offset,
+                          size_t len);
+#endif // HAVE_O_DIRECT
+
+  // Writes the data with direct I/O if it is enabled and the data
+  // contains at least one aligned block.  Returns true if the data
+  // was written.
+  bool tryWriteDataDirect(const a2iovec* iov, size_t iovcnt, int64_t offset,
+                          size_t len);
+
 protected:
   void createFile(int addFlags = 0);
 
@@ -82,6 +124,9 @@ public:
   virtual void writeData(const unsigned char* data, size_t len,
                          int64_t offset) CXX11_OVERRIDE;
 
+  virtual void writeDataVector(const a2iovec* iov, size_t iovcnt,
+                               int64_t offset) CXX11_OVERRIDE;
+
   virtual ssize_t readData(unsigned char* data, size_t len,
                            int64_t offset) CXX11_OVERRIDE;
 
@@ -99,9 +144,31 @@ public:
 
   virtual void enableMmap() CXX11_OVERRIDE;
 
+  virtual void enableDirectIO() CXX11_OVERRIDE;
+
   virtual void dropCache(int64_t len, int64_t offset) CXX11_OVERRIDE;
 
   virtual void flushOSBuffers() CXX11_OVERRIDE;
+
+  // On Linux, writeback of the data written is started with
+  // sync_file_range(2), so that little is left to do when
+  // waitWriteback() synchronizes the file with fdatasync, or fsync
+  // where fdatasync is missing.  closeFile() synchronizes the data
+  // not waited for yet, so that waitWriteback() never opens the file
+  // again.
+  virtual void startWriteback() CXX11_OVERRIDE;
+
+  virtual bool waitWriteback() CXX11_OVERRIDE;
+
+  // Returns the range passed to startWriteback() and not waited for
+  // yet.  The range is empty if its end is not greater than its
+  // beginning.
+  std::pair<int64_t, int64_t> getWritebackRange() const
+  {
+    return std::make_pair(writebackBegin_, writebackEnd_);
+  }
+
+  virtual int64_t seekData(int64_t offset) CXX11_OVERRIDE;
 };
 
 } // namespace aria2
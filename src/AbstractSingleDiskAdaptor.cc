@@ -38,8 +38,6 @@
 #include "DiskWriter.h"
 #include "FileEntry.h"
 #include "TruncFileAllocationIterator.h"
-#include "WrDiskCacheEntry.h"
-#include "LogFactory.h"
 #ifdef HAVE_SOME_FALLOCATE
 #  include "FallocFileAllocationIterator.h"
 #endif // HAVE_SOME_FALLOCATE
@@ -76,6 +74,12 @@ void AbstractSingleDiskAdaptor::writeData(const unsigned char* data, size_t len,
   diskWriter_->writeData(data, len, offset);
 }
 
+void AbstractSingleDiskAdaptor::writeDataVector(const a2iovec* iov,
+                                                size_t iovcnt, int64_t offset)
+{
+  diskWriter_->writeDataVector(iov, iovcnt, offset);
+}
+
 ssize_t AbstractSingleDiskAdaptor::readData(unsigned char* data, size_t len,
                                             int64_t offset)
 {
@@ -94,18 +98,25 @@ ssize_t AbstractSingleDiskAdaptor::readDataDropCache(unsigned char* data,
   return rv;
 }
 
-void AbstractSingleDiskAdaptor::writeCache(const WrDiskCacheEntry* entry)
+void AbstractSingleDiskAdaptor::flushOSBuffers()
 {
-  for (auto& d : entry->getDataSet()) {
-    A2_LOG_DEBUG(fmt("Cache flush goff=%" PRId64 ", len=%lu", d->goff,
-                     static_cast<unsigned long>(d->len)));
-    writeData(d->data + d->offset, d->len, d->goff);
-  }
+  diskWriter_->flushOSBuffers();
 }
 
-void AbstractSingleDiskAdaptor::flushOSBuffers()
+void AbstractSingleDiskAdaptor::startWriteback()
 {
-  diskWriter_->flushOSBuffers();
+  diskWriter_->startWriteback();
+}
+
+bool AbstractSingleDiskAdaptor::waitWriteback(size_t maxFiles)
+{
+  diskWriter_->waitWriteback();
+  return true;
+}
+
+int64_t AbstractSingleDiskAdaptor::seekData(int64_t offset)
+{
+  return diskWriter_->seekData(offset);
 }
 
 bool AbstractSingleDiskAdaptor::fileExists()
@@ -152,6 +163,11 @@ void AbstractSingleDiskAdaptor::disableReadOnly()
 
 void AbstractSingleDiskAdaptor::enableMmap() { diskWriter_->enableMmap(); }
 
+void AbstractSingleDiskAdaptor::enableDirectIO()
+{
+  diskWriter_->enableDirectIO();
+}
+
 void AbstractSingleDiskAdaptor::cutTrailingGarbage()
 {
   if (File(getFilePath()).size() > totalLength_) {
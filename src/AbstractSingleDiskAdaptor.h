@@ -64,16 +64,23 @@ public:
   virtual void writeData(const unsigned char* data, size_t len,
                          int64_t offset) CXX11_OVERRIDE;
 
+  virtual void writeDataVector(const a2iovec* iov, size_t iovcnt,
+                               int64_t offset) CXX11_OVERRIDE;
+
   virtual ssize_t readData(unsigned char* data, size_t len,
                            int64_t offset) CXX11_OVERRIDE;
 
   virtual ssize_t readDataDropCache(unsigned char* data, size_t len,
                                     int64_t offset) CXX11_OVERRIDE;
 
-  virtual void writeCache(const WrDiskCacheEntry* entry) CXX11_OVERRIDE;
-
   virtual void flushOSBuffers() CXX11_OVERRIDE;
 
+  virtual void startWriteback() CXX11_OVERRIDE;
+
+  virtual bool waitWriteback(size_t maxFiles) CXX11_OVERRIDE;
+
+  virtual int64_t seekData(int64_t offset) CXX11_OVERRIDE;
+
   virtual bool fileExists() CXX11_OVERRIDE;
 
   virtual int64_t size() CXX11_OVERRIDE;
@@ -93,6 +100,8 @@ public:
 
   virtual void enableMmap() CXX11_OVERRIDE;
 
+  virtual void enableDirectIO() CXX11_OVERRIDE;
+
   virtual void cutTrailingGarbage() CXX11_OVERRIDE;
 
   virtual const std::string& getFilePath() = 0;
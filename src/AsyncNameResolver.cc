@@ -35,6 +35,7 @@
 #include "AsyncNameResolver.h"
 
 #include <cstring>
+#include <algorithm>
 
 #include "A2STR.h"
 #include "LogFactory.h"
@@ -48,6 +49,7 @@ void callback(void* arg, int status, int timeouts, struct hostent* host)
   AsyncNameResolver* resolverPtr = reinterpret_cast<AsyncNameResolver*>(arg);
   if (status != ARES_SUCCESS) {
     resolverPtr->error_ = ares_strerror(status);
+    resolverPtr->notFound_ = status == ARES_ENOTFOUND || status == ARES_ENODATA;
     resolverPtr->status_ = AsyncNameResolver::STATUS_ERROR;
     return;
   }
@@ -66,13 +68,52 @@ void callback(void* arg, int status, int timeouts, struct hostent* host)
   }
 }
 
+#ifdef HAVE_ARES_GETADDRINFO
+
+// Unlike ares_gethostbyname(), ares_getaddrinfo() tells us the TTL of
+// the response.
+void addrinfoCallback(void* arg, int status, int timeouts,
+                      struct ares_addrinfo* res)
+{
+  AsyncNameResolver* resolverPtr = reinterpret_cast<AsyncNameResolver*>(arg);
+  if (status != ARES_SUCCESS) {
+    resolverPtr->error_ = ares_strerror(status);
+    resolverPtr->notFound_ = status == ARES_ENOTFOUND || status == ARES_ENODATA;
+    resolverPtr->status_ = AsyncNameResolver::STATUS_ERROR;
+    return;
+  }
+  std::unique_ptr<ares_addrinfo, decltype(&ares_freeaddrinfo)> resDeleter(
+      res, ares_freeaddrinfo);
+  for (auto node = res->nodes; node; node = node->ai_next) {
+    auto endpoint = util::getNumericNameInfo(node->ai_addr, node->ai_addrlen);
+    auto& addrs = resolverPtr->resolvedAddresses_;
+    if (std::find(std::begin(addrs), std::end(addrs), endpoint.addr) !=
+        std::end(addrs)) {
+      continue;
+    }
+    addrs.push_back(endpoint.addr);
+    if (resolverPtr->ttl_ == -1 || node->ai_ttl < resolverPtr->ttl_) {
+      resolverPtr->ttl_ = node->ai_ttl;
+    }
+  }
+  if (resolverPtr->resolvedAddresses_.empty()) {
+    resolverPtr->error_ = "no address returned or address conversion failed";
+    resolverPtr->status_ = AsyncNameResolver::STATUS_ERROR;
+  }
+  else {
+    resolverPtr->status_ = AsyncNameResolver::STATUS_SUCCESS;
+  }
+}
+
+#endif // HAVE_ARES_GETADDRINFO
+
 AsyncNameResolver::AsyncNameResolver(int family
 #ifdef HAVE_ARES_ADDR_NODE
                                      ,
                                      ares_addr_node* servers
 #endif // HAVE_ARES_ADDR_NODE
                                      )
-    : status_(STATUS_READY), family_(family)
+    : status_(STATUS_READY), family_(family), ttl_(-1), notFound_(false)
 {
   // TODO evaluate return value
   ares_init(&channel_);
@@ -92,7 +133,16 @@ void AsyncNameResolver::resolve(const std::string& name)
 {
   hostname_ = name;
   status_ = STATUS_QUERYING;
+#ifdef HAVE_ARES_GETADDRINFO
+  ares_addrinfo_hints hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = family_;
+  hints.ai_socktype = SOCK_STREAM;
+  ares_getaddrinfo(channel_, name.c_str(), nullptr, &hints, addrinfoCallback,
+                   this);
+#else  // !HAVE_ARES_GETADDRINFO
   ares_gethostbyname(channel_, name.c_str(), family_, callback, this);
+#endif // !HAVE_ARES_GETADDRINFO
 }
 
 int AsyncNameResolver::getFds(fd_set* rfdsPtr, fd_set* wfdsPtr) const
@@ -129,6 +179,8 @@ void AsyncNameResolver::reset()
 {
   hostname_ = A2STR::NIL;
   resolvedAddresses_.clear();
+  ttl_ = -1;
+  notFound_ = false;
   status_ = STATUS_READY;
   ares_destroy(channel_);
   // TODO evaluate return value
@@ -49,6 +49,10 @@ namespace aria2 {
 class AsyncNameResolver {
   friend void callback(void* arg, int status, int timeouts,
                        struct hostent* host);
+#ifdef HAVE_ARES_GETADDRINFO
+  friend void addrinfoCallback(void* arg, int status, int timeouts,
+                               struct ares_addrinfo* res);
+#endif // HAVE_ARES_GETADDRINFO
 
 public:
   enum STATUS {
@@ -66,6 +70,9 @@ private:
   std::vector<std::string> resolvedAddresses_;
   std::string error_;
   std::string hostname_;
+  // TTL of the response in seconds, or -1 if unknown.
+  int ttl_;
+  bool notFound_;
 
 public:
   AsyncNameResolver(int family
@@ -86,6 +93,14 @@ public:
 
   const std::string& getError() const { return error_; }
 
+  // Returns the TTL of the response in seconds, or -1 if it is
+  // unknown.
+  int getTtl() const { return ttl_; }
+
+  // Returns true if resolution failed because the hostname does not
+  // exist or has no address of the family.
+  bool notFound() const { return notFound_; }
+
   STATUS getStatus() const { return status_; }
 
   int getFds(fd_set* rfdsPtr, fd_set* wfdsPtr) const;
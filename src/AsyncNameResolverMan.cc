@@ -194,6 +194,35 @@ const std::string& AsyncNameResolverMan::getLastError() const
   return A2STR::NIL;
 }
 
+int AsyncNameResolverMan::getTtl() const
+{
+  int ttl = -1;
+  for (size_t i = 0; i < numResolver_; ++i) {
+    if (asyncNameResolver_[i]->getStatus() ==
+            AsyncNameResolver::STATUS_SUCCESS &&
+        asyncNameResolver_[i]->getTtl() != -1 &&
+        (ttl == -1 || asyncNameResolver_[i]->getTtl() < ttl)) {
+      ttl = asyncNameResolver_[i]->getTtl();
+    }
+  }
+  return ttl;
+}
+
+bool AsyncNameResolverMan::notFound() const
+{
+  if (numResolver_ == 0) {
+    return false;
+  }
+  for (size_t i = 0; i < numResolver_; ++i) {
+    if (asyncNameResolver_[i]->getStatus() !=
+            AsyncNameResolver::STATUS_ERROR ||
+        !asyncNameResolver_[i]->notFound()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void AsyncNameResolverMan::reset(DownloadEngine* e, Command* command)
 {
   disableNameResolverCheck(e, command);
@@ -76,6 +76,12 @@ public:
   int getStatus() const;
   // Returns last error string
   const std::string& getLastError() const;
+  // Returns the smallest TTL of the successful responses in seconds,
+  // or -1 if it is unknown.
+  int getTtl() const;
+  // Returns true if all resolvers failed because the hostname does
+  // not exist.
+  bool notFound() const;
   // Resets state. Also removes resolvers from DownloadEngine.
   void reset(DownloadEngine* e, Command* command);
 
@@ -52,11 +52,14 @@ void AutoSaveCommand::preProcess()
       getDownloadEngine()->isHaltRequested()) {
     enableExit();
   }
+  else {
+    getDownloadEngine()->getRequestGroupMan()->continueCheckpoint();
+  }
 }
 
 void AutoSaveCommand::process()
 {
-  getDownloadEngine()->getRequestGroupMan()->save();
+  getDownloadEngine()->getRequestGroupMan()->checkpoint();
 }
 
 } // namespace aria2
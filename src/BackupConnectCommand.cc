@@ -0,0 +1,245 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2013 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "BackupConnectCommand.h"
+
+#include <algorithm>
+
+#include "RequestGroup.h"
+#include "DownloadEngine.h"
+#include "SocketCore.h"
+#include "wallclock.h"
+#include "RecoverableException.h"
+#include "fmt.h"
+#include "LogFactory.h"
+#include "prefs.h"
+#include "Option.h"
+#include "a2netcompat.h"
+
+namespace aria2 {
+
+namespace {
+bool isIPv4(const std::string& addr)
+{
+  unsigned char buf[sizeof(in_addr)];
+  return inetPton(AF_INET, addr.c_str(), buf) == 0;
+}
+} // namespace
+
+std::vector<std::string>
+createBackupAddressList(const std::string& mainAddr,
+                        const std::vector<std::string>& addrs)
+{
+  std::vector<std::string> same, other;
+  auto mainIPv4 = isIPv4(mainAddr);
+  for (auto& addr : addrs) {
+    if (addr == mainAddr) {
+      continue;
+    }
+    if (isIPv4(addr) == mainIPv4) {
+      same.push_back(addr);
+    }
+    else {
+      other.push_back(addr);
+    }
+  }
+  std::vector<std::string> res;
+  for (size_t i = 0; i < std::max(same.size(), other.size()); ++i) {
+    if (i < other.size()) {
+      res.push_back(other[i]);
+    }
+    if (i < same.size()) {
+      res.push_back(same[i]);
+    }
+  }
+  return res;
+}
+
+BackupConnectInfo::BackupConnectInfo()
+    : cancel(false), mainFailed(false), finished(false)
+{
+}
+
+BackupConnectCommand::BackupConnectCommand(
+    cuid_t cuid, const std::string& hostname, std::vector<std::string> addrs,
+    uint16_t port, std::chrono::milliseconds attemptDelay,
+    const std::shared_ptr<BackupConnectInfo>& info, Command* mainCommand,
+    RequestGroup* requestGroup, DownloadEngine* e)
+    : Command(cuid),
+      hostname_(hostname),
+      addrs_(std::move(addrs)),
+      nextAddr_(0),
+      port_(port),
+      info_(info),
+      mainCommand_(mainCommand),
+      requestGroup_(requestGroup),
+      e_(e),
+      startNow_(false),
+      mainFailureSeen_(false),
+      lastAttemptTime_(global::wallclock()),
+      attemptDelay_(std::move(attemptDelay)),
+      timeoutCheck_(global::wallclock()),
+      timeout_(requestGroup_->getOption()->getAsInt(PREF_CONNECT_TIMEOUT))
+{
+  requestGroup_->increaseStreamCommand();
+  requestGroup_->increaseNumCommand();
+  // Executed in the next loop in DownloadEngine, so that the refresh
+  // interval is set for the first attempt.
+  setStatus(Command::STATUS_ONESHOT_REALTIME);
+}
+
+BackupConnectCommand::~BackupConnectCommand()
+{
+  requestGroup_->decreaseNumCommand();
+  requestGroup_->decreaseStreamCommand();
+  for (auto& attempt : attempts_) {
+    e_->deleteSocketForWriteCheck(attempt.socket, this);
+  }
+  info_->finished = true;
+}
+
+void BackupConnectCommand::startAttempt()
+{
+  while (nextAddr_ < addrs_.size()) {
+    const auto& ipaddr = addrs_[nextAddr_++];
+    A2_LOG_INFO(fmt("CUID#%" PRId64 " - Backup connection attempt to %s",
+                    getCuid(), ipaddr.c_str()));
+    auto socket = std::make_shared<SocketCore>();
+    try {
+      socket->establishConnection(ipaddr, port_);
+      e_->addSocketForWriteCheck(socket, this);
+      attempts_.push_back(Attempt{ipaddr, socket});
+      lastAttemptTime_ = global::wallclock();
+      timeoutCheck_ = global::wallclock();
+      return;
+    }
+    catch (RecoverableException& e) {
+      A2_LOG_INFO_EX(fmt("CUID#%" PRId64 " - Backup connection to %s failed",
+                         getCuid(), ipaddr.c_str()),
+                     e);
+      e_->markBadIPAddress(hostname_, ipaddr, port_);
+    }
+  }
+}
+
+bool BackupConnectCommand::checkAttempts()
+{
+  for (auto i = std::begin(attempts_); i != std::end(attempts_);) {
+    auto& attempt = *i;
+    std::string error;
+    try {
+      if (!attempt.socket->isWritable(0)) {
+        ++i;
+        continue;
+      }
+      error = attempt.socket->getSocketError();
+    }
+    catch (RecoverableException& e) {
+      error = e.what();
+    }
+    e_->deleteSocketForWriteCheck(attempt.socket, this);
+    if (error.empty()) {
+      A2_LOG_INFO(fmt("CUID#%" PRId64 " - Backup connection to %s "
+                      "established",
+                      getCuid(), attempt.ipaddr.c_str()));
+      info_->ipaddr = attempt.ipaddr;
+      info_->socket = attempt.socket;
+      attempts_.erase(i);
+      return true;
+    }
+    A2_LOG_INFO(fmt("CUID#%" PRId64 " - Backup connection to %s failed: %s",
+                    getCuid(), attempt.ipaddr.c_str(), error.c_str()));
+    e_->markBadIPAddress(hostname_, attempt.ipaddr, port_);
+    i = attempts_.erase(i);
+    startNow_ = true;
+  }
+  return false;
+}
+
+void BackupConnectCommand::wakeUpMainCommand()
+{
+  mainCommand_->setStatus(STATUS_ONESHOT_REALTIME);
+  e_->setNoWait(true);
+}
+
+bool BackupConnectCommand::execute()
+{
+  if (requestGroup_->downloadFinished() || requestGroup_->isHaltRequested()) {
+    return true;
+  }
+  if (info_->cancel) {
+    A2_LOG_INFO(
+        fmt("CUID#%" PRId64 " - Backup connection canceled", getCuid()));
+    return true;
+  }
+  if (checkAttempts()) {
+    wakeUpMainCommand();
+    return true;
+  }
+  if (info_->mainFailed && !mainFailureSeen_) {
+    mainFailureSeen_ = true;
+    startNow_ = true;
+  }
+  auto elapsed = lastAttemptTime_.difference(global::wallclock());
+  if (nextAddr_ < addrs_.size() && (startNow_ || elapsed >= attemptDelay_)) {
+    startNow_ = false;
+    startAttempt();
+  }
+  if (attempts_.empty() && nextAddr_ == addrs_.size()) {
+    A2_LOG_INFO(fmt("CUID#%" PRId64 " - All backup connection attempts failed",
+                    getCuid()));
+    wakeUpMainCommand();
+    return true;
+  }
+  if (timeoutCheck_.difference(global::wallclock()) >= timeout_) {
+    A2_LOG_INFO(
+        fmt("CUID#%" PRId64 " - Backup connection command timeout", getCuid()));
+    wakeUpMainCommand();
+    return true;
+  }
+  if (nextAddr_ < addrs_.size()) {
+    // Make sure that we are executed when the next attempt is due,
+    // rather than at the next regular refresh.
+    elapsed = lastAttemptTime_.difference(global::wallclock());
+    e_->setRefreshInterval(
+        elapsed >= attemptDelay_
+            ? std::chrono::milliseconds(0)
+            : std::chrono::duration_cast<std::chrono::milliseconds>(
+                  attemptDelay_ - elapsed));
+  }
+  e_->addCommand(std::unique_ptr<Command>(this));
+  return false;
+}
+
+} // namespace aria2
@@ -0,0 +1,132 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2013 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef BACKUP_CONNECT_COMMAND_H
+#define BACKUP_CONNECT_COMMAND_H
+
+#include "Command.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "TimerA2.h"
+
+namespace aria2 {
+
+class RequestGroup;
+class DownloadEngine;
+class SocketCore;
+
+// Used to communicate mainCommand and backup connection command.
+// When backup connection succeeds, ipaddr is filled with connected
+// address and socket is a socket connected to the ipaddr.  If
+// mainCommand wants to cancel backup connection command, cancel
+// member becomes true.  mainCommand sets mainFailed when its own
+// connection attempt failed.  finished becomes true when backup
+// connection command ends.
+struct BackupConnectInfo {
+  std::string ipaddr;
+  std::shared_ptr<SocketCore> socket;
+  bool cancel;
+  bool mainFailed;
+  bool finished;
+  BackupConnectInfo();
+};
+
+// Returns addrs except mainAddr in the order of connection attempts.
+// As described in RFC 8305 section 4, address families are
+// interleaved, starting with the one mainAddr does not belong to.
+// Otherwise, the order of addrs is kept.
+std::vector<std::string>
+createBackupAddressList(const std::string& mainAddr,
+                        const std::vector<std::string>& addrs);
+
+// Races connection attempts to the addresses other than the one
+// mainCommand connects to, in RFC 8305 "Happy Eyeballs Version 2"
+// fashion.  An attempt to the next address in addrs is started every
+// attemptDelay, or as soon as an attempt, including the one of
+// mainCommand, fails.  Attempts in progress are not canceled when a
+// new one is started.  The first established connection wins, and
+// mainCommand is woken up to use it.
+class BackupConnectCommand : public Command {
+public:
+  BackupConnectCommand(cuid_t cuid, const std::string& hostname,
+                       std::vector<std::string> addrs, uint16_t port,
+                       std::chrono::milliseconds attemptDelay,
+                       const std::shared_ptr<BackupConnectInfo>& info,
+                       Command* mainCommand, RequestGroup* requestGroup,
+                       DownloadEngine* e);
+  ~BackupConnectCommand();
+  virtual bool execute() CXX11_OVERRIDE;
+
+private:
+  struct Attempt {
+    std::string ipaddr;
+    std::shared_ptr<SocketCore> socket;
+  };
+
+  // Starts an attempt to the next address.  Addresses to which
+  // connect(2) fails immediately are marked bad and skipped.
+  void startAttempt();
+
+  // Checks the attempts in progress.  Returns true if one of them is
+  // established.  Failed attempts are removed and their addresses
+  // are marked bad.
+  bool checkAttempts();
+
+  void wakeUpMainCommand();
+
+  std::string hostname_;
+  std::vector<std::string> addrs_;
+  size_t nextAddr_;
+  uint16_t port_;
+  std::vector<Attempt> attempts_;
+  std::shared_ptr<BackupConnectInfo> info_;
+  Command* mainCommand_;
+  RequestGroup* requestGroup_;
+  DownloadEngine* e_;
+  // True if the next attempt should be started without waiting for
+  // attemptDelay_.
+  bool startNow_;
+  bool mainFailureSeen_;
+  Timer lastAttemptTime_;
+  std::chrono::milliseconds attemptDelay_;
+  Timer timeoutCheck_;
+  std::chrono::seconds timeout_;
+};
+
+} // namespace aria2
+
+#endif // BACKUP_CONNECT_COMMAND_H
@@ -0,0 +1,255 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "BencodeView.h"
+
+#include <cstring>
+
+#include "BencodeParser.h"
+#include "DlAbortEx.h"
+#include "error_code.h"
+#include "fmt.h"
+#include "util.h"
+
+namespace aria2 {
+
+namespace bittorrent {
+
+namespace {
+// The same limit as BencodeParser.
+constexpr int MAX_DEPTH = 50;
+} // namespace
+
+namespace {
+void throwError(int error)
+{
+  throw DL_ABORT_EX2(fmt("Bencode decoding failed: error=%d", error),
+                     error_code::BENCODE_PARSE_ERROR);
+}
+} // namespace
+
+namespace {
+bool isFloatChar(unsigned char c)
+{
+  return util::isDigit(c) || c == '.' || c == 'E' || c == '+' || c == '-';
+}
+} // namespace
+
+BencodeView::BencodeView()
+    : type_(BV_NONE),
+      first_(nullptr),
+      last_(nullptr),
+      payload_(nullptr),
+      number_(0)
+{
+}
+
+BencodeView BencodeView::parse(const unsigned char* data, size_t len)
+{
+  BencodeView res;
+  readValue(res, data, data + len, 0);
+  return res;
+}
+
+const unsigned char* BencodeView::readValue(BencodeView& out,
+                                            const unsigned char* p,
+                                            const unsigned char* last,
+                                            int depth)
+{
+  if (p == last) {
+    throwError(ERR_PREMATURE_DATA);
+  }
+  out.first_ = p;
+  out.payload_ = nullptr;
+  out.number_ = 0;
+  switch (*p) {
+  case 'd':
+  case 'l': {
+    bool dict = *p == 'd';
+    if (depth + 1 >= MAX_DEPTH) {
+      throwError(ERR_STRUCTURE_TOO_DEEP);
+    }
+    ++p;
+    BencodeView child;
+    for (;;) {
+      if (p == last) {
+        throwError(ERR_PREMATURE_DATA);
+      }
+      if (*p == 'e') {
+        ++p;
+        break;
+      }
+      if (dict) {
+        if (!util::isDigit(*p)) {
+          throwError(ERR_INVALID_STRING_LENGTH);
+        }
+        p = readValue(child, p, last, depth + 1);
+      }
+      p = readValue(child, p, last, depth + 1);
+    }
+    out.type_ = dict ? BV_DICT : BV_LIST;
+    break;
+  }
+  case 'i': {
+    ++p;
+    int sign = 1;
+    if (p != last && (*p == '+' || *p == '-')) {
+      sign = *p == '-' ? -1 : 1;
+      ++p;
+    }
+    int64_t number = 0;
+    auto digits = p;
+    for (; p != last && util::isDigit(*p); ++p) {
+      if ((INT64_MAX - (*p - '0')) / 10 < number) {
+        throwError(ERR_NUMBER_OUT_OF_RANGE);
+      }
+      number = number * 10 + (*p - '0');
+    }
+    if (p == last) {
+      throwError(ERR_PREMATURE_DATA);
+    }
+    if (p == digits) {
+      throwError(ERR_INVALID_NUMBER);
+    }
+    if (isFloatChar(*p)) {
+      // Some torrent generators put a floating point number in an
+      // integer field.  BencodeParser ignores it and so do we.
+      for (; p != last && isFloatChar(*p); ++p)
+        ;
+      if (p == last) {
+        throwError(ERR_PREMATURE_DATA);
+      }
+      if (*p != 'e') {
+        throwError(ERR_INVALID_FLOAT_NUMBER);
+      }
+      number = 0;
+    }
+    else if (*p != 'e') {
+      throwError(ERR_INVALID_NUMBER);
+    }
+    ++p;
+    out.number_ = sign * number;
+    out.type_ = BV_INTEGER;
+    break;
+  }
+  default: {
+    if (!util::isDigit(*p)) {
+      throwError(ERR_UNEXPECTED_CHAR_BEFORE_VAL);
+    }
+    int64_t length = 0;
+    for (; p != last && util::isDigit(*p); ++p) {
+      if ((INT64_MAX - (*p - '0')) / 10 < length) {
+        throwError(ERR_STRING_LENGTH_OUT_OF_RANGE);
+      }
+      length = length * 10 + (*p - '0');
+    }
+    if (p == last) {
+      throwError(ERR_PREMATURE_DATA);
+    }
+    if (*p != ':') {
+      throwError(ERR_INVALID_STRING_LENGTH);
+    }
+    ++p;
+    if (last - p < length) {
+      throwError(ERR_PREMATURE_DATA);
+    }
+    out.payload_ = p;
+    p += length;
+    out.type_ = BV_STRING;
+    break;
+  }
+  }
+  out.last_ = p;
+  return p;
+}
+
+ByteSpan BencodeView::s() const
+{
+  if (type_ != BV_STRING) {
+    return ByteSpan();
+  }
+  return ByteSpan(payload_, last_ - payload_);
+}
+
+BencodeView::Cursor BencodeView::children() const
+{
+  if (type_ != BV_LIST && type_ != BV_DICT) {
+    return Cursor(last_, last_, false);
+  }
+  // Skip the type prefix and the terminator.
+  return Cursor(first_ + 1, last_ - 1, type_ == BV_DICT);
+}
+
+BencodeView BencodeView::get(const char* key) const
+{
+  BencodeView res;
+  if (type_ != BV_DICT) {
+    return res;
+  }
+  auto keylen = strlen(key);
+  for (auto c = children(); c.valid(); c.next()) {
+    auto k = c.key().s();
+    if (k.size() == keylen && memcmp(k.data(), key, keylen) == 0) {
+      res = c.value();
+    }
+  }
+  return res;
+}
+
+BencodeView::Cursor::Cursor(const unsigned char* first,
+                            const unsigned char* last, bool dict)
+    : p_(first), last_(last), dict_(dict)
+{
+  read();
+}
+
+void BencodeView::Cursor::read()
+{
+  if (p_ == last_) {
+    key_ = value_ = BencodeView();
+    return;
+  }
+  // The whole buffer was validated by parse(), so that the depth
+  // does not matter here.
+  if (dict_) {
+    p_ = readValue(key_, p_, last_, 0);
+  }
+  p_ = readValue(value_, p_, last_, 0);
+}
+
+void BencodeView::Cursor::next() { read(); }
+
+} // namespace bittorrent
+
+} // namespace aria2
@@ -0,0 +1,152 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_BENCODE_VIEW_H
+#define D_BENCODE_VIEW_H
+
+#include "common.h"
+
+#include <string>
+
+#include "ByteSpan.h"
+
+namespace aria2 {
+
+namespace bittorrent {
+
+// A bencoded value in a buffer owned by someone else.  Unlike
+// bencode2::decode(), parsing does not build a tree of ValueBase.
+// Strings refer to the buffer, and the elements of a list or a
+// dictionary are parsed each time they are iterated.  The view is
+// invalidated when the buffer is freed.
+class BencodeView {
+public:
+  enum Type { BV_NONE, BV_STRING, BV_INTEGER, BV_LIST, BV_DICT };
+
+  class Cursor;
+
+  BencodeView();
+
+  // Parses the bencoded value at the beginning of |data| of |len|
+  // bytes, which must be well formed as a whole.  The bytes after the
+  // value are ignored.  Throws DlAbortEx on error.
+  static BencodeView parse(const unsigned char* data, size_t len);
+
+  Type getType() const { return type_; }
+
+  bool none() const { return type_ == BV_NONE; }
+
+  bool isString() const { return type_ == BV_STRING; }
+
+  bool isInteger() const { return type_ == BV_INTEGER; }
+
+  bool isList() const { return type_ == BV_LIST; }
+
+  bool isDict() const { return type_ == BV_DICT; }
+
+  // Returns the bytes of a string.
+  ByteSpan s() const;
+
+  // Returns a copy of the bytes of a string.
+  std::string str() const { return s().str(); }
+
+  // Returns the value of an integer.
+  int64_t i() const { return number_; }
+
+  // Returns the encoded bytes of the value, including the type prefix
+  // and the terminator.
+  ByteSpan raw() const { return ByteSpan(first_, last_ - first_); }
+
+  // Returns a cursor on the children of a list or a dictionary.
+  Cursor children() const;
+
+  // Returns the value of |key| in a dictionary.  If |key| appears more
+  // than once, the last value is returned, like bencode2::decode()
+  // does.  Returns a BV_NONE view if there is no such key.  This is a
+  // linear search.
+  BencodeView get(const char* key) const;
+
+private:
+  // Parses a value at |p| and stores it in |out|.  Returns the
+  // position after the value.  |depth| is the number of enclosing
+  // lists and dictionaries.
+  static const unsigned char* readValue(BencodeView& out,
+                                        const unsigned char* p,
+                                        const unsigned char* last, int depth);
+
+  Type type_;
+  // Range of the encoded value
+  const unsigned char* first_;
+  const unsigned char* last_;
+  // The first byte of a string
+  const unsigned char* payload_;
+  int64_t number_;
+};
+
+// Iterates the elements of a list, or the key and value pairs of a
+// dictionary, in the order they appear in the buffer:
+//
+//   for (auto c = dict.children(); c.valid(); c.next()) {
+//     ... c.key() ... c.value() ...
+//   }
+class BencodeView::Cursor {
+public:
+  bool valid() const { return !value_.none(); }
+
+  void next();
+
+  // Returns the current key.  Only available for a dictionary.
+  const BencodeView& key() const { return key_; }
+
+  const BencodeView& value() const { return value_; }
+
+private:
+  friend class BencodeView;
+
+  Cursor(const unsigned char* first, const unsigned char* last, bool dict);
+
+  void read();
+
+  const unsigned char* p_;
+  const unsigned char* last_;
+  bool dict_;
+  BencodeView key_;
+  BencodeView value_;
+};
+
+} // namespace bittorrent
+
+} // namespace aria2
+
+#endif // D_BENCODE_VIEW_H
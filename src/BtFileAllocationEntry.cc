@@ -72,6 +72,9 @@ void BtFileAllocationEntry::prepareForNextAction(
       diskAdaptor->size() <= option->getAsLLInt(PREF_MAX_MMAP_LIMIT)) {
     diskAdaptor->enableMmap();
   }
+  if (option->getAsBool(PREF_ENABLE_DIRECT_IO)) {
+    diskAdaptor->enableDirectIO();
+  }
   if (!rg->downloadFinished()) {
     // For DownloadContext::resetDownloadStartTime(), see also
     // RequestGroup::createInitialCommand()
@@ -59,6 +59,8 @@
 #include "array_fun.h"
 #include "WrDiskCache.h"
 #include "WrDiskCacheEntry.h"
+#include "PieceReadCache.h"
+#include "RequestGroup.h"
 #include "DownloadFailureException.h"
 #include "BtRejectMessage.h"
 
@@ -218,8 +220,18 @@ void BtPieceMessage::pushPieceData(int64_t offset, int32_t length) const
   auto buf = std::vector<unsigned char>(length + MESSAGE_HEADER_LENGTH);
   createMessageHeader(buf.data());
   ssize_t r;
-  r = getPieceStorage()->getDiskAdaptor()->readData(
-      buf.data() + MESSAGE_HEADER_LENGTH, length, offset);
+  auto pieceReadCache = getPieceStorage()->getPieceReadCache();
+  auto group = downloadContext_->getOwnerRequestGroup();
+  if (pieceReadCache && group) {
+    r = pieceReadCache->readData(
+        buf.data() + MESSAGE_HEADER_LENGTH, length, offset, group->getGID(),
+        index_, offset - begin_, getPieceStorage()->getPieceLength(index_),
+        getPieceStorage()->getDiskAdaptor().get());
+  }
+  else {
+    r = getPieceStorage()->getDiskAdaptor()->readData(
+        buf.data() + MESSAGE_HEADER_LENGTH, length, offset);
+  }
   if (r == length) {
     const auto& peer = getPeer();
     getPeerConnection()->pushBytes(
@@ -51,6 +51,18 @@ public:
 
   virtual void save() = 0;
 
+  // Returns true if the progress has changed since the last save().
+  virtual bool needsSave() = 0;
+
+  // Captures the progress of which the data have been written to the
+  // files, that is, without the blocks still in the write cache.
+  virtual void checkpoint() = 0;
+
+  // Saves the progress captured by the last checkpoint() if save()
+  // has not been called since then.  The data of the progress must
+  // have been written back to the disk beforehand.
+  virtual void saveCheckpoint() = 0;
+
   virtual void load() = 0;
 
   virtual void removeFile() = 0;
@@ -0,0 +1,100 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_BYTE_SPAN_H
+#define D_BYTE_SPAN_H
+
+#include "common.h"
+
+#include <cstring>
+#include <string>
+
+namespace aria2 {
+
+// A read-only view of a byte sequence owned by someone else, such as
+// a piece hash in DownloadContext.  The view is invalidated when the
+// owner changes the sequence.
+class ByteSpan {
+public:
+  ByteSpan() : data_(nullptr), size_(0) {}
+
+  ByteSpan(const unsigned char* data, size_t size) : data_(data), size_(size)
+  {
+  }
+
+  const unsigned char* data() const { return data_; }
+
+  size_t size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+  const unsigned char* begin() const { return data_; }
+
+  const unsigned char* end() const { return data_ + size_; }
+
+  // Returns a copy of the bytes as std::string.
+  std::string str() const
+  {
+    return std::string(reinterpret_cast<const char*>(data_), size_);
+  }
+
+private:
+  const unsigned char* data_;
+  size_t size_;
+};
+
+inline bool operator==(const ByteSpan& lhs, const std::string& rhs)
+{
+  return lhs.size() == rhs.size() &&
+         (lhs.empty() || memcmp(lhs.data(), rhs.data(), lhs.size()) == 0);
+}
+
+inline bool operator==(const std::string& lhs, const ByteSpan& rhs)
+{
+  return rhs == lhs;
+}
+
+inline bool operator!=(const ByteSpan& lhs, const std::string& rhs)
+{
+  return !(lhs == rhs);
+}
+
+inline bool operator!=(const std::string& lhs, const ByteSpan& rhs)
+{
+  return !(rhs == lhs);
+}
+
+} // namespace aria2
+
+#endif // D_BYTE_SPAN_H
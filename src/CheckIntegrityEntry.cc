@@ -86,7 +86,8 @@ void CheckIntegrityEntry::proceedFileAllocation(
     std::unique_ptr<FileAllocationEntry> entry, DownloadEngine* e)
 {
   if (getRequestGroup()->needsFileAllocation()) {
-    e->getFileAllocationMan()->pushEntry(std::move(entry));
+    auto deviceId = entry->getDeviceId();
+    e->getFileAllocationMan()->pushEntry(std::move(entry), deviceId);
   }
   else {
     entry->prepareForNextAction(commands, e);
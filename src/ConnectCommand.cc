@@ -33,7 +33,7 @@
  */
 /* copyright --> */
 #include "ConnectCommand.h"
-#include "BackupIPv4ConnectCommand.h"
+#include "BackupConnectCommand.h"
 #include "ControlChain.h"
 #include "Option.h"
 #include "message.h"
@@ -44,6 +44,7 @@
 #include "Request.h"
 #include "prefs.h"
 #include "SocketRecvBuffer.h"
+#include "SocketPool.h"
 
 namespace aria2 {
 
@@ -89,21 +90,63 @@ bool ConnectCommand::executeInternal()
   if (backupConnectionInfo_ && !backupConnectionInfo_->ipaddr.empty()) {
     A2_LOG_INFO(fmt("CUID#%" PRId64 " - Use backup connection address %s",
                     getCuid(), backupConnectionInfo_->ipaddr.c_str()));
-    getDownloadEngine()->markBadIPAddress(getRequest()->getConnectedHostname(),
-                                          getRequest()->getConnectedAddr(),
-                                          getRequest()->getConnectedPort());
+    // Remember the winner of the race, so that the next connection to
+    // the host tries it first.
+    getDownloadEngine()->markGoodIPAddress(getRequest()->getConnectedHostname(),
+                                           backupConnectionInfo_->ipaddr,
+                                           getRequest()->getConnectedPort());
 
     getRequest()->setConnectedAddrInfo(getRequest()->getConnectedHostname(),
                                        backupConnectionInfo_->ipaddr,
                                        getRequest()->getConnectedPort());
+    // InitiateConnectionCommand accounted our own socket, which is
+    // destroyed soon.
+    getDownloadEngine()->getSocketPool()->replaceConnection(
+        getRequest()->getConnectedHostname(),
+        getRequest()->getConnectedPort(), getSocket(),
+        backupConnectionInfo_->socket);
     swapSocket(backupConnectionInfo_->socket);
     backupConnectionInfo_.reset();
+    mainError_.clear();
   }
-  if (!checkIfConnectionEstablished(
-          getSocket(), getRequest()->getConnectedHostname(),
-          getRequest()->getConnectedAddr(), getRequest()->getConnectedPort())) {
+  else if (!mainError_.empty()) {
+    if (!backupConnectionInfo_->finished) {
+      addCommandSelf();
+      return false;
+    }
+    // Backup connection attempts failed as well.
+    backupConnectionInfo_.reset();
+    onConnectionFailure(mainError_, getRequest()->getConnectedHostname(),
+                        getRequest()->getConnectedAddr(),
+                        getRequest()->getConnectedPort());
     return true;
   }
+  else {
+    auto error = getSocket()->getSocketError();
+    if (!error.empty()) {
+      if (backupConnectionInfo_ && !backupConnectionInfo_->finished) {
+        A2_LOG_INFO(fmt("CUID#%" PRId64 " - Connection to %s failed: %s."
+                        " Waiting for backup connection",
+                        getCuid(), getRequest()->getConnectedAddr().c_str(),
+                        error.c_str()));
+        getDownloadEngine()->markBadIPAddress(
+            getRequest()->getConnectedHostname(),
+            getRequest()->getConnectedAddr(),
+            getRequest()->getConnectedPort());
+        mainError_ = error;
+        backupConnectionInfo_->mainFailed = true;
+        disableWriteCheckSocket();
+        // Let backup connection command start the next attempt now.
+        getDownloadEngine()->setRefreshInterval(std::chrono::milliseconds(0));
+        addCommandSelf();
+        return false;
+      }
+      onConnectionFailure(error, getRequest()->getConnectedHostname(),
+                          getRequest()->getConnectedAddr(),
+                          getRequest()->getConnectedPort());
+      return true;
+    }
+  }
   if (backupConnectionInfo_) {
     backupConnectionInfo_->cancel = true;
     backupConnectionInfo_.reset();
@@ -62,6 +62,9 @@ protected:
 private:
   std::shared_ptr<Request> proxyRequest_;
   std::shared_ptr<BackupConnectInfo> backupConnectionInfo_;
+  // Error of our own connection attempt if it failed while backup
+  // connection attempts are still in progress.
+  std::string mainError_;
   std::shared_ptr<ControlChain<ConnectCommand*>> chain_;
 };
 
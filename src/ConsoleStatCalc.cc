@@ -347,8 +347,10 @@ void ConsoleStatCalc::calculateStat(const DownloadEngine* e)
   }
 
   {
-    auto& entry = e->getFileAllocationMan()->getPickedEntry();
-    if (entry) {
+    auto& entries = e->getFileAllocationMan()->getPickedEntries();
+    if (!entries.empty()) {
+      // Show the oldest one.  The others are counted below.
+      auto& entry = entries.front();
       o << " [FileAlloc:#"
         << GroupId::toAbbrevHex(entry->getRequestGroup()->getGID()) << " "
         << sizeFormatter(entry->getCurrentLength()) << "B/"
@@ -360,8 +362,10 @@ void ConsoleStatCalc::calculateStat(const DownloadEngine* e)
         o << "--";
       }
       o << "%)]";
-      if (e->getFileAllocationMan()->hasNext()) {
-        o << "(+" << e->getFileAllocationMan()->countEntryInQueue() << ")";
+      auto numOthers = entries.size() - 1 +
+                       e->getFileAllocationMan()->countEntryInQueue();
+      if (numOthers > 0) {
+        o << "(+" << numOthers << ")";
       }
     }
   }
@@ -41,6 +41,7 @@
 #include <algorithm>
 #include <deque>
 #include <vector>
+#include <memory>
 
 #include "DHTConstants.h"
 #include "DHTNodeLookupEntry.h"
@@ -62,8 +63,13 @@ namespace aria2 {
 class DHTNode;
 class DHTMessage;
 
+// The callbacks of the queries hold a shared_ptr to the task, so that
+// the lookup can finish before all of them are called.
 template <class ResponseMessage>
-class DHTAbstractNodeLookupTask : public DHTAbstractTask {
+class DHTAbstractNodeLookupTask
+    : public DHTAbstractTask,
+      public std::enable_shared_from_this<
+          DHTAbstractNodeLookupTask<ResponseMessage>> {
 private:
   unsigned char targetID_[DHT_ID_LENGTH];
 
@@ -71,6 +77,28 @@ private:
 
   size_t inFlightMessage_;
 
+  // The number of queries kept in flight, not counting slowNodes_.
+  size_t concurrency_;
+
+  // Nodes whose replies are late. They are still counted in
+  // inFlightMessage_, but not against concurrency_, so that the
+  // lookup proceeds with other nodes instead of waiting for timeout.
+  std::vector<std::shared_ptr<DHTNode>> slowNodes_;
+
+  // Removes node from slowNodes_. Nodes are compared by address
+  // because node ID in a reply may differ from the queried one.
+  void removeSlowNode(const std::shared_ptr<DHTNode>& node)
+  {
+    auto i = std::find_if(std::begin(slowNodes_), std::end(slowNodes_),
+                          [&node](const std::shared_ptr<DHTNode>& n) {
+                            return n->getIPAddress() == node->getIPAddress() &&
+                                   n->getPort() == node->getPort();
+                          });
+    if (i != std::end(slowNodes_)) {
+      slowNodes_.erase(i);
+    }
+  }
+
   template <typename Container>
   void toEntries(Container& entries,
                  const std::vector<std::shared_ptr<DHTNode>>& nodes) const
@@ -83,7 +111,8 @@ private:
   void sendMessage()
   {
     for (auto i = std::begin(entries_), eoi = std::end(entries_);
-         i != eoi && inFlightMessage_ < ALPHA; ++i) {
+         i != eoi && inFlightMessage_ < concurrency_ + slowNodes_.size();
+         ++i) {
       if ((*i)->used == false) {
         ++inFlightMessage_;
         (*i)->used = true;
@@ -93,12 +122,24 @@ private:
     }
   }
 
+  // Returns true if the K closest nodes known have replied.  The
+  // queries still in flight cannot find closer nodes then.
+  bool closestNodesReplied() const
+  {
+    return entries_.size() >= DHTBucket::K &&
+           std::all_of(std::begin(entries_), std::end(entries_),
+                       [](const std::unique_ptr<DHTNodeLookupEntry>& entry) {
+                         return entry->replied;
+                       });
+  }
+
   void sendMessageAndCheckFinish()
   {
-    if (needsAdditionalOutgoingMessage()) {
+    bool replied = closestNodesReplied();
+    if (!replied && needsAdditionalOutgoingMessage()) {
       sendMessage();
     }
-    if (inFlightMessage_ == 0) {
+    if (inFlightMessage_ == 0 || replied) {
       A2_LOG_DEBUG(fmt("Finished node_lookup for node ID %s",
                        util::toHex(targetID_, DHT_ID_LENGTH).c_str()));
       onFinish();
@@ -137,12 +178,13 @@ protected:
   virtual std::unique_ptr<DHTMessageCallback> createCallback() = 0;
 
 public:
-  DHTAbstractNodeLookupTask(const unsigned char* targetID) : inFlightMessage_(0)
+  DHTAbstractNodeLookupTask(const unsigned char* targetID)
+      : inFlightMessage_(0), concurrency_(DHT_LOOKUP_CONCURRENCY)
   {
     memcpy(targetID_, targetID, DHT_ID_LENGTH);
   }
 
-  static const size_t ALPHA = 3;
+  void setConcurrency(size_t concurrency) { concurrency_ = concurrency; }
 
   virtual void startup() CXX11_OVERRIDE
   {
@@ -154,8 +196,8 @@ public:
       setFinished(true);
     }
     else {
-      // TODO use RTT here
       inFlightMessage_ = 0;
+      slowNodes_.clear();
       sendMessage();
       if (inFlightMessage_ == 0) {
         A2_LOG_DEBUG("No message was sent in this lookup stage. Finished.");
@@ -167,12 +209,19 @@ public:
   void onReceived(const ResponseMessage* message)
   {
     --inFlightMessage_;
+    if (finished()) {
+      // A late reply after the K closest nodes replied.
+      onReceivedInternal(message);
+      return;
+    }
+    removeSlowNode(message->getRemoteNode());
     // Replace old Node ID with new Node ID.
     for (auto& entry : entries_) {
       if (entry->node->getIPAddress() ==
               message->getRemoteNode()->getIPAddress() &&
           entry->node->getPort() == message->getRemoteNode()->getPort()) {
         entry->node = message->getRemoteNode();
+        entry->replied = true;
       }
     }
     onReceivedInternal(message);
@@ -188,7 +237,9 @@ public:
         A2_LOG_DEBUG(fmt("Received nodes: id=%s, ip=%s",
                          util::toHex(ne->node->getID(), DHT_ID_LENGTH).c_str(),
                          ne->node->getIPAddress().c_str()));
-        entries_.push_front(std::move(ne));
+        // Appended, so that the entries already queried are kept by
+        // std::unique() below.
+        entries_.push_back(std::move(ne));
         ++count;
       }
     }
@@ -213,6 +264,10 @@ public:
     A2_LOG_DEBUG(fmt("node lookup message timeout for node ID=%s",
                      util::toHex(node->getID(), DHT_ID_LENGTH).c_str()));
     --inFlightMessage_;
+    if (finished()) {
+      return;
+    }
+    removeSlowNode(node);
     for (auto i = std::begin(entries_), eoi = std::end(entries_); i != eoi;
          ++i) {
       if (*(*i)->node == *node) {
@@ -222,6 +277,19 @@ public:
     }
     sendMessageAndCheckFinish();
   }
+
+  void onSlowResponse(const std::shared_ptr<DHTNode>& node)
+  {
+    A2_LOG_DEBUG(fmt("node lookup message is slow for node ID=%s",
+                     util::toHex(node->getID(), DHT_ID_LENGTH).c_str()));
+    if (finished()) {
+      return;
+    }
+    slowNodes_.push_back(node);
+    if (needsAdditionalOutgoingMessage()) {
+      sendMessage();
+    }
+  }
 };
 
 } // namespace aria2
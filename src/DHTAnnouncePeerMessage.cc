@@ -60,6 +60,8 @@ const std::string DHTAnnouncePeerMessage::PORT("port");
 
 const std::string DHTAnnouncePeerMessage::TOKEN("token");
 
+const std::string DHTAnnouncePeerMessage::SEED("seed");
+
 DHTAnnouncePeerMessage::DHTAnnouncePeerMessage(
     const std::shared_ptr<DHTNode>& localNode,
     const std::shared_ptr<DHTNode>& remoteNode, const unsigned char* infoHash,
@@ -68,6 +70,7 @@ DHTAnnouncePeerMessage::DHTAnnouncePeerMessage(
     : DHTQueryMessage{localNode, remoteNode, transactionID},
       token_{token},
       tcpPort_{tcpPort},
+      seed_{false},
       peerAnnounceStorage_{nullptr},
       tokenTracker_{nullptr}
 {
@@ -77,7 +80,7 @@ DHTAnnouncePeerMessage::DHTAnnouncePeerMessage(
 void DHTAnnouncePeerMessage::doReceivedAction()
 {
   peerAnnounceStorage_->addPeerAnnounce(
-      infoHash_, getRemoteNode()->getIPAddress(), tcpPort_);
+      infoHash_, getRemoteNode()->getIPAddress(), tcpPort_, seed_);
 
   getMessageDispatcher()->addMessageToQueue(
       getMessageFactory()->createAnnouncePeerReplyMessage(getRemoteNode(),
@@ -91,6 +94,9 @@ std::unique_ptr<Dict> DHTAnnouncePeerMessage::getArgument()
   aDict->put(INFO_HASH, String::g(infoHash_, DHT_ID_LENGTH));
   aDict->put(PORT, Integer::g(tcpPort_));
   aDict->put(TOKEN, token_);
+  if (seed_) {
+    aDict->put(SEED, Integer::g(1));
+  }
   return aDict;
 }
 
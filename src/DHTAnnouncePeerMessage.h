@@ -52,6 +52,9 @@ private:
 
   uint16_t tcpPort_;
 
+  // true if the announcing peer is a seeder (BEP 33).
+  bool seed_;
+
   DHTPeerAnnounceStorage* peerAnnounceStorage_;
 
   DHTTokenTracker* tokenTracker_;
@@ -80,6 +83,10 @@ public:
 
   uint16_t getTCPPort() const { return tcpPort_; }
 
+  bool isSeed() const { return seed_; }
+
+  void setSeed(bool seed) { seed_ = seed; }
+
   void setPeerAnnounceStorage(DHTPeerAnnounceStorage* storage);
 
   void setTokenTracker(DHTTokenTracker* tokenTracker);
@@ -91,6 +98,8 @@ public:
   static const std::string PORT;
 
   static const std::string TOKEN;
+
+  static const std::string SEED;
 };
 
 } // namespace aria2
@@ -60,6 +60,8 @@ DHTBucket::DHTBucket(size_t prefixLength, const unsigned char* max,
 {
   memcpy(max_, max, DHT_ID_LENGTH);
   memcpy(min_, min, DHT_ID_LENGTH);
+  nodes_.reserve(K);
+  cachedNodes_.reserve(CACHE_SIZE + 1);
 }
 
 DHTBucket::DHTBucket(const std::shared_ptr<DHTNode>& localNode)
@@ -67,6 +69,8 @@ DHTBucket::DHTBucket(const std::shared_ptr<DHTNode>& localNode)
 {
   memset(max_, 0xffu, DHT_ID_LENGTH);
   memset(min_, 0, DHT_ID_LENGTH);
+  nodes_.reserve(K);
+  cachedNodes_.reserve(CACHE_SIZE + 1);
 }
 
 DHTBucket::~DHTBucket() = default;
@@ -133,9 +137,9 @@ bool DHTBucket::addNode(const std::shared_ptr<DHTNode>& node)
 void DHTBucket::cacheNode(const std::shared_ptr<DHTNode>& node)
 {
   // cachedNodes_ are sorted by last time seen
-  cachedNodes_.push_front(node);
+  cachedNodes_.insert(cachedNodes_.begin(), node);
   if (cachedNodes_.size() > CACHE_SIZE) {
-    cachedNodes_.resize(CACHE_SIZE, std::shared_ptr<DHTNode>());
+    cachedNodes_.resize(CACHE_SIZE);
   }
 }
 
@@ -156,7 +160,7 @@ void DHTBucket::moveToHead(const std::shared_ptr<DHTNode>& node)
   auto itr = std::find_if(nodes_.begin(), nodes_.end(), derefEqual(node));
   if (itr != nodes_.end()) {
     nodes_.erase(itr);
-    nodes_.push_front(node);
+    nodes_.insert(nodes_.begin(), node);
   }
 }
 
@@ -189,7 +193,7 @@ std::unique_ptr<DHTBucket> DHTBucket::split()
   ++prefixLength_;
   auto rBucket = make_unique<DHTBucket>(prefixLength_, rMax, rMin, localNode_);
 
-  std::deque<std::shared_ptr<DHTNode>> lNodes;
+  std::vector<std::shared_ptr<DHTNode>> lNodes;
   for (auto& elem : nodes_) {
     if (rBucket->isInRange(elem)) {
       assert(rBucket->addNode(elem));
@@ -214,20 +218,24 @@ std::unique_ptr<DHTBucket> DHTBucket::split()
 void DHTBucket::getGoodNodes(
     std::vector<std::shared_ptr<DHTNode>>& goodNodes) const
 {
-  goodNodes.insert(goodNodes.end(), nodes_.begin(), nodes_.end());
-  goodNodes.erase(std::remove_if(goodNodes.begin(), goodNodes.end(),
-                                 std::mem_fn(&DHTNode::isBad)),
-                  goodNodes.end());
+  for (auto& node : nodes_) {
+    if (!node->isBad()) {
+      goodNodes.push_back(node);
+    }
+  }
 }
 
 std::shared_ptr<DHTNode> DHTBucket::getNode(const unsigned char* nodeID,
                                             const std::string& ipaddr,
                                             uint16_t port) const
 {
-  auto node = std::make_shared<DHTNode>(nodeID);
-  node->setIPAddress(ipaddr);
-  node->setPort(port);
-  auto itr = std::find_if(nodes_.begin(), nodes_.end(), derefEqual(node));
+  // This is called for every incoming DHT message, so compare IDs
+  // directly instead of constructing a temporary DHTNode.
+  auto itr = std::find_if(nodes_.begin(), nodes_.end(),
+                          [nodeID](const std::shared_ptr<DHTNode>& node) {
+                            return memcmp(node->getID(), nodeID,
+                                          DHT_ID_LENGTH) == 0;
+                          });
   if (itr == nodes_.end() || (*itr)->getIPAddress() != ipaddr ||
       (*itr)->getPort() != port) {
     return nullptr;
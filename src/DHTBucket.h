@@ -38,7 +38,6 @@
 #include "common.h"
 
 #include <string>
-#include <deque>
 #include <vector>
 #include <memory>
 
@@ -60,12 +59,14 @@ private:
 
   std::shared_ptr<DHTNode> localNode_;
 
-  // sorted in ascending order
-  std::deque<std::shared_ptr<DHTNode>> nodes_;
+  // sorted in ascending order. The capacity is reserved up to K in
+  // the constructor, so that adding and reordering nodes never
+  // reallocates.
+  std::vector<std::shared_ptr<DHTNode>> nodes_;
 
   // a replacement cache. The maximum size is specified by CACHE_SIZE.
   // This is sorted by last time seen.
-  std::deque<std::shared_ptr<DHTNode>> cachedNodes_;
+  std::vector<std::shared_ptr<DHTNode>> cachedNodes_;
 
   Timer lastUpdated_;
 
@@ -107,7 +108,7 @@ public:
 
   size_t countNode() const { return nodes_.size(); }
 
-  const std::deque<std::shared_ptr<DHTNode>>& getNodes() const
+  const std::vector<std::shared_ptr<DHTNode>>& getNodes() const
   {
     return nodes_;
   }
@@ -136,7 +137,7 @@ public:
 
   std::shared_ptr<DHTNode> getLRUQuestionableNode() const;
 
-  const std::deque<std::shared_ptr<DHTNode>>& getCachedNodes() const
+  const std::vector<std::shared_ptr<DHTNode>>& getCachedNodes() const
   {
     return cachedNodes_;
   }
@@ -47,7 +47,10 @@
 
 namespace aria2 {
 
-DHTBucketRefreshTask::DHTBucketRefreshTask() : forceRefresh_(false) {}
+DHTBucketRefreshTask::DHTBucketRefreshTask()
+    : forceRefresh_(false), lookupConcurrency_(DHT_LOOKUP_CONCURRENCY)
+{
+}
 
 DHTBucketRefreshTask::~DHTBucketRefreshTask() = default;
 
@@ -68,6 +71,7 @@ void DHTBucketRefreshTask::startup()
     task->setMessageFactory(getMessageFactory());
     task->setTaskQueue(getTaskQueue());
     task->setLocalNode(getLocalNode());
+    task->setConcurrency(lookupConcurrency_);
 
     A2_LOG_INFO(fmt("Dispating bucket refresh. targetID=%s",
                     util::toHex(targetID, DHT_ID_LENGTH).c_str()));
@@ -81,4 +85,9 @@ void DHTBucketRefreshTask::setForceRefresh(bool forceRefresh)
   forceRefresh_ = forceRefresh;
 }
 
+void DHTBucketRefreshTask::setLookupConcurrency(size_t concurrency)
+{
+  lookupConcurrency_ = concurrency;
+}
+
 } // namespace aria2
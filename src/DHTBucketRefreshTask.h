@@ -43,6 +43,8 @@ class DHTBucketRefreshTask : public DHTAbstractTask {
 private:
   bool forceRefresh_;
 
+  size_t lookupConcurrency_;
+
 public:
   DHTBucketRefreshTask();
 
@@ -51,6 +53,8 @@ public:
   virtual void startup() CXX11_OVERRIDE;
 
   void setForceRefresh(bool forceRefresh);
+
+  void setLookupConcurrency(size_t concurrency);
 };
 
 } // namespace aria2
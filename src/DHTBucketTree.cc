@@ -120,9 +120,8 @@ namespace {
 void collectNodes(std::vector<std::shared_ptr<DHTNode>>& nodes,
                   const std::shared_ptr<DHTBucket>& bucket)
 {
-  std::vector<std::shared_ptr<DHTNode>> goodNodes;
-  bucket->getGoodNodes(goodNodes);
-  nodes.insert(nodes.end(), goodNodes.begin(), goodNodes.end());
+  // getGoodNodes() appends to nodes, so no intermediate copy is needed.
+  bucket->getGoodNodes(nodes);
 }
 } // namespace
 
@@ -52,6 +52,10 @@ constexpr size_t DHT_TRANSACTION_ID_LENGTH = 4;
 // See --dht-message-timeout option.
 constexpr auto DHT_MESSAGE_TIMEOUT = 10_s;
 
+// The number of queries a node lookup keeps in flight.  See
+// --dht-lookup-concurrency option.
+constexpr size_t DHT_LOOKUP_CONCURRENCY = 5;
+
 constexpr auto DHT_NODE_CONTACT_INTERVAL = 15_min;
 
 constexpr auto DHT_BUCKET_REFRESH_INTERVAL = 15_min;
@@ -66,6 +70,23 @@ constexpr auto DHT_PEER_ANNOUNCE_CHECK_INTERVAL = 5_min;
 
 constexpr auto DHT_TOKEN_UPDATE_INTERVAL = 10_min;
 
+// An outstanding query is considered slow after the smoothed RTT
+// plus 4 times its variance is elapsed, but not earlier than
+// DHT_MIN_SLOW_RESPONSE_TIMEOUT.  Node lookup sends a query to
+// another node for a slow query without waiting for
+// DHT_MESSAGE_TIMEOUT.
+constexpr auto DHT_MIN_SLOW_RESPONSE_TIMEOUT = 500_ms;
+
+// Used to detect slow query until RTT is measured.
+constexpr auto DHT_INITIAL_SLOW_RESPONSE_TIMEOUT = 2_s;
+
+// The maximum number of peers stored per info hash. If it is
+// exceeded, the least recently announced peer is evicted.
+constexpr size_t DHT_MAX_PEER_ADDR_ENTRY = 500;
+
+// The length of bloom filter in BEP 33 scrape response in bytes.
+constexpr size_t DHT_SCRAPE_BLOOM_FILTER_LENGTH = 256;
+
 } // namespace aria2
 
 #endif // D_DHT_CONSTANTS_H
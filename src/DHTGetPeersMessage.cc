@@ -58,6 +58,8 @@ const std::string DHTGetPeersMessage::GET_PEERS("get_peers");
 
 const std::string DHTGetPeersMessage::INFO_HASH("info_hash");
 
+const std::string DHTGetPeersMessage::SCRAPE("scrape");
+
 DHTGetPeersMessage::DHTGetPeersMessage(
     const std::shared_ptr<DHTNode>& localNode,
     const std::shared_ptr<DHTNode>& remoteNode, const unsigned char* infoHash,
@@ -66,7 +68,8 @@ DHTGetPeersMessage::DHTGetPeersMessage(
       peerAnnounceStorage_{nullptr},
       tokenTracker_{nullptr},
       btRegistry_{nullptr},
-      family_{AF_INET}
+      family_{AF_INET},
+      scrape_{false}
 {
   memcpy(infoHash_, infoHash, DHT_ID_LENGTH);
 }
@@ -121,10 +124,20 @@ void DHTGetPeersMessage::doReceivedAction()
 
   std::vector<std::shared_ptr<DHTNode>> nodes;
   getRoutingTable()->getClosestKNodes(nodes, infoHash_);
-  getMessageDispatcher()->addMessageToQueue(
-      getMessageFactory()->createGetPeersReplyMessage(
-          getRemoteNode(), std::move(nodes), std::move(peers), token,
-          getTransactionID()));
+  auto reply = getMessageFactory()->createGetPeersReplyMessage(
+      getRemoteNode(), std::move(nodes), std::move(peers), token,
+      getTransactionID());
+  if (scrape_) {
+    std::array<unsigned char, DHT_SCRAPE_BLOOM_FILTER_LENGTH> seedFilter;
+    std::array<unsigned char, DHT_SCRAPE_BLOOM_FILTER_LENGTH> peerFilter;
+    if (peerAnnounceStorage_->getScrapeFilters(seedFilter.data(),
+                                               peerFilter.data(), infoHash_)) {
+      reply->setScrapeFilters(
+          std::string(std::begin(seedFilter), std::end(seedFilter)),
+          std::string(std::begin(peerFilter), std::end(peerFilter)));
+    }
+  }
+  getMessageDispatcher()->addMessageToQueue(std::move(reply));
 }
 
 std::unique_ptr<Dict> DHTGetPeersMessage::getArgument()
@@ -132,6 +145,9 @@ std::unique_ptr<Dict> DHTGetPeersMessage::getArgument()
   auto aDict = Dict::g();
   aDict->put(DHTMessage::ID, String::g(getLocalNode()->getID(), DHT_ID_LENGTH));
   aDict->put(INFO_HASH, String::g(infoHash_, DHT_ID_LENGTH));
+  if (scrape_) {
+    aDict->put(SCRAPE, Integer::g(1));
+  }
   return aDict;
 }
 
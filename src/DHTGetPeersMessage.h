@@ -61,6 +61,9 @@ private:
 
   int family_;
 
+  // true if the requester asked for BEP 33 scrape bloom filters.
+  bool scrape_;
+
   void addLocalPeer(std::vector<std::shared_ptr<Peer>>& peers);
 
 protected:
@@ -88,9 +91,15 @@ public:
 
   void setFamily(int family);
 
+  bool isScrape() const { return scrape_; }
+
+  void setScrape(bool scrape) { scrape_ = scrape; }
+
   static const std::string GET_PEERS;
 
   static const std::string INFO_HASH;
+
+  static const std::string SCRAPE;
 };
 
 } // namespace aria2
@@ -60,6 +60,10 @@ const std::string DHTGetPeersReplyMessage::NODES("nodes");
 
 const std::string DHTGetPeersReplyMessage::NODES6("nodes6");
 
+const std::string DHTGetPeersReplyMessage::BFSD("BFsd");
+
+const std::string DHTGetPeersReplyMessage::BFPE("BFpe");
+
 DHTGetPeersReplyMessage::DHTGetPeersReplyMessage(
     int family, const std::shared_ptr<DHTNode>& localNode,
     const std::shared_ptr<DHTNode>& remoteNode, const std::string& token,
@@ -141,6 +145,12 @@ std::unique_ptr<Dict> DHTGetPeersReplyMessage::getResponse()
     }
     rDict->put(VALUES, std::move(valuesList));
   }
+  if (!seedFilter_.empty()) {
+    rDict->put(BFSD, seedFilter_);
+  }
+  if (!peerFilter_.empty()) {
+    rDict->put(BFPE, peerFilter_);
+  }
   return rDict;
 }
 
@@ -167,6 +177,13 @@ void DHTGetPeersReplyMessage::setClosestKNodes(
   closestKNodes_ = std::move(closestKNodes);
 }
 
+void DHTGetPeersReplyMessage::setScrapeFilters(std::string seedFilter,
+                                               std::string peerFilter)
+{
+  seedFilter_ = std::move(seedFilter);
+  peerFilter_ = std::move(peerFilter);
+}
+
 void DHTGetPeersReplyMessage::setValues(
     std::vector<std::shared_ptr<Peer>> peers)
 {
@@ -55,6 +55,12 @@ private:
 
   std::vector<std::shared_ptr<Peer>> values_;
 
+  // BEP 33 bloom filters of seeders and downloaders. Empty if they
+  // are not included in this message.
+  std::string seedFilter_;
+
+  std::string peerFilter_;
+
 protected:
   virtual std::string toStringOptional() const CXX11_OVERRIDE;
 
@@ -88,6 +94,12 @@ public:
 
   const std::string& getToken() const { return token_; }
 
+  void setScrapeFilters(std::string seedFilter, std::string peerFilter);
+
+  const std::string& getSeedFilter() const { return seedFilter_; }
+
+  const std::string& getPeerFilter() const { return peerFilter_; }
+
   static const std::string GET_PEERS;
 
   static const std::string TOKEN;
@@ -97,6 +109,10 @@ public:
   static const std::string NODES;
 
   static const std::string NODES6;
+
+  static const std::string BFSD;
+
+  static const std::string BFPE;
 };
 
 } // namespace aria2
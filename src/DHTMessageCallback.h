@@ -64,6 +64,10 @@ public:
   virtual void visit(const DHTPingReplyMessage* message) = 0;
 
   virtual void onTimeout(const std::shared_ptr<DHTNode>& remoteNode) = 0;
+
+  // Called at most once when the reply from remoteNode takes longer
+  // than usual.  onReceived() or onTimeout() is still called later.
+  virtual void onSlowResponse(const std::shared_ptr<DHTNode>& remoteNode) {}
 };
 
 } // namespace aria2
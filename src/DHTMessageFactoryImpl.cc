@@ -225,7 +225,12 @@ std::unique_ptr<DHTQueryMessage> DHTMessageFactoryImpl::createQueryMessage(
   else if (messageType->s() == DHTGetPeersMessage::GET_PEERS) {
     const String* infoHash = getString(aDict, DHTGetPeersMessage::INFO_HASH);
     validateID(infoHash);
-    msg = createGetPeersMessage(remoteNode, infoHash->uc(), transactionID->s());
+    auto m =
+        createGetPeersMessage(remoteNode, infoHash->uc(), transactionID->s());
+    const Integer* scrape =
+        downcast<Integer>(aDict->get(DHTGetPeersMessage::SCRAPE));
+    m->setScrape(scrape && scrape->i() == 1);
+    msg = std::move(m);
   }
   else if (messageType->s() == DHTAnnouncePeerMessage::ANNOUNCE_PEER) {
     const String* infoHash =
@@ -234,9 +239,13 @@ std::unique_ptr<DHTQueryMessage> DHTMessageFactoryImpl::createQueryMessage(
     const Integer* port = getInteger(aDict, DHTAnnouncePeerMessage::PORT);
     validatePort(port);
     const String* token = getString(aDict, DHTAnnouncePeerMessage::TOKEN);
-    msg = createAnnouncePeerMessage(remoteNode, infoHash->uc(),
-                                    static_cast<uint16_t>(port->i()),
-                                    token->s(), transactionID->s());
+    auto m = createAnnouncePeerMessage(remoteNode, infoHash->uc(),
+                                       static_cast<uint16_t>(port->i()),
+                                       token->s(), transactionID->s());
+    const Integer* seed =
+        downcast<Integer>(aDict->get(DHTAnnouncePeerMessage::SEED));
+    m->setSeed(seed && seed->i() == 1);
+    msg = std::move(m);
   }
   else {
     throw DL_ABORT_EX(
@@ -446,9 +455,19 @@ DHTMessageFactoryImpl::createGetPeersReplyMessage(
     }
   }
   const String* token = getString(rDict, DHTGetPeersReplyMessage::TOKEN);
-  return createGetPeersReplyMessage(remoteNode, std::move(nodes),
-                                    std::move(peers), token->s(),
-                                    transactionID);
+  auto m = createGetPeersReplyMessage(remoteNode, std::move(nodes),
+                                      std::move(peers), token->s(),
+                                      transactionID);
+  const String* seedFilter =
+      downcast<String>(rDict->get(DHTGetPeersReplyMessage::BFSD));
+  const String* peerFilter =
+      downcast<String>(rDict->get(DHTGetPeersReplyMessage::BFPE));
+  if (seedFilter && peerFilter &&
+      seedFilter->s().size() == DHT_SCRAPE_BLOOM_FILTER_LENGTH &&
+      peerFilter->s().size() == DHT_SCRAPE_BLOOM_FILTER_LENGTH) {
+    m->setScrapeFilters(seedFilter->s(), peerFilter->s());
+  }
+  return m;
 }
 
 std::unique_ptr<DHTGetPeersReplyMessage>
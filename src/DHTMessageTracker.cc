@@ -35,6 +35,7 @@
 #include "DHTMessageTracker.h"
 
 #include <utility>
+#include <algorithm>
 
 #include "DHTMessage.h"
 #include "DHTMessageCallback.h"
@@ -52,10 +53,39 @@
 namespace aria2 {
 
 DHTMessageTracker::DHTMessageTracker()
-    : routingTable_{nullptr}, factory_{nullptr}
+    : routingTable_{nullptr},
+      factory_{nullptr},
+      srtt_{0},
+      rttvar_{0},
+      rttSampled_{false}
 {
 }
 
+void DHTMessageTracker::updateRTT(const std::chrono::milliseconds& rtt)
+{
+  if (rttSampled_) {
+    auto delta = srtt_ > rtt ? srtt_ - rtt : rtt - srtt_;
+    rttvar_ = (rttvar_ * 3 + delta) / 4;
+    srtt_ = (srtt_ * 7 + rtt) / 8;
+  }
+  else {
+    srtt_ = rtt;
+    rttvar_ = rtt / 2;
+    rttSampled_ = true;
+  }
+}
+
+std::chrono::milliseconds DHTMessageTracker::getSlowResponseTimeout() const
+{
+  if (!rttSampled_) {
+    return DHT_INITIAL_SLOW_RESPONSE_TIMEOUT;
+  }
+  return std::min(
+      std::chrono::milliseconds(DHT_MESSAGE_TIMEOUT),
+      std::max(std::chrono::milliseconds(DHT_MIN_SLOW_RESPONSE_TIMEOUT),
+               srtt_ + rttvar_ * 4));
+}
+
 void DHTMessageTracker::addMessage(DHTMessage* message,
                                    std::chrono::seconds timeout,
                                    std::unique_ptr<DHTMessageCallback> callback)
@@ -93,6 +123,7 @@ DHTMessageTracker::messageArrived(const Dict* dict, const std::string& ipaddr,
         A2_LOG_DEBUG(
             fmt("RTT is %" PRId64 "", static_cast<int64_t>(rtt.count())));
         message->getRemoteNode()->updateRTT(rtt);
+        updateRTT(rtt);
         if (*targetNode != *message->getRemoteNode()) {
           // Node ID has changed. Drop previous node ID from
           // DHTRoutingTable
@@ -142,6 +173,7 @@ void DHTMessageTracker::handleTimeoutEntry(DHTMessageTrackerEntry* entry)
 
 void DHTMessageTracker::handleTimeout()
 {
+  auto slowTimeout = getSlowResponseTimeout();
   entries_.erase(
       std::remove_if(std::begin(entries_), std::end(entries_),
                      [&](const std::unique_ptr<DHTMessageTrackerEntry>& ent) {
@@ -149,9 +181,14 @@ void DHTMessageTracker::handleTimeout()
                          handleTimeoutEntry(ent.get());
                          return true;
                        }
-                       else {
-                         return false;
+                       if (ent->isSlowResponse(slowTimeout)) {
+                         ent->markSlowResponse();
+                         auto& callback = ent->getCallback();
+                         if (callback) {
+                           callback->onSlowResponse(ent->getTargetNode());
+                         }
                        }
+                       return false;
                      }),
       std::end(entries_));
 }
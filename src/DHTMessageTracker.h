@@ -61,6 +61,16 @@ private:
 
   DHTMessageFactory* factory_;
 
+  // Smoothed RTT and its mean deviation of replies, computed as
+  // described in RFC 6298.
+  std::chrono::milliseconds srtt_;
+
+  std::chrono::milliseconds rttvar_;
+
+  bool rttSampled_;
+
+  void updateRTT(const std::chrono::milliseconds& rtt);
+
 public:
   DHTMessageTracker();
 
@@ -77,6 +87,10 @@ public:
   // Made public so that unnamed functor can access this
   void handleTimeoutEntry(DHTMessageTrackerEntry* entry);
 
+  // Returns the time after which an outstanding query is considered
+  // slow.
+  std::chrono::milliseconds getSlowResponseTimeout() const;
+
   // // For unittest only
   const DHTMessageTrackerEntry* getEntryFor(const DHTMessage* message) const;
 
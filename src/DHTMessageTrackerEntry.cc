@@ -51,7 +51,8 @@ DHTMessageTrackerEntry::DHTMessageTrackerEntry(
       messageType_{std::move(messageType)},
       callback_{std::move(callback)},
       dispatchedTime_{global::wallclock()},
-      timeout_{std::move(timeout)}
+      timeout_{std::move(timeout)},
+      slowResponse_{false}
 {
 }
 
@@ -60,6 +61,13 @@ bool DHTMessageTrackerEntry::isTimeout() const
   return dispatchedTime_.difference(global::wallclock()) >= timeout_;
 }
 
+bool DHTMessageTrackerEntry::isSlowResponse(
+    const std::chrono::milliseconds& slowTimeout) const
+{
+  return !slowResponse_ &&
+         dispatchedTime_.difference(global::wallclock()) >= slowTimeout;
+}
+
 void DHTMessageTrackerEntry::extendTimeout() {}
 
 bool DHTMessageTrackerEntry::match(const std::string& transactionID,
@@ -63,6 +63,8 @@ private:
 
   std::chrono::seconds timeout_;
 
+  bool slowResponse_;
+
 public:
   DHTMessageTrackerEntry(std::shared_ptr<DHTNode> targetNode,
                          std::string transactionID, std::string messageType,
@@ -72,6 +74,12 @@ public:
 
   bool isTimeout() const;
 
+  // Returns true if this entry is not yet marked as slow and the
+  // elapsed time since dispatch is at least slowTimeout.
+  bool isSlowResponse(const std::chrono::milliseconds& slowTimeout) const;
+
+  void markSlowResponse() { slowResponse_ = true; }
+
   void extendTimeout();
 
   bool match(const std::string& transactionID, const std::string& ipaddr,
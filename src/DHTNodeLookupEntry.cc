@@ -38,11 +38,11 @@
 namespace aria2 {
 
 DHTNodeLookupEntry::DHTNodeLookupEntry(const std::shared_ptr<DHTNode>& node)
-    : node(node), used(false)
+    : node(node), used(false), replied(false)
 {
 }
 
-DHTNodeLookupEntry::DHTNodeLookupEntry() : used(false) {}
+DHTNodeLookupEntry::DHTNodeLookupEntry() : used(false), replied(false) {}
 
 bool DHTNodeLookupEntry::operator==(const DHTNodeLookupEntry& entry) const
 {
@@ -48,6 +48,9 @@ struct DHTNodeLookupEntry {
 
   bool used;
 
+  // True if the node replied to the query.
+  bool replied;
+
   DHTNodeLookupEntry(const std::shared_ptr<DHTNode>& node);
 
   DHTNodeLookupEntry();
@@ -66,7 +66,8 @@ DHTNodeLookupTask::createMessage(const std::shared_ptr<DHTNode>& remoteNode)
 
 std::unique_ptr<DHTMessageCallback> DHTNodeLookupTask::createCallback()
 {
-  return make_unique<DHTNodeLookupTaskCallback>(this);
+  return make_unique<DHTNodeLookupTaskCallback>(
+      std::static_pointer_cast<DHTNodeLookupTask>(shared_from_this()));
 }
 
 } // namespace aria2
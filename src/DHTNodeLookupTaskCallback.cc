@@ -42,8 +42,9 @@
 
 namespace aria2 {
 
-DHTNodeLookupTaskCallback::DHTNodeLookupTaskCallback(DHTNodeLookupTask* task)
-    : task_(task)
+DHTNodeLookupTaskCallback::DHTNodeLookupTaskCallback(
+    std::shared_ptr<DHTNodeLookupTask> task)
+    : task_(std::move(task))
 {
 }
 
@@ -77,4 +78,10 @@ void DHTNodeLookupTaskCallback::onTimeout(
   task_->onTimeout(remoteNode);
 }
 
+void DHTNodeLookupTaskCallback::onSlowResponse(
+    const std::shared_ptr<DHTNode>& remoteNode)
+{
+  task_->onSlowResponse(remoteNode);
+}
+
 } // namespace aria2
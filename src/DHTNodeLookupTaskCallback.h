@@ -43,10 +43,12 @@ class DHTNodeLookupTask;
 
 class DHTNodeLookupTaskCallback : public DHTMessageCallback {
 private:
-  DHTNodeLookupTask* task_;
+  // Keeps the task alive until this callback is called, even if the
+  // lookup has finished.
+  std::shared_ptr<DHTNodeLookupTask> task_;
 
 public:
-  DHTNodeLookupTaskCallback(DHTNodeLookupTask* task);
+  DHTNodeLookupTaskCallback(std::shared_ptr<DHTNodeLookupTask> task);
 
   virtual void visit(const DHTAnnouncePeerReplyMessage* message) CXX11_OVERRIDE;
 
@@ -58,6 +60,9 @@ public:
 
   virtual void
   onTimeout(const std::shared_ptr<DHTNode>& remoteNode) CXX11_OVERRIDE;
+
+  virtual void
+  onSlowResponse(const std::shared_ptr<DHTNode>& remoteNode) CXX11_OVERRIDE;
 };
 
 } // namespace aria2
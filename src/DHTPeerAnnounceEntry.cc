@@ -38,25 +38,58 @@
 #include <algorithm>
 
 #include "Peer.h"
+#include "MessageDigest.h"
 #include "wallclock.h"
 
 namespace aria2 {
 
-DHTPeerAnnounceEntry::DHTPeerAnnounceEntry(const unsigned char* infoHash)
+DHTPeerAnnounceEntry::DHTPeerAnnounceEntry(const unsigned char* infoHash,
+                                           size_t maxPeerAddrEntry)
+    : maxPeerAddrEntry_(maxPeerAddrEntry), filterDirty_(false)
 {
   memcpy(infoHash_, infoHash, DHT_ID_LENGTH);
+  seedFilter_.fill(0);
+  peerFilter_.fill(0);
 }
 
 DHTPeerAnnounceEntry::~DHTPeerAnnounceEntry() = default;
 
 void DHTPeerAnnounceEntry::addPeerAddrEntry(const PeerAddrEntry& entry)
 {
+  if (entry.getCompactLength() == 0) {
+    return;
+  }
   auto i = std::find(peerAddrEntries_.begin(), peerAddrEntries_.end(), entry);
   if (i == peerAddrEntries_.end()) {
-    peerAddrEntries_.push_back(entry);
+    if (peerAddrEntries_.size() >= maxPeerAddrEntry_) {
+      // The bits of the evicted entry cannot be cleared, since they
+      // may be shared with other entries.  The filters are rebuilt
+      // when they are requested next time, that is, at most once per
+      // scrape request however many peers are announced in between.
+      peerAddrEntries_.erase(peerAddrEntries_.begin());
+      filterDirty_ = true;
+    }
+    auto pos = std::upper_bound(
+        peerAddrEntries_.begin(), peerAddrEntries_.end(), entry,
+        [](const PeerAddrEntry& lhs, const PeerAddrEntry& rhs) {
+          return lhs.getLastUpdated() < rhs.getLastUpdated();
+        });
+    peerAddrEntries_.insert(pos, entry);
+    if (!filterDirty_) {
+      addToFilter(entry);
+    }
   }
   else {
-    (*i).notifyUpdate();
+    if ((*i).isSeed() != entry.isSeed()) {
+      filterDirty_ = true;
+    }
+    // Move the updated entry to the back to keep the order by last
+    // updated time.
+    auto e = *i;
+    e.setSeed(entry.isSeed());
+    e.notifyUpdate();
+    peerAddrEntries_.erase(i);
+    peerAddrEntries_.push_back(e);
   }
   notifyUpdate();
 }
@@ -69,13 +102,17 @@ size_t DHTPeerAnnounceEntry::countPeerAddrEntry() const
 void DHTPeerAnnounceEntry::removeStalePeerAddrEntry(
     const std::chrono::seconds& timeout)
 {
-  peerAddrEntries_.erase(
-      std::remove_if(std::begin(peerAddrEntries_), std::end(peerAddrEntries_),
-                     [&timeout](const PeerAddrEntry& entry) {
-                       return entry.getLastUpdated().difference(
-                                  global::wallclock()) >= timeout;
-                     }),
-      std::end(peerAddrEntries_));
+  // Only the prefix of peerAddrEntries_ can be stale.
+  auto i = std::find_if(std::begin(peerAddrEntries_),
+                        std::end(peerAddrEntries_),
+                        [&timeout](const PeerAddrEntry& entry) {
+                          return entry.getLastUpdated().difference(
+                                     global::wallclock()) < timeout;
+                        });
+  if (i != std::begin(peerAddrEntries_)) {
+    peerAddrEntries_.erase(std::begin(peerAddrEntries_), i);
+    filterDirty_ = true;
+  }
 }
 
 bool DHTPeerAnnounceEntry::empty() const { return peerAddrEntries_.empty(); }
@@ -93,4 +130,50 @@ void DHTPeerAnnounceEntry::notifyUpdate()
   lastUpdated_ = global::wallclock();
 }
 
+namespace {
+// Inserts the address of |entry| into |filter| as described in BEP
+// 33: 2 bit indices are taken from the first 4 bytes of SHA-1 hash
+// of the address in network byte order.
+void insertFilter(DHTPeerAnnounceEntry::BloomFilter& filter,
+                  MessageDigest& sha1, const PeerAddrEntry& entry)
+{
+  unsigned char hash[20];
+  sha1.reset();
+  sha1.update(entry.getCompact(), entry.getCompactLength() - 2);
+  sha1.digest(hash);
+  const size_t m = DHT_SCRAPE_BLOOM_FILTER_LENGTH * 8;
+  size_t index1 = (hash[0] | (hash[1] << 8)) % m;
+  size_t index2 = (hash[2] | (hash[3] << 8)) % m;
+  filter[index1 / 8] |= 1 << (index1 % 8);
+  filter[index2 / 8] |= 1 << (index2 % 8);
+}
+} // namespace
+
+void DHTPeerAnnounceEntry::addToFilter(const PeerAddrEntry& entry)
+{
+  auto sha1 = MessageDigest::sha1();
+  insertFilter(entry.isSeed() ? seedFilter_ : peerFilter_, *sha1, entry);
+}
+
+const DHTPeerAnnounceEntry::BloomFilter& DHTPeerAnnounceEntry::getSeedFilter()
+{
+  if (filterDirty_) {
+    seedFilter_.fill(0);
+    peerFilter_.fill(0);
+    auto sha1 = MessageDigest::sha1();
+    for (const auto& p : peerAddrEntries_) {
+      insertFilter(p.isSeed() ? seedFilter_ : peerFilter_, *sha1, p);
+    }
+    filterDirty_ = false;
+  }
+  return seedFilter_;
+}
+
+const DHTPeerAnnounceEntry::BloomFilter& DHTPeerAnnounceEntry::getPeerFilter()
+{
+  // getSeedFilter() rebuilds both filters if necessary.
+  getSeedFilter();
+  return peerFilter_;
+}
+
 } // namespace aria2
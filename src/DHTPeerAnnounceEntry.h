@@ -38,6 +38,7 @@
 #include "common.h"
 
 #include <vector>
+#include <array>
 #include <memory>
 
 #include "DHTConstants.h"
@@ -49,20 +50,42 @@ namespace aria2 {
 class Peer;
 
 class DHTPeerAnnounceEntry {
+public:
+  typedef std::array<unsigned char, DHT_SCRAPE_BLOOM_FILTER_LENGTH>
+      BloomFilter;
+
 private:
   unsigned char infoHash_[DHT_ID_LENGTH];
 
+  // Sorted by last updated time in ascending order, so that stale
+  // entries are always at the front.
   std::vector<PeerAddrEntry> peerAddrEntries_;
 
+  size_t maxPeerAddrEntry_;
+
   Timer lastUpdated_;
 
+  // BEP 33 bloom filters of seeders and downloaders. They are
+  // updated as peers are added, and rebuilt lazily after peers are
+  // removed, because bits cannot be removed from bloom filter.
+  BloomFilter seedFilter_;
+
+  BloomFilter peerFilter_;
+
+  bool filterDirty_;
+
+  void addToFilter(const PeerAddrEntry& entry);
+
 public:
-  DHTPeerAnnounceEntry(const unsigned char* infoHash);
+  DHTPeerAnnounceEntry(const unsigned char* infoHash,
+                       size_t maxPeerAddrEntry = DHT_MAX_PEER_ADDR_ENTRY);
 
   ~DHTPeerAnnounceEntry();
 
   // add peer addr entry.
-  // if it already exists, update "Last Updated" property.
+  // if it already exists, update "Last Updated" property.  If the
+  // number of entries reaches maxPeerAddrEntry, the least recently
+  // updated entry is removed.
   void addPeerAddrEntry(const PeerAddrEntry& entry);
 
   size_t countPeerAddrEntry() const;
@@ -83,6 +106,12 @@ public:
   const unsigned char* getInfoHash() const { return infoHash_; }
 
   void getPeers(std::vector<std::shared_ptr<Peer>>& peers) const;
+
+  // Returns BEP 33 bloom filter of seeders.
+  const BloomFilter& getSeedFilter();
+
+  // Returns BEP 33 bloom filter of downloaders.
+  const BloomFilter& getPeerFilter();
 };
 
 } // namespace aria2
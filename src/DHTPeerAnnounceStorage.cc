@@ -47,80 +47,113 @@
 #include "Logger.h"
 #include "util.h"
 #include "a2functional.h"
+#include "SimpleRandomizer.h"
 #include "wallclock.h"
 #include "fmt.h"
 
 namespace aria2 {
 
-DHTPeerAnnounceStorage::DHTPeerAnnounceStorage()
-    : taskQueue_{nullptr}, taskFactory_{nullptr}
+DHTPeerAnnounceStorage::InfoHashHash::InfoHashHash()
 {
+  SimpleRandomizer::getInstance()->getRandomBytes(
+      reinterpret_cast<unsigned char*>(keys_.data()),
+      keys_.size() * sizeof(keys_[0]));
 }
 
-bool DHTPeerAnnounceStorage::InfoHashLess::operator()(
-    const std::shared_ptr<DHTPeerAnnounceEntry>& lhs,
-    const std::shared_ptr<DHTPeerAnnounceEntry>& rhs) const
+size_t DHTPeerAnnounceStorage::InfoHashHash::operator()(
+    const InfoHash& infoHash) const
 {
-  return memcmp(lhs->getInfoHash(), rhs->getInfoHash(), DHT_ID_LENGTH) < 0;
+  // Multilinear hash of the info hash read as three 64 bits words,
+  // the last one being zero padded.
+  uint64_t words[3] = {};
+  memcpy(words, infoHash.data(), DHT_ID_LENGTH);
+  uint64_t h = 0;
+  for (size_t i = 0; i < 3; ++i) {
+    h += (keys_[i] | 1) * words[i];
+  }
+  return h >> 32 ^ h;
 }
 
-std::shared_ptr<DHTPeerAnnounceEntry>
-DHTPeerAnnounceStorage::getPeerAnnounceEntry(const unsigned char* infoHash)
+DHTPeerAnnounceStorage::DHTPeerAnnounceStorage()
+    : taskQueue_{nullptr}, taskFactory_{nullptr}
 {
-  auto entry = std::make_shared<DHTPeerAnnounceEntry>(infoHash);
+}
 
-  auto i = entries_.lower_bound(entry);
+DHTPeerAnnounceStorage::~DHTPeerAnnounceStorage() = default;
 
-  if (i != entries_.end() &&
-      memcmp(infoHash, (*i)->getInfoHash(), DHT_ID_LENGTH) == 0) {
-    entry = *i;
+DHTPeerAnnounceEntry*
+DHTPeerAnnounceStorage::getPeerAnnounceEntry(const unsigned char* infoHash)
+{
+  InfoHash key;
+  std::copy_n(infoHash, DHT_ID_LENGTH, std::begin(key));
+  auto& entry = entries_[key];
+  if (!entry) {
+    entry = make_unique<DHTPeerAnnounceEntry>(infoHash);
   }
-  else {
-    entries_.insert(i, entry);
+  return entry.get();
+}
+
+DHTPeerAnnounceEntry* DHTPeerAnnounceStorage::findPeerAnnounceEntry(
+    const unsigned char* infoHash) const
+{
+  InfoHash key;
+  std::copy_n(infoHash, DHT_ID_LENGTH, std::begin(key));
+  auto i = entries_.find(key);
+  if (i == std::end(entries_)) {
+    return nullptr;
   }
-  return entry;
+  return (*i).second.get();
 }
 
 void DHTPeerAnnounceStorage::addPeerAnnounce(const unsigned char* infoHash,
                                              const std::string& ipaddr,
-                                             uint16_t port)
+                                             uint16_t port, bool seed)
 {
-  A2_LOG_DEBUG(fmt("Adding %s:%u to peer announce list: infoHash=%s",
+  A2_LOG_DEBUG(fmt("Adding %s:%u to peer announce list: infoHash=%s, seed=%d",
                    ipaddr.c_str(), port,
-                   util::toHex(infoHash, DHT_ID_LENGTH).c_str()));
-  getPeerAnnounceEntry(infoHash)->addPeerAddrEntry(PeerAddrEntry(ipaddr, port));
+                   util::toHex(infoHash, DHT_ID_LENGTH).c_str(), seed));
+  getPeerAnnounceEntry(infoHash)->addPeerAddrEntry(
+      PeerAddrEntry(ipaddr, port, Timer(), seed));
 }
 
 bool DHTPeerAnnounceStorage::contains(const unsigned char* infoHash) const
 {
-  auto entry = std::make_shared<DHTPeerAnnounceEntry>(infoHash);
-  return std::binary_search(entries_.begin(), entries_.end(), entry,
-                            InfoHashLess());
+  return findPeerAnnounceEntry(infoHash);
 }
 
 void DHTPeerAnnounceStorage::getPeers(std::vector<std::shared_ptr<Peer>>& peers,
                                       const unsigned char* infoHash)
 {
-  auto entry = std::make_shared<DHTPeerAnnounceEntry>(infoHash);
+  auto entry = findPeerAnnounceEntry(infoHash);
+  if (entry) {
+    entry->getPeers(peers);
+  }
+}
 
-  auto i = entries_.find(entry);
-  if (i != entries_.end()) {
-    (*i)->getPeers(peers);
+bool DHTPeerAnnounceStorage::getScrapeFilters(unsigned char* seedFilter,
+                                              unsigned char* peerFilter,
+                                              const unsigned char* infoHash)
+{
+  auto entry = findPeerAnnounceEntry(infoHash);
+  if (!entry) {
+    return false;
   }
+  auto& seeds = entry->getSeedFilter();
+  std::copy(std::begin(seeds), std::end(seeds), seedFilter);
+  auto& peers = entry->getPeerFilter();
+  std::copy(std::begin(peers), std::end(peers), peerFilter);
+  return true;
 }
 
 void DHTPeerAnnounceStorage::handleTimeout()
 {
   A2_LOG_DEBUG(fmt("Now purge peer announces(%lu entries) which are timed out.",
                    static_cast<unsigned long>(entries_.size())));
-  std::for_each(std::begin(entries_), std::end(entries_),
-                [](const std::shared_ptr<DHTPeerAnnounceEntry>& e) {
-                  e->removeStalePeerAddrEntry(DHT_PEER_ANNOUNCE_PURGE_INTERVAL);
-                });
-
   for (auto i = std::begin(entries_); i != std::end(entries_);) {
-    if ((*i)->empty()) {
-      entries_.erase(i++);
+    auto& e = (*i).second;
+    e->removeStalePeerAddrEntry(DHT_PEER_ANNOUNCE_PURGE_INTERVAL);
+    if (e->empty()) {
+      i = entries_.erase(i);
     }
     else {
       ++i;
@@ -133,7 +166,8 @@ void DHTPeerAnnounceStorage::handleTimeout()
 void DHTPeerAnnounceStorage::announcePeer()
 {
   A2_LOG_DEBUG("Now announcing peer.");
-  for (auto& e : entries_) {
+  for (auto& kv : entries_) {
+    auto& e = kv.second;
     if (e->getLastUpdated().difference(global::wallclock()) <
         DHT_PEER_ANNOUNCE_INTERVAL) {
       continue;
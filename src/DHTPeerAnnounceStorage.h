@@ -37,11 +37,14 @@
 
 #include "common.h"
 
-#include <set>
+#include <unordered_map>
+#include <array>
 #include <vector>
 #include <string>
 #include <memory>
 
+#include "DHTConstants.h"
+
 namespace aria2 {
 
 class Peer;
@@ -51,17 +54,28 @@ class DHTTaskFactory;
 
 class DHTPeerAnnounceStorage {
 private:
-  class InfoHashLess {
+  typedef std::array<unsigned char, DHT_ID_LENGTH> InfoHash;
+
+  // Info hashes come from remote nodes, so they are hashed with
+  // random keys to make hash collisions hard to craft.
+  class InfoHashHash {
   public:
-    bool operator()(const std::shared_ptr<DHTPeerAnnounceEntry>& lhs,
-                    const std::shared_ptr<DHTPeerAnnounceEntry>& rhs) const;
+    InfoHashHash();
+    size_t operator()(const InfoHash& infoHash) const;
+
+  private:
+    std::array<uint64_t, 3> keys_;
   };
-  typedef std::set<std::shared_ptr<DHTPeerAnnounceEntry>, InfoHashLess>
-      DHTPeerAnnounceEntrySet;
-  DHTPeerAnnounceEntrySet entries_;
 
-  std::shared_ptr<DHTPeerAnnounceEntry>
-  getPeerAnnounceEntry(const unsigned char* infoHash);
+  typedef std::unordered_map<InfoHash, std::unique_ptr<DHTPeerAnnounceEntry>,
+                             InfoHashHash>
+      DHTPeerAnnounceEntryMap;
+  DHTPeerAnnounceEntryMap entries_;
+
+  DHTPeerAnnounceEntry* getPeerAnnounceEntry(const unsigned char* infoHash);
+
+  DHTPeerAnnounceEntry*
+  findPeerAnnounceEntry(const unsigned char* infoHash) const;
 
   DHTTaskQueue* taskQueue_;
 
@@ -70,14 +84,23 @@ private:
 public:
   DHTPeerAnnounceStorage();
 
+  ~DHTPeerAnnounceStorage();
+
   void addPeerAnnounce(const unsigned char* infoHash, const std::string& ipaddr,
-                       uint16_t port);
+                       uint16_t port, bool seed = false);
 
   bool contains(const unsigned char* infoHash) const;
 
   void getPeers(std::vector<std::shared_ptr<Peer>>& peers,
                 const unsigned char* infoHash);
 
+  // Stores BEP 33 bloom filters of seeders and downloaders of
+  // infoHash in seedFilter and peerFilter respectively. Both of them
+  // must be at least DHT_SCRAPE_BLOOM_FILTER_LENGTH bytes.  Returns
+  // false if infoHash is not found.
+  bool getScrapeFilters(unsigned char* seedFilter, unsigned char* peerFilter,
+                        const unsigned char* infoHash);
+
   // drop peer announce entry which is not updated in the past
   // DHT_PEER_ANNOUNCE_PURGE_INTERVAL seconds.
   void handleTimeout();
@@ -90,7 +90,8 @@ DHTPeerLookupTask::createMessage(const std::shared_ptr<DHTNode>& remoteNode)
 
 std::unique_ptr<DHTMessageCallback> DHTPeerLookupTask::createCallback()
 {
-  return make_unique<DHTPeerLookupTaskCallback>(this);
+  return make_unique<DHTPeerLookupTaskCallback>(
+      std::static_pointer_cast<DHTPeerLookupTask>(shared_from_this()));
 }
 
 void DHTPeerLookupTask::onFinish()
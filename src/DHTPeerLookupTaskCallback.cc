@@ -42,8 +42,9 @@
 
 namespace aria2 {
 
-DHTPeerLookupTaskCallback::DHTPeerLookupTaskCallback(DHTPeerLookupTask* task)
-    : task_(task)
+DHTPeerLookupTaskCallback::DHTPeerLookupTaskCallback(
+    std::shared_ptr<DHTPeerLookupTask> task)
+    : task_(std::move(task))
 {
 }
 
@@ -74,4 +75,10 @@ void DHTPeerLookupTaskCallback::onTimeout(
   task_->onTimeout(remoteNode);
 }
 
+void DHTPeerLookupTaskCallback::onSlowResponse(
+    const std::shared_ptr<DHTNode>& remoteNode)
+{
+  task_->onSlowResponse(remoteNode);
+}
+
 } // namespace aria2
@@ -43,10 +43,12 @@ class DHTPeerLookupTask;
 
 class DHTPeerLookupTaskCallback : public DHTMessageCallback {
 private:
-  DHTPeerLookupTask* task_;
+  // Keeps the task alive until this callback is called, even if the
+  // lookup has finished.
+  std::shared_ptr<DHTPeerLookupTask> task_;
 
 public:
-  DHTPeerLookupTaskCallback(DHTPeerLookupTask* task);
+  DHTPeerLookupTaskCallback(std::shared_ptr<DHTPeerLookupTask> task);
 
   virtual void visit(const DHTAnnouncePeerReplyMessage* message) CXX11_OVERRIDE;
 
@@ -58,6 +60,9 @@ public:
 
   virtual void
   onTimeout(const std::shared_ptr<DHTNode>& remoteNode) CXX11_OVERRIDE;
+
+  virtual void
+  onSlowResponse(const std::shared_ptr<DHTNode>& remoteNode) CXX11_OVERRIDE;
 };
 
 } // namespace aria2
@@ -55,7 +55,8 @@ DHTTaskFactoryImpl::DHTTaskFactoryImpl()
       dispatcher_(nullptr),
       factory_(nullptr),
       taskQueue_(nullptr),
-      timeout_(DHT_MESSAGE_TIMEOUT)
+      timeout_(DHT_MESSAGE_TIMEOUT),
+      lookupConcurrency_(DHT_LOOKUP_CONCURRENCY)
 {
 }
 
@@ -75,6 +76,7 @@ std::shared_ptr<DHTTask>
 DHTTaskFactoryImpl::createNodeLookupTask(const unsigned char* targetID)
 {
   auto task = std::make_shared<DHTNodeLookupTask>(targetID);
+  task->setConcurrency(lookupConcurrency_);
   setCommonProperty(task);
   return task;
 }
@@ -82,6 +84,7 @@ DHTTaskFactoryImpl::createNodeLookupTask(const unsigned char* targetID)
 std::shared_ptr<DHTTask> DHTTaskFactoryImpl::createBucketRefreshTask()
 {
   auto task = std::make_shared<DHTBucketRefreshTask>();
+  task->setLookupConcurrency(lookupConcurrency_);
   setCommonProperty(task);
   return task;
 }
@@ -91,6 +94,7 @@ std::shared_ptr<DHTTask> DHTTaskFactoryImpl::createPeerLookupTask(
     const std::shared_ptr<PeerStorage>& peerStorage)
 {
   auto task = std::make_shared<DHTPeerLookupTask>(ctx, tcpPort);
+  task->setConcurrency(lookupConcurrency_);
   // TODO this may be not freed by RequestGroup::releaseRuntimeResource()
   task->setPeerStorage(peerStorage);
   setCommonProperty(task);
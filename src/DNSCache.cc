@@ -34,6 +34,10 @@
 /* copyright --> */
 #include "DNSCache.h"
 #include "A2STR.h"
+#include "wallclock.h"
+#include "LogFactory.h"
+#include "fmt.h"
+#include "Command.h"
 
 namespace aria2 {
 
@@ -56,7 +60,7 @@ DNSCache::AddrEntry& DNSCache::AddrEntry::operator=(const AddrEntry& c)
 }
 
 DNSCache::CacheEntry::CacheEntry(const std::string& hostname, uint16_t port)
-    : hostname_(hostname), port_(port)
+    : hostname_(hostname), port_(port), negative_(false), refreshing_(false)
 {
 }
 
@@ -64,15 +68,8 @@ DNSCache::CacheEntry::CacheEntry(const CacheEntry& c) = default;
 
 DNSCache::CacheEntry::~CacheEntry() = default;
 
-DNSCache::CacheEntry& DNSCache::CacheEntry::operator=(const CacheEntry& c)
-{
-  if (this != &c) {
-    hostname_ = c.hostname_;
-    port_ = c.port_;
-    addrEntries_ = c.addrEntries_;
-  }
-  return *this;
-}
+DNSCache::CacheEntry&
+DNSCache::CacheEntry::operator=(const CacheEntry& c) = default;
 
 bool DNSCache::CacheEntry::add(const std::string& addr)
 {
@@ -124,6 +121,12 @@ const std::string& DNSCache::CacheEntry::getGoodAddr() const
   return A2STR::NIL;
 }
 
+bool DNSCache::CacheEntry::hasGoodAddr() const
+{
+  return std::any_of(std::begin(addrEntries_), std::end(addrEntries_),
+                     [](const AddrEntry& e) { return e.good_; });
+}
+
 void DNSCache::CacheEntry::markBad(const std::string& addr)
 {
   auto i = find(addr);
@@ -132,6 +135,15 @@ void DNSCache::CacheEntry::markBad(const std::string& addr)
   }
 }
 
+void DNSCache::CacheEntry::markGood(const std::string& addr)
+{
+  auto i = find(addr);
+  if (i != addrEntries_.end()) {
+    i->good_ = true;
+    std::rotate(addrEntries_.begin(), i, i + 1);
+  }
+}
+
 bool DNSCache::CacheEntry::operator<(const CacheEntry& e) const
 {
   int r = hostname_.compare(e.hostname_);
@@ -146,18 +158,118 @@ bool DNSCache::CacheEntry::operator==(const CacheEntry& e) const
   return hostname_ == e.hostname_ && port_ == e.port_;
 }
 
-DNSCache::DNSCache() {}
+DNSCache::DNSCache(size_t maxEntries, std::chrono::seconds ttl,
+                   std::chrono::seconds negativeTtl,
+                   std::chrono::seconds staleTtl)
+    : maxEntries_(maxEntries),
+      ttl_(std::move(ttl)),
+      negativeTtl_(std::move(negativeTtl)),
+      staleTtl_(std::move(staleTtl)),
+      numHits_(0),
+      numStaleHits_(0),
+      numNegativeHits_(0),
+      numMisses_(0),
+      numEvicted_(0),
+      numJoined_(0)
+{
+}
 
 DNSCache::DNSCache(const DNSCache& c) = default;
 
 DNSCache::~DNSCache() = default;
 
-DNSCache& DNSCache::operator=(const DNSCache& c)
+DNSCache& DNSCache::operator=(const DNSCache& c) = default;
+
+bool DNSCache::isObsolete(const CacheEntry& entry, const Timer& now) const
 {
-  if (this != &c) {
-    entries_ = c.entries_;
+  auto expiry = entry.expiry_;
+  if (!entry.negative_) {
+    expiry.advance(staleTtl_);
   }
-  return *this;
+  return expiry <= now;
+}
+
+const std::shared_ptr<DNSCache::CacheEntry>&
+DNSCache::getOrCreate(const std::string& hostname, uint16_t port)
+{
+  auto target = std::make_shared<CacheEntry>(hostname, port);
+  auto i = entries_.lower_bound(target);
+  if (i != entries_.end() && *(*i) == *target) {
+    return *i;
+  }
+  if (maxEntries_ > 0 && entries_.size() >= maxEntries_) {
+    evict();
+    i = entries_.lower_bound(target);
+  }
+  const auto& now = global::wallclock();
+  target->expiry_ = now;
+  target->expiry_.advance(ttl_);
+  target->lastAccess_ = now;
+  return *entries_.insert(i, target);
+}
+
+void DNSCache::evict()
+{
+  const auto& now = global::wallclock();
+  // Drop obsolete entries first.  If there is none, drop the least
+  // recently used one.
+  auto lru = std::end(entries_);
+  for (auto i = std::begin(entries_); i != std::end(entries_);) {
+    if (isObsolete(*(*i), now)) {
+      i = entries_.erase(i);
+      ++numEvicted_;
+      continue;
+    }
+    if (lru == std::end(entries_) || (*i)->lastAccess_ < (*lru)->lastAccess_) {
+      lru = i;
+    }
+    ++i;
+  }
+  if (entries_.size() >= maxEntries_ && lru != std::end(entries_)) {
+    entries_.erase(lru);
+    ++numEvicted_;
+  }
+}
+
+DNSCache::LookupResult DNSCache::lookup(std::vector<std::string>& addrs,
+                                        std::string& error,
+                                        const std::string& hostname,
+                                        uint16_t port)
+{
+  auto target = std::make_shared<CacheEntry>(hostname, port);
+  auto i = entries_.find(target);
+  if (i == entries_.end()) {
+    ++numMisses_;
+    return DNS_CACHE_MISS;
+  }
+  auto& entry = *(*i);
+  const auto& now = global::wallclock();
+  if (isObsolete(entry, now)) {
+    entries_.erase(i);
+    ++numMisses_;
+    return DNS_CACHE_MISS;
+  }
+  entry.lastAccess_ = now;
+  if (entry.negative_) {
+    error = entry.error_;
+    ++numNegativeHits_;
+    return DNS_CACHE_NEGATIVE;
+  }
+  if (!entry.hasGoodAddr()) {
+    ++numMisses_;
+    return DNS_CACHE_MISS;
+  }
+  entry.getAllGoodAddrs(std::back_inserter(addrs));
+  if (now < entry.expiry_) {
+    ++numHits_;
+    return DNS_CACHE_HIT;
+  }
+  ++numStaleHits_;
+  if (entry.refreshing_) {
+    return DNS_CACHE_HIT;
+  }
+  entry.refreshing_ = true;
+  return DNS_CACHE_STALE;
 }
 
 const std::string& DNSCache::find(const std::string& hostname,
@@ -176,14 +288,74 @@ const std::string& DNSCache::find(const std::string& hostname,
 void DNSCache::put(const std::string& hostname, const std::string& ipaddr,
                    uint16_t port)
 {
-  auto target = std::make_shared<CacheEntry>(hostname, port);
-  auto i = entries_.lower_bound(target);
-  if (i != entries_.end() && *(*i) == *target) {
-    (*i)->add(ipaddr);
+  auto& entry = getOrCreate(hostname, port);
+  if (entry->negative_) {
+    entry->negative_ = false;
+    entry->error_.clear();
+    entry->expiry_ = global::wallclock();
+    entry->expiry_.advance(ttl_);
   }
-  else {
-    target->add(ipaddr);
-    entries_.insert(i, target);
+  entry->add(ipaddr);
+}
+
+void DNSCache::put(const std::string& hostname,
+                   const std::vector<std::string>& addrs, uint16_t port,
+                   std::chrono::seconds ttl)
+{
+  if (addrs.empty()) {
+    return;
+  }
+  if (ttl.count() <= 0 || ttl > ttl_) {
+    ttl = ttl_;
+  }
+  auto& entry = getOrCreate(hostname, port);
+  // Keep the addresses which are still returned, with their good/bad
+  // marks and in the order markGood() arranged, so that a refresh
+  // does not make us try a bad address again.
+  std::vector<AddrEntry> addrEntries;
+  for (auto& e : entry->addrEntries_) {
+    if (std::find(std::begin(addrs), std::end(addrs), e.addr_) !=
+        std::end(addrs)) {
+      addrEntries.push_back(e);
+    }
+  }
+  entry->addrEntries_.swap(addrEntries);
+  for (auto& addr : addrs) {
+    entry->add(addr);
+  }
+  if (!entry->hasGoodAddr()) {
+    for (auto& e : entry->addrEntries_) {
+      e.good_ = true;
+    }
+  }
+  entry->negative_ = false;
+  entry->error_.clear();
+  entry->refreshing_ = false;
+  entry->expiry_ = global::wallclock();
+  entry->expiry_.advance(ttl);
+}
+
+void DNSCache::putNegative(const std::string& hostname, uint16_t port,
+                           const std::string& error)
+{
+  if (negativeTtl_.count() <= 0) {
+    return;
+  }
+  auto& entry = getOrCreate(hostname, port);
+  entry->addrEntries_.clear();
+  entry->negative_ = true;
+  entry->error_ = error;
+  entry->refreshing_ = false;
+  entry->expiry_ = global::wallclock();
+  entry->expiry_.advance(negativeTtl_);
+}
+
+void DNSCache::abortRefresh(const std::string& hostname, uint16_t port)
+{
+  auto target = std::make_shared<CacheEntry>(hostname, port);
+  auto i = entries_.find(target);
+  if (i != entries_.end()) {
+    (*i)->refreshing_ = false;
   }
 }
 
@@ -197,10 +369,111 @@ void DNSCache::markBad(const std::string& hostname, const std::string& ipaddr,
   }
 }
 
+void DNSCache::markGood(const std::string& hostname, const std::string& ipaddr,
+                        uint16_t port)
+{
+  auto target = std::make_shared<CacheEntry>(hostname, port);
+  auto i = entries_.find(target);
+  if (i != entries_.end()) {
+    (*i)->markGood(ipaddr);
+  }
+}
+
 void DNSCache::remove(const std::string& hostname, uint16_t port)
 {
   auto target = std::make_shared<CacheEntry>(hostname, port);
   entries_.erase(target);
 }
 
+bool DNSCache::acquireResolution(const std::string& hostname, uint16_t port,
+                                 Command* command)
+{
+  auto i = resolutions_.find(std::make_pair(hostname, port));
+  if (i == std::end(resolutions_)) {
+    resolutions_.emplace(std::make_pair(hostname, port),
+                         Resolution{command, std::vector<Command*>{}});
+    return true;
+  }
+  auto& res = (*i).second;
+  if (res.resolver == command) {
+    return true;
+  }
+  if (std::find(std::begin(res.waiters), std::end(res.waiters), command) ==
+      std::end(res.waiters)) {
+    res.waiters.push_back(command);
+    ++numJoined_;
+  }
+  return false;
+}
+
+void DNSCache::finishResolution(
+    std::map<std::pair<std::string, uint16_t>, Resolution>::iterator i,
+    const std::string& error)
+{
+  for (auto command : (*i).second.waiters) {
+    if (!error.empty()) {
+      resolutionErrors_[command] = error;
+    }
+    command->setStatusActive();
+  }
+  resolutions_.erase(i);
+}
+
+bool DNSCache::finishResolution(const std::string& hostname, uint16_t port,
+                                const std::string& error)
+{
+  auto i = resolutions_.find(std::make_pair(hostname, port));
+  if (i == std::end(resolutions_)) {
+    return false;
+  }
+  auto woken = !(*i).second.waiters.empty();
+  finishResolution(i, error);
+  return woken;
+}
+
+bool DNSCache::cancelResolution(Command* command)
+{
+  resolutionErrors_.erase(command);
+  for (auto i = std::begin(resolutions_); i != std::end(resolutions_); ++i) {
+    auto& res = (*i).second;
+    if (res.resolver == command) {
+      auto woken = !res.waiters.empty();
+      finishResolution(i, A2STR::NIL);
+      return woken;
+    }
+    auto j = std::find(std::begin(res.waiters), std::end(res.waiters), command);
+    if (j != std::end(res.waiters)) {
+      res.waiters.erase(j);
+      return false;
+    }
+  }
+  return false;
+}
+
+bool DNSCache::takeResolutionError(const Command* command, std::string& error)
+{
+  auto i = resolutionErrors_.find(command);
+  if (i == std::end(resolutionErrors_)) {
+    return false;
+  }
+  error = std::move((*i).second);
+  resolutionErrors_.erase(i);
+  return true;
+}
+
+void DNSCache::log() const
+{
+  if (numHits_ == 0 && numStaleHits_ == 0 && numNegativeHits_ == 0 &&
+      numMisses_ == 0) {
+    return;
+  }
+  A2_LOG_INFO(fmt("DNS cache: hits=%" PRIu64 ", stale hits=%" PRIu64
+                  ", negative hits=%" PRIu64 ", misses=%" PRIu64
+                  ", cached hosts=%lu, evicted=%" PRIu64
+                  ", shared resolutions=%" PRIu64,
+                  numHits_, numStaleHits_, numNegativeHits_, numMisses_,
+                  static_cast<unsigned long>(entries_.size()), numEvicted_,
+                  numJoined_));
+}
+
 } // namespace aria2
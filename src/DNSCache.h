@@ -39,14 +39,42 @@
 
 #include <string>
 #include <set>
+#include <map>
 #include <algorithm>
 #include <vector>
+#include <chrono>
 
 #include "a2functional.h"
+#include "TimerA2.h"
 
 namespace aria2 {
 
+class Command;
+
+// Caches resolved addresses per hostname and port.  An entry expires
+// after the TTL given when it was stored, capped by the TTL of the
+// cache.  An expired entry is still served by lookup() for staleTtl,
+// so that the entry of a busy host can be refreshed in the
+// background.  Failures to find a hostname are cached for
+// negativeTtl.  If the cache is full, the least recently used entry
+// is evicted.  The cache also tracks the commands resolving each
+// hostname and port, so that one resolution serves all commands
+// which miss the cache at the same time.
 class DNSCache {
+public:
+  enum LookupResult {
+    // No usable entry.  The hostname must be resolved.
+    DNS_CACHE_MISS,
+    // Addresses are found.
+    DNS_CACHE_HIT,
+    // Addresses are found, but the entry has expired.  The caller
+    // must refresh the entry.  This is returned to one caller until
+    // the entry is stored again or the refresh is aborted.
+    DNS_CACHE_STALE,
+    // The hostname was not found by the last resolution.
+    DNS_CACHE_NEGATIVE
+  };
+
 private:
   struct AddrEntry {
     std::string addr_;
@@ -63,6 +91,12 @@ private:
     std::string hostname_;
     uint16_t port_;
     std::vector<AddrEntry> addrEntries_;
+    Timer expiry_;
+    Timer lastAccess_;
+    // Error message of failed resolution if this is a negative entry.
+    std::string error_;
+    bool negative_;
+    bool refreshing_;
 
     CacheEntry(const std::string& hostname, uint16_t port);
     CacheEntry(const CacheEntry& c);
@@ -80,6 +114,8 @@ private:
 
     const std::string& getGoodAddr() const;
 
+    bool hasGoodAddr() const;
+
     template <typename OutputIterator>
     void getAllGoodAddrs(OutputIterator out) const
     {
@@ -92,6 +128,8 @@ private:
 
     void markBad(const std::string& addr);
 
+    void markGood(const std::string& addr);
+
     bool operator<(const CacheEntry& e) const;
 
     bool operator==(const CacheEntry& e) const;
@@ -102,13 +140,72 @@ private:
       CacheEntrySet;
   CacheEntrySet entries_;
 
+  struct Resolution {
+    // The command resolving the hostname.
+    Command* resolver;
+    // The commands waiting for the result.
+    std::vector<Command*> waiters;
+  };
+
+  // Resolutions in progress, keyed by hostname and port.
+  std::map<std::pair<std::string, uint16_t>, Resolution> resolutions_;
+  // Errors of failed resolutions, which the waiting commands have not
+  // taken yet.
+  std::map<const Command*, std::string> resolutionErrors_;
+  size_t maxEntries_;
+  std::chrono::seconds ttl_;
+  std::chrono::seconds negativeTtl_;
+  std::chrono::seconds staleTtl_;
+  uint64_t numHits_;
+  uint64_t numStaleHits_;
+  uint64_t numNegativeHits_;
+  uint64_t numMisses_;
+  uint64_t numEvicted_;
+  uint64_t numJoined_;
+
+  // Wakes up the commands waiting for the resolution at |i| and
+  // removes it.  If |error| is not empty, it is handed to them.
+  void finishResolution(
+      std::map<std::pair<std::string, uint16_t>, Resolution>::iterator i,
+      const std::string& error);
+
+  // Returns true if |entry| can be removed.
+  bool isObsolete(const CacheEntry& entry, const Timer& now) const;
+
+  // Returns the entry for hostname and port, inserting new one if it
+  // does not exist.
+  const std::shared_ptr<CacheEntry>& getOrCreate(const std::string& hostname,
+                                                 uint16_t port);
+
+  void evict();
+
 public:
-  DNSCache();
+  // If maxEntries is 0, the number of entries is not limited.
+  DNSCache(size_t maxEntries = 1024,
+           std::chrono::seconds ttl = std::chrono::seconds(300),
+           std::chrono::seconds negativeTtl = std::chrono::seconds(10),
+           std::chrono::seconds staleTtl = std::chrono::seconds(60));
   DNSCache(const DNSCache& c);
   ~DNSCache();
 
   DNSCache& operator=(const DNSCache& c);
 
+  void setTtl(std::chrono::seconds ttl) { ttl_ = std::move(ttl); }
+
+  // Zero disables negative caching.
+  void setNegativeTtl(std::chrono::seconds ttl)
+  {
+    negativeTtl_ = std::move(ttl);
+  }
+
+  // Looks up the good addresses of hostname and port, and appends
+  // them to |addrs|.  If DNS_CACHE_NEGATIVE is returned, the error
+  // message of the failed resolution is assigned to |error|.  Unlike
+  // find() and findAll(), this function takes expiry into account and
+  // is counted in the statistics.
+  LookupResult lookup(std::vector<std::string>& addrs, std::string& error,
+                      const std::string& hostname, uint16_t port);
+
   const std::string& find(const std::string& hostname, uint16_t port) const;
 
   template <typename OutputIterator>
@@ -125,10 +222,75 @@ public:
   void put(const std::string& hostname, const std::string& ipaddr,
            uint16_t port);
 
+  // Replaces the addresses of hostname and port with |addrs| which
+  // have just been resolved.  |ttl| is the TTL of the resolver
+  // response; zero means unknown.  The addresses which were cached
+  // already keep their good/bad marks and order, unless none of them
+  // is good.
+  void put(const std::string& hostname, const std::vector<std::string>& addrs,
+           uint16_t port, std::chrono::seconds ttl);
+
+  // Stores the fact that hostname does not exist.  |error| is the
+  // error message of the resolution.
+  void putNegative(const std::string& hostname, uint16_t port,
+                   const std::string& error);
+
+  // Allows lookup() to return DNS_CACHE_STALE again for hostname and
+  // port.  This is called when the refresh failed.
+  void abortRefresh(const std::string& hostname, uint16_t port);
+
   void markBad(const std::string& hostname, const std::string& ipaddr,
                uint16_t port);
 
+  // Marks ipaddr good and moves it to the front, so that find()
+  // returns it first.
+  void markGood(const std::string& hostname, const std::string& ipaddr,
+                uint16_t port);
+
   void remove(const std::string& hostname, uint16_t port);
+
+  // Returns true if |command| is to resolve hostname and port, which
+  // no other command is resolving.  Otherwise, |command| waits for
+  // the other command and false is returned.  The waiting command is
+  // woken up when the resolution finishes, and then finds the
+  // addresses in the cache, or the error with takeResolutionError().
+  bool acquireResolution(const std::string& hostname, uint16_t port,
+                         Command* command);
+
+  // Called by the command which resolved hostname and port.  Wakes up
+  // the waiting commands and returns true if there are any.  If
+  // |error| is not empty, the resolution failed and the waiting
+  // commands fail with |error|, too.
+  bool finishResolution(const std::string& hostname, uint16_t port,
+                        const std::string& error);
+
+  // Removes |command| from the resolutions.  If it was resolving, the
+  // waiting commands are woken up, so that one of them resolves
+  // instead, and true is returned.
+  bool cancelResolution(Command* command);
+
+  // If the resolution |command| waited for failed, assigns the error
+  // to |error| and returns true.
+  bool takeResolutionError(const Command* command, std::string& error);
+
+  size_t size() const { return entries_.size(); }
+
+  uint64_t getNumHits() const { return numHits_; }
+
+  uint64_t getNumStaleHits() const { return numStaleHits_; }
+
+  uint64_t getNumNegativeHits() const { return numNegativeHits_; }
+
+  uint64_t getNumMisses() const { return numMisses_; }
+
+  uint64_t getNumEvicted() const { return numEvicted_; }
+
+  // Returns the number of times acquireResolution() let a command
+  // wait for another one.
+  uint64_t getNumJoined() const { return numJoined_; }
+
+  // Writes the counters to the log if lookup() was called.
+  void log() const;
 };
 
 } // namespace aria2
@@ -0,0 +1,124 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "DNSRefreshCommand.h"
+#include "DownloadEngine.h"
+#include "DNSCache.h"
+#include "RequestGroupMan.h"
+#include "Option.h"
+#include "prefs.h"
+#include "message.h"
+#include "Logger.h"
+#include "LogFactory.h"
+#include "fmt.h"
+#include "wallclock.h"
+#include "a2functional.h"
+#include "AsyncNameResolverMan.h"
+
+namespace aria2 {
+
+DNSRefreshCommand::DNSRefreshCommand(cuid_t cuid, const std::string& hostname,
+                                     uint16_t port, DownloadEngine* e)
+    : Command(cuid),
+      hostname_(hostname),
+      port_(port),
+      e_(e),
+      asyncNameResolverMan_(make_unique<AsyncNameResolverMan>()),
+      timeoutCheck_(global::wallclock()),
+      timeout_(e->getOption()->getAsInt(PREF_DNS_TIMEOUT))
+{
+  configureAsyncNameResolverMan(asyncNameResolverMan_.get(), e_->getOption());
+}
+
+DNSRefreshCommand::~DNSRefreshCommand()
+{
+  asyncNameResolverMan_->disableNameResolverCheck(e_, this);
+}
+
+bool DNSRefreshCommand::execute()
+{
+  if (e_->getRequestGroupMan()->downloadFinished() || e_->isHaltRequested()) {
+    e_->getDNSCache()->abortRefresh(hostname_, port_);
+    return true;
+  }
+  if (!asyncNameResolverMan_->started()) {
+    asyncNameResolverMan_->startAsync(hostname_, e_, this);
+  }
+  switch (asyncNameResolverMan_->getStatus()) {
+  case -1:
+    onFailure(asyncNameResolverMan_->getLastError(),
+              asyncNameResolverMan_->notFound());
+    return true;
+  case 0:
+    if (timeoutCheck_.difference(global::wallclock()) >= timeout_) {
+      onFailure("timeout", false);
+      return true;
+    }
+    e_->addCommand(std::unique_ptr<Command>(this));
+    return false;
+  default: {
+    std::vector<std::string> addrs;
+    asyncNameResolverMan_->getResolvedAddress(addrs);
+    if (addrs.empty()) {
+      onFailure("No address returned", false);
+    }
+    else {
+      onSuccess(addrs, asyncNameResolverMan_->getTtl());
+    }
+    return true;
+  }
+  }
+}
+
+void DNSRefreshCommand::onSuccess(const std::vector<std::string>& addrs,
+                                  int ttl)
+{
+  A2_LOG_INFO(fmt(MSG_NAME_RESOLUTION_COMPLETE, getCuid(), hostname_.c_str(),
+                  strjoin(std::begin(addrs), std::end(addrs), ", ").c_str()));
+  e_->getDNSCache()->put(hostname_, addrs, port_, std::chrono::seconds(ttl));
+}
+
+void DNSRefreshCommand::onFailure(const std::string& error, bool notFound)
+{
+  A2_LOG_INFO(fmt(MSG_NAME_RESOLUTION_FAILED, getCuid(), hostname_.c_str(),
+                  error.c_str()));
+  if (notFound) {
+    e_->getDNSCache()->putNegative(hostname_, port_, error);
+  }
+  else {
+    e_->getDNSCache()->abortRefresh(hostname_, port_);
+  }
+}
+
+} // namespace aria2
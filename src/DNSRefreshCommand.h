@@ -2,7 +2,7 @@
 /*
  * aria2 - The high speed download utility
  *
- * Copyright (C) 2013 Tatsuhiro Tsujikawa
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
  *
  * This program is free software; you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -32,59 +32,49 @@
  * files in the program, then also delete it here.
  */
 /* copyright --> */
-#ifndef BACKUP_IPV4_CONNECT_COMMAND_H
-#define BACKUP_IPV4_CONNECT_COMMAND_H
+#ifndef D_DNS_REFRESH_COMMAND_H
+#define D_DNS_REFRESH_COMMAND_H
 
 #include "Command.h"
 
 #include <string>
 #include <memory>
+#include <chrono>
 
 #include "TimerA2.h"
 
 namespace aria2 {
 
-class RequestGroup;
 class DownloadEngine;
-class SocketCore;
+class AsyncNameResolverMan;
 
-// Used to communicate mainCommand and backup IPv4 connection command.
-// When backup connection succeeds, ipaddr is filled with connected
-// IPv4 address and socket is a socket connected to the ipaddr.  If
-// mainCommand wants to cancel backup connection command, cancel
-// member becomes true.
-struct BackupConnectInfo {
-  std::string ipaddr;
-  std::shared_ptr<SocketCore> socket;
-  bool cancel;
-  BackupConnectInfo();
-};
-
-// Make backup connection to IPv4 address. This is a simplest RFC 6555
-// "Happy Eyeballs" implementation.
-class BackupIPv4ConnectCommand : public Command {
+// Resolves hostname again asynchronously when its entry in DNSCache
+// has expired.  Meanwhile, the other commands keep using the stale
+// addresses, so that they don't wait for the resolution.  If the
+// resolution fails temporarily, the stale entry is kept.  Only used
+// if asynchronous DNS is enabled.
+class DNSRefreshCommand : public Command {
 public:
-  BackupIPv4ConnectCommand(cuid_t cuid, const std::string& ipaddr,
-                           uint16_t port,
-                           const std::shared_ptr<BackupConnectInfo>& info,
-                           Command* mainCommand, RequestGroup* requestGroup,
-                           DownloadEngine* e);
-  ~BackupIPv4ConnectCommand();
+  DNSRefreshCommand(cuid_t cuid, const std::string& hostname, uint16_t port,
+                    DownloadEngine* e);
+
+  virtual ~DNSRefreshCommand();
+
   virtual bool execute() CXX11_OVERRIDE;
 
 private:
-  std::string ipaddr_;
+  void onSuccess(const std::vector<std::string>& addrs, int ttl);
+
+  void onFailure(const std::string& error, bool notFound);
+
+  std::string hostname_;
   uint16_t port_;
-  std::shared_ptr<SocketCore> socket_;
-  std::shared_ptr<BackupConnectInfo> info_;
-  Command* mainCommand_;
-  RequestGroup* requestGroup_;
   DownloadEngine* e_;
-  Timer startTime_;
+  std::unique_ptr<AsyncNameResolverMan> asyncNameResolverMan_;
   Timer timeoutCheck_;
   std::chrono::seconds timeout_;
 };
 
 } // namespace aria2
 
-#endif // BACKUP_IPV4_CONNECT_COMMAND_H
+#endif // D_DNS_REFRESH_COMMAND_H
@@ -36,6 +36,7 @@
 
 #include <cstring>
 #include <cstdio>
+#include <algorithm>
 
 #include "PieceStorage.h"
 #include "Piece.h"
@@ -53,9 +54,11 @@
 #include "DownloadFailureException.h"
 #include "fmt.h"
 #include "array_fun.h"
+#include "a2functional.h"
 #include "DownloadContext.h"
 #include "BufferedFile.h"
-#include "SHA1IOFile.h"
+#include "MessageDigest.h"
+#include "WrDiskCacheEntry.h"
 #ifdef ENABLE_BITTORRENT
 #  include "PeerStorage.h"
 #  include "BtRuntime.h"
@@ -80,7 +83,12 @@ DefaultBtProgressInfoFile::DefaultBtProgressInfoFile(
     : dctx_(dctx),
       pieceStorage_(pieceStorage),
       option_(option),
-      filename_(createFilename(dctx_, getSuffix()))
+      filename_(createFilename(dctx_, getSuffix())),
+      savedUploadLength_(0),
+      fileLength_(0),
+      snapshotLength_(0),
+      checkpointUploadLength_(0),
+      hasCheckpoint_(false)
 {
 }
 
@@ -89,6 +97,7 @@ DefaultBtProgressInfoFile::~DefaultBtProgressInfoFile() = default;
 void DefaultBtProgressInfoFile::updateFilename()
 {
   filename_ = createFilename(dctx_, getSuffix());
+  resetSavedState();
 }
 
 bool DefaultBtProgressInfoFile::isTorrentDownload()
@@ -100,118 +109,178 @@ bool DefaultBtProgressInfoFile::isTorrentDownload()
 #endif // !ENABLE_BITTORRENT
 }
 
-#define WRITE_CHECK(fp, ptr, count)                                            \
-  if (fp.write((ptr), (count)) != (count)) {                                   \
-    throw DL_ABORT_EX(fmt(EX_SEGMENT_FILE_WRITE, filename_.c_str()));          \
-  }
+namespace {
+// Rewrite the control file when the delta records get longer than
+// this or the snapshot, whichever is longer.
+constexpr int64_t MIN_DELTA_LENGTH_TO_COMPACT = 64_k;
+} // namespace
 
-// Since version 0001, Integers are saved in binary form, network byte order.
-void DefaultBtProgressInfoFile::save(IOFile& fp)
+namespace {
+void appendUInt32(std::string& s, uint32_t n)
+{
+  n = htonl(n);
+  s.append(reinterpret_cast<const char*>(&n), sizeof(n));
+}
+} // namespace
+
+namespace {
+void appendUInt64(std::string& s, uint64_t n)
+{
+  n = hton64(n);
+  s.append(reinterpret_cast<const char*>(&n), sizeof(n));
+}
+} // namespace
+
+namespace {
+// Returns the checksum of a delta record, which is the first 4 bytes
+// of SHA-1 of |payload|.
+std::string recordChecksum(const std::string& payload)
+{
+  auto ctx = MessageDigest::sha1();
+  ctx->update(payload.data(), payload.size());
+  return ctx->digest().substr(0, 4);
+}
+} // namespace
+
+uint64_t DefaultBtProgressInfoFile::getUploadLength()
 {
 #ifdef ENABLE_BITTORRENT
-  bool torrentDownload = isTorrentDownload();
-#else  // !ENABLE_BITTORRENT
-  bool torrentDownload = false;
-#endif // !ENABLE_BITTORRENT
+  if (isTorrentDownload()) {
+    return btRuntime_->getUploadLengthAtStartup() +
+           dctx_->getNetStat().getSessionUploadLength();
+  }
+#endif // ENABLE_BITTORRENT
+  return 0;
+}
+
+namespace {
+// Unsets the bits of |bitfield|, the bitfield of |piece|, of the
+// blocks which have data in the write cache.
+void unsetCachedBlocks(unsigned char* bitfield, const Piece& piece,
+                       int32_t pieceLength)
+{
+  auto ce = piece.getWrDiskCacheEntry();
+  if (!ce) {
+    return;
+  }
+  auto pieceOffset = static_cast<int64_t>(piece.getIndex()) * pieceLength;
+  auto blockLength = piece.getBlockLength();
+  for (auto cell : ce->getDataSet()) {
+    if (cell->len == 0) {
+      continue;
+    }
+    size_t first = (cell->goff - pieceOffset) / blockLength;
+    size_t last = (cell->goff + cell->len - 1 - pieceOffset) / blockLength;
+    for (auto i = first; i <= last; ++i) {
+      bitfield[i / 8] &= ~(0x80u >> (i % 8));
+    }
+  }
+}
+} // namespace
+
+std::string DefaultBtProgressInfoFile::serializeInFlightPieces(bool writtenOnly)
+{
+  std::vector<std::shared_ptr<Piece>> inFlightPieces;
+  inFlightPieces.reserve(pieceStorage_->countInFlightPiece());
+  pieceStorage_->getInFlightPieces(inFlightPieces);
+  std::string s;
+  // the number of in-flight piece: 32 bits
+  appendUInt32(s, inFlightPieces.size());
+  for (auto& piece : inFlightPieces) {
+    appendUInt32(s, piece->getIndex());
+    appendUInt32(s, piece->getLength());
+    appendUInt32(s, piece->getBitfieldLength());
+    auto first = s.size();
+    s.append(reinterpret_cast<const char*>(piece->getBitfield()),
+             piece->getBitfieldLength());
+    if (writtenOnly) {
+      unsetCachedBlocks(reinterpret_cast<unsigned char*>(&s[first]), *piece,
+                        dctx_->getPieceLength());
+    }
+  }
+  return s;
+}
+
+bool DefaultBtProgressInfoFile::changed(const unsigned char* bitfield,
+                                        uint64_t uploadLength,
+                                        const std::string& inFlightPieces)
+{
+  return savedBitfield_.size() != pieceStorage_->getBitfieldLength() ||
+         !std::equal(std::begin(savedBitfield_), std::end(savedBitfield_),
+                     bitfield) ||
+         savedInFlightPieces_ != inFlightPieces ||
+         savedUploadLength_ != uploadLength;
+}
+
+bool DefaultBtProgressInfoFile::needsSave()
+{
+  return changed(pieceStorage_->getBitfield(), getUploadLength(),
+                 serializeInFlightPieces(false));
+}
+
+void DefaultBtProgressInfoFile::resetSavedState()
+{
+  savedBitfield_.clear();
+  savedInFlightPieces_.clear();
+  savedUploadLength_ = 0;
+  fileLength_ = 0;
+  snapshotLength_ = 0;
+  hasCheckpoint_ = false;
+}
+
+// Since version 0001, Integers are saved in binary form, network byte
+// order.  Since version 0002, delta records may follow the snapshot.
+void DefaultBtProgressInfoFile::saveSnapshot(const unsigned char* bitfield,
+                                             uint64_t uploadLength,
+                                             std::string inFlightPieces)
+{
+  std::string s;
   // file version: 16 bits
-  // values: '1'
-  char version[] = {0x00u, 0x01u};
-  WRITE_CHECK(fp, version, sizeof(version));
+  // values: '2'
+  s += '\0';
+  s += '\x02';
   // extension: 32 bits
   // If this is BitTorrent download, then 0x00000001
   // Otherwise, 0x00000000
-  char extension[4];
-  memset(extension, 0, sizeof(extension));
-  if (torrentDownload) {
-    extension[3] = 1;
-  }
-  WRITE_CHECK(fp, extension, sizeof(extension));
-  if (torrentDownload) {
+  appendUInt32(s, isTorrentDownload() ? 1 : 0);
+  if (isTorrentDownload()) {
 #ifdef ENABLE_BITTORRENT
     // infoHashLength:
     // length: 32 bits
-    const unsigned char* infoHash = bittorrent::getInfoHash(dctx_);
-    uint32_t infoHashLengthNL = htonl(INFO_HASH_LENGTH);
-    WRITE_CHECK(fp, &infoHashLengthNL, sizeof(infoHashLengthNL));
+    appendUInt32(s, INFO_HASH_LENGTH);
     // infoHash:
-    WRITE_CHECK(fp, infoHash, INFO_HASH_LENGTH);
+    s.append(reinterpret_cast<const char*>(bittorrent::getInfoHash(dctx_)),
+             INFO_HASH_LENGTH);
 #endif // ENABLE_BITTORRENT
   }
   else {
     // infoHashLength:
     // length: 32 bits
-    uint32_t infoHashLength = 0;
-    WRITE_CHECK(fp, &infoHashLength, sizeof(infoHashLength));
+    appendUInt32(s, 0);
   }
   // pieceLength: 32 bits
-  uint32_t pieceLengthNL = htonl(dctx_->getPieceLength());
-  WRITE_CHECK(fp, &pieceLengthNL, sizeof(pieceLengthNL));
+  appendUInt32(s, dctx_->getPieceLength());
   // totalLength: 64 bits
-  uint64_t totalLengthNL = hton64(dctx_->getTotalLength());
-  WRITE_CHECK(fp, &totalLengthNL, sizeof(totalLengthNL));
+  appendUInt64(s, dctx_->getTotalLength());
   // uploadLength: 64 bits
-  uint64_t uploadLengthNL = 0;
-#ifdef ENABLE_BITTORRENT
-  if (torrentDownload) {
-    uploadLengthNL = hton64(btRuntime_->getUploadLengthAtStartup() +
-                            dctx_->getNetStat().getSessionUploadLength());
-  }
-#endif // ENABLE_BITTORRENT
-  WRITE_CHECK(fp, &uploadLengthNL, sizeof(uploadLengthNL));
+  appendUInt64(s, uploadLength);
   // bitfieldLength: 32 bits
-  uint32_t bitfieldLengthNL = htonl(pieceStorage_->getBitfieldLength());
-  WRITE_CHECK(fp, &bitfieldLengthNL, sizeof(bitfieldLengthNL));
+  appendUInt32(s, pieceStorage_->getBitfieldLength());
   // bitfield
-  WRITE_CHECK(fp, pieceStorage_->getBitfield(),
-              pieceStorage_->getBitfieldLength());
-  // the number of in-flight piece: 32 bits
-  // TODO implement this
-  uint32_t numInFlightPieceNL = htonl(pieceStorage_->countInFlightPiece());
-  WRITE_CHECK(fp, &numInFlightPieceNL, sizeof(numInFlightPieceNL));
-  std::vector<std::shared_ptr<Piece>> inFlightPieces;
-  inFlightPieces.reserve(pieceStorage_->countInFlightPiece());
-  pieceStorage_->getInFlightPieces(inFlightPieces);
-  for (std::vector<std::shared_ptr<Piece>>::const_iterator
-           itr = inFlightPieces.begin(),
-           eoi = inFlightPieces.end();
-       itr != eoi; ++itr) {
-    uint32_t indexNL = htonl((*itr)->getIndex());
-    WRITE_CHECK(fp, &indexNL, sizeof(indexNL));
-    uint32_t lengthNL = htonl((*itr)->getLength());
-    WRITE_CHECK(fp, &lengthNL, sizeof(lengthNL));
-    uint32_t bitfieldLengthNL = htonl((*itr)->getBitfieldLength());
-    WRITE_CHECK(fp, &bitfieldLengthNL, sizeof(bitfieldLengthNL));
-    WRITE_CHECK(fp, (*itr)->getBitfield(), (*itr)->getBitfieldLength());
-  }
-  if (fp.close() == EOF) {
-    throw DL_ABORT_EX(fmt(EX_SEGMENT_FILE_WRITE, filename_.c_str()));
-  }
-}
-
-void DefaultBtProgressInfoFile::save()
-{
-  SHA1IOFile sha1io;
-
-  save(sha1io);
-
-  auto digest = sha1io.digest();
-  if (digest == lastDigest_) {
-    // We don't write control file if the content is not changed.
-    return;
-  }
-
-  lastDigest_ = std::move(digest);
+  s.append(reinterpret_cast<const char*>(bitfield),
+           pieceStorage_->getBitfieldLength());
+  s += inFlightPieces;
 
   A2_LOG_INFO(fmt(MSG_SAVING_SEGMENT_FILE, filename_.c_str()));
+  resetSavedState();
   std::string filenameTemp = filename_;
   filenameTemp += "__temp";
   {
     BufferedFile fp(filenameTemp.c_str(), BufferedFile::WRITE);
-    if (!fp) {
+    if (!fp || fp.write(s.data(), s.size()) != s.size() ||
+        fp.close() == EOF) {
       throw DL_ABORT_EX(fmt(EX_SEGMENT_FILE_WRITE, filename_.c_str()));
     }
-
-    save(fp);
   }
 
   A2_LOG_INFO(MSG_SAVED_SEGMENT_FILE);
@@ -219,6 +288,116 @@ void DefaultBtProgressInfoFile::save()
   if (!File(filenameTemp).renameTo(filename_)) {
     throw DL_ABORT_EX(fmt(EX_SEGMENT_FILE_WRITE, filename_.c_str()));
   }
+  savedBitfield_.assign(bitfield,
+                        bitfield + pieceStorage_->getBitfieldLength());
+  savedInFlightPieces_ = std::move(inFlightPieces);
+  savedUploadLength_ = uploadLength;
+  fileLength_ = snapshotLength_ = s.size();
+}
+
+bool DefaultBtProgressInfoFile::appendDelta(const unsigned char* bitfield,
+                                            uint64_t uploadLength,
+                                            std::string inFlightPieces)
+{
+  if (fileLength_ == 0 ||
+      fileLength_ - snapshotLength_ >=
+          std::max(snapshotLength_, MIN_DELTA_LENGTH_TO_COMPACT) ||
+      savedBitfield_.size() != pieceStorage_->getBitfieldLength() ||
+      File(filename_).size() != fileLength_) {
+    return false;
+  }
+  std::string payload;
+  appendUInt64(payload, uploadLength);
+  // The number of completed pieces is written later.
+  appendUInt32(payload, 0);
+  uint32_t numCompletedPieces = 0;
+  for (size_t i = 0; i < savedBitfield_.size(); ++i) {
+    if (savedBitfield_[i] == bitfield[i]) {
+      continue;
+    }
+    if (savedBitfield_[i] & ~bitfield[i]) {
+      // A piece was lost, which only a snapshot can tell.
+      return false;
+    }
+    unsigned char completed = bitfield[i] & ~savedBitfield_[i];
+    for (size_t j = 0; j < 8; ++j) {
+      if (completed & (0x80u >> j)) {
+        appendUInt32(payload, i * 8 + j);
+        ++numCompletedPieces;
+      }
+    }
+  }
+  uint32_t numCompletedPiecesNL = htonl(numCompletedPieces);
+  memcpy(&payload[8], &numCompletedPiecesNL, sizeof(numCompletedPiecesNL));
+  payload += inFlightPieces;
+
+  std::string record;
+  appendUInt32(record, payload.size());
+  record += recordChecksum(payload);
+  record += payload;
+
+  A2_LOG_DEBUG(fmt("Appending %lu completed pieces to %s",
+                   static_cast<unsigned long>(numCompletedPieces),
+                   filename_.c_str()));
+  // If the write fails, the next save() writes a snapshot.
+  auto fileLength = fileLength_;
+  fileLength_ = 0;
+  BufferedFile fp(filename_.c_str(), BufferedFile::APPEND);
+  if (!fp || fp.write(record.data(), record.size()) != record.size() ||
+      fp.close() == EOF) {
+    throw DL_ABORT_EX(fmt(EX_SEGMENT_FILE_WRITE, filename_.c_str()));
+  }
+  savedBitfield_.assign(bitfield, bitfield + savedBitfield_.size());
+  savedInFlightPieces_ = std::move(inFlightPieces);
+  savedUploadLength_ = uploadLength;
+  fileLength_ = fileLength + record.size();
+  return true;
+}
+
+void DefaultBtProgressInfoFile::saveProgress(const unsigned char* bitfield,
+                                             uint64_t uploadLength,
+                                             std::string inFlightPieces)
+{
+  if (!changed(bitfield, uploadLength, inFlightPieces)) {
+    // We don't write control file if the content is not changed.
+    return;
+  }
+  if (!appendDelta(bitfield, uploadLength, inFlightPieces)) {
+    saveSnapshot(bitfield, uploadLength, std::move(inFlightPieces));
+  }
+}
+
+void DefaultBtProgressInfoFile::save()
+{
+  // The current progress is newer than the checkpoint.
+  hasCheckpoint_ = false;
+  saveProgress(pieceStorage_->getBitfield(), getUploadLength(),
+               serializeInFlightPieces(false));
+}
+
+void DefaultBtProgressInfoFile::checkpoint()
+{
+  // The completed pieces are never in the write cache, since it is
+  // flushed before a piece is marked completed.
+  checkpointBitfield_.assign(pieceStorage_->getBitfield(),
+                             pieceStorage_->getBitfield() +
+                                 pieceStorage_->getBitfieldLength());
+  checkpointInFlightPieces_ = serializeInFlightPieces(true);
+  checkpointUploadLength_ = getUploadLength();
+  hasCheckpoint_ = true;
+}
+
+void DefaultBtProgressInfoFile::saveCheckpoint()
+{
+  if (!hasCheckpoint_) {
+    return;
+  }
+  hasCheckpoint_ = false;
+  if (checkpointBitfield_.size() != pieceStorage_->getBitfieldLength()) {
+    return;
+  }
+  saveProgress(checkpointBitfield_.data(), checkpointUploadLength_,
+               std::move(checkpointInFlightPieces_));
 }
 
 #define READ_CHECK(fp, ptr, count)                                             \
@@ -226,12 +405,87 @@ void DefaultBtProgressInfoFile::save()
     throw DL_ABORT_EX(fmt(EX_SEGMENT_FILE_READ, filename_.c_str()));           \
   }
 
+namespace {
+// Reads bytes from a buffer just like IOFile::read().
+class BufferReader {
+public:
+  BufferReader(const unsigned char* data, size_t len)
+      : p_(data), last_(data + len)
+  {
+  }
+
+  size_t read(void* ptr, size_t count)
+  {
+    count = std::min(count, static_cast<size_t>(last_ - p_));
+    memcpy(ptr, p_, count);
+    p_ += count;
+    return count;
+  }
+
+private:
+  const unsigned char* p_;
+  const unsigned char* last_;
+};
+} // namespace
+
+template <typename InputFile>
+void DefaultBtProgressInfoFile::readInFlightPieces(
+    std::vector<std::shared_ptr<Piece>>& pieces, InputFile& fp, int version,
+    uint32_t pieceLength, uint64_t totalLength)
+{
+  uint64_t numPieces = (totalLength + pieceLength - 1) / pieceLength;
+  uint32_t numInFlightPiece;
+  READ_CHECK(fp, &numInFlightPiece, sizeof(numInFlightPiece));
+  if (version >= 1) {
+    numInFlightPiece = ntohl(numInFlightPiece);
+  }
+  pieces.clear();
+  while (numInFlightPiece--) {
+    uint32_t index;
+    READ_CHECK(fp, &index, sizeof(index));
+    if (version >= 1) {
+      index = ntohl(index);
+    }
+    if (!(index < numPieces)) {
+      throw DL_ABORT_EX(fmt("piece index out of range: %u", index));
+    }
+    uint32_t length;
+    READ_CHECK(fp, &length, sizeof(length));
+    if (version >= 1) {
+      length = ntohl(length);
+    }
+    if (!(length <= pieceLength)) {
+      throw DL_ABORT_EX(fmt("piece length out of range: %u", length));
+    }
+    auto piece = std::make_shared<Piece>(index, length);
+    uint32_t bitfieldLength;
+    READ_CHECK(fp, &bitfieldLength, sizeof(bitfieldLength));
+    if (version >= 1) {
+      bitfieldLength = ntohl(bitfieldLength);
+    }
+    if (piece->getBitfieldLength() != bitfieldLength) {
+      throw DL_ABORT_EX(
+          fmt("piece bitfield length mismatch."
+              " expected: %lu actual: %u",
+              static_cast<unsigned long>(piece->getBitfieldLength()),
+              bitfieldLength));
+    }
+    auto pieceBitfield = make_unique<unsigned char[]>((size_t)bitfieldLength);
+    READ_CHECK(fp, pieceBitfield.get(), bitfieldLength);
+    piece->setBitfield(pieceBitfield.get(), bitfieldLength);
+    piece->setHashType(dctx_->getPieceHashType());
+
+    pieces.push_back(piece);
+  }
+}
+
 // It is assumed that integers are saved as:
 // 1) host byte order if version == 0000
-// 2) network byte order if version == 0001
+// 2) network byte order if version == 0001 or 0002
 void DefaultBtProgressInfoFile::load()
 {
   A2_LOG_INFO(fmt(MSG_LOADING_SEGMENT_FILE, filename_.c_str()));
+  auto fileLength = File(filename_).size();
   BufferedFile fp(filename_.c_str(), BufferedFile::READ);
   if (!fp) {
     throw DL_ABORT_EX(fmt(EX_SEGMENT_FILE_READ, filename_.c_str()));
@@ -246,6 +500,9 @@ void DefaultBtProgressInfoFile::load()
   else if ("0001" == versionHex) {
     version = 1;
   }
+  else if ("0002" == versionHex) {
+    version = 2;
+  }
   else {
     throw DL_ABORT_EX(
         fmt("Unsupported ctrl file version: %s", versionHex.c_str()));
@@ -288,6 +545,9 @@ void DefaultBtProgressInfoFile::load()
   if (version >= 1) {
     pieceLength = ntohl(pieceLength);
   }
+  if (pieceLength == 0) {
+    throw DL_ABORT_EX("piece length is 0");
+  }
 
   uint64_t totalLength;
   READ_CHECK(fp, &totalLength, sizeof(totalLength));
@@ -304,11 +564,6 @@ void DefaultBtProgressInfoFile::load()
   if (version >= 1) {
     uploadLength = ntoh64(uploadLength);
   }
-#ifdef ENABLE_BITTORRENT
-  if (isTorrentDownload()) {
-    btRuntime_->setUploadLengthAtStartup(uploadLength);
-  }
-#endif // ENABLE_BITTORRENT
   // TODO implement the conversion mechanism between different piece length.
   uint32_t bitfieldLength;
   READ_CHECK(fp, &bitfieldLength, sizeof(bitfieldLength));
@@ -324,64 +579,72 @@ void DefaultBtProgressInfoFile::load()
 
   auto savedBitfield = make_unique<unsigned char[]>((size_t)bitfieldLength);
   READ_CHECK(fp, savedBitfield.get(), bitfieldLength);
-  if (pieceLength == static_cast<uint32_t>(dctx_->getPieceLength())) {
-    pieceStorage_->setBitfield(savedBitfield.get(), bitfieldLength);
 
-    uint32_t numInFlightPiece;
-    READ_CHECK(fp, &numInFlightPiece, sizeof(numInFlightPiece));
-    if (version >= 1) {
-      numInFlightPiece = ntohl(numInFlightPiece);
-    }
-    std::vector<std::shared_ptr<Piece>> inFlightPieces;
-    inFlightPieces.reserve(numInFlightPiece);
-    while (numInFlightPiece--) {
-      uint32_t index;
-      READ_CHECK(fp, &index, sizeof(index));
-      if (version >= 1) {
-        index = ntohl(index);
-      }
-      if (!(index < dctx_->getNumPieces())) {
-        throw DL_ABORT_EX(fmt("piece index out of range: %u", index));
-      }
-      uint32_t length;
-      READ_CHECK(fp, &length, sizeof(length));
-      if (version >= 1) {
-        length = ntohl(length);
+  std::vector<std::shared_ptr<Piece>> inFlightPieces;
+  readInFlightPieces(inFlightPieces, fp, version, pieceLength, totalLength);
+
+  if (version >= 2) {
+    // Apply the delta records in order.  The last one may be broken if
+    // aria2 was killed while writing it.
+    uint64_t numPieces = (totalLength + pieceLength - 1) / pieceLength;
+    std::string payload;
+    for (;;) {
+      unsigned char header[8];
+      auto r = fp.read(header, sizeof(header));
+      if (r == 0) {
+        break;
       }
-      if (!(length <= static_cast<uint32_t>(dctx_->getPieceLength()))) {
-        throw DL_ABORT_EX(fmt("piece length out of range: %u", length));
+      uint32_t payloadLength;
+      memcpy(&payloadLength, header, sizeof(payloadLength));
+      payloadLength = ntohl(payloadLength);
+      if (r != sizeof(header) || payloadLength > fileLength) {
+        A2_LOG_INFO(fmt("Ignored broken delta record in %s",
+                        filename_.c_str()));
+        break;
       }
-      auto piece = std::make_shared<Piece>(index, length);
-      uint32_t bitfieldLength;
-      READ_CHECK(fp, &bitfieldLength, sizeof(bitfieldLength));
-      if (version >= 1) {
-        bitfieldLength = ntohl(bitfieldLength);
+      payload.resize(payloadLength);
+      if (fp.read(&payload[0], payload.size()) != payload.size() ||
+          recordChecksum(payload) != std::string(&header[4], &header[8])) {
+        A2_LOG_INFO(fmt("Ignored broken delta record in %s",
+                        filename_.c_str()));
+        break;
       }
-      if (piece->getBitfieldLength() != bitfieldLength) {
-        throw DL_ABORT_EX(
-            fmt("piece bitfield length mismatch."
-                " expected: %lu actual: %u",
-                static_cast<unsigned long>(piece->getBitfieldLength()),
-                bitfieldLength));
+      BufferReader record(
+          reinterpret_cast<const unsigned char*>(payload.data()),
+          payload.size());
+      READ_CHECK(record, &uploadLength, sizeof(uploadLength));
+      uploadLength = ntoh64(uploadLength);
+      uint32_t numCompletedPieces;
+      READ_CHECK(record, &numCompletedPieces, sizeof(numCompletedPieces));
+      numCompletedPieces = ntohl(numCompletedPieces);
+      while (numCompletedPieces--) {
+        uint32_t index;
+        READ_CHECK(record, &index, sizeof(index));
+        index = ntohl(index);
+        if (!(index < numPieces)) {
+          throw DL_ABORT_EX(fmt("piece index out of range: %u", index));
+        }
+        savedBitfield[index / 8] |= 0x80u >> (index % 8);
       }
-      auto pieceBitfield = make_unique<unsigned char[]>((size_t)bitfieldLength);
-      READ_CHECK(fp, pieceBitfield.get(), bitfieldLength);
-      piece->setBitfield(pieceBitfield.get(), bitfieldLength);
-      piece->setHashType(dctx_->getPieceHashType());
-
-      inFlightPieces.push_back(piece);
+      readInFlightPieces(inFlightPieces, record, version, pieceLength,
+                         totalLength);
     }
+  }
+
+#ifdef ENABLE_BITTORRENT
+  if (isTorrentDownload()) {
+    btRuntime_->setUploadLengthAtStartup(uploadLength);
+  }
+#endif // ENABLE_BITTORRENT
+
+  if (pieceLength == static_cast<uint32_t>(dctx_->getPieceLength())) {
+    pieceStorage_->setBitfield(savedBitfield.get(), bitfieldLength);
     pieceStorage_->addInFlightPiece(inFlightPieces);
   }
   else {
-    uint32_t numInFlightPiece;
-    READ_CHECK(fp, &numInFlightPiece, sizeof(numInFlightPiece));
-    if (version >= 1) {
-      numInFlightPiece = ntohl(numInFlightPiece);
-    }
     BitfieldMan src(pieceLength, totalLength);
     src.setBitfield(savedBitfield.get(), bitfieldLength);
-    if ((src.getCompletedLength() || numInFlightPiece) &&
+    if ((src.getCompletedLength() || !inFlightPieces.empty()) &&
         !option_->getAsBool(PREF_ALLOW_PIECE_LENGTH_CHANGE)) {
       throw DOWNLOAD_FAILURE_EXCEPTION2(
           "WARNING: Detected a change in piece length. You can proceed with"
@@ -402,6 +665,7 @@ void DefaultBtProgressInfoFile::removeFile()
     File f(filename_);
     f.remove();
   }
+  resetSavedState();
 }
 
 bool DefaultBtProgressInfoFile::exists()
@@ -38,6 +38,7 @@
 #include "BtProgressInfoFile.h"
 
 #include <memory>
+#include <vector>
 
 namespace aria2 {
 
@@ -47,6 +48,7 @@ class PeerStorage;
 class BtRuntime;
 class Option;
 class IOFile;
+class Piece;
 
 class DefaultBtProgressInfoFile : public BtProgressInfoFile {
 private:
@@ -58,13 +60,50 @@ private:
 #endif // ENABLE_BITTORRENT
   const Option* option_;
   std::string filename_;
-  // Last SHA1 digest value of the content written.  Initially, this
-  // is empty string.  This is used to avoid to write same content
-  // repeatedly, which could wake up disk that may be sleeping.
-  std::string lastDigest_;
+  // The progress written to the control file so far.  save() appends
+  // the difference from them as a delta record.  They are also used
+  // to avoid to write same content repeatedly, which could wake up
+  // disk that may be sleeping.
+  std::vector<unsigned char> savedBitfield_;
+  std::string savedInFlightPieces_;
+  uint64_t savedUploadLength_;
+  // The length of the control file and of the snapshot at its
+  // beginning.  fileLength_ is 0 if the control file has not been
+  // written by this object, and the next save() writes a snapshot.
+  int64_t fileLength_;
+  int64_t snapshotLength_;
+  // The progress captured by checkpoint().  hasCheckpoint_ is false
+  // if it has been saved or superseded by save().
+  std::vector<unsigned char> checkpointBitfield_;
+  std::string checkpointInFlightPieces_;
+  uint64_t checkpointUploadLength_;
+  bool hasCheckpoint_;
 
   bool isTorrentDownload();
-  void save(IOFile& fp);
+  uint64_t getUploadLength();
+  // Returns NUM IN-FLIGHT PIECE and the in-flight pieces in the
+  // control file format.  If |writtenOnly| is true, the blocks in the
+  // write cache are left out.
+  std::string serializeInFlightPieces(bool writtenOnly);
+  bool changed(const unsigned char* bitfield, uint64_t uploadLength,
+               const std::string& inFlightPieces);
+  // Saves the progress given by |bitfield|, which is as long as the
+  // bitfield of pieceStorage_, |uploadLength| and |inFlightPieces|.
+  void saveProgress(const unsigned char* bitfield, uint64_t uploadLength,
+                    std::string inFlightPieces);
+  // Rewrites the control file with a snapshot of the progress.
+  void saveSnapshot(const unsigned char* bitfield, uint64_t uploadLength,
+                    std::string inFlightPieces);
+  // Appends a delta record to the control file.  Returns false if the
+  // progress cannot be expressed as a delta.
+  bool appendDelta(const unsigned char* bitfield, uint64_t uploadLength,
+                   std::string inFlightPieces);
+  void resetSavedState();
+
+  template <typename InputFile>
+  void readInFlightPieces(std::vector<std::shared_ptr<Piece>>& pieces,
+                          InputFile& fp, int version, uint32_t pieceLength,
+                          uint64_t totalLength);
 
 public:
   DefaultBtProgressInfoFile(const std::shared_ptr<DownloadContext>& btContext,
@@ -77,8 +116,18 @@ public:
 
   virtual bool exists() CXX11_OVERRIDE;
 
+  // Saves the progress.  The first call writes a snapshot.  The
+  // following calls append the newly completed pieces and the
+  // in-flight pieces as a delta record, and rewrite a snapshot when
+  // the delta records get longer than the snapshot.
   virtual void save() CXX11_OVERRIDE;
 
+  virtual bool needsSave() CXX11_OVERRIDE;
+
+  virtual void checkpoint() CXX11_OVERRIDE;
+
+  virtual void saveCheckpoint() CXX11_OVERRIDE;
+
   virtual void load() CXX11_OVERRIDE;
 
   virtual void removeFile() CXX11_OVERRIDE;
@@ -92,7 +92,8 @@ DefaultPieceStorage::DefaultPieceStorage(
       pieceStatMan_(std::make_shared<PieceStatMan>(
           downloadContext->getNumPieces(), true)),
       pieceSelector_(make_unique<RarestPieceSelector>(pieceStatMan_)),
-      wrDiskCache_(nullptr)
+      wrDiskCache_(nullptr),
+      pieceReadCache_(nullptr)
 {
   const std::string& pieceSelectorOpt =
       option_->get(PREF_STREAM_PIECE_SELECTOR);
@@ -95,6 +95,7 @@ private:
   std::unique_ptr<StreamPieceSelector> streamPieceSelector_;
 
   WrDiskCache* wrDiskCache_;
+  PieceReadCache* pieceReadCache_;
 #ifdef ENABLE_BITTORRENT
   void getMissingPiece(std::vector<std::shared_ptr<Piece>>& pieces,
                        size_t minMissingBlocks, const unsigned char* bitfield,
@@ -236,6 +237,11 @@ public:
 
   virtual void flushWrDiskCacheEntry(bool releaseEntries) CXX11_OVERRIDE;
 
+  virtual PieceReadCache* getPieceReadCache() CXX11_OVERRIDE
+  {
+    return pieceReadCache_;
+  }
+
   virtual int32_t getPieceLength(size_t index) CXX11_OVERRIDE;
 
   virtual void advertisePiece(cuid_t cuid, size_t index,
@@ -300,6 +306,11 @@ public:
   std::unique_ptr<PieceSelector> popPieceSelector();
 
   void setWrDiskCache(WrDiskCache* wrDiskCache) { wrDiskCache_ = wrDiskCache; }
+
+  void setPieceReadCache(PieceReadCache* pieceReadCache)
+  {
+    pieceReadCache_ = pieceReadCache;
+  }
 };
 
 } // namespace aria2
@@ -35,6 +35,9 @@
 #include "DiskAdaptor.h"
 #include "FileEntry.h"
 #include "OpenedFileCounter.h"
+#include "WrDiskCacheEntry.h"
+#include "LogFactory.h"
+#include "fmt.h"
 
 namespace aria2 {
 
@@ -42,4 +45,37 @@ DiskAdaptor::DiskAdaptor() : fileAllocationMethod_(FILE_ALLOC_ADAPTIVE) {}
 
 DiskAdaptor::~DiskAdaptor() = default;
 
+void DiskAdaptor::writeCache(const WrDiskCacheEntry* entry)
+{
+  std::vector<a2iovec> iov;
+  int64_t goff = 0;
+  size_t len = 0;
+  auto flush = [&]() {
+    A2_LOG_DEBUG(fmt("Cache flush goff=%" PRId64 ", len=%lu, iovcnt=%lu", goff,
+                     static_cast<unsigned long>(len),
+                     static_cast<unsigned long>(iov.size())));
+    writeDataVector(iov.data(), iov.size(), goff);
+    iov.clear();
+  };
+  for (auto& d : entry->getDataSet()) {
+    if (!iov.empty() &&
+        (static_cast<int64_t>(goff + len) != d->goff ||
+         iov.size() == static_cast<size_t>(A2_IOV_MAX))) {
+      flush();
+    }
+    if (iov.empty()) {
+      goff = d->goff;
+      len = 0;
+    }
+    a2iovec v;
+    v.A2IOVEC_BASE = reinterpret_cast<char*>(d->data + d->offset);
+    v.A2IOVEC_LEN = d->len;
+    iov.push_back(v);
+    len += d->len;
+  }
+  if (!iov.empty()) {
+    flush();
+  }
+}
+
 } // namespace aria2
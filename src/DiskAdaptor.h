@@ -96,6 +96,10 @@ public:
   // have been opened before this method call.
   virtual void enableMmap() {}
 
+  // Enables direct I/O for writes. Some derived classes may require
+  // that files have been opened before this method call.
+  virtual void enableDirectIO() {}
+
   // Assumed each file length is stored in fileEntries or DiskAdaptor knows it.
   // If each actual file's length is larger than that, truncate file to that
   // length.
@@ -111,12 +115,28 @@ public:
   virtual ssize_t readDataDropCache(unsigned char* data, size_t len,
                                     int64_t offset) = 0;
 
-  // Writes cached data to the underlying disk.
-  virtual void writeCache(const WrDiskCacheEntry* entry) = 0;
+  // Writes cached data to the underlying disk.  Adjacent data cells
+  // are written together by writeDataVector().
+  virtual void writeCache(const WrDiskCacheEntry* entry);
 
   // Force physical write of data from OS buffer cache.
   virtual void flushOSBuffers(){};
 
+  // Starts writing back the data written since the last call.  See
+  // DiskWriter::startWriteback().
+  virtual void startWriteback() {}
+
+  // Waits until the data passed to startWriteback() are written to
+  // the disk, synchronizing at most |maxFiles| files.  Returns true if
+  // all of them have been written, or false if the rest must be
+  // waited for by another call.  See DiskWriter::waitWriteback().
+  virtual bool waitWriteback(size_t maxFiles) { return true; }
+
+  // Returns the offset of the first byte at or after |offset| which
+  // may hold data.  See DiskWriter::seekData().  The default
+  // implementation returns |offset|.
+  virtual int64_t seekData(int64_t offset) { return offset; }
+
   void setFileAllocationMethod(FileAllocationMethod method)
   {
     fileAllocationMethod_ = method;
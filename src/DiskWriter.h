@@ -83,11 +83,32 @@ public:
   // Enables mmap.
   virtual void enableMmap() {}
 
+  // Enables direct I/O, which writes data bypassing the OS buffer
+  // cache where possible.  The default implementation does nothing.
+  virtual void enableDirectIO() {}
+
   // Drops cache in range [offset, offset + len)
   virtual void dropCache(int64_t len, int64_t offset) {}
 
   // Force physical write of data from OS buffer cache.
   virtual void flushOSBuffers() {}
+
+  // Starts writing back the data written since the last call to the
+  // disk, and returns without waiting for it.
+  virtual void startWriteback() {}
+
+  // Waits until the data passed to startWriteback() are written to
+  // the disk.  Returns true if the file was synchronized, or false if
+  // there was nothing to wait for.  Throws DlAbortEx if they cannot
+  // be written.
+  virtual bool waitWriteback() { return false; }
+
+  // Returns the offset of the first byte at or after |offset| which
+  // may hold data.  The bytes in between are a hole, which is read as
+  // zeros.  The end of file is never inside a hole, so that reading
+  // beyond it still fails.  The default implementation returns
+  // |offset|.
+  virtual int64_t seekData(int64_t offset) { return offset; }
 };
 
 } // namespace aria2
@@ -157,8 +157,8 @@ bool DownloadCommand::executeInternal()
     // read data from socket here, we will get EOF and leaves 2nd
     // response unprocessed.  To prevent this, we don't read from
     // socket when buffer is not empty.
-    eof = getSocketRecvBuffer()->recv() == 0 && !getSocket()->wantRead() &&
-          !getSocket()->wantWrite();
+    eof = getSocketRecvBuffer()->recv() == 0 &&
+          getSocketRecvBuffer()->eof();
   }
   if (!eof) {
     size_t bufSize;
@@ -242,7 +242,7 @@ bool DownloadCommand::executeInternal()
       A2_LOG_INFO(fmt(MSG_SEGMENT_DOWNLOAD_COMPLETED, getCuid()));
 
       {
-        const std::string& expectedPieceHash =
+        auto expectedPieceHash =
             getDownloadContext()->getPieceHash(segment->getIndex());
         if (pieceHashValidationEnabled_ && !expectedPieceHash.empty()) {
           if (
@@ -381,7 +381,7 @@ bool DownloadCommand::prepareForNextSegment()
 }
 
 void DownloadCommand::validatePieceHash(const std::shared_ptr<Segment>& segment,
-                                        const std::string& expectedHash,
+                                        const ByteSpan& expectedHash,
                                         const std::string& actualHash)
 {
   if (actualHash == expectedHash) {
@@ -389,10 +389,12 @@ void DownloadCommand::validatePieceHash(const std::shared_ptr<Segment>& segment,
     completeSegment(getCuid(), segment);
   }
   else {
-    A2_LOG_INFO(fmt(EX_INVALID_CHUNK_CHECKSUM,
-                    static_cast<unsigned long>(segment->getIndex()),
-                    segment->getPosition(), util::toHex(expectedHash).c_str(),
-                    util::toHex(actualHash).c_str()));
+    A2_LOG_INFO(
+        fmt(EX_INVALID_CHUNK_CHECKSUM,
+            static_cast<unsigned long>(segment->getIndex()),
+            segment->getPosition(),
+            util::toHex(expectedHash.data(), expectedHash.size()).c_str(),
+            util::toHex(actualHash).c_str()));
     segment->clear(getPieceStorage()->getWrDiskCache());
     getSegmentMan()->cancelSegment(getCuid());
     throw DL_RETRY_EX(fmt("Invalid checksum index=%lu",
@@ -44,6 +44,7 @@ namespace aria2 {
 class PeerStat;
 class StreamFilter;
 class MessageDigest;
+class ByteSpan;
 
 class DownloadCommand : public AbstractCommand {
 private:
@@ -62,7 +63,7 @@ private:
   bool sinkFilterOnly_;
 
   void validatePieceHash(const std::shared_ptr<Segment>& segment,
-                         const std::string& expectedPieceHash,
+                         const ByteSpan& expectedPieceHash,
                          const std::string& actualPieceHash);
 
   void checkLowestDownloadSpeed() const;
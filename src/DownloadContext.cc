@@ -50,6 +50,7 @@ namespace aria2 {
 DownloadContext::DownloadContext()
     : ownerRequestGroup_(nullptr),
       attrs_(MAX_CTX_ATTR),
+      pieceHashLength_(0),
       downloadStopTime_(Timer::zero()),
       pieceLength_(0),
       checksumVerified_(false),
@@ -66,6 +67,7 @@ DownloadContext::DownloadContext(int32_t pieceLength, int64_t totalLength,
                                  std::string path)
     : ownerRequestGroup_(nullptr),
       attrs_(MAX_CTX_ATTR),
+      pieceHashLength_(0),
       downloadStopTime_(Timer::zero()),
       pieceLength_(pieceLength),
       checksumVerified_(false),
@@ -270,20 +272,31 @@ bool DownloadContext::isChecksumVerificationAvailable() const
 
 bool DownloadContext::isPieceHashVerificationAvailable() const
 {
-  return !pieceHashType_.empty() && pieceHashes_.size() > 0 &&
-         pieceHashes_.size() == getNumPieces();
+  return !pieceHashType_.empty() && countPieceHash() > 0 &&
+         countPieceHash() == getNumPieces();
 }
 
-const std::string& DownloadContext::getPieceHash(size_t index) const
+ByteSpan DownloadContext::getPieceHash(size_t index) const
 {
-  if (index < pieceHashes_.size()) {
-    return pieceHashes_[index];
+  if (index < countPieceHash()) {
+    return ByteSpan(reinterpret_cast<const unsigned char*>(
+                        pieceHashes_.data() + index * pieceHashLength_),
+                    pieceHashLength_);
   }
   else {
-    return A2STR::NIL;
+    return ByteSpan();
   }
 }
 
+void DownloadContext::setPieceHashes(const std::string& hashType,
+                                     std::string hashData, size_t hashLength)
+{
+  assert(hashLength > 0 && hashData.size() % hashLength == 0);
+  pieceHashType_ = hashType;
+  pieceHashes_ = std::move(hashData);
+  pieceHashLength_ = hashLength;
+}
+
 void DownloadContext::setDigest(const std::string& hashType,
                                 const std::string& digest)
 {
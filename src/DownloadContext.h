@@ -48,6 +48,7 @@
 #include "SegList.h"
 #include "ContextAttribute.h"
 #include "NetStat.h"
+#include "ByteSpan.h"
 
 namespace aria2 {
 
@@ -65,7 +66,10 @@ private:
 
   std::vector<std::shared_ptr<FileEntry>> fileEntries_;
 
-  std::vector<std::string> pieceHashes_;
+  // Piece hashes stored back to back, pieceHashLength_ bytes each.
+  std::string pieceHashes_;
+
+  size_t pieceHashLength_;
 
   NetStat netStat_;
 
@@ -99,21 +103,39 @@ public:
 
   ~DownloadContext();
 
-  const std::string& getPieceHash(size_t index) const;
+  // Returns the hash of the piece |index|.  If there is no such piece
+  // hash, returns an empty span.  The span is valid until the piece
+  // hashes are set again.
+  ByteSpan getPieceHash(size_t index) const;
 
-  const std::vector<std::string>& getPieceHashes() const
+  size_t countPieceHash() const
   {
-    return pieceHashes_;
+    return pieceHashLength_ == 0 ? 0 : pieceHashes_.size() / pieceHashLength_;
   }
 
+  // Sets the piece hashes in the range [first, last).  All hashes
+  // must have the same length.  Otherwise, no piece hash is set.
   template <typename InputIterator>
   void setPieceHashes(const std::string& hashType, InputIterator first,
                       InputIterator last)
   {
     pieceHashType_ = hashType;
-    pieceHashes_.assign(first, last);
+    pieceHashes_.clear();
+    pieceHashLength_ = first == last ? 0 : (*first).size();
+    for (; first != last; ++first) {
+      if ((*first).size() != pieceHashLength_) {
+        pieceHashes_.clear();
+        return;
+      }
+      pieceHashes_ += *first;
+    }
   }
 
+  // Sets the piece hashes concatenated in |hashData|, |hashLength|
+  // bytes each.
+  void setPieceHashes(const std::string& hashType, std::string hashData,
+                      size_t hashLength);
+
   int64_t getTotalLength() const;
 
   bool knowsTotalLength() const { return knowsTotalLength_; }
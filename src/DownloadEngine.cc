@@ -41,6 +41,8 @@
 #include <algorithm>
 #include <numeric>
 #include <iterator>
+#include <typeinfo>
+#include <typeindex>
 
 #include "StatCalc.h"
 #include "RequestGroup.h"
@@ -58,6 +60,9 @@
 #include "A2STR.h"
 #include "AuthConfigFactory.h"
 #include "AuthConfig.h"
+#include "EngineProfiler.h"
+#include "SocketPool.h"
+#include "HttpConnection.h"
 #include "Request.h"
 #include "EventPoll.h"
 #include "Command.h"
@@ -73,7 +78,11 @@
 #ifdef ENABLE_WEBSOCKET
 #  include "WebSocketSessionMan.h"
 #endif // ENABLE_WEBSOCKET
+#ifdef HAVE_LIBNGHTTP2
+#  include "Http2Session.h"
+#endif // HAVE_LIBNGHTTP2
 #include "Option.h"
+#include "prefs.h"
 #include "util_security.h"
 
 namespace aria2 {
@@ -97,6 +106,7 @@ constexpr auto DEFAULT_REFRESH_INTERVAL = 1_s;
 DownloadEngine::DownloadEngine(std::unique_ptr<EventPoll> eventPoll)
     : eventPoll_(std::move(eventPoll)),
       haltRequested_(0),
+      socketPool_(make_unique<SocketPool>()),
       noWait_(true),
       refreshInterval_(DEFAULT_REFRESH_INTERVAL),
       lastRefresh_(Timer::zero()),
@@ -123,10 +133,13 @@ DownloadEngine::~DownloadEngine()
 }
 
 namespace {
-void executeCommand(std::deque<std::unique_ptr<Command>>& commands,
-                    Command::STATUS statusFilter)
+// Returns the number of executed commands.  If |profiler| is not
+// null, execution time of each command is recorded to it.
+size_t executeCommand(std::deque<std::unique_ptr<Command>>& commands,
+                      Command::STATUS statusFilter, EngineProfiler* profiler)
 {
   size_t max = commands.size();
+  size_t numExecuted = 0;
   for (size_t i = 0; i < max; ++i) {
     auto com = std::move(commands.front());
     commands.pop_front();
@@ -136,7 +149,18 @@ void executeCommand(std::deque<std::unique_ptr<Command>>& commands,
       continue;
     }
     com->transitStatus();
-    if (com->execute()) {
+    ++numExecuted;
+    bool done;
+    if (profiler) {
+      std::type_index type = typeid(*com);
+      auto start = EngineProfiler::now();
+      done = com->execute();
+      profiler->addCommandExecution(type, EngineProfiler::now() - start);
+    }
+    else {
+      done = com->execute();
+    }
+    if (done) {
       com.reset();
     }
     else {
@@ -144,6 +168,7 @@ void executeCommand(std::deque<std::unique_ptr<Command>>& commands,
       com.release();
     }
   }
+  return numExecuted;
 }
 } // namespace
 
@@ -166,24 +191,42 @@ private:
 int DownloadEngine::run(bool oneshot)
 {
   GlobalHaltRequestedFinalizer ghrf(oneshot);
+  auto profiler = profiler_.get();
   while (!commands_.empty() || !routineCommands_.empty()) {
     if (!commands_.empty()) {
-      waitData();
+      if (profiler) {
+        auto start = EngineProfiler::now();
+        waitData();
+        profiler->addPollWait(EngineProfiler::now() - start);
+      }
+      else {
+        waitData();
+      }
+    }
+    EngineProfiler::Clock::time_point iterationStart;
+    if (profiler) {
+      iterationStart = EngineProfiler::now();
     }
     noWait_ = false;
     global::wallclock().reset();
     calculateStatistics();
+    size_t numExecuted;
     if (lastRefresh_.difference(global::wallclock()) + A2_DELTA_MILLIS >=
         refreshInterval_) {
       refreshInterval_ = DEFAULT_REFRESH_INTERVAL;
       lastRefresh_ = global::wallclock();
-      executeCommand(commands_, Command::STATUS_ALL);
+      numExecuted = executeCommand(commands_, Command::STATUS_ALL, profiler);
     }
     else {
-      executeCommand(commands_, Command::STATUS_ACTIVE);
+      numExecuted = executeCommand(commands_, Command::STATUS_ACTIVE, profiler);
     }
-    executeCommand(routineCommands_, Command::STATUS_ALL);
+    numExecuted +=
+        executeCommand(routineCommands_, Command::STATUS_ALL, profiler);
     afterEachIteration();
+    if (profiler) {
+      profiler->addIteration(EngineProfiler::now() - iterationStart,
+                             numExecuted);
+    }
     if (!noWait_ && oneshot) {
       return 1;
     }
@@ -235,6 +278,16 @@ bool DownloadEngine::deleteSocketForWriteCheck(
                                   EventPoll::EVENT_WRITE);
 }
 
+bool DownloadEngine::addFdForReadCheck(sock_t fd, Command* command)
+{
+  return eventPoll_->addEvents(fd, command, EventPoll::EVENT_READ);
+}
+
+bool DownloadEngine::deleteFdForReadCheck(sock_t fd, Command* command)
+{
+  return eventPoll_->deleteEvents(fd, command, EventPoll::EVENT_READ);
+}
+
 void DownloadEngine::calculateStatistics()
 {
   if (statCalc_) {
@@ -244,6 +297,11 @@ void DownloadEngine::calculateStatistics()
 
 void DownloadEngine::onEndOfRun()
 {
+  if (profiler_) {
+    profiler_->log();
+  }
+  socketPool_->log();
+  dnsCache_->log();
   requestGroupMan_->removeStoppedGroup(this);
   requestGroupMan_->closeFile();
   requestGroupMan_->save();
@@ -269,6 +327,13 @@ void DownloadEngine::afterEachIteration()
     setRefreshInterval(std::chrono::milliseconds(0));
     return;
   }
+
+  // Let the commands waiting for a connection to a host proceed if a
+  // connection to the host was pooled or closed in this iteration.
+  if (socketPool_->hasWaiter() &&
+      socketPool_->wakeUp(option_->getAsInt(PREF_MAX_HOST_CONNECTIONS))) {
+    setNoWait(true);
+  }
 }
 
 void DownloadEngine::requestHalt()
@@ -309,33 +374,85 @@ void DownloadEngine::addRoutineCommand(std::unique_ptr<Command> command)
   routineCommands_.push_back(std::move(command));
 }
 
-void DownloadEngine::poolSocket(const std::string& key,
-                                const SocketPoolEntry& entry)
+void DownloadEngine::addPipelinedHttpConnection(
+    const std::string& host, uint16_t port,
+    const std::shared_ptr<HttpConnection>& httpConnection)
 {
-  A2_LOG_INFO(fmt("Pool socket for %s", key.c_str()));
-  std::multimap<std::string, SocketPoolEntry>::value_type p(key, entry);
-  socketPool_.insert(p);
+  pipelinedHttpConnections_[fmt("%s:%u", host.c_str(), port)] = httpConnection;
 }
 
-void DownloadEngine::evictSocketPool()
+std::shared_ptr<HttpConnection>
+DownloadEngine::getPipelinedHttpConnection(const std::string& host,
+                                           uint16_t port, size_t maxRequests)
 {
-  if (socketPool_.empty()) {
-    return;
+  auto i = pipelinedHttpConnections_.find(fmt("%s:%u", host.c_str(), port));
+  if (i == std::end(pipelinedHttpConnections_)) {
+    return nullptr;
   }
+  // The entry for an expired connection is kept, so that the next
+  // connection to the server can be registered in its place.
+  auto httpConnection = (*i).second.lock();
+  if (!httpConnection || !httpConnection->canPipeline(maxRequests)) {
+    return nullptr;
+  }
+  return httpConnection;
+}
+
+void DownloadEngine::renewPipelinedHttpConnection(
+    const std::string& host, uint16_t port,
+    const std::shared_ptr<HttpConnection>& httpConnection)
+{
+  auto i = pipelinedHttpConnections_.find(fmt("%s:%u", host.c_str(), port));
+  if (i != std::end(pipelinedHttpConnections_)) {
+    (*i).second = httpConnection;
+  }
+}
 
-  std::multimap<std::string, SocketPoolEntry> newPool;
-  A2_LOG_DEBUG("Scanning SocketPool and erasing timed out entry.");
-  for (auto& elem : socketPool_) {
-    if (!elem.second.isTimeout()) {
-      newPool.insert(elem);
+void DownloadEngine::removePipelinedHttpConnection(
+    const std::shared_ptr<HttpConnection>& httpConnection)
+{
+  for (auto i = std::begin(pipelinedHttpConnections_);
+       i != std::end(pipelinedHttpConnections_); ++i) {
+    if ((*i).second.lock() == httpConnection) {
+      pipelinedHttpConnections_.erase(i);
+      return;
     }
   }
-  A2_LOG_DEBUG(
-      fmt("%lu entries removed.",
-          static_cast<unsigned long>(socketPool_.size() - newPool.size())));
-  socketPool_ = std::move(newPool);
 }
 
+#ifdef HAVE_LIBNGHTTP2
+void DownloadEngine::addHttp2Session(
+    const std::string& host, uint16_t port,
+    const std::shared_ptr<Http2Session>& session)
+{
+  http2Sessions_[fmt("%s:%u", host.c_str(), port)] = session;
+}
+
+std::shared_ptr<Http2Session>
+DownloadEngine::getHttp2Session(const std::string& host, uint16_t port)
+{
+  auto i = http2Sessions_.find(fmt("%s:%u", host.c_str(), port));
+  if (i == std::end(http2Sessions_) || !(*i).second->canSubmitRequest()) {
+    return nullptr;
+  }
+  return (*i).second;
+}
+
+void DownloadEngine::removeHttp2Session(
+    const std::shared_ptr<Http2Session>& session)
+{
+  for (auto i = std::begin(http2Sessions_); i != std::end(http2Sessions_);
+       ++i) {
+    if ((*i).second == session) {
+      http2Sessions_.erase(i);
+      return;
+    }
+  }
+}
+#endif // HAVE_LIBNGHTTP2
+
+void DownloadEngine::evictSocketPool() { socketPool_->evict(); }
+
 namespace {
 std::string createSockPoolKey(const std::string& host, uint16_t port,
                               const std::string& username,
@@ -362,9 +479,9 @@ void DownloadEngine::poolSocket(const std::string& ipaddr, uint16_t port,
                                 const std::string& options,
                                 std::chrono::seconds timeout)
 {
-  SocketPoolEntry e(sock, options, std::move(timeout));
-  poolSocket(createSockPoolKey(ipaddr, port, username, proxyhost, proxyport),
-             e);
+  socketPool_->add(
+      createSockPoolKey(ipaddr, port, username, proxyhost, proxyport), sock,
+      options, std::move(timeout));
 }
 
 void DownloadEngine::poolSocket(const std::string& ipaddr, uint16_t port,
@@ -373,9 +490,9 @@ void DownloadEngine::poolSocket(const std::string& ipaddr, uint16_t port,
                                 const std::shared_ptr<SocketCore>& sock,
                                 std::chrono::seconds timeout)
 {
-  SocketPoolEntry e(sock, std::move(timeout));
-  poolSocket(createSockPoolKey(ipaddr, port, A2STR::NIL, proxyhost, proxyport),
-             e);
+  socketPool_->add(
+      createSockPoolKey(ipaddr, port, A2STR::NIL, proxyhost, proxyport), sock,
+      A2STR::NIL, std::move(timeout));
 }
 
 namespace {
@@ -435,37 +552,14 @@ void DownloadEngine::poolSocket(const std::shared_ptr<Request>& request,
   }
 }
 
-std::multimap<std::string, DownloadEngine::SocketPoolEntry>::iterator
-DownloadEngine::findSocketPoolEntry(const std::string& key)
-{
-  std::pair<std::multimap<std::string, SocketPoolEntry>::iterator,
-            std::multimap<std::string, SocketPoolEntry>::iterator>
-      range = socketPool_.equal_range(key);
-  for (auto i = range.first, eoi = range.second; i != eoi; ++i) {
-    const SocketPoolEntry& e = (*i).second;
-    // We assume that if socket is readable it means peer shutdowns
-    // connection and the socket will receive EOF. So skip it.
-    if (!e.isTimeout() && !e.getSocket()->isReadable(0)) {
-      A2_LOG_INFO(fmt("Found socket for %s", key.c_str()));
-      return i;
-    }
-  }
-  return socketPool_.end();
-}
-
 std::shared_ptr<SocketCore>
 DownloadEngine::popPooledSocket(const std::string& ipaddr, uint16_t port,
                                 const std::string& proxyhost,
                                 uint16_t proxyport)
 {
-  std::shared_ptr<SocketCore> s;
-  auto i = findSocketPoolEntry(
-      createSockPoolKey(ipaddr, port, A2STR::NIL, proxyhost, proxyport));
-  if (i != socketPool_.end()) {
-    s = (*i).second.getSocket();
-    socketPool_.erase(i);
-  }
-  return s;
+  return socketPool_->pop(
+      nullptr, {createSockPoolKey(ipaddr, port, A2STR::NIL, proxyhost,
+                                  proxyport)});
 }
 
 std::shared_ptr<SocketCore>
@@ -474,29 +568,20 @@ DownloadEngine::popPooledSocket(std::string& options, const std::string& ipaddr,
                                 const std::string& proxyhost,
                                 uint16_t proxyport)
 {
-  std::shared_ptr<SocketCore> s;
-  auto i = findSocketPoolEntry(
-      createSockPoolKey(ipaddr, port, username, proxyhost, proxyport));
-  if (i != socketPool_.end()) {
-    s = (*i).second.getSocket();
-    options = (*i).second.getOptions();
-    socketPool_.erase(i);
-  }
-  return s;
+  return socketPool_->pop(
+      &options,
+      {createSockPoolKey(ipaddr, port, username, proxyhost, proxyport)});
 }
 
 std::shared_ptr<SocketCore>
 DownloadEngine::popPooledSocket(const std::vector<std::string>& ipaddrs,
                                 uint16_t port)
 {
-  std::shared_ptr<SocketCore> s;
+  std::vector<std::string> keys;
   for (const auto& ipaddr : ipaddrs) {
-    s = popPooledSocket(ipaddr, port, A2STR::NIL, 0);
-    if (s) {
-      break;
-    }
+    keys.push_back(createSockPoolKey(ipaddr, port, A2STR::NIL, A2STR::NIL, 0));
   }
-  return s;
+  return socketPool_->pop(nullptr, keys);
 }
 
 std::shared_ptr<SocketCore>
@@ -504,34 +589,11 @@ DownloadEngine::popPooledSocket(std::string& options,
                                 const std::vector<std::string>& ipaddrs,
                                 uint16_t port, const std::string& username)
 {
-  std::shared_ptr<SocketCore> s;
+  std::vector<std::string> keys;
   for (const auto& ipaddr : ipaddrs) {
-    s = popPooledSocket(options, ipaddr, port, username, A2STR::NIL, 0);
-    if (s) {
-      break;
-    }
+    keys.push_back(createSockPoolKey(ipaddr, port, username, A2STR::NIL, 0));
   }
-  return s;
-}
-
-DownloadEngine::SocketPoolEntry::SocketPoolEntry(
-    const std::shared_ptr<SocketCore>& socket, const std::string& options,
-    std::chrono::seconds timeout)
-    : socket_(socket), options_(options), timeout_(std::move(timeout))
-{
-}
-
-DownloadEngine::SocketPoolEntry::SocketPoolEntry(
-    const std::shared_ptr<SocketCore>& socket, std::chrono::seconds timeout)
-    : socket_(socket), timeout_(std::move(timeout))
-{
-}
-
-DownloadEngine::SocketPoolEntry::~SocketPoolEntry() = default;
-
-bool DownloadEngine::SocketPoolEntry::isTimeout() const
-{
-  return registeredTime_.difference(global::wallclock()) >= timeout_;
+  return socketPool_->pop(&options, keys);
 }
 
 cuid_t DownloadEngine::newCUID() { return cuidCounter_.newID(); }
@@ -555,6 +617,13 @@ void DownloadEngine::markBadIPAddress(const std::string& hostname,
   dnsCache_->markBad(hostname, ipaddr, port);
 }
 
+void DownloadEngine::markGoodIPAddress(const std::string& hostname,
+                                       const std::string& ipaddr,
+                                       uint16_t port)
+{
+  dnsCache_->markGood(hostname, ipaddr, port);
+}
+
 void DownloadEngine::removeCachedIPAddress(const std::string& hostname,
                                            uint16_t port)
 {
@@ -567,6 +636,11 @@ void DownloadEngine::setAuthConfigFactory(
   authConfigFactory_ = std::move(factory);
 }
 
+void DownloadEngine::setEngineProfiler(std::unique_ptr<EngineProfiler> profiler)
+{
+  profiler_ = std::move(profiler);
+}
+
 const std::unique_ptr<AuthConfigFactory>&
 DownloadEngine::getAuthConfigFactory() const
 {
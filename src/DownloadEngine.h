@@ -65,6 +65,12 @@ class AuthConfigFactory;
 class Request;
 class EventPoll;
 class Command;
+class EngineProfiler;
+class HttpConnection;
+class SocketPool;
+#ifdef HAVE_LIBNGHTTP2
+class Http2Session;
+#endif // HAVE_LIBNGHTTP2
 #ifdef ENABLE_BITTORRENT
 class BtRegistry;
 #endif // ENABLE_BITTORRENT
@@ -93,34 +99,7 @@ private:
 
   int haltRequested_;
 
-  class SocketPoolEntry {
-  private:
-    std::shared_ptr<SocketCore> socket_;
-    // protocol specific option string
-    std::string options_;
-
-    std::chrono::seconds timeout_;
-
-    Timer registeredTime_;
-
-  public:
-    SocketPoolEntry(const std::shared_ptr<SocketCore>& socket,
-                    const std::string& option, std::chrono::seconds timeout);
-
-    SocketPoolEntry(const std::shared_ptr<SocketCore>& socket,
-                    std::chrono::seconds timeout);
-
-    ~SocketPoolEntry();
-
-    bool isTimeout() const;
-
-    const std::shared_ptr<SocketCore>& getSocket() const { return socket_; }
-
-    const std::string& getOptions() const { return options_; }
-  };
-
-  // key = IP address:port, value = SocketPoolEntry
-  std::multimap<std::string, SocketPoolEntry> socketPool_;
+  std::unique_ptr<SocketPool> socketPool_;
 
   Timer lastSocketPoolScan_;
 
@@ -145,10 +124,23 @@ private:
 
   std::unique_ptr<AuthConfigFactory> authConfigFactory_;
 
+  // Non-null only if engine profiling is enabled.
+  std::unique_ptr<EngineProfiler> profiler_;
+
 #ifdef ENABLE_WEBSOCKET
   std::unique_ptr<rpc::WebSocketSessionMan> webSocketSessionMan_;
 #endif // ENABLE_WEBSOCKET
 
+  // HTTP/1.1 connections on which requests of other downloads can be
+  // pipelined, keyed by "host:port" of the origin server.
+  std::map<std::string, std::weak_ptr<HttpConnection>>
+      pipelinedHttpConnections_;
+
+#ifdef HAVE_LIBNGHTTP2
+  // HTTP/2 sessions keyed by "host:port" of the origin server.
+  std::map<std::string, std::shared_ptr<Http2Session>> http2Sessions_;
+#endif // HAVE_LIBNGHTTP2
+
   /**
    * Delegates to StatCalc
    */
@@ -158,11 +150,6 @@ private:
 
   void afterEachIteration();
 
-  void poolSocket(const std::string& key, const SocketPoolEntry& entry);
-
-  std::multimap<std::string, SocketPoolEntry>::iterator
-  findSocketPoolEntry(const std::string& key);
-
   std::unique_ptr<RequestGroupMan> requestGroupMan_;
   std::unique_ptr<FileAllocationMan> fileAllocationMan_;
   std::unique_ptr<CheckIntegrityMan> checkIntegrityMan_;
@@ -195,6 +182,12 @@ public:
   bool deleteSocketForWriteCheck(const std::shared_ptr<SocketCore>& socket,
                                  Command* command);
 
+  // Like addSocketForReadCheck(), but takes a descriptor which is not
+  // owned by a SocketCore, such as the read end of a pipe.  Pipes can
+  // only be used on POSIX systems.
+  bool addFdForReadCheck(sock_t fd, Command* command);
+  bool deleteFdForReadCheck(sock_t fd, Command* command);
+
 #ifdef ENABLE_ASYNC_DNS
 
   bool addNameResolverCheck(const std::shared_ptr<AsyncNameResolver>& resolver,
@@ -289,6 +282,53 @@ public:
 
   void evictSocketPool();
 
+  const std::unique_ptr<SocketPool>& getSocketPool() const
+  {
+    return socketPool_;
+  }
+
+  // Registers |httpConnection| as the connection to |host|:|port| on
+  // which requests of other downloads can be pipelined, replacing the
+  // one registered before, if any.
+  void addPipelinedHttpConnection(
+      const std::string& host, uint16_t port,
+      const std::shared_ptr<HttpConnection>& httpConnection);
+
+  // Returns the connection to |host|:|port| registered by
+  // addPipelinedHttpConnection() if it has less than |maxRequests|
+  // outstanding requests and can accept one more.  Otherwise returns
+  // nullptr.
+  std::shared_ptr<HttpConnection>
+  getPipelinedHttpConnection(const std::string& host, uint16_t port,
+                             size_t maxRequests);
+
+  // Registers |httpConnection| in place of the connection registered
+  // for |host|:|port| before, even if that one is gone already.  Does
+  // nothing if no connection to |host|:|port| has been registered or
+  // the last one was unregistered.
+  void renewPipelinedHttpConnection(
+      const std::string& host, uint16_t port,
+      const std::shared_ptr<HttpConnection>& httpConnection);
+
+  // Unregisters |httpConnection| if it is registered.
+  void removePipelinedHttpConnection(
+      const std::shared_ptr<HttpConnection>& httpConnection);
+
+#ifdef HAVE_LIBNGHTTP2
+  // Registers |session| as the HTTP/2 session to |host|:|port|,
+  // replacing the one registered before, if any.
+  void addHttp2Session(const std::string& host, uint16_t port,
+                       const std::shared_ptr<Http2Session>& session);
+
+  // Returns the HTTP/2 session to |host|:|port| if it can accept one
+  // more stream.  Otherwise returns nullptr.
+  std::shared_ptr<Http2Session> getHttp2Session(const std::string& host,
+                                                uint16_t port);
+
+  // Unregisters |session| if it is registered.
+  void removeHttp2Session(const std::shared_ptr<Http2Session>& session);
+#endif // HAVE_LIBNGHTTP2
+
   const std::unique_ptr<CookieStorage>& getCookieStorage() const;
 
 #ifdef ENABLE_BITTORRENT
@@ -316,14 +356,26 @@ public:
   void markBadIPAddress(const std::string& hostname, const std::string& ipaddr,
                         uint16_t port);
 
+  void markGoodIPAddress(const std::string& hostname, const std::string& ipaddr,
+                         uint16_t port);
+
   void removeCachedIPAddress(const std::string& hostname, uint16_t port);
 
+  const std::unique_ptr<DNSCache>& getDNSCache() const { return dnsCache_; }
+
   void setAuthConfigFactory(std::unique_ptr<AuthConfigFactory> factory);
 
   const std::unique_ptr<AuthConfigFactory>& getAuthConfigFactory() const;
 
   void setRefreshInterval(std::chrono::milliseconds interval);
 
+  void setEngineProfiler(std::unique_ptr<EngineProfiler> profiler);
+
+  const std::unique_ptr<EngineProfiler>& getEngineProfiler() const
+  {
+    return profiler_;
+  }
+
   const std::string getSessionId() const { return sessionId_; }
 
 #ifdef HAVE_ARES_ADDR_NODE
@@ -49,6 +49,8 @@
 #include "FileAllocationDispatcherCommand.h"
 #include "AutoSaveCommand.h"
 #include "SaveSessionCommand.h"
+#include "EngineProfileCommand.h"
+#include "EngineProfiler.h"
 #include "HaveEraseCommand.h"
 #include "TimedHaltCommand.h"
 #include "WatchProcessCommand.h"
@@ -152,10 +154,15 @@ std::unique_ptr<DownloadEngine> DownloadEngineFactory::newDownloadEngine(
       op->getAsInt(PREF_MAX_CONCURRENT_DOWNLOADS);
   auto e = make_unique<DownloadEngine>(createEventPoll(op));
   e->setOption(op);
+  e->getDNSCache()->setTtl(
+      std::chrono::seconds(op->getAsInt(PREF_DNS_CACHE_TTL)));
+  e->getDNSCache()->setNegativeTtl(
+      std::chrono::seconds(op->getAsInt(PREF_DNS_NEGATIVE_CACHE_TTL)));
   {
     auto requestGroupMan = make_unique<RequestGroupMan>(
         std::move(requestGroups), MAX_CONCURRENT_DOWNLOADS, op);
     requestGroupMan->initWrDiskCache();
+    requestGroupMan->initPieceReadCache();
     e->setRequestGroupMan(std::move(requestGroupMan));
   }
   e->setFileAllocationMan(make_unique<FileAllocationMan>());
@@ -179,6 +186,14 @@ std::unique_ptr<DownloadEngine> DownloadEngineFactory::newDownloadEngine(
         e->newCUID(), e.get(),
         std::chrono::seconds(op->getAsInt(PREF_SAVE_SESSION_INTERVAL))));
   }
+  if (op->getAsBool(PREF_ENABLE_ENGINE_PROFILE)) {
+    e->setEngineProfiler(make_unique<EngineProfiler>());
+    if (op->getAsInt(PREF_ENGINE_PROFILE_INTERVAL) > 0) {
+      e->addRoutineCommand(make_unique<EngineProfileCommand>(
+          e->newCUID(), e.get(),
+          std::chrono::seconds(op->getAsInt(PREF_ENGINE_PROFILE_INTERVAL))));
+    }
+  }
   e->addRoutineCommand(
       make_unique<HaveEraseCommand>(e->newCUID(), e.get(), 10_s));
   {
@@ -0,0 +1,210 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "EngineProfiler.h"
+
+#include <cstdlib>
+#include <algorithm>
+#ifdef __GNUC__
+#  include <cxxabi.h>
+#endif // __GNUC__
+
+#include "LogFactory.h"
+#include "Logger.h"
+#include "fmt.h"
+#include "util.h"
+
+namespace aria2 {
+
+Histogram::Histogram() { reset(); }
+
+void Histogram::add(int64_t value)
+{
+  if (value < 0) {
+    value = 0;
+  }
+  size_t i = 0;
+  for (auto v = value; v > 0 && i < NUM_BUCKETS - 1; v >>= 1, ++i)
+    ;
+  ++buckets_[i];
+  ++count_;
+  sum_ += value;
+  max_ = std::max(max_, value);
+}
+
+int64_t Histogram::getPercentile(double p) const
+{
+  if (count_ == 0) {
+    return 0;
+  }
+  auto rank = static_cast<uint64_t>(p * count_ / 100.0 + 0.5);
+  rank = std::max(static_cast<uint64_t>(1), std::min(rank, count_));
+  uint64_t cum = 0;
+  for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+    cum += buckets_[i];
+    if (cum >= rank) {
+      if (i == 0) {
+        return 0;
+      }
+      return std::min(max_, (static_cast<int64_t>(1) << i) - 1);
+    }
+  }
+  return max_;
+}
+
+void Histogram::reset()
+{
+  buckets_.fill(0);
+  count_ = 0;
+  sum_ = 0;
+  max_ = 0;
+}
+
+namespace {
+int64_t toMicros(EngineProfiler::Clock::duration d)
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+}
+} // namespace
+
+namespace {
+// Returns human readable class name of |type| without namespace
+// qualification.
+std::string getTypeName(const std::type_index& type)
+{
+  std::string name;
+#ifdef __GNUC__
+  int status;
+  auto demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+  if (demangled) {
+    name = demangled;
+    free(demangled);
+  }
+#endif // __GNUC__
+  if (name.empty()) {
+    name = type.name();
+  }
+  auto pos = name.rfind("::");
+  if (pos != std::string::npos) {
+    name.erase(0, pos + 2);
+  }
+  return name;
+}
+} // namespace
+
+EngineProfiler::EngineProfiler() : startTime_(now()) {}
+
+void EngineProfiler::addPollWait(Clock::duration d)
+{
+  pollWaitTime_.add(toMicros(d));
+}
+
+void EngineProfiler::addIteration(Clock::duration busy, size_t numExecuted)
+{
+  iterationTime_.add(toMicros(busy));
+  commandsPerIteration_.add(numExecuted);
+}
+
+void EngineProfiler::addCommandExecution(const std::type_index& type,
+                                         Clock::duration d)
+{
+  auto i = commandStats_.find(type);
+  if (i == std::end(commandStats_)) {
+    i = commandStats_.emplace(type, CommandStat{getTypeName(type), Histogram()})
+            .first;
+  }
+  (*i).second.executeTime.add(toMicros(d));
+}
+
+std::vector<const EngineProfiler::CommandStat*>
+EngineProfiler::getCommandStats() const
+{
+  std::vector<const CommandStat*> res;
+  res.reserve(commandStats_.size());
+  for (auto& p : commandStats_) {
+    res.push_back(&p.second);
+  }
+  std::sort(std::begin(res), std::end(res),
+            [](const CommandStat* lhs, const CommandStat* rhs) {
+              return lhs->executeTime.getSum() > rhs->executeTime.getSum();
+            });
+  return res;
+}
+
+void EngineProfiler::reset()
+{
+  iterationTime_.reset();
+  pollWaitTime_.reset();
+  commandsPerIteration_.reset();
+  commandStats_.clear();
+  startTime_ = now();
+}
+
+namespace {
+std::string formatHistogram(const Histogram& h)
+{
+  return fmt("count=%" PRIu64 " sum=%" PRId64 " p50=%" PRId64 " p99=%" PRId64
+             " max=%" PRId64,
+             h.getCount(), h.getSum(), h.getPercentile(50),
+             h.getPercentile(99), h.getMax());
+}
+} // namespace
+
+void EngineProfiler::log(size_t maxCommands) const
+{
+  if (!LogFactory::getInstance()->levelEnabled(Logger::A2_INFO)) {
+    return;
+  }
+  A2_LOG_INFO(fmt("Engine profile: last %" PRId64 "s, times in usec",
+                  static_cast<int64_t>(
+                      std::chrono::duration_cast<std::chrono::seconds>(
+                          now() - startTime_)
+                          .count())));
+  A2_LOG_INFO(fmt("Engine profile: iteration %s",
+                  formatHistogram(iterationTime_).c_str()));
+  A2_LOG_INFO(fmt("Engine profile: poll wait %s",
+                  formatHistogram(pollWaitTime_).c_str()));
+  A2_LOG_INFO(fmt("Engine profile: commands per iteration %s",
+                  formatHistogram(commandsPerIteration_).c_str()));
+  auto stats = getCommandStats();
+  if (stats.size() > maxCommands) {
+    stats.resize(maxCommands);
+  }
+  for (auto stat : stats) {
+    A2_LOG_INFO(fmt("Engine profile: %s %s", stat->name.c_str(),
+                    formatHistogram(stat->executeTime).c_str()));
+  }
+}
+
+} // namespace aria2
@@ -0,0 +1,142 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_ENGINE_PROFILER_H
+#define D_ENGINE_PROFILER_H
+
+#include "common.h"
+
+#include <string>
+#include <vector>
+#include <array>
+#include <chrono>
+#include <typeindex>
+#include <unordered_map>
+
+namespace aria2 {
+
+// Histogram of non-negative integer samples with power of 2 buckets.
+// Bucket 0 holds samples less than 1, and bucket i (i > 0) holds
+// samples in [2^(i-1), 2^i).  The last bucket also holds anything
+// larger.
+class Histogram {
+public:
+  static const size_t NUM_BUCKETS = 40;
+
+  Histogram();
+
+  void add(int64_t value);
+
+  uint64_t getCount() const { return count_; }
+
+  int64_t getSum() const { return sum_; }
+
+  int64_t getMax() const { return max_; }
+
+  // Returns an estimate of the |p|-th percentile (0 < p <= 100).
+  // This is the upper bound of the bucket in which the percentile
+  // falls, capped by the maximum sample, so it is never less than the
+  // real value and is at most twice of it.  Returns 0 if no sample
+  // has been added.
+  int64_t getPercentile(double p) const;
+
+  void reset();
+
+private:
+  std::array<uint64_t, NUM_BUCKETS> buckets_;
+  uint64_t count_;
+  int64_t sum_;
+  int64_t max_;
+};
+
+// Collects timing of the DownloadEngine event loop: how long each
+// iteration keeps the loop busy, how long it waits in EventPoll, how
+// many Commands are executed per iteration, and how long execute()
+// takes for each Command type.  Times are in microseconds.
+//
+// DownloadEngine holds EngineProfiler only when profiling is
+// enabled, so that a disabled profiler costs a pointer test per
+// Command execution.
+class EngineProfiler {
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  struct CommandStat {
+    std::string name;
+    Histogram executeTime;
+  };
+
+  EngineProfiler();
+
+  static Clock::time_point now() { return Clock::now(); }
+
+  void addPollWait(Clock::duration d);
+
+  void addIteration(Clock::duration busy, size_t numExecuted);
+
+  void addCommandExecution(const std::type_index& type, Clock::duration d);
+
+  const Histogram& getIterationTime() const { return iterationTime_; }
+
+  const Histogram& getPollWaitTime() const { return pollWaitTime_; }
+
+  const Histogram& getCommandsPerIteration() const
+  {
+    return commandsPerIteration_;
+  }
+
+  // Returns statistics of Command types sorted by total execution
+  // time in descending order.
+  std::vector<const CommandStat*> getCommandStats() const;
+
+  // Returns the time when profiling started or was last reset.
+  Clock::time_point getStartTime() const { return startTime_; }
+
+  void reset();
+
+  // Writes the summary of collected statistics to the log.  At most
+  // |maxCommands| Command types are listed.
+  void log(size_t maxCommands = 10) const;
+
+private:
+  Histogram iterationTime_;
+  Histogram pollWaitTime_;
+  Histogram commandsPerIteration_;
+  std::unordered_map<std::type_index, CommandStat> commandStats_;
+  Clock::time_point startTime_;
+};
+
+} // namespace aria2
+
+#endif // D_ENGINE_PROFILER_H
@@ -58,6 +58,12 @@
 #ifdef HAVE_LIBGMP
 #  include <gmp.h>
 #endif // HAVE_LIBGMP
+#ifdef HAVE_LIBBROTLIDEC
+#  include <brotli/decode.h>
+#endif // HAVE_LIBBROTLIDEC
+#ifdef HAVE_LIBZSTD
+#  include <zstd.h>
+#endif // HAVE_LIBZSTD
 #ifdef HAVE_LIBGCRYPT
 #  include <gcrypt.h>
 #endif // HAVE_LIBGCRYPT
@@ -70,6 +76,9 @@
 #ifdef HAVE_LIBSSH2
 #  include <libssh2.h>
 #endif // HAVE_LIBSSH2
+#ifdef HAVE_LIBNGHTTP2
+#  include <nghttp2/nghttp2.h>
+#endif // HAVE_LIBNGHTTP2
 #include "util.h"
 
 namespace aria2 {
@@ -183,6 +192,14 @@ const char* strSupportedFeature(int feature)
 #endif // !HAVE_LIBSSH2
     break;
 
+  case (FEATURE_HTTP2):
+#if defined(HAVE_LIBNGHTTP2) && defined(ENABLE_SSL)
+    return "HTTP/2";
+#else  // !HAVE_LIBNGHTTP2 || !ENABLE_SSL
+    return nullptr;
+#endif // !HAVE_LIBNGHTTP2 || !ENABLE_SSL
+    break;
+
   default:
     return nullptr;
   }
@@ -194,6 +211,17 @@ std::string usedLibs()
 #ifdef HAVE_ZLIB
   res += "zlib/" ZLIB_VERSION " ";
 #endif // HAVE_ZLIB
+#ifdef HAVE_LIBBROTLIDEC
+  {
+    // BrotliDecoderVersion() returns (major << 24) | (minor << 12) |
+    // patch.
+    auto v = BrotliDecoderVersion();
+    res += fmt("brotli/%u.%u.%u ", v >> 24, (v >> 12) & 0xfff, v & 0xfff);
+  }
+#endif // HAVE_LIBBROTLIDEC
+#ifdef HAVE_LIBZSTD
+  res += "zstd/" ZSTD_VERSION_STRING " ";
+#endif // HAVE_LIBZSTD
 #ifdef HAVE_LIBXML2
   res += "libxml2/" LIBXML_DOTTED_VERSION " ";
 #endif // HAVE_LIBXML2
@@ -240,6 +268,9 @@ std::string usedLibs()
 #ifdef HAVE_LIBSSH2
   res += "libssh2/" LIBSSH2_VERSION " ";
 #endif // HAVE_LIBSSH2
+#ifdef HAVE_LIBNGHTTP2
+  res += "nghttp2/" NGHTTP2_VERSION " ";
+#endif // HAVE_LIBNGHTTP2
 
   if (!res.empty()) {
     res.erase(res.length() - 1);
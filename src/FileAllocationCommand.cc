@@ -52,6 +52,13 @@
 
 namespace aria2 {
 
+#ifdef HAVE_STD_THREAD
+namespace {
+// How often the worker thread is checked if it cannot wake us up.
+constexpr auto WORKER_CHECK_INTERVAL = std::chrono::milliseconds(50);
+} // namespace
+#endif // HAVE_STD_THREAD
+
 FileAllocationCommand::FileAllocationCommand(
     cuid_t cuid, RequestGroup* requestGroup, DownloadEngine* e,
     FileAllocationEntry* fileAllocationEntry)
@@ -62,15 +69,68 @@ FileAllocationCommand::FileAllocationCommand(
 
 FileAllocationCommand::~FileAllocationCommand()
 {
-  getDownloadEngine()->getFileAllocationMan()->dropPickedEntry();
+#ifdef HAVE_STD_THREAD
+  auto fd = fileAllocationEntry_->getWakeupFd();
+  if (fd != -1) {
+    getDownloadEngine()->deleteFdForReadCheck(fd, this);
+  }
+#endif // HAVE_STD_THREAD
+  getDownloadEngine()->getFileAllocationMan()->dropPickedEntry(
+      fileAllocationEntry_);
+}
+
+#ifdef HAVE_STD_THREAD
+bool FileAllocationCommand::execute()
+{
+  if (fileAllocationEntry_->workerRunning()) {
+    if (getRequestGroup()->isHaltRequested()) {
+      // The worker is reaped when it stops, so that joining it does
+      // not block the event loop.
+      fileAllocationEntry_->cancelWorker();
+    }
+    if (fileAllocationEntry_->getWakeupFd() == -1) {
+      getDownloadEngine()->setRefreshInterval(WORKER_CHECK_INTERVAL);
+    }
+    // The worker wakes us up when it finishes.
+    // RealtimeCommand::execute() would keep the event loop spinning.
+    setStatusInactive();
+    getDownloadEngine()->addCommand(std::unique_ptr<Command>(this));
+    return false;
+  }
+  return RealtimeCommand::execute();
 }
+#endif // HAVE_STD_THREAD
 
 bool FileAllocationCommand::executeInternal()
 {
+#ifdef HAVE_STD_THREAD
+  if (!fileAllocationEntry_->workerStarted()) {
+    if (getRequestGroup()->isHaltRequested()) {
+      return true;
+    }
+    fileAllocationEntry_->startWorker();
+    auto fd = fileAllocationEntry_->getWakeupFd();
+    if (fd != -1) {
+      getDownloadEngine()->addFdForReadCheck(fd, this);
+    }
+    getDownloadEngine()->addCommand(std::unique_ptr<Command>(this));
+    return false;
+  }
+  // execute() lets us here only after the worker finished.
+  auto fd = fileAllocationEntry_->getWakeupFd();
+  if (fd != -1) {
+    getDownloadEngine()->deleteFdForReadCheck(fd, this);
+  }
+  fileAllocationEntry_->joinWorker();
+  if (getRequestGroup()->isHaltRequested()) {
+    return true;
+  }
+#else  // !HAVE_STD_THREAD
   if (getRequestGroup()->isHaltRequested()) {
     return true;
   }
   fileAllocationEntry_->allocateChunk();
+#endif // !HAVE_STD_THREAD
   if (fileAllocationEntry_->finished()) {
     A2_LOG_DEBUG(fmt(
         MSG_ALLOCATION_COMPLETED,
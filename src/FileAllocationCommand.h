@@ -57,6 +57,10 @@ public:
 
   virtual ~FileAllocationCommand();
 
+#ifdef HAVE_STD_THREAD
+  virtual bool execute() CXX11_OVERRIDE;
+#endif // HAVE_STD_THREAD
+
   virtual bool executeInternal() CXX11_OVERRIDE;
 
   virtual bool handleException(Exception& e) CXX11_OVERRIDE;
@@ -35,22 +35,33 @@
 #ifndef D_FILE_ALLOCATION_DISPATCHER_COMMAND_H
 #define D_FILE_ALLOCATION_DISPATCHER_COMMAND_H
 
-#include "SequentialDispatcherCommand.h"
+#include "Command.h"
+
+#include <memory>
+
 #include "FileAllocationMan.h"
 
 namespace aria2 {
 
 class FileAllocationEntry;
+class DownloadEngine;
+
+// Starts a FileAllocationCommand for each entry picked from
+// FileAllocationMan.  Unlike SequentialDispatcherCommand, entries on
+// different devices are allocated at the same time.
+class FileAllocationDispatcherCommand : public Command {
+private:
+  FileAllocationMan* fileAllocMan_;
+
+  DownloadEngine* e_;
+
+  std::unique_ptr<Command> createCommand(FileAllocationEntry* entry);
 
-class FileAllocationDispatcherCommand
-    : public SequentialDispatcherCommand<FileAllocationEntry> {
 public:
   FileAllocationDispatcherCommand(cuid_t cuid, FileAllocationMan* fileAllocMan,
                                   DownloadEngine* e);
 
-protected:
-  virtual std::unique_ptr<Command>
-  createCommand(FileAllocationEntry* entry) CXX11_OVERRIDE;
+  virtual bool execute() CXX11_OVERRIDE;
 };
 
 } // namespace aria2
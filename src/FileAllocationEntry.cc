@@ -33,11 +33,20 @@
  */
 /* copyright --> */
 #include "FileAllocationEntry.h"
+
+#include <cassert>
+#include <cerrno>
+
 #include "FileAllocationIterator.h"
 #include "DownloadEngine.h"
 #include "RequestGroup.h"
 #include "PieceStorage.h"
 #include "DiskAdaptor.h"
+#include "DownloadContext.h"
+#include "FileEntry.h"
+#include "File.h"
+#include "util.h"
+#include "a2io.h"
 
 namespace aria2 {
 
@@ -47,23 +56,63 @@ FileAllocationEntry::FileAllocationEntry(RequestGroup* requestGroup,
       fileAllocationIterator_{requestGroup->getPieceStorage()
                                   ->getDiskAdaptor()
                                   ->fileAllocationIterator()}
+#ifdef HAVE_STD_THREAD
+      ,
+      currentLength_{0},
+      totalLength_{0},
+      finished_{false},
+      workerDone_{false},
+      cancel_{false},
+      wakeupFds_{-1, -1}
+#endif // HAVE_STD_THREAD
 {
 }
 
-FileAllocationEntry::~FileAllocationEntry() = default;
+FileAllocationEntry::~FileAllocationEntry()
+{
+#ifdef HAVE_STD_THREAD
+  // FileAllocationCommand reaps the worker before dropping us, even
+  // if the download is stopped.  This is only reached if the engine
+  // is destroyed while the worker runs.
+  if (worker_.joinable()) {
+    cancel_ = true;
+    worker_.join();
+    getRequestGroup()->setFileAllocationRunning(false);
+  }
+  closeWakeupFds();
+#endif // HAVE_STD_THREAD
+}
 
 int64_t FileAllocationEntry::getCurrentLength()
 {
+#ifdef HAVE_STD_THREAD
+  if (worker_.joinable()) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return currentLength_;
+  }
+#endif // HAVE_STD_THREAD
   return fileAllocationIterator_->getCurrentLength();
 }
 
 int64_t FileAllocationEntry::getTotalLength()
 {
+#ifdef HAVE_STD_THREAD
+  if (worker_.joinable()) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return totalLength_;
+  }
+#endif // HAVE_STD_THREAD
   return fileAllocationIterator_->getTotalLength();
 }
 
 bool FileAllocationEntry::finished()
 {
+#ifdef HAVE_STD_THREAD
+  if (worker_.joinable()) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return finished_;
+  }
+#endif // HAVE_STD_THREAD
   return fileAllocationIterator_->finished();
 }
 
@@ -72,4 +121,108 @@ void FileAllocationEntry::allocateChunk()
   fileAllocationIterator_->allocateChunk();
 }
 
+#ifdef HAVE_STD_THREAD
+void FileAllocationEntry::updateProgress()
+{
+  auto currentLength = fileAllocationIterator_->getCurrentLength();
+  auto totalLength = fileAllocationIterator_->getTotalLength();
+  auto finished = fileAllocationIterator_->finished();
+  std::lock_guard<std::mutex> lock(mutex_);
+  currentLength_ = currentLength;
+  totalLength_ = totalLength;
+  finished_ = finished;
+}
+
+void FileAllocationEntry::closeWakeupFds()
+{
+  for (auto& fd : wakeupFds_) {
+    if (fd != -1) {
+      close(fd);
+      fd = -1;
+    }
+  }
+}
+
+void FileAllocationEntry::startWorker()
+{
+  assert(!worker_.joinable());
+  updateProgress();
+#ifndef __MINGW32__
+  if (pipe(wakeupFds_) == 0) {
+    util::make_fd_cloexec(wakeupFds_[0]);
+    util::make_fd_cloexec(wakeupFds_[1]);
+  }
+  else {
+    wakeupFds_[0] = wakeupFds_[1] = -1;
+  }
+#endif // !__MINGW32__
+  // RequestGroup::startCheckpoint() must not touch the DiskWriter the
+  // worker writes to.
+  getRequestGroup()->setFileAllocationRunning(true);
+  worker_ = std::thread([this] {
+    try {
+      while (!cancel_ && !fileAllocationIterator_->finished()) {
+        fileAllocationIterator_->allocateChunk();
+        updateProgress();
+      }
+    }
+    catch (...) {
+      error_ = std::current_exception();
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      workerDone_ = true;
+    }
+#ifndef __MINGW32__
+    if (wakeupFds_[1] != -1) {
+      char c = 0;
+      while (write(wakeupFds_[1], &c, 1) == -1 && errno == EINTR)
+        ;
+    }
+#endif // !__MINGW32__
+  });
+}
+
+bool FileAllocationEntry::workerRunning()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return worker_.joinable() && !workerDone_;
+}
+
+void FileAllocationEntry::joinWorker()
+{
+  worker_.join();
+  closeWakeupFds();
+  getRequestGroup()->setFileAllocationRunning(false);
+  if (error_) {
+    auto error = error_;
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+#endif // HAVE_STD_THREAD
+
+uint64_t FileAllocationEntry::getDeviceId() const
+{
+  auto fileEntry =
+      getRequestGroup()->getDownloadContext()->getFirstRequestedFileEntry();
+  if (!fileEntry) {
+    return 0;
+  }
+  // The file and its parent directories may not be created yet.
+  auto path = fileEntry->getPath();
+  while (!path.empty()) {
+    a2_struct_stat fstat;
+    if (a2stat(utf8ToWChar(path).c_str(), &fstat) == 0) {
+      return fstat.st_dev;
+    }
+    auto dirname = File(path).getDirname();
+    if (dirname == path) {
+      break;
+    }
+    path = std::move(dirname);
+  }
+  return 0;
+}
+
 } // namespace aria2
@@ -39,6 +39,12 @@
 
 #include <vector>
 #include <memory>
+#ifdef HAVE_STD_THREAD
+#  include <atomic>
+#  include <exception>
+#  include <mutex>
+#  include <thread>
+#endif // HAVE_STD_THREAD
 
 #include "ProgressAwareEntry.h"
 
@@ -52,6 +58,28 @@ class FileAllocationEntry : public RequestGroupEntry,
                             public ProgressAwareEntry {
 private:
   std::unique_ptr<FileAllocationIterator> fileAllocationIterator_;
+#ifdef HAVE_STD_THREAD
+  // While worker_ runs, fileAllocationIterator_ is only touched by
+  // it.  The event loop reads the progress from the copies below,
+  // which are updated after each chunk.
+  std::thread worker_;
+  std::mutex mutex_;
+  int64_t currentLength_;
+  int64_t totalLength_;
+  bool finished_;
+  bool workerDone_;
+  std::atomic<bool> cancel_;
+  // The exception thrown in worker_, if any
+  std::exception_ptr error_;
+  // worker_ writes a byte to wakeupFds_[1] when it finishes, so that
+  // the event loop waiting for wakeupFds_[0] wakes up.  Both are -1
+  // if no pipe is available.
+  int wakeupFds_[2];
+
+  void updateProgress();
+
+  void closeWakeupFds();
+#endif // HAVE_STD_THREAD
 
 public:
   FileAllocationEntry(
@@ -68,6 +96,39 @@ public:
 
   void allocateChunk();
 
+#ifdef HAVE_STD_THREAD
+  // Starts a worker thread which calls allocateChunk() until the
+  // allocation finishes.  Files on different devices are allocated
+  // by different threads, so a slow device does not hold up the
+  // others or the event loop.
+  void startWorker();
+
+  bool workerStarted() const { return worker_.joinable(); }
+
+  // Returns true if the worker thread has not finished yet.
+  bool workerRunning();
+
+  // Lets the worker thread stop after the current chunk.  A single
+  // chunk may take long, for example if posix_fallocate() is emulated
+  // by writing.
+  void cancelWorker() { cancel_ = true; }
+
+  // Returns the descriptor which becomes readable when the worker
+  // thread finishes, or -1 if there is none.  It is valid until
+  // joinWorker() is called.
+  int getWakeupFd() const { return wakeupFds_[0]; }
+
+  // Reaps the worker thread, which must have finished, and rethrows
+  // the exception thrown in it, if any.
+  void joinWorker();
+#endif // HAVE_STD_THREAD
+
+  // Returns the ID of the device the files are allocated on, that is,
+  // the device of the first requested file, or of its nearest
+  // existing parent directory.  Returns 0 if it is unknown.  The other
+  // files are assumed to be on the same device, even if they are not.
+  uint64_t getDeviceId() const;
+
   virtual void
   prepareForNextAction(std::vector<std::unique_ptr<Command>>& commands,
                        DownloadEngine* e) = 0;
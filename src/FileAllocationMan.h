@@ -36,13 +36,15 @@
 #define D_FILE_ALLOCATION_MAN_H
 
 #include "common.h"
-#include "SequentialPicker.h"
+#include "ParallelPicker.h"
 
 namespace aria2 {
 
 class FileAllocationEntry;
 
-typedef SequentialPicker<FileAllocationEntry> FileAllocationMan;
+// Files on different devices are allocated concurrently.  See
+// FileAllocationEntry::getDeviceId().
+typedef ParallelPicker<FileAllocationEntry> FileAllocationMan;
 
 } // namespace aria2
 
@@ -72,101 +72,165 @@ FtpConnection::FtpConnection(cuid_t cuid,
       authConfig_(authConfig),
       option_(op),
       socketBuffer_(socket),
-      baseWorkingDir_("/")
+      baseWorkingDir_("/"),
+      transferType_(0)
 {
 }
 
 FtpConnection::~FtpConnection() = default;
 
+void FtpConnection::queueUser()
+{
+  std::string request = "USER ";
+  request += authConfig_->getUser();
+  request += "\r\n";
+  A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, "USER ********"));
+  socketBuffer_.pushStr(std::move(request));
+}
+
+void FtpConnection::queuePass()
+{
+  std::string request = "PASS ";
+  request += authConfig_->getPassword();
+  request += "\r\n";
+  A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, "PASS ********"));
+  socketBuffer_.pushStr(std::move(request));
+}
+
+char FtpConnection::getRequestedTransferType() const
+{
+  return option_->get(PREF_FTP_TYPE) == V_ASCII ? 'A' : 'I';
+}
+
+void FtpConnection::queueType()
+{
+  std::string request = "TYPE ";
+  request += getRequestedTransferType();
+  request += "\r\n";
+  A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, request.c_str()));
+  socketBuffer_.pushStr(std::move(request));
+}
+
+void FtpConnection::queuePwd()
+{
+  std::string request = "PWD\r\n";
+  A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, request.c_str()));
+  socketBuffer_.pushStr(std::move(request));
+}
+
+void FtpConnection::queueCwd(const std::string& dir)
+{
+  std::string request = "CWD ";
+  request += util::percentDecode(dir.begin(), dir.end());
+  request += "\r\n";
+  A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, request.c_str()));
+  socketBuffer_.pushStr(std::move(request));
+}
+
+void FtpConnection::queueMdtm()
+{
+  std::string request = "MDTM ";
+  request +=
+      util::percentDecode(req_->getFile().begin(), req_->getFile().end());
+  request += "\r\n";
+  A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, request.c_str()));
+  socketBuffer_.pushStr(std::move(request));
+}
+
+void FtpConnection::queueSize()
+{
+  std::string request = "SIZE ";
+  request +=
+      util::percentDecode(req_->getFile().begin(), req_->getFile().end());
+  request += "\r\n";
+  A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, request.c_str()));
+  socketBuffer_.pushStr(std::move(request));
+}
+
+void FtpConnection::queueRest(const std::shared_ptr<Segment>& segment)
+{
+  std::string request =
+      fmt("REST %" PRId64 "\r\n", segment ? segment->getPositionToWrite()
+                                          : static_cast<int64_t>(0LL));
+  A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, request.c_str()));
+  socketBuffer_.pushStr(std::move(request));
+}
+
+void FtpConnection::queueRetr()
+{
+  std::string request = "RETR ";
+  request +=
+      util::percentDecode(req_->getFile().begin(), req_->getFile().end());
+  request += "\r\n";
+  A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, request.c_str()));
+  socketBuffer_.pushStr(std::move(request));
+}
+
+bool FtpConnection::sendPendingData()
+{
+  socketBuffer_.send();
+  return socketBuffer_.sendBufferIsEmpty();
+}
+
+bool FtpConnection::sendBufferIsEmpty() const
+{
+  return socketBuffer_.sendBufferIsEmpty();
+}
+
 bool FtpConnection::sendUser()
 {
   if (socketBuffer_.sendBufferIsEmpty()) {
-    std::string request = "USER ";
-    request += authConfig_->getUser();
-    request += "\r\n";
-    A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, "USER ********"));
-    socketBuffer_.pushStr(std::move(request));
+    queueUser();
   }
-  socketBuffer_.send();
-  return socketBuffer_.sendBufferIsEmpty();
+  return sendPendingData();
 }
 
 bool FtpConnection::sendPass()
 {
   if (socketBuffer_.sendBufferIsEmpty()) {
-    std::string request = "PASS ";
-    request += authConfig_->getPassword();
-    request += "\r\n";
-    A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, "PASS ********"));
-    socketBuffer_.pushStr(std::move(request));
+    queuePass();
   }
-  socketBuffer_.send();
-  return socketBuffer_.sendBufferIsEmpty();
+  return sendPendingData();
 }
 
 bool FtpConnection::sendType()
 {
   if (socketBuffer_.sendBufferIsEmpty()) {
-    std::string request = "TYPE ";
-    request += (option_->get(PREF_FTP_TYPE) == V_ASCII ? 'A' : 'I');
-    request += "\r\n";
-    A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, request.c_str()));
-    socketBuffer_.pushStr(std::move(request));
+    queueType();
   }
-  socketBuffer_.send();
-  return socketBuffer_.sendBufferIsEmpty();
+  return sendPendingData();
 }
 
 bool FtpConnection::sendPwd()
 {
   if (socketBuffer_.sendBufferIsEmpty()) {
-    std::string request = "PWD\r\n";
-    A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, request.c_str()));
-    socketBuffer_.pushStr(std::move(request));
+    queuePwd();
   }
-  socketBuffer_.send();
-  return socketBuffer_.sendBufferIsEmpty();
+  return sendPendingData();
 }
 
 bool FtpConnection::sendCwd(const std::string& dir)
 {
   if (socketBuffer_.sendBufferIsEmpty()) {
-    std::string request = "CWD ";
-    request += util::percentDecode(dir.begin(), dir.end());
-    request += "\r\n";
-    A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, request.c_str()));
-    socketBuffer_.pushStr(std::move(request));
+    queueCwd(dir);
   }
-  socketBuffer_.send();
-  return socketBuffer_.sendBufferIsEmpty();
+  return sendPendingData();
 }
 
 bool FtpConnection::sendMdtm()
 {
   if (socketBuffer_.sendBufferIsEmpty()) {
-    std::string request = "MDTM ";
-    request +=
-        util::percentDecode(req_->getFile().begin(), req_->getFile().end());
-    request += "\r\n";
-    A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, request.c_str()));
-    socketBuffer_.pushStr(std::move(request));
+    queueMdtm();
   }
-  socketBuffer_.send();
-  return socketBuffer_.sendBufferIsEmpty();
+  return sendPendingData();
 }
 
 bool FtpConnection::sendSize()
 {
   if (socketBuffer_.sendBufferIsEmpty()) {
-    std::string request = "SIZE ";
-    request +=
-        util::percentDecode(req_->getFile().begin(), req_->getFile().end());
-    request += "\r\n";
-    A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, request.c_str()));
-    socketBuffer_.pushStr(std::move(request));
+    queueSize();
   }
-  socketBuffer_.send();
-  return socketBuffer_.sendBufferIsEmpty();
+  return sendPendingData();
 }
 
 bool FtpConnection::sendEpsv()
@@ -176,8 +240,7 @@ bool FtpConnection::sendEpsv()
     A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, request.c_str()));
     socketBuffer_.pushStr(std::move(request));
   }
-  socketBuffer_.send();
-  return socketBuffer_.sendBufferIsEmpty();
+  return sendPendingData();
 }
 
 bool FtpConnection::sendPasv()
@@ -187,8 +250,7 @@ bool FtpConnection::sendPasv()
     A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, request.c_str()));
     socketBuffer_.pushStr(std::move(request));
   }
-  socketBuffer_.send();
-  return socketBuffer_.sendBufferIsEmpty();
+  return sendPendingData();
 }
 
 std::shared_ptr<SocketCore> FtpConnection::createServerSocket()
@@ -210,8 +272,7 @@ bool FtpConnection::sendEprt(const std::shared_ptr<SocketCore>& serverSocket)
     A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, request.c_str()));
     socketBuffer_.pushStr(std::move(request));
   }
-  socketBuffer_.send();
-  return socketBuffer_.sendBufferIsEmpty();
+  return sendPendingData();
 }
 
 bool FtpConnection::sendPort(const std::shared_ptr<SocketCore>& serverSocket)
@@ -228,35 +289,23 @@ bool FtpConnection::sendPort(const std::shared_ptr<SocketCore>& serverSocket)
     A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, request.c_str()));
     socketBuffer_.pushStr(std::move(request));
   }
-  socketBuffer_.send();
-  return socketBuffer_.sendBufferIsEmpty();
+  return sendPendingData();
 }
 
 bool FtpConnection::sendRest(const std::shared_ptr<Segment>& segment)
 {
   if (socketBuffer_.sendBufferIsEmpty()) {
-    std::string request =
-        fmt("REST %" PRId64 "\r\n", segment ? segment->getPositionToWrite()
-                                            : static_cast<int64_t>(0LL));
-    A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, request.c_str()));
-    socketBuffer_.pushStr(std::move(request));
+    queueRest(segment);
   }
-  socketBuffer_.send();
-  return socketBuffer_.sendBufferIsEmpty();
+  return sendPendingData();
 }
 
 bool FtpConnection::sendRetr()
 {
   if (socketBuffer_.sendBufferIsEmpty()) {
-    std::string request = "RETR ";
-    request +=
-        util::percentDecode(req_->getFile().begin(), req_->getFile().end());
-    request += "\r\n";
-    A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, request.c_str()));
-    socketBuffer_.pushStr(std::move(request));
+    queueRetr();
   }
-  socketBuffer_.send();
-  return socketBuffer_.sendBufferIsEmpty();
+  return sendPendingData();
 }
 
 int FtpConnection::getStatus(const std::string& response) const
@@ -368,6 +417,17 @@ int FtpConnection::receiveResponse()
   }
 }
 
+bool FtpConnection::isResponseBuffered() const
+{
+  if (strbuf_.size() < 4) {
+    return false;
+  }
+  int status = getStatus(strbuf_);
+  // If status is 0, receiveResponse() reports the protocol error.
+  return status == 0 ||
+         findEndOfResponse(status, strbuf_) != std::string::npos;
+}
+
 #ifdef __MINGW32__
 #  define LONGLONG_PRINTF "%I64d"
 #  define ULONGLONG_PRINTF "%I64u"
@@ -548,6 +608,38 @@ void FtpConnection::setBaseWorkingDir(const std::string& baseWorkingDir)
   baseWorkingDir_ = baseWorkingDir;
 }
 
+std::string FtpConnection::getPoolOptions() const
+{
+  std::string options = baseWorkingDir_;
+  options += '\n';
+  if (transferType_) {
+    options += transferType_;
+  }
+  options += '\n';
+  options += workingDir_;
+  return options;
+}
+
+void FtpConnection::setPoolOptions(const std::string& options)
+{
+  auto p = options.find('\n');
+  if (p == std::string::npos) {
+    baseWorkingDir_ = options;
+    transferType_ = 0;
+    workingDir_.clear();
+    return;
+  }
+  baseWorkingDir_.assign(options, 0, p);
+  auto q = options.find('\n', p + 1);
+  if (q == std::string::npos) {
+    transferType_ = 0;
+    workingDir_.clear();
+    return;
+  }
+  transferType_ = q == p + 2 ? options[p + 1] : 0;
+  workingDir_.assign(options, q + 1, std::string::npos);
+}
+
 const std::string& FtpConnection::getUser() const
 {
   return authConfig_->getUser();
@@ -70,6 +70,15 @@ private:
 
   std::string baseWorkingDir_;
 
+  // The transfer type ('A' or 'I') set by the last successful TYPE
+  // command, or 0 if it is unknown.
+  char transferType_;
+
+  // The directory, relative to baseWorkingDir_, which the last
+  // successful series of CWD commands changed to.  Empty if it is
+  // unknown.
+  std::string workingDir_;
+
   int getStatus(const std::string& response) const;
   std::string::size_type findEndOfResponse(int status,
                                            const std::string& buf) const;
@@ -84,6 +93,29 @@ public:
                 const std::shared_ptr<AuthConfig>& authConfig,
                 const Option* op);
   ~FtpConnection();
+
+  // The queueXXX() functions append the request to the send buffer.
+  // It is sent by sendPendingData().  Queueing several requests
+  // before sending them pipelines them.
+  void queueUser();
+  void queuePass();
+  void queueType();
+  void queuePwd();
+  void queueCwd(const std::string& dir);
+  void queueMdtm();
+  void queueSize();
+  void queueRest(const std::shared_ptr<Segment>& segment);
+  void queueRetr();
+
+  // Sends the data in the send buffer.  Returns true if all data have
+  // been sent.
+  bool sendPendingData();
+
+  bool sendBufferIsEmpty() const;
+
+  // The sendXXX() functions queue the request if the send buffer is
+  // empty, and then send the data in the send buffer.  Returns true
+  // if all data have been sent.
   bool sendUser();
   bool sendPass();
   bool sendType();
@@ -100,6 +132,9 @@ public:
   bool sendRetr();
 
   int receiveResponse();
+  // Returns true if a complete response has already been read from
+  // the socket.  It is not notified by the socket readiness.
+  bool isResponseBuffered() const;
   int receiveSizeResponse(int64_t& size);
   // Returns status code of MDTM reply. If the status code is 213, parses
   // time-val and store it in time.
@@ -116,6 +151,27 @@ public:
 
   const std::string& getBaseWorkingDir() const { return baseWorkingDir_; }
 
+  // Returns the transfer type requested by the ftp-type option.
+  char getRequestedTransferType() const;
+
+  void setTransferType(char type) { transferType_ = type; }
+
+  char getTransferType() const { return transferType_; }
+
+  void setWorkingDir(const std::string& dir) { workingDir_ = dir; }
+
+  const std::string& getWorkingDir() const { return workingDir_; }
+
+  // Returns the state of this connection which is saved with the
+  // socket when it is pooled.  It contains the base working
+  // directory, the transfer type and the working directory.
+  std::string getPoolOptions() const;
+
+  // Restores the state saved by getPoolOptions().  For backward
+  // compatibility, a string which only contains the base working
+  // directory is also accepted.
+  void setPoolOptions(const std::string& options);
+
   const std::string& getUser() const;
 };
 
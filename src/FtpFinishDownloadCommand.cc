@@ -74,7 +74,10 @@ bool FtpFinishDownloadCommand::execute()
     return true;
   }
   try {
-    if (readEventEnabled() || hupEventEnabled()) {
+    // The response may have been read together with the previous
+    // one.
+    if (readEventEnabled() || hupEventEnabled() ||
+        ftpConnection_->isResponseBuffered()) {
       getCheckPoint() = global::wallclock();
       int status = ftpConnection_->receiveResponse();
       if (status == 0) {
@@ -85,7 +88,7 @@ bool FtpFinishDownloadCommand::execute()
         if (getOption()->getAsBool(PREF_FTP_REUSE_CONNECTION)) {
           getDownloadEngine()->poolSocket(
               getRequest(), ftpConnection_->getUser(), createProxyRequest(),
-              getSocket(), ftpConnection_->getBaseWorkingDir());
+              getSocket(), ftpConnection_->getPoolOptions());
         }
       }
       else {
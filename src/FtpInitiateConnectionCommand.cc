@@ -56,7 +56,7 @@
 #include "AuthConfig.h"
 #include "fmt.h"
 #include "SocketRecvBuffer.h"
-#include "BackupIPv4ConnectCommand.h"
+#include "BackupConnectCommand.h"
 #include "FtpNegotiationConnectChain.h"
 #include "FtpTunnelRequestConnectChain.h"
 #include "HttpRequestConnectChain.h"
@@ -82,6 +82,9 @@ std::unique_ptr<Command> FtpInitiateConnectionCommand::createNextCommandProxied(
     const std::vector<std::string>& resolvedAddresses,
     const std::shared_ptr<Request>& proxyRequest)
 {
+  if (!mayReuseConnection(hostname, port)) {
+    return nullptr;
+  }
   std::string options;
   std::shared_ptr<SocketCore> pooledSocket;
   std::string proxyMethod = resolveProxyMethod(getRequest()->getProtocol());
@@ -103,6 +106,9 @@ std::unique_ptr<Command> FtpInitiateConnectionCommand::createNextCommandProxied(
   }
 
   if (!pooledSocket) {
+    if (!acquireConnection(hostname, port)) {
+      return nullptr;
+    }
     A2_LOG_INFO(fmt(MSG_CONNECTING_TO_SERVER, getCuid(), addr.c_str(), port));
     createSocket();
     getSocket()->establishConnection(addr, port);
@@ -140,7 +146,7 @@ std::unique_ptr<Command> FtpInitiateConnectionCommand::createNextCommandProxied(
     }
 #endif // HAVE_LIBSSH2
 
-    // options contains "baseWorkingDir"
+    // options contains the state of FtpConnection
     return make_unique<FtpNegotiationCommand>(
         getCuid(), getRequest(), getFileEntry(), getRequestGroup(),
         getDownloadEngine(), pooledSocket,
@@ -171,6 +177,9 @@ std::unique_ptr<Command> FtpInitiateConnectionCommand::createNextCommandPlain(
     const std::string& hostname, const std::string& addr, uint16_t port,
     const std::vector<std::string>& resolvedAddresses)
 {
+  if (!mayReuseConnection(hostname, port)) {
+    return nullptr;
+  }
   std::string options;
   std::shared_ptr<SocketCore> pooledSocket =
       getDownloadEngine()->popPooledSocket(
@@ -181,6 +190,9 @@ std::unique_ptr<Command> FtpInitiateConnectionCommand::createNextCommandPlain(
               ->getUser());
 
   if (!pooledSocket) {
+    if (!acquireConnection(hostname, port)) {
+      return nullptr;
+    }
     A2_LOG_INFO(fmt(MSG_CONNECTING_TO_SERVER, getCuid(), addr.c_str(), port));
     createSocket();
     getSocket()->establishConnection(addr, port);
@@ -214,7 +226,7 @@ std::unique_ptr<Command> FtpInitiateConnectionCommand::createNextCommandPlain(
   }
 #endif // HAVE_LIBSSH2
 
-  // options contains "baseWorkingDir"
+  // options contains the state of FtpConnection
   return make_unique<FtpNegotiationCommand>(
       getCuid(), getRequest(), getFileEntry(), getRequestGroup(),
       getDownloadEngine(), pooledSocket,
@@ -76,6 +76,7 @@
 #include "SocketRecvBuffer.h"
 #include "NullProgressInfoFile.h"
 #include "ChecksumCheckIntegrityEntry.h"
+#include "A2STR.h"
 
 namespace aria2 {
 
@@ -83,7 +84,7 @@ FtpNegotiationCommand::FtpNegotiationCommand(
     cuid_t cuid, const std::shared_ptr<Request>& req,
     const std::shared_ptr<FileEntry>& fileEntry, RequestGroup* requestGroup,
     DownloadEngine* e, const std::shared_ptr<SocketCore>& socket, Seq seq,
-    const std::string& baseWorkingDir)
+    const std::string& poolOptions)
     : AbstractCommand(cuid, req, fileEntry, requestGroup, e, socket),
       sequence_(seq),
       ftp_(std::make_shared<FtpConnection>(
@@ -91,9 +92,11 @@ FtpNegotiationCommand::FtpNegotiationCommand(
           e->getAuthConfigFactory()->createAuthConfig(
               req, requestGroup->getOption().get()),
           getOption().get())),
-      pasvPort_(0)
+      pasvPort_(0),
+      pipelining_(getOption()->getAsBool(PREF_FTP_PIPELINING)),
+      retype_(false)
 {
-  ftp_->setBaseWorkingDir(baseWorkingDir);
+  ftp_->setPoolOptions(poolOptions);
   if (seq == SEQ_RECV_GREETING) {
     setTimeout(
         std::chrono::seconds(getOption()->getAsInt(PREF_CONNECT_TIMEOUT)));
@@ -228,6 +231,12 @@ bool FtpNegotiationCommand::recvPass()
 
 bool FtpNegotiationCommand::sendType()
 {
+  if (pipelining_ && !retype_) {
+    queueCommand(SEQ_SEND_TYPE, nullptr);
+    queueCommand(SEQ_SEND_PWD, nullptr);
+    sequence_ = SEQ_SEND_PIPELINE;
+    return true;
+  }
   if (ftp_->sendType()) {
     disableWriteCheckSocket();
     sequence_ = SEQ_RECV_TYPE;
@@ -248,7 +257,16 @@ bool FtpNegotiationCommand::recvType()
     throw DL_ABORT_EX2(fmt(EX_BAD_STATUS, status),
                        error_code::FTP_PROTOCOL_ERROR);
   }
-  sequence_ = SEQ_SEND_PWD;
+  ftp_->setTransferType(ftp_->getRequestedTransferType());
+  if (retype_) {
+    // The working directory is not the base working directory
+    // anymore, so don't send PWD.
+    retype_ = false;
+    sequence_ = SEQ_SEND_CWD_PREP;
+  }
+  else {
+    sequence_ = SEQ_SEND_PWD;
+  }
   return true;
 }
 
@@ -286,13 +304,56 @@ bool FtpNegotiationCommand::sendCwdPrep()
 {
   // Calling setReadCheckSocket() is needed when the socket is reused,
   setReadCheckSocket(getSocket());
-  cwdDirs_.push_front(ftp_->getBaseWorkingDir());
-  util::split(getRequest()->getDir().begin(), getRequest()->getDir().end(),
-              std::back_inserter(cwdDirs_), '/');
-  sequence_ = SEQ_SEND_CWD;
+  if (ftp_->getTransferType() != ftp_->getRequestedTransferType()) {
+    // The connection was pooled by a download which used the other
+    // transfer type.
+    retype_ = true;
+    sequence_ = SEQ_SEND_TYPE;
+    return true;
+  }
+  if (ftp_->getWorkingDir() == getRequest()->getDir()) {
+    A2_LOG_DEBUG(fmt("CUID#%" PRId64 " - Already in '%s'. CWD is skipped.",
+                     getCuid(), getRequest()->getDir().c_str()));
+  }
+  else {
+    // The working directory is unknown until all CWD commands
+    // succeed.
+    ftp_->setWorkingDir(A2STR::NIL);
+    cwdDirs_.push_front(ftp_->getBaseWorkingDir());
+    util::split(getRequest()->getDir().begin(), getRequest()->getDir().end(),
+                std::back_inserter(cwdDirs_), '/');
+  }
+  if (pipelining_) {
+    for (const auto& dir : cwdDirs_) {
+      ftp_->queueCwd(dir);
+      pipeline_.push_back(SEQ_SEND_CWD);
+    }
+    if (mdtmNeeded()) {
+      queueCommand(SEQ_SEND_MDTM, nullptr);
+    }
+    queueCommand(SEQ_SEND_SIZE, nullptr);
+    sequence_ = SEQ_SEND_PIPELINE;
+  }
+  else if (!cwdDirs_.empty()) {
+    sequence_ = SEQ_SEND_CWD;
+  }
+  else if (mdtmNeeded()) {
+    sequence_ = SEQ_SEND_MDTM;
+  }
+  else {
+    sequence_ = SEQ_SEND_SIZE;
+  }
   return true;
 }
 
+bool FtpNegotiationCommand::mdtmNeeded() const
+{
+  // The timestamp is already known if another connection has
+  // retrieved it.
+  return getOption()->getAsBool(PREF_REMOTE_TIME) &&
+         !getRequestGroup()->getLastModifiedTime().good();
+}
+
 bool FtpNegotiationCommand::sendCwd()
 {
   if (ftp_->sendCwd(cwdDirs_.front())) {
@@ -323,7 +384,12 @@ bool FtpNegotiationCommand::recvCwd()
   }
   cwdDirs_.pop_front();
   if (cwdDirs_.empty()) {
-    if (getOption()->getAsBool(PREF_REMOTE_TIME)) {
+    ftp_->setWorkingDir(getRequest()->getDir());
+    if (!pipeline_.empty()) {
+      // Whether MDTM was sent or not has already been decided.
+      sequence_ = pipeline_.front();
+    }
+    else if (mdtmNeeded()) {
       sequence_ = SEQ_SEND_MDTM;
     }
     else {
@@ -833,6 +899,12 @@ bool FtpNegotiationCommand::sendRestPasv(
 
 bool FtpNegotiationCommand::sendRest(const std::shared_ptr<Segment>& segment)
 {
+  if (pipelining_) {
+    queueCommand(SEQ_SEND_REST, segment);
+    queueCommand(SEQ_SEND_RETR, nullptr);
+    sequence_ = SEQ_SEND_PIPELINE;
+    return true;
+  }
   if (ftp_->sendRest(segment)) {
     disableWriteCheckSocket();
     sequence_ = SEQ_RECV_REST;
@@ -909,10 +981,81 @@ bool FtpNegotiationCommand::waitConnection()
   return false;
 }
 
+bool FtpNegotiationCommand::sendPipeline()
+{
+  if (ftp_->sendPendingData()) {
+    disableWriteCheckSocket();
+    sequence_ = pipeline_.front();
+  }
+  else {
+    setWriteCheckSocket(getSocket());
+  }
+  return false;
+}
+
+void FtpNegotiationCommand::queueCommand(
+    Seq seq, const std::shared_ptr<Segment>& segment)
+{
+  switch (seq) {
+  case SEQ_SEND_TYPE:
+    ftp_->queueType();
+    break;
+  case SEQ_SEND_PWD:
+    ftp_->queuePwd();
+    break;
+  case SEQ_SEND_MDTM:
+    ftp_->queueMdtm();
+    break;
+  case SEQ_SEND_SIZE:
+    ftp_->queueSize();
+    break;
+  case SEQ_SEND_REST:
+    ftp_->queueRest(segment);
+    break;
+  case SEQ_SEND_RETR:
+    ftp_->queueRetr();
+    break;
+  default:
+    assert(0);
+  }
+  pipeline_.push_back(seq);
+}
+
+namespace {
+FtpNegotiationCommand::Seq
+getRecvSequence(FtpNegotiationCommand::Seq sendSeq)
+{
+  switch (sendSeq) {
+  case FtpNegotiationCommand::SEQ_SEND_TYPE:
+    return FtpNegotiationCommand::SEQ_RECV_TYPE;
+  case FtpNegotiationCommand::SEQ_SEND_PWD:
+    return FtpNegotiationCommand::SEQ_RECV_PWD;
+  case FtpNegotiationCommand::SEQ_SEND_CWD:
+    return FtpNegotiationCommand::SEQ_RECV_CWD;
+  case FtpNegotiationCommand::SEQ_SEND_MDTM:
+    return FtpNegotiationCommand::SEQ_RECV_MDTM;
+  case FtpNegotiationCommand::SEQ_SEND_SIZE:
+    return FtpNegotiationCommand::SEQ_RECV_SIZE;
+  case FtpNegotiationCommand::SEQ_SEND_REST:
+    return FtpNegotiationCommand::SEQ_RECV_REST;
+  case FtpNegotiationCommand::SEQ_SEND_RETR:
+    return FtpNegotiationCommand::SEQ_RECV_RETR;
+  default:
+    assert(0);
+    return sendSeq;
+  }
+}
+} // namespace
+
 bool FtpNegotiationCommand::processSequence(
     const std::shared_ptr<Segment>& segment)
 {
   bool doNextSequence = true;
+  if (!pipeline_.empty() && sequence_ == pipeline_.front()) {
+    // The command has already been sent.  Wait for its response.
+    pipeline_.pop_front();
+    sequence_ = getRecvSequence(sequence_);
+  }
   switch (sequence_) {
   case SEQ_RECV_GREETING:
     return recvGreeting();
@@ -988,6 +1131,8 @@ bool FtpNegotiationCommand::processSequence(
     return recvRetr();
   case SEQ_WAIT_CONNECTION:
     return waitConnection();
+  case SEQ_SEND_PIPELINE:
+    return sendPipeline();
   default:
     abort();
   }
@@ -996,11 +1141,13 @@ bool FtpNegotiationCommand::processSequence(
 
 void FtpNegotiationCommand::poolConnection() const
 {
-  if (getOption()->getAsBool(PREF_FTP_REUSE_CONNECTION)) {
-    // Store ftp_->getBaseWorkingDir() as options
+  // If responses to pipelined commands are still on their way, the
+  // connection cannot be reused.
+  if (getOption()->getAsBool(PREF_FTP_REUSE_CONNECTION) &&
+      pipeline_.empty()) {
     getDownloadEngine()->poolSocket(getRequest(), ftp_->getUser(),
                                     createProxyRequest(), getSocket(),
-                                    ftp_->getBaseWorkingDir());
+                                    ftp_->getPoolOptions());
   }
 }
 
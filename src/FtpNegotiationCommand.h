@@ -90,6 +90,7 @@ public:
     SEQ_HEAD_OK,
     SEQ_DOWNLOAD_ALREADY_COMPLETED,
     SEQ_FILE_PREPARATION, // File allocation after SIZE command
+    SEQ_SEND_PIPELINE,    // Sends the commands queued in pipeline_
     SEQ_EXIT
   };
 
@@ -132,8 +133,16 @@ private:
   bool sendRetr();
   bool recvRetr();
   bool waitConnection();
+  bool sendPipeline();
   bool processSequence(const std::shared_ptr<Segment>& segment);
 
+  // Queues the command of |seq| to ftp_ and appends |seq| to
+  // pipeline_.
+  void queueCommand(Seq seq, const std::shared_ptr<Segment>& segment);
+
+  // Returns true if MDTM command has to be sent.
+  bool mdtmNeeded() const;
+
   void afterFileAllocation();
 
   void poolConnection() const;
@@ -155,6 +164,19 @@ private:
 
   std::deque<std::string> cwdDirs_;
 
+  // The SEND states of the commands which were sent in a batch and
+  // whose responses have not been received yet, in the order they
+  // were sent.  When the state machine reaches the first one, it goes
+  // directly to the corresponding RECV state.
+  std::deque<Seq> pipeline_;
+
+  bool pipelining_;
+
+  // true if TYPE command is sent on a pooled connection, because the
+  // transfer type of the connection is different from the requested
+  // one.
+  bool retype_;
+
 protected:
   virtual bool executeInternal() CXX11_OVERRIDE;
 
@@ -164,7 +186,7 @@ public:
                         RequestGroup* requestGroup, DownloadEngine* e,
                         const std::shared_ptr<SocketCore>& s,
                         Seq seq = SEQ_RECV_GREETING,
-                        const std::string& baseWorkingDir = "/");
+                        const std::string& poolOptions = "/");
   virtual ~FtpNegotiationCommand();
 };
 
@@ -0,0 +1,523 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "Http2Session.h"
+
+#include <cstring>
+#include <algorithm>
+
+#include "SocketCore.h"
+#include "HttpHeader.h"
+#include "Command.h"
+#include "DlAbortEx.h"
+#include "DlRetryEx.h"
+#include "LogFactory.h"
+#include "Logger.h"
+#include "message.h"
+#include "util.h"
+#include "fmt.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+namespace {
+// Per stream flow control window.  The default 64KiB window limits
+// throughput of a stream to 64KiB per round trip.
+constexpr int32_t STREAM_WINDOW_SIZE = 1_m;
+// Connection flow control window, shared by all streams.
+constexpr int32_t CONNECTION_WINDOW_SIZE = 16_m;
+// The maximum number of bytes read from the socket in one call of
+// Http2Session::recv().
+constexpr size_t MAX_RECV_PER_CALL = 256_k;
+} // namespace
+
+Http2Stream::Http2Stream(Http2Session* session, int32_t streamId)
+    : session_(session),
+      streamId_(streamId),
+      header_(make_unique<HttpHeader>()),
+      headerReceived_(false),
+      bufPos_(0),
+      closed_(false),
+      errorCode_(NGHTTP2_NO_ERROR),
+      command_(nullptr)
+{
+  header_->setVersion("HTTP/2");
+}
+
+Http2Stream::~Http2Stream()
+{
+  if (session_) {
+    session_->removeStream(streamId_);
+  }
+}
+
+std::unique_ptr<HttpHeader> Http2Stream::popResponseHeader()
+{
+  if (!headerReceived_) {
+    return nullptr;
+  }
+  return std::move(header_);
+}
+
+size_t Http2Stream::readData(unsigned char* data, size_t len)
+{
+  len = std::min(len, getBufferedLength());
+  if (len == 0) {
+    return 0;
+  }
+  memcpy(data, buf_.data() + bufPos_, len);
+  bufPos_ += len;
+  if (bufPos_ == buf_.size()) {
+    buf_.clear();
+    bufPos_ = 0;
+  }
+  else if (bufPos_ >= 64_k && bufPos_ >= buf_.size() / 2) {
+    buf_.erase(0, bufPos_);
+    bufPos_ = 0;
+  }
+  if (session_) {
+    session_->consume(streamId_, len);
+  }
+  return len;
+}
+
+bool Http2Stream::readable() const
+{
+  return (headerReceived_ && header_) || getBufferedLength() > 0 || closed_;
+}
+
+void Http2Stream::onHeader(const std::string& name, const std::string& value)
+{
+  if (headerReceived_) {
+    // Trailer fields are not used.
+    return;
+  }
+  if (name == ":status") {
+    int32_t statusCode;
+    if (util::parseIntNoThrow(statusCode, value)) {
+      header_->setStatusCode(statusCode);
+    }
+    return;
+  }
+  if (util::startsWith(name, ":")) {
+    return;
+  }
+  int hdKey = idInterestingHeader(name.c_str());
+  if (hdKey != HttpHeader::MAX_INTERESTING_HEADER) {
+    header_->put(hdKey, value);
+  }
+}
+
+void Http2Stream::onHeadersComplete()
+{
+  if (headerReceived_) {
+    return;
+  }
+  if (header_->getStatusCode() / 100 == 1) {
+    // Interim response.  Wait for the final one.
+    header_ = make_unique<HttpHeader>();
+    header_->setVersion("HTTP/2");
+    return;
+  }
+  headerReceived_ = true;
+  notify();
+}
+
+void Http2Stream::onData(const uint8_t* data, size_t len)
+{
+  buf_.append(data, data + len);
+  notify();
+}
+
+void Http2Stream::onClose(uint32_t errorCode)
+{
+  closed_ = true;
+  errorCode_ = errorCode;
+  notify();
+}
+
+void Http2Stream::detach()
+{
+  session_ = nullptr;
+  if (!closed_) {
+    onClose(NGHTTP2_INTERNAL_ERROR);
+  }
+}
+
+void Http2Stream::notify()
+{
+  if (command_) {
+    command_->setStatusActive();
+  }
+}
+
+namespace {
+int onHeaderCallback(nghttp2_session* session, const nghttp2_frame* frame,
+                     const uint8_t* name, size_t namelen, const uint8_t* value,
+                     size_t valuelen, uint8_t flags, void* userData)
+{
+  if (frame->hd.type != NGHTTP2_HEADERS) {
+    return 0;
+  }
+  auto stream =
+      static_cast<Http2Session*>(userData)->findStream(frame->hd.stream_id);
+  if (stream) {
+    stream->onHeader(std::string(name, name + namelen),
+                     std::string(value, value + valuelen));
+  }
+  return 0;
+}
+} // namespace
+
+namespace {
+int onFrameRecvCallback(nghttp2_session* session, const nghttp2_frame* frame,
+                        void* userData)
+{
+  auto h2session = static_cast<Http2Session*>(userData);
+  switch (frame->hd.type) {
+  case NGHTTP2_HEADERS: {
+    auto stream = h2session->findStream(frame->hd.stream_id);
+    if (stream) {
+      stream->onHeadersComplete();
+    }
+    break;
+  }
+  case NGHTTP2_GOAWAY:
+    A2_LOG_INFO("HTTP/2: GOAWAY received");
+    h2session->onGoaway();
+    break;
+  }
+  return 0;
+}
+} // namespace
+
+namespace {
+int onDataChunkRecvCallback(nghttp2_session* session, uint8_t flags,
+                            int32_t streamId, const uint8_t* data, size_t len,
+                            void* userData)
+{
+  auto stream = static_cast<Http2Session*>(userData)->findStream(streamId);
+  if (stream) {
+    stream->onData(data, len);
+  }
+  else {
+    // Nobody reads the stream any longer.  Just give back the
+    // window.
+    nghttp2_session_consume(session, streamId, len);
+  }
+  return 0;
+}
+} // namespace
+
+namespace {
+int onStreamCloseCallback(nghttp2_session* session, int32_t streamId,
+                          uint32_t errorCode, void* userData)
+{
+  static_cast<Http2Session*>(userData)->onStreamClose(streamId, errorCode);
+  return 0;
+}
+} // namespace
+
+Http2Session::Http2Session(std::shared_ptr<SocketCore> socket)
+    : socket_(std::move(socket)),
+      session_(nullptr),
+      numActiveStreams_(0),
+      goawayReceived_(false),
+      command_(nullptr)
+{
+  nghttp2_session_callbacks* callbacks;
+  if (nghttp2_session_callbacks_new(&callbacks) != 0) {
+    throw DL_ABORT_EX("HTTP/2: could not allocate callbacks");
+  }
+  auto callbacksDeleter = defer(callbacks, nghttp2_session_callbacks_del);
+  nghttp2_session_callbacks_set_on_header_callback(callbacks,
+                                                   onHeaderCallback);
+  nghttp2_session_callbacks_set_on_frame_recv_callback(callbacks,
+                                                       onFrameRecvCallback);
+  nghttp2_session_callbacks_set_on_data_chunk_recv_callback(
+      callbacks, onDataChunkRecvCallback);
+  nghttp2_session_callbacks_set_on_stream_close_callback(
+      callbacks, onStreamCloseCallback);
+
+  nghttp2_option* option;
+  if (nghttp2_option_new(&option) != 0) {
+    throw DL_ABORT_EX("HTTP/2: could not allocate option");
+  }
+  auto optionDeleter = defer(option, nghttp2_option_del);
+  // Window is given back when the owner of a stream reads the data,
+  // rather than when it is received, so that a slow consumer does not
+  // make us buffer without bound.
+  nghttp2_option_set_no_auto_window_update(option, 1);
+
+  int rv = nghttp2_session_client_new2(&session_, callbacks, this, option);
+  if (rv != 0) {
+    throw DL_ABORT_EX(
+        fmt("HTTP/2: could not create session: %s", nghttp2_strerror(rv)));
+  }
+  nghttp2_settings_entry iv[] = {
+      {NGHTTP2_SETTINGS_ENABLE_PUSH, 0},
+      {NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE, STREAM_WINDOW_SIZE},
+  };
+  rv = nghttp2_submit_settings(session_, NGHTTP2_FLAG_NONE, iv,
+                               sizeof(iv) / sizeof(iv[0]));
+  if (rv == 0) {
+    rv = nghttp2_session_set_local_window_size(session_, NGHTTP2_FLAG_NONE, 0,
+                                               CONNECTION_WINDOW_SIZE);
+  }
+  if (rv != 0) {
+    nghttp2_session_del(session_);
+    throw DL_ABORT_EX(
+        fmt("HTTP/2: could not submit SETTINGS: %s", nghttp2_strerror(rv)));
+  }
+}
+
+Http2Session::~Http2Session()
+{
+  close();
+  nghttp2_session_del(session_);
+}
+
+std::vector<std::pair<std::string, std::string>>
+Http2Session::createHeaderBlock(const std::string& request,
+                                const std::string& scheme)
+{
+  std::string method, path, authority;
+  std::vector<std::pair<std::string, std::string>> fields;
+  auto eol = request.find("\r\n");
+  auto requestLine = request.substr(0, eol);
+  auto sp1 = requestLine.find(' ');
+  auto sp2 = requestLine.rfind(' ');
+  if (sp1 != std::string::npos && sp1 < sp2) {
+    method = requestLine.substr(0, sp1);
+    path = requestLine.substr(sp1 + 1, sp2 - sp1 - 1);
+  }
+  for (auto pos = eol; pos != std::string::npos && pos + 2 < request.size();) {
+    pos += 2;
+    eol = request.find("\r\n", pos);
+    auto line = request.substr(pos, eol - pos);
+    pos = eol;
+    auto colon = line.find(':');
+    if (colon == std::string::npos) {
+      continue;
+    }
+    auto name = line.substr(0, colon);
+    util::lowercase(name);
+    auto value = util::strip(line.substr(colon + 1));
+    if (name == "host") {
+      authority = value;
+    }
+    else if (name != "connection" && name != "keep-alive" &&
+             name != "proxy-connection" && name != "transfer-encoding" &&
+             name != "upgrade" && name != "te") {
+      fields.emplace_back(std::move(name), std::move(value));
+    }
+  }
+  std::vector<std::pair<std::string, std::string>> nva{
+      {":method", method},
+      {":scheme", scheme},
+      {":authority", authority},
+      {":path", path}};
+  std::move(std::begin(fields), std::end(fields), std::back_inserter(nva));
+  return nva;
+}
+
+std::shared_ptr<Http2Stream>
+Http2Session::submitRequest(const std::string& request,
+                            const std::string& scheme)
+{
+  auto headers = createHeaderBlock(request, scheme);
+  std::vector<nghttp2_nv> nva;
+  nva.reserve(headers.size());
+  for (auto& hd : headers) {
+    nva.push_back({reinterpret_cast<uint8_t*>(&hd.first[0]),
+                   reinterpret_cast<uint8_t*>(&hd.second[0]), hd.first.size(),
+                   hd.second.size(), NGHTTP2_NV_FLAG_NONE});
+  }
+  auto streamId = nghttp2_submit_request(session_, nullptr, nva.data(),
+                                         nva.size(), nullptr, nullptr);
+  if (streamId < 0) {
+    throw DL_ABORT_EX(fmt("HTTP/2: could not submit request: %s",
+                          nghttp2_strerror(streamId)));
+  }
+  auto stream = std::make_shared<Http2Stream>(this, streamId);
+  streams_[streamId] = stream.get();
+  ++numActiveStreams_;
+  signalWrite();
+  return stream;
+}
+
+size_t Http2Session::recv()
+{
+  unsigned char buf[16_k];
+  size_t total = 0;
+  while (total < MAX_RECV_PER_CALL) {
+    size_t len = sizeof(buf);
+    socket_->readData(buf, len);
+    if (len == 0) {
+      if (socket_->wantRead() || socket_->wantWrite()) {
+        break;
+      }
+      throw DL_RETRY_EX(EX_GOT_EOF);
+    }
+    auto rv = nghttp2_session_mem_recv(session_, buf, len);
+    if (rv < 0) {
+      throw DL_RETRY_EX(fmt("HTTP/2: %s", nghttp2_strerror(rv)));
+    }
+    total += len;
+  }
+  return total;
+}
+
+void Http2Session::send()
+{
+  if (!sendBuf_.empty()) {
+    auto n = socket_->writeData(sendBuf_.data(), sendBuf_.size());
+    sendBuf_.erase(0, n);
+    if (!sendBuf_.empty()) {
+      return;
+    }
+  }
+  for (;;) {
+    const uint8_t* data;
+    auto len = nghttp2_session_mem_send(session_, &data);
+    if (len < 0) {
+      throw DL_RETRY_EX(fmt("HTTP/2: %s", nghttp2_strerror(len)));
+    }
+    if (len == 0) {
+      return;
+    }
+    auto n = socket_->writeData(data, len);
+    if (n < len) {
+      sendBuf_.append(data + n, data + len);
+      return;
+    }
+  }
+}
+
+bool Http2Session::wantWrite()
+{
+  return !sendBuf_.empty() || nghttp2_session_want_write(session_);
+}
+
+bool Http2Session::isActive()
+{
+  return nghttp2_session_want_read(session_) ||
+         nghttp2_session_want_write(session_) || !sendBuf_.empty();
+}
+
+bool Http2Session::canSubmitRequest()
+{
+  return !goawayReceived_ &&
+         numActiveStreams_ <
+             nghttp2_session_get_remote_settings(
+                 session_, NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS);
+}
+
+void Http2Session::terminate()
+{
+  nghttp2_session_terminate_session(session_, NGHTTP2_NO_ERROR);
+  signalWrite();
+}
+
+void Http2Session::close()
+{
+  for (auto& elem : streams_) {
+    elem.second->detach();
+  }
+  streams_.clear();
+  numActiveStreams_ = 0;
+  goawayReceived_ = true;
+}
+
+void Http2Session::consume(int32_t streamId, size_t len)
+{
+  nghttp2_session_consume(session_, streamId, len);
+  if (nghttp2_session_want_write(session_)) {
+    signalWrite();
+  }
+}
+
+void Http2Session::removeStream(int32_t streamId)
+{
+  auto i = streams_.find(streamId);
+  if (i == std::end(streams_)) {
+    return;
+  }
+  // Nobody reads the data buffered in the stream any longer.  Give
+  // back its window, or the connection window runs out after a few
+  // streams are cancelled.
+  auto len = (*i).second->getBufferedLength();
+  if (len > 0) {
+    consume(streamId, len);
+  }
+  if (!(*i).second->isClosed()) {
+    nghttp2_submit_rst_stream(session_, NGHTTP2_FLAG_NONE, streamId,
+                              NGHTTP2_CANCEL);
+    signalWrite();
+  }
+  streams_.erase(i);
+}
+
+Http2Stream* Http2Session::findStream(int32_t streamId) const
+{
+  auto i = streams_.find(streamId);
+  if (i == std::end(streams_)) {
+    return nullptr;
+  }
+  return (*i).second;
+}
+
+void Http2Session::onStreamClose(int32_t streamId, uint32_t errorCode)
+{
+  if (numActiveStreams_ > 0) {
+    --numActiveStreams_;
+  }
+  auto stream = findStream(streamId);
+  if (stream) {
+    if (errorCode != NGHTTP2_NO_ERROR) {
+      A2_LOG_INFO(fmt("HTTP/2: stream %d closed with error code %u", streamId,
+                      errorCode));
+    }
+    stream->onClose(errorCode);
+  }
+}
+
+void Http2Session::signalWrite()
+{
+  if (command_) {
+    command_->setStatusActive();
+  }
+}
+
+} // namespace aria2
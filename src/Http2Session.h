@@ -0,0 +1,216 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_HTTP2_SESSION_H
+#define D_HTTP2_SESSION_H
+
+#include "common.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+
+#include <nghttp2/nghttp2.h>
+
+namespace aria2 {
+
+class SocketCore;
+class HttpHeader;
+class Command;
+class Http2Session;
+
+// A request/response exchange over Http2Session.  The response
+// header and body received for the stream are buffered here until
+// the owner of the stream reads them.  Destroying a stream which has
+// not been closed resets it.
+class Http2Stream {
+public:
+  Http2Stream(Http2Session* session, int32_t streamId);
+  ~Http2Stream();
+
+  Http2Stream(const Http2Stream&) = delete;
+  Http2Stream& operator=(const Http2Stream&) = delete;
+
+  int32_t getStreamId() const { return streamId_; }
+
+  // Returns true if the final response header has been received.
+  bool responseHeaderReceived() const { return headerReceived_; }
+
+  // Returns the final response header and gives up its ownership.
+  // Returns nullptr if it has not been received yet, or it has
+  // already been popped.
+  std::unique_ptr<HttpHeader> popResponseHeader();
+
+  // Copies at most |len| bytes of the buffered response body to
+  // |data| and returns the number of bytes copied.  The copied bytes
+  // are given back to the flow control window of the stream.
+  size_t readData(unsigned char* data, size_t len);
+
+  size_t getBufferedLength() const { return buf_.size() - bufPos_; }
+
+  // Returns true if the remote endpoint will not send any more data
+  // for this stream.
+  bool isClosed() const { return closed_; }
+
+  // Returns the error code the stream was closed with.  This is
+  // NGHTTP2_NO_ERROR if the stream was closed normally.
+  uint32_t getErrorCode() const { return errorCode_; }
+
+  // Returns true if the owner of the stream has something to process:
+  // the response header, response body or the end of stream.
+  bool readable() const;
+
+  // Sets the command which is woken up when the stream becomes
+  // readable.
+  void setCommand(Command* command) { command_ = command; }
+
+  // The following functions are called by Http2Session.
+  void onHeader(const std::string& name, const std::string& value);
+  void onHeadersComplete();
+  void onData(const uint8_t* data, size_t len);
+  void onClose(uint32_t errorCode);
+  void detach();
+
+private:
+  void notify();
+
+  Http2Session* session_;
+  int32_t streamId_;
+  std::unique_ptr<HttpHeader> header_;
+  bool headerReceived_;
+  // Response body received but not read yet starts at buf_[bufPos_].
+  std::string buf_;
+  size_t bufPos_;
+  bool closed_;
+  uint32_t errorCode_;
+  Command* command_;
+};
+
+// HTTP/2 client session over a connected SocketCore.  Many streams
+// are multiplexed over the connection.  Http2SessionCommand drives
+// I/O of the session.
+class Http2Session {
+public:
+  // The connection preface is queued in the constructor.  Throws
+  // DlAbortEx if nghttp2 could not be initialized.
+  Http2Session(std::shared_ptr<SocketCore> socket);
+  ~Http2Session();
+
+  Http2Session(const Http2Session&) = delete;
+  Http2Session& operator=(const Http2Session&) = delete;
+
+  // Opens a new stream which sends |request|, an HTTP/1.1 request
+  // header as created by HttpRequest::createRequest().  Throws
+  // DlAbortEx on error.  The request is actually sent when send() is
+  // called next time.
+  std::shared_ptr<Http2Stream> submitRequest(const std::string& request,
+                                             const std::string& scheme);
+
+  // Reads data from the socket and processes it.  Returns the number
+  // of bytes read.  Throws DlRetryEx if the connection was closed or
+  // a protocol error occurred.
+  size_t recv();
+
+  // Sends queued frames as much as the socket accepts.  Throws
+  // DlRetryEx on error.
+  void send();
+
+  // Returns true if there are frames which have not been sent yet.
+  bool wantWrite();
+
+  // Returns true if nghttp2 wants to exchange more frames with the
+  // remote endpoint.  It is false after GOAWAY was exchanged and all
+  // streams were closed.
+  bool isActive();
+
+  // Returns true if a new stream can be opened without exceeding
+  // SETTINGS_MAX_CONCURRENT_STREAMS of the remote endpoint.
+  bool canSubmitRequest();
+
+  // Returns the number of streams which have not been closed.
+  size_t getNumActiveStreams() const { return numActiveStreams_; }
+
+  // Queues GOAWAY to close the connection gracefully.
+  void terminate();
+
+  // Detaches all streams, marking them as closed with
+  // NGHTTP2_INTERNAL_ERROR, and wakes up their commands.  The
+  // session can no longer be used.
+  void close();
+
+  // Sets the command which drives I/O of this session.  It is woken
+  // up when there are frames to send.
+  void setCommand(Command* command) { command_ = command; }
+
+  const std::shared_ptr<SocketCore>& getSocket() const { return socket_; }
+
+  // Gives back |len| bytes to the flow control window of the stream
+  // |streamId| and the connection.
+  void consume(int32_t streamId, size_t len);
+
+  // Resets the stream |streamId| with NGHTTP2_CANCEL if it is open
+  // and forgets it.  The window taken by the data buffered in the
+  // stream is given back.
+  void removeStream(int32_t streamId);
+
+  Http2Stream* findStream(int32_t streamId) const;
+
+  void onStreamClose(int32_t streamId, uint32_t errorCode);
+
+  void onGoaway() { goawayReceived_ = true; }
+
+  // Converts |request|, an HTTP/1.1 request header, to the header
+  // list of HTTP/2 request.  The pseudo header fields come first.
+  // Connection specific header fields are dropped.
+  static std::vector<std::pair<std::string, std::string>>
+  createHeaderBlock(const std::string& request, const std::string& scheme);
+
+private:
+  void signalWrite();
+
+  std::shared_ptr<SocketCore> socket_;
+  nghttp2_session* session_;
+  std::map<int32_t, Http2Stream*> streams_;
+  size_t numActiveStreams_;
+  // Frames produced by nghttp2 which the socket has not accepted
+  // yet.
+  std::string sendBuf_;
+  bool goawayReceived_;
+  Command* command_;
+};
+
+} // namespace aria2
+
+#endif // D_HTTP2_SESSION_H
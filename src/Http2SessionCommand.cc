@@ -0,0 +1,137 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "Http2SessionCommand.h"
+#include "Http2Session.h"
+#include "SocketCore.h"
+#include "DownloadEngine.h"
+#include "RequestGroupMan.h"
+#include "RecoverableException.h"
+#include "Logger.h"
+#include "LogFactory.h"
+#include "wallclock.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+namespace {
+// Same as the default timeout of pooled sockets.
+constexpr auto IDLE_TIMEOUT = 15_s;
+} // namespace
+
+Http2SessionCommand::Http2SessionCommand(
+    cuid_t cuid, DownloadEngine* e,
+    const std::shared_ptr<Http2Session>& session)
+    : Command(cuid),
+      e_(e),
+      session_(session),
+      idleTimer_(global::wallclock()),
+      writeCheck_(false)
+{
+  session_->setCommand(this);
+  e_->addSocketForReadCheck(session_->getSocket(), this);
+  // Send the connection preface and the requests submitted so far.
+  setStatus(Command::STATUS_ONESHOT_REALTIME);
+  e_->setNoWait(true);
+}
+
+Http2SessionCommand::~Http2SessionCommand()
+{
+  e_->deleteSocketForReadCheck(session_->getSocket(), this);
+  if (writeCheck_) {
+    e_->deleteSocketForWriteCheck(session_->getSocket(), this);
+  }
+  e_->removeHttp2Session(session_);
+  session_->setCommand(nullptr);
+  // Streams still open fail and their commands retry.
+  session_->close();
+  session_->getSocket()->closeConnection();
+  e_->setNoWait(true);
+}
+
+void Http2SessionCommand::updateWriteCheck()
+{
+  auto& socket = session_->getSocket();
+  // After send(), frames are left only if the socket blocked.
+  if (session_->wantWrite()) {
+    if (!writeCheck_) {
+      writeCheck_ = true;
+      e_->addSocketForWriteCheck(socket, this);
+    }
+  }
+  else if (writeCheck_) {
+    writeCheck_ = false;
+    e_->deleteSocketForWriteCheck(socket, this);
+  }
+}
+
+bool Http2SessionCommand::execute()
+{
+  if (e_->getRequestGroupMan()->downloadFinished() || e_->isHaltRequested()) {
+    return true;
+  }
+  try {
+    if (session_->recv() > 0) {
+      // Let the commands of streams which received data run without
+      // waiting for the next event.
+      e_->setNoWait(true);
+    }
+    session_->send();
+    if (!session_->isActive()) {
+      A2_LOG_INFO(fmt("CUID#%" PRId64 " - HTTP/2 session finished",
+                      getCuid()));
+      return true;
+    }
+    if (session_->getNumActiveStreams() > 0) {
+      idleTimer_ = global::wallclock();
+    }
+    else if (idleTimer_.difference(global::wallclock()) >= IDLE_TIMEOUT) {
+      A2_LOG_INFO(fmt("CUID#%" PRId64 " - Closing idle HTTP/2 session",
+                      getCuid()));
+      session_->terminate();
+      session_->send();
+      return true;
+    }
+    updateWriteCheck();
+    e_->addCommand(std::unique_ptr<Command>(this));
+    return false;
+  }
+  catch (RecoverableException& e) {
+    A2_LOG_INFO_EX(fmt("CUID#%" PRId64 " - HTTP/2 session error", getCuid()),
+                   e);
+    return true;
+  }
+}
+
+} // namespace aria2
@@ -58,13 +58,18 @@
 #include "fmt.h"
 #include "SocketRecvBuffer.h"
 #include "array_fun.h"
+#ifdef HAVE_LIBNGHTTP2
+#  include "Http2Session.h"
+#endif // HAVE_LIBNGHTTP2
 
 namespace aria2 {
 
-HttpRequestEntry::HttpRequestEntry(std::unique_ptr<HttpRequest> httpRequest)
+HttpRequestEntry::HttpRequestEntry(std::unique_ptr<HttpRequest> httpRequest,
+                                   cuid_t cuid)
     : httpRequest_{std::move(httpRequest)},
       proc_{
-          make_unique<HttpHeaderProcessor>(HttpHeaderProcessor::CLIENT_PARSER)}
+          make_unique<HttpHeaderProcessor>(HttpHeaderProcessor::CLIENT_PARSER)},
+      cuid_{cuid}
 {
 }
 
@@ -84,13 +89,23 @@ HttpRequestEntry::getHttpHeaderProcessor() const
   return proc_;
 }
 
+#ifdef HAVE_LIBNGHTTP2
+void HttpRequestEntry::setHttp2Stream(std::shared_ptr<Http2Stream> stream)
+{
+  stream_ = std::move(stream);
+}
+#endif // HAVE_LIBNGHTTP2
+
 HttpConnection::HttpConnection(
     cuid_t cuid, const std::shared_ptr<SocketCore>& socket,
     const std::shared_ptr<SocketRecvBuffer>& socketRecvBuffer)
     : cuid_(cuid),
       socket_(socket),
       socketRecvBuffer_(socketRecvBuffer),
-      socketBuffer_(socket)
+      socketBuffer_(socket),
+      bodyOwner_(0),
+      receivingBody_(false),
+      broken_(false)
 {
 }
 
@@ -123,26 +138,38 @@ std::string HttpConnection::eraseConfidentialInfo(const std::string& request)
 }
 
 void HttpConnection::sendRequest(std::unique_ptr<HttpRequest> httpRequest,
-                                 std::string request)
+                                 std::string request, cuid_t cuid)
 {
   A2_LOG_INFO(
-      fmt(MSG_SENDING_REQUEST, cuid_, eraseConfidentialInfo(request).c_str()));
+      fmt(MSG_SENDING_REQUEST, cuid, eraseConfidentialInfo(request).c_str()));
   socketBuffer_.pushStr(std::move(request));
   socketBuffer_.send();
   outstandingHttpRequests_.push_back(
-      make_unique<HttpRequestEntry>(std::move(httpRequest)));
+      make_unique<HttpRequestEntry>(std::move(httpRequest), cuid));
 }
 
 void HttpConnection::sendRequest(std::unique_ptr<HttpRequest> httpRequest)
 {
+  sendRequest(std::move(httpRequest), cuid_);
+}
+
+void HttpConnection::sendRequest(std::unique_ptr<HttpRequest> httpRequest,
+                                 cuid_t cuid)
+{
+#ifdef HAVE_LIBNGHTTP2
+  if (http2Session_) {
+    sendHttp2Request(std::move(httpRequest));
+    return;
+  }
+#endif // HAVE_LIBNGHTTP2
   auto req = httpRequest->createRequest();
-  sendRequest(std::move(httpRequest), std::move(req));
+  sendRequest(std::move(httpRequest), std::move(req), cuid);
 }
 
 void HttpConnection::sendProxyRequest(std::unique_ptr<HttpRequest> httpRequest)
 {
   auto req = httpRequest->createProxyRequest();
-  sendRequest(std::move(httpRequest), std::move(req));
+  sendRequest(std::move(httpRequest), std::move(req), cuid_);
 }
 
 std::unique_ptr<HttpResponse> HttpConnection::receiveResponse()
@@ -150,9 +177,13 @@ std::unique_ptr<HttpResponse> HttpConnection::receiveResponse()
   if (outstandingHttpRequests_.empty()) {
     throw DL_ABORT_EX(EX_NO_HTTP_REQUEST_ENTRY_FOUND);
   }
+#ifdef HAVE_LIBNGHTTP2
+  if (http2Session_) {
+    return receiveHttp2Response();
+  }
+#endif // HAVE_LIBNGHTTP2
   if (socketRecvBuffer_->bufferEmpty()) {
-    if (socketRecvBuffer_->recv() == 0 && !socket_->wantRead() &&
-        !socket_->wantWrite()) {
+    if (socketRecvBuffer_->recv() == 0 && socketRecvBuffer_->eof()) {
       throw DL_RETRY_EX(EX_GOT_EOF);
     }
   }
@@ -170,11 +201,13 @@ std::unique_ptr<HttpResponse> HttpConnection::receiveResponse()
     }
 
     auto httpResponse = make_unique<HttpResponse>();
-    httpResponse->setCuid(cuid_);
+    httpResponse->setCuid(outstandingHttpRequests_.front()->getCuid());
     httpResponse->setHttpHeader(std::move(result));
     httpResponse->setHttpRequest(
         outstandingHttpRequests_.front()->popHttpRequest());
     socketRecvBuffer_->drain(proc->getLastBytesProcessed());
+    bodyOwner_ = outstandingHttpRequests_.front()->getCuid();
+    receivingBody_ = true;
     outstandingHttpRequests_.pop_front();
     return httpResponse;
   }
@@ -183,21 +216,179 @@ std::unique_ptr<HttpResponse> HttpConnection::receiveResponse()
   return nullptr;
 }
 
-bool HttpConnection::isIssued(const std::shared_ptr<Segment>& segment) const
+bool HttpConnection::isIssued(cuid_t cuid,
+                              const std::shared_ptr<Segment>& segment) const
 {
   for (const auto& entry : outstandingHttpRequests_) {
-    if (*entry->getHttpRequest()->getSegment() == *segment) {
+    if (entry->getCuid() != cuid) {
+      continue;
+    }
+    const auto& s = entry->getHttpRequest()->getSegment();
+    if (s && *s == *segment) {
       return true;
     }
   }
   return false;
 }
 
+void HttpConnection::attach(cuid_t cuid) { ++users_[cuid]; }
+
+bool HttpConnection::detach(cuid_t cuid)
+{
+  auto i = users_.find(cuid);
+  if (i == std::end(users_) || --(*i).second > 0) {
+    return false;
+  }
+  users_.erase(i);
+  if (receivingBody_ && bodyOwner_ == cuid) {
+    breakPipeline();
+  }
+  else {
+    for (const auto& entry : outstandingHttpRequests_) {
+      if (entry->getCuid() == cuid) {
+        breakPipeline();
+        break;
+      }
+    }
+  }
+  if (!broken_ || waiters_.empty()) {
+    return false;
+  }
+  for (auto& w : waiters_) {
+    w.second->setStatusActive();
+  }
+  return true;
+}
+
+void HttpConnection::breakPipeline()
+{
+  if (!broken_ && !waiters_.empty()) {
+    A2_LOG_INFO(fmt("CUID#%" PRId64 " - Pipelined requests on this connection"
+                    " are abandoned",
+                    cuid_));
+  }
+  broken_ = true;
+}
+
+bool HttpConnection::canReceiveResponse(cuid_t cuid) const
+{
+  if (receivingBody_) {
+    return bodyOwner_ == cuid;
+  }
+  return outstandingHttpRequests_.empty() ||
+         outstandingHttpRequests_.front()->getCuid() == cuid;
+}
+
+void HttpConnection::waitForResponse(cuid_t cuid, Command* command)
+{
+  waiters_[cuid] = command;
+}
+
+void HttpConnection::cancelWait(Command* command)
+{
+  for (auto i = std::begin(waiters_); i != std::end(waiters_); ++i) {
+    if ((*i).second == command) {
+      waiters_.erase(i);
+      return;
+    }
+  }
+}
+
+bool HttpConnection::endResponse()
+{
+  receivingBody_ = false;
+  if (outstandingHttpRequests_.empty()) {
+    return !broken_;
+  }
+  auto i = waiters_.find(outstandingHttpRequests_.front()->getCuid());
+  if (i != std::end(waiters_)) {
+    (*i).second->setStatusActive();
+  }
+  return false;
+}
+
+bool HttpConnection::canPipeline(size_t maxRequests) const
+{
+  return !broken_ && !isHttp2() &&
+         (receivingBody_ || !outstandingHttpRequests_.empty()) &&
+         outstandingHttpRequests_.size() < maxRequests;
+}
+
 bool HttpConnection::sendBufferIsEmpty() const
 {
-  return socketBuffer_.sendBufferIsEmpty();
+  // Frames of HTTP/2 session are sent by Http2SessionCommand.
+  return isHttp2() || socketBuffer_.sendBufferIsEmpty();
+}
+
+void HttpConnection::sendPendingData()
+{
+  if (!isHttp2()) {
+    socketBuffer_.send();
+  }
+}
+
+bool HttpConnection::isHttp2() const
+{
+#ifdef HAVE_LIBNGHTTP2
+  return http2Session_.get();
+#else  // !HAVE_LIBNGHTTP2
+  return false;
+#endif // !HAVE_LIBNGHTTP2
 }
 
-void HttpConnection::sendPendingData() { socketBuffer_.send(); }
+#ifdef HAVE_LIBNGHTTP2
+void HttpConnection::setHttp2Session(std::shared_ptr<Http2Session> session)
+{
+  http2Session_ = std::move(session);
+}
+
+void HttpConnection::sendHttp2Request(std::unique_ptr<HttpRequest> httpRequest)
+{
+  if (!http2Session_->canSubmitRequest()) {
+    throw DL_RETRY_EX("HTTP/2 session cannot accept more streams");
+  }
+  auto req = httpRequest->createRequest();
+  A2_LOG_INFO(
+      fmt(MSG_SENDING_REQUEST, cuid_, eraseConfidentialInfo(req).c_str()));
+  auto stream = http2Session_->submitRequest(
+      req, httpRequest->getRequest()->getProtocol());
+  A2_LOG_DEBUG(fmt("CUID#%" PRId64 " - HTTP/2 stream %d opened", cuid_,
+                   stream->getStreamId()));
+  if (outstandingHttpRequests_.empty()) {
+    // Attach the stream now, so that the command waiting for the
+    // response is woken up when it arrives.
+    socketRecvBuffer_->setHttp2Stream(stream);
+  }
+  auto entry = make_unique<HttpRequestEntry>(std::move(httpRequest), cuid_);
+  entry->setHttp2Stream(std::move(stream));
+  outstandingHttpRequests_.push_back(std::move(entry));
+}
+
+std::unique_ptr<HttpResponse> HttpConnection::receiveHttp2Response()
+{
+  const auto& entry = outstandingHttpRequests_.front();
+  const auto& stream = entry->getHttp2Stream();
+  if (socketRecvBuffer_->getHttp2Stream() != stream) {
+    socketRecvBuffer_->setHttp2Stream(stream);
+  }
+  auto header = stream->popResponseHeader();
+  if (!header) {
+    if (stream->isClosed()) {
+      throw DL_RETRY_EX(EX_GOT_EOF);
+    }
+    return nullptr;
+  }
+  A2_LOG_INFO(fmt(MSG_RECEIVE_RESPONSE, cuid_,
+                  fmt("HTTP/2 %d (stream %d)\n", header->getStatusCode(),
+                      stream->getStreamId())
+                      .c_str()));
+  auto httpResponse = make_unique<HttpResponse>();
+  httpResponse->setCuid(cuid_);
+  httpResponse->setHttpHeader(std::move(header));
+  httpResponse->setHttpRequest(entry->popHttpRequest());
+  outstandingHttpRequests_.pop_front();
+  return httpResponse;
+}
+#endif // HAVE_LIBNGHTTP2
 
 } // namespace aria2
@@ -39,6 +39,7 @@
 
 #include <string>
 #include <deque>
+#include <map>
 #include <memory>
 
 #include "SocketBuffer.h"
@@ -53,14 +54,25 @@ class Option;
 class Segment;
 class SocketCore;
 class SocketRecvBuffer;
+#ifdef HAVE_LIBNGHTTP2
+class Http2Session;
+class Http2Stream;
+#endif // HAVE_LIBNGHTTP2
 
 class HttpRequestEntry {
 private:
   std::unique_ptr<HttpRequest> httpRequest_;
   std::unique_ptr<HttpHeaderProcessor> proc_;
+  // CUID of the download which sent this request.
+  cuid_t cuid_;
+#ifdef HAVE_LIBNGHTTP2
+  std::shared_ptr<Http2Stream> stream_;
+#endif // HAVE_LIBNGHTTP2
 
 public:
-  HttpRequestEntry(std::unique_ptr<HttpRequest> httpRequest);
+  HttpRequestEntry(std::unique_ptr<HttpRequest> httpRequest, cuid_t cuid);
+
+  cuid_t getCuid() const { return cuid_; }
 
   // Resets proc_ by recreating the object.  Thus any object obtained
   // by getHttpRequest() before this call is invalidated.
@@ -74,6 +86,15 @@ public:
   std::unique_ptr<HttpRequest> popHttpRequest();
 
   const std::unique_ptr<HttpHeaderProcessor>& getHttpHeaderProcessor() const;
+
+#ifdef HAVE_LIBNGHTTP2
+  void setHttp2Stream(std::shared_ptr<Http2Stream> stream);
+
+  const std::shared_ptr<Http2Stream>& getHttp2Stream() const
+  {
+    return stream_;
+  }
+#endif // HAVE_LIBNGHTTP2
 };
 
 typedef std::deque<std::unique_ptr<HttpRequestEntry>> HttpRequestEntries;
@@ -87,9 +108,35 @@ private:
 
   HttpRequestEntries outstandingHttpRequests_;
 
+  // Downloads of several RequestGroups may pipeline their requests on
+  // one connection.  Responses are received in the order the requests
+  // were sent, so a download must wait until the responses before its
+  // own are received by the others.
+
+  // The number of live commands of each download using this
+  // connection.
+  std::map<cuid_t, int> users_;
+  // Commands waiting for their turn to receive the response.
+  std::map<cuid_t, Command*> waiters_;
+  // CUID of the download receiving the response body.  Only
+  // meaningful if receivingBody_ is true.
+  cuid_t bodyOwner_;
+  bool receivingBody_;
+  // True if some response can no longer be received because the
+  // download which should receive it has gone.
+  bool broken_;
+
+  void breakPipeline();
+#ifdef HAVE_LIBNGHTTP2
+  std::shared_ptr<Http2Session> http2Session_;
+
+  void sendHttp2Request(std::unique_ptr<HttpRequest> httpRequest);
+  std::unique_ptr<HttpResponse> receiveHttp2Response();
+#endif // HAVE_LIBNGHTTP2
+
   std::string eraseConfidentialInfo(const std::string& request);
   void sendRequest(std::unique_ptr<HttpRequest> httpRequest,
-                   std::string request);
+                   std::string request, cuid_t cuid);
 
 public:
   HttpConnection(cuid_t cuid, const std::shared_ptr<SocketCore>& socket,
@@ -105,6 +152,10 @@ public:
    */
   void sendRequest(std::unique_ptr<HttpRequest> httpRequest);
 
+  // Same as above, but the request is sent on behalf of the download
+  // |cuid|, which may differ from the one created this object.
+  void sendRequest(std::unique_ptr<HttpRequest> httpRequest, cuid_t cuid);
+
   /**
    * Sends Http proxy request using CONNECT method.
    */
@@ -123,7 +174,9 @@ public:
    */
   std::unique_ptr<HttpResponse> receiveResponse();
 
-  bool isIssued(const std::shared_ptr<Segment>& segment) const;
+  // Returns true if the download |cuid| has already sent a request
+  // for |segment|.
+  bool isIssued(cuid_t cuid, const std::shared_ptr<Segment>& segment) const;
 
   bool sendBufferIsEmpty() const;
 
@@ -133,6 +186,57 @@ public:
   {
     return socketRecvBuffer_;
   }
+
+  const std::shared_ptr<SocketCore>& getSocket() const { return socket_; }
+
+  // Commands holding this object call attach() with their CUID on
+  // construction and detach() on destruction.  When the last command
+  // of a download is gone while its response is yet to be received,
+  // the responses of the others cannot be received either.  Then the
+  // connection is broken and the waiting commands are woken up.
+  // detach() returns true if some command was woken up.
+  void attach(cuid_t cuid);
+  bool detach(cuid_t cuid);
+
+  // Returns true if the next response on the connection is the one
+  // to the request sent by the download |cuid|.
+  bool canReceiveResponse(cuid_t cuid) const;
+
+  // Makes |command| of the download |cuid| woken up when
+  // canReceiveResponse(cuid) becomes true or the connection is
+  // broken.
+  void waitForResponse(cuid_t cuid, Command* command);
+
+  // Cancels waitForResponse() for |command|.
+  void cancelWait(Command* command);
+
+  // Tells that the response body was received entirely.  If there are
+  // outstanding requests, the download which sent the oldest one is
+  // woken up.  Returns true if there is no outstanding request and the
+  // connection can be reused for another request.
+  bool endResponse();
+
+  // Returns true if another download can pipeline its request on this
+  // connection: the connection is in use, is not broken and has less
+  // than |maxRequests| outstanding requests.
+  bool canPipeline(size_t maxRequests) const;
+
+  bool isBroken() const { return broken_; }
+
+#ifdef HAVE_LIBNGHTTP2
+  // Makes subsequent requests sent as streams of |session| instead
+  // of over the socket of this connection.  Their response bodies are
+  // read from the stream through the SocketRecvBuffer.
+  void setHttp2Session(std::shared_ptr<Http2Session> session);
+
+  const std::shared_ptr<Http2Session>& getHttp2Session() const
+  {
+    return http2Session_;
+  }
+#endif // HAVE_LIBNGHTTP2
+
+  // Returns true if requests are sent over HTTP/2.
+  bool isHttp2() const;
 };
 
 } // namespace aria2
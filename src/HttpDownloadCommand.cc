@@ -67,14 +67,27 @@ HttpDownloadCommand::HttpDownloadCommand(
       httpResponse_(std::move(httpResponse)),
       httpConnection_(httpConnection)
 {
+  httpConnection_->attach(getCuid());
 }
 
-HttpDownloadCommand::~HttpDownloadCommand() = default;
+HttpDownloadCommand::~HttpDownloadCommand()
+{
+  if (httpConnection_->detach(getCuid())) {
+    getDownloadEngine()->setNoWait(true);
+  }
+}
 
 bool HttpDownloadCommand::prepareForNextSegment()
 {
   bool downloadFinished = getRequestGroup()->downloadFinished();
-  if (getRequest()->isPipeliningEnabled() && !downloadFinished) {
+  // The response to a range request ends with the segment.  Otherwise
+  // the body continues to the end of the file.
+  bool rangeResponse = httpResponse_->getStatusCode() == 206;
+  if (getRequest()->isPipeliningEnabled() && rangeResponse &&
+      !downloadFinished) {
+    if (!httpConnection_->endResponse()) {
+      getDownloadEngine()->setNoWait(true);
+    }
     auto command = make_unique<HttpRequestCommand>(
         getCuid(), getRequest(), getFileEntry(), getRequestGroup(),
         httpConnection_, getDownloadEngine(), getSocket());
@@ -88,8 +101,9 @@ bool HttpDownloadCommand::prepareForNextSegment()
   }
 
   const std::string& streamFilterName = getStreamFilter()->getName();
-  if (getRequest()->isPipeliningEnabled() ||
-      (getRequest()->isKeepAliveEnabled() &&
+  if ((getRequest()->isPipeliningEnabled() && rangeResponse) ||
+      ((getRequest()->isKeepAliveEnabled() ||
+        getRequest()->isPipeliningEnabled()) &&
        (
            // Make sure that all filters are finished to pool socket
            (!util::endsWith(streamFilterName, SinkStreamFilter::NAME) &&
@@ -102,8 +116,15 @@ bool HttpDownloadCommand::prepareForNextSegment()
     // pool terminated socket.  In HTTP/1.1, keep-alive is default,
     // so closing connection without Connection: close header means
     // that server is broken or not configured properly.
-    getDownloadEngine()->poolSocket(getRequest(), createProxyRequest(),
-                                    getSocket());
+    if (httpConnection_->endResponse()) {
+      getDownloadEngine()->poolSocket(getRequest(), createProxyRequest(),
+                                      getSocket());
+    }
+    else {
+      // Hand the connection over to the download which pipelined
+      // the next request on it.
+      getDownloadEngine()->setNoWait(true);
+    }
   }
 
   // The request was sent assuming that server supported pipelining, but
@@ -33,6 +33,11 @@
  */
 /* copyright --> */
 #include "HttpHeader.h"
+
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
 #include "Range.h"
 #include "util.h"
 #include "A2STR.h"
@@ -41,35 +46,66 @@
 
 namespace aria2 {
 
-HttpHeader::HttpHeader() : statusCode_(0) {}
+HttpHeader::HttpHeader() : definedFields_(0), statusCode_(0) {}
 
 HttpHeader::~HttpHeader() = default;
 
-void HttpHeader::put(int hdKey, const std::string& value)
+namespace {
+bool keyLess(const HttpHeader::FieldTable::value_type& field, int hdKey)
 {
-  std::multimap<int, std::string>::value_type vt(hdKey, value);
-  table_.insert(vt);
+  return field.first < hdKey;
 }
+} // namespace
 
-void HttpHeader::remove(int hdKey) { table_.erase(hdKey); }
+namespace {
+bool lessKey(int hdKey, const HttpHeader::FieldTable::value_type& field)
+{
+  return hdKey < field.first;
+}
+} // namespace
 
-bool HttpHeader::defined(int hdKey) const { return table_.count(hdKey); }
+void HttpHeader::put(int hdKey, std::string value)
+{
+  assert(0 <= hdKey && hdKey < MAX_INTERESTING_HEADER);
+  if (table_.empty()) {
+    // Enough for most of the responses.
+    table_.reserve(8);
+  }
+  auto i = std::upper_bound(std::begin(table_), std::end(table_), hdKey,
+                            lessKey);
+  table_.emplace(i, hdKey, std::move(value));
+  definedFields_ |= 1u << hdKey;
+}
+
+void HttpHeader::remove(int hdKey)
+{
+  if (!defined(hdKey)) {
+    return;
+  }
+  auto r = equalRange(hdKey);
+  table_.erase(r.first, r.second);
+  definedFields_ &= ~(1u << hdKey);
+}
+
+bool HttpHeader::defined(int hdKey) const
+{
+  return 0 <= hdKey && hdKey < MAX_INTERESTING_HEADER &&
+         (definedFields_ & (1u << hdKey));
+}
 
 const std::string& HttpHeader::find(int hdKey) const
 {
-  auto itr = table_.find(hdKey);
-  if (itr == table_.end()) {
+  if (!defined(hdKey)) {
     return A2STR::NIL;
   }
-  else {
-    return (*itr).second;
-  }
+  return std::lower_bound(std::begin(table_), std::end(table_), hdKey, keyLess)
+      ->second;
 }
 
 std::vector<std::string> HttpHeader::findAll(int hdKey) const
 {
   std::vector<std::string> v;
-  auto itrpair = table_.equal_range(hdKey);
+  auto itrpair = equalRange(hdKey);
   while (itrpair.first != itrpair.second) {
     v.push_back((*itrpair.first).second);
     ++itrpair.first;
@@ -77,11 +113,17 @@ std::vector<std::string> HttpHeader::findAll(int hdKey) const
   return v;
 }
 
-std::pair<std::multimap<int, std::string>::const_iterator,
-          std::multimap<int, std::string>::const_iterator>
+std::pair<HttpHeader::FieldTable::const_iterator,
+          HttpHeader::FieldTable::const_iterator>
 HttpHeader::equalRange(int hdKey) const
 {
-  return table_.equal_range(hdKey);
+  if (!defined(hdKey)) {
+    return std::make_pair(std::end(table_), std::end(table_));
+  }
+  auto first =
+      std::lower_bound(std::begin(table_), std::end(table_), hdKey, keyLess);
+  return std::make_pair(
+      first, std::upper_bound(first, std::end(table_), hdKey, lessKey));
 }
 
 Range HttpHeader::getRange() const
@@ -173,7 +215,11 @@ void HttpHeader::setRequestPath(const std::string& requestPath)
   requestPath_ = requestPath;
 }
 
-void HttpHeader::clearField() { table_.clear(); }
+void HttpHeader::clearField()
+{
+  table_.clear();
+  definedFields_ = 0;
+}
 
 int HttpHeader::getStatusCode() const { return statusCode_; }
 
@@ -194,9 +240,7 @@ void HttpHeader::setReasonPhrase(const std::string& reasonPhrase)
 
 bool HttpHeader::fieldContains(int hdKey, const char* value)
 {
-  std::pair<std::multimap<int, std::string>::const_iterator,
-            std::multimap<int, std::string>::const_iterator>
-      range = equalRange(hdKey);
+  auto range = equalRange(hdKey);
   for (auto i = range.first; i != range.second; ++i) {
     std::vector<Scip> values;
     util::splitIter((*i).second.begin(), (*i).second.end(),
@@ -247,17 +291,130 @@ constexpr const char* INTERESTING_HEADER_NAMES[] = {
 };
 } // namespace
 
+namespace {
+// Perfect hash of INTERESTING_HEADER_NAMES.  Only the length, the
+// first and the last characters of the name are used, so computing
+// it costs next to nothing compared to a binary search with string
+// comparisons.
+constexpr size_t hashHeaderName(const char* hdName, size_t len)
+{
+  return (len + 4 * static_cast<unsigned char>(hdName[0]) +
+          5 * static_cast<unsigned char>(hdName[len - 1])) &
+         63;
+}
+} // namespace
+
+namespace {
+// INTERESTING_HEADER_INDEX[hashHeaderName(name)] is the key of name.
+// If INTERESTING_HEADER_NAMES is updated, regenerate this table.  The
+// static_assert below catches a stale table or a collision.
+constexpr int INTERESTING_HEADER_INDEX[] = {
+    HttpHeader::MAX_INTERESTING_HEADER,         // 0
+    HttpHeader::MAX_INTERESTING_HEADER,         // 1
+    HttpHeader::MAX_INTERESTING_HEADER,         // 2
+    HttpHeader::MAX_INTERESTING_HEADER,         // 3
+    HttpHeader::MAX_INTERESTING_HEADER,         // 4
+    HttpHeader::CONTENT_DISPOSITION,            // 5
+    HttpHeader::MAX_INTERESTING_HEADER,         // 6
+    HttpHeader::SEC_WEBSOCKET_VERSION,          // 7
+    HttpHeader::PORT,                           // 8
+    HttpHeader::MAX_INTERESTING_HEADER,         // 9
+    HttpHeader::MAX_INTERESTING_HEADER,         // 10
+    HttpHeader::LINK,                           // 11
+    HttpHeader::MAX_INTERESTING_HEADER,         // 12
+    HttpHeader::RETRY_AFTER,                    // 13
+    HttpHeader::MAX_INTERESTING_HEADER,         // 14
+    HttpHeader::SET_COOKIE,                     // 15
+    HttpHeader::MAX_INTERESTING_HEADER,         // 16
+    HttpHeader::CONTENT_TYPE,                   // 17
+    HttpHeader::CONTENT_RANGE,                  // 18
+    HttpHeader::MAX_INTERESTING_HEADER,         // 19
+    HttpHeader::UPGRADE,                        // 20
+    HttpHeader::ACCESS_CONTROL_REQUEST_METHOD,  // 21
+    HttpHeader::ACCEPT_ENCODING,                // 22
+    HttpHeader::MAX_INTERESTING_HEADER,         // 23
+    HttpHeader::MAX_INTERESTING_HEADER,         // 24
+    HttpHeader::MAX_INTERESTING_HEADER,         // 25
+    HttpHeader::DIGEST,                         // 26
+    HttpHeader::MAX_INTERESTING_HEADER,         // 27
+    HttpHeader::MAX_INTERESTING_HEADER,         // 28
+    HttpHeader::MAX_INTERESTING_HEADER,         // 29
+    HttpHeader::LOCATION,                       // 30
+    HttpHeader::CONTENT_ENCODING,               // 31
+    HttpHeader::MAX_INTERESTING_HEADER,         // 32
+    HttpHeader::ACCESS_CONTROL_REQUEST_HEADERS, // 33
+    HttpHeader::CONTENT_LENGTH,                 // 34
+    HttpHeader::MAX_INTERESTING_HEADER,         // 35
+    HttpHeader::TRANSFER_ENCODING,              // 36
+    HttpHeader::MAX_INTERESTING_HEADER,         // 37
+    HttpHeader::MAX_INTERESTING_HEADER,         // 38
+    HttpHeader::MAX_INTERESTING_HEADER,         // 39
+    HttpHeader::ORIGIN,                         // 40
+    HttpHeader::MAX_INTERESTING_HEADER,         // 41
+    HttpHeader::MAX_INTERESTING_HEADER,         // 42
+    HttpHeader::MAX_INTERESTING_HEADER,         // 43
+    HttpHeader::MAX_INTERESTING_HEADER,         // 44
+    HttpHeader::MAX_INTERESTING_HEADER,         // 45
+    HttpHeader::MAX_INTERESTING_HEADER,         // 46
+    HttpHeader::MAX_INTERESTING_HEADER,         // 47
+    HttpHeader::MAX_INTERESTING_HEADER,         // 48
+    HttpHeader::LAST_MODIFIED,                  // 49
+    HttpHeader::MAX_INTERESTING_HEADER,         // 50
+    HttpHeader::MAX_INTERESTING_HEADER,         // 51
+    HttpHeader::INFOHASH,                       // 52
+    HttpHeader::MAX_INTERESTING_HEADER,         // 53
+    HttpHeader::MAX_INTERESTING_HEADER,         // 54
+    HttpHeader::AUTHORIZATION,                  // 55
+    HttpHeader::MAX_INTERESTING_HEADER,         // 56
+    HttpHeader::MAX_INTERESTING_HEADER,         // 57
+    HttpHeader::SEC_WEBSOCKET_KEY,              // 58
+    HttpHeader::MAX_INTERESTING_HEADER,         // 59
+    HttpHeader::CONNECTION,                     // 60
+    HttpHeader::MAX_INTERESTING_HEADER,         // 61
+    HttpHeader::MAX_INTERESTING_HEADER,         // 62
+    HttpHeader::MAX_INTERESTING_HEADER,         // 63
+};
+} // namespace
+
+namespace {
+constexpr size_t constStrlen(const char* s)
+{
+  return *s ? 1 + constStrlen(s + 1) : 0;
+}
+} // namespace
+
+namespace {
+constexpr bool checkInterestingHeaderIndex(size_t i)
+{
+  return i == arraySize(INTERESTING_HEADER_NAMES) ||
+         (INTERESTING_HEADER_INDEX[hashHeaderName(
+              INTERESTING_HEADER_NAMES[i],
+              constStrlen(INTERESTING_HEADER_NAMES[i]))] ==
+              static_cast<int>(i) &&
+          checkInterestingHeaderIndex(i + 1));
+}
+} // namespace
+
+static_assert(arraySize(INTERESTING_HEADER_NAMES) ==
+                  HttpHeader::MAX_INTERESTING_HEADER,
+              "INTERESTING_HEADER_NAMES is out of sync");
+static_assert(checkInterestingHeaderIndex(0),
+              "INTERESTING_HEADER_INDEX must be regenerated");
+static_assert(HttpHeader::MAX_INTERESTING_HEADER <= 32,
+              "HttpHeader::definedFields_ is too narrow");
+
 int idInterestingHeader(const char* hdName)
 {
-  auto i = std::lower_bound(std::begin(INTERESTING_HEADER_NAMES),
-                            std::end(INTERESTING_HEADER_NAMES), hdName,
-                            util::strless);
-  if (i != std::end(INTERESTING_HEADER_NAMES) && strcmp(*i, hdName) == 0) {
-    return i - std::begin(INTERESTING_HEADER_NAMES);
-  }
-  else {
+  auto len = strlen(hdName);
+  if (len == 0) {
     return HttpHeader::MAX_INTERESTING_HEADER;
   }
+  auto hdKey = INTERESTING_HEADER_INDEX[hashHeaderName(hdName, len)];
+  if (hdKey != HttpHeader::MAX_INTERESTING_HEADER &&
+      strcmp(INTERESTING_HEADER_NAMES[hdKey], hdName) == 0) {
+    return hdKey;
+  }
+  return HttpHeader::MAX_INTERESTING_HEADER;
 }
 
 } // namespace aria2
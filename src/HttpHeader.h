@@ -37,17 +37,28 @@
 
 #include "common.h"
 
-#include <map>
 #include <vector>
 #include <string>
+#include <utility>
 
 namespace aria2 {
 
 struct Range;
 
 class HttpHeader {
+public:
+  typedef std::vector<std::pair<int, std::string>> FieldTable;
+
 private:
-  std::multimap<int, std::string> table_;
+  // Header fields sorted by key.  Fields with the same key are kept in
+  // the order they were put.  We only keep the fields we are
+  // interested in, which are a handful per message, so a sorted
+  // vector makes fewer allocations and is faster to search than a
+  // tree.
+  FieldTable table_;
+
+  // Bit i is set if table_ contains a field whose key is i.
+  uint32_t definedFields_;
 
   // HTTP status code, e.g. 200
   int statusCode_;
@@ -99,12 +110,11 @@ public:
   };
 
   // For all methods, use lowercased header field name.
-  void put(int hdKey, const std::string& value);
+  void put(int hdKey, std::string value);
   bool defined(int hdKey) const;
   const std::string& find(int hdKey) const;
   std::vector<std::string> findAll(int hdKey) const;
-  std::pair<std::multimap<int, std::string>::const_iterator,
-            std::multimap<int, std::string>::const_iterator>
+  std::pair<FieldTable::const_iterator, FieldTable::const_iterator>
   equalRange(int hdKey) const;
 
   void remove(int hdKey);
@@ -161,6 +171,8 @@ public:
   bool isKeepAlive() const;
 };
 
+// Returns the key of lowercased header field name hdName, or
+// HttpHeader::MAX_INTERESTING_HEADER if we are not interested in it.
 int idInterestingHeader(const char* hdName);
 
 } // namespace aria2
@@ -35,6 +35,8 @@
 #include "HttpHeaderProcessor.h"
 
 #include <vector>
+#include <cstring>
+#include <algorithm>
 
 #include "HttpHeader.h"
 #include "message.h"
@@ -137,10 +139,142 @@ size_t ignoreText(std::string& buf, const unsigned char* data, size_t length,
 }
 } // namespace
 
+namespace {
+// Returns the end of the line [first, eol), excluding CR before LF.
+// Returns nullptr if the line contains CR in the middle of it.
+const unsigned char* getLineEnd(const unsigned char* first,
+                                const unsigned char* eol)
+{
+  auto end = eol;
+  if (end != first && *(end - 1) == '\r') {
+    --end;
+  }
+  if (memchr(first, '\r', end - first)) {
+    return nullptr;
+  }
+  return end;
+}
+} // namespace
+
+namespace {
+const unsigned char* findLws(const unsigned char* first,
+                             const unsigned char* last)
+{
+  for (; first != last && !util::isLws(*first); ++first)
+    ;
+  return first;
+}
+} // namespace
+
+namespace {
+const unsigned char* skipLws(const unsigned char* first,
+                             const unsigned char* last)
+{
+  for (; first != last && util::isLws(*first); ++first)
+    ;
+  return first;
+}
+} // namespace
+
+size_t HttpHeaderProcessor::parseHeaderBlock(const unsigned char* data,
+                                             size_t length)
+{
+  // We look for delimiters with memchr, which is vectorized in most C
+  // libraries, instead of examining each byte.  The field values are
+  // copied only for the fields we are interested in.
+  auto last = data + length;
+  auto eol = static_cast<const unsigned char*>(memchr(data, '\n', length));
+  if (!eol) {
+    return 0;
+  }
+  auto end = getLineEnd(data, eol);
+  if (!end || data == end || util::isLws(*data)) {
+    return 0;
+  }
+  auto sp = findLws(data, end);
+  if (sp == end) {
+    return 0;
+  }
+  if (mode_ == CLIENT_PARSER) {
+    auto codeFirst = skipLws(sp, end);
+    auto codeLast = findLws(codeFirst, end);
+    if (codeLast - codeFirst != 3 ||
+        !util::isNumber(codeFirst, codeLast) || *codeFirst == '0') {
+      return 0;
+    }
+    result_->setVersion(data, sp);
+    result_->setStatusCode((codeFirst[0] - '0') * 100 +
+                           (codeFirst[1] - '0') * 10 + (codeFirst[2] - '0'));
+    auto reasonFirst = skipLws(codeLast, end);
+    if (reasonFirst != end) {
+      result_->setReasonPhrase(std::string(reasonFirst, end));
+    }
+  }
+  else {
+    auto pathFirst = skipLws(sp, end);
+    auto pathLast = findLws(pathFirst, end);
+    auto versionFirst = skipLws(pathLast, end);
+    if (pathFirst == end || versionFirst == end ||
+        findLws(versionFirst, end) != end) {
+      return 0;
+    }
+    result_->setMethod(data, sp);
+    result_->setRequestPath(pathFirst, pathLast);
+    result_->setVersion(versionFirst, end);
+  }
+  // Longer names than this are not interesting.
+  char name[32];
+  for (;;) {
+    auto first = eol + 1;
+    eol = static_cast<const unsigned char*>(memchr(first, '\n', last - first));
+    if (!eol) {
+      break;
+    }
+    end = getLineEnd(first, eol);
+    if (!end || (first != end && util::isLws(*first))) {
+      break;
+    }
+    if (first == end) {
+      return eol + 1 - data;
+    }
+    auto colon =
+        static_cast<const unsigned char*>(memchr(first, ':', end - first));
+    if (!colon || colon == first || findLws(first, colon) != colon) {
+      break;
+    }
+    size_t namelen = colon - first;
+    auto v = util::stripIter(colon + 1, end);
+    // The same limits as the state machine below.
+    if (namelen > 1024 || static_cast<size_t>(v.second - v.first) > 8_k) {
+      throw DL_ABORT_EX("Too large HTTP header");
+    }
+    if (namelen >= sizeof(name)) {
+      continue;
+    }
+    std::transform(first, colon, name, util::toLowerChar);
+    name[namelen] = '\0';
+    auto hdKey = idInterestingHeader(name);
+    if (hdKey != HttpHeader::MAX_INTERESTING_HEADER) {
+      result_->put(hdKey, std::string(v.first, v.second));
+    }
+  }
+  // Let the state machine start over.
+  result_ = make_unique<HttpHeader>();
+  return 0;
+}
+
 bool HttpHeaderProcessor::parse(const unsigned char* data, size_t length)
 {
   size_t i;
   lastBytesProcessed_ = 0;
+  if (headers_.empty() &&
+      state_ == (mode_ == CLIENT_PARSER ? PREV_RES_VERSION : PREV_METHOD)) {
+    i = parseHeaderBlock(data, length);
+    if (i > 0) {
+      state_ = HEADERS_COMPLETE;
+      goto fin;
+    }
+  }
   for (i = 0; i < length; ++i) {
     unsigned char c = data[i];
     switch (state_) {
@@ -245,6 +379,7 @@ bool HttpHeaderProcessor::parse(const unsigned char* data, size_t length)
         throw DL_ABORT_EX("Bad Status-Line: missing status-code");
       }
 
+      i = getToken(buf_, data, length, i);
       break;
 
     case PREV_STATUS_CODE:
@@ -81,6 +81,14 @@ public:
   void clear();
 
 private:
+  // Parses the whole header block in data at once.  This is the fast
+  // path for the common case where the header was received in one
+  // read.  Returns the number of bytes processed, or 0 if the header
+  // is incomplete or is something the fast path does not handle
+  // (e.g., multi-line header fields and malformed header).  In the
+  // latter case, the caller must parse data with the state machine.
+  size_t parseHeaderBlock(const unsigned char* data, size_t length);
+
   ParserMode mode_;
   int state_;
   size_t lastBytesProcessed_;
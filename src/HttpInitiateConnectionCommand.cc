@@ -51,10 +51,13 @@
 #include "util.h"
 #include "fmt.h"
 #include "SocketRecvBuffer.h"
-#include "BackupIPv4ConnectCommand.h"
+#include "BackupConnectCommand.h"
 #include "ConnectCommand.h"
 #include "HttpRequestConnectChain.h"
 #include "HttpProxyRequestConnectChain.h"
+#ifdef HAVE_LIBNGHTTP2
+#  include "Http2Session.h"
+#endif // HAVE_LIBNGHTTP2
 
 namespace aria2 {
 
@@ -74,12 +77,18 @@ std::unique_ptr<Command> HttpInitiateConnectionCommand::createNextCommand(
     const std::shared_ptr<Request>& proxyRequest)
 {
   if (proxyRequest) {
+    if (!mayReuseConnection(hostname, port)) {
+      return nullptr;
+    }
     std::shared_ptr<SocketCore> pooledSocket =
         getDownloadEngine()->popPooledSocket(
             getRequest()->getHost(), getRequest()->getPort(),
             proxyRequest->getHost(), proxyRequest->getPort());
     std::string proxyMethod = resolveProxyMethod(getRequest()->getProtocol());
     if (!pooledSocket) {
+      if (!acquireConnection(hostname, port)) {
+        return nullptr;
+      }
       A2_LOG_INFO(fmt(MSG_CONNECTING_TO_SERVER, getCuid(), addr.c_str(), port));
       createSocket();
       getSocket()->establishConnection(addr, port);
@@ -116,10 +125,54 @@ std::unique_ptr<Command> HttpInitiateConnectionCommand::createNextCommand(
     }
   }
   else {
+#ifdef HAVE_LIBNGHTTP2
+    if (getRequest()->getProtocol() == "https" &&
+        getOption()->getAsBool(PREF_ENABLE_HTTP2)) {
+      auto session = getDownloadEngine()->getHttp2Session(
+          getRequest()->getHost(), getRequest()->getPort());
+      if (session) {
+        // Open a new stream on the existing connection.  The command
+        // gets a socket of its own which is never opened, so that it
+        // does not interfere with the I/O of the session.
+        setConnectedAddrInfo(getRequest(), hostname, session->getSocket());
+        auto socket = std::make_shared<SocketCore>();
+        auto httpConnection = std::make_shared<HttpConnection>(
+            getCuid(), socket, std::make_shared<SocketRecvBuffer>(socket));
+        httpConnection->setHttp2Session(session);
+        return make_unique<HttpRequestCommand>(
+            getCuid(), getRequest(), getFileEntry(), getRequestGroup(),
+            httpConnection, getDownloadEngine(), socket);
+      }
+    }
+#endif // HAVE_LIBNGHTTP2
+    if (getRequest()->isPipeliningHint()) {
+      auto httpConnection = getDownloadEngine()->getPipelinedHttpConnection(
+          getRequest()->getHost(), getRequest()->getPort(),
+          getOption()->getAsInt(PREF_MAX_HTTP_PIPELINING));
+      if (httpConnection) {
+        // Pipeline the request after those of other downloads on the
+        // connection to the same server.
+        A2_LOG_INFO(fmt("CUID#%" PRId64 " - Pipelining request on the"
+                        " connection to %s:%u",
+                        getCuid(), getRequest()->getHost().c_str(),
+                        getRequest()->getPort()));
+        setConnectedAddrInfo(getRequest(), hostname,
+                             httpConnection->getSocket());
+        return make_unique<HttpRequestCommand>(
+            getCuid(), getRequest(), getFileEntry(), getRequestGroup(),
+            httpConnection, getDownloadEngine(), httpConnection->getSocket());
+      }
+    }
+    if (!mayReuseConnection(hostname, port)) {
+      return nullptr;
+    }
     std::shared_ptr<SocketCore> pooledSocket =
         getDownloadEngine()->popPooledSocket(resolvedAddresses,
                                              getRequest()->getPort());
     if (!pooledSocket) {
+      if (!acquireConnection(hostname, port)) {
+        return nullptr;
+      }
       A2_LOG_INFO(fmt(MSG_CONNECTING_TO_SERVER, getCuid(), addr.c_str(), port));
       createSocket();
       getSocket()->establishConnection(addr, port);
@@ -181,13 +181,20 @@ std::string HttpRequest::createRequest()
   builtinHds.emplace_back("Accept:", acceptTypes);
   if (contentEncodingEnabled_) {
     std::string acceptableEncodings;
-#ifdef HAVE_ZLIB
     if (acceptGzip_) {
-      acceptableEncodings += "deflate, gzip";
-    }
+#ifdef HAVE_ZLIB
+      acceptableEncodings += ", deflate, gzip";
 #endif // HAVE_ZLIB
+#ifdef HAVE_LIBBROTLIDEC
+      acceptableEncodings += ", br";
+#endif // HAVE_LIBBROTLIDEC
+#ifdef HAVE_LIBZSTD
+      acceptableEncodings += ", zstd";
+#endif // HAVE_LIBZSTD
+    }
     if (!acceptableEncodings.empty()) {
-      builtinHds.emplace_back("Accept-Encoding:", acceptableEncodings);
+      builtinHds.emplace_back("Accept-Encoding:",
+                              acceptableEncodings.substr(2));
     }
   }
   builtinHds.emplace_back("Host:", getHostText(getURIHost(), getPort()));
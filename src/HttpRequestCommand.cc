@@ -59,6 +59,10 @@
 #include "LogFactory.h"
 #include "fmt.h"
 #include "SocketRecvBuffer.h"
+#ifdef HAVE_LIBNGHTTP2
+#  include "Http2Session.h"
+#  include "Http2SessionCommand.h"
+#endif // HAVE_LIBNGHTTP2
 
 namespace aria2 {
 
@@ -69,14 +73,21 @@ HttpRequestCommand::HttpRequestCommand(
     const std::shared_ptr<SocketCore>& s)
     : AbstractCommand(cuid, req, fileEntry, requestGroup, e, s,
                       httpConnection->getSocketRecvBuffer()),
-      httpConnection_(httpConnection)
+      httpConnection_(httpConnection),
+      requestSent_(false)
 {
+  httpConnection_->attach(getCuid());
   setTimeout(std::chrono::seconds(getOption()->getAsInt(PREF_CONNECT_TIMEOUT)));
   disableReadCheckSocket();
   setWriteCheckSocket(getSocket());
 }
 
-HttpRequestCommand::~HttpRequestCommand() = default;
+HttpRequestCommand::~HttpRequestCommand()
+{
+  if (httpConnection_->detach(getCuid())) {
+    getDownloadEngine()->setNoWait(true);
+  }
+}
 
 namespace {
 std::unique_ptr<HttpRequest>
@@ -120,18 +131,62 @@ createHttpRequest(const std::shared_ptr<Request>& req,
 }
 } // namespace
 
+#ifdef HAVE_LIBNGHTTP2
+void HttpRequestCommand::switchToHttp2()
+{
+  auto e = getDownloadEngine();
+  const auto& host = getRequest()->getHost();
+  auto port = getRequest()->getPort();
+  auto session = e->getHttp2Session(host, port);
+  if (session) {
+    // Another connection to the server became HTTP/2 session while
+    // we were connecting.  Share it rather than keeping two.
+    A2_LOG_INFO(fmt("CUID#%" PRId64 " - Use existing HTTP/2 session for %s:%u",
+                    getCuid(), host.c_str(), port));
+    getSocket()->closeConnection();
+  }
+  else {
+    A2_LOG_INFO(fmt("CUID#%" PRId64 " - HTTP/2 negotiated with %s:%u",
+                    getCuid(), host.c_str(), port));
+    session = std::make_shared<Http2Session>(getSocket());
+    e->addHttp2Session(host, port, session);
+    e->addCommand(make_unique<Http2SessionCommand>(e->newCUID(), e, session));
+  }
+  // From now on, the socket is read and written by
+  // Http2SessionCommand only.
+  disableReadCheckSocket();
+  disableWriteCheckSocket();
+  setSocket(std::make_shared<SocketCore>());
+  httpConnection_->setHttp2Session(session);
+}
+#endif // HAVE_LIBNGHTTP2
+
 bool HttpRequestCommand::executeInternal()
 {
   // socket->setBlockingMode();
-  if (httpConnection_->sendBufferIsEmpty()) {
+  // The send buffer is not empty if the connection is shared with
+  // other downloads and their requests are being sent.
+  if (!requestSent_) {
 #ifdef ENABLE_SSL
-    if (getRequest()->getProtocol() == "https") {
-      if (!getSocket()->tlsConnect(getRequest()->getHost())) {
+    if (getRequest()->getProtocol() == "https" && !httpConnection_->isHttp2()) {
+      std::vector<std::string> alpnProtocols;
+#  ifdef HAVE_LIBNGHTTP2
+      if (getOption()->getAsBool(PREF_ENABLE_HTTP2) && !proxyRequest_) {
+        alpnProtocols = {"h2", "http/1.1"};
+      }
+#  endif // HAVE_LIBNGHTTP2
+      if (!getSocket()->tlsConnect(getRequest()->getHost(),
+                                   getRequest()->getPort(), alpnProtocols)) {
         setReadCheckSocketIf(getSocket(), getSocket()->wantRead());
         setWriteCheckSocketIf(getSocket(), getSocket()->wantWrite());
         addCommandSelf();
         return false;
       }
+#  ifdef HAVE_LIBNGHTTP2
+      if (getSocket()->getALPNProtocol() == "h2") {
+        switchToHttp2();
+      }
+#  endif // HAVE_LIBNGHTTP2
     }
 #endif // ENABLE_SSL
     if (getSegments().empty()) {
@@ -169,11 +224,11 @@ bool HttpRequestCommand::executeInternal()
               file.getModifiedTime().toHTTPDate());
         }
       }
-      httpConnection_->sendRequest(std::move(httpRequest));
+      httpConnection_->sendRequest(std::move(httpRequest), getCuid());
     }
     else {
       for (auto& segment : getSegments()) {
-        if (!httpConnection_->isIssued(segment)) {
+        if (!httpConnection_->isIssued(getCuid(), segment)) {
           int64_t endOffset = 0;
           // FTP via HTTP proxy does not support end byte marker
           if (getRequest()->getProtocol() != "ftp" &&
@@ -189,15 +244,29 @@ bool HttpRequestCommand::executeInternal()
           httpConnection_->sendRequest(
               createHttpRequest(getRequest(), getFileEntry(), segment,
                                 getOption(), getRequestGroup(),
-                                getDownloadEngine(), proxyRequest_, endOffset));
+                                getDownloadEngine(), proxyRequest_, endOffset),
+              getCuid());
         }
       }
     }
+    requestSent_ = true;
+    if (getRequest()->isPipeliningHint() && !proxyRequest_ &&
+        !httpConnection_->isHttp2()) {
+      // The server is known to serve small bodies.  Let downloads
+      // starting while we wait for the response pipeline their
+      // requests after ours.
+      getDownloadEngine()->renewPipelinedHttpConnection(
+          getRequest()->getHost(), getRequest()->getPort(), httpConnection_);
+    }
   }
   else {
     httpConnection_->sendPendingData();
   }
   if (httpConnection_->sendBufferIsEmpty()) {
+    if (httpConnection_->isHttp2()) {
+      // Let Http2SessionCommand send the request without waiting.
+      getDownloadEngine()->setNoWait(true);
+    }
     getDownloadEngine()->addCommand(make_unique<HttpResponseCommand>(
         getCuid(), getRequest(), getFileEntry(), getRequestGroup(),
         httpConnection_, getDownloadEngine(), getSocket()));
@@ -54,6 +54,16 @@ private:
 
   std::shared_ptr<HttpConnection> httpConnection_;
 
+  bool requestSent_;
+
+#ifdef HAVE_LIBNGHTTP2
+  // Called when HTTP/2 was negotiated on the connection just
+  // established.  Makes httpConnection_ send requests over the
+  // HTTP/2 session to the server, creating it from the connection if
+  // there is none yet.
+  void switchToHttp2();
+#endif // HAVE_LIBNGHTTP2
+
 protected:
   virtual bool executeInternal() CXX11_OVERRIDE;
 
@@ -63,6 +63,12 @@
 #ifdef HAVE_ZLIB
 #  include "GZipDecodingStreamFilter.h"
 #endif // HAVE_ZLIB
+#ifdef HAVE_LIBBROTLIDEC
+#  include "BrotliDecodingStreamFilter.h"
+#endif // HAVE_LIBBROTLIDEC
+#ifdef HAVE_LIBZSTD
+#  include "ZstdDecodingStreamFilter.h"
+#endif // HAVE_LIBZSTD
 
 namespace aria2 {
 
@@ -217,6 +223,16 @@ HttpResponse::getContentEncodingStreamFilter() const
     return make_unique<GZipDecodingStreamFilter>();
   }
 #endif // HAVE_ZLIB
+#ifdef HAVE_LIBBROTLIDEC
+  if (util::strieq(getContentEncoding(), "br")) {
+    return make_unique<BrotliDecodingStreamFilter>();
+  }
+#endif // HAVE_LIBBROTLIDEC
+#ifdef HAVE_LIBZSTD
+  if (util::strieq(getContentEncoding(), "zstd")) {
+    return make_unique<ZstdDecodingStreamFilter>();
+  }
+#endif // HAVE_LIBZSTD
 
   return nullptr;
 }
@@ -117,6 +117,8 @@ public:
 
   void setCuid(cuid_t cuid) { cuid_ = cuid; }
 
+  cuid_t getCuid() const { return cuid_; }
+
   Time getLastModifiedTime() const;
 
   bool supportsPersistentConnection() const;
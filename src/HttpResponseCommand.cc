@@ -61,6 +61,7 @@
 #include "fmt.h"
 #include "HttpSkipResponseCommand.h"
 #include "HttpHeader.h"
+#include "Range.h"
 #include "LogFactory.h"
 #include "CookieStorage.h"
 #include "AuthConfigFactory.h"
@@ -85,6 +86,11 @@ namespace aria2 {
 
 namespace {
 
+// Requests of downloads of other files are pipelined on a connection
+// only after a response body of at most this length, so that they do
+// not wait long behind a large body.
+constexpr int64_t MAX_PIPELINED_BODY_LENGTH = 256_k;
+
 std::unique_ptr<StreamFilter> getTransferEncodingStreamFilter(
     HttpResponse* httpResponse,
     std::unique_ptr<StreamFilter> delegate = nullptr)
@@ -136,13 +142,38 @@ HttpResponseCommand::HttpResponseCommand(
                       httpConnection->getSocketRecvBuffer()),
       httpConnection_(httpConnection)
 {
+  httpConnection_->attach(getCuid());
   checkSocketRecvBuffer();
 }
 
-HttpResponseCommand::~HttpResponseCommand() = default;
+HttpResponseCommand::~HttpResponseCommand()
+{
+  httpConnection_->cancelWait(this);
+  if (httpConnection_->detach(getCuid())) {
+    getDownloadEngine()->setNoWait(true);
+  }
+}
 
 bool HttpResponseCommand::executeInternal()
 {
+  if (!httpConnection_->canReceiveResponse(getCuid())) {
+    if (httpConnection_->isBroken()) {
+      A2_LOG_INFO(fmt("CUID#%" PRId64 " - Connection was lost before the"
+                      " response to the pipelined request came.",
+                      getCuid()));
+      httpConnection_->cancelWait(this);
+      return prepareForRetry(0);
+    }
+    // The connection is shared with other downloads and one of them
+    // is receiving its response.  We are woken up when it is done.
+    disableReadCheckSocket();
+    disableWriteCheckSocket();
+    httpConnection_->waitForResponse(getCuid(), this);
+    addCommandSelf();
+    return false;
+  }
+  httpConnection_->cancelWait(this);
+  setReadCheckSocket(getSocket());
   auto httpResponse = httpConnection_->receiveResponse();
   if (!httpResponse) {
     // The server has not responded to our request yet.
@@ -164,15 +195,30 @@ bool HttpResponseCommand::executeInternal()
   auto& req = getRequest();
   req->supportsPersistentConnection(
       httpResponse->supportsPersistentConnection());
-  if (req->isPipeliningEnabled()) {
+  auto statusCode = httpResponse->getStatusCode();
+  // Requests for the other segments are pipelined only after the
+  // response to a range request.  The body of 200 response contains
+  // the rest of the file.
+  if (req->isPipeliningEnabled() && statusCode == 206) {
     req->setMaxPipelinedRequest(
         getOption()->getAsInt(PREF_MAX_HTTP_PIPELINING));
   }
   else {
     req->setMaxPipelinedRequest(1);
   }
+  // Let downloads of other files from the same server pipeline their
+  // requests on this connection while the response body is small.
+  auto range = httpHeader->getRange();
+  if (req->isPipeliningEnabled() && !httpConnection_->isHttp2() &&
+      !createProxyRequest() && range.entityLength > 0 &&
+      range.getContentLength() <= MAX_PIPELINED_BODY_LENGTH) {
+    getDownloadEngine()->addPipelinedHttpConnection(
+        req->getHost(), req->getPort(), httpConnection_);
+  }
+  else {
+    getDownloadEngine()->removePipelinedHttpConnection(httpConnection_);
+  }
 
-  auto statusCode = httpResponse->getStatusCode();
   auto& ctx = getDownloadContext();
   auto grp = getRequestGroup();
   auto& fe = getFileEntry();
@@ -377,8 +423,7 @@ bool HttpResponseCommand::handleDefaultEncoding(
   // body instead of a segment.
   // Therefore, we shutdown the socket here if pipelining is enabled.
   if (getRequest()->getMethod() == Request::METHOD_GET && segment &&
-      segment->getPositionToWrite() == 0 &&
-      !getRequest()->isPipeliningEnabled()) {
+      segment->getPositionToWrite() == 0) {
     auto teFilter = getTransferEncodingStreamFilter(httpResponse.get());
     checkEntry->pushNextCommand(createHttpDownloadCommand(
         std::move(httpResponse), std::move(teFilter)));
@@ -560,10 +605,17 @@ HttpResponseCommand::createHttpDownloadCommand(
 
 void HttpResponseCommand::poolConnection()
 {
-  if (getRequest()->supportsPersistentConnection()) {
+  if (!getRequest()->supportsPersistentConnection()) {
+    return;
+  }
+  if (httpConnection_->endResponse()) {
     getDownloadEngine()->poolSocket(getRequest(), createProxyRequest(),
                                     getSocket());
   }
+  else {
+    // Let the download waiting for the next response receive it.
+    getDownloadEngine()->setNoWait(true);
+  }
 }
 
 void HttpResponseCommand::onDryRunFileFound()
@@ -78,10 +78,16 @@ HttpSkipResponseCommand::HttpSkipResponseCommand(
       httpResponse_(std::move(httpResponse)),
       streamFilter_(make_unique<NullSinkStreamFilter>())
 {
+  httpConnection_->attach(getCuid());
   checkSocketRecvBuffer();
 }
 
-HttpSkipResponseCommand::~HttpSkipResponseCommand() = default;
+HttpSkipResponseCommand::~HttpSkipResponseCommand()
+{
+  if (httpConnection_->detach(getCuid())) {
+    getDownloadEngine()->setNoWait(true);
+  }
+}
 
 void HttpSkipResponseCommand::installStreamFilter(
     std::unique_ptr<StreamFilter> streamFilter)
@@ -113,8 +119,8 @@ bool HttpSkipResponseCommand::executeInternal()
   try {
     size_t bufSize;
     if (getSocketRecvBuffer()->bufferEmpty()) {
-      eof = getSocketRecvBuffer()->recv() == 0 && !getSocket()->wantRead() &&
-            !getSocket()->wantWrite();
+      eof = getSocketRecvBuffer()->recv() == 0 &&
+            getSocketRecvBuffer()->eof();
     }
     if (!eof) {
       if (sinkFilterOnly_) {
@@ -182,10 +188,17 @@ bool HttpSkipResponseCommand::executeInternal()
 
 void HttpSkipResponseCommand::poolConnection() const
 {
-  if (getRequest()->supportsPersistentConnection()) {
+  if (!getRequest()->supportsPersistentConnection()) {
+    return;
+  }
+  if (httpConnection_->endResponse()) {
     getDownloadEngine()->poolSocket(getRequest(), createProxyRequest(),
                                     getSocket());
   }
+  else {
+    // Let the download waiting for the next response receive it.
+    getDownloadEngine()->setNoWait(true);
+  }
 }
 
 bool HttpSkipResponseCommand::processResponse()
@@ -51,11 +51,17 @@
 #include "RecoverableException.h"
 #include "fmt.h"
 #include "SocketRecvBuffer.h"
-#include "BackupIPv4ConnectCommand.h"
+#include "BackupConnectCommand.h"
 #include "ConnectCommand.h"
+#include "SocketPool.h"
 
 namespace aria2 {
 
+namespace {
+// RFC 8305 recommends 250ms as the default Connection Attempt Delay.
+constexpr auto CONNECTION_ATTEMPT_DELAY = 250;
+} // namespace
+
 InitiateConnectionCommand::InitiateConnectionCommand(
     cuid_t cuid, const std::shared_ptr<Request>& req,
     const std::shared_ptr<FileEntry>& fileEntry, RequestGroup* requestGroup,
@@ -69,7 +75,10 @@ InitiateConnectionCommand::InitiateConnectionCommand(
   disableWriteCheckSocket();
 }
 
-InitiateConnectionCommand::~InitiateConnectionCommand() = default;
+InitiateConnectionCommand::~InitiateConnectionCommand()
+{
+  getDownloadEngine()->getSocketPool()->cancel(this);
+}
 
 bool InitiateConnectionCommand::executeInternal()
 {
@@ -92,6 +101,16 @@ bool InitiateConnectionCommand::executeInternal()
   }
   try {
     auto c = createNextCommand(hostname, ipaddr, port, addrs, proxyRequest);
+    if (!c) {
+      // Too many connections to the host.  DownloadEngine wakes us up
+      // when one of them becomes idle or is closed.
+      addCommandSelf();
+      return false;
+    }
+    if (getSocket()) {
+      getDownloadEngine()->getSocketPool()->addConnection(hostname, port,
+                                                          getSocket());
+    }
     c->setStatus(Command::STATUS_ONESHOT_REALTIME);
     getDownloadEngine()->setNoWait(true);
     getDownloadEngine()->addCommand(std::move(c));
@@ -99,7 +118,7 @@ bool InitiateConnectionCommand::executeInternal()
   }
   catch (RecoverableException& ex) {
     // Catch exception and retry another address.
-    // See also AbstractCommand::checkIfConnectionEstablished
+    // See also AbstractCommand::onConnectionFailure
 
     // TODO ipaddr might not be used if pooled socket was found.
     getDownloadEngine()->markBadIPAddress(hostname, ipaddr, port);
@@ -120,6 +139,24 @@ bool InitiateConnectionCommand::executeInternal()
   }
 }
 
+bool InitiateConnectionCommand::acquireConnection(const std::string& hostname,
+                                                  uint16_t port)
+{
+  auto e = getDownloadEngine();
+  return e->getSocketPool()->acquire(
+      hostname, port, e->getOption()->getAsInt(PREF_MAX_HOST_CONNECTIONS),
+      this);
+}
+
+bool InitiateConnectionCommand::mayReuseConnection(const std::string& hostname,
+                                                   uint16_t port)
+{
+  // acquireConnection() queues this command behind the others.
+  return !getDownloadEngine()->getSocketPool()->hasWaiterBefore(hostname, port,
+                                                                this) ||
+         acquireConnection(hostname, port);
+}
+
 void InitiateConnectionCommand::setConnectedAddrInfo(
     const std::shared_ptr<Request>& req, const std::string& hostname,
     const std::shared_ptr<SocketCore>& socket)
@@ -129,36 +166,30 @@ void InitiateConnectionCommand::setConnectedAddrInfo(
 }
 
 std::shared_ptr<BackupConnectInfo>
-InitiateConnectionCommand::createBackupIPv4ConnectCommand(
+InitiateConnectionCommand::createBackupConnectCommand(
     const std::string& hostname, const std::string& ipaddr, uint16_t port,
     Command* mainCommand)
 {
-  // Prepare IPv4 backup connection attempt in "Happy Eyeballs"
-  // fashion.
+  // Race connection attempts to the other addresses in "Happy
+  // Eyeballs" fashion.
   std::shared_ptr<BackupConnectInfo> info;
-  char buf[sizeof(in6_addr)];
-  if (inetPton(AF_INET6, ipaddr.c_str(), &buf) == -1) {
-    return info;
-  }
-  A2_LOG_INFO("Searching IPv4 address for backup connection attempt");
   std::vector<std::string> addrs;
   getDownloadEngine()->findAllCachedIPAddresses(std::back_inserter(addrs),
                                                 hostname, port);
-  for (std::vector<std::string>::const_iterator i = addrs.begin(),
-                                                eoi = addrs.end();
-       i != eoi; ++i) {
-    if (inetPton(AF_INET, (*i).c_str(), &buf) == 0) {
-      info = std::make_shared<BackupConnectInfo>();
-      auto command = make_unique<BackupIPv4ConnectCommand>(
-          getDownloadEngine()->newCUID(), *i, port, info, mainCommand,
-          getRequestGroup(), getDownloadEngine());
-      A2_LOG_INFO(fmt("Issue backup connection command CUID#%" PRId64
-                      ", addr=%s",
-                      command->getCuid(), (*i).c_str()));
-      getDownloadEngine()->addCommand(std::move(command));
-      return info;
-    }
+  addrs = createBackupAddressList(ipaddr, addrs);
+  if (addrs.empty()) {
+    return info;
   }
+  info = std::make_shared<BackupConnectInfo>();
+  auto command = make_unique<BackupConnectCommand>(
+      getDownloadEngine()->newCUID(), hostname, addrs, port,
+      std::chrono::milliseconds(CONNECTION_ATTEMPT_DELAY), info, mainCommand,
+      getRequestGroup(), getDownloadEngine());
+  A2_LOG_INFO(fmt("Issue backup connection command CUID#%" PRId64
+                  ", addrs=%s",
+                  command->getCuid(),
+                  strjoin(std::begin(addrs), std::end(addrs), ", ").c_str()));
+  getDownloadEngine()->addCommand(std::move(command));
   return info;
 }
 
@@ -167,7 +198,7 @@ void InitiateConnectionCommand::setupBackupConnection(
     ConnectCommand* c)
 {
   std::shared_ptr<BackupConnectInfo> backupConnectInfo =
-      createBackupIPv4ConnectCommand(hostname, addr, port, c);
+      createBackupConnectCommand(hostname, addr, port, c);
   if (backupConnectInfo) {
     c->setBackupConnectInfo(backupConnectInfo);
   }
@@ -57,21 +57,33 @@ protected:
   // and port of proxy server. addr is one of resolved address and we
   // use this address this time.  resolvedAddresses are all addresses
   // resolved.  proxyRequest is set if we are going to use proxy
-  // server.
+  // server.  Returns nullptr if acquireConnection() or
+  // mayReuseConnection() failed.
   virtual std::unique_ptr<Command>
   createNextCommand(const std::string& hostname, const std::string& addr,
                     uint16_t port,
                     const std::vector<std::string>& resolvedAddresses,
                     const std::shared_ptr<Request>& proxyRequest) = 0;
 
+  // Returns true if a new connection to |hostname|:|port| can be
+  // opened without exceeding --max-host-connections.  Otherwise, this
+  // command is queued until it can.
+  bool acquireConnection(const std::string& hostname, uint16_t port);
+
+  // Returns true if this command may take an idle pooled connection
+  // to |hostname|:|port|.  If other commands are queued for a
+  // connection to the host, this command is queued behind them and
+  // false is returned, so that they are served in order.
+  bool mayReuseConnection(const std::string& hostname, uint16_t port);
+
   void setConnectedAddrInfo(const std::shared_ptr<Request>& req,
                             const std::string& hostname,
                             const std::shared_ptr<SocketCore>& socket);
 
   std::shared_ptr<BackupConnectInfo>
-  createBackupIPv4ConnectCommand(const std::string& hostname,
-                                 const std::string& ipaddr, uint16_t port,
-                                 Command* mainCommand);
+  createBackupConnectCommand(const std::string& hostname,
+                             const std::string& ipaddr, uint16_t port,
+                             Command* mainCommand);
 
   void setupBackupConnection(const std::string& hostname,
                              const std::string& addr, uint16_t port,
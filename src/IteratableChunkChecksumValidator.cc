@@ -61,7 +61,10 @@ IteratableChunkChecksumValidator::IteratableChunkChecksumValidator(
       pieceStorage_(pieceStorage),
       bitfield_(make_unique<BitfieldMan>(dctx_->getPieceLength(),
                                          dctx_->getTotalLength())),
-      currentIndex_(0)
+      currentIndex_(0),
+      dataOffset_(-1),
+      zeroChecksumLength_(0),
+      numHolePieces_(0)
 {
 }
 
@@ -70,20 +73,34 @@ IteratableChunkChecksumValidator::~IteratableChunkChecksumValidator() = default;
 void IteratableChunkChecksumValidator::validateChunk()
 {
   if (!finished()) {
-    std::string actualChecksum;
     try {
-      actualChecksum = calculateActualChecksum();
-      if (actualChecksum == dctx_->getPieceHashes()[currentIndex_]) {
-        bitfield_->setBit(currentIndex_);
+      auto expectedChecksum = dctx_->getPieceHash(currentIndex_);
+      if (pieceInHole()) {
+        // A hole is read as zeros, so that the piece is only valid if
+        // it is all zeros.  Usually, it was never written.
+        ++numHolePieces_;
+        if (getZeroChecksum(getCurrentLength()) == expectedChecksum) {
+          bitfield_->setBit(currentIndex_);
+        }
+        else {
+          bitfield_->unsetBit(currentIndex_);
+        }
       }
       else {
-        A2_LOG_INFO(
-            fmt(EX_INVALID_CHUNK_CHECKSUM,
-                static_cast<unsigned long>(currentIndex_),
-                static_cast<int64_t>(getCurrentOffset()),
-                util::toHex(dctx_->getPieceHashes()[currentIndex_]).c_str(),
-                util::toHex(actualChecksum).c_str()));
-        bitfield_->unsetBit(currentIndex_);
+        auto actualChecksum = calculateActualChecksum();
+        if (actualChecksum == expectedChecksum) {
+          bitfield_->setBit(currentIndex_);
+        }
+        else {
+          A2_LOG_INFO(fmt(
+              EX_INVALID_CHUNK_CHECKSUM,
+              static_cast<unsigned long>(currentIndex_),
+              static_cast<int64_t>(getCurrentOffset()),
+              util::toHex(expectedChecksum.data(), expectedChecksum.size())
+                  .c_str(),
+              util::toHex(actualChecksum).c_str()));
+          bitfield_->unsetBit(currentIndex_);
+        }
       }
     }
     catch (RecoverableException& ex) {
@@ -97,24 +114,38 @@ void IteratableChunkChecksumValidator::validateChunk()
 
     ++currentIndex_;
     if (finished()) {
+      A2_LOG_INFO(fmt("%lu of %lu pieces are in holes and were not read.",
+                      static_cast<unsigned long>(numHolePieces_),
+                      static_cast<unsigned long>(dctx_->getNumPieces())));
       pieceStorage_->setBitfield(bitfield_->getBitfield(),
                                  bitfield_->getBitfieldLength());
     }
   }
 }
 
-std::string IteratableChunkChecksumValidator::calculateActualChecksum()
+size_t IteratableChunkChecksumValidator::getCurrentLength() const
 {
-  int64_t offset = getCurrentOffset();
-  size_t length;
   // When validating last piece
   if (currentIndex_ + 1 == dctx_->getNumPieces()) {
-    length = dctx_->getTotalLength() - offset;
+    return dctx_->getTotalLength() - getCurrentOffset();
   }
   else {
-    length = dctx_->getPieceLength();
+    return dctx_->getPieceLength();
+  }
+}
+
+bool IteratableChunkChecksumValidator::pieceInHole()
+{
+  int64_t offset = getCurrentOffset();
+  if (dataOffset_ < offset) {
+    dataOffset_ = pieceStorage_->getDiskAdaptor()->seekData(offset);
   }
-  return digest(offset, length);
+  return dataOffset_ >= offset + static_cast<int64_t>(getCurrentLength());
+}
+
+std::string IteratableChunkChecksumValidator::calculateActualChecksum()
+{
+  return digest(getCurrentOffset(), getCurrentLength());
 }
 
 void IteratableChunkChecksumValidator::init()
@@ -122,6 +153,10 @@ void IteratableChunkChecksumValidator::init()
   ctx_ = MessageDigest::create(dctx_->getPieceHashType());
   bitfield_->clearAllBit();
   currentIndex_ = 0;
+  dataOffset_ = -1;
+  zeroChecksum_.clear();
+  zeroChecksumLength_ = 0;
+  numHolePieces_ = 0;
 }
 
 std::string IteratableChunkChecksumValidator::digest(int64_t offset,
@@ -144,6 +179,23 @@ std::string IteratableChunkChecksumValidator::digest(int64_t offset,
   return ctx_->digest();
 }
 
+const std::string&
+IteratableChunkChecksumValidator::getZeroChecksum(size_t length)
+{
+  if (zeroChecksum_.empty() || zeroChecksumLength_ != length) {
+    std::array<unsigned char, 4_k> buf{};
+    ctx_->reset();
+    for (size_t rem = length; rem > 0;) {
+      auto n = std::min(buf.size(), rem);
+      ctx_->update(buf.data(), n);
+      rem -= n;
+    }
+    zeroChecksum_ = ctx_->digest();
+    zeroChecksumLength_ = length;
+  }
+  return zeroChecksum_;
+}
+
 bool IteratableChunkChecksumValidator::finished() const
 {
   if (currentIndex_ >= dctx_->getNumPieces()) {
@@ -54,11 +54,26 @@ private:
   std::unique_ptr<BitfieldMan> bitfield_;
   size_t currentIndex_;
   std::unique_ptr<MessageDigest> ctx_;
+  // The offset of the first byte which may hold data at or after the
+  // current piece.  The bytes before it down to the current piece are
+  // a hole in the file.
+  int64_t dataOffset_;
+  // The hash of zeros of zeroChecksumLength_ bytes
+  std::string zeroChecksum_;
+  size_t zeroChecksumLength_;
+  size_t numHolePieces_;
+
+  size_t getCurrentLength() const;
+
+  // Returns true if the current piece is entirely in a hole.
+  bool pieceInHole();
 
   std::string calculateActualChecksum();
 
   std::string digest(int64_t offset, size_t length);
 
+  const std::string& getZeroChecksum(size_t length);
+
 public:
   IteratableChunkChecksumValidator(
       const std::shared_ptr<DownloadContext>& dctx,
@@ -80,6 +80,11 @@ GnuTLSContext::~GnuTLSContext()
 
 bool GnuTLSContext::good() const { return good_; }
 
+TLSSessionCache* GnuTLSContext::getSessionCache()
+{
+  return side_ == TLS_CLIENT ? &sessionCache_ : nullptr;
+}
+
 bool GnuTLSContext::addCredentialFile(const std::string& certfile,
                                       const std::string& keyfile)
 {
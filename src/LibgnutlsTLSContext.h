@@ -40,6 +40,7 @@
 #include <gnutls/gnutls.h>
 
 #include "TLSContext.h"
+#include "TLSSessionCache.h"
 #include "DlAbortEx.h"
 
 namespace aria2 {
@@ -70,6 +71,8 @@ public:
     verifyPeer_ = verify;
   }
 
+  virtual TLSSessionCache* getSessionCache() CXX11_OVERRIDE;
+
   gnutls_certificate_credentials_t getCertCred() const;
 
   TLSVersion getMinTLSVersion() const { return minTLSVer_; }
@@ -80,6 +83,7 @@ private:
   TLSVersion minTLSVer_;
   bool good_;
   bool verifyPeer_;
+  TLSSessionCache sessionCache_;
 };
 
 } // namespace aria2
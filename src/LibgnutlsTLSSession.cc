@@ -178,6 +178,82 @@ int GnuTLSSession::setSNIHostname(const std::string& hostname)
   return TLS_ERR_OK;
 }
 
+int GnuTLSSession::setALPNProtocols(const std::vector<std::string>& protocols)
+{
+#if GNUTLS_VERSION_NUMBER >= 0x030200
+  std::vector<gnutls_datum_t> data;
+  for (const auto& proto : protocols) {
+    gnutls_datum_t d;
+    // GnuTLS copies the protocol names.
+    d.data = reinterpret_cast<unsigned char*>(const_cast<char*>(proto.data()));
+    d.size = proto.size();
+    data.push_back(d);
+  }
+  rv_ = gnutls_alpn_set_protocols(sslSession_, data.data(), data.size(), 0);
+  if (rv_ != GNUTLS_E_SUCCESS) {
+    return TLS_ERR_ERROR;
+  }
+#endif // GNUTLS_VERSION_NUMBER >= 0x030200
+  return TLS_ERR_OK;
+}
+
+#if GNUTLS_VERSION_NUMBER >= 0x030604
+namespace {
+// With TLS 1.3, the session data are available only after a session
+// ticket arrives, which happens after the handshake.
+int onNewSessionTicket(gnutls_session_t session, unsigned int htype,
+                       unsigned int when, unsigned int incoming,
+                       const gnutls_datum_t* msg)
+{
+  static_cast<GnuTLSSession*>(gnutls_session_get_ptr(session))
+      ->storeSession();
+  return 0;
+}
+} // namespace
+#endif // GNUTLS_VERSION_NUMBER >= 0x030604
+
+void GnuTLSSession::setSessionCacheKey(const std::string& key)
+{
+  auto cache = tlsContext_->getSessionCache();
+  if (!cache) {
+    return;
+  }
+  sessionCacheKey_ = key;
+#if GNUTLS_VERSION_NUMBER >= 0x030604
+  gnutls_session_set_ptr(sslSession_, this);
+  gnutls_handshake_set_hook_function(
+      sslSession_, GNUTLS_HANDSHAKE_NEW_SESSION_TICKET, GNUTLS_HOOK_POST,
+      onNewSessionTicket);
+#endif // GNUTLS_VERSION_NUMBER >= 0x030604
+  auto data = cache->get(key);
+  if (data.empty()) {
+    return;
+  }
+  if (gnutls_session_set_data(sslSession_, data.data(), data.size()) !=
+      GNUTLS_E_SUCCESS) {
+    cache->remove(key);
+  }
+}
+
+bool GnuTLSSession::isResumed()
+{
+  return gnutls_session_is_resumed(sslSession_);
+}
+
+void GnuTLSSession::storeSession()
+{
+  if (sessionCacheKey_.empty()) {
+    return;
+  }
+  gnutls_datum_t data;
+  if (gnutls_session_get_data2(sslSession_, &data) != GNUTLS_E_SUCCESS) {
+    return;
+  }
+  std::string buf(data.data, data.data + data.size);
+  gnutls_free(data.data);
+  tlsContext_->getSessionCache()->put(sessionCacheKey_, std::move(buf));
+}
+
 int GnuTLSSession::closeConnection()
 {
   rv_ = gnutls_bye(sslSession_, GNUTLS_SHUT_WR);
@@ -358,6 +434,9 @@ int GnuTLSSession::tlsConnect(const std::string& hostname, TLSVersion& version,
   }
 
   version = getProtocolFromSession(sslSession_);
+  if (version != TLS_PROTO_TLS13) {
+    storeSession();
+  }
 
   return TLS_ERR_OK;
 }
@@ -379,6 +458,18 @@ int GnuTLSSession::tlsAccept(TLSVersion& version)
   }
 }
 
+std::string GnuTLSSession::getALPNProtocol()
+{
+#if GNUTLS_VERSION_NUMBER >= 0x030200
+  gnutls_datum_t proto;
+  if (gnutls_alpn_get_selected_protocol(sslSession_, &proto) ==
+      GNUTLS_E_SUCCESS) {
+    return std::string(proto.data, proto.data + proto.size);
+  }
+#endif // GNUTLS_VERSION_NUMBER >= 0x030200
+  return "";
+}
+
 std::string GnuTLSSession::getLastErrorString() { return gnutls_strerror(rv_); }
 
 } // namespace aria2
@@ -51,6 +51,10 @@ public:
   ~GnuTLSSession();
   virtual int init(sock_t sockfd) CXX11_OVERRIDE;
   virtual int setSNIHostname(const std::string& hostname) CXX11_OVERRIDE;
+  virtual int
+  setALPNProtocols(const std::vector<std::string>& protocols) CXX11_OVERRIDE;
+  virtual void setSessionCacheKey(const std::string& key) CXX11_OVERRIDE;
+  virtual bool isResumed() CXX11_OVERRIDE;
   virtual int closeConnection() CXX11_OVERRIDE;
   virtual int checkDirection() CXX11_OVERRIDE;
   virtual ssize_t writeData(const void* data, size_t len) CXX11_OVERRIDE;
@@ -60,12 +64,19 @@ public:
   virtual int tlsAccept(TLSVersion& version) CXX11_OVERRIDE;
   virtual std::string getLastErrorString() CXX11_OVERRIDE;
   virtual size_t getRecvBufferedLength() CXX11_OVERRIDE { return 0; }
+  virtual std::string getALPNProtocol() CXX11_OVERRIDE;
+
+  // Stores the current session to the session cache of the context.
+  void storeSession();
 
 private:
   gnutls_session_t sslSession_;
   GnuTLSContext* tlsContext_;
   // Last error code from gnutls library functions
   int rv_;
+  // Key of the session cache entry for this session.  Empty if the
+  // session is not cached.
+  std::string sessionCacheKey_;
 };
 
 } // namespace aria2
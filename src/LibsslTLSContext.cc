@@ -46,6 +46,7 @@
 #include "fmt.h"
 #include "message.h"
 #include "BufferedFile.h"
+#include "LibsslTLSSession.h"
 
 namespace {
 struct bio_deleter {
@@ -150,6 +151,14 @@ OpenSSLTLSContext::OpenSSLTLSContext(TLSSessionSide side, TLSVersion minVer)
     A2_LOG_ERROR(fmt("SSL_CTX_set_cipher_list() failed. Cause: %s",
                      ERR_error_string(ERR_get_error(), nullptr)));
   }
+  if (side_ == TLS_CLIENT) {
+    // Client sessions are kept in sessionCache_, keyed by the remote
+    // endpoint, rather than in the internal cache of OpenSSL.
+    SSL_CTX_set_session_cache_mode(sslCtx_,
+                                   SSL_SESS_CACHE_CLIENT |
+                                       SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(sslCtx_, OpenSSLTLSSession::onNewSession);
+  }
 
 #if OPENSSL_VERSION_NUMBER < 0x30000000L &&                                    \
     OPENSSL_VERSION_NUMBER >= 0x0090800fL
@@ -172,6 +181,11 @@ OpenSSLTLSContext::~OpenSSLTLSContext() { SSL_CTX_free(sslCtx_); }
 
 bool OpenSSLTLSContext::good() const { return good_; }
 
+TLSSessionCache* OpenSSLTLSContext::getSessionCache()
+{
+  return side_ == TLS_CLIENT ? &sessionCache_ : nullptr;
+}
+
 bool OpenSSLTLSContext::addCredentialFile(const std::string& certfile,
                                           const std::string& keyfile)
 {
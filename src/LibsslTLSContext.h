@@ -42,6 +42,7 @@
 #include <openssl/ssl.h>
 
 #include "TLSContext.h"
+#include "TLSSessionCache.h"
 #include "DlAbortEx.h"
 
 namespace aria2 {
@@ -72,6 +73,8 @@ public:
     verifyPeer_ = verify;
   }
 
+  virtual TLSSessionCache* getSessionCache() CXX11_OVERRIDE;
+
   SSL_CTX* getSSLCtx() const { return sslCtx_; }
 
 private:
@@ -79,6 +82,7 @@ private:
   TLSSessionSide side_;
   bool good_;
   bool verifyPeer_;
+  TLSSessionCache sessionCache_;
 };
 
 } // namespace aria2
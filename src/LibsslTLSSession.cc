@@ -96,6 +96,74 @@ int OpenSSLTLSSession::setSNIHostname(const std::string& hostname)
   return TLS_ERR_OK;
 }
 
+int OpenSSLTLSSession::setALPNProtocols(
+    const std::vector<std::string>& protocols)
+{
+#if OPENSSL_VERSION_NUMBER >= 0x10002000L
+  std::string wire;
+  for (const auto& proto : protocols) {
+    wire += static_cast<char>(proto.size());
+    wire += proto;
+  }
+  ERR_clear_error();
+  // Unlike most OpenSSL functions, this returns 0 on success.
+  if (SSL_set_alpn_protos(ssl_,
+                          reinterpret_cast<const unsigned char*>(wire.data()),
+                          wire.size()) != 0) {
+    return TLS_ERR_ERROR;
+  }
+#endif // OPENSSL_VERSION_NUMBER >= 0x10002000L
+  return TLS_ERR_OK;
+}
+
+void OpenSSLTLSSession::setSessionCacheKey(const std::string& key)
+{
+  auto cache = tlsContext_->getSessionCache();
+  if (!cache) {
+    return;
+  }
+  sessionCacheKey_ = key;
+  SSL_set_app_data(ssl_, this);
+  auto data = cache->get(key);
+  if (data.empty()) {
+    return;
+  }
+  auto p = reinterpret_cast<const unsigned char*>(data.data());
+  auto session = d2i_SSL_SESSION(nullptr, &p, data.size());
+  if (!session) {
+    cache->remove(key);
+    return;
+  }
+  SSL_set_session(ssl_, session);
+  SSL_SESSION_free(session);
+}
+
+bool OpenSSLTLSSession::isResumed() { return SSL_session_reused(ssl_); }
+
+int OpenSSLTLSSession::onNewSession(SSL* ssl, SSL_SESSION* session)
+{
+  auto tlsSession = static_cast<OpenSSLTLSSession*>(SSL_get_app_data(ssl));
+  if (tlsSession) {
+    tlsSession->storeSession(session);
+  }
+  // We did not take the reference to |session|.
+  return 0;
+}
+
+void OpenSSLTLSSession::storeSession(SSL_SESSION* session)
+{
+  auto len = i2d_SSL_SESSION(session, nullptr);
+  if (len <= 0) {
+    return;
+  }
+  std::string data(len, '\0');
+  auto p = reinterpret_cast<unsigned char*>(&data[0]);
+  i2d_SSL_SESSION(session, &p);
+  tlsContext_->getSessionCache()->put(
+      sessionCacheKey_, std::move(data),
+      std::chrono::seconds(SSL_SESSION_get_timeout(session)));
+}
+
 int OpenSSLTLSSession::closeConnection()
 {
   ERR_clear_error();
@@ -336,6 +404,19 @@ int OpenSSLTLSSession::tlsAccept(TLSVersion& version)
   return handshake(version);
 }
 
+std::string OpenSSLTLSSession::getALPNProtocol()
+{
+#if OPENSSL_VERSION_NUMBER >= 0x10002000L
+  const unsigned char* proto = nullptr;
+  unsigned int len = 0;
+  SSL_get0_alpn_selected(ssl_, &proto, &len);
+  if (proto) {
+    return std::string(proto, proto + len);
+  }
+#endif // OPENSSL_VERSION_NUMBER >= 0x10002000L
+  return "";
+}
+
 std::string OpenSSLTLSSession::getLastErrorString()
 {
   if (rv_ <= 0) {
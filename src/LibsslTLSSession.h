@@ -52,6 +52,10 @@ public:
   virtual ~OpenSSLTLSSession();
   virtual int init(sock_t sockfd) CXX11_OVERRIDE;
   virtual int setSNIHostname(const std::string& hostname) CXX11_OVERRIDE;
+  virtual int
+  setALPNProtocols(const std::vector<std::string>& protocols) CXX11_OVERRIDE;
+  virtual void setSessionCacheKey(const std::string& key) CXX11_OVERRIDE;
+  virtual bool isResumed() CXX11_OVERRIDE;
   virtual int closeConnection() CXX11_OVERRIDE;
   virtual int checkDirection() CXX11_OVERRIDE;
   virtual ssize_t writeData(const void* data, size_t len) CXX11_OVERRIDE;
@@ -61,13 +65,22 @@ public:
   virtual int tlsAccept(TLSVersion& version) CXX11_OVERRIDE;
   virtual std::string getLastErrorString() CXX11_OVERRIDE;
   virtual size_t getRecvBufferedLength() CXX11_OVERRIDE { return 0; }
+  virtual std::string getALPNProtocol() CXX11_OVERRIDE;
+
+  // Callback for SSL_CTX_sess_set_new_cb().  With TLS 1.3, this is
+  // called when a session ticket arrives after the handshake.
+  static int onNewSession(SSL* ssl, SSL_SESSION* session);
 
 private:
   int handshake(TLSVersion& version);
+  void storeSession(SSL_SESSION* session);
   SSL* ssl_;
   OpenSSLTLSContext* tlsContext_;
   // Last error code from openSSL library functions
   int rv_;
+  // Key of the session cache entry for this session.  Empty if the
+  // session is not cached.
+  std::string sessionCacheKey_;
 };
 
 } // namespace aria2
@@ -63,6 +63,9 @@ Logger::~Logger() = default;
 void Logger::openFile(const std::string& filename)
 {
   closeFile();
+#ifdef HAVE_STD_THREAD
+  std::lock_guard<std::mutex> lock(mutex_);
+#endif // HAVE_STD_THREAD
   if (filename == DEV_STDOUT) {
     fpp_ = global::cout();
   }
@@ -77,6 +80,9 @@ void Logger::openFile(const std::string& filename)
 
 void Logger::closeFile()
 {
+#ifdef HAVE_STD_THREAD
+  std::lock_guard<std::mutex> lock(mutex_);
+#endif // HAVE_STD_THREAD
   if (fpp_) {
     fpp_.reset();
   }
@@ -192,6 +198,9 @@ void writeStackTrace(Output& fp, const char* stackTrace)
 void Logger::writeLog(Logger::LEVEL level, const char* sourceFile, int lineNum,
                       const char* msg, const char* trace)
 {
+#ifdef HAVE_STD_THREAD
+  std::lock_guard<std::mutex> lock(mutex_);
+#endif // HAVE_STD_THREAD
   if (fileLogEnabled(level)) {
     writeHeader(*fpp_, level, sourceFile, lineNum);
     fpp_->printf("%s\n", msg);
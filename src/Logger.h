@@ -39,6 +39,9 @@
 
 #include <string>
 #include <memory>
+#ifdef HAVE_STD_THREAD
+#  include <mutex>
+#endif // HAVE_STD_THREAD
 
 namespace aria2 {
 
@@ -64,6 +67,11 @@ private:
   // true if console log output is enabled.
   bool consoleOutput_;
   bool colorOutput_;
+#ifdef HAVE_STD_THREAD
+  // File allocation logs from worker threads.  Guards fpp_ and the
+  // output.
+  std::mutex mutex_;
+#endif // HAVE_STD_THREAD
   // Don't allow copying
   Logger(const Logger&);
   Logger& operator=(const Logger&);
@@ -37,6 +37,7 @@
 #include <cassert>
 #include <algorithm>
 #include <map>
+#include <exception>
 
 #include "DefaultDiskWriter.h"
 #include "message.h"
@@ -49,7 +50,6 @@
 #include "fmt.h"
 #include "Logger.h"
 #include "LogFactory.h"
-#include "SimpleRandomizer.h"
 #include "WrDiskCacheEntry.h"
 #include "OpenedFileCounter.h"
 
@@ -58,6 +58,7 @@ namespace aria2 {
 DiskWriterEntry::DiskWriterEntry(const std::shared_ptr<FileEntry>& fileEntry)
     : fileEntry_{fileEntry},
       open_{false},
+      writeback_{false},
       needsFileAllocation_{false},
       needsDiskWriter_{false}
 {
@@ -102,6 +103,12 @@ void DiskWriterEntry::closeFile()
 
 bool DiskWriterEntry::fileExists() { return fileEntry_->exists(); }
 
+bool DiskWriterEntry::usesDiskWriter()
+{
+  return diskWriter_ || needsFileAllocation_ || needsDiskWriter_ ||
+         fileExists();
+}
+
 int64_t DiskWriterEntry::size() const { return File(getFilePath()).size(); }
 
 void DiskWriterEntry::setDiskWriter(std::unique_ptr<DiskWriter> diskWriter)
@@ -114,7 +121,13 @@ bool DiskWriterEntry::operator<(const DiskWriterEntry& entry) const
   return *fileEntry_ < *entry.fileEntry_;
 }
 
-MultiDiskAdaptor::MultiDiskAdaptor() : pieceLength_{0}, readOnly_{false} {}
+MultiDiskAdaptor::MultiDiskAdaptor()
+    : pieceLength_{0},
+      readOnly_{false},
+      enableMmap_{false},
+      enableDirectIO_{false}
+{
+}
 
 MultiDiskAdaptor::~MultiDiskAdaptor() { closeFile(); }
 
@@ -131,12 +144,17 @@ createDiskWriterEntry(const std::shared_ptr<FileEntry>& fileEntry)
 void MultiDiskAdaptor::resetDiskWriterEntries()
 {
   assert(openedDiskWriterEntries_.empty());
+  writebackEntries_.clear();
   diskWriterEntries_.clear();
+  offsets_.clear();
   if (getFileEntries().empty()) {
     return;
   }
+  diskWriterEntries_.reserve(getFileEntries().size());
+  offsets_.reserve(getFileEntries().size());
   for (auto& fileEntry : getFileEntries()) {
     diskWriterEntries_.push_back(createDiskWriterEntry(fileEntry));
+    offsets_.push_back(fileEntry->getOffset());
   }
   // TODO Currently, pieceLength_ == 0 is used for unit testing only.
   if (pieceLength_ > 0) {
@@ -178,34 +196,39 @@ void MultiDiskAdaptor::resetDiskWriterEntries()
       }
     }
   }
-  DefaultDiskWriterFactory dwFactory;
-  for (auto& dwent : diskWriterEntries_) {
-    if (dwent->needsFileAllocation() || dwent->needsDiskWriter() ||
-        dwent->fileExists()) {
-      A2_LOG_DEBUG(fmt("Creating DiskWriter for filename=%s",
-                       dwent->getFilePath().c_str()));
-      dwent->setDiskWriter(dwFactory.newDiskWriter(dwent->getFilePath()));
-      if (readOnly_) {
-        dwent->getDiskWriter()->enableReadOnly();
-      }
-      // TODO mmap is not enabled at this moment. Call enableMmap()
-      // after this function call.
-    }
+  // DiskWriters are created when the files are opened, so that a
+  // torrent with a huge number of files does not allocate them all
+  // at once.
+}
+
+void MultiDiskAdaptor::createDiskWriter(DiskWriterEntry* entry)
+{
+  if (entry->getDiskWriter() || !entry->usesDiskWriter()) {
+    return;
+  }
+  A2_LOG_DEBUG(
+      fmt("Creating DiskWriter for filename=%s", entry->getFilePath().c_str()));
+  auto dw = DefaultDiskWriterFactory().newDiskWriter(entry->getFilePath());
+  if (readOnly_) {
+    dw->enableReadOnly();
   }
+  if (enableMmap_) {
+    dw->enableMmap();
+  }
+  if (enableDirectIO_) {
+    dw->enableDirectIO();
+  }
+  entry->setDiskWriter(std::move(dw));
 }
 
 size_t MultiDiskAdaptor::tryCloseFile(size_t numClose)
 {
   size_t left = numClose;
   for (; !openedDiskWriterEntries_.empty() && left > 0; --left) {
-    // Choose one DiskWriterEntry randomly and close it.
-    size_t index = SimpleRandomizer::getInstance()->getRandomNumber(
-        openedDiskWriterEntries_.size());
-    auto i = std::begin(openedDiskWriterEntries_);
-    std::advance(i, index);
-    (*i)->closeFile();
-    (*i) = openedDiskWriterEntries_.back();
-    openedDiskWriterEntries_.pop_back();
+    auto entry = openedDiskWriterEntries_.front();
+    entry->closeFile();
+    addWritebackEntry(entry);
+    openedDiskWriterEntries_.pop_front();
   }
   return numClose - left;
 }
@@ -213,20 +236,35 @@ size_t MultiDiskAdaptor::tryCloseFile(size_t numClose)
 void MultiDiskAdaptor::openIfNot(DiskWriterEntry* entry,
                                  void (DiskWriterEntry::*open)())
 {
-  if (!entry->isOpen()) {
-    // A2_LOG_NOTICE(fmt("DiskWriterEntry: Cache MISS. offset=%s",
-    //        util::itos(entry->getFileEntry()->getOffset()).c_str()));
-    auto& openedFileCounter = getOpenedFileCounter();
+  if (entry->isOpen()) {
+    // Now the most recently used one
+    openedDiskWriterEntries_.splice(std::end(openedDiskWriterEntries_),
+                                    openedDiskWriterEntries_,
+                                    entry->openedPos_);
+    return;
+  }
+  createDiskWriter(entry);
+  if (!entry->getDiskWriter()) {
+    return;
+  }
+  auto& openedFileCounter = getOpenedFileCounter();
+  if (openedFileCounter) {
+    openedFileCounter->ensureMaxOpenFileLimit(1);
+  }
+  try {
+    (entry->*open)();
+  }
+  catch (RecoverableException& e) {
     if (openedFileCounter) {
-      openedFileCounter->ensureMaxOpenFileLimit(1);
+      openedFileCounter->reduceNumOfOpenedFile(1);
     }
-    (entry->*open)();
-    openedDiskWriterEntries_.push_back(entry);
+    throw;
   }
-  else {
-    // A2_LOG_NOTICE(fmt("DiskWriterEntry: Cache HIT. offset=%s",
-    //        util::itos(entry->getFileEntry()->getOffset()).c_str()));
+  if (openedFileCounter && openedDiskWriterEntries_.empty()) {
+    openedFileCounter->addDiskAdaptor(this);
   }
+  entry->openedPos_ = openedDiskWriterEntries_.insert(
+      std::end(openedDiskWriterEntries_), entry);
 }
 
 void MultiDiskAdaptor::openFile()
@@ -235,10 +273,12 @@ void MultiDiskAdaptor::openFile()
   // util::mkdir() is called in AbstractDiskWriter::createFile(), so
   // we don't need to call it here.
 
-  // Call DiskWriterEntry::openFile to make sure that zero-length files are
-  // created.
+  // Call DiskWriterEntry::openFile to make sure that zero-length files
+  // are created.  The other files are opened when they are accessed.
   for (auto& dwent : diskWriterEntries_) {
-    openIfNot(dwent.get(), &DiskWriterEntry::openFile);
+    if (dwent->getFileEntry()->getLength() == 0) {
+      openIfNot(dwent.get(), &DiskWriterEntry::openFile);
+    }
   }
 }
 
@@ -262,17 +302,14 @@ void MultiDiskAdaptor::openExistingFile()
 
 void MultiDiskAdaptor::closeFile()
 {
-  for (auto& dwent : openedDiskWriterEntries_) {
-    auto& dw = dwent->getDiskWriter();
-    // required for unit test
-    if (!dw) {
-      continue;
-    }
-    dw->closeFile();
+  for (auto dwent : openedDiskWriterEntries_) {
+    dwent->closeFile();
+    addWritebackEntry(dwent);
   }
   auto& openedFileCounter = getOpenedFileCounter();
   if (openedFileCounter) {
     openedFileCounter->reduceNumOfOpenedFile(openedDiskWriterEntries_.size());
+    openedFileCounter->removeDiskAdaptor(this);
   }
   openedDiskWriterEntries_.clear();
 }
@@ -297,33 +334,19 @@ ssize_t calculateLength(DiskWriterEntry* entry, int64_t fileOffset, ssize_t rem)
 }
 } // namespace
 
-namespace {
-class OffsetCompare {
-public:
-  bool operator()(int64_t offset, const std::unique_ptr<DiskWriterEntry>& dwe)
-  {
-    return offset < dwe->getFileEntry()->getOffset();
-  }
-};
-} // namespace
-
-namespace {
 DiskWriterEntries::const_iterator
-findFirstDiskWriterEntry(const DiskWriterEntries& diskWriterEntries,
-                         int64_t offset)
+MultiDiskAdaptor::findFirstDiskWriterEntry(int64_t offset)
 {
-  auto first =
-      std::upper_bound(std::begin(diskWriterEntries),
-                       std::end(diskWriterEntries), offset, OffsetCompare());
-  --first;
+  auto index =
+      std::upper_bound(std::begin(offsets_), std::end(offsets_), offset) -
+      std::begin(offsets_);
   // In case when offset is out-of-range
-  if (!isInRange((*first).get(), offset)) {
+  if (index == 0 || !isInRange(diskWriterEntries_[index - 1].get(), offset)) {
     throw DL_ABORT_EX(
         fmt(EX_FILE_OFFSET_OUT_OF_RANGE, static_cast<int64_t>(offset)));
   }
-  return first;
+  return std::begin(diskWriterEntries_) + (index - 1);
 }
-} // namespace
 
 namespace {
 void throwOnDiskWriterNotOpened(DiskWriterEntry* e, int64_t offset)
@@ -337,7 +360,7 @@ void throwOnDiskWriterNotOpened(DiskWriterEntry* e, int64_t offset)
 void MultiDiskAdaptor::writeData(const unsigned char* data, size_t len,
                                  int64_t offset)
 {
-  auto first = findFirstDiskWriterEntry(diskWriterEntries_, offset);
+  auto first = findFirstDiskWriterEntry(offset);
   ssize_t rem = len;
   int64_t fileOffset = offset - (*first)->getFileEntry()->getOffset();
   for (auto i = first, eoi = diskWriterEntries_.cend(); i != eoi; ++i) {
@@ -357,6 +380,55 @@ void MultiDiskAdaptor::writeData(const unsigned char* data, size_t len,
   }
 }
 
+void MultiDiskAdaptor::writeDataVector(const a2iovec* iov, size_t iovcnt,
+                                       int64_t offset)
+{
+  ssize_t len = 0;
+  for (size_t i = 0; i < iovcnt; ++i) {
+    len += iov[i].A2IOVEC_LEN;
+  }
+  auto first = findFirstDiskWriterEntry(offset);
+  ssize_t rem = len;
+  int64_t fileOffset = offset - (*first)->getFileEntry()->getOffset();
+  // The buffers are split at file boundaries.  |iov[idx] + bufOffset|
+  // is the first byte not yet assigned to a file.
+  size_t idx = 0;
+  size_t bufOffset = 0;
+  std::vector<a2iovec> fileIov;
+  for (auto i = first, eoi = diskWriterEntries_.cend(); i != eoi; ++i) {
+    ssize_t writeLength = calculateLength((*i).get(), fileOffset, rem);
+    openIfNot((*i).get(), &DiskWriterEntry::openFile);
+    if (!(*i)->isOpen()) {
+      throwOnDiskWriterNotOpened((*i).get(), offset + (len - rem));
+    }
+
+    fileIov.clear();
+    for (auto n = writeLength; n > 0;) {
+      auto l = std::min(static_cast<size_t>(n),
+                        static_cast<size_t>(iov[idx].A2IOVEC_LEN) - bufOffset);
+      if (l > 0) {
+        a2iovec v;
+        v.A2IOVEC_BASE = static_cast<char*>(iov[idx].A2IOVEC_BASE) + bufOffset;
+        v.A2IOVEC_LEN = l;
+        fileIov.push_back(v);
+      }
+      n -= l;
+      bufOffset += l;
+      if (bufOffset == iov[idx].A2IOVEC_LEN) {
+        ++idx;
+        bufOffset = 0;
+      }
+    }
+    (*i)->getDiskWriter()->writeDataVector(fileIov.data(), fileIov.size(),
+                                           fileOffset);
+    rem -= writeLength;
+    fileOffset = 0;
+    if (rem == 0) {
+      break;
+    }
+  }
+}
+
 ssize_t MultiDiskAdaptor::readData(unsigned char* data, size_t len,
                                    int64_t offset)
 {
@@ -372,7 +444,7 @@ ssize_t MultiDiskAdaptor::readDataDropCache(unsigned char* data, size_t len,
 ssize_t MultiDiskAdaptor::readData(unsigned char* data, size_t len,
                                    int64_t offset, bool dropCache)
 {
-  auto first = findFirstDiskWriterEntry(diskWriterEntries_, offset);
+  auto first = findFirstDiskWriterEntry(offset);
   ssize_t rem = len;
   ssize_t totalReadLength = 0;
   int64_t fileOffset = offset - (*first)->getFileEntry()->getOffset();
@@ -410,15 +482,6 @@ ssize_t MultiDiskAdaptor::readData(unsigned char* data, size_t len,
   return totalReadLength;
 }
 
-void MultiDiskAdaptor::writeCache(const WrDiskCacheEntry* entry)
-{
-  for (auto& d : entry->getDataSet()) {
-    A2_LOG_DEBUG(fmt("Cache flush goff=%" PRId64 ", len=%lu", d->goff,
-                     static_cast<unsigned long>(d->len)));
-    writeData(d->data + d->offset, d->len, d->goff);
-  }
-}
-
 void MultiDiskAdaptor::flushOSBuffers()
 {
   for (auto& dwent : openedDiskWriterEntries_) {
@@ -428,6 +491,81 @@ void MultiDiskAdaptor::flushOSBuffers()
     }
     dw->flushOSBuffers();
   }
+  // The errors with which closing the files failed to synchronize
+  // them.
+  try {
+    waitWriteback(std::numeric_limits<size_t>::max());
+  }
+  catch (RecoverableException& e) {
+    A2_LOG_ERROR_EX(EX_EXCEPTION_CAUGHT, e);
+  }
+}
+
+void MultiDiskAdaptor::addWritebackEntry(DiskWriterEntry* entry)
+{
+  if (!entry->writeback_) {
+    entry->writeback_ = true;
+    writebackEntries_.push_back(entry);
+  }
+}
+
+void MultiDiskAdaptor::startWriteback()
+{
+  for (auto dwent : openedDiskWriterEntries_) {
+    dwent->getDiskWriter()->startWriteback();
+    addWritebackEntry(dwent);
+  }
+}
+
+bool MultiDiskAdaptor::waitWriteback(size_t maxFiles)
+{
+  // An entry which fails is dropped as well, and the rest are still
+  // waited for.  The first error is thrown at the end, so that the
+  // caller can fall back to saving the control file in full.
+  std::exception_ptr error;
+  size_t numSynced = 0;
+  while (!writebackEntries_.empty() && numSynced < maxFiles) {
+    auto entry = writebackEntries_.back();
+    entry->writeback_ = false;
+    writebackEntries_.pop_back();
+    try {
+      if (entry->getDiskWriter()->waitWriteback()) {
+        ++numSynced;
+      }
+    }
+    catch (RecoverableException& e) {
+      if (error) {
+        A2_LOG_ERROR_EX(EX_EXCEPTION_CAUGHT, e);
+      }
+      else {
+        error = std::current_exception();
+      }
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  return writebackEntries_.empty();
+}
+
+int64_t MultiDiskAdaptor::seekData(int64_t offset)
+{
+  auto first = findFirstDiskWriterEntry(offset);
+  for (auto i = first, eoi = diskWriterEntries_.cend(); i != eoi; ++i) {
+    auto& fileEntry = (*i)->getFileEntry();
+    openIfNot((*i).get(), &DiskWriterEntry::openFile);
+    if (!(*i)->isOpen()) {
+      return offset;
+    }
+    auto dataOffset = (*i)->getDiskWriter()->seekData(
+        offset - fileEntry->getOffset());
+    if (dataOffset < fileEntry->getLength()) {
+      return fileEntry->getOffset() + dataOffset;
+    }
+    // The rest of this file is a hole.
+    offset = fileEntry->getLastOffset();
+  }
+  return offset;
 }
 
 bool MultiDiskAdaptor::fileExists()
@@ -458,6 +596,7 @@ void MultiDiskAdaptor::disableReadOnly() { readOnly_ = false; }
 
 void MultiDiskAdaptor::enableMmap()
 {
+  enableMmap_ = true;
   for (auto& dwent : diskWriterEntries_) {
     auto& dw = dwent->getDiskWriter();
     if (dw) {
@@ -466,6 +605,17 @@ void MultiDiskAdaptor::enableMmap()
   }
 }
 
+void MultiDiskAdaptor::enableDirectIO()
+{
+  enableDirectIO_ = true;
+  for (auto& dwent : diskWriterEntries_) {
+    auto& dw = dwent->getDiskWriter();
+    if (dw) {
+      dw->enableDirectIO();
+    }
+  }
+}
+
 void MultiDiskAdaptor::cutTrailingGarbage()
 {
   for (auto& dwent : diskWriterEntries_) {
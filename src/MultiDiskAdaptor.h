@@ -37,6 +37,9 @@
 
 #include "DiskAdaptor.h"
 
+#include <list>
+#include <vector>
+
 namespace aria2 {
 
 class MultiFileAllocationIterator;
@@ -45,9 +48,16 @@ class DiskWriter;
 
 class DiskWriterEntry {
 private:
+  friend class MultiDiskAdaptor;
+
   std::shared_ptr<FileEntry> fileEntry_;
   std::unique_ptr<DiskWriter> diskWriter_;
+  // Position in MultiDiskAdaptor::openedDiskWriterEntries_ while the
+  // file is open.
+  std::list<DiskWriterEntry*>::iterator openedPos_;
   bool open_;
+  // True if the entry is in MultiDiskAdaptor::writebackEntries_.
+  bool writeback_;
   bool needsFileAllocation_;
   bool needsDiskWriter_;
 
@@ -88,6 +98,12 @@ public:
   bool needsDiskWriter() const { return needsDiskWriter_; }
 
   void needsDiskWriter(bool f) { needsDiskWriter_ = f; }
+
+  // Returns true if the file is read or written through this entry,
+  // that is, it needs file allocation, it needs DiskWriter or the
+  // file exists.  The DiskWriter of such an entry is created when it
+  // is opened for the first time.
+  bool usesDiskWriter();
 };
 
 typedef std::vector<std::unique_ptr<DiskWriterEntry>> DiskWriterEntries;
@@ -98,15 +114,34 @@ class MultiDiskAdaptor : public DiskAdaptor {
 private:
   int32_t pieceLength_;
   DiskWriterEntries diskWriterEntries_;
-
-  std::vector<DiskWriterEntry*> openedDiskWriterEntries_;
+  // The offset of each entry in diskWriterEntries_, so that the entry
+  // at a given offset is found by binary search without touching the
+  // entries.
+  std::vector<int64_t> offsets_;
+
+  // Open entries, least recently used first.
+  std::list<DiskWriterEntry*> openedDiskWriterEntries_;
+  // The entries which may have the data being written back, which
+  // waitWriteback() waits for.  They include the entries closed since
+  // then, which only report the error with which closing them failed
+  // to synchronize the data.
+  std::vector<DiskWriterEntry*> writebackEntries_;
 
   bool readOnly_;
+  bool enableMmap_;
+  bool enableDirectIO_;
 
   void resetDiskWriterEntries();
 
+  // Creates the DiskWriter of |entry| if it uses one.
+  void createDiskWriter(DiskWriterEntry* entry);
+
+  DiskWriterEntries::const_iterator findFirstDiskWriterEntry(int64_t offset);
+
   void openIfNot(DiskWriterEntry* entry, void (DiskWriterEntry::*f)());
 
+  void addWritebackEntry(DiskWriterEntry* entry);
+
   ssize_t readData(unsigned char* data, size_t len, int64_t offset,
                    bool dropCache);
 
@@ -127,16 +162,23 @@ public:
   virtual void writeData(const unsigned char* data, size_t len,
                          int64_t offset) CXX11_OVERRIDE;
 
+  virtual void writeDataVector(const a2iovec* iov, size_t iovcnt,
+                               int64_t offset) CXX11_OVERRIDE;
+
   virtual ssize_t readData(unsigned char* data, size_t len,
                            int64_t offset) CXX11_OVERRIDE;
 
   virtual ssize_t readDataDropCache(unsigned char* data, size_t len,
                                     int64_t offset) CXX11_OVERRIDE;
 
-  virtual void writeCache(const WrDiskCacheEntry* entry) CXX11_OVERRIDE;
-
   virtual void flushOSBuffers() CXX11_OVERRIDE;
 
+  virtual void startWriteback() CXX11_OVERRIDE;
+
+  virtual bool waitWriteback(size_t maxFiles) CXX11_OVERRIDE;
+
+  virtual int64_t seekData(int64_t offset) CXX11_OVERRIDE;
+
   virtual bool fileExists() CXX11_OVERRIDE;
 
   virtual int64_t size() CXX11_OVERRIDE;
@@ -150,10 +192,12 @@ public:
 
   virtual bool isReadOnlyEnabled() const CXX11_OVERRIDE { return readOnly_; }
 
-  // Enables mmap feature. This method must be called after files are
-  // opened.
+  // Enables mmap feature.  The files opened later also use mmap.
   virtual void enableMmap() CXX11_OVERRIDE;
 
+  // Enables direct I/O.  The files opened later also use direct I/O.
+  virtual void enableDirectIO() CXX11_OVERRIDE;
+
   void setPieceLength(int32_t pieceLength) { pieceLength_ = pieceLength; }
 
   int32_t getPieceLength() const { return pieceLength_; }
@@ -167,6 +211,7 @@ public:
     return diskWriterEntries_;
   }
 
+  // Closes the least recently used files.
   virtual size_t tryCloseFile(size_t numClose) CXX11_OVERRIDE;
 };
 
@@ -77,7 +77,7 @@ void MultiFileAllocationIterator::allocateChunk()
   }
 
   while (entryItr_ != std::end(diskAdaptor_->getDiskWriterEntries())) {
-    if (!(*entryItr_)->getDiskWriter()) {
+    if (!(*entryItr_)->usesDiskWriter()) {
       ++entryItr_;
       continue;
     }
@@ -72,6 +72,7 @@
 #endif // !ENABLE_WEBSOCKET
 #ifdef ENABLE_SSL
 #  include "TLSContext.h"
+#  include "TLSSessionCache.h"
 #endif // ENABLE_SSL
 #ifdef ENABLE_ASYNC_DNS
 #  include "AsyncNameResolver.h"
@@ -346,6 +347,14 @@ error_code::Value MultiUrlRequestInfo::getResult()
           fmt(_("Failed to serialize session to '%s'."), filename.c_str()));
     }
   }
+#ifdef ENABLE_SSL
+  {
+    auto& tlsContext = SocketCore::getClientTLSContext();
+    if (tlsContext && tlsContext->getSessionCache()) {
+      tlsContext->getSessionCache()->log();
+    }
+  }
+#endif // ENABLE_SSL
   SingletonHolder<Notifier>::clear();
   return returnValue;
 }
@@ -45,7 +45,10 @@
 
 namespace aria2 {
 
-NameResolver::NameResolver() : socktype_(0), family_(AF_UNSPEC) {}
+NameResolver::NameResolver()
+    : socktype_(0), family_(AF_UNSPEC), notFound_(false)
+{
+}
 
 void NameResolver::resolve(std::vector<std::string>& resolvedAddresses,
                            const std::string& hostname)
@@ -54,7 +57,12 @@ void NameResolver::resolve(std::vector<std::string>& resolvedAddresses,
   int s;
   s = callGetaddrinfo(&res, hostname.c_str(), nullptr, family_, socktype_, 0,
                       0);
+  notFound_ = false;
   if (s) {
+    notFound_ = s == EAI_NONAME;
+#ifdef EAI_NODATA
+    notFound_ = notFound_ || s == EAI_NODATA;
+#endif // EAI_NODATA
     throw DL_ABORT_EX2(
         fmt(EX_RESOLVE_HOSTNAME, hostname.c_str(), gai_strerror(s)),
         error_code::NAME_RESOLVE_ERROR);
@@ -45,6 +45,7 @@ class NameResolver {
 private:
   int socktype_;
   int family_;
+  bool notFound_;
 
 public:
   NameResolver();
@@ -60,6 +61,10 @@ public:
 
   // specify protocol family
   void setFamily(int family) { family_ = family; }
+
+  // Returns true if the last resolve() failed because the hostname
+  // does not exist, rather than a temporary failure.
+  bool notFound() const { return notFound_; }
 };
 
 } // namespace aria2
@@ -50,6 +50,12 @@ public:
 
   virtual void save() CXX11_OVERRIDE {}
 
+  virtual bool needsSave() CXX11_OVERRIDE { return false; }
+
+  virtual void checkpoint() CXX11_OVERRIDE {}
+
+  virtual void saveCheckpoint() CXX11_OVERRIDE {}
+
   virtual void load() CXX11_OVERRIDE {}
 
   virtual void removeFile() CXX11_OVERRIDE {}
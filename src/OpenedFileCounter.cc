@@ -35,24 +35,20 @@
 #include "OpenedFileCounter.h"
 
 #include <cassert>
+#include <algorithm>
 
-#include "RequestGroupMan.h"
-#include "RequestGroup.h"
-#include "PieceStorage.h"
 #include "DiskAdaptor.h"
-#include "SimpleRandomizer.h"
 
 namespace aria2 {
 
-OpenedFileCounter::OpenedFileCounter(RequestGroupMan* rgman,
-                                     size_t maxOpenFiles)
-    : rgman_(rgman), maxOpenFiles_(maxOpenFiles), numOpenFiles_(0)
+OpenedFileCounter::OpenedFileCounter(size_t maxOpenFiles)
+    : next_(0), maxOpenFiles_(maxOpenFiles), numOpenFiles_(0), active_(true)
 {
 }
 
 void OpenedFileCounter::ensureMaxOpenFileLimit(size_t numNewFiles)
 {
-  if (!rgman_) {
+  if (!active_) {
     return;
   }
 
@@ -64,34 +60,21 @@ void OpenedFileCounter::ensureMaxOpenFileLimit(size_t numNewFiles)
   size_t numClose = numOpenFiles_ + numNewFiles - maxOpenFiles_;
   size_t left = numClose;
 
-  auto& requestGroups = rgman_->getRequestGroups();
-
-  auto mark = std::begin(requestGroups);
-  std::advance(mark, SimpleRandomizer::getInstance()->getRandomNumber(
-                         requestGroups.size()));
-
-  auto closeFun = [&left](const std::shared_ptr<RequestGroup>& group) {
-    auto& ps = group->getPieceStorage();
-
-    if (!ps) {
-      return;
+  while (left > 0 && !diskAdaptors_.empty()) {
+    if (next_ >= diskAdaptors_.size()) {
+      next_ = 0;
     }
-
-    auto diskAdaptor = ps->getDiskAdaptor();
-
-    if (!diskAdaptor) {
-      return;
+    auto diskAdaptor = diskAdaptors_[next_];
+    auto n = diskAdaptor->tryCloseFile(left);
+    if (n < left) {
+      // diskAdaptor has no open file now.
+      diskAdaptors_[next_] = diskAdaptors_.back();
+      diskAdaptors_.pop_back();
     }
-
-    left -= diskAdaptor->tryCloseFile(left);
-  };
-
-  for (auto i = mark; i != std::end(requestGroups) && left > 0; ++i) {
-    closeFun(*i);
-  }
-
-  for (auto i = std::begin(requestGroups); i != mark && left > 0; ++i) {
-    closeFun(*i);
+    else {
+      ++next_;
+    }
+    left -= n;
   }
 
   assert(left == 0);
@@ -100,7 +83,7 @@ void OpenedFileCounter::ensureMaxOpenFileLimit(size_t numNewFiles)
 
 void OpenedFileCounter::reduceNumOfOpenedFile(size_t numCloseFiles)
 {
-  if (!rgman_) {
+  if (!active_) {
     return;
   }
 
@@ -108,6 +91,29 @@ void OpenedFileCounter::reduceNumOfOpenedFile(size_t numCloseFiles)
   numOpenFiles_ -= numCloseFiles;
 }
 
-void OpenedFileCounter::deactivate() { rgman_ = nullptr; }
+void OpenedFileCounter::addDiskAdaptor(DiskAdaptor* diskAdaptor)
+{
+  if (!active_ || std::find(std::begin(diskAdaptors_), std::end(diskAdaptors_),
+                            diskAdaptor) != std::end(diskAdaptors_)) {
+    return;
+  }
+  diskAdaptors_.push_back(diskAdaptor);
+}
+
+void OpenedFileCounter::removeDiskAdaptor(DiskAdaptor* diskAdaptor)
+{
+  auto i = std::find(std::begin(diskAdaptors_), std::end(diskAdaptors_),
+                     diskAdaptor);
+  if (i != std::end(diskAdaptors_)) {
+    *i = diskAdaptors_.back();
+    diskAdaptors_.pop_back();
+  }
+}
+
+void OpenedFileCounter::deactivate()
+{
+  active_ = false;
+  diskAdaptors_.clear();
+}
 
 } // namespace aria2
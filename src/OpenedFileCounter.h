@@ -37,13 +37,15 @@
 
 #include "common.h"
 
+#include <vector>
+
 namespace aria2 {
 
-class RequestGroupMan;
+class DiskAdaptor;
 
 class OpenedFileCounter {
 public:
-  OpenedFileCounter(RequestGroupMan* rgman, size_t maxOpenFiles);
+  OpenedFileCounter(size_t maxOpenFiles);
 
   // Keeps the number of open files under the global limit specified
   // in the option.  The caller requests that |numNewFiles| files are
@@ -57,15 +59,29 @@ public:
   // Reduces the number of open files managed by this object.
   void reduceNumOfOpenedFile(size_t numCloseFiles);
 
+  // Adds |diskAdaptor|, which has opened a file, to the DiskAdaptors
+  // whose files are closed to keep the limit.  Does nothing if it has
+  // been added.
+  void addDiskAdaptor(DiskAdaptor* diskAdaptor);
+
+  // Removes |diskAdaptor| added by addDiskAdaptor().  This function
+  // must be called before |diskAdaptor| is destroyed.
+  void removeDiskAdaptor(DiskAdaptor* diskAdaptor);
+
   void setMaxOpenFiles(size_t maxOpenFiles) { maxOpenFiles_ = maxOpenFiles; }
 
   // Deactivates this object.
   void deactivate();
 
 private:
-  RequestGroupMan* rgman_;
+  // DiskAdaptors which may have open files.  Files are closed in
+  // round-robin fashion starting at diskAdaptors_[next_], so that
+  // the number of DiskAdaptors without open files does not matter.
+  std::vector<DiskAdaptor*> diskAdaptors_;
+  size_t next_;
   size_t maxOpenFiles_;
   size_t numOpenFiles_;
+  bool active_;
 };
 
 } // namespace aria2
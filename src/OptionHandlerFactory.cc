@@ -235,6 +235,19 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->hide();
     handlers.push_back(op);
   }
+  {
+    OptionHandler* op(new NumberOptionHandler(
+        PREF_DNS_CACHE_TTL, TEXT_DNS_CACHE_TTL, "300", 1, 86400));
+    op->addTag(TAG_ADVANCED);
+    handlers.push_back(op);
+  }
+  {
+    OptionHandler* op(new NumberOptionHandler(PREF_DNS_NEGATIVE_CACHE_TTL,
+                                              TEXT_DNS_NEGATIVE_CACHE_TTL, "10",
+                                              0, 86400));
+    op->addTag(TAG_ADVANCED);
+    handlers.push_back(op);
+  }
   {
     OptionHandler* op(new ParameterOptionHandler(
         PREF_DOWNLOAD_RESULT, TEXT_DOWNLOAD_RESULT, A2_V_DEFAULT,
@@ -263,6 +276,20 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->addTag(TAG_ADVANCED);
     handlers.push_back(op);
   }
+  {
+    OptionHandler* op(new BooleanOptionHandler(
+        PREF_ENABLE_ENGINE_PROFILE, TEXT_ENABLE_ENGINE_PROFILE, A2_V_FALSE,
+        OptionHandler::OPT_ARG));
+    op->addTag(TAG_ADVANCED);
+    handlers.push_back(op);
+  }
+  {
+    OptionHandler* op(new NumberOptionHandler(PREF_ENGINE_PROFILE_INTERVAL,
+                                              TEXT_ENGINE_PROFILE_INTERVAL,
+                                              "60", 0, 86400));
+    op->addTag(TAG_ADVANCED);
+    handlers.push_back(op);
+  }
 #if defined(HAVE_MMAP) || defined(__MINGW32__)
   {
     OptionHandler* op(new BooleanOptionHandler(PREF_ENABLE_MMAP,
@@ -276,6 +303,20 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     handlers.push_back(op);
   }
 #endif // HAVE_MMAP || __MINGW32__
+#ifdef HAVE_O_DIRECT
+  {
+    OptionHandler* op(new BooleanOptionHandler(PREF_ENABLE_DIRECT_IO,
+                                               TEXT_ENABLE_DIRECT_IO,
+                                               A2_V_FALSE,
+                                               OptionHandler::OPT_ARG));
+    op->addTag(TAG_ADVANCED);
+    op->addTag(TAG_EXPERIMENTAL);
+    op->setInitialOption(true);
+    op->setChangeGlobalOption(true);
+    op->setChangeOptionForReserved(true);
+    handlers.push_back(op);
+  }
+#endif // HAVE_O_DIRECT
   {
     OptionHandler* op(new BooleanOptionHandler(
         PREF_ENABLE_RPC, TEXT_ENABLE_RPC, A2_V_FALSE, OptionHandler::OPT_ARG));
@@ -449,6 +490,16 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->setChangeOptionForReserved(true);
     handlers.push_back(op);
   }
+  {
+    OptionHandler* op(new NumberOptionHandler(PREF_MAX_HOST_CONNECTIONS,
+                                              TEXT_MAX_HOST_CONNECTIONS, "0",
+                                              0));
+    op->addTag(TAG_ADVANCED);
+    op->addTag(TAG_FTP);
+    op->addTag(TAG_HTTP);
+    op->setChangeGlobalOption(true);
+    handlers.push_back(op);
+  }
   {
     OptionHandler* op(new UnitNumberOptionHandler(
         PREF_MAX_DOWNLOAD_LIMIT, TEXT_MAX_DOWNLOAD_LIMIT, "0", 0));
@@ -1086,6 +1137,20 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->setChangeOptionForReserved(true);
     handlers.push_back(op);
   }
+#if defined(HAVE_LIBNGHTTP2) && defined(ENABLE_SSL)
+  {
+    OptionHandler* op(new BooleanOptionHandler(PREF_ENABLE_HTTP2,
+                                               TEXT_ENABLE_HTTP2, A2_V_FALSE,
+                                               OptionHandler::OPT_ARG));
+    op->addTag(TAG_ADVANCED);
+    op->addTag(TAG_HTTP);
+    op->addTag(TAG_HTTPS);
+    op->setInitialOption(true);
+    op->setChangeGlobalOption(true);
+    op->setChangeOptionForReserved(true);
+    handlers.push_back(op);
+  }
+#endif // HAVE_LIBNGHTTP2 && ENABLE_SSL
   {
     OptionHandler* op(new CumulativeOptionHandler(PREF_HEADER, TEXT_HEADER,
                                                   NO_DEFAULT_VALUE, "\n"));
@@ -1256,6 +1321,16 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->setChangeOptionForReserved(true);
     handlers.push_back(op);
   }
+  {
+    OptionHandler* op(new BooleanOptionHandler(
+        PREF_FTP_PIPELINING, TEXT_FTP_PIPELINING, A2_V_FALSE,
+        OptionHandler::OPT_ARG));
+    op->addTag(TAG_FTP);
+    op->setInitialOption(true);
+    op->setChangeGlobalOption(true);
+    op->setChangeOptionForReserved(true);
+    handlers.push_back(op);
+  }
   {
     OptionHandler* op(new ParameterOptionHandler(
         PREF_FTP_TYPE, TEXT_FTP_TYPE, V_BINARY, {V_BINARY, V_ASCII}));
@@ -1547,6 +1622,13 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->setChangeOptionForReserved(true);
     handlers.push_back(op);
   }
+  {
+    OptionHandler* op(new UnitNumberOptionHandler(
+        PREF_BT_READ_CACHE, TEXT_BT_READ_CACHE, "0", 0));
+    op->addTag(TAG_ADVANCED);
+    op->addTag(TAG_BITTORRENT);
+    handlers.push_back(op);
+  }
   {
     OptionHandler* op(new DefaultOptionHandler(
         PREF_BT_LPD_INTERFACE, TEXT_BT_LPD_INTERFACE, NO_DEFAULT_VALUE,
@@ -1761,6 +1843,13 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->addTag(TAG_BITTORRENT);
     handlers.push_back(op);
   }
+  {
+    OptionHandler* op(new NumberOptionHandler(PREF_DHT_LOOKUP_CONCURRENCY,
+                                              TEXT_DHT_LOOKUP_CONCURRENCY,
+                                              "5", 1, 8));
+    op->addTag(TAG_BITTORRENT);
+    handlers.push_back(op);
+  }
   {
     OptionHandler* op(new NumberOptionHandler(
         PREF_DHT_MESSAGE_TIMEOUT, TEXT_DHT_MESSAGE_TIMEOUT, "10", 1, 60));
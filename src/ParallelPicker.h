@@ -0,0 +1,110 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_PARALLEL_PICKER_H
+#define D_PARALLEL_PICKER_H
+
+#include "common.h"
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace aria2 {
+
+// Like SequentialPicker, but more than one entry can be picked at a
+// time.  Each entry is pushed with a key, and at most one entry is
+// picked for each key.  Entries are picked in the order they were
+// pushed, skipping the ones whose key is in use.
+template <typename T> class ParallelPicker {
+private:
+  std::deque<std::pair<uint64_t, std::unique_ptr<T>>> entries_;
+  std::vector<std::unique_ptr<T>> pickedEntries_;
+  // The key of each entry in pickedEntries_
+  std::vector<uint64_t> pickedKeys_;
+
+public:
+  bool isPicked() const { return !pickedEntries_.empty(); }
+
+  // Returns the picked entries, the oldest first.
+  const std::vector<std::unique_ptr<T>>& getPickedEntries() const
+  {
+    return pickedEntries_;
+  }
+
+  void dropPickedEntry(T* entry)
+  {
+    for (size_t i = 0; i < pickedEntries_.size(); ++i) {
+      if (pickedEntries_[i].get() == entry) {
+        pickedEntries_.erase(std::begin(pickedEntries_) + i);
+        pickedKeys_.erase(std::begin(pickedKeys_) + i);
+        return;
+      }
+    }
+  }
+
+  // Returns true if an entry is waiting to be picked, including the
+  // ones whose key is in use.
+  bool hasNext() const { return !entries_.empty(); }
+
+  // Picks the oldest entry whose key is not in use, and returns it.
+  // Returns nullptr if there is no such entry.
+  T* pickNext()
+  {
+    for (auto i = std::begin(entries_); i != std::end(entries_); ++i) {
+      if (std::find(std::begin(pickedKeys_), std::end(pickedKeys_),
+                    (*i).first) != std::end(pickedKeys_)) {
+        continue;
+      }
+      pickedKeys_.push_back((*i).first);
+      pickedEntries_.push_back(std::move((*i).second));
+      entries_.erase(i);
+      return pickedEntries_.back().get();
+    }
+    return nullptr;
+  }
+
+  void pushEntry(std::unique_ptr<T> entry, uint64_t key)
+  {
+    entries_.push_back(std::make_pair(key, std::move(entry)));
+  }
+
+  size_t countEntryInQueue() const { return entries_.size(); }
+};
+
+} // namespace aria2
+
+#endif // D_PARALLEL_PICKER_H
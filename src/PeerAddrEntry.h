@@ -40,28 +40,50 @@
 #include <string>
 
 #include "TimerA2.h"
+#include "BtConstants.h"
 
 namespace aria2 {
 
+// Peer address stored in the packed compact form (address followed
+// by port, both in network byte order), so that a DHT storage node
+// holding many peers does not keep a heap allocated string per
+// peer.
 class PeerAddrEntry {
 private:
-  std::string ipaddr_;
+  unsigned char compact_[COMPACT_LEN_IPV6];
 
-  uint16_t port_;
+  uint8_t compactlen_;
+
+  bool seed_;
 
   Timer lastUpdated_;
 
 public:
   PeerAddrEntry(const std::string& ipaddr, uint16_t port,
-                Timer updated = Timer());
+                Timer updated = Timer(), bool seed = false);
   PeerAddrEntry(const PeerAddrEntry& c);
   ~PeerAddrEntry();
 
   PeerAddrEntry& operator=(const PeerAddrEntry& c);
 
-  const std::string& getIPAddress() const { return ipaddr_; }
+  // Returns textual representation of the address. Returns empty
+  // string if the address given in the constructor could not be
+  // packed.
+  std::string getIPAddress() const;
+
+  uint16_t getPort() const;
+
+  // Returns compact address+port. Its length is given by
+  // getCompactLength().
+  const unsigned char* getCompact() const { return compact_; }
+
+  // Returns the length of compact form, that is COMPACT_LEN_IPV4 or
+  // COMPACT_LEN_IPV6. Returns 0 if the address is invalid.
+  size_t getCompactLength() const { return compactlen_; }
+
+  bool isSeed() const { return seed_; }
 
-  uint16_t getPort() const { return port_; }
+  void setSeed(bool seed) { seed_ = seed; }
 
   const Timer& getLastUpdated() const { return lastUpdated_; }
 
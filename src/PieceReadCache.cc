@@ -0,0 +1,164 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "PieceReadCache.h"
+
+#include <cassert>
+#include <cstring>
+
+#include "DiskAdaptor.h"
+#include "LogFactory.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+PieceReadCache::PieceReadCache(size_t limit)
+    : limit_(limit),
+      total_(0),
+      inTotal_(0),
+      ghostTotal_(0),
+      hits_(0),
+      misses_(0)
+{
+}
+
+ssize_t PieceReadCache::readData(unsigned char* data, size_t len,
+                                 int64_t offset, a2_gid_t gid, size_t index,
+                                 int64_t pieceOffset, int32_t pieceLength,
+                                 DiskAdaptor* diskAdaptor)
+{
+  assert(pieceOffset <= offset &&
+         offset + static_cast<int64_t>(len) <= pieceOffset + pieceLength);
+  auto key = Key(gid, index);
+  auto i = entries_.find(key);
+  if (i != std::end(entries_)) {
+    ++hits_;
+    auto& ent = *(*i).second;
+    if (ent.frequent) {
+      main_.splice(std::end(main_), main_, (*i).second);
+    }
+    memcpy(data, ent.data.data() + (offset - pieceOffset), len);
+    return len;
+  }
+  ++misses_;
+  // A piece larger than in_ cannot be cached.
+  if (static_cast<size_t>(pieceLength) > limit_ / 4) {
+    return diskAdaptor->readData(data, len, offset);
+  }
+  Entry ent{key, std::vector<unsigned char>(pieceLength), false};
+  auto r = diskAdaptor->readData(ent.data.data(), pieceLength, pieceOffset);
+  if (r != pieceLength) {
+    // Let the caller handle the short read.
+    return diskAdaptor->readData(data, len, offset);
+  }
+  memcpy(data, ent.data.data() + (offset - pieceOffset), len);
+  auto j = ghostIndex_.find(key);
+  EntryList* list;
+  if (j == std::end(ghostIndex_)) {
+    list = &in_;
+    inTotal_ += pieceLength;
+  }
+  else {
+    A2_LOG_DEBUG(fmt("Read cache: piece %lu of GID#%s is requested again",
+                     static_cast<unsigned long>(index),
+                     GroupId::toHex(gid).c_str()));
+    ghostTotal_ -= (*(*j).second).second;
+    ghosts_.erase((*j).second);
+    ghostIndex_.erase(j);
+    ent.frequent = true;
+    list = &main_;
+  }
+  total_ += pieceLength;
+  list->push_back(std::move(ent));
+  entries_.insert(std::make_pair(key, --std::end(*list)));
+  ensureLimit();
+  return len;
+}
+
+void PieceReadCache::evict(EntryList& list)
+{
+  auto& ent = list.front();
+  total_ -= ent.data.size();
+  if (!ent.frequent) {
+    inTotal_ -= ent.data.size();
+    ghosts_.push_back(std::make_pair(ent.key, ent.data.size()));
+    ghostIndex_.insert(std::make_pair(ent.key, --std::end(ghosts_)));
+    ghostTotal_ += ent.data.size();
+    // Remember as many pieces as half of the cache can hold.
+    while (ghostTotal_ > limit_ / 2) {
+      ghostTotal_ -= ghosts_.front().second;
+      ghostIndex_.erase(ghosts_.front().first);
+      ghosts_.pop_front();
+    }
+  }
+  entries_.erase(ent.key);
+  list.pop_front();
+}
+
+void PieceReadCache::ensureLimit()
+{
+  while (total_ > limit_) {
+    if (!in_.empty() && (inTotal_ > limit_ / 4 || main_.empty())) {
+      evict(in_);
+    }
+    else {
+      evict(main_);
+    }
+  }
+}
+
+void PieceReadCache::remove(a2_gid_t gid)
+{
+  for (auto i = entries_.lower_bound(Key(gid, 0));
+       i != std::end(entries_) && (*i).first.first == gid;) {
+    auto& ent = *(*i).second;
+    total_ -= ent.data.size();
+    if (ent.frequent) {
+      main_.erase((*i).second);
+    }
+    else {
+      inTotal_ -= ent.data.size();
+      in_.erase((*i).second);
+    }
+    entries_.erase(i++);
+  }
+  for (auto i = ghostIndex_.lower_bound(Key(gid, 0));
+       i != std::end(ghostIndex_) && (*i).first.first == gid;) {
+    ghostTotal_ -= (*(*i).second).second;
+    ghosts_.erase((*i).second);
+    ghostIndex_.erase(i++);
+  }
+}
+
+} // namespace aria2
@@ -0,0 +1,128 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_PIECE_READ_CACHE_H
+#define D_PIECE_READ_CACHE_H
+
+#include "common.h"
+
+#include <list>
+#include <map>
+#include <vector>
+
+#include "GroupId.h"
+
+namespace aria2 {
+
+class DiskAdaptor;
+
+// Caches whole pieces read from the disk to upload them to peers.
+// The first block request for a piece reads the whole piece, so that
+// the following requests for the piece, from the same peer or from
+// other peers, are served from memory.  The cache is shared by all
+// downloads and its total size is kept under the limit.
+//
+// Pieces are evicted by the 2Q algorithm.  A piece read for the first
+// time enters a FIFO queue, which takes at most 1/4 of the limit.
+// Requests for the other blocks of the piece, which usually follow
+// soon, do not make it "hot".  A piece evicted from the FIFO queue is
+// remembered for a while.  If it is requested again in the meantime,
+// it enters an LRU queue.  This way, a burst of pieces each requested
+// only once does not evict the pieces requested by many peers.
+class PieceReadCache {
+public:
+  PieceReadCache(size_t limit);
+
+  // Reads |len| bytes at |offset| of |diskAdaptor| into |data|.  The
+  // data must be in the piece |index| of the download |gid|, which is
+  // |pieceLength| bytes at |pieceOffset|.  If the piece is not cached,
+  // the whole piece is read and cached.  Returns the number of bytes
+  // read.
+  ssize_t readData(unsigned char* data, size_t len, int64_t offset,
+                   a2_gid_t gid, size_t index, int64_t pieceOffset,
+                   int32_t pieceLength, DiskAdaptor* diskAdaptor);
+
+  // Removes the pieces of the download |gid|.
+  void remove(a2_gid_t gid);
+
+  size_t getLimit() const { return limit_; }
+
+  // Returns the number of bytes cached.
+  size_t getSize() const { return total_; }
+
+  // Returns the number of readData() calls served from the cache.
+  int64_t getHits() const { return hits_; }
+
+  // Returns the number of readData() calls which read the disk.
+  int64_t getMisses() const { return misses_; }
+
+private:
+  typedef std::pair<a2_gid_t, size_t> Key;
+
+  struct Entry {
+    Key key;
+    std::vector<unsigned char> data;
+    // true if the entry is in main_, otherwise in in_
+    bool frequent;
+  };
+
+  typedef std::list<Entry> EntryList;
+
+  void evict(EntryList& list);
+
+  void ensureLimit();
+
+  size_t limit_;
+  // Current number of bytes cached.
+  size_t total_;
+  // Number of bytes cached in in_.
+  size_t inTotal_;
+  // Pieces requested once, oldest first.
+  EntryList in_;
+  // Pieces requested again after they were evicted from in_, least
+  // recently used first.
+  EntryList main_;
+  std::map<Key, EntryList::iterator> entries_;
+  // Pieces evicted from in_ and their length, oldest first.
+  std::list<std::pair<Key, size_t>> ghosts_;
+  std::map<Key, std::list<std::pair<Key, size_t>>::iterator> ghostIndex_;
+  // Sum of the length of the pieces in ghosts_.
+  size_t ghostTotal_;
+  int64_t hits_;
+  int64_t misses_;
+};
+
+} // namespace aria2
+
+#endif // D_PIECE_READ_CACHE_H
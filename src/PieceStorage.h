@@ -52,6 +52,7 @@ class Peer;
 #endif // ENABLE_BITTORRENT
 class DiskAdaptor;
 class WrDiskCache;
+class PieceReadCache;
 
 class PieceStorage {
 public:
@@ -230,6 +231,10 @@ public:
   // and optionally releases the associated cache entries.
   virtual void flushWrDiskCacheEntry(bool releaseEntries) = 0;
 
+  // Returns the cache of the pieces read for uploading, or nullptr
+  // if it is disabled.
+  virtual PieceReadCache* getPieceReadCache() = 0;
+
   virtual int32_t getPieceLength(size_t index) = 0;
 
   /**
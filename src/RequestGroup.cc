@@ -73,6 +73,7 @@
 #include "URISelector.h"
 #include "InorderURISelector.h"
 #include "PieceSelector.h"
+#include "PieceReadCache.h"
 #include "a2functional.h"
 #include "SocketCore.h"
 #include "SimpleRandomizer.h"
@@ -146,6 +147,7 @@ RequestGroup::RequestGroup(const std::shared_ptr<GroupId>& gid,
       haltReason_(RequestGroup::NONE),
       lastErrorCode_(error_code::UNDEFINED),
       saveControlFile_(true),
+      fileAllocationRunning_(false),
       preLocalFileCheckEnabled_(true),
       haltRequested_(false),
       forceHaltRequested_(false),
@@ -597,6 +599,7 @@ void RequestGroup::initPieceStorage()
 #endif // !ENABLE_BITTORRENT
     if (requestGroupMan_) {
       ps->setWrDiskCache(requestGroupMan_->getWrDiskCache());
+      ps->setPieceReadCache(requestGroupMan_->getPieceReadCache());
     }
     if (diskWriterFactory_) {
       ps->setDiskWriterFactory(diskWriterFactory_);
@@ -1030,6 +1033,9 @@ void RequestGroup::releaseRuntimeResource(DownloadEngine* e)
 #endif // ENABLE_BITTORRENT
   if (pieceStorage_) {
     pieceStorage_->removeAdvertisedPiece(Timer::zero());
+    if (pieceStorage_->getPieceReadCache()) {
+      pieceStorage_->getPieceReadCache()->remove(gid_->getNumericId());
+    }
   }
   // Don't reset segmentMan_ and pieceStorage_ here to provide
   // progress information via RPC
@@ -1289,16 +1295,63 @@ bool RequestGroup::doesUploadSpeedExceed()
 }
 
 void RequestGroup::saveControlFile() const
+{
+  if (isControlFileSaveNeeded()) {
+    flushWrDiskCache();
+    flushOSBuffers();
+    writeControlFile();
+  }
+}
+
+bool RequestGroup::isControlFileSaveNeeded() const
+{
+  return saveControlFile_ && progressInfoFile_->needsSave();
+}
+
+void RequestGroup::flushWrDiskCache() const
+{
+  if (pieceStorage_) {
+    pieceStorage_->flushWrDiskCacheEntry(false);
+  }
+}
+
+void RequestGroup::flushOSBuffers() const
+{
+  if (pieceStorage_ && !fileAllocationRunning_) {
+    pieceStorage_->getDiskAdaptor()->flushOSBuffers();
+  }
+}
+
+void RequestGroup::writeControlFile() const
 {
   if (saveControlFile_) {
-    if (pieceStorage_) {
-      pieceStorage_->flushWrDiskCacheEntry(false);
-      pieceStorage_->getDiskAdaptor()->flushOSBuffers();
-    }
     progressInfoFile_->save();
   }
 }
 
+bool RequestGroup::waitWriteback(size_t maxFiles) const
+{
+  if (saveControlFile_ && pieceStorage_ && !fileAllocationRunning_) {
+    return pieceStorage_->getDiskAdaptor()->waitWriteback(maxFiles);
+  }
+  return true;
+}
+
+void RequestGroup::writeCheckpoint() const
+{
+  if (saveControlFile_) {
+    progressInfoFile_->saveCheckpoint();
+  }
+}
+
+void RequestGroup::startCheckpoint() const
+{
+  if (pieceStorage_ && !fileAllocationRunning_ && isControlFileSaveNeeded()) {
+    progressInfoFile_->checkpoint();
+    pieceStorage_->getDiskAdaptor()->startWriteback();
+  }
+}
+
 void RequestGroup::removeControlFile() const
 {
   progressInfoFile_->removeFile();
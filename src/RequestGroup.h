@@ -173,6 +173,10 @@ private:
 
   bool fileAllocationEnabled_;
 
+  // true while a worker thread allocates the files.  The DiskAdaptor
+  // must not be flushed or written back meanwhile.
+  bool fileAllocationRunning_;
+
   bool preLocalFileCheckEnabled_;
 
   bool haltRequested_;
@@ -330,6 +334,10 @@ public:
 
   bool isFileAllocationEnabled() const { return fileAllocationEnabled_; }
 
+  void setFileAllocationRunning(bool f) { fileAllocationRunning_ = f; }
+
+  bool isFileAllocationRunning() const { return fileAllocationRunning_; }
+
   bool needsFileAllocation() const;
 
   /**
@@ -414,6 +422,8 @@ public:
 
   void updateLastModifiedTime(const Time& time);
 
+  const Time& getLastModifiedTime() const { return lastModifiedTime_; }
+
   void increaseAndValidateFileNotFoundCount();
 
   // Just set inMemoryDownload flag true.
@@ -452,8 +462,38 @@ public:
 
   error_code::Value getLastErrorCode() const { return lastErrorCode_; }
 
+  // Flushes the downloaded data and saves the control file if the
+  // progress has changed since the last save.
   void saveControlFile() const;
 
+  // Returns true if the control file is enabled and the progress has
+  // changed since the last save.
+  bool isControlFileSaveNeeded() const;
+
+  // Writes the cached data to the files.
+  void flushWrDiskCache() const;
+
+  // Forces physical write of the files, so that the control file does
+  // not claim the data which is not on the disk yet.
+  void flushOSBuffers() const;
+
+  // Saves the control file without flushing the data.  Use
+  // saveControlFile() unless the data has been flushed.
+  void writeControlFile() const;
+
+  // Waits until the data of the last checkpoint are written back to
+  // the disk, synchronizing at most |maxFiles| files.  Returns false
+  // if the rest must be waited for by another call.
+  bool waitWriteback(size_t maxFiles) const;
+
+  // Saves the last checkpoint into the control file.  Call
+  // waitWriteback() beforehand.
+  void writeCheckpoint() const;
+
+  // Captures the progress as a checkpoint if it has changed since the
+  // last save, and starts writing back its data.
+  void startCheckpoint() const;
+
   void removeControlFile() const;
 
   void enableSaveControlFile() { saveControlFile_ = true; }
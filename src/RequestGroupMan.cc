@@ -78,6 +78,7 @@
 #include "Notifier.h"
 #include "PeerStat.h"
 #include "WrDiskCache.h"
+#include "PieceReadCache.h"
 #include "PieceStorage.h"
 #include "DiskAdaptor.h"
 #include "SimpleRandomizer.h"
@@ -123,7 +124,7 @@ RequestGroupMan::RequestGroupMan(
       removedLastErrorResult_(error_code::FINISHED),
       maxDownloadResult_(option->getAsInt(PREF_MAX_DOWNLOAD_RESULT)),
       openedFileCounter_(std::make_shared<OpenedFileCounter>(
-          this, option->getAsInt(PREF_BT_MAX_OPEN_FILES))),
+          option->getAsInt(PREF_BT_MAX_OPEN_FILES))),
       numStoppedTotal_(0)
 {
   setupOptimizeConcurrentDownloads();
@@ -592,21 +593,132 @@ void RequestGroupMan::fillRequestGroupFromReserver(DownloadEngine* e)
   }
 }
 
+namespace {
+// Returns true if the control file of |rg| is no longer needed.
+bool isControlFileObsolete(const RequestGroup* rg)
+{
+  return rg->allDownloadFinished() &&
+         !rg->getDownloadContext()->isChecksumVerificationNeeded() &&
+         !rg->getOption()->getAsBool(PREF_FORCE_SAVE);
+}
+} // namespace
+
 void RequestGroupMan::save()
 {
+  // The downloads which made no progress since the last save are
+  // skipped without touching their files.  The data of the others are
+  // written and flushed together before their control files are
+  // written, so that the OS can write back them at once.
+  std::vector<RequestGroup*> groups;
   for (auto& rg : requestGroups_) {
-    if (rg->allDownloadFinished() &&
-        !rg->getDownloadContext()->isChecksumVerificationNeeded() &&
-        !rg->getOption()->getAsBool(PREF_FORCE_SAVE)) {
+    if (isControlFileObsolete(rg.get())) {
       rg->removeControlFile();
     }
+    else if (rg->isControlFileSaveNeeded()) {
+      groups.push_back(rg.get());
+    }
+  }
+  for (auto& rg : groups) {
+    try {
+      rg->flushWrDiskCache();
+    }
+    catch (RecoverableException& e) {
+      A2_LOG_ERROR_EX(EX_EXCEPTION_CAUGHT, e);
+      // Its control file must not claim the data not written.
+      rg = nullptr;
+    }
+  }
+  groups.erase(std::remove(std::begin(groups), std::end(groups), nullptr),
+               std::end(groups));
+  for (auto rg : groups) {
+    rg->flushOSBuffers();
+  }
+  for (auto rg : groups) {
+    try {
+      rg->writeControlFile();
+    }
+    catch (RecoverableException& e) {
+      A2_LOG_ERROR_EX(EX_EXCEPTION_CAUGHT, e);
+    }
+  }
+}
+
+namespace {
+// The number of files synchronized for a download at a time, so that
+// a download which has written many files does not block the event
+// loop for long.
+constexpr size_t MAX_WRITEBACK_FILES = 8;
+} // namespace
+
+namespace {
+// Saves the last checkpoint of |rg| once its data are written back.
+// Returns false if the data must be waited for by another call.
+bool saveCheckpoint(RequestGroup* rg)
+{
+  try {
+    if (!rg->waitWriteback(MAX_WRITEBACK_FILES)) {
+      return false;
+    }
+    rg->writeCheckpoint();
+  }
+  catch (RecoverableException& e) {
+    A2_LOG_ERROR_EX(EX_EXCEPTION_CAUGHT, e);
+    // The checkpoint may cover data which is not on the disk.  Save
+    // the current progress after flushing the files instead.
+    try {
+      rg->saveControlFile();
+    }
+    catch (RecoverableException& e) {
+      A2_LOG_ERROR_EX(EX_EXCEPTION_CAUGHT, e);
+    }
+  }
+  return true;
+}
+} // namespace
+
+void RequestGroupMan::checkpoint()
+{
+  std::vector<RequestGroup*> groups;
+  for (auto& rg : requestGroups_) {
+    if (isControlFileObsolete(rg.get())) {
+      rg->removeControlFile();
+    }
+    else if (std::find(std::begin(pendingCheckpoints_),
+                       std::end(pendingCheckpoints_),
+                       rg->getGID()) == std::end(pendingCheckpoints_)) {
+      groups.push_back(rg.get());
+    }
+  }
+  for (auto& rg : groups) {
+    if (!saveCheckpoint(rg)) {
+      pendingCheckpoints_.push_back(rg->getGID());
+      rg = nullptr;
+    }
+  }
+  groups.erase(std::remove(std::begin(groups), std::end(groups), nullptr),
+               std::end(groups));
+  // The new checkpoints only cover the data written so far, which the
+  // next call waits for.
+  for (auto rg : groups) {
+    rg->startCheckpoint();
+  }
+}
+
+void RequestGroupMan::continueCheckpoint()
+{
+  for (auto i = std::begin(pendingCheckpoints_);
+       i != std::end(pendingCheckpoints_);) {
+    auto rg = requestGroups_.get(*i);
+    if (!rg || isControlFileObsolete(rg.get())) {
+      // A stopped download saved its control file in full.
+      i = pendingCheckpoints_.erase(i);
+    }
+    else if (saveCheckpoint(rg.get())) {
+      rg->startCheckpoint();
+      i = pendingCheckpoints_.erase(i);
+    }
     else {
-      try {
-        rg->saveControlFile();
-      }
-      catch (RecoverableException& e) {
-        A2_LOG_ERROR_EX(EX_EXCEPTION_CAUGHT, e);
-      }
+      ++i;
     }
   }
 }
@@ -1054,6 +1166,15 @@ void RequestGroupMan::initWrDiskCache()
   }
 }
 
+void RequestGroupMan::initPieceReadCache()
+{
+  assert(!pieceReadCache_);
+  size_t limit = option_->getAsLLInt(PREF_BT_READ_CACHE);
+  if (limit > 0) {
+    pieceReadCache_ = make_unique<PieceReadCache>(limit);
+  }
+}
+
 void RequestGroupMan::decreaseNumActive()
 {
   assert(numActive_ > 0);
@@ -60,6 +60,7 @@ class Option;
 class OutputFile;
 class UriListParser;
 class WrDiskCache;
+class PieceReadCache;
 class OpenedFileCounter;
 
 typedef IndexedList<a2_gid_t, std::shared_ptr<RequestGroup>> RequestGroupList;
@@ -121,8 +122,14 @@ private:
 
   std::unique_ptr<WrDiskCache> wrDiskCache_;
 
+  std::unique_ptr<PieceReadCache> pieceReadCache_;
+
   std::shared_ptr<OpenedFileCounter> openedFileCounter_;
 
+  // The downloads of which the data of the last checkpoint are still
+  // being waited for by continueCheckpoint().
+  std::vector<a2_gid_t> pendingCheckpoints_;
+
   // The number of stopped downloads so far in total, including
   // evicted DownloadResults.
   size_t numStoppedTotal_;
@@ -155,8 +162,25 @@ public:
 
   bool downloadFinished();
 
+  // Flushes the data and saves the current progress of all
+  // downloads.
   void save();
 
+  // Saves the checkpoints captured by the last call, of which the data
+  // have been written back since then, and captures new ones.  Unlike
+  // save(), this neither flushes the write cache nor waits for the
+  // data written after the last call, so that it is cheap to run
+  // frequently.  Only a few files of each download are synchronized
+  // at a time.  The downloads which have more are left to
+  // continueCheckpoint().
+  void checkpoint();
+
+  // Continues waiting for the data of the checkpoints which
+  // checkpoint() could not save yet.  Once they are written back, the
+  // checkpoints are saved and new ones are captured.  Call this on
+  // each iteration of the event loop.
+  void continueCheckpoint();
+
   void closeFile();
 
   void halt();
@@ -347,6 +371,12 @@ public:
   // its value is 0, cache storage will not be initialized.
   void initWrDiskCache();
 
+  PieceReadCache* getPieceReadCache() const { return pieceReadCache_.get(); }
+
+  // Initializes PieceReadCache according to PREF_BT_READ_CACHE
+  // option.  If its value is 0, the cache will not be initialized.
+  void initPieceReadCache();
+
   void setKeepRunning(bool flag) { keepRunning_ = flag; }
 
   bool getKeepRunning() const { return keepRunning_; }
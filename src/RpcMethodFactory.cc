@@ -87,6 +87,7 @@ std::vector<std::string> rpcMethodNames = {
     "aria2.shutdown",
     "aria2.forceShutdown",
     "aria2.getGlobalStat",
+    "aria2.getEngineProfile",
     "aria2.saveSession",
     "system.multicall",
     "system.listMethods",
@@ -247,6 +248,10 @@ std::unique_ptr<RpcMethod> createMethod(const std::string& methodName)
     return make_unique<GetGlobalStatRpcMethod>();
   }
 
+  if (methodName == GetEngineProfileRpcMethod::getMethodName()) {
+    return make_unique<GetEngineProfileRpcMethod>();
+  }
+
   if (methodName == SaveSessionRpcMethod::getMethodName()) {
     return make_unique<SaveSessionRpcMethod>();
   }
@@ -69,6 +69,8 @@
 #include "MessageDigest.h"
 #include "message_digest_helper.h"
 #include "OpenedFileCounter.h"
+#include "PieceReadCache.h"
+#include "EngineProfiler.h"
 #ifdef ENABLE_BITTORRENT
 #  include "bittorrent_helper.h"
 #  include "BtRegistry.h"
@@ -145,8 +147,23 @@ const char KEY_NUM_WAITING[] = "numWaiting";
 const char KEY_NUM_STOPPED[] = "numStopped";
 const char KEY_NUM_ACTIVE[] = "numActive";
 const char KEY_NUM_STOPPED_TOTAL[] = "numStoppedTotal";
+const char KEY_READ_CACHE_HIT[] = "readCacheHit";
+const char KEY_READ_CACHE_MISS[] = "readCacheMiss";
+const char KEY_READ_CACHE_SIZE[] = "readCacheSize";
 const char KEY_VERIFIED_LENGTH[] = "verifiedLength";
 const char KEY_VERIFY_PENDING[] = "verifyIntegrityPending";
+const char KEY_DURATION[] = "duration";
+const char KEY_ITERATION[] = "iteration";
+const char KEY_POLL_WAIT[] = "pollWait";
+const char KEY_COMMANDS_PER_ITERATION[] = "commandsPerIteration";
+const char KEY_COMMANDS[] = "commands";
+const char KEY_TYPE[] = "type";
+const char KEY_COUNT[] = "count";
+const char KEY_SUM[] = "sum";
+const char KEY_P50[] = "p50";
+const char KEY_P90[] = "p90";
+const char KEY_P99[] = "p99";
+const char KEY_MAX[] = "max";
 } // namespace
 
 namespace {
@@ -1390,6 +1407,62 @@ GetGlobalStatRpcMethod::process(const RpcRequest& req, DownloadEngine* e)
   res->put(KEY_NUM_STOPPED, util::uitos(rgman->getDownloadResults().size()));
   res->put(KEY_NUM_STOPPED_TOTAL, util::uitos(rgman->getNumStoppedTotal()));
   res->put(KEY_NUM_ACTIVE, util::uitos(rgman->getRequestGroups().size()));
+  auto pieceReadCache = rgman->getPieceReadCache();
+  if (pieceReadCache) {
+    res->put(KEY_READ_CACHE_HIT, util::itos(pieceReadCache->getHits()));
+    res->put(KEY_READ_CACHE_MISS, util::itos(pieceReadCache->getMisses()));
+    res->put(KEY_READ_CACHE_SIZE, util::uitos(pieceReadCache->getSize()));
+  }
+  return std::move(res);
+}
+
+namespace {
+void putHistogram(Dict* dict, const Histogram& h)
+{
+  dict->put(KEY_COUNT, util::uitos(h.getCount()));
+  dict->put(KEY_SUM, util::itos(h.getSum()));
+  dict->put(KEY_P50, util::itos(h.getPercentile(50)));
+  dict->put(KEY_P90, util::itos(h.getPercentile(90)));
+  dict->put(KEY_P99, util::itos(h.getPercentile(99)));
+  dict->put(KEY_MAX, util::itos(h.getMax()));
+}
+} // namespace
+
+namespace {
+std::unique_ptr<Dict> createHistogramResponse(const Histogram& h)
+{
+  auto res = Dict::g();
+  putHistogram(res.get(), h);
+  return res;
+}
+} // namespace
+
+std::unique_ptr<ValueBase>
+GetEngineProfileRpcMethod::process(const RpcRequest& req, DownloadEngine* e)
+{
+  auto& profiler = e->getEngineProfiler();
+  if (!profiler) {
+    throw DL_ABORT_EX("Engine profiling is disabled. Enable it with "
+                      "--enable-engine-profile option.");
+  }
+  auto res = Dict::g();
+  res->put(KEY_DURATION,
+           util::itos(std::chrono::duration_cast<std::chrono::seconds>(
+                          EngineProfiler::now() - profiler->getStartTime())
+                          .count()));
+  res->put(KEY_ITERATION,
+           createHistogramResponse(profiler->getIterationTime()));
+  res->put(KEY_POLL_WAIT, createHistogramResponse(profiler->getPollWaitTime()));
+  res->put(KEY_COMMANDS_PER_ITERATION,
+           createHistogramResponse(profiler->getCommandsPerIteration()));
+  auto commands = List::g();
+  for (auto stat : profiler->getCommandStats()) {
+    auto entry = Dict::g();
+    entry->put(KEY_TYPE, stat->name);
+    putHistogram(entry.get(), stat->executeTime);
+    commands->append(std::move(entry));
+  }
+  res->put(KEY_COMMANDS, std::move(commands));
   return std::move(res);
 }
 
@@ -498,6 +498,15 @@ public:
   static const char* getMethodName() { return "aria2.getGlobalStat"; }
 };
 
+class GetEngineProfileRpcMethod : public RpcMethod {
+protected:
+  virtual std::unique_ptr<ValueBase> process(const RpcRequest& req,
+                                             DownloadEngine* e) CXX11_OVERRIDE;
+
+public:
+  static const char* getMethodName() { return "aria2.getEngineProfile"; }
+};
+
 class ForceShutdownRpcMethod : public RpcMethod {
 protected:
   virtual std::unique_ptr<ValueBase> process(const RpcRequest& req,
@@ -36,6 +36,7 @@
 
 #include <cstring>
 #include <cstdlib>
+#include <atomic>
 
 #include "BinaryStream.h"
 #include "util.h"
@@ -69,9 +70,9 @@ SingleFileAllocationIterator::~SingleFileAllocationIterator()
 
 void SingleFileAllocationIterator::init()
 {
-  static bool noticeDone = false;
-  if (!noticeDone) {
-    noticeDone = true;
+  // This may run on file allocation worker threads at the same time.
+  static std::atomic<bool> noticeDone{false};
+  if (!noticeDone.exchange(true)) {
     A2_LOG_NOTICE(_("Allocating disk space. Use --file-allocation=none to"
                     " disable it. See --file-allocation option in man page for"
                     " more details."));
@@ -61,6 +61,7 @@
 #ifdef ENABLE_SSL
 #  include "TLSContext.h"
 #  include "TLSSession.h"
+#  include "TLSSessionCache.h"
 #endif // ENABLE_SSL
 #ifdef HAVE_LIBSSH2
 #  include "SSHSession.h"
@@ -903,15 +904,35 @@ void SocketCore::readData(void* data, size_t& len)
 
 bool SocketCore::tlsAccept()
 {
-  return tlsHandshake(svTlsContext_.get(), A2STR::NIL);
+  return tlsHandshake(svTlsContext_.get(), A2STR::NIL, 0);
 }
 
-bool SocketCore::tlsConnect(const std::string& hostname)
+bool SocketCore::tlsConnect(const std::string& hostname, uint16_t port,
+                            const std::vector<std::string>& alpnProtocols)
 {
-  return tlsHandshake(clTlsContext_.get(), hostname);
+  return tlsHandshake(clTlsContext_.get(), hostname, port, alpnProtocols);
 }
 
-bool SocketCore::tlsHandshake(TLSContext* tlsctx, const std::string& hostname)
+std::string SocketCore::getALPNProtocol() const
+{
+  if (!tlsSession_ || secure_ != A2_TLS_CONNECTED) {
+    return "";
+  }
+  return tlsSession_->getALPNProtocol();
+}
+
+std::string SocketCore::getTLSSessionCacheKey(const std::string& hostname,
+                                              uint16_t port) const
+{
+  auto peerEndpoint = getPeerInfo();
+  return fmt("%s:%u",
+             hostname.empty() ? peerEndpoint.addr.c_str() : hostname.c_str(),
+             port == 0 ? peerEndpoint.port : port);
+}
+
+bool SocketCore::tlsHandshake(TLSContext* tlsctx, const std::string& hostname,
+                              uint16_t port,
+                              const std::vector<std::string>& alpnProtocols)
 {
   wantRead_ = false;
   wantWrite_ = false;
@@ -941,6 +962,16 @@ bool SocketCore::tlsHandshake(TLSContext* tlsctx, const std::string& hostname)
                               tlsSession_->getLastErrorString().c_str()));
       }
     }
+    if (tlsctx->getSide() == TLS_CLIENT && !alpnProtocols.empty()) {
+      rv = tlsSession_->setALPNProtocols(alpnProtocols);
+      if (rv != TLS_ERR_OK) {
+        throw DL_ABORT_EX(fmt(EX_SSL_INIT_FAILURE,
+                              tlsSession_->getLastErrorString().c_str()));
+      }
+    }
+    if (tlsctx->getSide() == TLS_CLIENT && tlsctx->getSessionCache()) {
+      tlsSession_->setSessionCacheKey(getTLSSessionCacheKey(hostname, port));
+    }
     // Done with the setup, now let handshaking begin immediately.
     secure_ = A2_TLS_HANDSHAKING;
     A2_LOG_DEBUG("TLS Handshaking");
@@ -993,6 +1024,17 @@ bool SocketCore::tlsHandshake(TLSContext* tlsctx, const std::string& hostname)
       A2_LOG_DEBUG(fmt("Securely connected to %s with %s", peerInfo.c_str(),
                        tlsVersion.c_str()));
 
+      if (tlsctx->getSide() == TLS_CLIENT) {
+        auto cache = tlsctx->getSessionCache();
+        if (cache) {
+          auto resumed = tlsSession_->isResumed();
+          if (resumed) {
+            A2_LOG_DEBUG(fmt("TLS session resumed with %s", peerInfo.c_str()));
+          }
+          cache->addHandshake(resumed);
+        }
+      }
+
       // 2. We're connected now!
       secure_ = A2_TLS_CONNECTED;
       return true;
@@ -1014,6 +1056,12 @@ bool SocketCore::tlsHandshake(TLSContext* tlsctx, const std::string& hostname)
     }
 
     if (rv == TLS_ERR_ERROR) {
+      if (tlsctx->getSide() == TLS_CLIENT && tlsctx->getSessionCache()) {
+        // The cached session might be the cause.  Do a full handshake
+        // next time.
+        tlsctx->getSessionCache()->remove(
+            getTLSSessionCacheKey(hostname, port));
+      }
       // Damn those error.
       throw DL_ABORT_EX(fmt("SSL/TLS handshake failure: %s",
                             handshakeError.empty()
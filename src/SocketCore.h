@@ -99,7 +99,18 @@ private:
    *
    * If you are going to verify peer's certificate, hostname must be supplied.
    */
-  bool tlsHandshake(TLSContext* tlsctx, const std::string& hostname);
+  bool tlsHandshake(TLSContext* tlsctx, const std::string& hostname,
+                    uint16_t port,
+                    const std::vector<std::string>& alpnProtocols =
+                        std::vector<std::string>());
+
+  // Returns the key of the TLS session cache entry for the origin
+  // server |hostname|:|port|, which is not the remote endpoint of
+  // this socket if it is tunneled through a proxy.  The address and
+  // port of the remote endpoint are used if |hostname| is empty and
+  // |port| is 0 respectively.
+  std::string getTLSSessionCacheKey(const std::string& hostname,
+                                    uint16_t port) const;
 #endif // ENABLE_SSL
 
 #ifdef HAVE_LIBSSH2
@@ -294,8 +305,18 @@ public:
   // returns true. If handshake has not been done yet, returns false.
   //
   // If you are going to verify peer's certificate, hostname must be
-  // supplied.
-  bool tlsConnect(const std::string& hostname);
+  // supplied.  The |port| is the port of the origin server, which
+  // keys the TLS session cache together with |hostname|.  The
+  // |alpnProtocols| are offered to the server with ALPN extension in
+  // order of preference.  They are only looked at when handshake
+  // starts.
+  bool tlsConnect(const std::string& hostname, uint16_t port,
+                  const std::vector<std::string>& alpnProtocols =
+                      std::vector<std::string>());
+
+  // Returns the application protocol the server selected with ALPN,
+  // or empty string if it did not select any.
+  std::string getALPNProtocol() const;
 #endif // ENABLE_SSL
 
 #ifdef HAVE_LIBSSH2
@@ -347,6 +368,10 @@ public:
   setClientTLSContext(const std::shared_ptr<TLSContext>& tlsContext);
   static void
   setServerTLSContext(const std::shared_ptr<TLSContext>& tlsContext);
+  static const std::shared_ptr<TLSContext>& getClientTLSContext()
+  {
+    return clTlsContext_;
+  }
 #endif // ENABLE_SSL
 
   static void setProtocolFamily(int protocolFamily)
@@ -0,0 +1,294 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "SocketPool.h"
+
+#include <algorithm>
+
+#include "SocketCore.h"
+#include "Command.h"
+#include "LogFactory.h"
+#include "Logger.h"
+#include "fmt.h"
+#include "wallclock.h"
+
+namespace aria2 {
+
+namespace {
+std::string createHostKey(const std::string& host, uint16_t port)
+{
+  return fmt("%s:%u", host.c_str(), port);
+}
+} // namespace
+
+SocketPool::SocketPool() : hits_(0), misses_(0) {}
+
+SocketPool::~SocketPool() = default;
+
+void SocketPool::add(const std::string& key,
+                     const std::shared_ptr<SocketCore>& socket,
+                     const std::string& options, std::chrono::seconds timeout)
+{
+  A2_LOG_INFO(fmt("Pool socket for %s", key.c_str()));
+  pool_.insert(std::make_pair(
+      key, SocketPoolEntry(socket, options, std::move(timeout))));
+}
+
+std::multimap<std::string, SocketPool::SocketPoolEntry>::iterator
+SocketPool::find(const std::string& key)
+{
+  auto range = pool_.equal_range(key);
+  for (auto i = range.first, eoi = range.second; i != eoi; ++i) {
+    const SocketPoolEntry& e = (*i).second;
+    // We assume that if socket is readable it means peer shutdowns
+    // connection and the socket will receive EOF. So skip it.
+    if (!e.isTimeout() && !e.getSocket()->isReadable(0)) {
+      A2_LOG_INFO(fmt("Found socket for %s", key.c_str()));
+      return i;
+    }
+  }
+  return pool_.end();
+}
+
+std::shared_ptr<SocketCore>
+SocketPool::pop(std::string* options, const std::vector<std::string>& keys)
+{
+  for (auto& key : keys) {
+    auto i = find(key);
+    if (i != pool_.end()) {
+      auto s = (*i).second.getSocket();
+      if (options) {
+        *options = (*i).second.getOptions();
+      }
+      pool_.erase(i);
+      ++hits_;
+      return s;
+    }
+  }
+  return nullptr;
+}
+
+void SocketPool::evict()
+{
+  if (pool_.empty()) {
+    return;
+  }
+
+  std::multimap<std::string, SocketPoolEntry> newPool;
+  A2_LOG_DEBUG("Scanning SocketPool and erasing timed out entry.");
+  for (auto& elem : pool_) {
+    if (!elem.second.isTimeout()) {
+      newPool.insert(elem);
+    }
+  }
+  A2_LOG_DEBUG(
+      fmt("%lu entries removed.",
+          static_cast<unsigned long>(pool_.size() - newPool.size())));
+  pool_ = std::move(newPool);
+}
+
+size_t SocketPool::count(std::vector<std::weak_ptr<SocketCore>>& conns)
+{
+  conns.erase(std::remove_if(std::begin(conns), std::end(conns),
+                             [](const std::weak_ptr<SocketCore>& conn) {
+                               return conn.expired();
+                             }),
+              std::end(conns));
+  return conns.size();
+}
+
+std::multimap<std::string, SocketPool::SocketPoolEntry>::iterator
+SocketPool::findIdle(const std::vector<std::weak_ptr<SocketCore>>& conns)
+{
+  for (auto i = std::begin(pool_), eoi = std::end(pool_); i != eoi; ++i) {
+    for (auto& conn : conns) {
+      if (conn.lock() == (*i).second.getSocket()) {
+        return i;
+      }
+    }
+  }
+  return pool_.end();
+}
+
+void SocketPool::addConnection(const std::string& host, uint16_t port,
+                               const std::shared_ptr<SocketCore>& socket)
+{
+  auto& conns = connections_[createHostKey(host, port)];
+  count(conns);
+  for (auto& conn : conns) {
+    if (conn.lock() == socket) {
+      return;
+    }
+  }
+  conns.push_back(socket);
+  ++misses_;
+}
+
+void SocketPool::replaceConnection(
+    const std::string& host, uint16_t port,
+    const std::shared_ptr<SocketCore>& oldSocket,
+    const std::shared_ptr<SocketCore>& newSocket)
+{
+  auto& conns = connections_[createHostKey(host, port)];
+  for (auto& conn : conns) {
+    if (conn.lock() == oldSocket) {
+      conn = newSocket;
+      return;
+    }
+  }
+  conns.push_back(newSocket);
+}
+
+size_t SocketPool::countConnection(const std::string& host, uint16_t port)
+{
+  auto i = connections_.find(createHostKey(host, port));
+  if (i == std::end(connections_)) {
+    return 0;
+  }
+  auto n = count((*i).second);
+  if (n == 0) {
+    connections_.erase(i);
+  }
+  return n;
+}
+
+bool SocketPool::acquire(const std::string& host, uint16_t port,
+                         size_t maxConnections, Command* command)
+{
+  if (maxConnections == 0) {
+    cancel(command);
+    return true;
+  }
+  auto key = createHostKey(host, port);
+  auto w = waiters_.find(key);
+  if (w != std::end(waiters_) && (*w).second.front() != command) {
+    auto& queue = (*w).second;
+    if (std::find(std::begin(queue), std::end(queue), command) ==
+        std::end(queue)) {
+      queue.push_back(command);
+    }
+    return false;
+  }
+  auto& conns = connections_[key];
+  auto ok = count(conns) < maxConnections;
+  if (!ok) {
+    auto i = findIdle(conns);
+    if (i != pool_.end()) {
+      A2_LOG_INFO(fmt("Closing idle connection to %s to open a new one",
+                      key.c_str()));
+      pool_.erase(i);
+      ok = true;
+    }
+  }
+  if (ok) {
+    if (w != std::end(waiters_)) {
+      (*w).second.pop_front();
+      if ((*w).second.empty()) {
+        waiters_.erase(w);
+      }
+    }
+    return true;
+  }
+  if (w == std::end(waiters_)) {
+    A2_LOG_INFO(fmt("CUID#%" PRId64 " - Waiting for a connection to %s",
+                    command->getCuid(), key.c_str()));
+    waiters_[key].push_back(command);
+  }
+  return false;
+}
+
+void SocketPool::cancel(Command* command)
+{
+  for (auto i = std::begin(waiters_); i != std::end(waiters_);) {
+    auto& queue = (*i).second;
+    queue.erase(std::remove(std::begin(queue), std::end(queue), command),
+                std::end(queue));
+    if (queue.empty()) {
+      waiters_.erase(i++);
+    }
+    else {
+      ++i;
+    }
+  }
+}
+
+bool SocketPool::hasWaiterBefore(const std::string& host, uint16_t port,
+                                 const Command* command) const
+{
+  auto w = waiters_.find(createHostKey(host, port));
+  return w != std::end(waiters_) && (*w).second.front() != command;
+}
+
+bool SocketPool::wakeUp(size_t maxConnections)
+{
+  auto woken = false;
+  for (auto& w : waiters_) {
+    auto& conns = connections_[w.first];
+    if (maxConnections == 0) {
+      for (auto command : w.second) {
+        command->setStatusActive();
+      }
+      woken = true;
+    }
+    else if (count(conns) < maxConnections || findIdle(conns) != pool_.end()) {
+      w.second.front()->setStatusActive();
+      woken = true;
+    }
+  }
+  return woken;
+}
+
+void SocketPool::log() const
+{
+  auto total = hits_ + misses_;
+  A2_LOG_INFO(fmt("Socket pool: %" PRIu64 " connections reused, %" PRIu64
+                  " opened, hit rate %" PRIu64 "%%",
+                  hits_, misses_, total == 0 ? 0 : hits_ * 100 / total));
+}
+
+SocketPool::SocketPoolEntry::SocketPoolEntry(
+    const std::shared_ptr<SocketCore>& socket, const std::string& options,
+    std::chrono::seconds timeout)
+    : socket_(socket), options_(options), timeout_(std::move(timeout))
+{
+}
+
+SocketPool::SocketPoolEntry::~SocketPoolEntry() = default;
+
+bool SocketPool::SocketPoolEntry::isTimeout() const
+{
+  return registeredTime_.difference(global::wallclock()) >= timeout_;
+}
+
+} // namespace aria2
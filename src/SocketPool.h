@@ -0,0 +1,187 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_SOCKET_POOL_H
+#define D_SOCKET_POOL_H
+
+#include "common.h"
+
+#include <string>
+#include <map>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <chrono>
+
+#include "TimerA2.h"
+
+namespace aria2 {
+
+class SocketCore;
+class Command;
+
+// Keeps idle keep-alive connections for reuse and accounts the
+// connections to each host, so that the number of connections to one
+// host can be limited across all downloads.  A command which has to
+// open a connection beyond the limit is queued, and the queued
+// commands are woken up one by one, in order, when a connection to
+// the host is pooled or closed.
+class SocketPool {
+private:
+  class SocketPoolEntry {
+  private:
+    std::shared_ptr<SocketCore> socket_;
+    // protocol specific option string
+    std::string options_;
+
+    std::chrono::seconds timeout_;
+
+    Timer registeredTime_;
+
+  public:
+    SocketPoolEntry(const std::shared_ptr<SocketCore>& socket,
+                    const std::string& option, std::chrono::seconds timeout);
+
+    ~SocketPoolEntry();
+
+    bool isTimeout() const;
+
+    const std::shared_ptr<SocketCore>& getSocket() const { return socket_; }
+
+    const std::string& getOptions() const { return options_; }
+  };
+
+  // key = IP address:port, value = SocketPoolEntry
+  std::multimap<std::string, SocketPoolEntry> pool_;
+
+  // Connections opened to each host, keyed by "host:port".  Includes
+  // the ones in pool_.  Closed connections are purged lazily.
+  std::map<std::string, std::vector<std::weak_ptr<SocketCore>>> connections_;
+
+  // Commands waiting for a connection to each host, keyed by
+  // "host:port".
+  std::map<std::string, std::deque<Command*>> waiters_;
+
+  uint64_t hits_;
+  uint64_t misses_;
+
+  std::multimap<std::string, SocketPoolEntry>::iterator
+  find(const std::string& key);
+
+  // Returns the number of open connections in |conns|, erasing the
+  // closed ones.
+  size_t count(std::vector<std::weak_ptr<SocketCore>>& conns);
+
+  // Returns the entry of an idle connection in |conns|, or the end of
+  // pool_.
+  std::multimap<std::string, SocketPoolEntry>::iterator
+  findIdle(const std::vector<std::weak_ptr<SocketCore>>& conns);
+
+public:
+  SocketPool();
+
+  ~SocketPool();
+
+  // Pools idle |socket| under |key|.  |options| is returned by pop()
+  // along with the socket.  The socket is dropped after |timeout|.
+  void add(const std::string& key, const std::shared_ptr<SocketCore>& socket,
+           const std::string& options, std::chrono::seconds timeout);
+
+  // Removes and returns the socket pooled under the first key in
+  // |keys| which has a usable one.  If |options| is not null, the
+  // options given to add() are assigned to it.  Returns nullptr if
+  // there is no usable socket.
+  std::shared_ptr<SocketCore> pop(std::string* options,
+                                  const std::vector<std::string>& keys);
+
+  // Drops timed out sockets.
+  void evict();
+
+  size_t size() const { return pool_.size(); }
+
+  // Accounts |socket| as a connection to |host|:|port| until it is
+  // destroyed.  Counted as a miss unless it is accounted already.
+  void addConnection(const std::string& host, uint16_t port,
+                     const std::shared_ptr<SocketCore>& socket);
+
+  // Accounts |newSocket|, which took over the connection of
+  // |oldSocket| to |host|:|port|, in place of |oldSocket|.  Unlike
+  // addConnection(), it is not counted as a miss.
+  void replaceConnection(const std::string& host, uint16_t port,
+                         const std::shared_ptr<SocketCore>& oldSocket,
+                         const std::shared_ptr<SocketCore>& newSocket);
+
+  // Returns the number of open connections to |host|:|port|,
+  // including idle ones.
+  size_t countConnection(const std::string& host, uint16_t port);
+
+  // Returns true if |command| may open a new connection to
+  // |host|:|port|: no other command is queued before it and there are
+  // less than |maxConnections| connections to the host.  An idle
+  // connection to the host is closed to make room if necessary.
+  // Otherwise, |command| is queued and false is returned.  If
+  // |maxConnections| is 0, the number of connections is not limited.
+  bool acquire(const std::string& host, uint16_t port,
+               size_t maxConnections, Command* command);
+
+  // Removes |command| from the queue.
+  void cancel(Command* command);
+
+  // Returns true if another command is queued for a connection to
+  // |host|:|port| before |command|.  Such a command takes an idle
+  // connection to the host first.
+  bool hasWaiterBefore(const std::string& host, uint16_t port,
+                       const Command* command) const;
+
+  // Wakes up the first queued command of each host to which a new
+  // connection can be opened now.  Returns true if a command was
+  // woken up.
+  bool wakeUp(size_t maxConnections);
+
+  bool hasWaiter() const { return !waiters_.empty(); }
+
+  // Returns the number of times pop() found a pooled socket.
+  uint64_t getHitCount() const { return hits_; }
+
+  // Returns the number of new connections accounted by
+  // addConnection().
+  uint64_t getMissCount() const { return misses_; }
+
+  // Logs the hit rate at INFO level.
+  void log() const;
+};
+
+} // namespace aria2
+
+#endif // D_SOCKET_POOL_H
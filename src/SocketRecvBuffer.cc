@@ -39,11 +39,17 @@
 
 #include "SocketCore.h"
 #include "LogFactory.h"
+#ifdef HAVE_LIBNGHTTP2
+#  include "Http2Session.h"
+#endif // HAVE_LIBNGHTTP2
 
 namespace aria2 {
 
 SocketRecvBuffer::SocketRecvBuffer(std::shared_ptr<SocketCore> socket)
-    : socket_(std::move(socket)), pos_(buf_.data()), last_(pos_)
+    : socket_(std::move(socket)),
+      pos_(buf_.data()),
+      last_(pos_),
+      command_(nullptr)
 {
 }
 
@@ -56,11 +62,69 @@ ssize_t SocketRecvBuffer::recv()
     A2_LOG_DEBUG("Buffer full");
     return 0;
   }
+#ifdef HAVE_LIBNGHTTP2
+  if (stream_) {
+    n = stream_->readData(last_, n);
+    last_ += n;
+    return n;
+  }
+#endif // HAVE_LIBNGHTTP2
   socket_->readData(last_, n);
   last_ += n;
   return n;
 }
 
+bool SocketRecvBuffer::eof() const
+{
+#ifdef HAVE_LIBNGHTTP2
+  if (stream_) {
+    return stream_->isClosed() && stream_->getBufferedLength() == 0;
+  }
+#endif // HAVE_LIBNGHTTP2
+  return !socket_->wantRead() && !socket_->wantWrite();
+}
+
+bool SocketRecvBuffer::hasPendingData() const
+{
+  if (!bufferEmpty()) {
+    return true;
+  }
+#ifdef HAVE_LIBNGHTTP2
+  if (stream_) {
+    return stream_->readable();
+  }
+#endif // HAVE_LIBNGHTTP2
+  return socket_->getRecvBufferedLength() > 0;
+}
+
+void SocketRecvBuffer::setCommand(Command* command)
+{
+  command_ = command;
+#ifdef HAVE_LIBNGHTTP2
+  if (stream_) {
+    stream_->setCommand(command);
+  }
+#endif // HAVE_LIBNGHTTP2
+}
+
+void SocketRecvBuffer::unsetCommand(Command* command)
+{
+  if (command_ == command) {
+    setCommand(nullptr);
+  }
+}
+
+#ifdef HAVE_LIBNGHTTP2
+void SocketRecvBuffer::setHttp2Stream(std::shared_ptr<Http2Stream> stream)
+{
+  if (stream_) {
+    stream_->setCommand(nullptr);
+  }
+  stream_ = std::move(stream);
+  stream_->setCommand(command_);
+}
+#endif // HAVE_LIBNGHTTP2
+
 void SocketRecvBuffer::drain(size_t n)
 {
   assert(pos_ + n <= last_);
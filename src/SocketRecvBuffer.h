@@ -45,6 +45,10 @@
 namespace aria2 {
 
 class SocketCore;
+class Command;
+#ifdef HAVE_LIBNGHTTP2
+class Http2Stream;
+#endif // HAVE_LIBNGHTTP2
 
 class SocketRecvBuffer {
 public:
@@ -53,6 +57,30 @@ public:
   // Reads data from socket as much as capacity allows. Returns the
   // number of bytes read.
   ssize_t recv();
+  // Returns true if the last recv() returned 0 because the remote
+  // endpoint finished sending data, rather than because no data was
+  // available at the moment.
+  bool eof() const;
+  // Returns true if there is data to process without waiting for the
+  // socket: buffered data, or for an HTTP/2 stream, anything the
+  // stream received.
+  bool hasPendingData() const;
+  // Sets the command which processes the data of this buffer.  It is
+  // woken up when an HTTP/2 stream set to this buffer becomes
+  // readable.
+  void setCommand(Command* command);
+  // Clears the command set by setCommand() if it is |command|.
+  void unsetCommand(Command* command);
+#ifdef HAVE_LIBNGHTTP2
+  // Makes recv() read the response body of |stream| instead of the
+  // socket.
+  void setHttp2Stream(std::shared_ptr<Http2Stream> stream);
+
+  const std::shared_ptr<Http2Stream>& getHttp2Stream() const
+  {
+    return stream_;
+  }
+#endif // HAVE_LIBNGHTTP2
   // Truncates the contents of buffer to 0.
   void truncateBuffer();
   // Drains first n bytes of data from buffer.  It is an programmer's
@@ -73,6 +101,10 @@ private:
   std::shared_ptr<SocketCore> socket_;
   unsigned char* pos_;
   unsigned char* last_;
+  Command* command_;
+#ifdef HAVE_LIBNGHTTP2
+  std::shared_ptr<Http2Stream> stream_;
+#endif // HAVE_LIBNGHTTP2
 };
 
 } // namespace aria2
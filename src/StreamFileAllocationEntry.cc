@@ -75,6 +75,9 @@ void StreamFileAllocationEntry::prepareForNextAction(
       diskAdaptor->size() <= option->getAsLLInt(PREF_MAX_MMAP_LIMIT)) {
     diskAdaptor->enableMmap();
   }
+  if (option->getAsBool(PREF_ENABLE_DIRECT_IO)) {
+    diskAdaptor->enableDirectIO();
+  }
   if (getNextCommand()) {
     // Reset download start time of PeerStat because it is started
     // before file allocation begins.
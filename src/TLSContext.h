@@ -41,6 +41,8 @@
 
 namespace aria2 {
 
+class TLSSessionCache;
+
 enum TLSSessionSide { TLS_CLIENT, TLS_SERVER };
 
 enum TLSVersion {
@@ -69,6 +71,10 @@ public:
   virtual TLSSessionSide getSide() const = 0;
   virtual bool getVerifyPeer() const = 0;
   virtual void setVerifyPeer(bool) = 0;
+
+  // Returns the cache of client side sessions used for resumption,
+  // or nullptr if the backend does not support it.
+  virtual TLSSessionCache* getSessionCache() { return nullptr; }
 };
 
 } // namespace aria2
@@ -36,6 +36,10 @@
 #define TLS_SESSION_H
 
 #include "common.h"
+
+#include <string>
+#include <vector>
+
 #include "a2netcompat.h"
 #include "TLSContext.h"
 
@@ -68,6 +72,28 @@ public:
   // succeeds, or TLS_ERR_ERROR.
   virtual int setSNIHostname(const std::string& hostname) = 0;
 
+  // Sets the list of application protocols offered to the remote
+  // endpoint with TLS ALPN extension, in order of preference. This
+  // is only meaningful for client side session. This function
+  // returns TLS_ERR_OK if it succeeds, or TLS_ERR_ERROR. Backends
+  // without ALPN support ignore the list.
+  virtual int setALPNProtocols(const std::vector<std::string>& protocols)
+  {
+    return TLS_ERR_OK;
+  }
+
+  // Makes the session resume the session stored in the session cache
+  // of the TLS context under |key|, which identifies the remote
+  // endpoint, and store the new session there when it is
+  // established. This is only meaningful for client side session and
+  // must be called before the handshake. Backends without session
+  // cache ignore this.
+  virtual void setSessionCacheKey(const std::string& key) {}
+
+  // Returns true if the handshake resumed a previous session. This is
+  // only meaningful after handshake has completed.
+  virtual bool isResumed() { return false; }
+
   // Closes the SSL/TLS session. Don't close underlying transport
   // socket. This function returns TLS_ERR_OK if it succeeds, or
   // TLS_ERR_ERROR.
@@ -111,6 +137,11 @@ public:
   // contacting network.
   virtual size_t getRecvBufferedLength() = 0;
 
+  // Returns the application protocol selected by the remote endpoint
+  // with TLS ALPN extension, or empty string if none was selected.
+  // This is only meaningful after handshake has completed.
+  virtual std::string getALPNProtocol() { return ""; }
+
 protected:
   TLSSession() = default;
 
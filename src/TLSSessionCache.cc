@@ -0,0 +1,140 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "TLSSessionCache.h"
+
+#include <algorithm>
+
+#include "wallclock.h"
+#include "LogFactory.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+TLSSessionCache::TLSSessionCache(size_t maxEntries, std::chrono::seconds ttl)
+    : maxEntries_(maxEntries),
+      ttl_(ttl),
+      numFullHandshakes_(0),
+      numResumedHandshakes_(0),
+      numEvicted_(0)
+{
+}
+
+std::string TLSSessionCache::get(const std::string& key)
+{
+  auto i = entries_.find(key);
+  if (i == std::end(entries_)) {
+    return "";
+  }
+  const auto& now = global::wallclock();
+  if ((*i).second.expiry <= now) {
+    entries_.erase(i);
+    return "";
+  }
+  (*i).second.lastAccess = now;
+  return (*i).second.data;
+}
+
+void TLSSessionCache::put(const std::string& key, std::string data,
+                          std::chrono::seconds lifetime)
+{
+  if (maxEntries_ == 0 || data.empty()) {
+    return;
+  }
+  if (lifetime.count() <= 0 || lifetime > ttl_) {
+    lifetime = ttl_;
+  }
+  const auto& now = global::wallclock();
+  auto i = entries_.find(key);
+  if (i == std::end(entries_)) {
+    if (entries_.size() >= maxEntries_) {
+      evict();
+    }
+    i = entries_.insert(std::make_pair(key, Entry())).first;
+  }
+  auto& entry = (*i).second;
+  entry.data = std::move(data);
+  entry.expiry = now;
+  entry.expiry.advance(lifetime);
+  entry.lastAccess = now;
+}
+
+void TLSSessionCache::remove(const std::string& key) { entries_.erase(key); }
+
+void TLSSessionCache::evict()
+{
+  const auto& now = global::wallclock();
+  // Drop expired entries first.  If there is none, drop the least
+  // recently used one.
+  auto lru = std::end(entries_);
+  for (auto i = std::begin(entries_); i != std::end(entries_);) {
+    if ((*i).second.expiry <= now) {
+      i = entries_.erase(i);
+      ++numEvicted_;
+      continue;
+    }
+    if (lru == std::end(entries_) ||
+        (*i).second.lastAccess < (*lru).second.lastAccess) {
+      lru = i;
+    }
+    ++i;
+  }
+  if (entries_.size() >= maxEntries_ && lru != std::end(entries_)) {
+    entries_.erase(lru);
+    ++numEvicted_;
+  }
+}
+
+void TLSSessionCache::addHandshake(bool resumed)
+{
+  if (resumed) {
+    ++numResumedHandshakes_;
+  }
+  else {
+    ++numFullHandshakes_;
+  }
+}
+
+void TLSSessionCache::log() const
+{
+  if (numFullHandshakes_ == 0 && numResumedHandshakes_ == 0) {
+    return;
+  }
+  A2_LOG_INFO(fmt("TLS handshakes: full=%" PRIu64 ", resumed=%" PRIu64
+                  ", cached sessions=%lu, evicted=%" PRIu64,
+                  numFullHandshakes_, numResumedHandshakes_,
+                  static_cast<unsigned long>(entries_.size()), numEvicted_));
+}
+
+} // namespace aria2
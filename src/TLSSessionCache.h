@@ -0,0 +1,108 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_TLS_SESSION_CACHE_H
+#define D_TLS_SESSION_CACHE_H
+
+#include "common.h"
+
+#include <string>
+#include <map>
+#include <chrono>
+
+#include "TimerA2.h"
+
+namespace aria2 {
+
+// Client side cache of TLS sessions for resumption.  The session
+// data are opaque bytes serialized by the TLS backend, keyed by the
+// remote endpoint.  An entry expires after the lifetime given when
+// it was stored, capped by the TTL of the cache.  If the cache is
+// full, the least recently used entry is evicted.
+//
+// The cache also counts full and resumed handshakes, so that the
+// effect of resumption can be seen.
+class TLSSessionCache {
+public:
+  TLSSessionCache(size_t maxEntries = 256,
+                  std::chrono::seconds ttl = std::chrono::seconds(600));
+
+  // Returns the session data stored for |key|, or empty string if
+  // there is none or it has expired.
+  std::string get(const std::string& key);
+
+  // Stores |data| for |key|, replacing the previous one.  |lifetime|
+  // is the lifetime of the session advertised by the server; zero
+  // means unknown.
+  void put(const std::string& key, std::string data,
+           std::chrono::seconds lifetime = std::chrono::seconds(0));
+
+  // Removes the session data stored for |key|.  This is called when
+  // the handshake with the cached session failed.
+  void remove(const std::string& key);
+
+  size_t size() const { return entries_.size(); }
+
+  // Records the completion of a handshake.
+  void addHandshake(bool resumed);
+
+  uint64_t getNumFullHandshakes() const { return numFullHandshakes_; }
+
+  uint64_t getNumResumedHandshakes() const { return numResumedHandshakes_; }
+
+  uint64_t getNumEvicted() const { return numEvicted_; }
+
+  // Writes the counters to the log if any handshake was recorded.
+  void log() const;
+
+private:
+  struct Entry {
+    std::string data;
+    Timer expiry;
+    Timer lastAccess;
+  };
+
+  void evict();
+
+  std::map<std::string, Entry> entries_;
+  size_t maxEntries_;
+  std::chrono::seconds ttl_;
+  uint64_t numFullHandshakes_;
+  uint64_t numResumedHandshakes_;
+  uint64_t numEvicted_;
+};
+
+} // namespace aria2
+
+#endif // D_TLS_SESSION_CACHE_H
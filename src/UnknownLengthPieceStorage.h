@@ -218,6 +218,8 @@ public:
 
   virtual void flushWrDiskCacheEntry(bool releaseEntries) CXX11_OVERRIDE {}
 
+  virtual PieceReadCache* getPieceReadCache() CXX11_OVERRIDE { return nullptr; }
+
   virtual int32_t getPieceLength(size_t index) CXX11_OVERRIDE;
 
   virtual void advertisePiece(cuid_t cuid, size_t index,
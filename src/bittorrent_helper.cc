@@ -34,9 +34,15 @@
 /* copyright --> */
 #include "bittorrent_helper.h"
 
+#ifdef HAVE_MMAP
+#  include <sys/mman.h>
+#endif // HAVE_MMAP
+
 #include <cassert>
+#include <cerrno>
 #include <cstring>
 #include <algorithm>
+#include <array>
 
 #include "DownloadContext.h"
 #include "Randomizer.h"
@@ -61,7 +67,10 @@
 #include "error_code.h"
 #include "array_fun.h"
 #include "DownloadFailureException.h"
-#include "ValueBaseBencodeParser.h"
+#include "BencodeView.h"
+#include "File.h"
+#include "a2io.h"
+#include "a2functional.h"
 
 namespace aria2 {
 
@@ -97,62 +106,34 @@ const std::string SINGLE("single");
 
 namespace {
 void extractPieceHash(const std::shared_ptr<DownloadContext>& ctx,
-                      const std::string& hashData, size_t hashLength,
+                      const ByteSpan& hashData, size_t hashLength,
                       size_t numPieces)
 {
-  std::vector<std::string> pieceHashes;
-  pieceHashes.reserve(numPieces);
-  for (size_t i = 0; i < numPieces; ++i) {
-    const char* p = hashData.data() + i * hashLength;
-    pieceHashes.push_back(std::string(p, p + hashLength));
-  }
-  ctx->setPieceHashes("sha-1", pieceHashes.begin(), pieceHashes.end());
+  ctx->setPieceHashes(
+      "sha-1",
+      std::string(hashData.begin(), hashData.begin() + numPieces * hashLength),
+      hashLength);
 }
 } // namespace
 
 namespace {
 void extractUrlList(TorrentAttribute* torrent, std::vector<std::string>& uris,
-                    const ValueBase* v)
+                    const BencodeView& v)
 {
-  class UrlListVisitor : public ValueBaseVisitor {
-  private:
-    std::vector<std::string>& uris_;
-    TorrentAttribute* torrent_;
-
-  public:
-    UrlListVisitor(std::vector<std::string>& uris, TorrentAttribute* torrent)
-        : uris_(uris), torrent_(torrent)
-    {
-    }
-
-    virtual void visit(const String& v) CXX11_OVERRIDE
-    {
-      std::string utf8Uri = util::encodeNonUtf8(v.s());
-      uris_.push_back(utf8Uri);
-      torrent_->urlList.push_back(utf8Uri);
-    }
-
-    virtual void visit(const Integer& v) CXX11_OVERRIDE {}
-    virtual void visit(const Bool& v) CXX11_OVERRIDE {}
-    virtual void visit(const Null& v) CXX11_OVERRIDE {}
-
-    virtual void visit(const List& v) CXX11_OVERRIDE
-    {
-      for (auto& elem : v) {
-        const String* uri = downcast<String>(elem);
-        if (uri) {
-          std::string utf8Uri = util::encodeNonUtf8(uri->s());
-          uris_.push_back(utf8Uri);
-          torrent_->urlList.push_back(utf8Uri);
-        }
+  auto addUri = [&](const BencodeView& uri) {
+    std::string utf8Uri = util::encodeNonUtf8(uri.str());
+    uris.push_back(utf8Uri);
+    torrent->urlList.push_back(utf8Uri);
+  };
+  if (v.isString()) {
+    addUri(v);
+  }
+  else if (v.isList()) {
+    for (auto c = v.children(); c.valid(); c.next()) {
+      if (c.value().isString()) {
+        addUri(c.value());
       }
     }
-    virtual void visit(const Dict& v) CXX11_OVERRIDE {}
-  };
-
-  if (v) {
-    UrlListVisitor visitor(uris, torrent);
-    v->accept(visitor);
   }
 }
 } // namespace
@@ -174,9 +155,62 @@ OutputIterator createUri(InputIterator first, InputIterator last,
 }
 } // namespace
 
+namespace {
+bool keyEquals(const BencodeView& key, const char* s)
+{
+  auto k = key.s();
+  auto len = strlen(s);
+  return k.size() == len && memcmp(k.data(), s, len) == 0;
+}
+} // namespace
+
+namespace {
+// The values of the info dictionary used to create a download.  If a
+// key is missing, its value is BV_NONE.
+struct InfoDict {
+  BencodeView name;
+  BencodeView nameUtf8;
+  BencodeView files;
+  BencodeView length;
+  BencodeView pieces;
+  BencodeView pieceLength;
+  BencodeView privateFlag;
+
+  // Reads |info| in a single pass, so that a huge file list is not
+  // scanned for each key.
+  InfoDict(const BencodeView& info)
+  {
+    for (auto c = info.children(); c.valid(); c.next()) {
+      auto& key = c.key();
+      if (keyEquals(key, C_NAME)) {
+        name = c.value();
+      }
+      else if (keyEquals(key, C_NAME_UTF8)) {
+        nameUtf8 = c.value();
+      }
+      else if (keyEquals(key, C_FILES)) {
+        files = c.value();
+      }
+      else if (keyEquals(key, C_LENGTH)) {
+        length = c.value();
+      }
+      else if (keyEquals(key, C_PIECES)) {
+        pieces = c.value();
+      }
+      else if (keyEquals(key, C_PIECE_LENGTH)) {
+        pieceLength = c.value();
+      }
+      else if (keyEquals(key, C_PRIVATE)) {
+        privateFlag = c.value();
+      }
+    }
+  }
+};
+} // namespace
+
 namespace {
 void extractFileEntries(const std::shared_ptr<DownloadContext>& ctx,
-                        TorrentAttribute* torrent, const Dict* infoDict,
+                        TorrentAttribute* torrent, const InfoDict& infoDict,
                         const std::shared_ptr<Option>& option,
                         const std::string& defaultName,
                         const std::string& overrideName,
@@ -184,19 +218,13 @@ void extractFileEntries(const std::shared_ptr<DownloadContext>& ctx,
 {
   std::string utf8Name;
   if (overrideName.empty()) {
-    std::string nameKey;
-    if (infoDict->containsKey(C_NAME_UTF8)) {
-      nameKey = C_NAME_UTF8;
-    }
-    else {
-      nameKey = C_NAME;
-    }
-    const String* nameData = downcast<String>(infoDict->get(nameKey));
-    if (nameData) {
-      utf8Name = util::encodeNonUtf8(nameData->s());
+    const auto& nameData =
+        infoDict.nameUtf8.none() ? infoDict.name : infoDict.nameUtf8;
+    if (nameData.isString()) {
+      utf8Name = util::encodeNonUtf8(nameData.str());
       if (util::detectDirTraversal(utf8Name)) {
         throw DL_ABORT_EX2(
-            fmt(MSG_DIR_TRAVERSAL_DETECTED, nameData->s().c_str()),
+            fmt(MSG_DIR_TRAVERSAL_DETECTED, nameData.str().c_str()),
             error_code::BITTORRENT_PARSE_ERROR);
       }
     }
@@ -211,59 +239,57 @@ void extractFileEntries(const std::shared_ptr<DownloadContext>& ctx,
   torrent->name = utf8Name;
   int maxConn = option->getAsInt(PREF_MAX_CONNECTION_PER_SERVER);
   std::vector<std::shared_ptr<FileEntry>> fileEntries;
-  const List* filesList = downcast<List>(infoDict->get(C_FILES));
-  if (filesList) {
-    fileEntries.reserve(filesList->size());
+  if (infoDict.files.isList()) {
     int64_t length = 0;
     int64_t offset = 0;
     // multi-file mode
     torrent->mode = BT_FILE_MODE_MULTI;
-    for (auto& f : *filesList) {
-      const Dict* fileDict = downcast<Dict>(f);
-      if (!fileDict) {
+    for (auto f = infoDict.files.children(); f.valid(); f.next()) {
+      const auto& fileDict = f.value();
+      if (!fileDict.isDict()) {
         continue;
       }
-      const Integer* fileLengthData =
-          downcast<Integer>(fileDict->get(C_LENGTH));
-      if (!fileLengthData) {
+      BencodeView fileLengthData, pathData, pathUtf8Data;
+      for (auto c = fileDict.children(); c.valid(); c.next()) {
+        if (keyEquals(c.key(), C_LENGTH)) {
+          fileLengthData = c.value();
+        }
+        else if (keyEquals(c.key(), C_PATH)) {
+          pathData = c.value();
+        }
+        else if (keyEquals(c.key(), C_PATH_UTF8)) {
+          pathUtf8Data = c.value();
+        }
+      }
+      if (!fileLengthData.isInteger()) {
         throw DL_ABORT_EX2(fmt(MSG_MISSING_BT_INFO, C_LENGTH),
                            error_code::BITTORRENT_PARSE_ERROR);
       }
 
-      if (fileLengthData->i() < 0) {
+      if (fileLengthData.i() < 0) {
         throw DL_ABORT_EX2(
-            fmt(MSG_NEGATIVE_LENGTH_BT_INFO, C_LENGTH, fileLengthData->i()),
+            fmt(MSG_NEGATIVE_LENGTH_BT_INFO, C_LENGTH, fileLengthData.i()),
             error_code::BITTORRENT_PARSE_ERROR);
       }
 
-      if (length > std::numeric_limits<int64_t>::max() - fileLengthData->i()) {
+      if (length > std::numeric_limits<int64_t>::max() - fileLengthData.i()) {
         throw DOWNLOAD_FAILURE_EXCEPTION(fmt(EX_TOO_LARGE_FILE, length));
       }
-      length += fileLengthData->i();
-      if (fileLengthData->i() > std::numeric_limits<a2_off_t>::max()) {
+      length += fileLengthData.i();
+      if (fileLengthData.i() > std::numeric_limits<a2_off_t>::max()) {
         throw DOWNLOAD_FAILURE_EXCEPTION(fmt(EX_TOO_LARGE_FILE, length));
       }
-      std::string pathKey;
-      if (fileDict->containsKey(C_PATH_UTF8)) {
-        pathKey = C_PATH_UTF8;
-      }
-      else {
-        pathKey = C_PATH;
-      }
-      const List* pathList = downcast<List>(fileDict->get(pathKey));
-      if (!pathList || pathList->empty()) {
+      const auto& pathList = pathUtf8Data.none() ? pathData : pathUtf8Data;
+      if (!pathList.isList() || !pathList.children().valid()) {
         throw DL_ABORT_EX2("Path is empty.",
                            error_code::BITTORRENT_PARSE_ERROR);
       }
 
-      std::vector<std::string> pathelem(pathList->size() + 1);
-      pathelem[0] = utf8Name;
-      auto pathelemOutItr = pathelem.begin();
-      ++pathelemOutItr;
-      for (auto& p : *pathList) {
-        const String* elem = downcast<String>(p);
-        if (elem) {
-          (*pathelemOutItr++) = elem->s();
+      std::vector<std::string> pathelem;
+      pathelem.push_back(utf8Name);
+      for (auto p = pathList.children(); p.valid(); p.next()) {
+        if (p.value().isString()) {
+          pathelem.push_back(p.value().str());
         }
         else {
           throw DL_ABORT_EX2("Path element is not string.",
@@ -290,7 +316,7 @@ void extractFileEntries(const std::shared_ptr<DownloadContext>& ctx,
 
       auto fileEntry = std::make_shared<FileEntry>(
           util::applyDir(option->get(PREF_DIR), suffixPath),
-          fileLengthData->i(), offset, uris);
+          fileLengthData.i(), offset, uris);
       fileEntry->setOriginalName(utf8Path);
       fileEntry->setSuffixPath(suffixPath);
       fileEntry->setMaxConnectionPerServer(maxConn);
@@ -301,12 +327,12 @@ void extractFileEntries(const std::shared_ptr<DownloadContext>& ctx,
   else {
     // single-file mode;
     torrent->mode = BT_FILE_MODE_SINGLE;
-    const Integer* lengthData = downcast<Integer>(infoDict->get(C_LENGTH));
-    if (!lengthData) {
+    const auto& lengthData = infoDict.length;
+    if (!lengthData.isInteger()) {
       throw DL_ABORT_EX2(fmt(MSG_MISSING_BT_INFO, C_LENGTH),
                          error_code::BITTORRENT_PARSE_ERROR);
     }
-    int64_t totalLength = lengthData->i();
+    int64_t totalLength = lengthData.i();
 
     if (totalLength < 0) {
       throw DL_ABORT_EX2(
@@ -348,20 +374,20 @@ void extractFileEntries(const std::shared_ptr<DownloadContext>& ctx,
 } // namespace
 
 namespace {
-void extractAnnounce(TorrentAttribute* torrent, const Dict* rootDict)
+void extractAnnounce(TorrentAttribute* torrent,
+                     const BencodeView& announceList,
+                     const BencodeView& announce)
 {
-  const List* announceList = downcast<List>(rootDict->get(C_ANNOUNCE_LIST));
-  if (announceList) {
-    for (auto& elem : *announceList) {
-      const List* tier = downcast<List>(elem);
-      if (!tier) {
+  if (announceList.isList()) {
+    for (auto c = announceList.children(); c.valid(); c.next()) {
+      const auto& tier = c.value();
+      if (!tier.isList()) {
         continue;
       }
       std::vector<std::string> ntier;
-      for (auto& t : *tier) {
-        const String* uri = downcast<String>(t);
-        if (uri) {
-          ntier.push_back(util::encodeNonUtf8(util::strip(uri->s())));
+      for (auto t = tier.children(); t.valid(); t.next()) {
+        if (t.value().isString()) {
+          ntier.push_back(util::encodeNonUtf8(util::strip(t.value().str())));
         }
       }
       if (!ntier.empty()) {
@@ -369,79 +395,114 @@ void extractAnnounce(TorrentAttribute* torrent, const Dict* rootDict)
       }
     }
   }
-  else {
-    const String* announce = downcast<String>(rootDict->get(C_ANNOUNCE));
-    if (announce) {
-      std::vector<std::string> tier;
-      tier.push_back(util::encodeNonUtf8(util::strip(announce->s())));
-      torrent->announceList.push_back(tier);
-    }
+  else if (announce.isString()) {
+    std::vector<std::string> tier;
+    tier.push_back(util::encodeNonUtf8(util::strip(announce.str())));
+    torrent->announceList.push_back(tier);
   }
 }
 } // namespace
 
 namespace {
-void extractNodes(TorrentAttribute* torrent, const ValueBase* nodesListSrc)
+void extractNodes(TorrentAttribute* torrent, const BencodeView& nodesList)
 {
-  const List* nodesList = downcast<List>(nodesListSrc);
-  if (nodesList) {
-    for (auto& elem : *nodesList) {
-      const List* addrPairList = downcast<List>(elem);
-      if (!addrPairList || addrPairList->size() != 2) {
-        continue;
-      }
-      const String* hostname = downcast<String>(addrPairList->get(0));
-      if (!hostname) {
-        continue;
-      }
-      std::string utf8Hostname =
-          util::encodeNonUtf8(util::strip(hostname->s()));
-      if (utf8Hostname.empty()) {
-        continue;
-      }
-      const Integer* port = downcast<Integer>(addrPairList->get(1));
-      if (!port || !(0 < port->i() && port->i() < 65536)) {
-        continue;
-      }
-      torrent->nodes.push_back(std::make_pair(utf8Hostname, port->i()));
+  if (!nodesList.isList()) {
+    return;
+  }
+  for (auto c = nodesList.children(); c.valid(); c.next()) {
+    if (!c.value().isList()) {
+      continue;
+    }
+    auto pair = c.value().children();
+    if (!pair.valid()) {
+      continue;
+    }
+    auto hostname = pair.value();
+    pair.next();
+    if (!pair.valid()) {
+      continue;
+    }
+    auto port = pair.value();
+    pair.next();
+    if (pair.valid() || !hostname.isString()) {
+      continue;
     }
+    std::string utf8Hostname = util::encodeNonUtf8(util::strip(hostname.str()));
+    if (utf8Hostname.empty()) {
+      continue;
+    }
+    if (!port.isInteger() || !(0 < port.i() && port.i() < 65536)) {
+      continue;
+    }
+    torrent->nodes.push_back(std::make_pair(utf8Hostname, port.i()));
   }
 }
 } // namespace
 
 namespace {
 void processRootDictionary(const std::shared_ptr<DownloadContext>& ctx,
-                           const ValueBase* root,
+                           const BencodeView& root,
                            const std::shared_ptr<Option>& option,
                            const std::string& defaultName,
                            const std::string& overrideName,
                            const std::vector<std::string>& uris)
 {
-  const Dict* rootDict = downcast<Dict>(root);
-  if (!rootDict) {
+  if (!root.isDict()) {
     throw DL_ABORT_EX2("torrent file does not contain a root dictionary.",
                        error_code::BITTORRENT_PARSE_ERROR);
   }
-  const Dict* infoDict = downcast<Dict>(rootDict->get(C_INFO));
-  if (!infoDict) {
+  BencodeView info, urlListData, announceList, announce, nodes, creationDate,
+      comment, commentUtf8, createdBy;
+  for (auto c = root.children(); c.valid(); c.next()) {
+    auto& key = c.key();
+    if (keyEquals(key, C_INFO)) {
+      info = c.value();
+    }
+    else if (keyEquals(key, C_URL_LIST)) {
+      urlListData = c.value();
+    }
+    else if (keyEquals(key, C_ANNOUNCE_LIST)) {
+      announceList = c.value();
+    }
+    else if (keyEquals(key, C_ANNOUNCE)) {
+      announce = c.value();
+    }
+    else if (keyEquals(key, C_NODES)) {
+      nodes = c.value();
+    }
+    else if (keyEquals(key, C_CREATION_DATE)) {
+      creationDate = c.value();
+    }
+    else if (keyEquals(key, C_COMMENT)) {
+      comment = c.value();
+    }
+    else if (keyEquals(key, C_COMMENT_UTF8)) {
+      commentUtf8 = c.value();
+    }
+    else if (keyEquals(key, C_CREATED_BY)) {
+      createdBy = c.value();
+    }
+  }
+  if (!info.isDict()) {
     throw DL_ABORT_EX2(fmt(MSG_MISSING_BT_INFO, C_INFO),
                        error_code::BITTORRENT_PARSE_ERROR);
   }
   auto torrent = std::make_shared<TorrentAttribute>();
 
-  // retrieve infoHash
-  std::string encodedInfoDict = bencode2::encode(infoDict);
+  // retrieve infoHash.  The info dictionary is hashed as it appears in
+  // the torrent file.
+  auto encodedInfoDict = info.raw();
   unsigned char infoHash[INFO_HASH_LENGTH];
   message_digest::digest(infoHash, INFO_HASH_LENGTH,
                          MessageDigest::sha1().get(), encodedInfoDict.data(),
                          encodedInfoDict.size());
   torrent->infoHash.assign(&infoHash[0], &infoHash[INFO_HASH_LENGTH]);
-  torrent->metadata = encodedInfoDict;
+  torrent->metadata = encodedInfoDict.str();
   torrent->metadataSize = encodedInfoDict.size();
 
+  InfoDict infoDict(info);
   // calculate the number of pieces
-  const String* piecesData = downcast<String>(infoDict->get(C_PIECES));
-  if (!piecesData) {
+  if (!infoDict.pieces.isString()) {
     throw DL_ABORT_EX2(fmt(MSG_MISSING_BT_INFO, C_PIECES),
                        error_code::BITTORRENT_PARSE_ERROR);
   }
@@ -449,45 +510,37 @@ void processRootDictionary(const std::shared_ptr<DownloadContext>& ctx,
   //   if(piecesData.s().empty()) {
   //     throw DL_ABORT_EX("The length of piece hash is 0.");
   //   }
-  size_t numPieces = piecesData->s().size() / PIECE_HASH_LENGTH;
+  size_t numPieces = infoDict.pieces.s().size() / PIECE_HASH_LENGTH;
   // Commented out to download 0 length torrent.
   //   if(numPieces == 0) {
   //     throw DL_ABORT_EX("The number of pieces is 0.");
   //   }
   // retrieve piece length
-  const Integer* pieceLengthData =
-      downcast<Integer>(infoDict->get(C_PIECE_LENGTH));
-  if (!pieceLengthData) {
+  const auto& pieceLengthData = infoDict.pieceLength;
+  if (!pieceLengthData.isInteger()) {
     throw DL_ABORT_EX2(fmt(MSG_MISSING_BT_INFO, C_PIECE_LENGTH),
                        error_code::BITTORRENT_PARSE_ERROR);
   }
 
-  if (pieceLengthData->i() < 0) {
+  if (pieceLengthData.i() < 0) {
     throw DL_ABORT_EX2(
-        fmt(MSG_NEGATIVE_LENGTH_BT_INFO, C_PIECE_LENGTH, pieceLengthData->i()),
+        fmt(MSG_NEGATIVE_LENGTH_BT_INFO, C_PIECE_LENGTH, pieceLengthData.i()),
         error_code::BITTORRENT_PARSE_ERROR);
   }
 
-  size_t pieceLength = pieceLengthData->i();
+  size_t pieceLength = pieceLengthData.i();
   ctx->setPieceLength(pieceLength);
   // retrieve piece hashes
-  extractPieceHash(ctx, piecesData->s(), PIECE_HASH_LENGTH, numPieces);
+  extractPieceHash(ctx, infoDict.pieces.s(), PIECE_HASH_LENGTH, numPieces);
   // private flag
-  const Integer* privateData = downcast<Integer>(infoDict->get(C_PRIVATE));
-  int privatefg = 0;
-  if (privateData) {
-    if (privateData->i() == 1) {
-      privatefg = 1;
-    }
-  }
-  if (privatefg) {
+  if (infoDict.privateFlag.isInteger() && infoDict.privateFlag.i() == 1) {
     torrent->privateTorrent = true;
   }
   // retrieve uri-list.
   // This implementation obeys HTTP-Seeding specification:
   // see http://www.getright.com/seedtorrent.html
   std::vector<std::string> urlList;
-  extractUrlList(torrent.get(), urlList, rootDict->get(C_URL_LIST));
+  extractUrlList(torrent.get(), urlList, urlListData);
   urlList.insert(urlList.end(), uris.begin(), uris.end());
   std::sort(urlList.begin(), urlList.end());
   urlList.erase(std::unique(urlList.begin(), urlList.end()), urlList.end());
@@ -500,42 +553,106 @@ void processRootDictionary(const std::shared_ptr<DownloadContext>& ctx,
                        error_code::BITTORRENT_PARSE_ERROR);
   }
   // retrieve announce
-  extractAnnounce(torrent.get(), rootDict);
+  extractAnnounce(torrent.get(), announceList, announce);
   // retrieve nodes
-  extractNodes(torrent.get(), rootDict->get(C_NODES));
+  extractNodes(torrent.get(), nodes);
 
-  const Integer* creationDate =
-      downcast<Integer>(rootDict->get(C_CREATION_DATE));
-  if (creationDate) {
-    torrent->creationDate = creationDate->i();
+  if (creationDate.isInteger()) {
+    torrent->creationDate = creationDate.i();
   }
-  const String* commentUtf8 = downcast<String>(rootDict->get(C_COMMENT_UTF8));
-  if (commentUtf8) {
-    torrent->comment = util::encodeNonUtf8(commentUtf8->s());
+  if (commentUtf8.isString()) {
+    torrent->comment = util::encodeNonUtf8(commentUtf8.str());
   }
-  else {
-    const String* comment = downcast<String>(rootDict->get(C_COMMENT));
-    if (comment) {
-      torrent->comment = util::encodeNonUtf8(comment->s());
-    }
+  else if (comment.isString()) {
+    torrent->comment = util::encodeNonUtf8(comment.str());
   }
-  const String* createdBy = downcast<String>(rootDict->get(C_CREATED_BY));
-  if (createdBy) {
-    torrent->createdBy = util::encodeNonUtf8(createdBy->s());
+  if (createdBy.isString()) {
+    torrent->createdBy = util::encodeNonUtf8(createdBy.str());
   }
 
   ctx->setAttribute(CTX_ATTR_BT, std::move(torrent));
 }
 } // namespace
 
+namespace {
+// The content of a torrent file.  The file is mapped into memory if
+// mmap is available, so that a huge torrent file is not copied.
+class TorrentFile {
+public:
+  TorrentFile(const std::string& filename)
+      : data_(nullptr), size_(0), mapped_(false)
+  {
+    int fd;
+    while ((fd = a2open(utf8ToWChar(filename).c_str(), O_BINARY | O_RDONLY,
+                        OPEN_MODE)) == -1 &&
+           errno == EINTR)
+      ;
+    if (fd == -1) {
+      int errNum = errno;
+      throw DL_ABORT_EX2(fmt(EX_FILE_OPEN, filename.c_str(),
+                             util::safeStrerror(errNum).c_str()),
+                         error_code::FILE_OPEN_ERROR);
+    }
+    auto fdclose = defer(fd, close);
+    a2_struct_stat st;
+    if (a2fstat(fd, &st) == 0 && st.st_size > 0 &&
+        static_cast<uint64_t>(st.st_size) <= SIZE_MAX) {
+      size_ = st.st_size;
+#ifdef HAVE_MMAP
+      auto addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr != MAP_FAILED) {
+        data_ = static_cast<const unsigned char*>(addr);
+        mapped_ = true;
+        return;
+      }
+#endif // HAVE_MMAP
+      buf_.reserve(size_);
+    }
+    std::array<char, 16_k> buf;
+    ssize_t nread;
+    while ((nread = read(fd, buf.data(), buf.size())) != 0) {
+      if (nread == -1) {
+        if (errno == EINTR) {
+          continue;
+        }
+        int errNum = errno;
+        throw DL_ABORT_EX2(fmt(EX_FILE_READ, filename.c_str(),
+                               util::safeStrerror(errNum).c_str()),
+                           error_code::FILE_IO_ERROR);
+      }
+      buf_.append(buf.data(), nread);
+    }
+    data_ = reinterpret_cast<const unsigned char*>(buf_.data());
+    size_ = buf_.size();
+  }
+
+  ~TorrentFile()
+  {
+#ifdef HAVE_MMAP
+    if (mapped_) {
+      munmap(const_cast<unsigned char*>(data_), size_);
+    }
+#endif // HAVE_MMAP
+  }
+
+  const unsigned char* data() const { return data_; }
+
+  size_t size() const { return size_; }
+
+private:
+  const unsigned char* data_;
+  size_t size_;
+  bool mapped_;
+  std::string buf_;
+};
+} // namespace
+
 void load(const std::string& torrentFile,
           const std::shared_ptr<DownloadContext>& ctx,
           const std::shared_ptr<Option>& option,
           const std::string& overrideName)
 {
-  ValueBaseBencodeParser parser;
-  processRootDictionary(ctx, parseFile(parser, torrentFile).get(), option,
-                        torrentFile, overrideName, std::vector<std::string>());
+  load(torrentFile, ctx, option, std::vector<std::string>(), overrideName);
 }
 
 void load(const std::string& torrentFile,
@@ -543,9 +660,9 @@ void load(const std::string& torrentFile,
           const std::shared_ptr<Option>& option,
           const std::vector<std::string>& uris, const std::string& overrideName)
 {
-  ValueBaseBencodeParser parser;
-  processRootDictionary(ctx, parseFile(parser, torrentFile).get(), option,
-                        torrentFile, overrideName, uris);
+  TorrentFile file(torrentFile);
+  loadFromMemory(file.data(), file.size(), ctx, option, uris, torrentFile,
+                 overrideName);
 }
 
 void loadFromMemory(const unsigned char* content, size_t length,
@@ -554,8 +671,8 @@ void loadFromMemory(const unsigned char* content, size_t length,
                     const std::string& defaultName,
                     const std::string& overrideName)
 {
-  processRootDictionary(ctx, bencode2::decode(content, length).get(), option,
-                        defaultName, overrideName, std::vector<std::string>());
+  loadFromMemory(content, length, ctx, option, std::vector<std::string>(),
+                 defaultName, overrideName);
 }
 
 void loadFromMemory(const unsigned char* content, size_t length,
@@ -565,7 +682,7 @@ void loadFromMemory(const unsigned char* content, size_t length,
                     const std::string& defaultName,
                     const std::string& overrideName)
 {
-  processRootDictionary(ctx, bencode2::decode(content, length).get(), option,
+  processRootDictionary(ctx, BencodeView::parse(content, length), option,
                         defaultName, overrideName, uris);
 }
 
@@ -575,8 +692,9 @@ void loadFromMemory(const std::string& context,
                     const std::string& defaultName,
                     const std::string& overrideName)
 {
-  processRootDictionary(ctx, bencode2::decode(context).get(), option,
-                        defaultName, overrideName, std::vector<std::string>());
+  loadFromMemory(reinterpret_cast<const unsigned char*>(context.data()),
+                 context.size(), ctx, option, std::vector<std::string>(),
+                 defaultName, overrideName);
 }
 
 void loadFromMemory(const std::string& context,
@@ -586,8 +704,8 @@ void loadFromMemory(const std::string& context,
                     const std::string& defaultName,
                     const std::string& overrideName)
 {
-  processRootDictionary(ctx, bencode2::decode(context).get(), option,
-                        defaultName, overrideName, uris);
+  loadFromMemory(reinterpret_cast<const unsigned char*>(context.data()),
+                 context.size(), ctx, option, uris, defaultName, overrideName);
 }
 
 void loadFromMemory(const ValueBase* torrent,
@@ -597,7 +715,8 @@ void loadFromMemory(const ValueBase* torrent,
                     const std::string& defaultName,
                     const std::string& overrideName)
 {
-  processRootDictionary(ctx, torrent, option, defaultName, overrideName, uris);
+  loadFromMemory(bencode2::encode(torrent), ctx, option, uris, defaultName,
+                 overrideName);
 }
 
 TorrentAttribute* getTorrentAttrs(const std::shared_ptr<DownloadContext>& dctx)
@@ -66,7 +66,7 @@
 #ifdef ENABLE_BITTORRENT
 #  include "bittorrent_helper.h"
 #  include "BtConstants.h"
-#  include "ValueBaseBencodeParser.h"
+#  include "bencode2.h"
 #endif // ENABLE_BITTORRENT
 
 namespace aria2 {
@@ -182,19 +182,28 @@ std::shared_ptr<MetadataInfo> createMetadataInfoDataOnly()
 #ifdef ENABLE_BITTORRENT
 
 namespace {
+// Creates RequestGroup from torrent file content |torrentData|.  If
+// |torrentData| is empty, the torrent file |metaInfoUri| is loaded.
 std::shared_ptr<RequestGroup>
 createBtRequestGroup(const std::string& metaInfoUri,
                      const std::shared_ptr<Option>& optionTemplate,
                      const std::vector<std::string>& auxUris,
-                     const ValueBase* torrent, bool adjustAnnounceUri = true)
+                     const std::string& torrentData,
+                     bool adjustAnnounceUri = true)
 {
   auto option = util::copy(optionTemplate);
   auto gid = getGID(option);
   auto rg = std::make_shared<RequestGroup>(gid, option);
   auto dctx = std::make_shared<DownloadContext>();
   // may throw exception
-  bittorrent::loadFromMemory(torrent, dctx, option, auxUris,
-                             metaInfoUri.empty() ? "default" : metaInfoUri);
+  if (torrentData.empty()) {
+    bittorrent::load(metaInfoUri, dctx, option, auxUris);
+  }
+  else {
+    bittorrent::loadFromMemory(torrentData, dctx, option, auxUris,
+                               metaInfoUri.empty() ? "default"
+                                                   : metaInfoUri);
+  }
   for (auto& fe : dctx->getFileEntries()) {
     auto& uris = fe->getRemainingUris();
     std::shuffle(std::begin(uris), std::end(uris),
@@ -252,11 +261,18 @@ createBtMagnetRequestGroup(const std::string& magnetLink,
         util::applyDir(optionTemplate->get(PREF_DIR),
                        util::toHex(torrentAttrs->infoHash) + ".torrent");
 
-    bittorrent::ValueBaseBencodeParser parser;
-    auto torrent = parseFile(parser, torrentFilename);
-    if (torrent) {
-      auto rg = createBtRequestGroup(torrentFilename, optionTemplate, {},
-                                     torrent.get());
+    std::shared_ptr<RequestGroup> rg;
+    if (File(torrentFilename).isFile()) {
+      try {
+        rg = createBtRequestGroup(torrentFilename, optionTemplate, {}, "");
+      }
+      catch (RecoverableException& e) {
+        A2_LOG_INFO_EX(fmt("Could not load BitTorrent metadata from %s",
+                           torrentFilename.c_str()),
+                       e);
+      }
+    }
+    if (rg) {
       const auto& actualInfoHash =
           bittorrent::getTorrentAttrs(rg->getDownloadContext())->infoHash;
 
@@ -307,29 +323,6 @@ void createRequestGroupForBitTorrent(
     const std::shared_ptr<Option>& option, const std::vector<std::string>& uris,
     const std::string& metaInfoUri, const std::string& torrentData,
     bool adjustAnnounceUri)
-{
-  std::unique_ptr<ValueBase> torrent;
-  bittorrent::ValueBaseBencodeParser parser;
-  if (torrentData.empty()) {
-    torrent = parseFile(parser, metaInfoUri);
-  }
-  else {
-    ssize_t error;
-    torrent = parser.parseFinal(torrentData.c_str(), torrentData.size(), error);
-  }
-  if (!torrent) {
-    throw DL_ABORT_EX2("Bencode decoding failed",
-                       error_code::BENCODE_PARSE_ERROR);
-  }
-  createRequestGroupForBitTorrent(result, option, uris, metaInfoUri,
-                                  torrent.get(), adjustAnnounceUri);
-}
-
-void createRequestGroupForBitTorrent(
-    std::vector<std::shared_ptr<RequestGroup>>& result,
-    const std::shared_ptr<Option>& option, const std::vector<std::string>& uris,
-    const std::string& metaInfoUri, const ValueBase* torrent,
-    bool adjustAnnounceUri)
 {
   std::vector<std::string> nargs;
   if (option->get(PREF_PARAMETERIZED_URI) == A2_V_TRUE) {
@@ -340,12 +333,22 @@ void createRequestGroupForBitTorrent(
   }
   // we ignore -Z option here
   size_t numSplit = option->getAsInt(PREF_SPLIT);
-  auto rg = createBtRequestGroup(metaInfoUri, option, nargs, torrent,
+  auto rg = createBtRequestGroup(metaInfoUri, option, nargs, torrentData,
                                  adjustAnnounceUri);
   rg->setNumConcurrentCommand(numSplit);
   result.push_back(rg);
 }
 
+void createRequestGroupForBitTorrent(
+    std::vector<std::shared_ptr<RequestGroup>>& result,
+    const std::shared_ptr<Option>& option, const std::vector<std::string>& uris,
+    const std::string& metaInfoUri, const ValueBase* torrent,
+    bool adjustAnnounceUri)
+{
+  createRequestGroupForBitTorrent(result, option, uris, metaInfoUri,
+                                  bencode2::encode(torrent), adjustAnnounceUri);
+}
+
 #endif // ENABLE_BITTORRENT
 
 #ifdef ENABLE_METALINK
@@ -407,14 +410,7 @@ public:
     }
     else if (!ignoreLocalPath_ && detector_.guessTorrentFile(uri)) {
       try {
-        bittorrent::ValueBaseBencodeParser parser;
-        auto torrent = parseFile(parser, uri);
-        if (!torrent) {
-          throw DL_ABORT_EX2("Bencode decoding failed",
-                             error_code::BENCODE_PARSE_ERROR);
-        }
-        requestGroups_.push_back(
-            createBtRequestGroup(uri, option_, {}, torrent.get()));
+        requestGroups_.push_back(createBtRequestGroup(uri, option_, {}, ""));
       }
       catch (RecoverableException& e) {
         if (throwOnError_) {
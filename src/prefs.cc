@@ -165,6 +165,10 @@ PrefPtr PREF_TIMEOUT = makePref("timeout");
 // values: 1*digit
 PrefPtr PREF_DNS_TIMEOUT = makePref("dns-timeout");
 // values: 1*digit
+PrefPtr PREF_DNS_CACHE_TTL = makePref("dns-cache-ttl");
+// values: 1*digit
+PrefPtr PREF_DNS_NEGATIVE_CACHE_TTL = makePref("dns-negative-cache-ttl");
+// values: 1*digit
 PrefPtr PREF_CONNECT_TIMEOUT = makePref("connect-timeout");
 // values: 1*digit
 PrefPtr PREF_MAX_TRIES = makePref("max-tries");
@@ -315,6 +319,8 @@ PrefPtr PREF_SAVE_SESSION = makePref("save-session");
 // value: 1*digit
 PrefPtr PREF_MAX_CONNECTION_PER_SERVER = makePref("max-connection-per-server");
 // value: 1*digit
+PrefPtr PREF_MAX_HOST_CONNECTIONS = makePref("max-host-connections");
+// value: 1*digit
 PrefPtr PREF_MIN_SPLIT_SIZE = makePref("min-split-size");
 // value: true | false
 PrefPtr PREF_CONDITIONAL_GET = makePref("conditional-get");
@@ -347,6 +353,8 @@ PrefPtr PREF_STOP_WITH_PROCESS = makePref("stop-with-process");
 // value: true | false
 PrefPtr PREF_ENABLE_MMAP = makePref("enable-mmap");
 // value: true | false
+PrefPtr PREF_ENABLE_DIRECT_IO = makePref("enable-direct-io");
+// value: true | false
 PrefPtr PREF_FORCE_SAVE = makePref("force-save");
 // value: true | false
 PrefPtr PREF_SAVE_NOT_FOUND = makePref("save-not-found");
@@ -376,6 +384,10 @@ PrefPtr PREF_STDERR = makePref("stderr");
 // value: true | false
 PrefPtr PREF_KEEP_UNFINISHED_DOWNLOAD_RESULT =
     makePref("keep-unfinished-download-result");
+// value: true | false
+PrefPtr PREF_ENABLE_ENGINE_PROFILE = makePref("enable-engine-profile");
+// value: 1*digit
+PrefPtr PREF_ENGINE_PROFILE_INTERVAL = makePref("engine-profile-interval");
 
 /**
  * FTP related preferences
@@ -388,6 +400,8 @@ PrefPtr PREF_FTP_TYPE = makePref("ftp-type");
 PrefPtr PREF_FTP_PASV = makePref("ftp-pasv");
 // values: true | false
 PrefPtr PREF_FTP_REUSE_CONNECTION = makePref("ftp-reuse-connection");
+// values: true | false
+PrefPtr PREF_FTP_PIPELINING = makePref("ftp-pipelining");
 // values: hashType=digest
 PrefPtr PREF_SSH_HOST_KEY_MD = makePref("ssh-host-key-md");
 
@@ -406,6 +420,7 @@ PrefPtr PREF_SAVE_COOKIES = makePref("save-cookies");
 PrefPtr PREF_ENABLE_HTTP_KEEP_ALIVE = makePref("enable-http-keep-alive");
 // values: true | false
 PrefPtr PREF_ENABLE_HTTP_PIPELINING = makePref("enable-http-pipelining");
+PrefPtr PREF_ENABLE_HTTP2 = makePref("enable-http2");
 // value: 1*digit
 PrefPtr PREF_MAX_HTTP_PIPELINING = makePref("max-http-pipelining");
 // value: string
@@ -552,6 +567,8 @@ PrefPtr PREF_BT_TRACKER_TIMEOUT = makePref("bt-tracker-timeout");
 PrefPtr PREF_BT_TRACKER_CONNECT_TIMEOUT =
     makePref("bt-tracker-connect-timeout");
 // values: 1*digit
+PrefPtr PREF_DHT_LOOKUP_CONCURRENCY = makePref("dht-lookup-concurrency");
+// values: 1*digit
 PrefPtr PREF_DHT_MESSAGE_TIMEOUT = makePref("dht-message-timeout");
 // values: string
 PrefPtr PREF_ON_BT_DOWNLOAD_COMPLETE = makePref("on-bt-download-complete");
@@ -568,6 +585,8 @@ PrefPtr PREF_BT_ENABLE_HOOK_AFTER_HASH_CHECK =
     makePref("bt-enable-hook-after-hash-check");
 // values: true | false
 PrefPtr PREF_BT_LOAD_SAVED_METADATA = makePref("bt-load-saved-metadata");
+// values: 1*digit
+PrefPtr PREF_BT_READ_CACHE = makePref("bt-read-cache");
 
 /**
  * Metalink related preferences
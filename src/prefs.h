@@ -122,6 +122,10 @@ extern PrefPtr PREF_TIMEOUT;
 // values: 1*digit
 extern PrefPtr PREF_DNS_TIMEOUT;
 // values: 1*digit
+extern PrefPtr PREF_DNS_CACHE_TTL;
+// values: 1*digit
+extern PrefPtr PREF_DNS_NEGATIVE_CACHE_TTL;
+// values: 1*digit
 extern PrefPtr PREF_CONNECT_TIMEOUT;
 // values: 1*digit
 extern PrefPtr PREF_MAX_TRIES;
@@ -268,6 +272,8 @@ extern PrefPtr PREF_SAVE_SESSION;
 // value: 1*digit
 extern PrefPtr PREF_MAX_CONNECTION_PER_SERVER;
 // value: 1*digit
+extern PrefPtr PREF_MAX_HOST_CONNECTIONS;
+// value: 1*digit
 extern PrefPtr PREF_MIN_SPLIT_SIZE;
 // value: true | false
 extern PrefPtr PREF_CONDITIONAL_GET;
@@ -300,6 +306,8 @@ extern PrefPtr PREF_STOP_WITH_PROCESS;
 // value: true | false
 extern PrefPtr PREF_ENABLE_MMAP;
 // value: true | false
+extern PrefPtr PREF_ENABLE_DIRECT_IO;
+// value: true | false
 extern PrefPtr PREF_FORCE_SAVE;
 // value: true | false
 extern PrefPtr PREF_SAVE_NOT_FOUND;
@@ -329,6 +337,10 @@ extern PrefPtr PREF_MAX_MMAP_LIMIT;
 extern PrefPtr PREF_STDERR;
 // value: true | false
 extern PrefPtr PREF_KEEP_UNFINISHED_DOWNLOAD_RESULT;
+// value: true | false
+extern PrefPtr PREF_ENABLE_ENGINE_PROFILE;
+// value: 1*digit
+extern PrefPtr PREF_ENGINE_PROFILE_INTERVAL;
 
 /**
  * FTP related preferences
@@ -341,6 +353,8 @@ extern PrefPtr PREF_FTP_TYPE;
 extern PrefPtr PREF_FTP_PASV;
 // values: true | false
 extern PrefPtr PREF_FTP_REUSE_CONNECTION;
+// values: true | false
+extern PrefPtr PREF_FTP_PIPELINING;
 // values: hashType=digest
 extern PrefPtr PREF_SSH_HOST_KEY_MD;
 
@@ -359,6 +373,8 @@ extern PrefPtr PREF_SAVE_COOKIES;
 extern PrefPtr PREF_ENABLE_HTTP_KEEP_ALIVE;
 // values: true | false
 extern PrefPtr PREF_ENABLE_HTTP_PIPELINING;
+// values: true | false
+extern PrefPtr PREF_ENABLE_HTTP2;
 // value: 1*digit
 extern PrefPtr PREF_MAX_HTTP_PIPELINING;
 // value: string
@@ -502,6 +518,8 @@ extern PrefPtr PREF_BT_TRACKER_TIMEOUT;
 // values: 1*digit
 extern PrefPtr PREF_BT_TRACKER_CONNECT_TIMEOUT;
 // values: 1*digit
+extern PrefPtr PREF_DHT_LOOKUP_CONCURRENCY;
+// values: 1*digit
 extern PrefPtr PREF_DHT_MESSAGE_TIMEOUT;
 // values: string
 extern PrefPtr PREF_ON_BT_DOWNLOAD_COMPLETE;
@@ -519,6 +537,8 @@ extern PrefPtr PREF_BT_FORCE_ENCRYPTION;
 extern PrefPtr PREF_BT_ENABLE_HOOK_AFTER_HASH_CHECK;
 // values: true | false
 extern PrefPtr PREF_BT_LOAD_SAVED_METADATA;
+// values: 1*digit
+extern PrefPtr PREF_BT_READ_CACHE;
 
 /**
  * Metalink related preferences
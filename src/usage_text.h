@@ -153,10 +153,11 @@
   _(" --no-file-allocation-limit=SIZE No file allocation is made for files whose\n" \
     "                              size is smaller than SIZE.\n"        \
     "                              You can append K or M(1K = 1024, 1M = 1024K).")
-#define TEXT_ENABLE_DIRECT_IO                                          \
-  _(" --enable-direct-io[=true|false] Enable directI/O, which lowers cpu usage while\n" \
-    "                              allocating files.\n"                 \
-    "                              Turn off if you encounter any error")
+#define TEXT_ENABLE_DIRECT_IO                                           \
+  _(" --enable-direct-io[=true|false] Write files with direct I/O, bypassing\n" \
+    "                              the OS page cache where possible. Use with\n" \
+    "                              --disk-cache so that whole pieces are\n" \
+    "                              written at once.")
 #define TEXT_ALLOW_OVERWRITE                                            \
   _(" --allow-overwrite[=true|false] Restart download from scratch if the\n" \
     "                              corresponding control file doesn't exist.  See\n" \
@@ -192,6 +193,12 @@
   _(" --enable-http-keep-alive[=true|false] Enable HTTP/1.1 persistent connection.")
 #define TEXT_ENABLE_HTTP_PIPELINING                                     \
   _(" --enable-http-pipelining[=true|false] Enable HTTP/1.1 pipelining.")
+#define TEXT_ENABLE_HTTP2                                               \
+  _(" --enable-http2[=true|false] Offer HTTP/2 when connecting to an HTTPS\n" \
+    "                              server without a proxy. If the server selects\n" \
+    "                              it, the segments of a download are fetched as\n" \
+    "                              streams multiplexed over one connection.\n" \
+    "                              This feature is experimental.")
 #define TEXT_CHECK_INTEGRITY                                            \
   _(" -V, --check-integrity[=true|false] Check file integrity by validating piece\n" \
     "                              hashes or a hash of entire file. This option has\n" \
@@ -453,6 +460,12 @@
   _(" --async-dns[=true|false]     Enable asynchronous DNS.")
 #define TEXT_FTP_REUSE_CONNECTION                                       \
   _(" --ftp-reuse-connection[=true|false] Reuse connection in FTP.")
+#define TEXT_FTP_PIPELINING                                             \
+  _(" --ftp-pipelining[=true|false] Send several FTP commands at once without\n" \
+    "                              waiting for each reply, where the order of the\n" \
+    "                              replies is known in advance. This saves round\n" \
+    "                              trips to the server when downloading many small\n" \
+    "                              files.")
 #define TEXT_SUMMARY_INTERVAL                                           \
   _(" --summary-interval=SEC       Set interval to output download progress summary.\n" \
     "                              Setting 0 suppresses the output.")
@@ -645,6 +658,15 @@
     "                              ignored.")
 #define TEXT_DISABLE_IPV6                               \
   _(" --disable-ipv6[=true|false]  Disable IPv6.")
+#define TEXT_DNS_CACHE_TTL                                              \
+  _(" --dns-cache-ttl=SEC          Set the maximum time in seconds resolved\n" \
+    "                              addresses are cached. If the DNS response has a\n" \
+    "                              shorter TTL, it is used instead. Expired\n" \
+    "                              addresses are refreshed in the background while\n" \
+    "                              they are still in use.")
+#define TEXT_DNS_NEGATIVE_CACHE_TTL                                     \
+  _(" --dns-negative-cache-ttl=SEC Set the time in seconds the failure to find a\n" \
+    "                              hostname is cached. 0 disables negative caching.")
 #define TEXT_BT_SAVE_METADATA                                           \
   _(" --bt-save-metadata[=true|false] Save metadata as .torrent file. This option has\n" \
     "                              effect only when BitTorrent Magnet URI is used.\n" \
@@ -723,13 +745,18 @@
     "                              connection is established, this option makes no\n" \
     "                              effect and --bt-tracker-timeout option is used\n" \
     "                              instead.")
+#define TEXT_DHT_LOOKUP_CONCURRENCY                                     \
+  _(" --dht-lookup-concurrency=NUM Set the number of queries a DHT node lookup\n" \
+    "                              keeps in flight.")
 #define TEXT_DHT_MESSAGE_TIMEOUT                \
   _(" --dht-message-timeout=SEC    Set timeout in seconds.")
 #define TEXT_HTTP_ACCEPT_GZIP                   \
   _(" --http-accept-gzip[=true|false] Send 'Accept-Encoding: deflate, gzip' request\n" \
     "                              header and inflate response if remote server\n" \
     "                              responds with 'Content-Encoding: gzip' or\n"  \
-    "                              'Content-Encoding: deflate'.")
+    "                              'Content-Encoding: deflate'. If aria2 is built\n" \
+    "                              with libbrotlidec and/or libzstd, 'br' and\n" \
+    "                              'zstd' are also accepted and decoded.")
 #define TEXT_SAVE_SESSION                       \
   _(" --save-session=FILE          Save error/unfinished downloads to FILE on exit.\n" \
     "                              You can pass this output file to aria2c with -i\n" \
@@ -742,6 +769,12 @@
 #define TEXT_MAX_CONNECTION_PER_SERVER          \
   _(" -x, --max-connection-per-server=NUM The maximum number of connections to one\n" \
     "                              server for each download.")
+#define TEXT_MAX_HOST_CONNECTIONS               \
+  _(" --max-host-connections=NUM   The maximum number of connections to one host\n" \
+    "                              across all downloads. Idle keep-alive\n" \
+    "                              connections count toward the limit. Downloads\n" \
+    "                              which need another connection wait for one to\n" \
+    "                              become idle or closed. 0 means no limit.")
 #define TEXT_MIN_SPLIT_SIZE                     \
   _(" -k, --min-split-size=SIZE    aria2 does not split less than 2*SIZE byte range.\n" \
     "                              For example, let's consider downloading 20MiB\n" \
@@ -1129,5 +1162,30 @@
     "                              file saved by --bt-save-metadata option. If it is\n" \
     "                              successful, then skip downloading metadata from\n" \
     "                              DHT.")
+#define TEXT_BT_READ_CACHE                      \
+  _(" --bt-read-cache=SIZE         Cache the pieces read from the disk to upload\n" \
+    "                              them to peers, which grows to at most SIZE\n" \
+    "                              bytes. The whole piece is read when a peer\n" \
+    "                              requests its first block, and the following\n" \
+    "                              requests are served from memory. The cache is\n" \
+    "                              shared by all downloads. If SIZE is 0, the cache\n" \
+    "                              is disabled.\n" \
+    "                              SIZE can include K or M(1K = 1024, 1M = 1024K).")
+
+#define TEXT_ENABLE_ENGINE_PROFILE \
+  _(" --enable-engine-profile[=true|false]\n" \
+    "                              Measure how long each Command type takes in the\n" \
+    "                              event loop, the duration of each loop iteration,\n" \
+    "                              the time spent waiting for events and the number\n" \
+    "                              of Commands executed per iteration. The result is\n" \
+    "                              written to the log periodically (see\n" \
+    "                              --engine-profile-interval option) and is also\n" \
+    "                              available via aria2.getEngineProfile RPC method.")
+#define TEXT_ENGINE_PROFILE_INTERVAL \
+  _(" --engine-profile-interval=SEC Write the result of engine profiling to the\n" \
+    "                              log every SEC seconds at info level, and start\n" \
+    "                              a new measurement. If 0 is given, the result is\n" \
+    "                              never written to the log. This option has effect\n" \
+    "                              only when --enable-engine-profile is true.")
 
 // clang-format on
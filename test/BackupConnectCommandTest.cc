@@ -0,0 +1,126 @@
+#include "BackupConnectCommand.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "DownloadEngine.h"
+#include "SelectEventPoll.h"
+#include "RequestGroupMan.h"
+#include "RequestGroup.h"
+#include "GroupId.h"
+#include "SocketCore.h"
+#include "Option.h"
+#include "prefs.h"
+#include "wallclock.h"
+#include "RecoverableException.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+class BackupConnectCommandTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(BackupConnectCommandTest);
+  CPPUNIT_TEST(testCreateBackupAddressList);
+  CPPUNIT_TEST(testCreateBackupAddressList_singleFamily);
+  CPPUNIT_TEST(testExecute_blackholedAddress);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testCreateBackupAddressList();
+  void testCreateBackupAddressList_singleFamily();
+  void testExecute_blackholedAddress();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(BackupConnectCommandTest);
+
+void BackupConnectCommandTest::testCreateBackupAddressList()
+{
+  std::vector<std::string> addrs{"2001:db8::1", "2001:db8::2", "192.0.2.1",
+                                 "2001:db8::3", "192.0.2.2"};
+  auto res = createBackupAddressList("2001:db8::1", addrs);
+  CPPUNIT_ASSERT_EQUAL((size_t)4, res.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("192.0.2.1"), res[0]);
+  CPPUNIT_ASSERT_EQUAL(std::string("2001:db8::2"), res[1]);
+  CPPUNIT_ASSERT_EQUAL(std::string("192.0.2.2"), res[2]);
+  CPPUNIT_ASSERT_EQUAL(std::string("2001:db8::3"), res[3]);
+
+  res = createBackupAddressList("192.0.2.1", addrs);
+  CPPUNIT_ASSERT_EQUAL((size_t)4, res.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("2001:db8::1"), res[0]);
+  CPPUNIT_ASSERT_EQUAL(std::string("192.0.2.2"), res[1]);
+  CPPUNIT_ASSERT_EQUAL(std::string("2001:db8::2"), res[2]);
+  CPPUNIT_ASSERT_EQUAL(std::string("2001:db8::3"), res[3]);
+}
+
+void BackupConnectCommandTest::testCreateBackupAddressList_singleFamily()
+{
+  std::vector<std::string> addrs{"192.0.2.1", "192.0.2.2", "192.0.2.3"};
+  auto res = createBackupAddressList("192.0.2.2", addrs);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, res.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("192.0.2.1"), res[0]);
+  CPPUNIT_ASSERT_EQUAL(std::string("192.0.2.3"), res[1]);
+
+  CPPUNIT_ASSERT(createBackupAddressList("192.0.2.1", {"192.0.2.1"}).empty());
+}
+
+namespace {
+class MainCommand : public Command {
+public:
+  MainCommand(cuid_t cuid) : Command(cuid) {}
+  virtual bool execute() CXX11_OVERRIDE { return true; }
+};
+} // namespace
+
+void BackupConnectCommandTest::testExecute_blackholedAddress()
+{
+  SocketCore server;
+  server.bind("127.0.0.1", 0, AF_INET);
+  server.beginListen();
+  auto port = server.getAddrInfo().port;
+  // 127.0.0.2 listens on the same port with the accept queue of
+  // length 0, which is filled by one connection.  The kernel drops
+  // SYN to it after that, just like a blackholed address.
+  SocketCore blackhole;
+  try {
+    blackhole.bind("127.0.0.2", port, AF_INET);
+  }
+  catch (RecoverableException& e) {
+    // 127.0.0.2 is not a loopback address on this platform.
+    return;
+  }
+  CPPUNIT_ASSERT_EQUAL(0, listen(blackhole.getSockfd(), 0));
+  SocketCore filler;
+  filler.establishConnection("127.0.0.2", port);
+  CPPUNIT_ASSERT(filler.isWritable(1));
+  SocketCore mainSocket;
+  mainSocket.establishConnection("127.0.0.2", port);
+
+  auto option = std::make_shared<Option>();
+  option->put(PREF_CONNECT_TIMEOUT, "60");
+  DownloadEngine e(make_unique<SelectEventPoll>());
+  e.setOption(option.get());
+  e.setRequestGroupMan(make_unique<RequestGroupMan>(
+      std::vector<std::shared_ptr<RequestGroup>>{}, 1, option.get()));
+  RequestGroup group(GroupId::create(), option);
+  auto info = std::make_shared<BackupConnectInfo>();
+  MainCommand mainCommand(1);
+  const auto attemptDelay = std::chrono::milliseconds(250);
+  global::wallclock().reset();
+  e.addCommand(make_unique<BackupConnectCommand>(
+      2, "localhost", std::vector<std::string>{"127.0.0.1"}, port,
+      attemptDelay, info, &mainCommand, &group, &e));
+  auto start = std::chrono::steady_clock::now();
+  e.run();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  CPPUNIT_ASSERT_EQUAL(std::string("127.0.0.1"), info->ipaddr);
+  CPPUNIT_ASSERT(info->socket);
+  CPPUNIT_ASSERT(info->finished);
+  CPPUNIT_ASSERT(mainCommand.statusMatch(Command::STATUS_ONESHOT_REALTIME));
+  // The attempt to 127.0.0.1 started after attemptDelay and was
+  // established right away, long before the connect timeout.
+  CPPUNIT_ASSERT(elapsed >= attemptDelay - std::chrono::milliseconds(50));
+  CPPUNIT_ASSERT(elapsed < attemptDelay + std::chrono::milliseconds(500));
+  CPPUNIT_ASSERT(!mainSocket.isWritable(0));
+}
+
+} // namespace aria2
@@ -0,0 +1,111 @@
+#include "common.h"
+
+#include <signal.h>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+
+#include <aria2/aria2.h>
+
+#include "Benchmark.h"
+#include "SocketCore.h"
+#include "ValueBase.h"
+#include "Exception.h"
+#include "json.h"
+#include "util.h"
+
+// Runs the benchmark workloads and writes the results as JSON, so
+// that runs can be compared by a script to catch regressions.
+//
+// Usage: aria2bench [--scale N] [--output FILE] [PATTERN...]
+//
+// Only workloads whose name contains one of PATTERNs are run.  If no
+// PATTERN is given, all workloads are run.
+int main(int argc, char* argv[])
+{
+  using namespace aria2;
+
+  int scale = 1;
+  std::string output;
+  std::vector<std::string> patterns;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+      scale = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+      output = argv[++i];
+    }
+    else {
+      patterns.push_back(argv[i]);
+    }
+  }
+
+  libraryInit();
+#ifdef SIGPIPE
+  // Loopback servers write to connections the client may have closed.
+  signal(SIGPIPE, SIG_IGN);
+#endif // SIGPIPE
+  SocketCore::setProtocolFamily(AF_INET);
+  util::mkdirs(A2_TEST_OUT_DIR);
+
+  int status = EXIT_SUCCESS;
+  auto results = List::g();
+  for (auto& workload : bench::getWorkloads()) {
+    if (!patterns.empty() &&
+        std::none_of(std::begin(patterns), std::end(patterns),
+                     [&workload](const std::string& p) {
+                       return workload.name.find(p) != std::string::npos;
+                     })) {
+      continue;
+    }
+    std::cerr << "Running " << workload.name << std::endl;
+    bench::Result result(workload.name);
+    auto entry = Dict::g();
+    entry->put("name", workload.name);
+    try {
+      workload.func(result, scale);
+    }
+    catch (Exception& e) {
+      std::cerr << e.stackTrace() << std::endl;
+      entry->put("error", e.what());
+      status = EXIT_FAILURE;
+    }
+    auto wall = result.wall.count();
+    auto cpu = result.cpu.count();
+    entry->put("wall_usec", Integer::g(wall));
+    entry->put("cpu_usec", Integer::g(cpu));
+    entry->put("bytes", Integer::g(result.bytes));
+    entry->put("items", Integer::g(result.items));
+    entry->put("allocations", Integer::g(result.allocations));
+    entry->put("bytes_per_sec",
+               Integer::g(wall > 0 ? result.bytes * 1000000 / wall : 0));
+    entry->put("cpu_usec_per_gib",
+               Integer::g(result.bytes > 0
+                              ? static_cast<int64_t>(
+                                    static_cast<double>(cpu) * (1 << 30) /
+                                    result.bytes)
+                              : 0));
+    for (auto& m : result.metrics) {
+      entry->put(m.first, Integer::g(m.second));
+    }
+    results->append(std::move(entry));
+  }
+
+  auto report = Dict::g();
+  report->put("version", PACKAGE_VERSION);
+  report->put("scale", Integer::g(scale));
+  report->put("results", std::move(results));
+  auto json = json::encode(report.get());
+  if (output.empty()) {
+    std::cout << json << std::endl;
+  }
+  else {
+    std::ofstream out(output.c_str(), std::ios::binary);
+    out << json << "\n";
+  }
+
+  libraryDeinit();
+  return status;
+}
@@ -0,0 +1,87 @@
+#include "Benchmark.h"
+
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <cstdlib>
+#include <new>
+#include <atomic>
+
+#include "util.h"
+
+namespace {
+std::atomic<int64_t> allocationCount(0);
+} // namespace
+
+// Count every allocation made by the benchmark binary.  The array
+// forms call these by default.
+void* operator new(size_t size)
+{
+  ++allocationCount;
+  if (size == 0) {
+    size = 1;
+  }
+  void* p = malloc(size);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+
+namespace aria2 {
+
+namespace bench {
+
+std::vector<Workload>& getWorkloads()
+{
+  static std::vector<Workload> workloads;
+  return workloads;
+}
+
+Registrar::Registrar(const char* name, WorkloadFunc func)
+{
+  getWorkloads().push_back(Workload{name, func});
+}
+
+Measure::Measure(Result& result)
+    : result_(result),
+      wallStart_(std::chrono::steady_clock::now()),
+      cpuStart_(getCpuTime()),
+      allocStart_(getAllocationCount())
+{
+}
+
+Measure::~Measure()
+{
+  result_.allocations += getAllocationCount() - allocStart_;
+  result_.cpu += getCpuTime() - cpuStart_;
+  result_.wall += std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - wallStart_);
+}
+
+int64_t getAllocationCount() { return allocationCount; }
+
+std::chrono::microseconds getCpuTime()
+{
+  struct rusage ru;
+#ifdef RUSAGE_THREAD
+  // Exclude the threads running loopback servers.
+  getrusage(RUSAGE_THREAD, &ru);
+#else  // !RUSAGE_THREAD
+  getrusage(RUSAGE_SELF, &ru);
+#endif // !RUSAGE_THREAD
+  return std::chrono::seconds(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) +
+         std::chrono::microseconds(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec);
+}
+
+std::string prepareOutDir(const std::string& name)
+{
+  auto dir = std::string(A2_TEST_OUT_DIR "/bench/") + name;
+  util::mkdirs(dir);
+  return dir;
+}
+
+} // namespace bench
+
+} // namespace aria2
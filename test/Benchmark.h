@@ -0,0 +1,95 @@
+#ifndef D_BENCHMARK_H
+#define D_BENCHMARK_H
+
+#include "common.h"
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <chrono>
+
+namespace aria2 {
+
+namespace bench {
+
+// Measurements of one workload run.  The workload fills bytes, items
+// and metrics; Measure fills the timing and allocation fields.
+struct Result {
+  std::string name;
+  // Payload bytes transferred
+  int64_t bytes;
+  // Number of downloads (or other work units) completed
+  int64_t items;
+  std::chrono::microseconds wall;
+  std::chrono::microseconds cpu;
+  int64_t allocations;
+  // Workload specific integer metrics, reported as is.
+  std::vector<std::pair<std::string, int64_t>> metrics;
+
+  Result(std::string name)
+      : name(std::move(name)),
+        bytes(0),
+        items(0),
+        wall(0),
+        cpu(0),
+        allocations(0)
+  {
+  }
+};
+
+// Runs a workload.  |scale| multiplies the problem size so that the
+// same workload can be used as a quick smoke run and as a long
+// benchmark run.  A workload signals failure by throwing an
+// exception.
+typedef void (*WorkloadFunc)(Result& result, int scale);
+
+struct Workload {
+  std::string name;
+  WorkloadFunc func;
+};
+
+std::vector<Workload>& getWorkloads();
+
+// Registers workload at static initialization time.  Use
+// A2_BENCH_REGISTER(name, func) in workload source files.
+class Registrar {
+public:
+  Registrar(const char* name, WorkloadFunc func);
+};
+
+#define A2_BENCH_REGISTER(name, func)                                          \
+  static ::aria2::bench::Registrar a2benchRegistrar##func(name, func)
+
+// Measures wall clock time, CPU time of the calling thread and the
+// number of heap allocations made in the enclosing scope, and adds
+// them to the result.
+class Measure {
+public:
+  Measure(Result& result);
+  ~Measure();
+
+private:
+  Result& result_;
+  std::chrono::steady_clock::time_point wallStart_;
+  std::chrono::microseconds cpuStart_;
+  int64_t allocStart_;
+};
+
+// Returns the number of operator new calls made so far in this
+// process.
+int64_t getAllocationCount();
+
+// Returns CPU time consumed by the calling thread.  If per thread
+// accounting is not available, returns CPU time of the process.
+std::chrono::microseconds getCpuTime();
+
+// Creates a directory for workload output under A2_TEST_OUT_DIR and
+// returns its path.  Files from previous runs are left there, so
+// workloads must download with allow-overwrite enabled.
+std::string prepareOutDir(const std::string& name);
+
+} // namespace bench
+
+} // namespace aria2
+
+#endif // D_BENCHMARK_H
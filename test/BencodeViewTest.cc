@@ -0,0 +1,186 @@
+#include "BencodeView.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "RecoverableException.h"
+
+namespace aria2 {
+
+namespace bittorrent {
+
+class BencodeViewTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(BencodeViewTest);
+  CPPUNIT_TEST(testParse);
+  CPPUNIT_TEST(testParse_error);
+  CPPUNIT_TEST(testChildren);
+  CPPUNIT_TEST(testGet);
+  CPPUNIT_TEST(testRaw);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testParse();
+  void testParse_error();
+  void testChildren();
+  void testGet();
+  void testRaw();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(BencodeViewTest);
+
+namespace {
+BencodeView parse(const std::string& s)
+{
+  return BencodeView::parse(reinterpret_cast<const unsigned char*>(s.data()),
+                            s.size());
+}
+} // namespace
+
+namespace {
+void checkError(const std::string& s)
+{
+  try {
+    parse(s);
+    CPPUNIT_FAIL("exception must be thrown: " + s);
+  }
+  catch (RecoverableException& e) {
+  }
+}
+} // namespace
+
+void BencodeViewTest::testParse()
+{
+  {
+    std::string s = "5:aria2";
+    auto v = parse(s);
+    CPPUNIT_ASSERT(v.isString());
+    CPPUNIT_ASSERT_EQUAL(std::string("aria2"), v.str());
+  }
+  {
+    std::string s = "0:";
+    auto v = parse(s);
+    CPPUNIT_ASSERT(v.isString());
+    CPPUNIT_ASSERT(v.s().empty());
+  }
+  {
+    std::string s = "i-100e";
+    auto v = parse(s);
+    CPPUNIT_ASSERT(v.isInteger());
+    CPPUNIT_ASSERT_EQUAL((int64_t)-100, v.i());
+  }
+  {
+    // A floating point number is read as 0.
+    std::string s = "i1.5E+2e";
+    auto v = parse(s);
+    CPPUNIT_ASSERT(v.isInteger());
+    CPPUNIT_ASSERT_EQUAL((int64_t)0, v.i());
+  }
+  {
+    std::string s = "le";
+    auto v = parse(s);
+    CPPUNIT_ASSERT(v.isList());
+    CPPUNIT_ASSERT(!v.children().valid());
+  }
+  {
+    std::string s = "de";
+    auto v = parse(s);
+    CPPUNIT_ASSERT(v.isDict());
+    CPPUNIT_ASSERT(!v.children().valid());
+  }
+  {
+    // The bytes after the value are ignored.
+    std::string s = "i1ei2e";
+    auto v = parse(s);
+    CPPUNIT_ASSERT_EQUAL((int64_t)1, v.i());
+  }
+}
+
+void BencodeViewTest::testParse_error()
+{
+  checkError("");
+  checkError("5:aria");
+  checkError("5aria2");
+  checkError("i123");
+  checkError("ie");
+  checkError("i12xe");
+  checkError("i99999999999999999999e");
+  checkError("x");
+  checkError("l5:aria2");
+  checkError("di1e5:aria2e");
+  checkError("d5:aria2e");
+  // An error deep inside is found by parse().
+  checkError("d4:infod5:filesl3:fooee");
+  checkError(std::string(50, 'l') + std::string(50, 'e'));
+  parse(std::string(49, 'l') + std::string(49, 'e'));
+}
+
+void BencodeViewTest::testChildren()
+{
+  {
+    std::string s = "l5:aria2i1ele3:fooe";
+    auto v = parse(s);
+    auto c = v.children();
+    CPPUNIT_ASSERT(c.valid());
+    CPPUNIT_ASSERT_EQUAL(std::string("aria2"), c.value().str());
+    c.next();
+    CPPUNIT_ASSERT(c.valid());
+    CPPUNIT_ASSERT_EQUAL((int64_t)1, c.value().i());
+    c.next();
+    CPPUNIT_ASSERT(c.valid());
+    CPPUNIT_ASSERT(c.value().isList());
+    CPPUNIT_ASSERT(!c.value().children().valid());
+    c.next();
+    CPPUNIT_ASSERT(c.valid());
+    CPPUNIT_ASSERT_EQUAL(std::string("foo"), c.value().str());
+    c.next();
+    CPPUNIT_ASSERT(!c.valid());
+  }
+  {
+    std::string s = "d4:name5:aria24:sizei100e5:filesl3:fooee";
+    auto v = parse(s);
+    auto c = v.children();
+    CPPUNIT_ASSERT(c.valid());
+    CPPUNIT_ASSERT_EQUAL(std::string("name"), c.key().str());
+    CPPUNIT_ASSERT_EQUAL(std::string("aria2"), c.value().str());
+    c.next();
+    CPPUNIT_ASSERT(c.valid());
+    CPPUNIT_ASSERT_EQUAL(std::string("size"), c.key().str());
+    CPPUNIT_ASSERT_EQUAL((int64_t)100, c.value().i());
+    c.next();
+    CPPUNIT_ASSERT(c.valid());
+    CPPUNIT_ASSERT_EQUAL(std::string("files"), c.key().str());
+    auto files = c.value().children();
+    CPPUNIT_ASSERT_EQUAL(std::string("foo"), files.value().str());
+    c.next();
+    CPPUNIT_ASSERT(!c.valid());
+  }
+  {
+    // Not a list nor a dictionary.
+    std::string s = "5:aria2";
+    CPPUNIT_ASSERT(!parse(s).children().valid());
+  }
+}
+
+void BencodeViewTest::testGet()
+{
+  std::string s = "d4:name5:aria24:sizei100e4:name3:fooe";
+  auto v = parse(s);
+  // The last one wins.
+  CPPUNIT_ASSERT_EQUAL(std::string("foo"), v.get("name").str());
+  CPPUNIT_ASSERT_EQUAL((int64_t)100, v.get("size").i());
+  CPPUNIT_ASSERT(v.get("nam").none());
+  CPPUNIT_ASSERT(v.get("size").get("name").none());
+}
+
+void BencodeViewTest::testRaw()
+{
+  std::string s = "d8:announce3:foo4:infod4:name5:aria2ee";
+  auto v = parse(s);
+  CPPUNIT_ASSERT(v.raw() == s);
+  CPPUNIT_ASSERT(v.get("info").raw() == std::string("d4:name5:aria2e"));
+  CPPUNIT_ASSERT(v.get("announce").raw() == std::string("3:foo"));
+}
+
+} // namespace bittorrent
+
+} // namespace aria2
@@ -153,12 +153,12 @@ void BittorrentHelperTest::testGetPieceHash()
   load(A2_TEST_DIR "/test.torrent", dctx, option_);
 
   CPPUNIT_ASSERT_EQUAL(std::string("AAAAAAAAAAAAAAAAAAAA"),
-                       dctx->getPieceHash(0));
+                       dctx->getPieceHash(0).str());
   CPPUNIT_ASSERT_EQUAL(std::string("BBBBBBBBBBBBBBBBBBBB"),
-                       dctx->getPieceHash(1));
+                       dctx->getPieceHash(1).str());
   CPPUNIT_ASSERT_EQUAL(std::string("CCCCCCCCCCCCCCCCCCCC"),
-                       dctx->getPieceHash(2));
-  CPPUNIT_ASSERT_EQUAL(std::string(""), dctx->getPieceHash(3));
+                       dctx->getPieceHash(2).str());
+  CPPUNIT_ASSERT_EQUAL(std::string(""), dctx->getPieceHash(3).str());
 
   CPPUNIT_ASSERT_EQUAL(std::string("sha-1"), dctx->getPieceHashType());
 }
@@ -0,0 +1,122 @@
+#include "Benchmark.h"
+
+#include <memory>
+#include <random>
+
+#include "DirectDiskAdaptor.h"
+#include "DefaultDiskWriter.h"
+#include "PieceReadCache.h"
+#include "FileEntry.h"
+#include "File.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+namespace bench {
+
+namespace {
+// Counts the read calls which reach the file.
+class CountingDiskWriter : public DefaultDiskWriter {
+public:
+  CountingDiskWriter(const std::string& filename, int64_t& count)
+      : DefaultDiskWriter(filename), count_(count)
+  {
+  }
+
+  virtual ssize_t readData(unsigned char* data, size_t len,
+                           int64_t offset) CXX11_OVERRIDE
+  {
+    ++count_;
+    return DefaultDiskWriter::readData(data, len, offset);
+  }
+
+private:
+  int64_t& count_;
+};
+} // namespace
+
+namespace {
+constexpr int32_t PIECE_LENGTH = 256_k;
+constexpr int32_t BLOCK_LENGTH = 16_k;
+constexpr int64_t TOTAL_LENGTH = 64_m;
+} // namespace
+
+namespace {
+// Serves 4096 * |scale| pieces from a 64MiB torrent in 16KiB blocks,
+// just like BtPieceMessage does.  9 out of 10 requests are for the
+// first 1/10 of the pieces.  If |cacheSize| is 0, each block is read
+// from the disk.
+void seedPieces(Result& result, int scale, size_t cacheSize)
+{
+  auto path = prepareOutDir(result.name) + "/file";
+  int64_t reads = 0;
+  auto adaptor = std::make_shared<DirectDiskAdaptor>();
+  adaptor->setDiskWriter(make_unique<CountingDiskWriter>(path, reads));
+  adaptor->setTotalLength(TOTAL_LENGTH);
+  auto fileEntries =
+      std::vector<std::shared_ptr<FileEntry>>{std::make_shared<FileEntry>(
+          path, TOTAL_LENGTH, 0)};
+  adaptor->setFileEntries(std::begin(fileEntries), std::end(fileEntries));
+  adaptor->initAndOpenFile();
+  std::vector<unsigned char> buf(PIECE_LENGTH, 'a');
+  for (int64_t off = 0; off < TOTAL_LENGTH; off += PIECE_LENGTH) {
+    adaptor->writeData(buf.data(), buf.size(), off);
+  }
+  reads = 0;
+  std::unique_ptr<PieceReadCache> cache;
+  if (cacheSize > 0) {
+    cache = make_unique<PieceReadCache>(cacheSize);
+  }
+  const size_t numPieces = TOTAL_LENGTH / PIECE_LENGTH;
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<size_t> hot(0, numPieces / 10 - 1);
+  std::uniform_int_distribution<size_t> all(0, numPieces - 1);
+  std::uniform_int_distribution<int> coin(0, 9);
+  {
+    Measure measure(result);
+    for (int i = 0; i < 4096 * scale; ++i) {
+      size_t index = coin(gen) < 9 ? hot(gen) : all(gen);
+      int64_t pieceOffset = static_cast<int64_t>(index) * PIECE_LENGTH;
+      for (int32_t begin = 0; begin < PIECE_LENGTH; begin += BLOCK_LENGTH) {
+        ssize_t r;
+        if (cache) {
+          r = cache->readData(buf.data(), BLOCK_LENGTH, pieceOffset + begin, 1,
+                              index, pieceOffset, PIECE_LENGTH, adaptor.get());
+        }
+        else {
+          r = adaptor->readData(buf.data(), BLOCK_LENGTH, pieceOffset + begin);
+        }
+        result.bytes += r;
+      }
+      ++result.items;
+    }
+  }
+  adaptor->closeFile();
+  result.metrics.push_back({"disk_reads", reads});
+  if (cache) {
+    result.metrics.push_back({"cache_hits", cache->getHits()});
+  }
+}
+} // namespace
+
+namespace {
+void seedPiecesNoCache(Result& result, int scale)
+{
+  seedPieces(result, scale, 0);
+}
+} // namespace
+
+A2_BENCH_REGISTER("bt-seed-read", seedPiecesNoCache);
+
+namespace {
+void seedPiecesReadCache(Result& result, int scale)
+{
+  seedPieces(result, scale, 16_m);
+}
+} // namespace
+
+A2_BENCH_REGISTER("bt-seed-read-cache", seedPiecesReadCache);
+
+} // namespace bench
+
+} // namespace aria2
@@ -0,0 +1,201 @@
+#include "Benchmark.h"
+
+#include <cstring>
+#include <memory>
+
+#include <aria2/aria2.h>
+
+#include "LoopbackHttpServer.h"
+#include "LoopbackBtPeer.h"
+#include "aria2api.h"
+#include "Context.h"
+#include "MultiUrlRequestInfo.h"
+#include "DownloadEngine.h"
+#include "EngineProfiler.h"
+#include "MessageDigest.h"
+#include "ValueBase.h"
+#include "bencode2.h"
+#include "bittorrent_helper.h"
+#include "File.h"
+#include "BufferedFile.h"
+#include "DlAbortEx.h"
+#include "fmt.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+namespace bench {
+
+namespace {
+constexpr int32_t PIECE_LENGTH = 256_k;
+} // namespace
+
+namespace {
+// Returns the bencoded info dictionary of a single file torrent of
+// |length| bytes of the content LoopbackBtPeer shares.
+std::string createInfo(int64_t length)
+{
+  std::string pieces;
+  std::vector<unsigned char> buf(PIECE_LENGTH);
+  for (int64_t offset = 0; offset < length; offset += PIECE_LENGTH) {
+    auto len = std::min(static_cast<int64_t>(PIECE_LENGTH), length - offset);
+    for (int64_t i = 0; i < len; ++i) {
+      buf[i] = 'a' + (offset + i) % 26;
+    }
+    pieces += MessageDigest::sha1()->update(buf.data(), len).digest();
+  }
+  Dict info;
+  info.put("name", "swarm");
+  info.put("piece length", Integer::g(PIECE_LENGTH));
+  info.put("length", Integer::g(length));
+  info.put("pieces", std::move(pieces));
+  return bencode2::encode(&info);
+}
+} // namespace
+
+namespace {
+// Returns the compact tracker response listing |peers|.
+std::string createAnnounceResponse(
+    const std::vector<std::unique_ptr<LoopbackBtPeer>>& peers)
+{
+  std::string compact;
+  for (auto& peer : peers) {
+    unsigned char addr[6] = {127, 0, 0, 1};
+    bittorrent::setShortIntParam(addr + 4, peer->getPort());
+    compact.append(addr, addr + sizeof(addr));
+  }
+  return fmt("d8:intervali1800e5:peers%lu:",
+             static_cast<unsigned long>(compact.size())) +
+         compact + "e";
+}
+} // namespace
+
+namespace {
+// Downloads a torrent of 64MiB * |scale| from |numSeeders|
+// LoopbackBtPeer seeders in 256KiB pieces, found through a loopback
+// HTTP tracker.  If |numLeechers| is not 0, the tracker also lists
+// that many LoopbackBtPeer leechers, and aria2 seeds to them after
+// the download until it uploads as much as the torrent, or at most 1
+// minute.  bytes counts the payload downloaded and uploaded.
+void swarm(Result& result, int scale, size_t numSeeders, size_t numLeechers)
+{
+  const int64_t length = 64_m * scale;
+  auto info = createInfo(length);
+  auto infoHash =
+      MessageDigest::sha1()->update(info.data(), info.size()).digest();
+  std::vector<std::unique_ptr<LoopbackBtPeer>> peers;
+  for (size_t i = 0; i < numSeeders + numLeechers; ++i) {
+    peers.push_back(make_unique<LoopbackBtPeer>(
+        reinterpret_cast<const unsigned char*>(infoHash.data()), PIECE_LENGTH,
+        length, i < numSeeders));
+    peers.back()->start();
+  }
+  LoopbackHttpServer tracker;
+  tracker.setAnnounceResponse(createAnnounceResponse(peers));
+  tracker.start();
+
+  auto dir = prepareOutDir(result.name);
+  auto torrentPath = dir + "/swarm.torrent";
+  {
+    auto announce = tracker.getAnnounceURI();
+    auto torrent = fmt("d8:announce%lu:%s4:info",
+                       static_cast<unsigned long>(announce.size()),
+                       announce.c_str()) +
+                   info + "e";
+    BufferedFile fp(torrentPath.c_str(), BufferedFile::WRITE);
+    if (fp.write(torrent.data(), torrent.size()) != torrent.size() ||
+        fp.close() == EOF) {
+      throw DL_ABORT_EX(fmt("Could not write %s", torrentPath.c_str()));
+    }
+  }
+  // The download starts from scratch each time.
+  File(dir + "/swarm").remove();
+  File(dir + "/swarm.aria2").remove();
+
+  KeyVals options{{"no-conf", "true"},
+                  {"dir", dir},
+                  {"allow-overwrite", "true"},
+                  {"auto-file-renaming", "false"},
+                  {"file-allocation", "none"},
+                  {"enable-dht", "false"},
+                  {"enable-dht6", "false"},
+                  {"bt-enable-lpd", "false"},
+                  {"enable-peer-exchange", "false"},
+                  {"seed-ratio", numLeechers ? "1.0" : "0.0"},
+                  {"seed-time", numLeechers ? "1" : "0"},
+                  {"enable-engine-profile", "true"},
+                  {"engine-profile-interval", "0"}};
+  SessionConfig config;
+  config.useSignalHandler = false;
+  auto session = sessionNew(options, config);
+  if (!session) {
+    throw DL_ABORT_EX("Could not create session");
+  }
+  A2Gid gid;
+  {
+    Measure measure(result);
+    if (addTorrent(session, &gid, torrentPath, KeyVals()) != 0) {
+      sessionFinal(session);
+      throw DL_ABORT_EX(fmt("Could not add %s", torrentPath.c_str()));
+    }
+    run(session, RUN_DEFAULT);
+  }
+  auto& e = session->context->reqinfo->getDownloadEngine();
+  auto& profiler = e->getEngineProfiler();
+  auto& iteration = profiler->getIterationTime();
+  result.metrics.push_back(
+      {"loop_iterations", static_cast<int64_t>(iteration.getCount())});
+  result.metrics.push_back({"loop_p50_usec", iteration.getPercentile(50)});
+  result.metrics.push_back({"loop_p99_usec", iteration.getPercentile(99)});
+  result.metrics.push_back({"loop_max_usec", iteration.getMax()});
+  std::string error;
+  auto dh = getDownloadHandle(session, gid);
+  if (!dh || dh->getStatus() != DOWNLOAD_COMPLETE) {
+    error = fmt("Download %s did not complete", gidToHex(gid).c_str());
+  }
+  else {
+    result.bytes += dh->getCompletedLength() + dh->getUploadLength();
+    ++result.items;
+  }
+  if (dh) {
+    deleteDownloadHandle(dh);
+  }
+  sessionFinal(session);
+  tracker.stop();
+  int64_t seederUpload = 0;
+  int64_t leecherDownload = 0;
+  for (auto& peer : peers) {
+    peer->stop();
+    seederUpload += peer->getUploadLength();
+    leecherDownload += peer->getDownloadLength();
+  }
+  result.metrics.push_back({"seeder_upload_bytes", seederUpload});
+  result.metrics.push_back({"leecher_download_bytes", leecherDownload});
+  result.metrics.push_back(
+      {"tracker_requests", static_cast<int64_t>(tracker.getRequestCount())});
+  if (!error.empty()) {
+    throw DL_ABORT_EX(error);
+  }
+}
+} // namespace
+
+namespace {
+// Piece selection, request pipelining and hash checking against 8
+// peers which upload as fast as the loopback interface allows.
+void swarmDownload(Result& result, int scale) { swarm(result, scale, 8, 0); }
+} // namespace
+
+A2_BENCH_REGISTER("bt-swarm-download", swarmDownload);
+
+namespace {
+// Same as bt-swarm-download, but 8 leechers are connected as well,
+// which aria2 uploads to while it downloads and afterwards as a
+// seeder.
+void swarmSeedLeech(Result& result, int scale) { swarm(result, scale, 8, 8); }
+} // namespace
+
+A2_BENCH_REGISTER("bt-swarm-seed-leech", swarmSeedLeech);
+
+} // namespace bench
+
+} // namespace aria2
@@ -0,0 +1,111 @@
+#include "Benchmark.h"
+
+#include <memory>
+
+#include "IteratableChunkChecksumValidator.h"
+#include "DefaultPieceStorage.h"
+#include "DownloadContext.h"
+#include "DiskAdaptor.h"
+#include "DiskWriterFactory.h"
+#include "DefaultDiskWriter.h"
+#include "Option.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+namespace bench {
+
+namespace {
+// Counts the bytes read from the file.
+class CountingDiskWriter : public DefaultDiskWriter {
+public:
+  CountingDiskWriter(const std::string& filename, int64_t& bytes)
+      : DefaultDiskWriter(filename), bytes_(bytes)
+  {
+  }
+
+  virtual ssize_t readData(unsigned char* data, size_t len,
+                           int64_t offset) CXX11_OVERRIDE
+  {
+    auto r = DefaultDiskWriter::readData(data, len, offset);
+    bytes_ += r;
+    return r;
+  }
+
+private:
+  int64_t& bytes_;
+};
+} // namespace
+
+namespace {
+class CountingDiskWriterFactory : public DiskWriterFactory {
+public:
+  CountingDiskWriterFactory(int64_t& bytes) : bytes_(bytes) {}
+
+  virtual std::unique_ptr<DiskWriter>
+  newDiskWriter(const std::string& filename) CXX11_OVERRIDE
+  {
+    return make_unique<CountingDiskWriter>(filename, bytes_);
+  }
+
+private:
+  int64_t& bytes_;
+};
+} // namespace
+
+namespace {
+constexpr int32_t PIECE_LENGTH = 1_m;
+} // namespace
+
+namespace {
+// Checks a 1GiB * |scale| file of 1MiB pieces, only 1 out of 64
+// pieces of which were written.  The rest of the file is a hole.
+void checkSparseFile(Result& result, int scale)
+{
+  auto path = prepareOutDir(result.name) + "/file";
+  const int64_t totalLength = 1_g * scale;
+  const size_t numPieces = totalLength / PIECE_LENGTH;
+  std::string data(PIECE_LENGTH, 'a');
+  {
+    DefaultDiskWriter dw(path);
+    dw.initAndOpenFile();
+    dw.truncate(totalLength);
+    for (size_t i = 0; i < numPieces; i += 64) {
+      dw.writeData(reinterpret_cast<const unsigned char*>(data.data()),
+                   data.size(), static_cast<int64_t>(i) * PIECE_LENGTH);
+    }
+    dw.closeFile();
+  }
+  auto dctx = std::make_shared<DownloadContext>(PIECE_LENGTH, totalLength,
+                                                path);
+  // None of the pieces is valid, so that all of them are checked.
+  std::vector<std::string> hashes(numPieces, std::string(20, '\xff'));
+  dctx->setPieceHashes("sha-1", std::begin(hashes), std::end(hashes));
+  Option option;
+  int64_t bytesRead = 0;
+  auto ps = std::make_shared<DefaultPieceStorage>(dctx, &option);
+  ps->setDiskWriterFactory(
+      std::make_shared<CountingDiskWriterFactory>(bytesRead));
+  ps->initStorage();
+  ps->getDiskAdaptor()->enableReadOnly();
+  ps->getDiskAdaptor()->openFile();
+  IteratableChunkChecksumValidator validator(dctx, ps);
+  {
+    Measure measure(result);
+    validator.init();
+    while (!validator.finished()) {
+      validator.validateChunk();
+    }
+  }
+  ps->getDiskAdaptor()->closeFile();
+  result.bytes += totalLength;
+  result.items += numPieces;
+  result.metrics.push_back({"bytes_read", bytesRead});
+}
+} // namespace
+
+A2_BENCH_REGISTER("check-integrity-sparse", checkSparseFile);
+
+} // namespace bench
+
+} // namespace aria2
@@ -0,0 +1,115 @@
+#include "Benchmark.h"
+
+#include <fstream>
+#include <algorithm>
+#include <sstream>
+#include <memory>
+
+#include "ByteArrayDiskWriter.h"
+#include "SinkStreamFilter.h"
+#include "MockSegment.h"
+#include "DlAbortEx.h"
+#include "fmt.h"
+#include "a2functional.h"
+#ifdef HAVE_ZLIB
+#  include "GZipDecodingStreamFilter.h"
+#endif // HAVE_ZLIB
+#ifdef HAVE_LIBBROTLIDEC
+#  include "BrotliDecodingStreamFilter.h"
+#endif // HAVE_LIBBROTLIDEC
+#ifdef HAVE_LIBZSTD
+#  include "ZstdDecodingStreamFilter.h"
+#endif // HAVE_LIBZSTD
+
+namespace aria2 {
+
+namespace bench {
+
+namespace {
+std::string readFile(const std::string& path)
+{
+  std::ifstream in(path.c_str(), std::ios::binary);
+  if (!in) {
+    throw DL_ABORT_EX(fmt("Could not open %s", path.c_str()));
+  }
+  std::stringstream ss;
+  ss << in.rdbuf();
+  return ss.str();
+}
+} // namespace
+
+namespace {
+// Decodes the content of |path| 32 * |scale| times with Filter.  The
+// input is fed in 16KiB chunks, which is the size of the socket read
+// buffer of HTTP downloads.  bytes is the number of decoded bytes.
+template <typename Filter>
+void decode(Result& result, int scale, const std::string& path)
+{
+  auto data = readFile(path);
+  const size_t chunkSize = 16_k;
+  auto segment = std::make_shared<MockSegment>();
+  int64_t inputBytes = 0;
+  Measure measure(result);
+  for (int i = 0; i < 32 * scale; ++i) {
+    // Decoded data is always written at offset 0, so the writer does
+    // not grow over iterations.
+    auto writer = std::make_shared<ByteArrayDiskWriter>();
+    auto sinkFilter = make_unique<SinkStreamFilter>();
+    sinkFilter->init();
+    Filter filter(std::move(sinkFilter));
+    filter.init();
+    auto p = reinterpret_cast<const unsigned char*>(data.data());
+    for (size_t off = 0; off < data.size(); off += chunkSize) {
+      result.bytes += filter.transform(writer, segment, p + off,
+                                       std::min(chunkSize, data.size() - off));
+    }
+    if (!filter.finished()) {
+      throw DL_ABORT_EX(fmt("%s was not decoded completely", path.c_str()));
+    }
+    filter.release();
+    inputBytes += data.size();
+    ++result.items;
+  }
+  result.metrics.push_back({"input_bytes", inputBytes});
+}
+} // namespace
+
+#ifdef HAVE_ZLIB
+namespace {
+void decodeGZip(Result& result, int scale)
+{
+  decode<GZipDecodingStreamFilter>(result, scale,
+                                   A2_TEST_DIR "/gzip_decode_test.gz");
+}
+} // namespace
+
+A2_BENCH_REGISTER("content_decode_gzip", decodeGZip);
+#endif // HAVE_ZLIB
+
+#ifdef HAVE_LIBBROTLIDEC
+namespace {
+void decodeBrotli(Result& result, int scale)
+{
+  decode<BrotliDecodingStreamFilter>(result, scale,
+                                     A2_TEST_DIR "/brotli_decode_test.br");
+}
+} // namespace
+
+A2_BENCH_REGISTER("content_decode_brotli", decodeBrotli);
+#endif // HAVE_LIBBROTLIDEC
+
+#ifdef HAVE_LIBZSTD
+namespace {
+void decodeZstd(Result& result, int scale)
+{
+  decode<ZstdDecodingStreamFilter>(result, scale,
+                                   A2_TEST_DIR "/zstd_decode_test.zst");
+}
+} // namespace
+
+A2_BENCH_REGISTER("content_decode_zstd", decodeZstd);
+#endif // HAVE_LIBZSTD
+
+} // namespace bench
+
+} // namespace aria2
@@ -0,0 +1,256 @@
+#include "Benchmark.h"
+
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <random>
+
+#include "DefaultBtProgressInfoFile.h"
+#include "DefaultPieceStorage.h"
+#include "DownloadContext.h"
+#include "Piece.h"
+#include "DiskAdaptor.h"
+#include "MultiDiskAdaptor.h"
+#include "OpenedFileCounter.h"
+#include "FileEntry.h"
+#include "Option.h"
+#include "File.h"
+#include "fmt.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+namespace bench {
+
+namespace {
+constexpr size_t NUM_DOWNLOADS = 1000;
+constexpr int32_t PIECE_LENGTH = 16_k;
+// 64Ki pieces, which is an 8KiB bitfield
+constexpr int64_t TOTAL_LENGTH = 1_g;
+} // namespace
+
+namespace {
+struct Download {
+  std::shared_ptr<DownloadContext> dctx;
+  std::shared_ptr<DefaultPieceStorage> pieceStorage;
+  std::unique_ptr<DefaultBtProgressInfoFile> progressInfoFile;
+};
+} // namespace
+
+namespace {
+// Saves the control files of 1000 downloads 20 * |scale| times, just
+// like AutoSaveCommand does.  Each download completes 4 pieces
+// between the saves.
+void saveControlFiles(Result& result, int scale)
+{
+  auto dir = prepareOutDir(result.name);
+  Option option;
+  std::vector<Download> downloads(NUM_DOWNLOADS);
+  for (size_t i = 0; i < NUM_DOWNLOADS; ++i) {
+    auto& d = downloads[i];
+    d.dctx = std::make_shared<DownloadContext>(
+        PIECE_LENGTH, TOTAL_LENGTH, fmt("%s/file%lu", dir.c_str(),
+                                        static_cast<unsigned long>(i)));
+    d.pieceStorage = std::make_shared<DefaultPieceStorage>(d.dctx, &option);
+    d.progressInfoFile = make_unique<DefaultBtProgressInfoFile>(
+        d.dctx, d.pieceStorage, &option);
+  }
+  size_t index = 0;
+  for (int tick = 0; tick < 20 * scale; ++tick) {
+    for (auto& d : downloads) {
+      for (size_t j = 0; j < 4; ++j) {
+        d.pieceStorage->completePiece(
+            d.pieceStorage->getMissingPiece(index + j, 1));
+      }
+    }
+    index += 4;
+    {
+      Measure measure(result);
+      for (auto& d : downloads) {
+        d.progressInfoFile->save();
+      }
+    }
+    result.items += NUM_DOWNLOADS;
+  }
+  int64_t fileBytes = 0;
+  for (auto& d : downloads) {
+    fileBytes += File(d.progressInfoFile->getFilename()).size();
+  }
+  result.metrics.push_back({"control_file_bytes", fileBytes});
+}
+} // namespace
+
+A2_BENCH_REGISTER("control-file-save", saveControlFiles);
+
+namespace {
+constexpr size_t NUM_WRITING_DOWNLOADS = 5;
+constexpr int32_t WRITE_PIECE_LENGTH = 1_m;
+// The data written by each download between the saves
+constexpr size_t PIECES_PER_TICK = 4;
+} // namespace
+
+namespace {
+// Saves the control files of 5 downloads 20 * |scale| times.  Each
+// download writes 4MiB to its file between the saves, which are
+// 100ms apart, as if it were downloading at 40MiB/s.  Only the time
+// spent in the saves is measured.  If |checkpoint| is false, the
+// files are synchronized before the control files are saved, just
+// like RequestGroupMan::save() does.  Otherwise, checkpoints are
+// saved just like RequestGroupMan::checkpoint() does.
+void saveWrittenData(Result& result, int scale, bool checkpoint)
+{
+  auto dir = prepareOutDir(result.name);
+  const int numTicks = 20 * scale;
+  Option option;
+  std::vector<Download> downloads(NUM_WRITING_DOWNLOADS);
+  for (size_t i = 0; i < NUM_WRITING_DOWNLOADS; ++i) {
+    auto& d = downloads[i];
+    d.dctx = std::make_shared<DownloadContext>(
+        WRITE_PIECE_LENGTH,
+        static_cast<int64_t>(WRITE_PIECE_LENGTH) * PIECES_PER_TICK * numTicks,
+        fmt("%s/file%lu", dir.c_str(), static_cast<unsigned long>(i)));
+    d.pieceStorage = std::make_shared<DefaultPieceStorage>(d.dctx, &option);
+    d.pieceStorage->initStorage();
+    d.pieceStorage->getDiskAdaptor()->initAndOpenFile();
+    d.progressInfoFile = make_unique<DefaultBtProgressInfoFile>(
+        d.dctx, d.pieceStorage, &option);
+  }
+  std::string data(WRITE_PIECE_LENGTH, 'a');
+  size_t index = 0;
+  for (int tick = 0; tick < numTicks; ++tick) {
+    for (auto& d : downloads) {
+      for (size_t j = 0; j < PIECES_PER_TICK; ++j) {
+        d.pieceStorage->getDiskAdaptor()->writeData(
+            reinterpret_cast<const unsigned char*>(data.data()), data.size(),
+            static_cast<int64_t>(index + j) * WRITE_PIECE_LENGTH);
+        d.pieceStorage->completePiece(
+            d.pieceStorage->getMissingPiece(index + j, 1));
+      }
+    }
+    index += PIECES_PER_TICK;
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    {
+      Measure measure(result);
+      if (checkpoint) {
+        for (auto& d : downloads) {
+          d.pieceStorage->getDiskAdaptor()->waitWriteback(8);
+          d.progressInfoFile->saveCheckpoint();
+        }
+        for (auto& d : downloads) {
+          d.progressInfoFile->checkpoint();
+          d.pieceStorage->getDiskAdaptor()->startWriteback();
+        }
+      }
+      else {
+        for (auto& d : downloads) {
+          d.pieceStorage->getDiskAdaptor()->flushOSBuffers();
+        }
+        for (auto& d : downloads) {
+          d.progressInfoFile->save();
+        }
+      }
+    }
+    result.bytes += NUM_WRITING_DOWNLOADS * PIECES_PER_TICK * data.size();
+    result.items += NUM_WRITING_DOWNLOADS;
+  }
+  for (auto& d : downloads) {
+    d.pieceStorage->getDiskAdaptor()->closeFile();
+  }
+}
+} // namespace
+
+namespace {
+void saveFlushedData(Result& result, int scale)
+{
+  saveWrittenData(result, scale, false);
+}
+} // namespace
+
+A2_BENCH_REGISTER("control-file-flush", saveFlushedData);
+
+namespace {
+void saveCheckpoints(Result& result, int scale)
+{
+  saveWrittenData(result, scale, true);
+}
+} // namespace
+
+A2_BENCH_REGISTER("control-file-checkpoint", saveCheckpoints);
+
+namespace {
+constexpr size_t NUM_FILES = 1000;
+constexpr int64_t FILE_LENGTH = 256_k;
+constexpr size_t BLOCK_LENGTH = 16_k;
+// The number of files RequestGroupMan::checkpoint() synchronizes for
+// a download at a time.
+constexpr size_t MAX_WRITEBACK_FILES = 8;
+} // namespace
+
+namespace {
+// Waits for the data of a download of 1000 files of 256KiB 20 *
+// |scale| times, with at most 100 files open at a time, which is the
+// default of --bt-max-open-files.  Between the waits, 500 blocks of
+// 16KiB are written to random files, so that many files are closed
+// after being written.  The waits are split just like
+// RequestGroupMan::checkpoint() and continueCheckpoint() do.  The
+// longest call is reported as max_call_usec, and the time spent in
+// the writes, which synchronize the files closed, as write_usec.
+void waitManyFiles(Result& result, int scale)
+{
+  auto dir = prepareOutDir(result.name);
+  std::vector<std::shared_ptr<FileEntry>> fileEntries;
+  for (size_t i = 0; i < NUM_FILES; ++i) {
+    fileEntries.push_back(std::make_shared<FileEntry>(
+        fmt("%s/file%lu", dir.c_str(), static_cast<unsigned long>(i)),
+        FILE_LENGTH, static_cast<int64_t>(i) * FILE_LENGTH));
+  }
+  auto adaptor = std::make_shared<MultiDiskAdaptor>();
+  adaptor->setPieceLength(1_m);
+  adaptor->setFileEntries(std::begin(fileEntries), std::end(fileEntries));
+  adaptor->setOpenedFileCounter(std::make_shared<OpenedFileCounter>(100));
+  adaptor->openFile();
+  std::vector<unsigned char> buf(BLOCK_LENGTH, 'a');
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int64_t> dist(
+      0, NUM_FILES * FILE_LENGTH / BLOCK_LENGTH - 1);
+  std::chrono::steady_clock::duration maxCall{};
+  std::chrono::steady_clock::duration writeTime{};
+  for (int tick = 0; tick < 20 * scale; ++tick) {
+    auto writeStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < 500; ++i) {
+      adaptor->writeData(buf.data(), buf.size(), dist(gen) * BLOCK_LENGTH);
+    }
+    writeTime += std::chrono::steady_clock::now() - writeStart;
+    result.bytes += 500 * BLOCK_LENGTH;
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    {
+      Measure measure(result);
+      for (;;) {
+        auto start = std::chrono::steady_clock::now();
+        auto done = adaptor->waitWriteback(MAX_WRITEBACK_FILES);
+        maxCall = std::max(maxCall, std::chrono::steady_clock::now() - start);
+        if (done) {
+          break;
+        }
+      }
+      adaptor->startWriteback();
+    }
+    ++result.items;
+  }
+  adaptor->closeFile();
+  result.metrics.push_back(
+      {"max_call_usec",
+       std::chrono::duration_cast<std::chrono::microseconds>(maxCall)
+           .count()});
+  result.metrics.push_back(
+      {"write_usec",
+       std::chrono::duration_cast<std::chrono::microseconds>(writeTime)
+           .count()});
+}
+} // namespace
+
+A2_BENCH_REGISTER("control-file-checkpoint-multi", waitManyFiles);
+
+} // namespace bench
+
+} // namespace aria2
@@ -0,0 +1,196 @@
+#include "DHTAbstractNodeLookupTask.h"
+
+#include <cstring>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "DHTNodeLookupTask.h"
+#include "DHTFindNodeReplyMessage.h"
+#include "DHTRoutingTable.h"
+#include "DHTNode.h"
+#include "MockDHTMessageDispatcher.h"
+#include "MockDHTMessageFactory.h"
+#include "util.h"
+
+namespace aria2 {
+
+class DHTAbstractNodeLookupTaskTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(DHTAbstractNodeLookupTaskTest);
+  CPPUNIT_TEST(testStartup);
+  CPPUNIT_TEST(testOnSlowResponse);
+  CPPUNIT_TEST(testOnReceived_closestNodesReplied);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp();
+
+  void testStartup();
+  void testOnSlowResponse();
+  void testOnReceived_closestNodesReplied();
+
+private:
+  std::shared_ptr<DHTNode> localNode_;
+  std::unique_ptr<DHTRoutingTable> routingTable_;
+  std::vector<std::shared_ptr<DHTNode>> nodes_;
+  unsigned char targetID_[DHT_ID_LENGTH];
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DHTAbstractNodeLookupTaskTest);
+
+namespace {
+// Records the nodes queried.
+class RecordingDHTMessageFactory : public MockDHTMessageFactory {
+public:
+  std::vector<std::shared_ptr<DHTNode>> queried;
+
+  virtual std::unique_ptr<DHTFindNodeMessage>
+  createFindNodeMessage(const std::shared_ptr<DHTNode>& remoteNode,
+                        const unsigned char* targetNodeID,
+                        const std::string& transactionID = "") CXX11_OVERRIDE
+  {
+    queried.push_back(remoteNode);
+    return nullptr;
+  }
+};
+} // namespace
+
+namespace {
+std::shared_ptr<DHTNode> createNode(unsigned char firstByte, int index)
+{
+  unsigned char id[DHT_ID_LENGTH];
+  memset(id, 0, DHT_ID_LENGTH);
+  id[0] = firstByte;
+  auto node = std::make_shared<DHTNode>(id);
+  node->setIPAddress("192.168.0." + util::uitos(index + 1));
+  node->setPort(6881);
+  return node;
+}
+} // namespace
+
+namespace {
+std::unique_ptr<DHTFindNodeReplyMessage>
+createReply(const std::shared_ptr<DHTNode>& localNode,
+            const std::shared_ptr<DHTNode>& remoteNode,
+            std::vector<std::shared_ptr<DHTNode>> closestKNodes =
+                std::vector<std::shared_ptr<DHTNode>>{})
+{
+  auto reply = make_unique<DHTFindNodeReplyMessage>(AF_INET, localNode,
+                                                    remoteNode, "t");
+  reply->setClosestKNodes(std::move(closestKNodes));
+  return reply;
+}
+} // namespace
+
+void DHTAbstractNodeLookupTaskTest::setUp()
+{
+  unsigned char id[DHT_ID_LENGTH];
+  memset(id, 0xff, DHT_ID_LENGTH);
+  localNode_ = std::make_shared<DHTNode>(id);
+  routingTable_ = make_unique<DHTRoutingTable>(localNode_);
+  // The distance from targetID_ increases with the index.
+  nodes_.clear();
+  for (int i = 0; i < 8; ++i) {
+    nodes_.push_back(createNode((i + 1) << 4, i));
+    CPPUNIT_ASSERT(routingTable_->addNode(nodes_.back()));
+  }
+  memset(targetID_, 0, DHT_ID_LENGTH);
+}
+
+namespace {
+std::shared_ptr<DHTNodeLookupTask>
+createTask(const unsigned char* targetID,
+           const std::shared_ptr<DHTNode>& localNode,
+           DHTRoutingTable* routingTable, MockDHTMessageDispatcher* dispatcher,
+           DHTMessageFactory* factory, size_t concurrency)
+{
+  auto task = std::make_shared<DHTNodeLookupTask>(targetID);
+  task->setLocalNode(localNode);
+  task->setRoutingTable(routingTable);
+  task->setMessageDispatcher(dispatcher);
+  task->setMessageFactory(factory);
+  task->setConcurrency(concurrency);
+  return task;
+}
+} // namespace
+
+void DHTAbstractNodeLookupTaskTest::testStartup()
+{
+  MockDHTMessageDispatcher dispatcher;
+  RecordingDHTMessageFactory factory;
+  auto task = createTask(targetID_, localNode_, routingTable_.get(),
+                         &dispatcher, &factory, 3);
+  task->startup();
+  CPPUNIT_ASSERT(!task->finished());
+  CPPUNIT_ASSERT_EQUAL((size_t)3, dispatcher.messageQueue_.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)3, factory.queried.size());
+}
+
+void DHTAbstractNodeLookupTaskTest::testOnSlowResponse()
+{
+  MockDHTMessageDispatcher dispatcher;
+  RecordingDHTMessageFactory factory;
+  auto task = createTask(targetID_, localNode_, routingTable_.get(),
+                         &dispatcher, &factory, 3);
+  task->startup();
+  CPPUNIT_ASSERT_EQUAL((size_t)3, dispatcher.messageQueue_.size());
+
+  // A slow query does not count against the concurrency.
+  auto slowNode = factory.queried[0];
+  dispatcher.messageQueue_[0].callback_->onSlowResponse(slowNode);
+  CPPUNIT_ASSERT_EQUAL((size_t)4, dispatcher.messageQueue_.size());
+
+  // The reply from the slow node makes it count again, so that no
+  // query is sent.
+  dispatcher.messageQueue_[0].callback_->onReceived(
+      createReply(localNode_, slowNode).get());
+  CPPUNIT_ASSERT_EQUAL((size_t)4, dispatcher.messageQueue_.size());
+
+  // The timeout of the other query frees its slot.
+  dispatcher.messageQueue_[1].callback_->onTimeout(factory.queried[1]);
+  CPPUNIT_ASSERT_EQUAL((size_t)5, dispatcher.messageQueue_.size());
+  CPPUNIT_ASSERT(!task->finished());
+}
+
+void DHTAbstractNodeLookupTaskTest::testOnReceived_closestNodesReplied()
+{
+  MockDHTMessageDispatcher dispatcher;
+  RecordingDHTMessageFactory factory;
+  auto task = createTask(targetID_, localNode_, routingTable_.get(),
+                         &dispatcher, &factory, 8);
+  task->startup();
+  CPPUNIT_ASSERT_EQUAL((size_t)8, dispatcher.messageQueue_.size());
+
+  // nodes_[0] returns a node closer than all the others.  The farthest
+  // node, nodes_[7], falls out of the K closest nodes while its query
+  // is in flight.
+  auto closest = createNode(0x08, 8);
+  dispatcher.messageQueue_[0].callback_->onReceived(
+      createReply(localNode_, nodes_[0], {closest}).get());
+  CPPUNIT_ASSERT_EQUAL((size_t)9, dispatcher.messageQueue_.size());
+  CPPUNIT_ASSERT(*closest == *factory.queried.back());
+
+  for (int i = 1; i < 7; ++i) {
+    dispatcher.messageQueue_[i].callback_->onReceived(
+        createReply(localNode_, nodes_[i]).get());
+    CPPUNIT_ASSERT(!task->finished());
+  }
+  // All the K closest nodes have replied.  The lookup finishes without
+  // waiting for nodes_[7].
+  dispatcher.messageQueue_[8].callback_->onReceived(
+      createReply(localNode_, closest).get());
+  CPPUNIT_ASSERT(task->finished());
+  CPPUNIT_ASSERT_EQUAL((size_t)9, dispatcher.messageQueue_.size());
+
+  // The callback keeps the task alive for the late reply.
+  std::weak_ptr<DHTNodeLookupTask> weakTask = task;
+  task.reset();
+  CPPUNIT_ASSERT(!weakTask.expired());
+  dispatcher.messageQueue_[7].callback_->onReceived(
+      createReply(localNode_, nodes_[7]).get());
+  CPPUNIT_ASSERT_EQUAL((size_t)9, dispatcher.messageQueue_.size());
+  dispatcher.messageQueue_.clear();
+  CPPUNIT_ASSERT(weakTask.expired());
+}
+
+} // namespace aria2
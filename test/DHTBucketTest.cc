@@ -25,6 +25,7 @@ class DHTBucketTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testCacheNode);
   CPPUNIT_TEST(testDropNode);
   CPPUNIT_TEST(testGetNode);
+  CPPUNIT_TEST(testGetNode_full);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -43,6 +44,7 @@ public:
   void testCacheNode();
   void testDropNode();
   void testGetNode();
+  void testGetNode_full();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(DHTBucketTest);
@@ -364,6 +366,10 @@ void DHTBucketTest::testGetGoodNodes()
   CPPUNIT_ASSERT_EQUAL((uint16_t)6885, goodNodes[3]->getPort());
   CPPUNIT_ASSERT_EQUAL((uint16_t)6887, goodNodes[4]->getPort());
   CPPUNIT_ASSERT_EQUAL((uint16_t)6888, goodNodes[5]->getPort());
+  // The good nodes are appended.
+  bucket.getGoodNodes(goodNodes);
+  CPPUNIT_ASSERT_EQUAL((size_t)12, goodNodes.size());
+  CPPUNIT_ASSERT_EQUAL((uint16_t)6881, goodNodes[6]->getPort());
 }
 
 void DHTBucketTest::testCacheNode()
@@ -410,7 +416,7 @@ void DHTBucketTest::testDropNode()
   bucket.dropNode(nodes[3]);
   // nothing happens because the replacement cache is empty.
   {
-    std::deque<std::shared_ptr<DHTNode>> tnodes = bucket.getNodes();
+    std::vector<std::shared_ptr<DHTNode>> tnodes = bucket.getNodes();
     CPPUNIT_ASSERT_EQUAL((size_t)8, tnodes.size());
     CPPUNIT_ASSERT(*nodes[3] == *tnodes[3]);
   }
@@ -420,7 +426,7 @@ void DHTBucketTest::testDropNode()
 
   bucket.dropNode(nodes[3]);
   {
-    std::deque<std::shared_ptr<DHTNode>> tnodes = bucket.getNodes();
+    std::vector<std::shared_ptr<DHTNode>> tnodes = bucket.getNodes();
     CPPUNIT_ASSERT_EQUAL((size_t)8, tnodes.size());
     CPPUNIT_ASSERT(tnodes.end() == std::find_if(tnodes.begin(), tnodes.end(),
                                                 derefEqual(nodes[3])));
@@ -449,4 +455,34 @@ void DHTBucketTest::testGetNode()
   CPPUNIT_ASSERT(!bucket.getNode(localNodeID, "192.168.0.1", 6881));
 }
 
+void DHTBucketTest::testGetNode_full()
+{
+  unsigned char localNodeID[DHT_ID_LENGTH];
+  memset(localNodeID, 0, DHT_ID_LENGTH);
+  std::shared_ptr<DHTNode> localNode(new DHTNode(localNodeID));
+  DHTBucket bucket(localNode);
+
+  unsigned char id[DHT_ID_LENGTH];
+  std::shared_ptr<DHTNode> nodes[8];
+  for (size_t i = 0; i < DHTBucket::K; ++i) {
+    createID(id, 0xf0, i);
+    nodes[i].reset(new DHTNode(id));
+    nodes[i]->setIPAddress("192.168.0.1");
+    nodes[i]->setPort(6881 + i);
+    CPPUNIT_ASSERT(bucket.addNode(nodes[i]));
+  }
+  // The node is found by its ID even if the others share the address.
+  for (size_t i = 0; i < DHTBucket::K; ++i) {
+    CPPUNIT_ASSERT(nodes[i] ==
+                   bucket.getNode(nodes[i]->getID(), "192.168.0.1", 6881 + i));
+  }
+  CPPUNIT_ASSERT(!bucket.getNode(nodes[0]->getID(), "192.168.0.1", 6882));
+  // Only the last byte differs from nodes[0]'s ID.
+  createID(id, 0xf0, DHTBucket::K);
+  CPPUNIT_ASSERT(!bucket.getNode(id, "192.168.0.1", 6881));
+  id[0] = 0xf1;
+  id[DHT_ID_LENGTH - 1] = 0;
+  CPPUNIT_ASSERT(!bucket.getNode(id, "192.168.0.1", 6881));
+}
+
 } // namespace aria2
@@ -86,6 +86,9 @@ void DHTGetPeersReplyMessageTest::testGetBencodedMessage()
     }
     msg.setValues(peers);
     rDict->put("values", std::move(valuesList));
+    msg.setScrapeFilters(std::string(256, 's'), std::string(256, 'p'));
+    rDict->put("BFsd", std::string(256, 's'));
+    rDict->put("BFpe", std::string(256, 'p'));
     dict.put("r", std::move(rDict));
 
     std::string msgbody = msg.getBencodedMessage();
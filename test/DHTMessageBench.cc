@@ -0,0 +1,211 @@
+#include "Benchmark.h"
+
+#include <array>
+#include <memory>
+#include <random>
+
+#include "DHTMessageFactoryImpl.h"
+#include "DHTMessageReceiver.h"
+#include "DHTMessageTracker.h"
+#include "DHTMessageTrackerEntry.h"
+#include "DHTMessageDispatcher.h"
+#include "DHTMessageCallback.h"
+#include "DHTConnection.h"
+#include "DHTRoutingTable.h"
+#include "DHTPeerAnnounceStorage.h"
+#include "DHTTokenTracker.h"
+#include "DHTNode.h"
+#include "DHTPingMessage.h"
+#include "DHTFindNodeMessage.h"
+#include "DHTGetPeersMessage.h"
+#include "DHTConstants.h"
+#include "ValueBase.h"
+#include "bencode2.h"
+#include "fmt.h"
+#include "a2functional.h"
+#include "a2netcompat.h"
+
+namespace aria2 {
+
+namespace bench {
+
+namespace {
+// Counts the bytes of the messages sent instead of sending them.
+class CountingDHTConnection : public DHTConnection {
+public:
+  CountingDHTConnection(int64_t& bytes) : bytes_(bytes) {}
+
+  virtual ssize_t receiveMessage(unsigned char* data, size_t len,
+                                 std::string& host,
+                                 uint16_t& port) CXX11_OVERRIDE
+  {
+    return -1;
+  }
+
+  virtual ssize_t sendMessage(const unsigned char* data, size_t len,
+                              const std::string& host,
+                              uint16_t port) CXX11_OVERRIDE
+  {
+    bytes_ += len;
+    return len;
+  }
+
+private:
+  int64_t& bytes_;
+};
+} // namespace
+
+namespace {
+// Sends the replies at once, just like DHTMessageDispatcherImpl does
+// for the messages which expect no reply.
+class SendingDHTMessageDispatcher : public DHTMessageDispatcher {
+public:
+  virtual void addMessageToQueue(std::unique_ptr<DHTMessage> message,
+                                 std::chrono::seconds timeout,
+                                 std::unique_ptr<DHTMessageCallback> callback =
+                                     nullptr) CXX11_OVERRIDE
+  {
+    message->send();
+  }
+
+  virtual void addMessageToQueue(std::unique_ptr<DHTMessage> message,
+                                 std::unique_ptr<DHTMessageCallback> callback =
+                                     nullptr) CXX11_OVERRIDE
+  {
+    message->send();
+  }
+
+  virtual void sendMessages() CXX11_OVERRIDE {}
+
+  virtual size_t countMessageInQueue() const CXX11_OVERRIDE { return 0; }
+};
+} // namespace
+
+namespace {
+constexpr size_t NUM_REMOTE_NODES = 1000;
+constexpr size_t NUM_INFO_HASHES = 100;
+constexpr size_t PEERS_PER_INFO_HASH = 20;
+constexpr int NUM_ROUNDS = 10;
+} // namespace
+
+namespace {
+struct Query {
+  std::string ipaddr;
+  uint16_t port;
+  std::string data;
+};
+} // namespace
+
+namespace {
+// Receives the queries of 1000 remote nodes 10 * |scale| times, and
+// sends the replies, just like DHTInteractionCommand does.  Each node
+// sends a ping, a find_node and a get_peers query for one of 100 info
+// hashes, each of which has 20 peers.  The time and the allocations
+// spent in bencode2::decode() alone for the same messages are
+// reported as decode_usec and decode_allocations, which is the part a
+// specialized KRPC decoder would replace.
+void receiveQueries(Result& result, int scale)
+{
+  auto localNode = std::make_shared<DHTNode>();
+  localNode->generateID();
+  DHTRoutingTable routingTable(localNode);
+  DHTPeerAnnounceStorage peerAnnounceStorage;
+  DHTTokenTracker tokenTracker;
+  int64_t sentBytes = 0;
+  CountingDHTConnection connection(sentBytes);
+  SendingDHTMessageDispatcher dispatcher;
+  DHTMessageFactoryImpl factory(AF_INET);
+  factory.setLocalNode(localNode);
+  factory.setRoutingTable(&routingTable);
+  factory.setConnection(&connection);
+  factory.setMessageDispatcher(&dispatcher);
+  factory.setPeerAnnounceStorage(&peerAnnounceStorage);
+  factory.setTokenTracker(&tokenTracker);
+  DHTMessageReceiver receiver(std::make_shared<DHTMessageTracker>());
+  receiver.setMessageFactory(&factory);
+  receiver.setRoutingTable(&routingTable);
+
+  std::mt19937 gen(0);
+  auto randomID = [&gen](unsigned char* id) {
+    for (size_t i = 0; i < DHT_ID_LENGTH; ++i) {
+      id[i] = gen();
+    }
+  };
+  std::vector<std::array<unsigned char, DHT_ID_LENGTH>> infoHashes(
+      NUM_INFO_HASHES);
+  for (auto& infoHash : infoHashes) {
+    randomID(infoHash.data());
+    for (size_t i = 0; i < PEERS_PER_INFO_HASH; ++i) {
+      peerAnnounceStorage.addPeerAnnounce(
+          infoHash.data(), fmt("192.168.%u.%u", static_cast<unsigned>(i / 256),
+                               static_cast<unsigned>(i % 256)),
+          6881);
+    }
+  }
+  // The messages the remote nodes send to us.
+  DHTMessageFactoryImpl remoteFactory(AF_INET);
+  std::vector<Query> queries;
+  for (size_t i = 0; i < NUM_REMOTE_NODES; ++i) {
+    unsigned char id[DHT_ID_LENGTH];
+    randomID(id);
+    auto remoteNode = std::make_shared<DHTNode>(id);
+    remoteNode->setIPAddress(
+        fmt("10.0.%u.%u", static_cast<unsigned>(i / 256),
+            static_cast<unsigned>(i % 256)));
+    remoteNode->setPort(6881);
+    remoteFactory.setLocalNode(remoteNode);
+    unsigned char target[DHT_ID_LENGTH];
+    randomID(target);
+    for (auto data :
+         {remoteFactory.createPingMessage(localNode)->getBencodedMessage(),
+          remoteFactory.createFindNodeMessage(localNode, target)
+              ->getBencodedMessage(),
+          remoteFactory
+              .createGetPeersMessage(
+                  localNode, infoHashes[i % NUM_INFO_HASHES].data())
+              ->getBencodedMessage()}) {
+      queries.push_back({remoteNode->getIPAddress(), remoteNode->getPort(),
+                         std::move(data)});
+    }
+  }
+  std::vector<unsigned char> buf;
+  {
+    Measure measure(result);
+    for (int round = 0; round < NUM_ROUNDS * scale; ++round) {
+      for (auto& query : queries) {
+        // receiveMessage() takes a mutable buffer, just like the one
+        // DHTInteractionCommand reads into.
+        buf.assign(std::begin(query.data), std::end(query.data));
+        receiver.receiveMessage(query.ipaddr, query.port, buf.data(),
+                                buf.size());
+        result.bytes += query.data.size();
+        ++result.items;
+      }
+    }
+  }
+  auto decodeStart = std::chrono::steady_clock::now();
+  auto allocStart = getAllocationCount();
+  for (int round = 0; round < NUM_ROUNDS * scale; ++round) {
+    for (auto& query : queries) {
+      bencode2::decode(
+          reinterpret_cast<const unsigned char*>(query.data.data()),
+          query.data.size());
+    }
+  }
+  result.metrics.push_back(
+      {"decode_allocations", getAllocationCount() - allocStart});
+  result.metrics.push_back(
+      {"decode_usec", std::chrono::duration_cast<std::chrono::microseconds>(
+                          std::chrono::steady_clock::now() - decodeStart)
+                          .count()});
+  result.metrics.push_back({"sent_bytes", sentBytes});
+  result.metrics.push_back({"routing_table_buckets",
+                            static_cast<int64_t>(routingTable.getNumBucket())});
+}
+} // namespace
+
+A2_BENCH_REGISTER("dht-receive-queries", receiveQueries);
+
+} // namespace bench
+
+} // namespace aria2
@@ -10,6 +10,7 @@
 #include "DHTMessageTrackerEntry.h"
 #include "DHTRoutingTable.h"
 #include "MockDHTMessageFactory.h"
+#include "wallclock.h"
 
 namespace aria2 {
 
@@ -18,6 +19,7 @@ class DHTMessageTrackerTest : public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(DHTMessageTrackerTest);
   CPPUNIT_TEST(testMessageArrived);
   CPPUNIT_TEST(testHandleTimeout);
+  CPPUNIT_TEST(testSlowResponse);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -28,6 +30,21 @@ public:
   void testMessageArrived();
 
   void testHandleTimeout();
+
+  void testSlowResponse();
+
+  class SlowResponseCallback : public MockDHTMessageCallback {
+  public:
+    int* count_;
+
+    SlowResponseCallback(int* count) : count_(count) {}
+
+    virtual void
+    onSlowResponse(const std::shared_ptr<DHTNode>& remoteNode) CXX11_OVERRIDE
+    {
+      ++*count_;
+    }
+  };
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(DHTMessageTrackerTest);
@@ -97,4 +114,55 @@ void DHTMessageTrackerTest::testMessageArrived()
 
 void DHTMessageTrackerTest::testHandleTimeout() {}
 
+void DHTMessageTrackerTest::testSlowResponse()
+{
+  auto localNode = std::make_shared<DHTNode>();
+  auto routingTable = make_unique<DHTRoutingTable>(localNode);
+  auto factory = make_unique<MockDHTMessageFactory>();
+  factory->setLocalNode(localNode);
+
+  auto r1 = std::make_shared<DHTNode>();
+  r1->setIPAddress("192.168.0.1");
+  r1->setPort(6881);
+  auto r2 = std::make_shared<DHTNode>();
+  r2->setIPAddress("192.168.0.2");
+  r2->setPort(6882);
+
+  auto m1 = make_unique<MockDHTMessage>(localNode, r1);
+  auto m2 = make_unique<MockDHTMessage>(localNode, r2);
+
+  DHTMessageTracker tracker;
+  tracker.setRoutingTable(routingTable.get());
+  tracker.setMessageFactory(factory.get());
+
+  CPPUNIT_ASSERT(std::chrono::milliseconds(DHT_INITIAL_SLOW_RESPONSE_TIMEOUT) ==
+                 tracker.getSlowResponseTimeout());
+
+  int count = 0;
+  global::wallclock().reset();
+  tracker.addMessage(m1.get(), DHT_MESSAGE_TIMEOUT,
+                     make_unique<SlowResponseCallback>(&count));
+  tracker.addMessage(m2.get(), DHT_MESSAGE_TIMEOUT);
+  tracker.handleTimeout();
+  CPPUNIT_ASSERT_EQUAL(0, count);
+
+  global::wallclock().advance(3_s);
+  tracker.handleTimeout();
+  CPPUNIT_ASSERT_EQUAL(1, count);
+  // Notified only once
+  tracker.handleTimeout();
+  CPPUNIT_ASSERT_EQUAL(1, count);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, tracker.countEntry());
+
+  // RTT sample of 3 seconds
+  Dict resDict;
+  resDict.put("t", m2->getTransactionID());
+  auto p = tracker.messageArrived(&resDict, r2->getIPAddress(), r2->getPort());
+  CPPUNIT_ASSERT(p.first);
+  // srtt + 4 * rttvar = 3000 + 4 * 1500
+  CPPUNIT_ASSERT(std::chrono::milliseconds(9000) ==
+                 tracker.getSlowResponseTimeout());
+  global::wallclock().reset();
+}
+
 } // namespace aria2
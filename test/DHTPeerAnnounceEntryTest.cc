@@ -1,6 +1,7 @@
 #include "DHTPeerAnnounceEntry.h"
 
 #include <cstring>
+#include <cmath>
 
 #include <cppunit/extensions/HelperMacros.h>
 
@@ -8,6 +9,7 @@
 #include "util.h"
 #include "FileEntry.h"
 #include "Peer.h"
+#include "fmt.h"
 
 namespace aria2 {
 
@@ -18,6 +20,8 @@ class DHTPeerAnnounceEntryTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testEmpty);
   CPPUNIT_TEST(testAddPeerAddrEntry);
   CPPUNIT_TEST(testGetPeers);
+  CPPUNIT_TEST(testMaxPeerAddrEntry);
+  CPPUNIT_TEST(testScrapeFilter);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -25,6 +29,8 @@ public:
   void testEmpty();
   void testAddPeerAddrEntry();
   void testGetPeers();
+  void testMaxPeerAddrEntry();
+  void testScrapeFilter();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(DHTPeerAnnounceEntryTest);
@@ -110,4 +116,80 @@ void DHTPeerAnnounceEntryTest::testGetPeers()
   }
 }
 
+void DHTPeerAnnounceEntryTest::testMaxPeerAddrEntry()
+{
+  unsigned char infohash[DHT_ID_LENGTH];
+  memset(infohash, 0xff, DHT_ID_LENGTH);
+  DHTPeerAnnounceEntry entry(infohash, 2);
+  entry.addPeerAddrEntry(PeerAddrEntry("192.168.0.1", 6881));
+  entry.addPeerAddrEntry(PeerAddrEntry("192.168.0.2", 6882));
+  // Refreshing 192.168.0.1 makes 192.168.0.2 the oldest one.
+  entry.addPeerAddrEntry(PeerAddrEntry("192.168.0.1", 6881));
+  entry.addPeerAddrEntry(PeerAddrEntry("192.168.0.3", 6883));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, entry.countPeerAddrEntry());
+  const std::vector<PeerAddrEntry>& peerAddrEntries =
+      entry.getPeerAddrEntries();
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.1"),
+                       peerAddrEntries[0].getIPAddress());
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.3"),
+                       peerAddrEntries[1].getIPAddress());
+  CPPUNIT_ASSERT_EQUAL((uint16_t)6883, peerAddrEntries[1].getPort());
+}
+
+namespace {
+double estimateCount(const DHTPeerAnnounceEntry::BloomFilter& filter)
+{
+  size_t zeros = 0;
+  for (auto c : filter) {
+    for (int i = 0; i < 8; ++i) {
+      zeros += (c & (1 << i)) == 0;
+    }
+  }
+  const double m = filter.size() * 8;
+  return std::log(zeros / m) / (2 * std::log(1 - 1 / m));
+}
+} // namespace
+
+void DHTPeerAnnounceEntryTest::testScrapeFilter()
+{
+  unsigned char infohash[DHT_ID_LENGTH];
+  memset(infohash, 0xff, DHT_ID_LENGTH);
+  DHTPeerAnnounceEntry entry(infohash, 2000);
+  // BEP 33 test vector: 192.0.2.0-192.0.2.255 and
+  // 2001:db8::-2001:db8::3e7, which are estimated to be 1224.93.
+  for (int i = 0; i < 256; ++i) {
+    entry.addPeerAddrEntry(
+        PeerAddrEntry(fmt("192.0.2.%d", i), 6881, Timer(), true));
+  }
+  for (int i = 0; i < 1000; ++i) {
+    entry.addPeerAddrEntry(
+        PeerAddrEntry(fmt("2001:db8::%x", i), 6881, Timer(), true));
+  }
+  const std::string expected =
+      "f6c3f5eaa07ffd91bde89f777f26fb2bff37bdb8fb2bbaa2fd3ddde7bacfff75"
+      "ee7ccbaefe5eedb1fbfaff67f6abff5e43ddbca3fd9b9ffdf4ffd3e9dff12d1b"
+      "df59db53dbe9fa5b7ff3b8fdfcde1afb8bedd7be2f3ee71ebbbfe93bcdeefe14"
+      "8246c2bc5dbff7e7efdcf24fd8dc7adffd8fffdfddfff7a4bbeedf5cb95ce81f"
+      "c7fcff1ff4ffffdfe5f7fdcbb7fd79b3fa1fc77bfe07fff905b7b7ffc7fefeff"
+      "e0b8370bb0cd3f5b7f2bd93feb4386cfdd6f7fd5bfaf2e9ebffffeecd67adbf7"
+      "c67f17efd5d75eba6ffeba7fff47a91eb1bfbb53e8abfb5762abe8ff237279bf"
+      "efbfeef5ffc5febfdfe5adffadfee1fb737ffffbfd9f6aeffeee76b6fd8f72ef";
+  CPPUNIT_ASSERT_EQUAL(expected, util::toHex(entry.getSeedFilter().data(),
+                                             entry.getSeedFilter().size()));
+  CPPUNIT_ASSERT(std::abs(estimateCount(entry.getSeedFilter()) - 1224.93) <
+                 0.01);
+  CPPUNIT_ASSERT_EQUAL(0., estimateCount(entry.getPeerFilter()));
+
+  // Removing stale peers rebuilds the filters.
+  entry.addPeerAddrEntry(
+      PeerAddrEntry("192.168.0.1", 6881, Timer::zero(), false));
+  entry.removeStalePeerAddrEntry(10_s);
+  CPPUNIT_ASSERT_EQUAL(expected, util::toHex(entry.getSeedFilter().data(),
+                                             entry.getSeedFilter().size()));
+  CPPUNIT_ASSERT_EQUAL(0., estimateCount(entry.getPeerFilter()));
+
+  entry.addPeerAddrEntry(PeerAddrEntry("192.168.0.1", 6881));
+  CPPUNIT_ASSERT(estimateCount(entry.getPeerFilter()) > 0.9);
+}
+
 } // namespace aria2
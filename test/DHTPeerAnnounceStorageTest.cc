@@ -11,6 +11,7 @@
 #include "Peer.h"
 #include "FileEntry.h"
 #include "bittorrent_helper.h"
+#include "bitfield.h"
 
 namespace aria2 {
 
@@ -18,10 +19,12 @@ class DHTPeerAnnounceStorageTest : public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(DHTPeerAnnounceStorageTest);
   CPPUNIT_TEST(testAddAnnounce);
+  CPPUNIT_TEST(testGetScrapeFilters);
   CPPUNIT_TEST_SUITE_END();
 
 public:
   void testAddAnnounce();
+  void testGetScrapeFilters();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(DHTPeerAnnounceStorageTest);
@@ -47,4 +50,32 @@ void DHTPeerAnnounceStorageTest::testAddAnnounce()
   CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.4"), peers[1]->getIPAddress());
 }
 
+void DHTPeerAnnounceStorageTest::testGetScrapeFilters()
+{
+  unsigned char infohash1[DHT_ID_LENGTH];
+  memset(infohash1, 0xff, DHT_ID_LENGTH);
+  unsigned char infohash2[DHT_ID_LENGTH];
+  memset(infohash2, 0xf0, DHT_ID_LENGTH);
+
+  DHTPeerAnnounceStorage storage;
+  storage.addPeerAnnounce(infohash1, "192.168.0.1", 6881, true);
+  storage.addPeerAnnounce(infohash1, "192.168.0.2", 6882);
+  CPPUNIT_ASSERT(storage.contains(infohash1));
+  CPPUNIT_ASSERT(!storage.contains(infohash2));
+
+  unsigned char seedFilter[DHT_SCRAPE_BLOOM_FILTER_LENGTH];
+  unsigned char peerFilter[DHT_SCRAPE_BLOOM_FILTER_LENGTH];
+  CPPUNIT_ASSERT(!storage.getScrapeFilters(seedFilter, peerFilter, infohash2));
+  CPPUNIT_ASSERT(storage.getScrapeFilters(seedFilter, peerFilter, infohash1));
+  size_t seedBits = 0;
+  size_t peerBits = 0;
+  for (size_t i = 0; i < DHT_SCRAPE_BLOOM_FILTER_LENGTH; ++i) {
+    seedBits += bitfield::countBit32(seedFilter[i]);
+    peerBits += bitfield::countBit32(peerFilter[i]);
+  }
+  // Each address sets 1 or 2 bits.
+  CPPUNIT_ASSERT(1 <= seedBits && seedBits <= 2);
+  CPPUNIT_ASSERT(1 <= peerBits && peerBits <= 2);
+}
+
 } // namespace aria2
@@ -19,6 +19,7 @@ class DHTRoutingTableTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testAddNode);
   CPPUNIT_TEST(testAddNode_localNode);
   CPPUNIT_TEST(testGetClosestKNodes);
+  CPPUNIT_TEST(testGetNode);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -29,6 +30,7 @@ public:
   void testAddNode();
   void testAddNode_localNode();
   void testGetClosestKNodes();
+  void testGetNode();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(DHTRoutingTableTest);
@@ -111,4 +113,35 @@ void DHTRoutingTableTest::testGetClosestKNodes()
   }
 }
 
+void DHTRoutingTableTest::testGetNode()
+{
+  unsigned char id[DHT_ID_LENGTH];
+  createID(id, 0x81, 0);
+  auto localNode = std::make_shared<DHTNode>(id);
+
+  DHTRoutingTable table(localNode);
+
+  // The buckets are split, so that each node is in its own bucket.
+  std::vector<std::shared_ptr<DHTNode>> nodes;
+  for (auto first : {0xf0, 0x80, 0x70}) {
+    for (size_t i = 0; i < DHTBucket::K; ++i) {
+      createID(id, first, i);
+      auto node = std::make_shared<DHTNode>(id);
+      node->setIPAddress("192.168.0.1");
+      node->setPort(6881 + nodes.size());
+      CPPUNIT_ASSERT(table.addNode(node));
+      nodes.push_back(node);
+    }
+  }
+  CPPUNIT_ASSERT(table.getNumBucket() > 1);
+  for (auto& node : nodes) {
+    CPPUNIT_ASSERT(node == table.getNode(node->getID(), node->getIPAddress(),
+                                         node->getPort()));
+  }
+  CPPUNIT_ASSERT(!table.getNode(nodes[0]->getID(), "192.168.0.2",
+                                nodes[0]->getPort()));
+  createID(id, 0x80, 0x10);
+  CPPUNIT_ASSERT(!table.getNode(id, "192.168.0.1", 6881));
+}
+
 } // namespace aria2
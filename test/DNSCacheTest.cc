@@ -2,6 +2,9 @@
 
 #include <cppunit/extensions/HelperMacros.h>
 
+#include "wallclock.h"
+#include "Command.h"
+
 namespace aria2 {
 
 class DNSCacheTest : public CppUnit::TestFixture {
@@ -9,8 +12,18 @@ class DNSCacheTest : public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(DNSCacheTest);
   CPPUNIT_TEST(testFind);
   CPPUNIT_TEST(testMarkBad);
+  CPPUNIT_TEST(testMarkGood);
   CPPUNIT_TEST(testPutBadAddr);
   CPPUNIT_TEST(testRemove);
+  CPPUNIT_TEST(testLookup);
+  CPPUNIT_TEST(testLookup_stale);
+  CPPUNIT_TEST(testLookup_ttl);
+  CPPUNIT_TEST(testLookup_negative);
+  CPPUNIT_TEST(testPut_keepMarks);
+  CPPUNIT_TEST(testEvict);
+  CPPUNIT_TEST(testResolution);
+  CPPUNIT_TEST(testResolution_error);
+  CPPUNIT_TEST(testResolution_cancel);
   CPPUNIT_TEST_SUITE_END();
 
   DNSCache cache_;
@@ -18,6 +31,7 @@ class DNSCacheTest : public CppUnit::TestFixture {
 public:
   void setUp()
   {
+    global::wallclock().reset();
     cache_ = DNSCache();
     cache_.put("www", "192.168.0.1", 80);
     cache_.put("www", "::1", 80);
@@ -27,12 +41,30 @@ public:
 
   void testFind();
   void testMarkBad();
+  void testMarkGood();
   void testPutBadAddr();
   void testRemove();
+  void testLookup();
+  void testLookup_stale();
+  void testLookup_ttl();
+  void testLookup_negative();
+  void testPut_keepMarks();
+  void testEvict();
+  void testResolution();
+  void testResolution_error();
+  void testResolution_cancel();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(DNSCacheTest);
 
+namespace {
+class WaitingCommand : public Command {
+public:
+  WaitingCommand(cuid_t cuid) : Command(cuid) {}
+  virtual bool execute() CXX11_OVERRIDE { return true; }
+};
+} // namespace
+
 void DNSCacheTest::testFind()
 {
   CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.1"), cache_.find("www", 80));
@@ -48,6 +80,22 @@ void DNSCacheTest::testMarkBad()
   CPPUNIT_ASSERT_EQUAL(std::string("::1"), cache_.find("www", 80));
 }
 
+void DNSCacheTest::testMarkGood()
+{
+  cache_.put("www", "192.168.0.2", 80);
+  cache_.markGood("www", "192.168.0.2", 80);
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.2"), cache_.find("www", 80));
+  std::vector<std::string> addrs;
+  cache_.findAll(std::back_inserter(addrs), "www", 80);
+  CPPUNIT_ASSERT_EQUAL((size_t)3, addrs.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.1"), addrs[1]);
+  CPPUNIT_ASSERT_EQUAL(std::string("::1"), addrs[2]);
+
+  cache_.markBad("www", "::1", 80);
+  cache_.markGood("www", "::1", 80);
+  CPPUNIT_ASSERT_EQUAL(std::string("::1"), cache_.find("www", 80));
+}
+
 void DNSCacheTest::testPutBadAddr()
 {
   cache_.markBad("www", "192.168.0.1", 80);
@@ -61,4 +109,249 @@ void DNSCacheTest::testRemove()
   CPPUNIT_ASSERT_EQUAL(std::string(""), cache_.find("www", 80));
 }
 
+void DNSCacheTest::testLookup()
+{
+  std::vector<std::string> addrs;
+  std::string error;
+  CPPUNIT_ASSERT_EQUAL(DNSCache::DNS_CACHE_HIT,
+                       cache_.lookup(addrs, error, "www", 80));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, addrs.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.1"), addrs[0]);
+  CPPUNIT_ASSERT_EQUAL(std::string("::1"), addrs[1]);
+
+  addrs.clear();
+  CPPUNIT_ASSERT_EQUAL(DNSCache::DNS_CACHE_MISS,
+                       cache_.lookup(addrs, error, "www", 8080));
+  CPPUNIT_ASSERT(addrs.empty());
+
+  // No good address left
+  cache_.markBad("www", "192.168.0.1", 80);
+  cache_.markBad("www", "::1", 80);
+  CPPUNIT_ASSERT_EQUAL(DNSCache::DNS_CACHE_MISS,
+                       cache_.lookup(addrs, error, "www", 80));
+
+  // New resolution replaces the bad addresses.  192.168.0.1 is still
+  // bad.
+  cache_.put("www", {"192.168.0.3", "192.168.0.1"}, 80,
+             std::chrono::seconds(0));
+  CPPUNIT_ASSERT_EQUAL(DNSCache::DNS_CACHE_HIT,
+                       cache_.lookup(addrs, error, "www", 80));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, addrs.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.3"), addrs[0]);
+
+  CPPUNIT_ASSERT_EQUAL((uint64_t)2, cache_.getNumHits());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)2, cache_.getNumMisses());
+}
+
+void DNSCacheTest::testLookup_stale()
+{
+  std::vector<std::string> addrs;
+  std::string error;
+  global::wallclock().advance(std::chrono::seconds(299));
+  CPPUNIT_ASSERT_EQUAL(DNSCache::DNS_CACHE_HIT,
+                       cache_.lookup(addrs, error, "www", 80));
+
+  // Only the first lookup after expiry is asked to refresh.
+  global::wallclock().advance(std::chrono::seconds(1));
+  addrs.clear();
+  CPPUNIT_ASSERT_EQUAL(DNSCache::DNS_CACHE_STALE,
+                       cache_.lookup(addrs, error, "www", 80));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, addrs.size());
+  addrs.clear();
+  CPPUNIT_ASSERT_EQUAL(DNSCache::DNS_CACHE_HIT,
+                       cache_.lookup(addrs, error, "www", 80));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, addrs.size());
+
+  cache_.abortRefresh("www", 80);
+  CPPUNIT_ASSERT_EQUAL(DNSCache::DNS_CACHE_STALE,
+                       cache_.lookup(addrs, error, "www", 80));
+
+  cache_.put("www", {"192.168.0.1"}, 80, std::chrono::seconds(0));
+  CPPUNIT_ASSERT_EQUAL(DNSCache::DNS_CACHE_HIT,
+                       cache_.lookup(addrs, error, "www", 80));
+
+  // Not refreshed in time
+  global::wallclock().advance(std::chrono::seconds(359));
+  CPPUNIT_ASSERT_EQUAL(DNSCache::DNS_CACHE_STALE,
+                       cache_.lookup(addrs, error, "www", 80));
+  global::wallclock().advance(std::chrono::seconds(1));
+  CPPUNIT_ASSERT_EQUAL(DNSCache::DNS_CACHE_MISS,
+                       cache_.lookup(addrs, error, "www", 80));
+  CPPUNIT_ASSERT_EQUAL(std::string(""), cache_.find("www", 80));
+
+  CPPUNIT_ASSERT_EQUAL((uint64_t)4, cache_.getNumStaleHits());
+}
+
+void DNSCacheTest::testLookup_ttl()
+{
+  std::vector<std::string> addrs;
+  std::string error;
+  cache_.put("www", {"192.168.0.1"}, 80, std::chrono::seconds(30));
+  // The TTL of the cache caps the TTL of the response.
+  cache_.put("ftp", {"192.168.0.1"}, 21, std::chrono::seconds(3600));
+  global::wallclock().advance(std::chrono::seconds(30));
+  CPPUNIT_ASSERT_EQUAL(DNSCache::DNS_CACHE_STALE,
+                       cache_.lookup(addrs, error, "www", 80));
+  CPPUNIT_ASSERT_EQUAL(DNSCache::DNS_CACHE_HIT,
+                       cache_.lookup(addrs, error, "ftp", 21));
+  global::wallclock().advance(std::chrono::seconds(270));
+  CPPUNIT_ASSERT_EQUAL(DNSCache::DNS_CACHE_STALE,
+                       cache_.lookup(addrs, error, "ftp", 21));
+}
+
+void DNSCacheTest::testLookup_negative()
+{
+  std::vector<std::string> addrs;
+  std::string error;
+  cache_.putNegative("nxdomain", 80, "Domain name not found");
+  CPPUNIT_ASSERT_EQUAL(DNSCache::DNS_CACHE_NEGATIVE,
+                       cache_.lookup(addrs, error, "nxdomain", 80));
+  CPPUNIT_ASSERT(addrs.empty());
+  CPPUNIT_ASSERT_EQUAL(std::string("Domain name not found"), error);
+  CPPUNIT_ASSERT_EQUAL(std::string(""), cache_.find("nxdomain", 80));
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, cache_.getNumNegativeHits());
+
+  // Negative entries are not served stale.
+  global::wallclock().advance(std::chrono::seconds(10));
+  CPPUNIT_ASSERT_EQUAL(DNSCache::DNS_CACHE_MISS,
+                       cache_.lookup(addrs, error, "nxdomain", 80));
+
+  // Found later
+  cache_.putNegative("nxdomain", 80, "Domain name not found");
+  cache_.put("nxdomain", {"192.168.0.4"}, 80, std::chrono::seconds(0));
+  CPPUNIT_ASSERT_EQUAL(DNSCache::DNS_CACHE_HIT,
+                       cache_.lookup(addrs, error, "nxdomain", 80));
+
+  DNSCache cache;
+  cache.setNegativeTtl(std::chrono::seconds(0));
+  cache.putNegative("nxdomain", 80, "Domain name not found");
+  CPPUNIT_ASSERT_EQUAL(DNSCache::DNS_CACHE_MISS,
+                       cache.lookup(addrs, error, "nxdomain", 80));
+}
+
+void DNSCacheTest::testPut_keepMarks()
+{
+  std::vector<std::string> addrs;
+  std::string error;
+  cache_.put("www", {"192.168.0.1", "192.168.0.2", "192.168.0.3"}, 80,
+             std::chrono::seconds(0));
+  cache_.markBad("www", "192.168.0.1", 80);
+  cache_.markGood("www", "192.168.0.3", 80);
+  // ::1 is gone and 192.168.0.4 is new.
+  cache_.put("www", {"192.168.0.4", "192.168.0.2", "192.168.0.1",
+                     "192.168.0.3"},
+             80, std::chrono::seconds(0));
+  CPPUNIT_ASSERT_EQUAL(DNSCache::DNS_CACHE_HIT,
+                       cache_.lookup(addrs, error, "www", 80));
+  CPPUNIT_ASSERT_EQUAL((size_t)3, addrs.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.3"), addrs[0]);
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.2"), addrs[1]);
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.4"), addrs[2]);
+
+  // If all of them are bad, they are tried again.
+  cache_.markBad("www", "192.168.0.2", 80);
+  cache_.markBad("www", "192.168.0.3", 80);
+  cache_.markBad("www", "192.168.0.4", 80);
+  cache_.put("www", {"192.168.0.1", "192.168.0.2"}, 80,
+             std::chrono::seconds(0));
+  addrs.clear();
+  CPPUNIT_ASSERT_EQUAL(DNSCache::DNS_CACHE_HIT,
+                       cache_.lookup(addrs, error, "www", 80));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, addrs.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.1"), addrs[0]);
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.2"), addrs[1]);
+}
+
+void DNSCacheTest::testEvict()
+{
+  DNSCache cache(2);
+  std::vector<std::string> addrs;
+  std::string error;
+  cache.put("alpha", "192.168.0.1", 80);
+  global::wallclock().advance(std::chrono::seconds(1));
+  cache.put("bravo", "192.168.0.2", 80);
+  global::wallclock().advance(std::chrono::seconds(1));
+  CPPUNIT_ASSERT_EQUAL(DNSCache::DNS_CACHE_HIT,
+                       cache.lookup(addrs, error, "alpha", 80));
+  // bravo is the least recently used.
+  cache.put("charlie", "192.168.0.3", 80);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, cache.size());
+  CPPUNIT_ASSERT_EQUAL(std::string(""), cache.find("bravo", 80));
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.1"), cache.find("alpha", 80));
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.3"), cache.find("charlie", 80));
+
+  // Obsolete entries are evicted first.
+  cache.putNegative("delta", 80, "Domain name not found");
+  CPPUNIT_ASSERT_EQUAL(std::string(""), cache.find("alpha", 80));
+  global::wallclock().advance(std::chrono::seconds(10));
+  cache.put("echo", "192.168.0.5", 80);
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.3"), cache.find("charlie", 80));
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.5"), cache.find("echo", 80));
+  CPPUNIT_ASSERT_EQUAL((uint64_t)3, cache.getNumEvicted());
+}
+
+void DNSCacheTest::testResolution()
+{
+  WaitingCommand c1(1), c2(2), c3(3);
+  CPPUNIT_ASSERT(cache_.acquireResolution("alpha", 80, &c1));
+  // c1 is still resolving.
+  CPPUNIT_ASSERT(cache_.acquireResolution("alpha", 80, &c1));
+  CPPUNIT_ASSERT(!cache_.acquireResolution("alpha", 80, &c2));
+  CPPUNIT_ASSERT(!cache_.acquireResolution("alpha", 80, &c2));
+  // Another port is resolved separately.
+  CPPUNIT_ASSERT(cache_.acquireResolution("alpha", 443, &c3));
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, cache_.getNumJoined());
+
+  cache_.put("alpha", std::vector<std::string>{"192.168.0.1"}, 80,
+             std::chrono::seconds(0));
+  CPPUNIT_ASSERT(cache_.finishResolution("alpha", 80, ""));
+  CPPUNIT_ASSERT(c2.statusMatch(Command::STATUS_ACTIVE));
+  std::string error;
+  CPPUNIT_ASSERT(!cache_.takeResolutionError(&c2, error));
+  std::vector<std::string> addrs;
+  CPPUNIT_ASSERT_EQUAL(DNSCache::DNS_CACHE_HIT,
+                       cache_.lookup(addrs, error, "alpha", 80));
+  // No one waits for alpha:443.
+  CPPUNIT_ASSERT(!cache_.finishResolution("alpha", 443, ""));
+  CPPUNIT_ASSERT(cache_.acquireResolution("alpha", 80, &c2));
+}
+
+void DNSCacheTest::testResolution_error()
+{
+  WaitingCommand c1(1), c2(2), c3(3);
+  CPPUNIT_ASSERT(cache_.acquireResolution("alpha", 80, &c1));
+  CPPUNIT_ASSERT(!cache_.acquireResolution("alpha", 80, &c2));
+  CPPUNIT_ASSERT(!cache_.acquireResolution("alpha", 80, &c3));
+  // The error, such as a timeout, is not cached, but the waiting
+  // commands fail with it instead of resolving again one by one.
+  CPPUNIT_ASSERT(cache_.finishResolution("alpha", 80, "Timeout"));
+  CPPUNIT_ASSERT(c2.statusMatch(Command::STATUS_ACTIVE));
+  CPPUNIT_ASSERT(c3.statusMatch(Command::STATUS_ACTIVE));
+  std::string error;
+  CPPUNIT_ASSERT(cache_.takeResolutionError(&c2, error));
+  CPPUNIT_ASSERT_EQUAL(std::string("Timeout"), error);
+  CPPUNIT_ASSERT(!cache_.takeResolutionError(&c2, error));
+  // The error is discarded with the command.
+  CPPUNIT_ASSERT(!cache_.cancelResolution(&c3));
+  CPPUNIT_ASSERT(!cache_.takeResolutionError(&c3, error));
+}
+
+void DNSCacheTest::testResolution_cancel()
+{
+  WaitingCommand c1(1), c2(2), c3(3);
+  CPPUNIT_ASSERT(cache_.acquireResolution("alpha", 80, &c1));
+  CPPUNIT_ASSERT(!cache_.acquireResolution("alpha", 80, &c2));
+  CPPUNIT_ASSERT(!cache_.acquireResolution("alpha", 80, &c3));
+  // A waiting command leaves quietly.
+  CPPUNIT_ASSERT(!cache_.cancelResolution(&c3));
+  CPPUNIT_ASSERT(c3.statusMatch(Command::STATUS_INACTIVE));
+  // If the resolving command goes away, the waiting one takes over.
+  CPPUNIT_ASSERT(cache_.cancelResolution(&c1));
+  CPPUNIT_ASSERT(c2.statusMatch(Command::STATUS_ACTIVE));
+  std::string error;
+  CPPUNIT_ASSERT(!cache_.takeResolutionError(&c2, error));
+  CPPUNIT_ASSERT(cache_.acquireResolution("alpha", 80, &c2));
+  CPPUNIT_ASSERT(!cache_.acquireResolution("alpha", 80, &c3));
+}
+
 } // namespace aria2
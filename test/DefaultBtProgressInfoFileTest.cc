@@ -1,6 +1,8 @@
 #include "DefaultBtProgressInfoFile.h"
 
 #include <fstream>
+#include <map>
+#include <random>
 
 #include <cppunit/extensions/HelperMacros.h>
 
@@ -13,6 +15,14 @@
 #include "Piece.h"
 #include "FileEntry.h"
 #include "array_fun.h"
+#include "File.h"
+#include "fmt.h"
+#include "WrDiskCache.h"
+#include "DirectDiskAdaptor.h"
+#include "ByteArrayDiskWriter.h"
+#include "DefaultPieceStorage.h"
+#include "DefaultDiskWriter.h"
+#include "DiskWriterFactory.h"
 #ifdef ENABLE_BITTORRENT
 #  include "MockPeerStorage.h"
 #  include "BtRuntime.h"
@@ -37,6 +47,9 @@ class DefaultBtProgressInfoFileTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testLoad_nonBt_compat);
 #endif // !WORDS_BIGENDIAN
   CPPUNIT_TEST(testLoad_nonBt_pieceLengthShorter);
+  CPPUNIT_TEST(testSave_delta);
+  CPPUNIT_TEST(testCheckpoint);
+  CPPUNIT_TEST(testCheckpoint_resume);
   CPPUNIT_TEST(testUpdateFilename);
   CPPUNIT_TEST_SUITE_END();
 
@@ -99,6 +112,9 @@ public:
   void testLoad_nonBt_compat();
 #endif // !WORDS_BIGENDIAN
   void testLoad_nonBt_pieceLengthShorter();
+  void testSave_delta();
+  void testCheckpoint();
+  void testCheckpoint_resume();
   void testUpdateFilename();
 };
 
@@ -243,7 +259,7 @@ void DefaultBtProgressInfoFileTest::testSave()
 
   unsigned char version[2];
   in.read((char*)version, sizeof(version));
-  CPPUNIT_ASSERT_EQUAL(std::string("0001"),
+  CPPUNIT_ASSERT_EQUAL(std::string("0002"),
                        util::toHex(version, sizeof(version)));
 
   unsigned char extension[4];
@@ -475,7 +491,7 @@ void DefaultBtProgressInfoFileTest::testSave_nonBt()
 
   unsigned char version[2];
   in.read((char*)version, sizeof(version));
-  CPPUNIT_ASSERT_EQUAL(std::string("0001"),
+  CPPUNIT_ASSERT_EQUAL(std::string("0002"),
                        util::toHex(version, sizeof(version)));
 
   unsigned char extension[4];
@@ -551,6 +567,327 @@ void DefaultBtProgressInfoFileTest::testSave_nonBt()
   CPPUNIT_ASSERT_EQUAL((uint32_t)512, pieceLength2);
 }
 
+void DefaultBtProgressInfoFileTest::testSave_delta()
+{
+  initializeMembers(1_k, 80_k);
+
+  auto dctx = std::make_shared<DownloadContext>(1_k, 80_k,
+                                                A2_TEST_OUT_DIR "/save-delta");
+  File(A2_TEST_OUT_DIR "/save-delta.aria2").remove();
+
+  bitfield_->setBit(0);
+  auto p1 = std::make_shared<Piece>(1, 1_k);
+  pieceStorage_->addInFlightPiece({p1});
+
+  DefaultBtProgressInfoFile infoFile(dctx, pieceStorage_, option_.get());
+  CPPUNIT_ASSERT(infoFile.needsSave());
+  infoFile.save();
+  CPPUNIT_ASSERT(!infoFile.needsSave());
+  auto snapshotLength = File(infoFile.getFilename()).size();
+
+  bitfield_->setBit(2);
+  bitfield_->setBit(79);
+  p1->completeBlock(0);
+  CPPUNIT_ASSERT(infoFile.needsSave());
+  infoFile.save();
+  // The record has 8 bytes of header, 8 bytes of upload length, 2
+  // completed pieces and 1 in-flight piece.
+  CPPUNIT_ASSERT_EQUAL(snapshotLength + 8 + 8 + 4 + 2 * 4 + 4 + 13,
+                       File(infoFile.getFilename()).size());
+
+  {
+    BitfieldMan bitfield(1_k, 80_k);
+    auto pieceStorage = std::make_shared<MockPieceStorage>();
+    pieceStorage->setBitfield(&bitfield);
+    DefaultBtProgressInfoFile loadFile(dctx, pieceStorage, option_.get());
+    loadFile.load();
+    CPPUNIT_ASSERT_EQUAL(
+        std::string("a0000000000000000001"),
+        util::toHex(bitfield.getBitfield(), bitfield.getBitfieldLength()));
+    std::vector<std::shared_ptr<Piece>> inFlightPieces;
+    pieceStorage->getInFlightPieces(inFlightPieces);
+    CPPUNIT_ASSERT_EQUAL((size_t)1, inFlightPieces.size());
+    CPPUNIT_ASSERT_EQUAL((size_t)1, inFlightPieces[0]->getIndex());
+    CPPUNIT_ASSERT(inFlightPieces[0]->hasBlock(0));
+  }
+
+  // A lost piece cannot be a delta.
+  bitfield_->unsetBit(2);
+  infoFile.save();
+  CPPUNIT_ASSERT_EQUAL(snapshotLength, File(infoFile.getFilename()).size());
+
+  // A broken record at the end is ignored.
+  bitfield_->setBit(3);
+  infoFile.save();
+  {
+    std::ofstream out(infoFile.getFilename().c_str(),
+                      std::ios::binary | std::ios::app);
+    out << "broken record";
+  }
+  {
+    BitfieldMan bitfield(1_k, 80_k);
+    auto pieceStorage = std::make_shared<MockPieceStorage>();
+    pieceStorage->setBitfield(&bitfield);
+    DefaultBtProgressInfoFile loadFile(dctx, pieceStorage, option_.get());
+    loadFile.load();
+    CPPUNIT_ASSERT_EQUAL(
+        std::string("90000000000000000001"),
+        util::toHex(bitfield.getBitfield(), bitfield.getBitfieldLength()));
+  }
+}
+
+void DefaultBtProgressInfoFileTest::testCheckpoint()
+{
+  initializeMembers(1_k, 80_k);
+
+  auto dctx = std::make_shared<DownloadContext>(1_k, 80_k,
+                                                A2_TEST_OUT_DIR "/checkpoint");
+  File(A2_TEST_OUT_DIR "/checkpoint.aria2").remove();
+
+  auto adaptor = std::make_shared<DirectDiskAdaptor>();
+  adaptor->setDiskWriter(make_unique<ByteArrayDiskWriter>());
+  WrDiskCache dc(1_m);
+
+  bitfield_->setBit(0);
+  // 4 blocks of 256 bytes.  Block 1 is still in the write cache.
+  auto p1 = std::make_shared<Piece>(1, 1_k, 256);
+  p1->initWrCache(&dc, adaptor);
+  p1->completeBlock(0);
+  p1->completeBlock(1);
+  p1->updateWrCache(&dc, new unsigned char[256](), 0, 256, 1_k + 256);
+  pieceStorage_->addInFlightPiece({p1});
+
+  DefaultBtProgressInfoFile infoFile(dctx, pieceStorage_, option_.get());
+  infoFile.checkpoint();
+  bitfield_->setBit(2);
+  p1->completeBlock(2);
+  infoFile.saveCheckpoint();
+
+  auto load = [&](BitfieldMan& bitfield) {
+    auto pieceStorage = std::make_shared<MockPieceStorage>();
+    pieceStorage->setBitfield(&bitfield);
+    DefaultBtProgressInfoFile loadFile(dctx, pieceStorage, option_.get());
+    loadFile.load();
+    std::vector<std::shared_ptr<Piece>> inFlightPieces;
+    pieceStorage->getInFlightPieces(inFlightPieces);
+    CPPUNIT_ASSERT_EQUAL((size_t)1, inFlightPieces.size());
+    return inFlightPieces[0]->getBitfield()[0];
+  };
+  {
+    // Only the progress captured by checkpoint() without the cached
+    // block.
+    BitfieldMan bitfield(1_k, 80_k);
+    CPPUNIT_ASSERT_EQUAL((unsigned char)0x80u, load(bitfield));
+    CPPUNIT_ASSERT_EQUAL(
+        std::string("80000000000000000000"),
+        util::toHex(bitfield.getBitfield(), bitfield.getBitfieldLength()));
+  }
+
+  // save() supersedes the checkpoint captured before.
+  infoFile.checkpoint();
+  bitfield_->setBit(3);
+  infoFile.save();
+  infoFile.saveCheckpoint();
+  {
+    BitfieldMan bitfield(1_k, 80_k);
+    CPPUNIT_ASSERT_EQUAL((unsigned char)0xe0u, load(bitfield));
+    CPPUNIT_ASSERT_EQUAL(
+        std::string("b0000000000000000000"),
+        util::toHex(bitfield.getBitfield(), bitfield.getBitfieldLength()));
+  }
+  p1->clearWrCache(&dc);
+  p1->releaseWrCache(&dc);
+}
+
+namespace {
+unsigned char testData(int64_t offset)
+{
+  return offset % 251 + 1;
+}
+
+// Records the range written since the last startWriteback().
+class RecordingDiskWriter : public DefaultDiskWriter {
+public:
+  RecordingDiskWriter(const std::string& filename)
+      : DefaultDiskWriter(filename), begin_(0), end_(0)
+  {
+  }
+
+  virtual void writeData(const unsigned char* data, size_t len,
+                         int64_t offset) CXX11_OVERRIDE
+  {
+    DefaultDiskWriter::writeData(data, len, offset);
+    record(offset, offset + len);
+  }
+
+  virtual void writeDataVector(const a2iovec* iov, size_t iovcnt,
+                               int64_t offset) CXX11_OVERRIDE
+  {
+    DefaultDiskWriter::writeDataVector(iov, iovcnt, offset);
+    auto end = offset;
+    for (size_t i = 0; i < iovcnt; ++i) {
+      end += iov[i].A2IOVEC_LEN;
+    }
+    record(offset, end);
+  }
+
+  virtual void startWriteback() CXX11_OVERRIDE
+  {
+    DefaultDiskWriter::startWriteback();
+    // The data written must be in the writeback range.
+    auto range = getWritebackRange();
+    CPPUNIT_ASSERT(begin_ >= end_ ||
+                   (range.first <= begin_ && end_ <= range.second));
+    begin_ = end_ = 0;
+  }
+
+private:
+  void record(int64_t begin, int64_t end)
+  {
+    if (begin_ < end_) {
+      begin_ = std::min(begin_, begin);
+      end_ = std::max(end_, end);
+    }
+    else {
+      begin_ = begin;
+      end_ = end;
+    }
+  }
+
+  int64_t begin_;
+  int64_t end_;
+};
+
+class RecordingDiskWriterFactory : public DiskWriterFactory {
+public:
+  virtual std::unique_ptr<DiskWriter>
+  newDiskWriter(const std::string& filename) CXX11_OVERRIDE
+  {
+    auto dw = make_unique<RecordingDiskWriter>(filename);
+    diskWriter = dw.get();
+    return std::move(dw);
+  }
+
+  RecordingDiskWriter* diskWriter = nullptr;
+};
+} // namespace
+
+void DefaultBtProgressInfoFileTest::testCheckpoint_resume()
+{
+  // Downloads pieces in random order through the write cache, taking
+  // checkpoints on the way, and kills the download at a random point,
+  // discarding the write cache.  The resumed download must not have
+  // the data which were not written.
+  const int32_t pieceLength = 64_k;
+  const int64_t totalLength = 4_m;
+  const size_t numPieces = totalLength / pieceLength;
+  const std::string path = A2_TEST_OUT_DIR "/checkpoint-resume";
+  Option option;
+  int64_t resumedLength = 0;
+  std::mt19937 gen(0);
+  for (int round = 0; round < 20; ++round) {
+    File(path).remove();
+    File(path + ".aria2").remove();
+    auto dctx = std::make_shared<DownloadContext>(pieceLength, totalLength,
+                                                  path);
+    WrDiskCache dc(256_k);
+    auto ps = std::make_shared<DefaultPieceStorage>(dctx, &option);
+    ps->setWrDiskCache(&dc);
+    auto dwFactory = std::make_shared<RecordingDiskWriterFactory>();
+    ps->setDiskWriterFactory(dwFactory);
+    ps->initStorage();
+    ps->getDiskAdaptor()->initAndOpenFile();
+    CPPUNIT_ASSERT(dwFactory->diskWriter);
+    DefaultBtProgressInfoFile infoFile(dctx, ps, &option);
+    std::map<size_t, std::shared_ptr<Piece>> inFlightPieces;
+    auto numSteps = 100 + gen() % 400;
+    for (size_t step = 0; step < numSteps; ++step) {
+      if (gen() % 20 == 0) {
+        CPPUNIT_ASSERT(ps->getDiskAdaptor()->waitWriteback(1));
+        auto range = dwFactory->diskWriter->getWritebackRange();
+        CPPUNIT_ASSERT(range.first >= range.second);
+        infoFile.saveCheckpoint();
+        if (infoFile.needsSave()) {
+          infoFile.checkpoint();
+          ps->getDiskAdaptor()->startWriteback();
+        }
+        continue;
+      }
+      size_t index = gen() % numPieces;
+      if (ps->hasPiece(index)) {
+        continue;
+      }
+      auto& piece = inFlightPieces[index];
+      if (!piece) {
+        piece = ps->getMissingPiece(index, 1);
+      }
+      size_t block = 0;
+      while (piece->hasBlock(block)) {
+        ++block;
+      }
+      auto goff = static_cast<int64_t>(index) * pieceLength +
+                  block * piece->getBlockLength();
+      size_t len = piece->getBlockLength(block);
+      auto data = new unsigned char[len];
+      for (size_t i = 0; i < len; ++i) {
+        data[i] = testData(goff + i);
+      }
+      piece->updateWrCache(&dc, data, 0, len, goff);
+      piece->completeBlock(block);
+      if (piece->pieceComplete()) {
+        piece->flushWrCache(&dc);
+        ps->completePiece(piece);
+        inFlightPieces.erase(index);
+      }
+    }
+    // Killed.  The data in the write cache are lost.
+    for (auto& e : inFlightPieces) {
+      e.second->clearWrCache(&dc);
+      e.second->releaseWrCache(&dc);
+    }
+    ps->getDiskAdaptor()->closeFile();
+
+    auto resumed = std::make_shared<DefaultPieceStorage>(dctx, &option);
+    DefaultBtProgressInfoFile loadFile(dctx, resumed, &option);
+    if (!loadFile.exists()) {
+      continue;
+    }
+    loadFile.load();
+    std::string content;
+    {
+      std::ifstream in(path.c_str(), std::ios::binary);
+      content.assign(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+    }
+    auto check = [&](int64_t offset, int64_t len) {
+      for (int64_t i = offset; i < offset + len; ++i) {
+        if (i >= static_cast<int64_t>(content.size()) ||
+            static_cast<unsigned char>(content[i]) != testData(i)) {
+          CPPUNIT_FAIL(fmt("round=%d offset=%" PRId64, round, i));
+        }
+      }
+      resumedLength += len;
+    };
+    for (size_t i = 0; i < numPieces; ++i) {
+      if (resumed->hasPiece(i)) {
+        check(static_cast<int64_t>(i) * pieceLength, pieceLength);
+      }
+    }
+    std::vector<std::shared_ptr<Piece>> pieces;
+    resumed->getInFlightPieces(pieces);
+    for (auto& piece : pieces) {
+      for (size_t i = 0; i < piece->countBlock(); ++i) {
+        if (piece->hasBlock(i)) {
+          check(static_cast<int64_t>(piece->getIndex()) * pieceLength +
+                    i * piece->getBlockLength(),
+                piece->getBlockLength(i));
+        }
+      }
+    }
+  }
+  CPPUNIT_ASSERT(resumedLength > 0);
+}
+
 void DefaultBtProgressInfoFileTest::testUpdateFilename()
 {
   std::shared_ptr<DownloadContext> dctx(
@@ -2,6 +2,9 @@
 #include <cppunit/extensions/HelperMacros.h>
 
 #include "a2functional.h"
+#include "File.h"
+#include "TestUtil.h"
+#include "DlAbortEx.h"
 
 namespace aria2 {
 
@@ -9,6 +12,10 @@ class DefaultDiskWriterTest : public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(DefaultDiskWriterTest);
   CPPUNIT_TEST(testSize);
+  CPPUNIT_TEST(testWriteDataVector);
+  CPPUNIT_TEST(testWriteData_directIO);
+  CPPUNIT_TEST(testSeekData);
+  CPPUNIT_TEST(testWaitWriteback);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -16,6 +23,10 @@ public:
   void setUp() {}
 
   void testSize();
+  void testWriteDataVector();
+  void testWriteData_directIO();
+  void testSeekData();
+  void testWaitWriteback();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(DefaultDiskWriterTest);
@@ -28,4 +39,123 @@ void DefaultDiskWriterTest::testSize()
   CPPUNIT_ASSERT_EQUAL((int64_t)4_k, dw.size());
 }
 
+void DefaultDiskWriterTest::testWriteDataVector()
+{
+  std::string filename =
+      A2_TEST_OUT_DIR "/aria2_DefaultDiskWriterTest_testWriteDataVector";
+  File(filename).remove();
+  // More buffers than A2_IOV_MAX, each of them having different
+  // length including 0.
+  std::vector<std::string> data;
+  std::vector<a2iovec> iov;
+  std::string expected;
+  for (size_t i = 0; i < A2_IOV_MAX * 2 + 1; ++i) {
+    data.push_back(std::string(i % 7, 'a' + i % 26));
+  }
+  for (auto& d : data) {
+    a2iovec v;
+    v.A2IOVEC_BASE = &d[0];
+    v.A2IOVEC_LEN = d.size();
+    iov.push_back(v);
+    expected += d;
+  }
+  DefaultDiskWriter dw(filename);
+  dw.initAndOpenFile();
+  dw.writeDataVector(iov.data(), iov.size(), 3);
+  dw.closeFile();
+  CPPUNIT_ASSERT_EQUAL(std::string(3, '\0') + expected, readFile(filename));
+}
+
+void DefaultDiskWriterTest::testWriteData_directIO()
+{
+  std::string filename =
+      A2_TEST_OUT_DIR "/aria2_DefaultDiskWriterTest_testWriteData_directIO";
+  File(filename).remove();
+  std::string data1(10_k, '1'), data2(3_k, '2'), data3(100, '3'),
+      data4(1_m + 1, '4');
+  a2iovec iov[2];
+  iov[0].A2IOVEC_BASE = &data1[0];
+  iov[0].A2IOVEC_LEN = data1.size();
+  iov[1].A2IOVEC_BASE = &data2[0];
+  iov[1].A2IOVEC_LEN = data2.size();
+  DefaultDiskWriter dw(filename);
+  dw.initAndOpenFile();
+  dw.enableDirectIO();
+  // Unaligned head and tail, and the aligned part spanning the
+  // buffers.
+  dw.writeDataVector(iov, 2, 100);
+  // No aligned block
+  dw.writeData(reinterpret_cast<const unsigned char*>(data3.data()),
+               data3.size(), 0);
+  // Aligned head, and the aligned part longer than the staging
+  // buffer.
+  dw.writeData(reinterpret_cast<const unsigned char*>(data4.data()),
+               data4.size(), 16_k);
+  dw.closeFile();
+  std::string expected =
+      data3 + data1 + data2 + std::string(16_k - 100 - 13_k, '\0') + data4;
+  CPPUNIT_ASSERT_EQUAL((int64_t)expected.size(), File(filename).size());
+  CPPUNIT_ASSERT(expected == readFile(filename));
+}
+
+void DefaultDiskWriterTest::testSeekData()
+{
+  std::string filename =
+      A2_TEST_OUT_DIR "/aria2_DefaultDiskWriterTest_testSeekData";
+  File(filename).remove();
+  DefaultDiskWriter dw(filename);
+  dw.initAndOpenFile();
+  dw.truncate(1_m);
+  std::string data(64_k, 'a');
+  dw.writeData(reinterpret_cast<const unsigned char*>(data.data()),
+               data.size(), 512_k);
+  // If the file system does not support holes, the whole file is
+  // data.
+  auto r = dw.seekData(0);
+  CPPUNIT_ASSERT(r == 0 || r == 512_k);
+  CPPUNIT_ASSERT_EQUAL((int64_t)512_k, dw.seekData(512_k));
+  r = dw.seekData(576_k);
+  CPPUNIT_ASSERT(r == 576_k || r == 1_m);
+  // The end of file is not a hole.
+  CPPUNIT_ASSERT_EQUAL((int64_t)2_m, dw.seekData(2_m));
+  dw.closeFile();
+}
+
+void DefaultDiskWriterTest::testWaitWriteback()
+{
+  std::string filename =
+      A2_TEST_OUT_DIR "/aria2_DefaultDiskWriterTest_testWaitWriteback";
+  File(filename).remove();
+  DefaultDiskWriter dw(filename);
+  dw.initAndOpenFile();
+  dw.writeData(reinterpret_cast<const unsigned char*>("hello"), 5, 4_k);
+  dw.startWriteback();
+  CPPUNIT_ASSERT(std::make_pair((int64_t)4_k, (int64_t)4_k + 5) ==
+                 dw.getWritebackRange());
+  dw.writeData(reinterpret_cast<const unsigned char*>("world"), 5, 0);
+  CPPUNIT_ASSERT(dw.waitWriteback());
+  CPPUNIT_ASSERT(std::make_pair((int64_t)0, (int64_t)0) ==
+                 dw.getWritebackRange());
+  CPPUNIT_ASSERT(!dw.waitWriteback());
+  // closeFile() synchronizes the data written since then, so that the
+  // file is not opened again to wait for them.
+  dw.startWriteback();
+  dw.closeFile();
+  CPPUNIT_ASSERT(std::make_pair((int64_t)0, (int64_t)0) ==
+                 dw.getWritebackRange());
+  File(filename).renameTo(filename + ".moved");
+  CPPUNIT_ASSERT(!dw.waitWriteback());
+  CPPUNIT_ASSERT_EQUAL(std::string("world") + std::string(4_k - 5, '\0') +
+                           "hello",
+                       readFile(filename + ".moved"));
+  // Nothing is left to wait for after flushOSBuffers().
+  dw.initAndOpenFile();
+  dw.writeData(reinterpret_cast<const unsigned char*>("!"), 1, 0);
+  dw.startWriteback();
+  dw.flushOSBuffers();
+  dw.closeFile();
+  File(filename).remove();
+  CPPUNIT_ASSERT(!dw.waitWriteback());
+}
+
 } // namespace aria2
@@ -0,0 +1,273 @@
+#include "Benchmark.h"
+
+#include <cstring>
+#include <memory>
+#include <random>
+#ifdef __linux__
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#endif // __linux__
+
+#include "DirectDiskAdaptor.h"
+#include "MultiDiskAdaptor.h"
+#include "DefaultDiskWriter.h"
+#include "WrDiskCacheEntry.h"
+#include "OpenedFileCounter.h"
+#include "FileEntry.h"
+#include "File.h"
+#include "fmt.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+namespace bench {
+
+namespace {
+// Counts the write calls which reach the file.  Each call is one
+// write system call, or one per 16KiB buffer if writeDataVector() is
+// not implemented.
+class CountingDiskWriter : public DefaultDiskWriter {
+public:
+  CountingDiskWriter(const std::string& filename, int64_t& count)
+      : DefaultDiskWriter(filename), count_(count)
+  {
+  }
+
+  virtual void writeData(const unsigned char* data, size_t len,
+                         int64_t offset) CXX11_OVERRIDE
+  {
+    ++count_;
+    DefaultDiskWriter::writeData(data, len, offset);
+  }
+
+  virtual void writeDataVector(const a2iovec* iov, size_t iovcnt,
+                               int64_t offset) CXX11_OVERRIDE
+  {
+    ++count_;
+    DefaultDiskWriter::writeDataVector(iov, iovcnt, offset);
+  }
+
+private:
+  int64_t& count_;
+};
+} // namespace
+
+namespace {
+constexpr int64_t PIECE_LENGTH = 1_m;
+// The size of the socket read buffer, which is the usual size of a
+// data cell of the write cache.
+constexpr size_t CELL_LENGTH = 16_k;
+} // namespace
+
+namespace {
+// Fills |entry| with a piece at |goff| in 16KiB data cells, just like
+// a piece downloaded from one connection.
+void cachePiece(WrDiskCacheEntry& entry, int64_t goff)
+{
+  for (int64_t off = 0; off < PIECE_LENGTH; off += CELL_LENGTH) {
+    auto cell = new WrDiskCacheEntry::DataCell();
+    cell->goff = goff + off;
+    cell->data = new unsigned char[CELL_LENGTH];
+    memset(cell->data, 'a' + off / CELL_LENGTH % 26, CELL_LENGTH);
+    cell->offset = 0;
+    cell->len = cell->capacity = CELL_LENGTH;
+    entry.cacheData(cell);
+  }
+}
+} // namespace
+
+namespace {
+enum FlushMode {
+  FLUSH_BUFFERED,
+  // Buffered, and the data is synced to the disk at the end.
+  FLUSH_BUFFERED_SYNC,
+  // Direct I/O, and the data is synced to the disk at the end.
+  FLUSH_DIRECT_SYNC
+};
+} // namespace
+
+namespace {
+// Flushes the write cache of all |totalLength| / 1MiB pieces of
+// |adaptor| in piece order.  Only the flushes and the final sync are
+// measured.
+void flushPieces(Result& result, const std::shared_ptr<DiskAdaptor>& adaptor,
+                 int64_t totalLength, FlushMode mode)
+{
+  adaptor->initAndOpenFile();
+  if (mode == FLUSH_DIRECT_SYNC) {
+    adaptor->enableDirectIO();
+  }
+  WrDiskCacheEntry entry{adaptor};
+  for (int64_t goff = 0; goff < totalLength; goff += PIECE_LENGTH) {
+    cachePiece(entry, goff);
+    {
+      Measure measure(result);
+      adaptor->writeCache(&entry);
+    }
+    entry.clear();
+    result.bytes += PIECE_LENGTH;
+    ++result.items;
+  }
+  if (mode != FLUSH_BUFFERED) {
+    Measure measure(result);
+    adaptor->flushOSBuffers();
+  }
+  adaptor->closeFile();
+}
+} // namespace
+
+#ifdef __linux__
+namespace {
+// Returns the number of bytes of the file |path| which are in the
+// page cache, or -1 on error.
+int64_t getPageCacheBytes(const std::string& path)
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return -1;
+  }
+  struct stat st;
+  int64_t res = -1;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    auto addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr != MAP_FAILED) {
+      auto pageSize = sysconf(_SC_PAGESIZE);
+      std::vector<unsigned char> vec((st.st_size + pageSize - 1) / pageSize);
+      if (mincore(addr, st.st_size, vec.data()) == 0) {
+        res = 0;
+        for (auto c : vec) {
+          if (c & 1) {
+            res += pageSize;
+          }
+        }
+      }
+      munmap(addr, st.st_size);
+    }
+  }
+  close(fd);
+  return res;
+}
+} // namespace
+#endif // __linux__
+
+namespace {
+// Flushes 64MiB * |scale| of cached pieces into a single file.
+void flushSingleFile(Result& result, int scale, FlushMode mode)
+{
+  const int64_t totalLength = 64_m * scale;
+  auto path = prepareOutDir(result.name) + "/file";
+  // Start with no page of the file in the page cache.
+  File(path).remove();
+  int64_t writes = 0;
+  auto adaptor = std::make_shared<DirectDiskAdaptor>();
+  adaptor->setDiskWriter(make_unique<CountingDiskWriter>(path, writes));
+  adaptor->setTotalLength(totalLength);
+  auto fileEntries =
+      std::vector<std::shared_ptr<FileEntry>>{std::make_shared<FileEntry>(
+          path, totalLength, 0)};
+  adaptor->setFileEntries(std::begin(fileEntries), std::end(fileEntries));
+  flushPieces(result, adaptor, totalLength, mode);
+  result.metrics.push_back({"disk_writes", writes});
+#ifdef __linux__
+  result.metrics.push_back({"page_cache_bytes", getPageCacheBytes(path)});
+#endif // __linux__
+}
+} // namespace
+
+namespace {
+void flushSingleFileBuffered(Result& result, int scale)
+{
+  flushSingleFile(result, scale, FLUSH_BUFFERED);
+}
+} // namespace
+
+A2_BENCH_REGISTER("wrdiskcache-flush", flushSingleFileBuffered);
+
+namespace {
+void flushSingleFileBufferedSync(Result& result, int scale)
+{
+  flushSingleFile(result, scale, FLUSH_BUFFERED_SYNC);
+}
+} // namespace
+
+A2_BENCH_REGISTER("wrdiskcache-flush-sync", flushSingleFileBufferedSync);
+
+namespace {
+void flushSingleFileDirectSync(Result& result, int scale)
+{
+  flushSingleFile(result, scale, FLUSH_DIRECT_SYNC);
+}
+} // namespace
+
+A2_BENCH_REGISTER("wrdiskcache-flush-direct", flushSingleFileDirectSync);
+
+namespace {
+// Flushes 64MiB * |scale| of cached pieces into files of 100KiB, so
+// that most pieces span 11 files and have to be split at the file
+// boundaries.
+void flushMultiFile(Result& result, int scale)
+{
+  const int64_t fileLength = 100_k;
+  const int64_t totalLength = 64_m * scale;
+  auto dir = prepareOutDir(result.name);
+  std::vector<std::shared_ptr<FileEntry>> fileEntries;
+  for (int64_t off = 0; off < totalLength; off += fileLength) {
+    fileEntries.push_back(std::make_shared<FileEntry>(
+        fmt("%s/file%" PRId64, dir.c_str(), off / fileLength),
+        std::min(fileLength, totalLength - off), off));
+  }
+  auto adaptor = std::make_shared<MultiDiskAdaptor>();
+  adaptor->setPieceLength(PIECE_LENGTH);
+  adaptor->setFileEntries(std::begin(fileEntries), std::end(fileEntries));
+  flushPieces(result, adaptor, totalLength, FLUSH_BUFFERED);
+  result.metrics.push_back({"files", static_cast<int64_t>(fileEntries.size())});
+}
+} // namespace
+
+A2_BENCH_REGISTER("wrdiskcache-flush-multi", flushMultiFile);
+
+namespace {
+// Opens a download of 20000 * |scale| files of 4KiB, and writes 20000
+// blocks of 16KiB at random offsets, 4 or 5 files each, with at most
+// 100 files open at a time, which is the default of
+// --bt-max-open-files.
+void writeManyFiles(Result& result, int scale)
+{
+  const int64_t numFiles = 20000 * scale;
+  const int64_t fileLength = 4_k;
+  const int64_t totalLength = numFiles * fileLength;
+  auto dir = prepareOutDir(result.name);
+  std::vector<std::shared_ptr<FileEntry>> fileEntries;
+  for (int64_t i = 0; i < numFiles; ++i) {
+    fileEntries.push_back(std::make_shared<FileEntry>(
+        fmt("%s/dir%" PRId64 "/file%" PRId64, dir.c_str(), i / 1000, i),
+        fileLength, i * fileLength));
+  }
+  auto adaptor = std::make_shared<MultiDiskAdaptor>();
+  adaptor->setPieceLength(PIECE_LENGTH);
+  adaptor->setFileEntries(std::begin(fileEntries), std::end(fileEntries));
+  adaptor->setOpenedFileCounter(std::make_shared<OpenedFileCounter>(100));
+  std::vector<unsigned char> buf(CELL_LENGTH, 'a');
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int64_t> dist(
+      0, (totalLength - CELL_LENGTH) / CELL_LENGTH);
+  {
+    Measure measure(result);
+    adaptor->openFile();
+    for (int i = 0; i < 20000; ++i) {
+      adaptor->writeData(buf.data(), buf.size(), dist(gen) * CELL_LENGTH);
+      result.bytes += buf.size();
+      ++result.items;
+    }
+    adaptor->closeFile();
+  }
+  result.metrics.push_back({"files", numFiles});
+}
+} // namespace
+
+A2_BENCH_REGISTER("multidisk-write-many-files", writeManyFiles);
+
+} // namespace bench
+
+} // namespace aria2
@@ -54,10 +54,22 @@ void DownloadContextTest::testFindFileEntryByOffset()
 void DownloadContextTest::testGetPieceHash()
 {
   DownloadContext ctx;
-  const std::string pieceHashes[] = {"hash1", "hash2", "shash3"};
+  const std::string pieceHashes[] = {"hash1", "hash2", "hash3"};
   ctx.setPieceHashes("sha-1", &pieceHashes[0], &pieceHashes[3]);
-  CPPUNIT_ASSERT_EQUAL(std::string("hash1"), ctx.getPieceHash(0));
-  CPPUNIT_ASSERT_EQUAL(std::string(""), ctx.getPieceHash(3));
+  CPPUNIT_ASSERT_EQUAL((size_t)3, ctx.countPieceHash());
+  CPPUNIT_ASSERT_EQUAL(std::string("hash1"), ctx.getPieceHash(0).str());
+  CPPUNIT_ASSERT_EQUAL(std::string("hash3"), ctx.getPieceHash(2).str());
+  CPPUNIT_ASSERT_EQUAL(std::string(""), ctx.getPieceHash(3).str());
+
+  ctx.setPieceHashes("sha-1", "hash1hash2", 5);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, ctx.countPieceHash());
+  CPPUNIT_ASSERT(ctx.getPieceHash(1) == "hash2");
+
+  // The hashes must have the same length.
+  const std::string badHashes[] = {"hash1", "hash22"};
+  ctx.setPieceHashes("sha-1", &badHashes[0], &badHashes[2]);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, ctx.countPieceHash());
+  CPPUNIT_ASSERT(ctx.getPieceHash(0).empty());
 }
 
 void DownloadContextTest::testGetNumPieces()
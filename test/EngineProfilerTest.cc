@@ -0,0 +1,111 @@
+#include "EngineProfiler.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "Command.h"
+
+namespace aria2 {
+
+class EngineProfilerTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(EngineProfilerTest);
+  CPPUNIT_TEST(testHistogram);
+  CPPUNIT_TEST(testHistogram_empty);
+  CPPUNIT_TEST(testGetCommandStats);
+  CPPUNIT_TEST(testReset);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testHistogram();
+  void testHistogram_empty();
+  void testGetCommandStats();
+  void testReset();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(EngineProfilerTest);
+
+namespace {
+class FastCommand : public Command {
+public:
+  FastCommand() : Command(1) {}
+  virtual bool execute() CXX11_OVERRIDE { return true; }
+};
+
+class SlowCommand : public Command {
+public:
+  SlowCommand() : Command(2) {}
+  virtual bool execute() CXX11_OVERRIDE { return true; }
+};
+} // namespace
+
+void EngineProfilerTest::testHistogram()
+{
+  Histogram h;
+  for (int i = 0; i < 98; ++i) {
+    h.add(10);
+  }
+  h.add(1000);
+  h.add(5000);
+
+  CPPUNIT_ASSERT_EQUAL((uint64_t)100, h.getCount());
+  CPPUNIT_ASSERT_EQUAL((int64_t)(98 * 10 + 1000 + 5000), h.getSum());
+  CPPUNIT_ASSERT_EQUAL((int64_t)5000, h.getMax());
+  // 10 falls in [8, 16)
+  CPPUNIT_ASSERT_EQUAL((int64_t)15, h.getPercentile(50));
+  CPPUNIT_ASSERT_EQUAL((int64_t)15, h.getPercentile(98));
+  // 1000 falls in [512, 1024)
+  CPPUNIT_ASSERT_EQUAL((int64_t)1023, h.getPercentile(99));
+  // Capped by the maximum
+  CPPUNIT_ASSERT_EQUAL((int64_t)5000, h.getPercentile(100));
+
+  h.add(0);
+  h.add(-1);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)102, h.getCount());
+  CPPUNIT_ASSERT_EQUAL((int64_t)0, h.getPercentile(1));
+}
+
+void EngineProfilerTest::testHistogram_empty()
+{
+  Histogram h;
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0, h.getCount());
+  CPPUNIT_ASSERT_EQUAL((int64_t)0, h.getPercentile(50));
+  CPPUNIT_ASSERT_EQUAL((int64_t)0, h.getMax());
+}
+
+void EngineProfilerTest::testGetCommandStats()
+{
+  EngineProfiler profiler;
+  FastCommand fast;
+  SlowCommand slow;
+  for (int i = 0; i < 10; ++i) {
+    profiler.addCommandExecution(typeid(fast), std::chrono::microseconds(1));
+  }
+  profiler.addCommandExecution(typeid(slow), std::chrono::milliseconds(1));
+
+  auto stats = profiler.getCommandStats();
+  CPPUNIT_ASSERT_EQUAL((size_t)2, stats.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("SlowCommand"), stats[0]->name);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, stats[0]->executeTime.getCount());
+  CPPUNIT_ASSERT_EQUAL((int64_t)1000, stats[0]->executeTime.getSum());
+  CPPUNIT_ASSERT_EQUAL(std::string("FastCommand"), stats[1]->name);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)10, stats[1]->executeTime.getCount());
+}
+
+void EngineProfilerTest::testReset()
+{
+  EngineProfiler profiler;
+  profiler.addIteration(std::chrono::microseconds(300), 4);
+  profiler.addPollWait(std::chrono::milliseconds(2));
+  profiler.addCommandExecution(typeid(FastCommand),
+                               std::chrono::microseconds(1));
+  CPPUNIT_ASSERT_EQUAL((int64_t)300, profiler.getIterationTime().getSum());
+  CPPUNIT_ASSERT_EQUAL((int64_t)4, profiler.getCommandsPerIteration().getSum());
+  CPPUNIT_ASSERT_EQUAL((int64_t)2000, profiler.getPollWaitTime().getSum());
+
+  profiler.reset();
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0, profiler.getIterationTime().getCount());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0, profiler.getPollWaitTime().getCount());
+  CPPUNIT_ASSERT(profiler.getCommandStats().empty());
+}
+
+} // namespace aria2
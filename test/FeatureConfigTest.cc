@@ -50,6 +50,13 @@ void FeatureConfigTest::testStrSupportedFeature()
 #else  // !HAVE_LIBSSH2
   CPPUNIT_ASSERT(!sftp);
 #endif // !HAVE_LIBSSH2
+
+  auto http2 = strSupportedFeature(FEATURE_HTTP2);
+#if defined(HAVE_LIBNGHTTP2) && defined(ENABLE_SSL)
+  CPPUNIT_ASSERT(http2);
+#else  // !HAVE_LIBNGHTTP2 || !ENABLE_SSL
+  CPPUNIT_ASSERT(!http2);
+#endif // !HAVE_LIBNGHTTP2 || !ENABLE_SSL
 }
 
 void FeatureConfigTest::testFeatureSummary()
@@ -89,6 +96,10 @@ void FeatureConfigTest::testFeatureSummary()
 #ifdef HAVE_LIBSSH2
       "SFTP",
 #endif // HAVE_LIBSSH2
+
+#if defined(HAVE_LIBNGHTTP2) && defined(ENABLE_SSL)
+      "HTTP/2",
+#endif // HAVE_LIBNGHTTP2 && ENABLE_SSL
   };
 
   std::string featuresString =
@@ -0,0 +1,126 @@
+#include "FileAllocationEntry.h"
+
+#include <thread>
+#include <chrono>
+
+#include <poll.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "StreamFileAllocationEntry.h"
+#include "RequestGroup.h"
+#include "DownloadContext.h"
+#include "PieceStorage.h"
+#include "DiskAdaptor.h"
+#include "Option.h"
+#include "GroupId.h"
+#include "File.h"
+#include "RecoverableException.h"
+
+namespace aria2 {
+
+class FileAllocationEntryTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(FileAllocationEntryTest);
+  CPPUNIT_TEST(testWorker);
+  CPPUNIT_TEST(testWorker_error);
+  CPPUNIT_TEST(testWorker_cancel);
+  CPPUNIT_TEST(testWorker_destroy);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  std::shared_ptr<Option> option_;
+  std::unique_ptr<RequestGroup> group_;
+  std::string path_;
+
+public:
+  void setUp()
+  {
+    option_ = std::make_shared<Option>();
+    path_ = A2_TEST_OUT_DIR "/aria2_FileAllocationEntryTest";
+    File(path_).remove();
+    group_ = make_unique<RequestGroup>(GroupId::create(), option_);
+    group_->setDownloadContext(
+        std::make_shared<DownloadContext>(1_m, 4_m, path_));
+    group_->initPieceStorage();
+    group_->getPieceStorage()->getDiskAdaptor()->initAndOpenFile();
+  }
+
+  void tearDown()
+  {
+    group_->getPieceStorage()->getDiskAdaptor()->closeFile();
+  }
+
+  void testWorker();
+  void testWorker_error();
+  void testWorker_cancel();
+  void testWorker_destroy();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(FileAllocationEntryTest);
+
+void FileAllocationEntryTest::testWorker()
+{
+  StreamFileAllocationEntry entry(group_.get());
+  entry.startWorker();
+  CPPUNIT_ASSERT(entry.workerStarted());
+  CPPUNIT_ASSERT(group_->isFileAllocationRunning());
+  CPPUNIT_ASSERT(entry.getWakeupFd() != -1);
+  // The worker makes the wakeup fd readable when it finishes.
+  pollfd pfd = {entry.getWakeupFd(), POLLIN, 0};
+  CPPUNIT_ASSERT_EQUAL(1, poll(&pfd, 1, 10000));
+  CPPUNIT_ASSERT(!entry.workerRunning());
+  // Until it is joined, the progress is the one the worker reported.
+  CPPUNIT_ASSERT(entry.finished());
+  CPPUNIT_ASSERT_EQUAL((int64_t)4_m, entry.getCurrentLength());
+  CPPUNIT_ASSERT_EQUAL((int64_t)4_m, entry.getTotalLength());
+  entry.joinWorker();
+  CPPUNIT_ASSERT(!entry.workerStarted());
+  CPPUNIT_ASSERT_EQUAL(-1, entry.getWakeupFd());
+  CPPUNIT_ASSERT(!group_->isFileAllocationRunning());
+  CPPUNIT_ASSERT(entry.finished());
+  CPPUNIT_ASSERT_EQUAL((int64_t)4_m, File(path_).size());
+}
+
+void FileAllocationEntryTest::testWorker_error()
+{
+  StreamFileAllocationEntry entry(group_.get());
+  // Writing to the closed file fails in the worker thread.
+  group_->getPieceStorage()->getDiskAdaptor()->closeFile();
+  entry.startWorker();
+  try {
+    entry.joinWorker();
+    CPPUNIT_FAIL("Exception must be thrown.");
+  }
+  catch (RecoverableException& e) {
+    // Success
+  }
+  CPPUNIT_ASSERT(!entry.finished());
+  CPPUNIT_ASSERT(!group_->isFileAllocationRunning());
+}
+
+void FileAllocationEntryTest::testWorker_cancel()
+{
+  StreamFileAllocationEntry entry(group_.get());
+  entry.startWorker();
+  entry.cancelWorker();
+  while (entry.workerRunning()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  // The worker stopped, so joining it does not block.
+  entry.joinWorker();
+  CPPUNIT_ASSERT(!entry.workerStarted());
+  CPPUNIT_ASSERT(!group_->isFileAllocationRunning());
+}
+
+void FileAllocationEntryTest::testWorker_destroy()
+{
+  {
+    StreamFileAllocationEntry entry(group_.get());
+    entry.startWorker();
+    // The destructor stops and joins the worker thread.
+  }
+  CPPUNIT_ASSERT(!group_->isFileAllocationRunning());
+}
+
+} // namespace aria2
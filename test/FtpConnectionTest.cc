@@ -33,6 +33,8 @@ class FtpConnectionTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testReceiveSizeResponse);
   CPPUNIT_TEST(testSendRetr);
   CPPUNIT_TEST(testReceiveEpsvResponse);
+  CPPUNIT_TEST(testQueue);
+  CPPUNIT_TEST(testPoolOptions);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -89,6 +91,8 @@ public:
   void testReceiveSizeResponse();
   void testSendRetr();
   void testReceiveEpsvResponse();
+  void testQueue();
+  void testPoolOptions();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(FtpConnectionTest);
@@ -346,4 +350,69 @@ void FtpConnectionTest::testReceiveEpsvResponse()
   CPPUNIT_ASSERT_EQUAL((uint16_t)0, port);
 }
 
+void FtpConnectionTest::testQueue()
+{
+  ftp_->queueCwd("dir");
+  ftp_->queueSize();
+  ftp_->queueRest(nullptr);
+  ftp_->queueRetr();
+  CPPUNIT_ASSERT(!ftp_->sendBufferIsEmpty());
+  CPPUNIT_ASSERT(ftp_->sendPendingData());
+  std::string expected = "CWD dir\r\n"
+                         "SIZE hello world.img\r\n"
+                         "REST 0\r\n"
+                         "RETR hello world.img\r\n";
+  std::string received;
+  while (received.size() < expected.size()) {
+    char data[128];
+    size_t len = sizeof(data);
+    serverSocket_->readData(data, len);
+    CPPUNIT_ASSERT(len > 0);
+    received.append(data, len);
+  }
+  CPPUNIT_ASSERT_EQUAL(expected, received);
+
+  // Responses to pipelined commands are received in order.
+  serverSocket_->writeData("250 cwd\r\n"
+                           "213 100\r\n"
+                           "350 rest\r\n"
+                           "150 retr\r\n");
+  waitRead(clientSocket_);
+  CPPUNIT_ASSERT_EQUAL(250, ftp_->receiveResponse());
+  int64_t size;
+  CPPUNIT_ASSERT_EQUAL(213, ftp_->receiveSizeResponse(size));
+  CPPUNIT_ASSERT_EQUAL((int64_t)100, size);
+  CPPUNIT_ASSERT_EQUAL(350, ftp_->receiveResponse());
+  CPPUNIT_ASSERT_EQUAL(150, ftp_->receiveResponse());
+}
+
+void FtpConnectionTest::testPoolOptions()
+{
+  CPPUNIT_ASSERT_EQUAL('I', ftp_->getRequestedTransferType());
+  CPPUNIT_ASSERT_EQUAL(std::string("/\n\n"), ftp_->getPoolOptions());
+
+  ftp_->setBaseWorkingDir("/home/user");
+  ftp_->setTransferType('I');
+  ftp_->setWorkingDir("/dir%20sp");
+  auto options = ftp_->getPoolOptions();
+
+  FtpConnection ftp(2, clientSocket_, req_, nullptr, option_.get());
+  ftp.setPoolOptions(options);
+  CPPUNIT_ASSERT_EQUAL(std::string("/home/user"), ftp.getBaseWorkingDir());
+  CPPUNIT_ASSERT_EQUAL('I', ftp.getTransferType());
+  CPPUNIT_ASSERT_EQUAL(std::string("/dir%20sp"), ftp.getWorkingDir());
+
+  ftp.setPoolOptions("/\n\n");
+  CPPUNIT_ASSERT_EQUAL(std::string("/"), ftp.getBaseWorkingDir());
+  CPPUNIT_ASSERT_EQUAL((char)0, ftp.getTransferType());
+  CPPUNIT_ASSERT_EQUAL(std::string(""), ftp.getWorkingDir());
+
+  // Only base working directory
+  ftp.setTransferType('A');
+  ftp.setPoolOptions("/pub");
+  CPPUNIT_ASSERT_EQUAL(std::string("/pub"), ftp.getBaseWorkingDir());
+  CPPUNIT_ASSERT_EQUAL((char)0, ftp.getTransferType());
+  CPPUNIT_ASSERT_EQUAL(std::string(""), ftp.getWorkingDir());
+}
+
 } // namespace aria2
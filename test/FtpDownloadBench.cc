@@ -0,0 +1,105 @@
+#include "Benchmark.h"
+
+#include <memory>
+
+#include <aria2/aria2.h>
+
+#include "LoopbackFtpServer.h"
+#include "aria2api.h"
+#include "DlAbortEx.h"
+#include "fmt.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+namespace bench {
+
+namespace {
+// Mirrors a tree of small files, 20 files in each directory, from one
+// server which adds 10ms of latency to each reply.  The control
+// connection round trips per file dominate.  At most 4 control
+// connections are used, which are handed over through the socket
+// pool.
+void mirrorTree(Result& result, int scale, bool pipelining)
+{
+  LoopbackFtpServer server;
+  server.setResponseDelay(10_ms);
+  server.start();
+  KeyVals options{{"no-conf", "true"},
+                  {"dir", prepareOutDir(result.name)},
+                  {"allow-overwrite", "true"},
+                  {"auto-file-renaming", "false"},
+                  {"file-allocation", "none"},
+                  {"max-tries", "1"},
+                  {"remote-time", "true"},
+                  {"max-concurrent-downloads", "4"},
+                  {"max-host-connections", "4"},
+                  {"ftp-pipelining", pipelining ? "true" : "false"}};
+  SessionConfig config;
+  config.useSignalHandler = false;
+  auto session = sessionNew(options, config);
+  if (!session) {
+    throw DL_ABORT_EX("Could not create session");
+  }
+  std::vector<A2Gid> gids;
+  {
+    Measure measure(result);
+    for (int i = 0; i < 100 * scale; ++i) {
+      // Each file gets its own output path through "out", because
+      // file names repeat across directories.
+      auto dir = fmt("/mirror/d%d", i / 20);
+      A2Gid gid;
+      if (addUri(session, &gid, {server.getURI(dir, 8_k, "file")},
+                 {{"out", fmt("file-%d", i)}}) != 0) {
+        sessionFinal(session);
+        throw DL_ABORT_EX("Could not add URI");
+      }
+      gids.push_back(gid);
+    }
+    run(session, RUN_DEFAULT);
+  }
+  std::string error;
+  for (auto gid : gids) {
+    auto dh = getDownloadHandle(session, gid);
+    if (!dh || dh->getStatus() != DOWNLOAD_COMPLETE) {
+      error = fmt("Download %s did not complete", gidToHex(gid).c_str());
+    }
+    else {
+      result.bytes += dh->getCompletedLength();
+      ++result.items;
+    }
+    if (dh) {
+      deleteDownloadHandle(dh);
+    }
+  }
+  sessionFinal(session);
+  result.metrics.push_back({"ftp_commands", server.getCommandCount()});
+  result.metrics.push_back({"ftp_pipelined", server.getPipelinedCount()});
+  result.metrics.push_back({"ftp_connections", server.getConnectionCount()});
+  if (!error.empty()) {
+    throw DL_ABORT_EX(error);
+  }
+}
+} // namespace
+
+namespace {
+void mirrorTreeSerial(Result& result, int scale)
+{
+  mirrorTree(result, scale, false);
+}
+} // namespace
+
+A2_BENCH_REGISTER("ftp-mirror-tree", mirrorTreeSerial);
+
+namespace {
+void mirrorTreePipelined(Result& result, int scale)
+{
+  mirrorTree(result, scale, true);
+}
+} // namespace
+
+A2_BENCH_REGISTER("ftp-mirror-tree-pipelined", mirrorTreePipelined);
+
+} // namespace bench
+
+} // namespace aria2
@@ -0,0 +1,160 @@
+#include "FtpNegotiationCommand.h"
+
+#include <csignal>
+#include <algorithm>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <aria2/aria2.h>
+
+#include "LoopbackFtpServer.h"
+#include "File.h"
+#include "util.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+class FtpNegotiationCommandTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(FtpNegotiationCommandTest);
+  CPPUNIT_TEST(testReuseConnection);
+  CPPUNIT_TEST(testReuseConnection_changeDir);
+  CPPUNIT_TEST(testReuseConnection_changeType);
+  CPPUNIT_TEST(testPipelining);
+  CPPUNIT_TEST_SUITE_END();
+
+  std::unique_ptr<LoopbackFtpServer> server_;
+  std::string dir_;
+
+  // Downloads each URI in |uris| one by one over a single control
+  // connection.  |options| is applied to the download of the same
+  // index.  Returns true if all downloads completed.
+  bool download(const std::vector<std::string>& uris,
+                const std::vector<KeyVals>& options, KeyVals globalOptions);
+
+  size_t count(const std::string& command) const;
+
+public:
+  void setUp()
+  {
+#ifdef SIGPIPE
+    signal(SIGPIPE, SIG_IGN);
+#endif // SIGPIPE
+    dir_ = A2_TEST_OUT_DIR "/aria2_FtpNegotiationCommandTest";
+    util::mkdirs(dir_);
+    server_ = make_unique<LoopbackFtpServer>();
+    server_->start();
+  }
+
+  void tearDown() { server_.reset(); }
+
+  void testReuseConnection();
+  void testReuseConnection_changeDir();
+  void testReuseConnection_changeType();
+  void testPipelining();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(FtpNegotiationCommandTest);
+
+bool FtpNegotiationCommandTest::download(const std::vector<std::string>& uris,
+                                         const std::vector<KeyVals>& options,
+                                         KeyVals globalOptions)
+{
+  globalOptions.push_back({"no-conf", "true"});
+  globalOptions.push_back({"quiet", "true"});
+  globalOptions.push_back({"dir", dir_});
+  globalOptions.push_back({"allow-overwrite", "true"});
+  globalOptions.push_back({"auto-file-renaming", "false"});
+  globalOptions.push_back({"file-allocation", "none"});
+  globalOptions.push_back({"max-tries", "1"});
+  globalOptions.push_back({"max-concurrent-downloads", "1"});
+  // The next download waits until the control connection is pooled.
+  globalOptions.push_back({"max-host-connections", "1"});
+  SessionConfig config;
+  auto session = sessionNew(globalOptions, config);
+  std::vector<A2Gid> gids;
+  for (size_t i = 0; i < uris.size(); ++i) {
+    A2Gid gid;
+    CPPUNIT_ASSERT_EQUAL(
+        0, addUri(session, &gid, {uris[i]},
+                  i < options.size() ? options[i] : KeyVals()));
+    gids.push_back(gid);
+  }
+  run(session, RUN_DEFAULT);
+  bool completed = true;
+  for (auto gid : gids) {
+    auto dh = getDownloadHandle(session, gid);
+    completed = completed && dh && dh->getStatus() == DOWNLOAD_COMPLETE;
+    deleteDownloadHandle(dh);
+  }
+  sessionFinal(session);
+  return completed;
+}
+
+size_t FtpNegotiationCommandTest::count(const std::string& command) const
+{
+  auto commands = server_->getCommands();
+  return std::count_if(std::begin(commands), std::end(commands),
+                       [&command](const std::string& c) {
+                         return util::startsWith(c, command);
+                       });
+}
+
+void FtpNegotiationCommandTest::testReuseConnection()
+{
+  CPPUNIT_ASSERT(download({server_->getURI("/pub/a", 10_k, "reuse1"),
+                           server_->getURI("/pub/a", 20_k, "reuse2")},
+                          {}, {}));
+  CPPUNIT_ASSERT_EQUAL((int64_t)1, server_->getConnectionCount());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, count("TYPE"));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, count("PWD"));
+  // CWD to "/", "pub" and "a" are not repeated for the second file.
+  CPPUNIT_ASSERT_EQUAL((size_t)3, count("CWD"));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, count("RETR"));
+  CPPUNIT_ASSERT_EQUAL((int64_t)0, server_->getPipelinedCount());
+  CPPUNIT_ASSERT_EQUAL((int64_t)10_k, File(dir_ + "/10240-reuse1").size());
+  CPPUNIT_ASSERT_EQUAL((int64_t)20_k, File(dir_ + "/20480-reuse2").size());
+}
+
+void FtpNegotiationCommandTest::testReuseConnection_changeDir()
+{
+  CPPUNIT_ASSERT(download({server_->getURI("/pub/a", 1_k, "changedir1"),
+                           server_->getURI("/pub/b", 1_k, "changedir2")},
+                          {}, {}));
+  CPPUNIT_ASSERT_EQUAL((int64_t)1, server_->getConnectionCount());
+  CPPUNIT_ASSERT_EQUAL((size_t)6, count("CWD"));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, count("CWD b"));
+}
+
+void FtpNegotiationCommandTest::testReuseConnection_changeType()
+{
+  CPPUNIT_ASSERT(download({server_->getURI("/pub", 1_k, "changetype1"),
+                           server_->getURI("/pub", 1_k, "changetype2")},
+                          {{{"ftp-type", "ascii"}}}, {}));
+  CPPUNIT_ASSERT_EQUAL((int64_t)1, server_->getConnectionCount());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, count("TYPE A"));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, count("TYPE I"));
+  // PWD is only sent after login.
+  CPPUNIT_ASSERT_EQUAL((size_t)1, count("PWD"));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, count("CWD"));
+}
+
+void FtpNegotiationCommandTest::testPipelining()
+{
+  CPPUNIT_ASSERT(download({server_->getURI("/pub/a", 100_k, "pipelining1"),
+                           server_->getURI("/pub/b", 1_k, "pipelining2")},
+                          {}, {{"ftp-pipelining", "true"},
+                               {"remote-time", "true"}}));
+  CPPUNIT_ASSERT_EQUAL((int64_t)1, server_->getConnectionCount());
+  CPPUNIT_ASSERT(server_->getPipelinedCount() > 0);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, count("PWD"));
+  CPPUNIT_ASSERT_EQUAL((size_t)6, count("CWD"));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, count("MDTM"));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, count("SIZE"));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, count("RETR"));
+  CPPUNIT_ASSERT_EQUAL((int64_t)100_k,
+                       File(dir_ + "/102400-pipelining1").size());
+  CPPUNIT_ASSERT_EQUAL((int64_t)1_k, File(dir_ + "/1024-pipelining2").size());
+}
+
+} // namespace aria2
@@ -0,0 +1,399 @@
+#include "Http2Session.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "SocketCore.h"
+#include "HttpHeader.h"
+#include "a2functional.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+class Http2SessionTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(Http2SessionTest);
+  CPPUNIT_TEST(testCreateHeaderBlock);
+  CPPUNIT_TEST(testSubmitRequest);
+  CPPUNIT_TEST(testMultiplexedStreams);
+  CPPUNIT_TEST(testRemoveStream);
+  CPPUNIT_TEST(testRemoveStream_bufferedData);
+  CPPUNIT_TEST(testGoaway);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  std::shared_ptr<SocketCore> clientSocket_;
+  std::shared_ptr<SocketCore> serverSocket_;
+
+public:
+  void setUp()
+  {
+    SocketCore listenSocket;
+    listenSocket.bind(0);
+    listenSocket.beginListen();
+    listenSocket.setBlockingMode();
+    auto port = listenSocket.getAddrInfo().port;
+
+    clientSocket_ = std::make_shared<SocketCore>();
+    clientSocket_->establishConnection("localhost", port);
+    while (!clientSocket_->isWritable(0))
+      ;
+    clientSocket_->setNonBlockingMode();
+
+    serverSocket_ = listenSocket.acceptConnection();
+    serverSocket_->setNonBlockingMode();
+  }
+
+  void testCreateHeaderBlock();
+  void testSubmitRequest();
+  void testMultiplexedStreams();
+  void testRemoveStream();
+  void testRemoveStream_bufferedData();
+  void testGoaway();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Http2SessionTest);
+
+namespace {
+// Minimal HTTP/2 server which responds to each request with the
+// request path as the response body, padded to bodyLength_ bytes.
+class TestServer {
+public:
+  TestServer(std::shared_ptr<SocketCore> socket)
+      : socket_(std::move(socket)),
+        session_(nullptr),
+        numResets_(0),
+        bodyLength_(0)
+  {
+    nghttp2_session_callbacks* callbacks;
+    nghttp2_session_callbacks_new(&callbacks);
+    nghttp2_session_callbacks_set_on_header_callback(callbacks, onHeader);
+    nghttp2_session_callbacks_set_on_frame_recv_callback(callbacks,
+                                                         onFrameRecv);
+    nghttp2_session_callbacks_set_on_stream_close_callback(callbacks,
+                                                           onStreamClose);
+    nghttp2_session_server_new(&session_, callbacks, this);
+    nghttp2_session_callbacks_del(callbacks);
+    nghttp2_settings_entry iv[] = {
+        {NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, 100}};
+    nghttp2_submit_settings(session_, NGHTTP2_FLAG_NONE, iv, 1);
+  }
+
+  ~TestServer() { nghttp2_session_del(session_); }
+
+  void recv()
+  {
+    unsigned char buf[16_k];
+    for (;;) {
+      size_t len = sizeof(buf);
+      socket_->readData(buf, len);
+      if (len == 0) {
+        return;
+      }
+      nghttp2_session_mem_recv(session_, buf, len);
+    }
+  }
+
+  void send()
+  {
+    for (;;) {
+      if (wbuf_.empty()) {
+        const uint8_t* data;
+        auto len = nghttp2_session_mem_send(session_, &data);
+        if (len <= 0) {
+          return;
+        }
+        wbuf_.assign(data, data + len);
+      }
+      auto n = socket_->writeData(wbuf_.data(), wbuf_.size());
+      wbuf_.erase(0, n);
+      if (!wbuf_.empty()) {
+        return;
+      }
+    }
+  }
+
+  void goaway()
+  {
+    nghttp2_submit_goaway(session_, NGHTTP2_FLAG_NONE, 0, NGHTTP2_NO_ERROR,
+                          nullptr, 0);
+  }
+
+  const std::map<int32_t, std::string>& getPaths() const { return paths_; }
+
+  int getNumResets() const { return numResets_; }
+
+  void setBodyLength(size_t bodyLength) { bodyLength_ = bodyLength; }
+
+  // Returns the connection flow control window of the client.
+  int32_t getRemoteWindowSize() const
+  {
+    return nghttp2_session_get_remote_window_size(session_);
+  }
+
+private:
+  static int onHeader(nghttp2_session* session, const nghttp2_frame* frame,
+                      const uint8_t* name, size_t namelen,
+                      const uint8_t* value, size_t valuelen, uint8_t flags,
+                      void* userData)
+  {
+    if (std::string(name, name + namelen) == ":path") {
+      static_cast<TestServer*>(userData)->paths_[frame->hd.stream_id] =
+          std::string(value, value + valuelen);
+    }
+    return 0;
+  }
+
+  static int onFrameRecv(nghttp2_session* session, const nghttp2_frame* frame,
+                         void* userData)
+  {
+    if (frame->hd.type != NGHTTP2_HEADERS ||
+        !(frame->hd.flags & NGHTTP2_FLAG_END_STREAM)) {
+      return 0;
+    }
+    auto server = static_cast<TestServer*>(userData);
+    auto& body = server->bodies_[frame->hd.stream_id];
+    body = server->paths_[frame->hd.stream_id];
+    if (body.size() < server->bodyLength_) {
+      body.resize(server->bodyLength_, 'a');
+    }
+    nghttp2_nv nva[] = {
+        {(uint8_t*)":status", (uint8_t*)"200", 7, 3, NGHTTP2_NV_FLAG_NONE}};
+    nghttp2_data_provider prd;
+    prd.source.ptr = &body;
+    prd.read_callback = readBody;
+    nghttp2_submit_response(session, frame->hd.stream_id, nva, 1, &prd);
+    return 0;
+  }
+
+  static int onStreamClose(nghttp2_session* session, int32_t streamId,
+                           uint32_t errorCode, void* userData)
+  {
+    if (errorCode == NGHTTP2_CANCEL) {
+      ++static_cast<TestServer*>(userData)->numResets_;
+    }
+    return 0;
+  }
+
+  static ssize_t readBody(nghttp2_session* session, int32_t streamId,
+                          uint8_t* buf, size_t length, uint32_t* dataFlags,
+                          nghttp2_data_source* source, void* userData)
+  {
+    auto body = static_cast<std::string*>(source->ptr);
+    auto n = std::min(length, body->size());
+    memcpy(buf, body->data(), n);
+    body->erase(0, n);
+    if (body->empty()) {
+      *dataFlags |= NGHTTP2_DATA_FLAG_EOF;
+    }
+    return n;
+  }
+
+  std::shared_ptr<SocketCore> socket_;
+  nghttp2_session* session_;
+  std::map<int32_t, std::string> paths_;
+  std::map<int32_t, std::string> bodies_;
+  // Frames which have not been written to the socket yet
+  std::string wbuf_;
+  int numResets_;
+  size_t bodyLength_;
+};
+} // namespace
+
+namespace {
+// Lets |session| and |server| exchange frames until both have
+// nothing more to send.
+void exchange(Http2Session& session, TestServer& server)
+{
+  for (int idle = 0; idle < 10;) {
+    session.send();
+    server.recv();
+    server.send();
+    if (session.recv() > 0) {
+      idle = 0;
+    }
+    else {
+      ++idle;
+    }
+  }
+}
+} // namespace
+
+namespace {
+std::string readAll(Http2Stream& stream)
+{
+  std::string res;
+  unsigned char buf[4_k];
+  size_t n;
+  while ((n = stream.readData(buf, sizeof(buf))) > 0) {
+    res.append(buf, buf + n);
+  }
+  return res;
+}
+} // namespace
+
+namespace {
+std::string createRequest(const std::string& path)
+{
+  return fmt("GET %s HTTP/1.1\r\n"
+             "User-Agent: aria2\r\n"
+             "Host: localhost\r\n"
+             "Connection: close\r\n"
+             "\r\n",
+             path.c_str());
+}
+} // namespace
+
+void Http2SessionTest::testCreateHeaderBlock()
+{
+  std::string request = "GET /dir/file?q=1 HTTP/1.1\r\n"
+                        "User-Agent: aria2/1.0\r\n"
+                        "Accept: */*\r\n"
+                        "Host: example.org:8443\r\n"
+                        "Pragma: no-cache\r\n"
+                        "Cache-Control: no-cache\r\n"
+                        "Connection: Keep-Alive\r\n"
+                        "Range: bytes=100-199\r\n"
+                        "\r\n";
+  auto nva = Http2Session::createHeaderBlock(request, "https");
+  CPPUNIT_ASSERT_EQUAL((size_t)9, nva.size());
+  CPPUNIT_ASSERT_EQUAL(std::string(":method"), nva[0].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("GET"), nva[0].second);
+  CPPUNIT_ASSERT_EQUAL(std::string(":scheme"), nva[1].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("https"), nva[1].second);
+  CPPUNIT_ASSERT_EQUAL(std::string(":authority"), nva[2].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("example.org:8443"), nva[2].second);
+  CPPUNIT_ASSERT_EQUAL(std::string(":path"), nva[3].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("/dir/file?q=1"), nva[3].second);
+  CPPUNIT_ASSERT_EQUAL(std::string("user-agent"), nva[4].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("aria2/1.0"), nva[4].second);
+  CPPUNIT_ASSERT_EQUAL(std::string("accept"), nva[5].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("pragma"), nva[6].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("cache-control"), nva[7].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("range"), nva[8].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("bytes=100-199"), nva[8].second);
+}
+
+void Http2SessionTest::testSubmitRequest()
+{
+  Http2Session session(clientSocket_);
+  TestServer server(serverSocket_);
+  auto stream = session.submitRequest(createRequest("/hello"), "https");
+  CPPUNIT_ASSERT_EQUAL((int32_t)1, stream->getStreamId());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, session.getNumActiveStreams());
+  CPPUNIT_ASSERT(!stream->readable());
+
+  exchange(session, server);
+
+  CPPUNIT_ASSERT(stream->readable());
+  auto header = stream->popResponseHeader();
+  CPPUNIT_ASSERT(header);
+  CPPUNIT_ASSERT_EQUAL(200, header->getStatusCode());
+  CPPUNIT_ASSERT_EQUAL(std::string("HTTP/2"), header->getVersion());
+  CPPUNIT_ASSERT(!stream->popResponseHeader());
+  CPPUNIT_ASSERT_EQUAL(std::string("/hello"), readAll(*stream));
+  CPPUNIT_ASSERT(stream->isClosed());
+  CPPUNIT_ASSERT_EQUAL((uint32_t)NGHTTP2_NO_ERROR, stream->getErrorCode());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, session.getNumActiveStreams());
+  CPPUNIT_ASSERT(session.canSubmitRequest());
+}
+
+void Http2SessionTest::testMultiplexedStreams()
+{
+  Http2Session session(clientSocket_);
+  TestServer server(serverSocket_);
+  std::vector<std::shared_ptr<Http2Stream>> streams;
+  for (int i = 0; i < 3; ++i) {
+    streams.push_back(
+        session.submitRequest(createRequest(fmt("/file%d", i)), "https"));
+  }
+  CPPUNIT_ASSERT_EQUAL((size_t)3, session.getNumActiveStreams());
+
+  exchange(session, server);
+
+  CPPUNIT_ASSERT_EQUAL((size_t)3, server.getPaths().size());
+  // Read in the reverse order of the requests.
+  for (int i = 2; i >= 0; --i) {
+    CPPUNIT_ASSERT(streams[i]->popResponseHeader());
+    CPPUNIT_ASSERT_EQUAL(fmt("/file%d", i), readAll(*streams[i]));
+    CPPUNIT_ASSERT(streams[i]->isClosed());
+  }
+  CPPUNIT_ASSERT_EQUAL((size_t)0, session.getNumActiveStreams());
+}
+
+void Http2SessionTest::testRemoveStream()
+{
+  Http2Session session(clientSocket_);
+  TestServer server(serverSocket_);
+  auto stream1 = session.submitRequest(createRequest("/1"), "https");
+  auto stream2 = session.submitRequest(createRequest("/2"), "https");
+  session.send();
+  server.recv();
+  CPPUNIT_ASSERT_EQUAL((size_t)2, server.getPaths().size());
+
+  // Destroying an open stream resets it.
+  auto streamId = stream1->getStreamId();
+  stream1.reset();
+  CPPUNIT_ASSERT(!session.findStream(streamId));
+
+  exchange(session, server);
+
+  CPPUNIT_ASSERT_EQUAL(1, server.getNumResets());
+  CPPUNIT_ASSERT(stream2->popResponseHeader());
+  CPPUNIT_ASSERT_EQUAL(std::string("/2"), readAll(*stream2));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, session.getNumActiveStreams());
+}
+
+void Http2SessionTest::testRemoveStream_bufferedData()
+{
+  Http2Session session(clientSocket_);
+  TestServer server(serverSocket_);
+  // 16 streams which fill their 1MiB windows take up the whole 16MiB
+  // connection window.
+  server.setBodyLength(1_m);
+  std::vector<std::shared_ptr<Http2Stream>> streams;
+  for (int i = 0; i < 16; ++i) {
+    streams.push_back(
+        session.submitRequest(createRequest(fmt("/%d", i)), "https"));
+  }
+
+  exchange(session, server);
+
+  for (auto& stream : streams) {
+    CPPUNIT_ASSERT_EQUAL((size_t)1_m, stream->getBufferedLength());
+  }
+  CPPUNIT_ASSERT_EQUAL((int32_t)0, server.getRemoteWindowSize());
+
+  // Cancelling the streams gives back the window of the data nobody
+  // reads.
+  streams.clear();
+  exchange(session, server);
+
+  CPPUNIT_ASSERT_EQUAL((int32_t)16_m, server.getRemoteWindowSize());
+  auto stream = session.submitRequest(createRequest("/new"), "https");
+
+  exchange(session, server);
+
+  CPPUNIT_ASSERT(stream->popResponseHeader());
+  CPPUNIT_ASSERT_EQUAL((size_t)1_m, readAll(*stream).size());
+}
+
+void Http2SessionTest::testGoaway()
+{
+  auto session = make_unique<Http2Session>(clientSocket_);
+  TestServer server(serverSocket_);
+  auto stream = session->submitRequest(createRequest("/1"), "https");
+  server.goaway();
+
+  exchange(*session, server);
+
+  CPPUNIT_ASSERT(!session->canSubmitRequest());
+
+  // Streams outlive the session they belong to.
+  auto stream2 = session->submitRequest(createRequest("/2"), "https");
+  session.reset();
+  CPPUNIT_ASSERT(stream2->isClosed());
+  CPPUNIT_ASSERT_EQUAL((uint32_t)NGHTTP2_INTERNAL_ERROR,
+                       stream2->getErrorCode());
+}
+
+} // namespace aria2
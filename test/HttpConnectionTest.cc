@@ -0,0 +1,191 @@
+#include "HttpConnection.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "HttpRequest.h"
+#include "HttpResponse.h"
+#include "HttpHeader.h"
+#include "Request.h"
+#include "FileEntry.h"
+#include "Option.h"
+#include "AuthConfigFactory.h"
+#include "SocketCore.h"
+#include "SocketRecvBuffer.h"
+#include "Command.h"
+
+namespace aria2 {
+
+class HttpConnectionTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(HttpConnectionTest);
+  CPPUNIT_TEST(testPipelinedResponses);
+  CPPUNIT_TEST(testCanPipeline);
+  CPPUNIT_TEST(testDetach);
+  CPPUNIT_TEST(testDetach_bodyOwner);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  std::shared_ptr<SocketCore> serverSocket_;
+  std::shared_ptr<SocketCore> clientSocket_;
+  std::shared_ptr<HttpConnection> conn_;
+  std::unique_ptr<Option> option_;
+  std::unique_ptr<AuthConfigFactory> authConfigFactory_;
+
+public:
+  void setUp()
+  {
+    option_.reset(new Option());
+    authConfigFactory_.reset(new AuthConfigFactory());
+
+    SocketCore listenSocket;
+    listenSocket.bind(0);
+    listenSocket.beginListen();
+    listenSocket.setBlockingMode();
+    auto port = listenSocket.getAddrInfo().port;
+
+    clientSocket_ = std::make_shared<SocketCore>();
+    clientSocket_->establishConnection("localhost", port);
+    while (!clientSocket_->isWritable(0))
+      ;
+    serverSocket_ = listenSocket.acceptConnection();
+    serverSocket_->setBlockingMode();
+    conn_ = std::make_shared<HttpConnection>(
+        1, clientSocket_, std::make_shared<SocketRecvBuffer>(clientSocket_));
+  }
+
+  std::unique_ptr<HttpRequest> createHttpRequest(const std::string& uri)
+  {
+    auto request = std::make_shared<Request>();
+    request->setUri(uri);
+    auto httpRequest = make_unique<HttpRequest>();
+    httpRequest->setRequest(request);
+    httpRequest->setFileEntry(std::make_shared<FileEntry>());
+    httpRequest->setAuthConfigFactory(authConfigFactory_.get());
+    httpRequest->setOption(option_.get());
+    return httpRequest;
+  }
+
+  std::unique_ptr<HttpResponse> receiveResponse()
+  {
+    for (int i = 0; i < 100; ++i) {
+      clientSocket_->isReadable(1);
+      auto httpResponse = conn_->receiveResponse();
+      if (httpResponse) {
+        return httpResponse;
+      }
+    }
+    return nullptr;
+  }
+
+  void testPipelinedResponses();
+  void testCanPipeline();
+  void testDetach();
+  void testDetach_bodyOwner();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(HttpConnectionTest);
+
+namespace {
+class WaitingCommand : public Command {
+public:
+  WaitingCommand(cuid_t cuid) : Command(cuid) {}
+  virtual bool execute() CXX11_OVERRIDE { return true; }
+};
+} // namespace
+
+void HttpConnectionTest::testPipelinedResponses()
+{
+  WaitingCommand waiter(2);
+  conn_->attach(1);
+  conn_->attach(2);
+  conn_->sendRequest(createHttpRequest("http://localhost/a"), 1);
+  conn_->sendRequest(createHttpRequest("http://localhost/b"), 2);
+  CPPUNIT_ASSERT(conn_->canReceiveResponse(1));
+  CPPUNIT_ASSERT(!conn_->canReceiveResponse(2));
+  conn_->waitForResponse(2, &waiter);
+
+  serverSocket_->writeData("HTTP/1.1 200 OK\r\n"
+                           "Content-Length: 3\r\n"
+                           "\r\n"
+                           "abc"
+                           "HTTP/1.1 200 OK\r\n"
+                           "Content-Length: 0\r\n"
+                           "\r\n");
+  auto httpResponse = receiveResponse();
+  CPPUNIT_ASSERT(httpResponse);
+  CPPUNIT_ASSERT_EQUAL((cuid_t)1, httpResponse->getCuid());
+  // Download 1 is receiving the body.
+  CPPUNIT_ASSERT(conn_->canReceiveResponse(1));
+  CPPUNIT_ASSERT(!conn_->canReceiveResponse(2));
+  CPPUNIT_ASSERT(!waiter.statusMatch(Command::STATUS_ACTIVE));
+
+  conn_->getSocketRecvBuffer()->drain(3);
+  CPPUNIT_ASSERT(!conn_->endResponse());
+  CPPUNIT_ASSERT(waiter.statusMatch(Command::STATUS_ACTIVE));
+  CPPUNIT_ASSERT(!conn_->canReceiveResponse(1));
+  CPPUNIT_ASSERT(conn_->canReceiveResponse(2));
+  conn_->cancelWait(&waiter);
+
+  httpResponse = receiveResponse();
+  CPPUNIT_ASSERT(httpResponse);
+  CPPUNIT_ASSERT_EQUAL((cuid_t)2, httpResponse->getCuid());
+  CPPUNIT_ASSERT(conn_->endResponse());
+  CPPUNIT_ASSERT(!conn_->isBroken());
+  CPPUNIT_ASSERT(!conn_->detach(1));
+  CPPUNIT_ASSERT(!conn_->detach(2));
+  CPPUNIT_ASSERT(!conn_->isBroken());
+}
+
+void HttpConnectionTest::testCanPipeline()
+{
+  // Idle connection is reused through the socket pool.
+  CPPUNIT_ASSERT(!conn_->canPipeline(2));
+  conn_->sendRequest(createHttpRequest("http://localhost/a"), 1);
+  CPPUNIT_ASSERT(conn_->canPipeline(2));
+  conn_->sendRequest(createHttpRequest("http://localhost/b"), 2);
+  CPPUNIT_ASSERT(!conn_->canPipeline(2));
+  CPPUNIT_ASSERT(conn_->canPipeline(3));
+}
+
+void HttpConnectionTest::testDetach()
+{
+  WaitingCommand waiter(3);
+  conn_->attach(1);
+  conn_->attach(2);
+  conn_->attach(2);
+  conn_->attach(3);
+  conn_->sendRequest(createHttpRequest("http://localhost/a"), 1);
+  conn_->sendRequest(createHttpRequest("http://localhost/b"), 2);
+  conn_->sendRequest(createHttpRequest("http://localhost/c"), 3);
+  conn_->waitForResponse(3, &waiter);
+
+  // Download 2 still has a command.
+  CPPUNIT_ASSERT(!conn_->detach(2));
+  CPPUNIT_ASSERT(!conn_->isBroken());
+  // The response to download 2 would never be received.
+  CPPUNIT_ASSERT(conn_->detach(2));
+  CPPUNIT_ASSERT(conn_->isBroken());
+  CPPUNIT_ASSERT(waiter.statusMatch(Command::STATUS_ACTIVE));
+  CPPUNIT_ASSERT(!conn_->canPipeline(8));
+  // Download 1 can still receive its response, but the connection
+  // must not be reused.
+  CPPUNIT_ASSERT(conn_->canReceiveResponse(1));
+}
+
+void HttpConnectionTest::testDetach_bodyOwner()
+{
+  conn_->attach(1);
+  conn_->attach(2);
+  conn_->sendRequest(createHttpRequest("http://localhost/a"), 1);
+  conn_->sendRequest(createHttpRequest("http://localhost/b"), 2);
+  serverSocket_->writeData("HTTP/1.1 200 OK\r\n"
+                           "Content-Length: 3\r\n"
+                           "\r\n");
+  CPPUNIT_ASSERT(receiveResponse());
+  // Download 1 gave up before the body was received.
+  conn_->detach(1);
+  CPPUNIT_ASSERT(conn_->isBroken());
+  CPPUNIT_ASSERT(!conn_->canReceiveResponse(2));
+}
+
+} // namespace aria2
@@ -0,0 +1,252 @@
+#include "Benchmark.h"
+
+#include <memory>
+
+#include <aria2/aria2.h>
+
+#include "LoopbackHttpServer.h"
+#include "aria2api.h"
+#include "Context.h"
+#include "MultiUrlRequestInfo.h"
+#include "DownloadEngine.h"
+#include "EngineProfiler.h"
+#include "SocketPool.h"
+#include "DlAbortEx.h"
+#include "fmt.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+namespace bench {
+
+namespace {
+// Downloads each element of |downloads|, which is a list of mirror
+// URIs for one file, in one session and accounts them to |result|.
+void download(Result& result,
+              const std::vector<std::vector<std::string>>& downloads,
+              KeyVals options)
+{
+  options.push_back({"no-conf", "true"});
+  options.push_back({"allow-overwrite", "true"});
+  options.push_back({"auto-file-renaming", "false"});
+  options.push_back({"file-allocation", "none"});
+  options.push_back({"max-tries", "1"});
+  options.push_back({"enable-engine-profile", "true"});
+  options.push_back({"engine-profile-interval", "0"});
+  SessionConfig config;
+  config.useSignalHandler = false;
+  auto session = sessionNew(options, config);
+  if (!session) {
+    throw DL_ABORT_EX("Could not create session");
+  }
+  std::vector<A2Gid> gids;
+  {
+    Measure measure(result);
+    for (auto& uris : downloads) {
+      A2Gid gid;
+      if (addUri(session, &gid, uris, KeyVals()) != 0) {
+        sessionFinal(session);
+        throw DL_ABORT_EX(fmt("Could not add %s", uris[0].c_str()));
+      }
+      gids.push_back(gid);
+    }
+    run(session, RUN_DEFAULT);
+  }
+  auto& e = session->context->reqinfo->getDownloadEngine();
+  auto& profiler = e->getEngineProfiler();
+  auto& iteration = profiler->getIterationTime();
+  result.metrics.push_back(
+      {"loop_iterations", static_cast<int64_t>(iteration.getCount())});
+  result.metrics.push_back({"loop_p50_usec", iteration.getPercentile(50)});
+  result.metrics.push_back({"loop_p99_usec", iteration.getPercentile(99)});
+  result.metrics.push_back({"loop_max_usec", iteration.getMax()});
+  result.metrics.push_back(
+      {"poll_wait_usec", profiler->getPollWaitTime().getSum()});
+  result.metrics.push_back(
+      {"socket_pool_hits",
+       static_cast<int64_t>(e->getSocketPool()->getHitCount())});
+  result.metrics.push_back(
+      {"socket_pool_misses",
+       static_cast<int64_t>(e->getSocketPool()->getMissCount())});
+  std::string error;
+  for (auto gid : gids) {
+    auto dh = getDownloadHandle(session, gid);
+    if (!dh || dh->getStatus() != DOWNLOAD_COMPLETE) {
+      error = fmt("Download %s did not complete", gidToHex(gid).c_str());
+    }
+    else {
+      result.bytes += dh->getCompletedLength();
+      ++result.items;
+    }
+    if (dh) {
+      deleteDownloadHandle(dh);
+    }
+  }
+  sessionFinal(session);
+  if (!error.empty()) {
+    throw DL_ABORT_EX(error);
+  }
+}
+} // namespace
+
+namespace {
+void addServerMetrics(
+    Result& result,
+    const std::vector<std::unique_ptr<LoopbackHttpServer>>& servers)
+{
+  int64_t requests = 0;
+  int64_t connections = 0;
+  for (auto& s : servers) {
+    requests += s->getRequestCount();
+    connections += s->getConnectionCount();
+  }
+  result.metrics.push_back({"http_requests", requests});
+  result.metrics.push_back({"http_connections", connections});
+}
+} // namespace
+
+namespace {
+std::vector<std::unique_ptr<LoopbackHttpServer>>
+startServers(size_t num, std::chrono::milliseconds delay)
+{
+  std::vector<std::unique_ptr<LoopbackHttpServer>> servers;
+  for (size_t i = 0; i < num; ++i) {
+    servers.push_back(make_unique<LoopbackHttpServer>());
+    servers.back()->setResponseDelay(delay);
+    servers.back()->start();
+  }
+  return servers;
+}
+} // namespace
+
+namespace {
+// Per download overhead dominates: request setup, response header
+// parsing, file creation and RequestGroup bookkeeping.
+void manySmallFiles(Result& result, int scale)
+{
+  auto servers = startServers(1, 0_ms);
+  std::vector<std::vector<std::string>> downloads;
+  for (int i = 0; i < 200 * scale; ++i) {
+    downloads.push_back({servers[0]->getURI(64_k, fmt("small-%d", i))});
+  }
+  download(result, downloads,
+           {{"dir", prepareOutDir(result.name)},
+            {"max-concurrent-downloads", "16"}});
+  addServerMetrics(result, servers);
+}
+} // namespace
+
+A2_BENCH_REGISTER("http-many-small-files", manySmallFiles);
+
+namespace {
+// Same as http-many-small-files, but the 16 concurrent downloads share
+// at most 4 connections, which are handed over through the socket
+// pool.
+void manySmallFilesHostLimit(Result& result, int scale)
+{
+  auto servers = startServers(1, 0_ms);
+  std::vector<std::vector<std::string>> downloads;
+  for (int i = 0; i < 200 * scale; ++i) {
+    downloads.push_back({servers[0]->getURI(64_k, fmt("small-%d", i))});
+  }
+  download(result, downloads,
+           {{"dir", prepareOutDir(result.name)},
+            {"max-concurrent-downloads", "16"},
+            {"max-host-connections", "4"}});
+  addServerMetrics(result, servers);
+}
+} // namespace
+
+A2_BENCH_REGISTER("http-many-small-files-host-limit", manySmallFilesHostLimit);
+
+namespace {
+// Throughput of the segmented download path: piece selection, disk
+// cache and socket reads for a single large file fetched from two
+// mirrors.
+void largeFileSplit(Result& result, int scale)
+{
+  auto servers = startServers(2, 0_ms);
+  int64_t length = 256_m * scale;
+  std::vector<std::vector<std::string>> downloads{
+      {servers[0]->getURI(length, "large"),
+       servers[1]->getURI(length, "large")}};
+  download(result, downloads,
+           {{"dir", prepareOutDir(result.name)},
+            {"split", "8"},
+            {"max-connection-per-server", "4"},
+            {"min-split-size", "4M"}});
+  addServerMetrics(result, servers);
+}
+} // namespace
+
+A2_BENCH_REGISTER("http-large-file-split", largeFileSplit);
+
+namespace {
+// Many medium sized files from four mirrors which add 20ms of
+// latency to each response, so that time spent waiting on round
+// trips, rather than raw throughput, is measured.
+void mirrorsWithLatency(Result& result, int scale)
+{
+  auto servers = startServers(4, 20_ms);
+  std::vector<std::vector<std::string>> downloads;
+  for (int i = 0; i < 20 * scale; ++i) {
+    std::vector<std::string> uris;
+    for (auto& s : servers) {
+      uris.push_back(s->getURI(4_m, fmt("mirror-%d", i)));
+    }
+    downloads.push_back(std::move(uris));
+  }
+  download(result, downloads,
+           {{"dir", prepareOutDir(result.name)},
+            {"max-concurrent-downloads", "5"},
+            {"split", "4"},
+            {"min-split-size", "1M"}});
+  addServerMetrics(result, servers);
+}
+} // namespace
+
+A2_BENCH_REGISTER("http-mirrors-with-latency", mirrorsWithLatency);
+
+namespace {
+// Many ~50KiB files from one server which adds 20ms of latency to
+// each response.  A request/response round trip per file dominates,
+// unless requests of the concurrent downloads are pipelined.
+void smallFilesWithLatency(Result& result, int scale, bool pipelining)
+{
+  auto servers = startServers(1, 20_ms);
+  std::vector<std::vector<std::string>> downloads;
+  for (int i = 0; i < 100 * scale; ++i) {
+    downloads.push_back({servers[0]->getURI(50_k, fmt("latency-%d", i))});
+  }
+  download(result, downloads,
+           {{"dir", prepareOutDir(result.name)},
+            {"max-concurrent-downloads", "16"},
+            {"enable-http-pipelining", pipelining ? "true" : "false"},
+            {"max-http-pipelining", "8"}});
+  addServerMetrics(result, servers);
+}
+} // namespace
+
+namespace {
+void smallFilesWithLatencyKeepAlive(Result& result, int scale)
+{
+  smallFilesWithLatency(result, scale, false);
+}
+} // namespace
+
+A2_BENCH_REGISTER("http-small-files-with-latency",
+                  smallFilesWithLatencyKeepAlive);
+
+namespace {
+void smallFilesWithLatencyPipelined(Result& result, int scale)
+{
+  smallFilesWithLatency(result, scale, true);
+}
+} // namespace
+
+A2_BENCH_REGISTER("http-small-files-with-latency-pipelined",
+                  smallFilesWithLatencyPipelined);
+
+} // namespace bench
+
+} // namespace aria2
@@ -0,0 +1,112 @@
+#include "Benchmark.h"
+
+#include "HttpHeaderProcessor.h"
+#include "HttpHeader.h"
+#include "DlAbortEx.h"
+
+namespace aria2 {
+
+namespace bench {
+
+namespace {
+const char RESPONSE[] = "HTTP/1.1 206 Partial Content\r\n"
+                        "Date: Mon, 25 Jun 2007 16:04:59 GMT\r\n"
+                        "Server: Apache/2.2.3 (Debian)\r\n"
+                        "Last-Modified: Tue, 12 Jun 2007 14:28:43 GMT\r\n"
+                        "ETag: \"594065-23e3-50825cc0\"\r\n"
+                        "Accept-Ranges: bytes\r\n"
+                        "Content-Length: 1048576\r\n"
+                        "Content-Range: bytes 1048576-2097151/10485760\r\n"
+                        "Keep-Alive: timeout=15, max=100\r\n"
+                        "Connection: Keep-Alive\r\n"
+                        "Content-Type: application/octet-stream\r\n"
+                        "\r\n";
+} // namespace
+
+namespace {
+const char REQUEST[] = "POST /jsonrpc HTTP/1.1\r\n"
+                       "Host: localhost:6800\r\n"
+                       "User-Agent: Mozilla/5.0 (X11; Linux x86_64)\r\n"
+                       "Accept: application/json, text/javascript, */*\r\n"
+                       "Accept-Language: en-US,en;q=0.5\r\n"
+                       "Accept-Encoding: gzip, deflate\r\n"
+                       "Content-Type: application/json\r\n"
+                       "Origin: http://localhost:8080\r\n"
+                       "Content-Length: 101\r\n"
+                       "Connection: keep-alive\r\n"
+                       "\r\n";
+} // namespace
+
+namespace {
+// Parses |hd| 50000 * |scale| times.  If |split| is true, the first
+// byte is fed separately, so that the header is processed by the
+// byte-oriented state machine instead of the header block fast path.
+void parse(Result& result, int scale, HttpHeaderProcessor::ParserMode mode,
+           const char* hd, size_t len, bool split)
+{
+  auto data = reinterpret_cast<const unsigned char*>(hd);
+  HttpHeaderProcessor proc(mode);
+  Measure measure(result);
+  for (int i = 0; i < 50000 * scale; ++i) {
+    proc.clear();
+    bool done;
+    if (split) {
+      proc.parse(data, 1);
+      done = proc.parse(data + 1, len - 1);
+    }
+    else {
+      done = proc.parse(data, len);
+    }
+    if (!done) {
+      throw DL_ABORT_EX("Header was not parsed");
+    }
+    auto h = proc.getResult();
+    result.bytes += len;
+    ++result.items;
+  }
+}
+} // namespace
+
+namespace {
+void parseResponse(Result& result, int scale)
+{
+  parse(result, scale, HttpHeaderProcessor::CLIENT_PARSER, RESPONSE,
+        sizeof(RESPONSE) - 1, false);
+}
+} // namespace
+
+A2_BENCH_REGISTER("http_header_parse_response", parseResponse);
+
+namespace {
+void parseResponseSplit(Result& result, int scale)
+{
+  parse(result, scale, HttpHeaderProcessor::CLIENT_PARSER, RESPONSE,
+        sizeof(RESPONSE) - 1, true);
+}
+} // namespace
+
+A2_BENCH_REGISTER("http_header_parse_response_split", parseResponseSplit);
+
+namespace {
+void parseRequest(Result& result, int scale)
+{
+  parse(result, scale, HttpHeaderProcessor::SERVER_PARSER, REQUEST,
+        sizeof(REQUEST) - 1, false);
+}
+} // namespace
+
+A2_BENCH_REGISTER("http_header_parse_request", parseRequest);
+
+namespace {
+void parseRequestSplit(Result& result, int scale)
+{
+  parse(result, scale, HttpHeaderProcessor::SERVER_PARSER, REQUEST,
+        sizeof(REQUEST) - 1, true);
+}
+} // namespace
+
+A2_BENCH_REGISTER("http_header_parse_request_split", parseRequestSplit);
+
+} // namespace bench
+
+} // namespace aria2
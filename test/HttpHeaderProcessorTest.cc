@@ -7,6 +7,7 @@
 #include "HttpHeader.h"
 #include "DlRetryEx.h"
 #include "DlAbortEx.h"
+#include "a2functional.h"
 
 namespace aria2 {
 
@@ -26,6 +27,8 @@ class HttpHeaderProcessorTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testBeyondLimit);
   CPPUNIT_TEST(testGetHeaderString);
   CPPUNIT_TEST(testGetHttpRequestHeader);
+  CPPUNIT_TEST(testParseHeaderBlock);
+  CPPUNIT_TEST(testParseHeaderBlock_fallback);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -42,6 +45,8 @@ public:
   void testBeyondLimit();
   void testGetHeaderString();
   void testGetHttpRequestHeader();
+  void testParseHeaderBlock();
+  void testParseHeaderBlock_fallback();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(HttpHeaderProcessorTest);
@@ -242,6 +247,24 @@ void HttpHeaderProcessorTest::testBeyondLimit()
   catch (DlAbortEx& ex) {
     // Success
   }
+
+  // The whole header in one buffer takes the fast path, which must
+  // apply the same limits.
+  for (auto& field : {"Content-Type: " + std::string(8_k + 1, 'A'),
+                      "X-Foo: " + std::string(8_k + 1, 'A'),
+                      std::string(1025, 'A') + ": foo"}) {
+    proc.clear();
+    try {
+      proc.parse(hd1 + field + "\r\n\r\n");
+      CPPUNIT_FAIL("Exception must be thrown.");
+    }
+    catch (DlAbortEx& ex) {
+      // Success
+    }
+  }
+  proc.clear();
+  CPPUNIT_ASSERT(proc.parse(hd1 + "Content-Type: " + std::string(8_k, 'A') +
+                            "\r\n\r\n"));
 }
 
 void HttpHeaderProcessorTest::testGetHeaderString()
@@ -295,4 +318,123 @@ void HttpHeaderProcessorTest::testGetHttpRequestHeader()
   CPPUNIT_ASSERT(!httpHeader->defined(HttpHeader::CONTENT_ENCODING));
 }
 
+namespace {
+// Parses hd at once, which takes the fast path if possible, and byte
+// by byte, which always uses the state machine, and checks that both
+// results are the same.
+void checkSameResult(HttpHeaderProcessor::ParserMode mode,
+                     const std::string& hd)
+{
+  HttpHeaderProcessor whole(mode), split(mode);
+  CPPUNIT_ASSERT(whole.parse(hd));
+  size_t processed = 0;
+  for (; processed < hd.size(); ++processed) {
+    if (split.parse(
+            reinterpret_cast<const unsigned char*>(&hd[processed]), 1)) {
+      ++processed;
+      break;
+    }
+  }
+  CPPUNIT_ASSERT_EQUAL(processed, whole.getLastBytesProcessed());
+  CPPUNIT_ASSERT_EQUAL(split.getHeaderString(), whole.getHeaderString());
+  auto h1 = whole.getResult();
+  auto h2 = split.getResult();
+  CPPUNIT_ASSERT_EQUAL(h2->getStatusCode(), h1->getStatusCode());
+  CPPUNIT_ASSERT_EQUAL(h2->getReasonPhrase(), h1->getReasonPhrase());
+  CPPUNIT_ASSERT_EQUAL(h2->getVersion(), h1->getVersion());
+  CPPUNIT_ASSERT_EQUAL(h2->getMethod(), h1->getMethod());
+  CPPUNIT_ASSERT_EQUAL(h2->getRequestPath(), h1->getRequestPath());
+  for (int i = 0; i < HttpHeader::MAX_INTERESTING_HEADER; ++i) {
+    CPPUNIT_ASSERT(h2->findAll(i) == h1->findAll(i));
+  }
+}
+} // namespace
+
+void HttpHeaderProcessorTest::testParseHeaderBlock()
+{
+  checkSameResult(HttpHeaderProcessor::CLIENT_PARSER,
+                  "HTTP/1.1 206 Partial Content\r\n"
+                  "Date: Mon, 25 Jun 2007 16:04:59 GMT\r\n"
+                  "X-Long-Header-Name-Not-Interesting-At-All: foo\r\n"
+                  "Content-Length: 9187 \r\n"
+                  "Content-Range:bytes 0-9186/10000\r\n"
+                  "Set-Cookie: a=b\r\n"
+                  "set-cookie:  c=d\t\r\n"
+                  "Content-Type:\r\n"
+                  "\r\nputbackme");
+  checkSameResult(HttpHeaderProcessor::CLIENT_PARSER,
+                  "HTTP/1.0  200   OK  \n"
+                  "Connection: close\n"
+                  "\n");
+  checkSameResult(HttpHeaderProcessor::CLIENT_PARSER, "HTTP/1.1 200\r\n\r\n");
+  checkSameResult(HttpHeaderProcessor::CLIENT_PARSER,
+                  "HTTP/1.1 200 \r\n"
+                  "Transfer-Encoding: chunked\r\n"
+                  "Content-Length: 200\r\n"
+                  "\r\n");
+  checkSameResult(HttpHeaderProcessor::SERVER_PARSER,
+                  "POST  /jsonrpc HTTP/1.1\r\n"
+                  "Host: localhost:6800\r\n"
+                  "Content-Length: 48\r\n"
+                  "Authorization: Basic Zm9vOmJhcg==\r\n"
+                  "\r\n"
+                  "{}");
+  // Multi-line header field is handled by the state machine.
+  checkSameResult(HttpHeaderProcessor::SERVER_PARSER,
+                  "GET / HTTP/1.1\r\n"
+                  "Accept-Encoding: text1\r\n"
+                  "  text2\r\n"
+                  "\r\n");
+}
+
+void HttpHeaderProcessorTest::testParseHeaderBlock_fallback()
+{
+  HttpHeaderProcessor proc(HttpHeaderProcessor::CLIENT_PARSER);
+  // Incomplete header
+  CPPUNIT_ASSERT(!proc.parse("HTTP/1.1 200 OK\r\n"
+                             "Content-Length: 100\r\n"));
+  CPPUNIT_ASSERT(proc.parse("Content-Type: text/plain\r\n"
+                            "\r\n"));
+  auto h = proc.getResult();
+  CPPUNIT_ASSERT_EQUAL(200, h->getStatusCode());
+  CPPUNIT_ASSERT_EQUAL(std::string("100"), h->find(HttpHeader::CONTENT_LENGTH));
+  CPPUNIT_ASSERT_EQUAL(std::string("text/plain"),
+                       h->find(HttpHeader::CONTENT_TYPE));
+
+  // CR in the middle of the line
+  proc.clear();
+  try {
+    proc.parse("HTTP/1.1 200 OK\r\n"
+               "Content-Length: 100\rfoo\r\n"
+               "\r\n");
+    CPPUNIT_FAIL("Exception must be thrown.");
+  }
+  catch (DlAbortEx& ex) {
+    // Success
+  }
+
+  // Missing ':'
+  proc.clear();
+  try {
+    proc.parse("HTTP/1.1 200 OK\r\n"
+               "Content-Length 100\r\n"
+               "\r\n");
+    CPPUNIT_FAIL("Exception must be thrown.");
+  }
+  catch (DlAbortEx& ex) {
+    // Success
+  }
+
+  // LWS after HTTP-version
+  HttpHeaderProcessor serverProc(HttpHeaderProcessor::SERVER_PARSER);
+  try {
+    serverProc.parse("GET / HTTP/1.1 \r\n"
+                     "\r\n");
+    CPPUNIT_FAIL("Exception must be thrown.");
+  }
+  catch (DlAbortEx& ex) {
+    // Success
+  }
+}
+
 } // namespace aria2
@@ -15,6 +15,8 @@ class HttpHeaderTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testClearField);
   CPPUNIT_TEST(testFieldContains);
   CPPUNIT_TEST(testRemove);
+  CPPUNIT_TEST(testEqualRange);
+  CPPUNIT_TEST(testIdInterestingHeader);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -23,6 +25,8 @@ public:
   void testClearField();
   void testFieldContains();
   void testRemove();
+  void testEqualRange();
+  void testIdInterestingHeader();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(HttpHeaderTest);
@@ -197,4 +201,44 @@ void HttpHeaderTest::testRemove()
   CPPUNIT_ASSERT(h.defined(HttpHeader::CONNECTION));
 }
 
+void HttpHeaderTest::testEqualRange()
+{
+  HttpHeader h;
+  h.put(HttpHeader::SET_COOKIE, "a=1");
+  h.put(HttpHeader::CONNECTION, "close");
+  h.put(HttpHeader::SET_COOKIE, "b=2");
+  h.put(HttpHeader::ACCEPT_ENCODING, "gzip");
+  h.put(HttpHeader::SET_COOKIE, "c=3");
+
+  auto r = h.equalRange(HttpHeader::SET_COOKIE);
+  CPPUNIT_ASSERT_EQUAL((ptrdiff_t)3, std::distance(r.first, r.second));
+  CPPUNIT_ASSERT_EQUAL(std::string("a=1"), (*r.first++).second);
+  CPPUNIT_ASSERT_EQUAL(std::string("b=2"), (*r.first++).second);
+  CPPUNIT_ASSERT_EQUAL(std::string("c=3"), (*r.first++).second);
+  CPPUNIT_ASSERT_EQUAL(std::string("a=1"), h.find(HttpHeader::SET_COOKIE));
+  CPPUNIT_ASSERT_EQUAL(std::string("close"), h.find(HttpHeader::CONNECTION));
+
+  r = h.equalRange(HttpHeader::LINK);
+  CPPUNIT_ASSERT(r.first == r.second);
+  CPPUNIT_ASSERT(!h.defined(HttpHeader::MAX_INTERESTING_HEADER));
+}
+
+void HttpHeaderTest::testIdInterestingHeader()
+{
+  CPPUNIT_ASSERT_EQUAL((int)HttpHeader::ACCEPT_ENCODING,
+                       idInterestingHeader("accept-encoding"));
+  CPPUNIT_ASSERT_EQUAL((int)HttpHeader::CONTENT_LENGTH,
+                       idInterestingHeader("content-length"));
+  CPPUNIT_ASSERT_EQUAL((int)HttpHeader::UPGRADE,
+                       idInterestingHeader("upgrade"));
+  CPPUNIT_ASSERT_EQUAL((int)HttpHeader::MAX_INTERESTING_HEADER,
+                       idInterestingHeader("Content-Length"));
+  CPPUNIT_ASSERT_EQUAL((int)HttpHeader::MAX_INTERESTING_HEADER,
+                       idInterestingHeader("content-lengtx"));
+  CPPUNIT_ASSERT_EQUAL((int)HttpHeader::MAX_INTERESTING_HEADER,
+                       idInterestingHeader("x"));
+  CPPUNIT_ASSERT_EQUAL((int)HttpHeader::MAX_INTERESTING_HEADER,
+                       idInterestingHeader(""));
+}
+
 } // namespace aria2
@@ -865,8 +865,14 @@ void HttpRequestTest::testEnableAcceptEncoding()
 
   std::string acceptEncodings;
 #ifdef HAVE_ZLIB
-  acceptEncodings += "deflate, gzip";
+  acceptEncodings += ", deflate, gzip";
 #endif // HAVE_ZLIB
+#ifdef HAVE_LIBBROTLIDEC
+  acceptEncodings += ", br";
+#endif // HAVE_LIBBROTLIDEC
+#ifdef HAVE_LIBZSTD
+  acceptEncodings += ", zstd";
+#endif // HAVE_LIBZSTD
 
   std::string expectedTextHead =
       "GET /archives/aria2-1.0.0.tar.bz2 HTTP/1.1\r\n"
@@ -885,7 +891,7 @@ void HttpRequestTest::testEnableAcceptEncoding()
   expectedText = expectedTextHead;
   if (!acceptEncodings.empty()) {
     expectedText += "Accept-Encoding: ";
-    expectedText += acceptEncodings;
+    expectedText += acceptEncodings.substr(2);
     expectedText += "\r\n";
   }
   expectedText += expectedTextTail;
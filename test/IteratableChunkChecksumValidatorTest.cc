@@ -9,6 +9,10 @@
 #include "DiskAdaptor.h"
 #include "FileEntry.h"
 #include "PieceSelector.h"
+#include "DirectDiskAdaptor.h"
+#include "ByteArrayDiskWriter.h"
+#include "MessageDigest.h"
+#include "a2functional.h"
 
 namespace aria2 {
 
@@ -17,6 +21,7 @@ class IteratableChunkChecksumValidatorTest : public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(IteratableChunkChecksumValidatorTest);
   CPPUNIT_TEST(testValidate);
   CPPUNIT_TEST(testValidate_readError);
+  CPPUNIT_TEST(testValidate_hole);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -27,6 +32,7 @@ public:
 
   void testValidate();
   void testValidate_readError();
+  void testValidate_hole();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(IteratableChunkChecksumValidatorTest);
@@ -106,4 +112,84 @@ void IteratableChunkChecksumValidatorTest::testValidate_readError()
   CPPUNIT_ASSERT(!ps->hasPiece(4));
 }
 
+namespace {
+std::string sha1(const std::string& data)
+{
+  auto ctx = MessageDigest::sha1();
+  ctx->update(data.data(), data.size());
+  return ctx->digest();
+}
+} // namespace
+
+namespace {
+// 4 pieces of 64KiB.  The pieces #0 and #2 are holes, and reading
+// them fails the test.
+class HoleDiskWriter : public ByteArrayDiskWriter {
+public:
+  HoleDiskWriter() : readLength_(0) {}
+
+  virtual int64_t seekData(int64_t offset) CXX11_OVERRIDE
+  {
+    if (offset < 64_k) {
+      return 64_k;
+    }
+    if (offset >= 128_k && offset < 192_k) {
+      return 192_k;
+    }
+    return offset;
+  }
+
+  virtual ssize_t readData(unsigned char* data, size_t len,
+                           int64_t offset) CXX11_OVERRIDE
+  {
+    int64_t last = offset + len;
+    CPPUNIT_ASSERT_MESSAGE("read in a hole",
+                           (offset >= 64_k && last <= 128_k) ||
+                               offset >= 192_k);
+    readLength_ += len;
+    return ByteArrayDiskWriter::readData(data, len, offset);
+  }
+
+  int64_t getReadLength() const { return readLength_; }
+
+private:
+  int64_t readLength_;
+};
+} // namespace
+
+void IteratableChunkChecksumValidatorTest::testValidate_hole()
+{
+  Option option;
+  auto dctx = std::make_shared<DownloadContext>(
+      64_k, 256_k, A2_TEST_OUT_DIR "/aria2_IteratableChunkChecksum_hole");
+  std::string data(64_k, 'a');
+  auto zeros = sha1(std::string(64_k, '\0'));
+  std::vector<std::string> hashes{
+      zeros, sha1(data), sha1(data),
+      fromHex("ffffffffffffffffffffffffffffffffffffffff")};
+  dctx->setPieceHashes("sha-1", hashes.begin(), hashes.end());
+  auto ps = std::make_shared<DefaultPieceStorage>(dctx, &option);
+  ps->initStorage();
+  auto dw = make_unique<HoleDiskWriter>();
+  auto writer = dw.get();
+  writer->setString(std::string(64_k, '\0') + data + std::string(64_k, '\0') +
+                    std::string(64_k, 'b'));
+  std::static_pointer_cast<DirectDiskAdaptor>(ps->getDiskAdaptor())
+      ->setDiskWriter(std::move(dw));
+
+  IteratableChunkChecksumValidator validator(dctx, ps);
+  validator.init();
+  while (!validator.finished()) {
+    validator.validateChunk();
+  }
+
+  // Only the pieces #1 and #3 were read.
+  CPPUNIT_ASSERT_EQUAL((int64_t)128_k, writer->getReadLength());
+  // A hole is valid if the piece is all zeros.
+  CPPUNIT_ASSERT(ps->hasPiece(0));
+  CPPUNIT_ASSERT(ps->hasPiece(1));
+  CPPUNIT_ASSERT(!ps->hasPiece(2));
+  CPPUNIT_ASSERT(!ps->hasPiece(3));
+}
+
 } // namespace aria2
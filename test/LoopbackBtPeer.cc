@@ -0,0 +1,366 @@
+#include "LoopbackBtPeer.h"
+
+#include <cstring>
+#include <algorithm>
+
+#include "SocketCore.h"
+#include "Exception.h"
+#include "bittorrent_helper.h"
+#include "fmt.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+namespace {
+// Content repeats every 26 bytes.  The buffer holds one extra period
+// so that a write can start at any offset.
+constexpr size_t PERIOD = 26;
+constexpr size_t BLOCK_LENGTH = 16_k;
+
+struct BlockBuffer {
+  unsigned char data[BLOCK_LENGTH + PERIOD];
+  BlockBuffer()
+  {
+    for (size_t i = 0; i < sizeof(data); ++i) {
+      data[i] = 'a' + i % PERIOD;
+    }
+  }
+};
+
+const BlockBuffer& getBlockBuffer()
+{
+  static BlockBuffer buf;
+  return buf;
+}
+} // namespace
+
+namespace {
+constexpr size_t HANDSHAKE_LENGTH = 68;
+// The largest message accepted.  It is enough for a piece message and
+// the bitfield of a torrent of 1M pieces.
+constexpr uint32_t MAX_MESSAGE_LENGTH = 128_k;
+// The number of requests a leecher keeps in flight.
+constexpr int MAX_LEECHER_REQUESTS = 16;
+
+enum {
+  MSG_CHOKE = 0,
+  MSG_UNCHOKE = 1,
+  MSG_INTERESTED = 2,
+  MSG_HAVE = 4,
+  MSG_BITFIELD = 5,
+  MSG_REQUEST = 6,
+  MSG_PIECE = 7
+};
+} // namespace
+
+namespace {
+bool writeAll(SocketCore& socket, const void* data, size_t len)
+{
+  auto p = static_cast<const unsigned char*>(data);
+  while (len > 0) {
+    auto n = socket.writeData(p, len);
+    if (n <= 0) {
+      return false;
+    }
+    p += n;
+    len -= n;
+  }
+  return true;
+}
+} // namespace
+
+namespace {
+// Returns false on EOF.
+bool readAll(SocketCore& socket, void* data, size_t len)
+{
+  auto p = static_cast<unsigned char*>(data);
+  while (len > 0) {
+    size_t n = len;
+    socket.readData(p, n);
+    if (n == 0) {
+      return false;
+    }
+    p += n;
+    len -= n;
+  }
+  return true;
+}
+} // namespace
+
+namespace {
+// Sends a message without payload, or with the integer parameters in
+// |params|.
+bool sendMessage(SocketCore& socket, uint8_t id,
+                 std::initializer_list<uint32_t> params = {})
+{
+  unsigned char msg[17];
+  size_t len = 5 + 4 * params.size();
+  bittorrent::setIntParam(msg, len - 4);
+  msg[4] = id;
+  auto p = msg + 5;
+  for (auto param : params) {
+    bittorrent::setIntParam(p, param);
+    p += 4;
+  }
+  return writeAll(socket, msg, len);
+}
+} // namespace
+
+LoopbackBtPeer::LoopbackBtPeer(const unsigned char* infoHash,
+                               int32_t pieceLength, int64_t totalLength,
+                               bool seeder)
+    : pieceLength_(pieceLength),
+      totalLength_(totalLength),
+      numPieces_((totalLength + pieceLength - 1) / pieceLength),
+      seeder_(seeder),
+      stop_(false),
+      uploadLength_(0),
+      downloadLength_(0),
+      port_(0)
+{
+  memcpy(infoHash_, infoHash, INFO_HASH_LENGTH);
+}
+
+LoopbackBtPeer::~LoopbackBtPeer() { stop(); }
+
+void LoopbackBtPeer::start()
+{
+  serverSocket_ = std::make_shared<SocketCore>();
+  serverSocket_->bind("127.0.0.1", 0, AF_INET);
+  serverSocket_->beginListen();
+  port_ = serverSocket_->getAddrInfo().port;
+  acceptThread_ = std::thread(&LoopbackBtPeer::acceptLoop, this);
+}
+
+void LoopbackBtPeer::stop()
+{
+  if (!acceptThread_.joinable()) {
+    return;
+  }
+  stop_ = true;
+  // Wake up accept() by connecting to ourselves.
+  try {
+    SocketCore waker;
+    waker.establishConnection("127.0.0.1", port_);
+    waker.setBlockingMode();
+    waker.isWritable(1);
+  }
+  catch (Exception& e) {
+  }
+  acceptThread_.join();
+  std::vector<std::thread> workers;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& c : connections_) {
+      shutdown(c->getSockfd(), SHUT_RDWR);
+    }
+    workers.swap(workers_);
+  }
+  for (auto& t : workers) {
+    t.join();
+  }
+  connections_.clear();
+  serverSocket_.reset();
+}
+
+void LoopbackBtPeer::acceptLoop()
+{
+  while (!stop_) {
+    std::shared_ptr<SocketCore> socket;
+    try {
+      socket = serverSocket_->acceptConnection();
+    }
+    catch (Exception& e) {
+      continue;
+    }
+    if (stop_) {
+      break;
+    }
+    socket->setBlockingMode();
+    socket->setTcpNodelay(true);
+    std::lock_guard<std::mutex> lock(mutex_);
+    connections_.push_back(socket);
+    workers_.push_back(std::thread(&LoopbackBtPeer::serve, this, socket));
+  }
+}
+
+void LoopbackBtPeer::serve(const std::shared_ptr<SocketCore>& socket)
+{
+  serveConnection(*socket);
+  // Let the client see EOF.  After a failed encrypted handshake, it
+  // retries with the plain one.
+  shutdown(socket->getSockfd(), SHUT_RDWR);
+}
+
+void LoopbackBtPeer::serveConnection(SocketCore& socket)
+{
+  const auto& block = getBlockBuffer();
+  try {
+    unsigned char handshake[HANDSHAKE_LENGTH];
+    if (!readAll(socket, handshake, sizeof(handshake)) ||
+        handshake[0] != 19 ||
+        memcmp(handshake + 28, infoHash_, INFO_HASH_LENGTH) != 0) {
+      return;
+    }
+    // Reply with no reserved bit set, so that the client uses no
+    // extension.
+    memset(handshake + 20, 0, 8);
+    auto peerId = fmt("-LB0001-%012u", port_);
+    memcpy(handshake + 48, peerId.data(), PEER_ID_LENGTH);
+    if (!writeAll(socket, handshake, sizeof(handshake))) {
+      return;
+    }
+    if (seeder_) {
+      std::vector<unsigned char> bitfield((numPieces_ + 7) / 8, 0xff);
+      if (numPieces_ % 8) {
+        bitfield.back() = 0xff << (8 - numPieces_ % 8);
+      }
+      unsigned char header[5];
+      bittorrent::setIntParam(header, 1 + bitfield.size());
+      header[4] = MSG_BITFIELD;
+      if (!writeAll(socket, header, sizeof(header)) ||
+          !writeAll(socket, bitfield.data(), bitfield.size()) ||
+          !sendMessage(socket, MSG_UNCHOKE)) {
+        return;
+      }
+    }
+
+    // The pieces the client has, and the state of a leecher.
+    std::vector<bool> clientPieces(numPieces_);
+    bool interested = false;
+    bool choked = true;
+    int inFlight = 0;
+    // The next block a leecher requests.  Leechers start at different
+    // pieces, like the ones which select pieces at random.
+    int64_t cursor = static_cast<int64_t>(port_ % numPieces_) * pieceLength_;
+    // Requests the blocks of the pieces the client has from cursor
+    // on, wrapping around at the end.
+    auto requestBlocks = [&]() {
+      for (size_t tried = 0; !choked && inFlight < MAX_LEECHER_REQUESTS &&
+                             tried < numPieces_;) {
+        size_t index = cursor / pieceLength_;
+        if (!clientPieces[index]) {
+          ++tried;
+          cursor = (index + 1) % numPieces_ * pieceLength_;
+          continue;
+        }
+        int64_t pieceEnd = std::min(
+            static_cast<int64_t>(index + 1) * pieceLength_, totalLength_);
+        auto begin = cursor - static_cast<int64_t>(index) * pieceLength_;
+        auto length = std::min(static_cast<int64_t>(BLOCK_LENGTH),
+                               pieceEnd - cursor);
+        if (!sendMessage(socket, MSG_REQUEST,
+                         {static_cast<uint32_t>(index),
+                          static_cast<uint32_t>(begin),
+                          static_cast<uint32_t>(length)})) {
+          return false;
+        }
+        ++inFlight;
+        cursor += length;
+        if (cursor == totalLength_) {
+          cursor = 0;
+        }
+      }
+      return true;
+    };
+    // Sends interested when the client has a piece first.
+    auto onClientPiece = [&](size_t index) {
+      if (index < numPieces_) {
+        clientPieces[index] = true;
+      }
+      if (!interested) {
+        interested = true;
+        return sendMessage(socket, MSG_INTERESTED);
+      }
+      return requestBlocks();
+    };
+
+    std::vector<unsigned char> msg;
+    for (;;) {
+      unsigned char lenbuf[4];
+      if (!readAll(socket, lenbuf, sizeof(lenbuf))) {
+        return;
+      }
+      auto len = bittorrent::getIntParam(lenbuf, 0);
+      if (len == 0) {
+        // keep-alive
+        continue;
+      }
+      if (len > MAX_MESSAGE_LENGTH) {
+        return;
+      }
+      msg.resize(len);
+      if (!readAll(socket, msg.data(), len)) {
+        return;
+      }
+      bool ok = true;
+      switch (msg[0]) {
+      case MSG_CHOKE:
+        // The requests in flight are discarded.
+        choked = true;
+        inFlight = 0;
+        break;
+      case MSG_UNCHOKE:
+        choked = false;
+        ok = seeder_ || requestBlocks();
+        break;
+      case MSG_HAVE:
+        if (!seeder_ && len == 5) {
+          ok = onClientPiece(bittorrent::getIntParam(msg.data(), 1));
+        }
+        break;
+      case MSG_BITFIELD:
+        if (!seeder_) {
+          for (size_t i = 0; i < numPieces_ && i / 8 + 1 < len; ++i) {
+            if (msg[1 + i / 8] & (0x80 >> (i % 8))) {
+              clientPieces[i] = true;
+            }
+          }
+          ok = onClientPiece(numPieces_);
+        }
+        break;
+      case MSG_REQUEST: {
+        if (!seeder_ || len != 13) {
+          break;
+        }
+        auto index = bittorrent::getIntParam(msg.data(), 1);
+        auto begin = bittorrent::getIntParam(msg.data(), 5);
+        auto length = bittorrent::getIntParam(msg.data(), 9);
+        auto offset = static_cast<int64_t>(index) * pieceLength_ + begin;
+        if (index >= numPieces_ || begin + length > pieceLength_ ||
+            offset + length > totalLength_ || length > BLOCK_LENGTH) {
+          return;
+        }
+        unsigned char header[13];
+        bittorrent::setIntParam(header, 9 + length);
+        header[4] = MSG_PIECE;
+        bittorrent::setIntParam(header + 5, index);
+        bittorrent::setIntParam(header + 9, begin);
+        ok = writeAll(socket, header, sizeof(header)) &&
+             writeAll(socket, block.data + offset % PERIOD, length);
+        uploadLength_ += length;
+        break;
+      }
+      case MSG_PIECE:
+        if (!seeder_ && len > 9) {
+          downloadLength_ += len - 9;
+          if (inFlight > 0) {
+            --inFlight;
+          }
+          ok = requestBlocks();
+        }
+        break;
+      default:
+        break;
+      }
+      if (!ok) {
+        return;
+      }
+    }
+  }
+  catch (Exception& e) {
+    // Client went away.
+  }
+}
+
+} // namespace aria2
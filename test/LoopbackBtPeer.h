@@ -0,0 +1,76 @@
+#ifndef D_LOOPBACK_BT_PEER_H
+#define D_LOOPBACK_BT_PEER_H
+
+#include "common.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+#include "BtConstants.h"
+
+namespace aria2 {
+
+class SocketCore;
+
+// Minimal BitTorrent peer listening on the loopback interface.  Like
+// LoopbackHttpServer, it shares generated content: the byte at offset
+// o of the torrent is 'a' + o % 26.  A seeder has all pieces,
+// unchokes the client at once and serves its requests.  A leecher has
+// no piece and downloads the pieces the client announces, keeping 16
+// requests in flight.  It does not keep what it downloads, so that
+// the client uploads as long as it is unchoked.  Extensions and
+// encryption are not supported.  Each connection is served by its own
+// blocking thread.
+class LoopbackBtPeer {
+public:
+  LoopbackBtPeer(const unsigned char* infoHash, int32_t pieceLength,
+                 int64_t totalLength, bool seeder);
+
+  // Calls stop().
+  ~LoopbackBtPeer();
+
+  // Binds an ephemeral port on 127.0.0.1 and starts accepting
+  // connections.
+  void start();
+
+  // Closes all connections and joins threads.
+  void stop();
+
+  uint16_t getPort() const { return port_; }
+
+  // Returns the number of bytes sent in piece messages.
+  int64_t getUploadLength() const { return uploadLength_; }
+
+  // Returns the number of bytes received in piece messages.
+  int64_t getDownloadLength() const { return downloadLength_; }
+
+private:
+  void acceptLoop();
+
+  void serve(const std::shared_ptr<SocketCore>& socket);
+
+  void serveConnection(SocketCore& socket);
+
+  unsigned char infoHash_[INFO_HASH_LENGTH];
+  int32_t pieceLength_;
+  int64_t totalLength_;
+  size_t numPieces_;
+  bool seeder_;
+  std::shared_ptr<SocketCore> serverSocket_;
+  std::thread acceptThread_;
+  std::mutex mutex_;
+  std::vector<std::thread> workers_;
+  std::vector<std::shared_ptr<SocketCore>> connections_;
+  std::atomic<bool> stop_;
+  std::atomic<int64_t> uploadLength_;
+  std::atomic<int64_t> downloadLength_;
+  uint16_t port_;
+};
+
+} // namespace aria2
+
+#endif // D_LOOPBACK_BT_PEER_H
@@ -0,0 +1,351 @@
+#include "LoopbackFtpServer.h"
+
+#include <algorithm>
+#include <deque>
+
+#include "SocketCore.h"
+#include "Exception.h"
+#include "util.h"
+#include "fmt.h"
+#include "a2functional.h"
+#include "A2STR.h"
+
+namespace aria2 {
+
+namespace {
+// Content repeats every 26 bytes.  The buffer holds one extra period
+// so that a write can start at any offset.
+constexpr size_t PERIOD = 26;
+constexpr size_t DATA_CHUNK = 16_k;
+
+struct DataBuffer {
+  unsigned char data[DATA_CHUNK + PERIOD];
+  DataBuffer()
+  {
+    for (size_t i = 0; i < sizeof(data); ++i) {
+      data[i] = 'a' + i % PERIOD;
+    }
+  }
+};
+
+const DataBuffer& getDataBuffer()
+{
+  static DataBuffer buf;
+  return buf;
+}
+} // namespace
+
+namespace {
+bool writeAll(SocketCore& socket, const void* data, size_t len)
+{
+  auto p = static_cast<const unsigned char*>(data);
+  while (len > 0) {
+    auto n = socket.writeData(p, len);
+    if (n <= 0) {
+      return false;
+    }
+    p += n;
+    len -= n;
+  }
+  return true;
+}
+} // namespace
+
+namespace {
+// Returns the length of the file |path|, which is encoded in its
+// name, or -1 if |path| does not name a file.
+int64_t getFileLength(const std::string& path)
+{
+  auto slash = path.rfind('/');
+  auto name = slash == std::string::npos ? path : path.substr(slash + 1);
+  auto dash = name.find('-');
+  int64_t length;
+  if (dash == std::string::npos ||
+      !util::parseLLIntNoThrow(length, name.substr(0, dash)) || length < 0) {
+    return -1;
+  }
+  return length;
+}
+} // namespace
+
+namespace {
+std::string changeDir(const std::string& cwd, const std::string& dir)
+{
+  if (!dir.empty() && dir[0] == '/') {
+    return dir;
+  }
+  if (cwd == "/") {
+    return cwd + dir;
+  }
+  return cwd + "/" + dir;
+}
+} // namespace
+
+LoopbackFtpServer::LoopbackFtpServer()
+    : stop_(false),
+      commandCount_(0),
+      pipelinedCount_(0),
+      connectionCount_(0),
+      responseDelay_(0),
+      port_(0)
+{
+}
+
+LoopbackFtpServer::~LoopbackFtpServer() { stop(); }
+
+void LoopbackFtpServer::start()
+{
+  serverSocket_ = std::make_shared<SocketCore>();
+  serverSocket_->bind("127.0.0.1", 0, AF_INET);
+  serverSocket_->beginListen();
+  port_ = serverSocket_->getAddrInfo().port;
+  acceptThread_ = std::thread(&LoopbackFtpServer::acceptLoop, this);
+}
+
+void LoopbackFtpServer::stop()
+{
+  if (!acceptThread_.joinable()) {
+    return;
+  }
+  stop_ = true;
+  // Wake up accept() by connecting to ourselves.
+  try {
+    SocketCore waker;
+    waker.establishConnection("127.0.0.1", port_);
+    waker.setBlockingMode();
+    waker.isWritable(1);
+  }
+  catch (Exception& e) {
+  }
+  acceptThread_.join();
+  std::vector<std::thread> workers;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& c : connections_) {
+      shutdown(c->getSockfd(), SHUT_RDWR);
+    }
+    workers.swap(workers_);
+  }
+  for (auto& t : workers) {
+    t.join();
+  }
+  connections_.clear();
+  serverSocket_.reset();
+}
+
+std::string LoopbackFtpServer::getURI(const std::string& dir, int64_t length,
+                                      const std::string& name) const
+{
+  return fmt("ftp://127.0.0.1:%u%s/%" PRId64 "-%s", port_, dir.c_str(),
+             length, name.c_str());
+}
+
+std::vector<std::string> LoopbackFtpServer::getCommands() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return commands_;
+}
+
+void LoopbackFtpServer::acceptLoop()
+{
+  while (!stop_) {
+    std::shared_ptr<SocketCore> socket;
+    try {
+      socket = serverSocket_->acceptConnection();
+    }
+    catch (Exception& e) {
+      continue;
+    }
+    if (stop_) {
+      break;
+    }
+    socket->setBlockingMode();
+    socket->setTcpNodelay(true);
+    ++connectionCount_;
+    std::lock_guard<std::mutex> lock(mutex_);
+    connections_.push_back(socket);
+    workers_.push_back(std::thread(&LoopbackFtpServer::serve, this, socket));
+  }
+}
+
+void LoopbackFtpServer::serve(const std::shared_ptr<SocketCore>& socket)
+{
+  const auto& data = getDataBuffer();
+  std::string buf;
+  // Arrival times of the commands in buf
+  std::deque<std::chrono::steady_clock::time_point> arrivals;
+  size_t scanned = 0;
+  // Reads data from the client and records the arrival of the
+  // commands completed by it.  Returns false on EOF.
+  auto readCommands = [&]() {
+    char chunk[4_k];
+    size_t len = sizeof(chunk);
+    socket->readData(chunk, len);
+    if (len == 0) {
+      return false;
+    }
+    buf.append(chunk, len);
+    auto now = std::chrono::steady_clock::now();
+    size_t end;
+    while ((end = buf.find("\r\n", scanned)) != std::string::npos) {
+      arrivals.push_back(now);
+      scanned = end + 2;
+    }
+    return true;
+  };
+  auto lastReply = std::chrono::steady_clock::now();
+  auto reply = [&](const std::string& response) {
+    if (!writeAll(*socket, response.data(), response.size())) {
+      return false;
+    }
+    lastReply = std::chrono::steady_clock::now();
+    return true;
+  };
+  std::string cwd = "/";
+  int64_t restart = 0;
+  std::shared_ptr<SocketCore> dataServer;
+  try {
+    if (!reply("220 aria2 loopback FTP server\r\n")) {
+      return;
+    }
+    for (;;) {
+      while (arrivals.empty()) {
+        if (!readCommands()) {
+          return;
+        }
+      }
+      auto eol = buf.find("\r\n");
+      auto line = buf.substr(0, eol);
+      buf.erase(0, eol + 2);
+      scanned -= eol + 2;
+      auto arrival = arrivals.front();
+      arrivals.pop_front();
+      if (arrival < lastReply) {
+        ++pipelinedCount_;
+      }
+      ++commandCount_;
+
+      auto sp = line.find(' ');
+      auto verb = util::toUpper(line.substr(0, sp));
+      auto arg = sp == std::string::npos ? A2STR::NIL : line.substr(sp + 1);
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        commands_.push_back(verb == "PASS" ? verb : line);
+      }
+
+      // Pick up the commands pipelined by the client before we
+      // reply, so that they are counted as pipelined.
+      while (socket->isReadable(0) && readCommands())
+        ;
+      if (responseDelay_.count() > 0) {
+        std::this_thread::sleep_until(arrival + responseDelay_);
+      }
+
+      std::string response;
+      if (verb == "USER") {
+        response = "331 Password required.\r\n";
+      }
+      else if (verb == "PASS") {
+        response = "230 Logged in.\r\n";
+      }
+      else if (verb == "TYPE") {
+        response = fmt("200 Type set to %s.\r\n", arg.c_str());
+      }
+      else if (verb == "PWD") {
+        response = fmt("257 \"%s\" is the current directory.\r\n", cwd.c_str());
+      }
+      else if (verb == "CWD") {
+        cwd = changeDir(cwd, arg);
+        response = "250 Directory changed.\r\n";
+      }
+      else if (verb == "SIZE" || verb == "MDTM") {
+        auto length = getFileLength(arg);
+        if (length < 0) {
+          response = "550 No such file.\r\n";
+        }
+        else if (verb == "SIZE") {
+          response = fmt("213 %" PRId64 "\r\n", length);
+        }
+        else {
+          response = "213 20100101000000\r\n";
+        }
+      }
+      else if (verb == "EPSV" || verb == "PASV") {
+        dataServer = std::make_shared<SocketCore>();
+        dataServer->bind("127.0.0.1", 0, AF_INET);
+        dataServer->beginListen();
+        auto port = dataServer->getAddrInfo().port;
+        if (verb == "EPSV") {
+          response =
+              fmt("229 Entering Extended Passive Mode (|||%u|)\r\n", port);
+        }
+        else {
+          response = fmt("227 Entering Passive Mode (127,0,0,1,%u,%u).\r\n",
+                         port / 256, port % 256);
+        }
+      }
+      else if (verb == "REST") {
+        if (util::parseLLIntNoThrow(restart, arg) && restart >= 0) {
+          response = fmt("350 Restarting at %" PRId64 ".\r\n", restart);
+        }
+        else {
+          restart = 0;
+          response = "501 Invalid argument.\r\n";
+        }
+      }
+      else if (verb == "RETR") {
+        auto length = getFileLength(arg);
+        if (length < 0) {
+          response = "550 No such file.\r\n";
+        }
+        else if (!dataServer) {
+          response = "425 Use PASV first.\r\n";
+        }
+        else {
+          if (!reply("150 Opening BINARY mode data connection.\r\n")) {
+            return;
+          }
+          response = "226 Transfer complete.\r\n";
+          try {
+            while (!dataServer->isReadable(1)) {
+              if (stop_) {
+                return;
+              }
+            }
+            auto dataSocket = dataServer->acceptConnection();
+            dataSocket->setBlockingMode();
+            for (auto offset = std::min(restart, length); offset < length;) {
+              auto len =
+                  std::min(static_cast<int64_t>(DATA_CHUNK), length - offset);
+              if (!writeAll(*dataSocket, data.data + offset % PERIOD, len)) {
+                response = "426 Connection closed; transfer aborted.\r\n";
+                break;
+              }
+              offset += len;
+            }
+          }
+          catch (Exception& e) {
+            response = "426 Connection closed; transfer aborted.\r\n";
+          }
+          dataServer.reset();
+        }
+        restart = 0;
+      }
+      else if (verb == "QUIT") {
+        reply("221 Goodbye.\r\n");
+        return;
+      }
+      else {
+        response = "502 Command not implemented.\r\n";
+      }
+      if (!reply(response)) {
+        return;
+      }
+    }
+  }
+  catch (Exception& e) {
+    // Client went away.
+  }
+}
+
+} // namespace aria2
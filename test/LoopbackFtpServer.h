@@ -0,0 +1,91 @@
+#ifndef D_LOOPBACK_FTP_SERVER_H
+#define D_LOOPBACK_FTP_SERVER_H
+
+#include "common.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+namespace aria2 {
+
+class SocketCore;
+
+// Minimal FTP server listening on the loopback interface.  Like
+// LoopbackHttpServer, it serves generated content: the file
+// "<dir>/<length>-<name>" has <length> bytes whose byte at offset o is
+// 'a' + o % 26.  Every directory exists.  It implements the commands
+// aria2 sends in passive mode: USER, PASS, TYPE, PWD, CWD, SIZE, MDTM,
+// EPSV, PASV, REST, RETR and QUIT.  Commands are answered in order, so
+// pipelined commands work.  Each control connection is served by its
+// own blocking thread.
+class LoopbackFtpServer {
+public:
+  LoopbackFtpServer();
+
+  // Calls stop().
+  ~LoopbackFtpServer();
+
+  // Binds an ephemeral port on 127.0.0.1 and starts accepting
+  // connections.
+  void start();
+
+  // Closes all connections and joins threads.
+  void stop();
+
+  uint16_t getPort() const { return port_; }
+
+  // Returns URI of the file |name| of |length| bytes in |dir|.  |dir|
+  // must start with "/".
+  std::string getURI(const std::string& dir, int64_t length,
+                     const std::string& name) const;
+
+  // Sets the delay between the arrival of each command and its reply
+  // to emulate round trip time to a remote server.  Must be called
+  // before start().
+  void setResponseDelay(std::chrono::milliseconds delay)
+  {
+    responseDelay_ = delay;
+  }
+
+  // Returns the commands received so far, for example "CWD pub", in
+  // the order they were received.  The argument of PASS is not
+  // recorded.
+  std::vector<std::string> getCommands() const;
+
+  // Returns the number of commands received so far.
+  int64_t getCommandCount() const { return commandCount_; }
+
+  // Returns the number of commands which arrived before the reply to
+  // the previous command on the same connection was sent.
+  int64_t getPipelinedCount() const { return pipelinedCount_; }
+
+  // Returns the number of control connections accepted so far.
+  int64_t getConnectionCount() const { return connectionCount_; }
+
+private:
+  void acceptLoop();
+
+  void serve(const std::shared_ptr<SocketCore>& socket);
+
+  std::shared_ptr<SocketCore> serverSocket_;
+  std::thread acceptThread_;
+  mutable std::mutex mutex_;
+  std::vector<std::thread> workers_;
+  std::vector<std::shared_ptr<SocketCore>> connections_;
+  std::vector<std::string> commands_;
+  std::atomic<bool> stop_;
+  std::atomic<int64_t> commandCount_;
+  std::atomic<int64_t> pipelinedCount_;
+  std::atomic<int64_t> connectionCount_;
+  std::chrono::milliseconds responseDelay_;
+  uint16_t port_;
+};
+
+} // namespace aria2
+
+#endif // D_LOOPBACK_FTP_SERVER_H
@@ -0,0 +1,317 @@
+#include "LoopbackHttpServer.h"
+
+#include <cstring>
+#include <algorithm>
+#include <deque>
+
+#include "SocketCore.h"
+#include "Exception.h"
+#include "util.h"
+#include "fmt.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+namespace {
+// Body content repeats every 26 bytes.  The buffer holds one extra
+// period so that a write can start at any offset.
+constexpr size_t PERIOD = 26;
+constexpr size_t BODY_CHUNK = 16_k;
+
+struct BodyBuffer {
+  unsigned char data[BODY_CHUNK + PERIOD];
+  BodyBuffer()
+  {
+    for (size_t i = 0; i < sizeof(data); ++i) {
+      data[i] = 'a' + i % PERIOD;
+    }
+  }
+};
+
+const BodyBuffer& getBodyBuffer()
+{
+  static BodyBuffer buf;
+  return buf;
+}
+} // namespace
+
+namespace {
+bool writeAll(SocketCore& socket, const void* data, size_t len)
+{
+  auto p = static_cast<const unsigned char*>(data);
+  while (len > 0) {
+    auto n = socket.writeData(p, len);
+    if (n <= 0) {
+      return false;
+    }
+    p += n;
+    len -= n;
+  }
+  return true;
+}
+} // namespace
+
+namespace {
+// Parses "bytes=first-last" or "bytes=first-".  Returns false if
+// |value| is not a single satisfiable range.
+bool parseRange(int64_t& first, int64_t& last, const std::string& value,
+                int64_t length)
+{
+  if (!util::istartsWith(value, "bytes=")) {
+    return false;
+  }
+  auto spec = value.substr(6);
+  auto dash = spec.find('-');
+  if (dash == std::string::npos || dash == 0) {
+    return false;
+  }
+  if (!util::parseLLIntNoThrow(first, spec.substr(0, dash))) {
+    return false;
+  }
+  if (dash + 1 == spec.size()) {
+    last = length - 1;
+  }
+  else if (!util::parseLLIntNoThrow(last, spec.substr(dash + 1))) {
+    return false;
+  }
+  last = std::min(last, length - 1);
+  return 0 <= first && first <= last;
+}
+} // namespace
+
+LoopbackHttpServer::LoopbackHttpServer()
+    : stop_(false),
+      requestCount_(0),
+      connectionCount_(0),
+      responseDelay_(0),
+      port_(0)
+{
+}
+
+LoopbackHttpServer::~LoopbackHttpServer() { stop(); }
+
+void LoopbackHttpServer::start()
+{
+  serverSocket_ = std::make_shared<SocketCore>();
+  serverSocket_->bind("127.0.0.1", 0, AF_INET);
+  serverSocket_->beginListen();
+  port_ = serverSocket_->getAddrInfo().port;
+  acceptThread_ = std::thread(&LoopbackHttpServer::acceptLoop, this);
+}
+
+void LoopbackHttpServer::stop()
+{
+  if (!acceptThread_.joinable()) {
+    return;
+  }
+  stop_ = true;
+  // Wake up accept() by connecting to ourselves.
+  try {
+    SocketCore waker;
+    waker.establishConnection("127.0.0.1", port_);
+    waker.setBlockingMode();
+    waker.isWritable(1);
+  }
+  catch (Exception& e) {
+  }
+  acceptThread_.join();
+  std::vector<std::thread> workers;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& c : connections_) {
+      shutdown(c->getSockfd(), SHUT_RDWR);
+    }
+    workers.swap(workers_);
+  }
+  for (auto& t : workers) {
+    t.join();
+  }
+  connections_.clear();
+  serverSocket_.reset();
+}
+
+std::string LoopbackHttpServer::getURI(int64_t length,
+                                       const std::string& name) const
+{
+  return fmt("http://127.0.0.1:%u/%" PRId64 "/%s", port_, length,
+             name.c_str());
+}
+
+std::string LoopbackHttpServer::getAnnounceURI() const
+{
+  return fmt("http://127.0.0.1:%u/announce", port_);
+}
+
+void LoopbackHttpServer::acceptLoop()
+{
+  while (!stop_) {
+    std::shared_ptr<SocketCore> socket;
+    try {
+      socket = serverSocket_->acceptConnection();
+    }
+    catch (Exception& e) {
+      continue;
+    }
+    if (stop_) {
+      break;
+    }
+    socket->setBlockingMode();
+    socket->setTcpNodelay(true);
+    ++connectionCount_;
+    std::lock_guard<std::mutex> lock(mutex_);
+    connections_.push_back(socket);
+    workers_.push_back(std::thread(&LoopbackHttpServer::serve, this, socket));
+  }
+}
+
+void LoopbackHttpServer::serve(const std::shared_ptr<SocketCore>& socket)
+{
+  const auto& body = getBodyBuffer();
+  std::string buf;
+  // Arrival times of the requests in buf.  The response delay counts
+  // from them, so that pipelined requests are not delayed more than
+  // they would be by a network with that latency.
+  std::deque<std::chrono::steady_clock::time_point> arrivals;
+  size_t scanned = 0;
+  // Reads data from the client and records the arrival of the requests
+  // completed by it.  Returns false on EOF.
+  auto readRequests = [&]() {
+    char data[4_k];
+    size_t len = sizeof(data);
+    socket->readData(data, len);
+    if (len == 0) {
+      return false;
+    }
+    buf.append(data, len);
+    auto now = std::chrono::steady_clock::now();
+    size_t end;
+    while ((end = buf.find("\r\n\r\n", scanned)) != std::string::npos) {
+      arrivals.push_back(now);
+      scanned = end + 4;
+    }
+    return true;
+  };
+  try {
+    for (;;) {
+      while (arrivals.empty()) {
+        if (!readRequests()) {
+          return;
+        }
+      }
+      auto headerEnd = buf.find("\r\n\r\n");
+      auto header = buf.substr(0, headerEnd);
+      buf.erase(0, headerEnd + 4);
+      scanned -= headerEnd + 4;
+      auto arrival = arrivals.front();
+      arrivals.pop_front();
+      ++requestCount_;
+
+      std::vector<std::string> lines;
+      util::split(std::begin(header), std::end(header),
+                  std::back_inserter(lines), '\n', true);
+      std::vector<std::string> requestLine;
+      if (!lines.empty()) {
+        util::split(std::begin(lines[0]), std::end(lines[0]),
+                    std::back_inserter(requestLine), ' ', true);
+      }
+      std::string range;
+      bool keepAlive = true;
+      for (size_t i = 1; i < lines.size(); ++i) {
+        auto colon = lines[i].find(':');
+        if (colon == std::string::npos) {
+          continue;
+        }
+        auto name = lines[i].substr(0, colon);
+        auto value = util::strip(lines[i].substr(colon + 1));
+        if (util::strieq(name, "range")) {
+          range = value;
+        }
+        else if (util::strieq(name, "connection")) {
+          keepAlive = !util::strieq(value, "close");
+        }
+      }
+
+      if (responseDelay_.count() > 0) {
+        // Pick up the requests pipelined while we were busy, so that
+        // their arrival times are not recorded late.
+        while (socket->isReadable(0) && readRequests())
+          ;
+        std::this_thread::sleep_until(arrival + responseDelay_);
+      }
+
+      if (!announceResponse_.empty() && requestLine.size() == 3 &&
+          util::startsWith(requestLine[1], "/announce")) {
+        auto response =
+            fmt("HTTP/1.1 200 OK\r\n"
+                "Content-Length: %lu\r\n"
+                "Content-Type: text/plain\r\n"
+                "%s\r\n",
+                static_cast<unsigned long>(announceResponse_.size()),
+                keepAlive ? "" : "Connection: close\r\n");
+        response += announceResponse_;
+        if (!writeAll(*socket, response.data(), response.size()) ||
+            !keepAlive) {
+          return;
+        }
+        continue;
+      }
+
+      int64_t length = -1;
+      if (requestLine.size() == 3 && requestLine[0] == "GET") {
+        std::vector<std::string> path;
+        util::split(std::begin(requestLine[1]), std::end(requestLine[1]),
+                    std::back_inserter(path), '/');
+        if (path.size() == 2 && !util::parseLLIntNoThrow(length, path[0])) {
+          length = -1;
+        }
+      }
+      if (length < 0) {
+        std::string response = "HTTP/1.1 404 Not Found\r\n"
+                               "Content-Length: 0\r\n\r\n";
+        writeAll(*socket, response.data(), response.size());
+        if (!keepAlive) {
+          return;
+        }
+        continue;
+      }
+
+      int64_t first = 0;
+      int64_t last = length - 1;
+      std::string response;
+      if (!range.empty() && parseRange(first, last, range, length)) {
+        response = fmt("HTTP/1.1 206 Partial Content\r\n"
+                       "Content-Range: bytes %" PRId64 "-%" PRId64
+                       "/%" PRId64 "\r\n",
+                       first, last, length);
+      }
+      else {
+        response = "HTTP/1.1 200 OK\r\n";
+      }
+      response += fmt("Content-Length: %" PRId64 "\r\n"
+                      "Accept-Ranges: bytes\r\n"
+                      "Content-Type: application/octet-stream\r\n"
+                      "%s\r\n",
+                      last - first + 1,
+                      keepAlive ? "" : "Connection: close\r\n");
+      if (!writeAll(*socket, response.data(), response.size())) {
+        return;
+      }
+      for (auto offset = first; offset <= last;) {
+        auto len = std::min(static_cast<int64_t>(BODY_CHUNK),
+                            last - offset + 1);
+        if (!writeAll(*socket, body.data + offset % PERIOD, len)) {
+          return;
+        }
+        offset += len;
+      }
+      if (!keepAlive) {
+        return;
+      }
+    }
+  }
+  catch (Exception& e) {
+    // Client went away.
+  }
+}
+
+} // namespace aria2
@@ -0,0 +1,93 @@
+#ifndef D_LOOPBACK_HTTP_SERVER_H
+#define D_LOOPBACK_HTTP_SERVER_H
+
+#include "common.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+namespace aria2 {
+
+class SocketCore;
+
+// Minimal HTTP/1.1 origin server listening on the loopback interface.
+// It serves generated content, so that benchmarks do not depend on
+// disk contents: the path "/<length>/<name>" returns <length> bytes
+// whose byte at offset o is 'a' + o % 26.  Range requests,
+// persistent connections and pipelining are supported.  Each
+// connection is served by its own blocking thread, so that the server
+// side stays out of the way of the download engine under measurement.
+// It also works as a BitTorrent tracker if setAnnounceResponse() is
+// called.
+class LoopbackHttpServer {
+public:
+  LoopbackHttpServer();
+
+  // Calls stop().
+  ~LoopbackHttpServer();
+
+  // Binds an ephemeral port on 127.0.0.1 and starts accepting
+  // connections.
+  void start();
+
+  // Closes all connections and joins threads.
+  void stop();
+
+  uint16_t getPort() const { return port_; }
+
+  // Returns URI which serves |length| bytes.  |name| becomes the last
+  // path component, which is used as a file name by the client.
+  std::string getURI(int64_t length, const std::string& name) const;
+
+  // Sets the delay between the arrival of each request and its
+  // response to emulate round trip time to a remote server.  Requests
+  // pipelined by the client are answered in order, each no earlier
+  // than the delay after its own arrival.  Must be called before
+  // start().
+  void setResponseDelay(std::chrono::milliseconds delay)
+  {
+    responseDelay_ = delay;
+  }
+
+  // Sets the body returned for the path "/announce" with any query,
+  // for example a bencoded dictionary listing LoopbackBtPeers.  Must
+  // be called before start().
+  void setAnnounceResponse(std::string response)
+  {
+    announceResponse_ = std::move(response);
+  }
+
+  std::string getAnnounceURI() const;
+
+  // Returns the number of requests served so far.
+  int64_t getRequestCount() const { return requestCount_; }
+
+  // Returns the number of connections accepted so far.
+  int64_t getConnectionCount() const { return connectionCount_; }
+
+private:
+  void acceptLoop();
+
+  void serve(const std::shared_ptr<SocketCore>& socket);
+
+  std::shared_ptr<SocketCore> serverSocket_;
+  std::thread acceptThread_;
+  std::mutex mutex_;
+  std::vector<std::thread> workers_;
+  std::vector<std::shared_ptr<SocketCore>> connections_;
+  std::atomic<bool> stop_;
+  std::atomic<int64_t> requestCount_;
+  std::atomic<int64_t> connectionCount_;
+  std::chrono::milliseconds responseDelay_;
+  std::string announceResponse_;
+  uint16_t port_;
+};
+
+} // namespace aria2
+
+#endif // D_LOOPBACK_HTTP_SERVER_H
@@ -230,6 +230,8 @@ public:
 
   virtual void flushWrDiskCacheEntry(bool releaseEntries) CXX11_OVERRIDE {}
 
+  virtual PieceReadCache* getPieceReadCache() CXX11_OVERRIDE { return 0; }
+
   void setDiskAdaptor(const std::shared_ptr<DiskAdaptor>& adaptor)
   {
     this->diskAdaptor = adaptor;
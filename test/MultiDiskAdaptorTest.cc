@@ -11,8 +11,11 @@
 #include "a2io.h"
 #include "array_fun.h"
 #include "TestUtil.h"
-#include "DiskWriter.h"
+#include "AbstractDiskWriter.h"
 #include "WrDiskCacheEntry.h"
+#include "OpenedFileCounter.h"
+#include "DlAbortEx.h"
+#include "File.h"
 
 namespace aria2 {
 
@@ -20,12 +23,17 @@ class MultiDiskAdaptorTest : public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(MultiDiskAdaptorTest);
   CPPUNIT_TEST(testWriteData);
+  CPPUNIT_TEST(testWriteDataVector);
   CPPUNIT_TEST(testReadData);
   CPPUNIT_TEST(testCutTrailingGarbage);
   CPPUNIT_TEST(testSize);
   CPPUNIT_TEST(testUtime);
   CPPUNIT_TEST(testResetDiskWriterEntries);
   CPPUNIT_TEST(testWriteCache);
+  CPPUNIT_TEST(testOpenFile_lazy);
+  CPPUNIT_TEST(testOpenedFileCounter);
+  CPPUNIT_TEST(testWaitWriteback);
+  CPPUNIT_TEST(testWaitWriteback_maxFiles);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -39,12 +47,17 @@ public:
   }
 
   void testWriteData();
+  void testWriteDataVector();
   void testReadData();
   void testCutTrailingGarbage();
   void testSize();
   void testUtime();
   void testResetDiskWriterEntries();
   void testWriteCache();
+  void testOpenFile_lazy();
+  void testOpenedFileCounter();
+  void testWaitWriteback();
+  void testWaitWriteback_maxFiles();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(MultiDiskAdaptorTest);
@@ -89,12 +102,12 @@ void MultiDiskAdaptorTest::testResetDiskWriterEntries()
     adaptor->openFile();
 
     auto& entries = adaptor->getDiskWriterEntries();
-    CPPUNIT_ASSERT(entries[0]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[1]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[2]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[3]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[4]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[5]->getDiskWriter());
+    CPPUNIT_ASSERT(entries[0]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[1]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[2]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[3]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[4]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[5]->usesDiskWriter());
 
     adaptor->closeFile();
   }
@@ -107,12 +120,12 @@ void MultiDiskAdaptorTest::testResetDiskWriterEntries()
 
     auto& entries = adaptor->getDiskWriterEntries();
     // Because entries[1] spans entries[0]
-    CPPUNIT_ASSERT(entries[0]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[1]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[2]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[3]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[4]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[5]->getDiskWriter());
+    CPPUNIT_ASSERT(entries[0]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[1]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[2]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[3]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[4]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[5]->usesDiskWriter());
 
     adaptor->closeFile();
   }
@@ -125,14 +138,14 @@ void MultiDiskAdaptorTest::testResetDiskWriterEntries()
     adaptor->openFile();
 
     auto& entries = adaptor->getDiskWriterEntries();
-    CPPUNIT_ASSERT(!entries[0]->getDiskWriter());
+    CPPUNIT_ASSERT(!entries[0]->usesDiskWriter());
     // Because entries[2] spans entries[1]
-    CPPUNIT_ASSERT(entries[1]->getDiskWriter());
+    CPPUNIT_ASSERT(entries[1]->usesDiskWriter());
     CPPUNIT_ASSERT(entries[1]->needsFileAllocation());
-    CPPUNIT_ASSERT(entries[2]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[3]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[4]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[5]->getDiskWriter());
+    CPPUNIT_ASSERT(entries[2]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[3]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[4]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[5]->usesDiskWriter());
 
     adaptor->closeFile();
   }
@@ -144,14 +157,14 @@ void MultiDiskAdaptorTest::testResetDiskWriterEntries()
     adaptor->openFile();
 
     auto& entries = adaptor->getDiskWriterEntries();
-    CPPUNIT_ASSERT(entries[0]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[1]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[2]->getDiskWriter());
+    CPPUNIT_ASSERT(entries[0]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[1]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[2]->usesDiskWriter());
     // Because entries[4] spans entries[3]
-    CPPUNIT_ASSERT(entries[3]->getDiskWriter());
+    CPPUNIT_ASSERT(entries[3]->usesDiskWriter());
     CPPUNIT_ASSERT(entries[3]->needsFileAllocation());
-    CPPUNIT_ASSERT(entries[4]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[5]->getDiskWriter());
+    CPPUNIT_ASSERT(entries[4]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[5]->usesDiskWriter());
 
     adaptor->closeFile();
   }
@@ -163,13 +176,13 @@ void MultiDiskAdaptorTest::testResetDiskWriterEntries()
     adaptor->openFile();
 
     auto& entries = adaptor->getDiskWriterEntries();
-    CPPUNIT_ASSERT(entries[0]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[1]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[2]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[3]->getDiskWriter());
+    CPPUNIT_ASSERT(entries[0]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[1]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[2]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[3]->usesDiskWriter());
     // entries[3] is 0 length. No overrap with entries[4]
-    CPPUNIT_ASSERT(!entries[4]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[5]->getDiskWriter());
+    CPPUNIT_ASSERT(!entries[4]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[5]->usesDiskWriter());
 
     adaptor->closeFile();
   }
@@ -182,12 +195,12 @@ void MultiDiskAdaptorTest::testResetDiskWriterEntries()
     adaptor->openFile();
 
     auto& entries = adaptor->getDiskWriterEntries();
-    CPPUNIT_ASSERT(entries[0]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[1]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[2]->getDiskWriter());
-    CPPUNIT_ASSERT(!entries[3]->getDiskWriter());
-    CPPUNIT_ASSERT(!entries[4]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[5]->getDiskWriter());
+    CPPUNIT_ASSERT(entries[0]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[1]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[2]->usesDiskWriter());
+    CPPUNIT_ASSERT(!entries[3]->usesDiskWriter());
+    CPPUNIT_ASSERT(!entries[4]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[5]->usesDiskWriter());
 
     adaptor->closeFile();
   }
@@ -201,12 +214,12 @@ void MultiDiskAdaptorTest::testResetDiskWriterEntries()
     adaptor->openFile();
 
     auto& entries = adaptor->getDiskWriterEntries();
-    CPPUNIT_ASSERT(entries[0]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[1]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[2]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[3]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[4]->getDiskWriter());
-    CPPUNIT_ASSERT(!entries[5]->getDiskWriter());
+    CPPUNIT_ASSERT(entries[0]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[1]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[2]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[3]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[4]->usesDiskWriter());
+    CPPUNIT_ASSERT(!entries[5]->usesDiskWriter());
 
     adaptor->closeFile();
   }
@@ -218,12 +231,12 @@ void MultiDiskAdaptorTest::testResetDiskWriterEntries()
     adaptor->setFileEntries(fileEntries.begin(), fileEntries.end());
     adaptor->openFile();
     auto& entries = adaptor->getDiskWriterEntries();
-    CPPUNIT_ASSERT(entries[0]->getDiskWriter());
-    CPPUNIT_ASSERT(!entries[1]->getDiskWriter());
-    CPPUNIT_ASSERT(!entries[2]->getDiskWriter());
-    CPPUNIT_ASSERT(!entries[3]->getDiskWriter());
-    CPPUNIT_ASSERT(!entries[4]->getDiskWriter());
-    CPPUNIT_ASSERT(!entries[5]->getDiskWriter());
+    CPPUNIT_ASSERT(entries[0]->usesDiskWriter());
+    CPPUNIT_ASSERT(!entries[1]->usesDiskWriter());
+    CPPUNIT_ASSERT(!entries[2]->usesDiskWriter());
+    CPPUNIT_ASSERT(!entries[3]->usesDiskWriter());
+    CPPUNIT_ASSERT(!entries[4]->usesDiskWriter());
+    CPPUNIT_ASSERT(!entries[5]->usesDiskWriter());
 
     adaptor->closeFile();
   }
@@ -235,14 +248,14 @@ void MultiDiskAdaptorTest::testResetDiskWriterEntries()
     adaptor->setFileEntries(fileEntries.begin(), fileEntries.end());
     adaptor->openFile();
     auto& entries = adaptor->getDiskWriterEntries();
-    CPPUNIT_ASSERT(entries[0]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[1]->getDiskWriter());
+    CPPUNIT_ASSERT(entries[0]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[1]->usesDiskWriter());
     // entries[1] spans entries[2]
-    CPPUNIT_ASSERT(entries[2]->getDiskWriter());
+    CPPUNIT_ASSERT(entries[2]->usesDiskWriter());
     CPPUNIT_ASSERT(!entries[2]->needsFileAllocation());
-    CPPUNIT_ASSERT(!entries[3]->getDiskWriter());
-    CPPUNIT_ASSERT(!entries[4]->getDiskWriter());
-    CPPUNIT_ASSERT(!entries[5]->getDiskWriter());
+    CPPUNIT_ASSERT(!entries[3]->usesDiskWriter());
+    CPPUNIT_ASSERT(!entries[4]->usesDiskWriter());
+    CPPUNIT_ASSERT(!entries[5]->usesDiskWriter());
 
     adaptor->closeFile();
   }
@@ -255,17 +268,17 @@ void MultiDiskAdaptorTest::testResetDiskWriterEntries()
     adaptor->setFileEntries(fileEntries.begin(), fileEntries.end());
     adaptor->openFile();
     auto& entries = adaptor->getDiskWriterEntries();
-    CPPUNIT_ASSERT(!entries[0]->getDiskWriter());
-    CPPUNIT_ASSERT(!entries[1]->getDiskWriter());
-    CPPUNIT_ASSERT(!entries[2]->getDiskWriter());
-    CPPUNIT_ASSERT(!entries[3]->getDiskWriter());
-    CPPUNIT_ASSERT(!entries[4]->getDiskWriter());
+    CPPUNIT_ASSERT(!entries[0]->usesDiskWriter());
+    CPPUNIT_ASSERT(!entries[1]->usesDiskWriter());
+    CPPUNIT_ASSERT(!entries[2]->usesDiskWriter());
+    CPPUNIT_ASSERT(!entries[3]->usesDiskWriter());
+    CPPUNIT_ASSERT(!entries[4]->usesDiskWriter());
     // entries[6] spans entries[5] in the current implementation.
-    CPPUNIT_ASSERT(entries[5]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[6]->getDiskWriter());
-    CPPUNIT_ASSERT(entries[7]->getDiskWriter());
+    CPPUNIT_ASSERT(entries[5]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[6]->usesDiskWriter());
+    CPPUNIT_ASSERT(entries[7]->usesDiskWriter());
     // entries[6] spans entries[8]
-    CPPUNIT_ASSERT(entries[8]->getDiskWriter());
+    CPPUNIT_ASSERT(entries[8]->usesDiskWriter());
     adaptor->closeFile();
   }
 }
@@ -334,6 +347,34 @@ void MultiDiskAdaptorTest::testWriteData()
   CPPUNIT_ASSERT(File(A2_TEST_OUT_DIR "/file5.txt").isFile());
 }
 
+void MultiDiskAdaptorTest::testWriteDataVector()
+{
+  auto fileEntries = createEntries();
+  adaptor->setFileEntries(std::begin(fileEntries), std::end(fileEntries));
+
+  // Buffers span file1, file2, the empty file3, file4 and file6.  The
+  // empty buffer must be skipped.
+  std::string msgs[] = {"1234567890ABC", "DEFGHIJ", "", "KLMNO"};
+  a2iovec iov[4];
+  for (size_t i = 0; i < 4; ++i) {
+    iov[i].A2IOVEC_BASE = &msgs[i][0];
+    iov[i].A2IOVEC_LEN = msgs[i].size();
+  }
+  adaptor->openFile();
+  adaptor->writeDataVector(iov, 4, 1);
+  adaptor->closeFile();
+
+  CPPUNIT_ASSERT_EQUAL(std::string("1234567890ABCD"),
+                       readFile(A2_TEST_OUT_DIR "/file1.txt").substr(1));
+  CPPUNIT_ASSERT_EQUAL(std::string("EFGHIJK"),
+                       readFile(A2_TEST_OUT_DIR "/file2.txt"));
+  CPPUNIT_ASSERT(File(A2_TEST_OUT_DIR "/file3.txt").isFile());
+  CPPUNIT_ASSERT_EQUAL(std::string("LM"),
+                       readFile(A2_TEST_OUT_DIR "/file4.txt"));
+  CPPUNIT_ASSERT_EQUAL(std::string("NO"),
+                       readFile(A2_TEST_OUT_DIR "/file6.txt"));
+}
+
 void MultiDiskAdaptorTest::testReadData()
 {
   auto entries = std::vector<std::shared_ptr<FileEntry>>{
@@ -483,4 +524,129 @@ void MultiDiskAdaptorTest::testWriteCache()
   CPPUNIT_ASSERT_EQUAL(data2, readFile(entries[0]->getPath()).substr(123));
 }
 
+void MultiDiskAdaptorTest::testOpenFile_lazy()
+{
+  auto fileEntries = createEntries();
+  adaptor->setFileEntries(std::begin(fileEntries), std::end(fileEntries));
+  adaptor->openFile();
+  auto& entries = adaptor->getDiskWriterEntries();
+  // Only zero-length files are created.
+  CPPUNIT_ASSERT(entries[0]->getDiskWriter());
+  CPPUNIT_ASSERT(File(A2_TEST_OUT_DIR "/file0.txt").isFile());
+  CPPUNIT_ASSERT(!entries[1]->getDiskWriter());
+  CPPUNIT_ASSERT(!entries[2]->getDiskWriter());
+  CPPUNIT_ASSERT(!File(A2_TEST_OUT_DIR "/file1.txt").isFile());
+
+  std::string msg = "1234567890ABCDEF";
+  adaptor->writeData((const unsigned char*)msg.c_str(), msg.size(), 0);
+  CPPUNIT_ASSERT(entries[1]->isOpen());
+  CPPUNIT_ASSERT(entries[2]->isOpen());
+  CPPUNIT_ASSERT(!entries[4]->getDiskWriter());
+  adaptor->closeFile();
+  CPPUNIT_ASSERT(!entries[1]->isOpen());
+  CPPUNIT_ASSERT_EQUAL(std::string("F"),
+                       readFile(A2_TEST_OUT_DIR "/file2.txt"));
+}
+
+void MultiDiskAdaptorTest::testOpenedFileCounter()
+{
+  auto counter = std::make_shared<OpenedFileCounter>(3);
+  auto fileEntries = createEntries();
+  adaptor->setFileEntries(std::begin(fileEntries), std::end(fileEntries));
+  adaptor->setOpenedFileCounter(counter);
+  // Avoid opening zero-length files.
+  adaptor->openExistingFile();
+  auto& entries = adaptor->getDiskWriterEntries();
+  unsigned char buf[1] = {'a'};
+  // file1, file2 and file4 are open.
+  adaptor->writeData(buf, 1, 0);
+  adaptor->writeData(buf, 1, 15);
+  adaptor->writeData(buf, 1, 22);
+  // Now file1 is the most recently used one.
+  adaptor->writeData(buf, 1, 1);
+  // file6 is opened and file2 is closed.
+  adaptor->writeData(buf, 1, 24);
+  CPPUNIT_ASSERT(entries[1]->isOpen());
+  CPPUNIT_ASSERT(!entries[2]->isOpen());
+  CPPUNIT_ASSERT(entries[4]->isOpen());
+  CPPUNIT_ASSERT(entries[6]->isOpen());
+
+  // Files of the other download are closed to open a file.
+  std::string storeDir =
+      A2_TEST_OUT_DIR "/aria2_MultiDiskAdaptorTest_testOpenedFileCounter";
+  auto otherEntries = std::vector<std::shared_ptr<FileEntry>>{
+      std::make_shared<FileEntry>(storeDir + "/file1", 1, 0),
+      std::make_shared<FileEntry>(storeDir + "/file2", 1, 1)};
+  MultiDiskAdaptor other;
+  other.setFileEntries(std::begin(otherEntries), std::end(otherEntries));
+  other.setOpenedFileCounter(counter);
+  other.openExistingFile();
+  other.writeData(buf, 1, 0);
+  CPPUNIT_ASSERT(entries[1]->isOpen());
+  CPPUNIT_ASSERT(!entries[4]->isOpen());
+  CPPUNIT_ASSERT(entries[6]->isOpen());
+  other.closeFile();
+  adaptor->closeFile();
+}
+
+void MultiDiskAdaptorTest::testWaitWriteback()
+{
+  auto counter = std::make_shared<OpenedFileCounter>(1);
+  auto fileEntries = createEntries();
+  adaptor->setFileEntries(std::begin(fileEntries), std::end(fileEntries));
+  adaptor->setOpenedFileCounter(counter);
+  adaptor->openExistingFile();
+  auto& entries = adaptor->getDiskWriterEntries();
+  unsigned char buf[1] = {'a'};
+  auto writebackRange = [&](size_t i) {
+    return static_cast<AbstractDiskWriter*>(entries[i]->getDiskWriter().get())
+        ->getWritebackRange();
+  };
+  adaptor->writeData(buf, 1, 0);
+  // file1 is closed to open file2, which synchronizes its data.
+  adaptor->writeData(buf, 1, 15);
+  CPPUNIT_ASSERT(!entries[1]->isOpen());
+  CPPUNIT_ASSERT(std::make_pair((int64_t)0, (int64_t)0) == writebackRange(1));
+  adaptor->startWriteback();
+  CPPUNIT_ASSERT(std::make_pair((int64_t)0, (int64_t)1) == writebackRange(2));
+  // file1 is not opened again, and it is not counted.
+  File(A2_TEST_OUT_DIR "/file1.txt").remove();
+  CPPUNIT_ASSERT(!adaptor->waitWriteback(1));
+  CPPUNIT_ASSERT(std::make_pair((int64_t)0, (int64_t)0) == writebackRange(2));
+  CPPUNIT_ASSERT(adaptor->waitWriteback(1));
+  adaptor->closeFile();
+}
+
+void MultiDiskAdaptorTest::testWaitWriteback_maxFiles()
+{
+  auto fileEntries = createEntries();
+  adaptor->setFileEntries(std::begin(fileEntries), std::end(fileEntries));
+  adaptor->openExistingFile();
+  auto& entries = adaptor->getDiskWriterEntries();
+  unsigned char buf[1] = {'a'};
+  auto writebackRange = [&](size_t i) {
+    return static_cast<AbstractDiskWriter*>(entries[i]->getDiskWriter().get())
+        ->getWritebackRange();
+  };
+  // file1, file2 and file4.  file3, which is empty, is opened too.
+  adaptor->writeData(buf, 1, 0);
+  adaptor->writeData(buf, 1, 15);
+  adaptor->writeData(buf, 1, 22);
+  adaptor->startWriteback();
+  // The files with nothing to wait for are not counted.
+  CPPUNIT_ASSERT(!adaptor->waitWriteback(2));
+  size_t numLeft = 0;
+  for (size_t i : {1, 2, 4}) {
+    if (writebackRange(i).first < writebackRange(i).second) {
+      ++numLeft;
+    }
+  }
+  CPPUNIT_ASSERT_EQUAL((size_t)1, numLeft);
+  CPPUNIT_ASSERT(adaptor->waitWriteback(2));
+  for (size_t i : {1, 2, 4}) {
+    CPPUNIT_ASSERT(writebackRange(i).first >= writebackRange(i).second);
+  }
+  adaptor->closeFile();
+}
+
 } // namespace aria2
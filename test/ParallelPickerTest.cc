@@ -0,0 +1,55 @@
+#include "ParallelPicker.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "a2functional.h"
+
+namespace aria2 {
+
+class ParallelPickerTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(ParallelPickerTest);
+  CPPUNIT_TEST(testPick);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testPick();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ParallelPickerTest);
+
+void ParallelPickerTest::testPick()
+{
+  ParallelPicker<int> picker;
+
+  CPPUNIT_ASSERT(!picker.isPicked());
+  CPPUNIT_ASSERT(!picker.hasNext());
+  CPPUNIT_ASSERT(!picker.pickNext());
+
+  picker.pushEntry(make_unique<int>(1), 100);
+  picker.pushEntry(make_unique<int>(2), 100);
+  picker.pushEntry(make_unique<int>(3), 200);
+
+  CPPUNIT_ASSERT_EQUAL((size_t)3, picker.countEntryInQueue());
+
+  auto first = picker.pickNext();
+  CPPUNIT_ASSERT_EQUAL(1, *first);
+  // 2 has the same key as 1.
+  auto second = picker.pickNext();
+  CPPUNIT_ASSERT_EQUAL(3, *second);
+  CPPUNIT_ASSERT(!picker.pickNext());
+
+  CPPUNIT_ASSERT(picker.isPicked());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, picker.getPickedEntries().size());
+  CPPUNIT_ASSERT(picker.hasNext());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, picker.countEntryInQueue());
+
+  picker.dropPickedEntry(second);
+  CPPUNIT_ASSERT(!picker.pickNext());
+  picker.dropPickedEntry(first);
+  CPPUNIT_ASSERT_EQUAL(2, *picker.pickNext());
+  CPPUNIT_ASSERT(!picker.hasNext());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, picker.getPickedEntries().size());
+}
+
+} // namespace aria2
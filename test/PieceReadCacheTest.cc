@@ -0,0 +1,144 @@
+#include "PieceReadCache.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "DirectDiskAdaptor.h"
+#include "ByteArrayDiskWriter.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+namespace {
+class CountingDiskWriter : public ByteArrayDiskWriter {
+public:
+  CountingDiskWriter() : count_(0) {}
+
+  virtual ssize_t readData(unsigned char* data, size_t len,
+                           int64_t offset) CXX11_OVERRIDE
+  {
+    ++count_;
+    return ByteArrayDiskWriter::readData(data, len, offset);
+  }
+
+  int getCount() const { return count_; }
+
+private:
+  int count_;
+};
+} // namespace
+
+class PieceReadCacheTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(PieceReadCacheTest);
+  CPPUNIT_TEST(testReadData);
+  CPPUNIT_TEST(testReadData_promote);
+  CPPUNIT_TEST(testReadData_largePiece);
+  CPPUNIT_TEST(testRemove);
+  CPPUNIT_TEST_SUITE_END();
+
+  std::shared_ptr<DirectDiskAdaptor> adaptor_;
+  CountingDiskWriter* writer_;
+
+  // Reads |len| bytes at |begin| of the piece |index| of 100 bytes.
+  std::string read(PieceReadCache& cache, a2_gid_t gid, size_t index,
+                   int32_t begin, size_t len);
+
+public:
+  void setUp()
+  {
+    adaptor_ = std::make_shared<DirectDiskAdaptor>();
+    auto dw = make_unique<CountingDiskWriter>();
+    writer_ = dw.get();
+    std::string s;
+    for (int i = 0; i < 1000; ++i) {
+      s += 'a' + i / 100;
+    }
+    writer_->setString(s);
+    adaptor_->setDiskWriter(std::move(dw));
+  }
+
+  void testReadData();
+  void testReadData_promote();
+  void testReadData_largePiece();
+  void testRemove();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(PieceReadCacheTest);
+
+std::string PieceReadCacheTest::read(PieceReadCache& cache, a2_gid_t gid,
+                                     size_t index, int32_t begin, size_t len)
+{
+  unsigned char buf[100];
+  auto r = cache.readData(buf, len, index * 100 + begin, gid, index,
+                          index * 100, 100, adaptor_.get());
+  CPPUNIT_ASSERT_EQUAL((ssize_t)len, r);
+  return std::string(&buf[0], &buf[len]);
+}
+
+void PieceReadCacheTest::testReadData()
+{
+  PieceReadCache cache(400);
+  CPPUNIT_ASSERT_EQUAL(std::string(10, 'b'), read(cache, 1, 1, 10, 10));
+  // The whole piece is read.
+  CPPUNIT_ASSERT_EQUAL(1, writer_->getCount());
+  CPPUNIT_ASSERT_EQUAL((size_t)100, cache.getSize());
+  CPPUNIT_ASSERT_EQUAL(std::string(40, 'b'), read(cache, 1, 1, 60, 40));
+  CPPUNIT_ASSERT_EQUAL(1, writer_->getCount());
+  CPPUNIT_ASSERT_EQUAL((int64_t)1, cache.getHits());
+  CPPUNIT_ASSERT_EQUAL((int64_t)1, cache.getMisses());
+  // The same piece of another download is another entry.
+  read(cache, 2, 1, 0, 10);
+  CPPUNIT_ASSERT_EQUAL(2, writer_->getCount());
+  CPPUNIT_ASSERT_EQUAL((size_t)200, cache.getSize());
+}
+
+void PieceReadCacheTest::testReadData_promote()
+{
+  PieceReadCache cache(400);
+  for (size_t i = 0; i < 5; ++i) {
+    read(cache, 1, i, 0, 10);
+  }
+  // The piece 0 is evicted and remembered.
+  CPPUNIT_ASSERT_EQUAL((size_t)400, cache.getSize());
+  read(cache, 1, 0, 0, 10);
+  CPPUNIT_ASSERT_EQUAL(6, writer_->getCount());
+  // The piece 0 is requested again, so that the pieces read only
+  // once do not evict it.
+  for (size_t i = 5; i < 10; ++i) {
+    read(cache, 1, i, 0, 10);
+  }
+  CPPUNIT_ASSERT_EQUAL(11, writer_->getCount());
+  CPPUNIT_ASSERT_EQUAL(std::string(10, 'a'), read(cache, 1, 0, 90, 10));
+  CPPUNIT_ASSERT_EQUAL(11, writer_->getCount());
+  CPPUNIT_ASSERT_EQUAL((size_t)400, cache.getSize());
+  // The piece 1 was evicted long ago.
+  read(cache, 1, 1, 0, 10);
+  CPPUNIT_ASSERT_EQUAL(12, writer_->getCount());
+}
+
+void PieceReadCacheTest::testReadData_largePiece()
+{
+  PieceReadCache cache(200);
+  CPPUNIT_ASSERT_EQUAL(std::string(10, 'c'), read(cache, 1, 2, 0, 10));
+  CPPUNIT_ASSERT_EQUAL(std::string(10, 'c'), read(cache, 1, 2, 10, 10));
+  CPPUNIT_ASSERT_EQUAL(2, writer_->getCount());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, cache.getSize());
+  CPPUNIT_ASSERT_EQUAL((int64_t)2, cache.getMisses());
+}
+
+void PieceReadCacheTest::testRemove()
+{
+  PieceReadCache cache(400);
+  read(cache, 1, 0, 0, 10);
+  read(cache, 1, 1, 0, 10);
+  read(cache, 2, 0, 0, 10);
+  CPPUNIT_ASSERT_EQUAL((size_t)300, cache.getSize());
+  cache.remove(1);
+  CPPUNIT_ASSERT_EQUAL((size_t)100, cache.getSize());
+  read(cache, 2, 0, 0, 10);
+  CPPUNIT_ASSERT_EQUAL(3, writer_->getCount());
+  read(cache, 1, 0, 0, 10);
+  CPPUNIT_ASSERT_EQUAL(4, writer_->getCount());
+}
+
+} // namespace aria2
@@ -21,6 +21,7 @@
 #include "download_helper.h"
 #include "FileEntry.h"
 #include "RpcMethodFactory.h"
+#include "EngineProfiler.h"
 #ifdef ENABLE_BITTORRENT
 #  include "BtRegistry.h"
 #  include "BtRuntime.h"
@@ -77,6 +78,7 @@ class RpcMethodTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testChangePosition);
   CPPUNIT_TEST(testChangePosition_fail);
   CPPUNIT_TEST(testGetSessionInfo);
+  CPPUNIT_TEST(testGetEngineProfile);
   CPPUNIT_TEST(testChangeUri);
   CPPUNIT_TEST(testChangeUri_fail);
   CPPUNIT_TEST(testPause);
@@ -147,6 +149,7 @@ public:
   void testChangePosition();
   void testChangePosition_fail();
   void testGetSessionInfo();
+  void testGetEngineProfile();
   void testChangeUri();
   void testChangeUri_fail();
   void testPause();
@@ -1284,6 +1287,41 @@ void RpcMethodTest::testGetSessionInfo()
                        getString(downcast<Dict>(res.param), "sessionId"));
 }
 
+void RpcMethodTest::testGetEngineProfile()
+{
+  GetEngineProfileRpcMethod m;
+  auto res = m.execute(createReq(GetEngineProfileRpcMethod::getMethodName()),
+                       e_.get());
+  // Profiling is disabled
+  CPPUNIT_ASSERT_EQUAL(1, res.code);
+
+  e_->setEngineProfiler(make_unique<EngineProfiler>());
+  auto& profiler = e_->getEngineProfiler();
+  profiler->addIteration(std::chrono::microseconds(100), 3);
+  profiler->addPollWait(std::chrono::milliseconds(5));
+  profiler->addCommandExecution(typeid(GetEngineProfileRpcMethod),
+                                std::chrono::microseconds(40));
+  res = m.execute(createReq(GetEngineProfileRpcMethod::getMethodName()),
+                  e_.get());
+  CPPUNIT_ASSERT_EQUAL(0, res.code);
+  const Dict* resParams = downcast<Dict>(res.param);
+  const Dict* iteration = downcast<Dict>(resParams->get("iteration"));
+  CPPUNIT_ASSERT_EQUAL(std::string("1"), getString(iteration, "count"));
+  CPPUNIT_ASSERT_EQUAL(std::string("100"), getString(iteration, "max"));
+  const Dict* pollWait = downcast<Dict>(resParams->get("pollWait"));
+  CPPUNIT_ASSERT_EQUAL(std::string("5000"), getString(pollWait, "sum"));
+  const Dict* commandsPerIteration =
+      downcast<Dict>(resParams->get("commandsPerIteration"));
+  CPPUNIT_ASSERT_EQUAL(std::string("3"),
+                       getString(commandsPerIteration, "max"));
+  const List* commands = downcast<List>(resParams->get("commands"));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, commands->size());
+  const Dict* command = downcast<Dict>(commands->get(0));
+  CPPUNIT_ASSERT_EQUAL(std::string("GetEngineProfileRpcMethod"),
+                       getString(command, "type"));
+  CPPUNIT_ASSERT_EQUAL(std::string("40"), getString(command, "p99"));
+}
+
 void RpcMethodTest::testPause()
 {
   std::vector<std::string> uris{
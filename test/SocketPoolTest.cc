@@ -0,0 +1,210 @@
+#include "SocketPool.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "SocketCore.h"
+#include "Command.h"
+
+namespace aria2 {
+
+class SocketPoolTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(SocketPoolTest);
+  CPPUNIT_TEST(testPop);
+  CPPUNIT_TEST(testEvict);
+  CPPUNIT_TEST(testAcquire);
+  CPPUNIT_TEST(testAcquire_noLimit);
+  CPPUNIT_TEST(testAcquire_closeIdle);
+  CPPUNIT_TEST(testReplaceConnection);
+  CPPUNIT_TEST(testCancel);
+  CPPUNIT_TEST(testHasWaiterBefore);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  std::shared_ptr<SocketCore> serverSocket_;
+  std::shared_ptr<SocketCore> clientSocket_;
+
+public:
+  void setUp()
+  {
+    SocketCore listenSocket;
+    listenSocket.bind(0);
+    listenSocket.beginListen();
+    listenSocket.setBlockingMode();
+    auto port = listenSocket.getAddrInfo().port;
+
+    clientSocket_ = std::make_shared<SocketCore>();
+    clientSocket_->establishConnection("localhost", port);
+    while (!clientSocket_->isWritable(0))
+      ;
+    serverSocket_ = listenSocket.acceptConnection();
+  }
+
+  void testPop();
+  void testEvict();
+  void testAcquire();
+  void testAcquire_noLimit();
+  void testAcquire_closeIdle();
+  void testReplaceConnection();
+  void testCancel();
+  void testHasWaiterBefore();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SocketPoolTest);
+
+namespace {
+class WaitingCommand : public Command {
+public:
+  WaitingCommand(cuid_t cuid) : Command(cuid) {}
+  virtual bool execute() CXX11_OVERRIDE { return true; }
+};
+} // namespace
+
+void SocketPoolTest::testPop()
+{
+  SocketPool pool;
+  pool.add("192.168.0.1(80)", clientSocket_, "baseWorkingDir=/",
+           std::chrono::seconds(15));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, pool.size());
+  std::string options;
+  CPPUNIT_ASSERT(clientSocket_ ==
+                 pool.pop(&options, {"192.168.0.2(80)", "192.168.0.1(80)"}));
+  CPPUNIT_ASSERT_EQUAL(std::string("baseWorkingDir=/"), options);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.size());
+  CPPUNIT_ASSERT(!pool.pop(nullptr, {"192.168.0.1(80)"}));
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, pool.getHitCount());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0, pool.getMissCount());
+}
+
+void SocketPoolTest::testEvict()
+{
+  SocketPool pool;
+  pool.add("192.168.0.1(80)", clientSocket_, "", std::chrono::seconds(0));
+  pool.add("192.168.0.2(80)", std::make_shared<SocketCore>(), "",
+           std::chrono::seconds(15));
+  pool.evict();
+  CPPUNIT_ASSERT_EQUAL((size_t)1, pool.size());
+  // Timed out socket is not returned even if it is not evicted yet.
+  pool.add("192.168.0.1(80)", clientSocket_, "", std::chrono::seconds(0));
+  CPPUNIT_ASSERT(!pool.pop(nullptr, {"192.168.0.1(80)"}));
+}
+
+void SocketPoolTest::testAcquire()
+{
+  SocketPool pool;
+  WaitingCommand c1(1), c2(2);
+  auto s1 = std::make_shared<SocketCore>();
+  auto s2 = std::make_shared<SocketCore>();
+  CPPUNIT_ASSERT(pool.acquire("example.org", 80, 2, &c1));
+  pool.addConnection("example.org", 80, s1);
+  // Adding the same socket again does not count twice.
+  pool.addConnection("example.org", 80, s1);
+  CPPUNIT_ASSERT(pool.acquire("example.org", 80, 2, &c1));
+  pool.addConnection("example.org", 80, s2);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, pool.countConnection("example.org", 80));
+  CPPUNIT_ASSERT_EQUAL((uint64_t)2, pool.getMissCount());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.countConnection("example.org", 443));
+
+  CPPUNIT_ASSERT(!pool.acquire("example.org", 80, 2, &c1));
+  CPPUNIT_ASSERT(!pool.acquire("example.org", 80, 2, &c2));
+  CPPUNIT_ASSERT(pool.hasWaiter());
+  // Other hosts are not affected.
+  CPPUNIT_ASSERT(pool.acquire("example.net", 80, 2, &c2));
+
+  c1.setStatusInactive();
+  c2.setStatusInactive();
+  CPPUNIT_ASSERT(!pool.wakeUp(2));
+  s1.reset();
+  CPPUNIT_ASSERT(pool.wakeUp(2));
+  CPPUNIT_ASSERT(c1.statusMatch(Command::STATUS_ACTIVE));
+  CPPUNIT_ASSERT(!c2.statusMatch(Command::STATUS_ACTIVE));
+  // c2 has to wait for c1 which is queued first.
+  CPPUNIT_ASSERT(!pool.acquire("example.org", 80, 2, &c2));
+  CPPUNIT_ASSERT(pool.acquire("example.org", 80, 2, &c1));
+  auto s3 = std::make_shared<SocketCore>();
+  pool.addConnection("example.org", 80, s3);
+  CPPUNIT_ASSERT(!pool.acquire("example.org", 80, 2, &c2));
+  s2.reset();
+  CPPUNIT_ASSERT(pool.acquire("example.org", 80, 2, &c2));
+  CPPUNIT_ASSERT(!pool.hasWaiter());
+}
+
+void SocketPoolTest::testAcquire_noLimit()
+{
+  SocketPool pool;
+  WaitingCommand c1(1);
+  auto s1 = std::make_shared<SocketCore>();
+  pool.addConnection("example.org", 80, s1);
+  CPPUNIT_ASSERT(!pool.acquire("example.org", 80, 1, &c1));
+  c1.setStatusInactive();
+  // The limit was removed.
+  CPPUNIT_ASSERT(pool.wakeUp(0));
+  CPPUNIT_ASSERT(c1.statusMatch(Command::STATUS_ACTIVE));
+  CPPUNIT_ASSERT(pool.acquire("example.org", 80, 0, &c1));
+  CPPUNIT_ASSERT(!pool.hasWaiter());
+}
+
+void SocketPoolTest::testAcquire_closeIdle()
+{
+  SocketPool pool;
+  WaitingCommand c1(1);
+  pool.addConnection("example.org", 80, clientSocket_);
+  pool.add("192.168.0.1(80)", clientSocket_, "", std::chrono::seconds(15));
+  CPPUNIT_ASSERT(!pool.wakeUp(1));
+  clientSocket_.reset();
+  // The idle connection is closed to make room for a new one.
+  CPPUNIT_ASSERT(pool.acquire("example.org", 80, 1, &c1));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.countConnection("example.org", 80));
+}
+
+void SocketPoolTest::testReplaceConnection()
+{
+  SocketPool pool;
+  auto s1 = std::make_shared<SocketCore>();
+  auto s2 = std::make_shared<SocketCore>();
+  pool.addConnection("example.org", 80, s1);
+  pool.replaceConnection("example.org", 80, s1, s2);
+  s1.reset();
+  CPPUNIT_ASSERT_EQUAL((size_t)1, pool.countConnection("example.org", 80));
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, pool.getMissCount());
+  s2.reset();
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.countConnection("example.org", 80));
+}
+
+void SocketPoolTest::testCancel()
+{
+  SocketPool pool;
+  WaitingCommand c1(1), c2(2);
+  auto s1 = std::make_shared<SocketCore>();
+  pool.addConnection("example.org", 80, s1);
+  CPPUNIT_ASSERT(!pool.acquire("example.org", 80, 1, &c1));
+  CPPUNIT_ASSERT(!pool.acquire("example.org", 80, 1, &c2));
+  pool.cancel(&c1);
+  c2.setStatusInactive();
+  s1.reset();
+  CPPUNIT_ASSERT(pool.wakeUp(1));
+  CPPUNIT_ASSERT(c2.statusMatch(Command::STATUS_ACTIVE));
+  CPPUNIT_ASSERT(pool.acquire("example.org", 80, 1, &c2));
+  CPPUNIT_ASSERT(!pool.hasWaiter());
+}
+
+void SocketPoolTest::testHasWaiterBefore()
+{
+  SocketPool pool;
+  WaitingCommand c1(1), c2(2), c3(3);
+  auto s1 = std::make_shared<SocketCore>();
+  pool.addConnection("example.org", 80, s1);
+  CPPUNIT_ASSERT(!pool.hasWaiterBefore("example.org", 80, &c3));
+  CPPUNIT_ASSERT(!pool.acquire("example.org", 80, 1, &c1));
+  CPPUNIT_ASSERT(!pool.acquire("example.org", 80, 1, &c2));
+  CPPUNIT_ASSERT(!pool.hasWaiterBefore("example.org", 80, &c1));
+  CPPUNIT_ASSERT(pool.hasWaiterBefore("example.org", 80, &c2));
+  // A new command must not take the idle connection from c1 and c2.
+  CPPUNIT_ASSERT(pool.hasWaiterBefore("example.org", 80, &c3));
+  CPPUNIT_ASSERT(!pool.hasWaiterBefore("example.org", 443, &c3));
+  pool.cancel(&c1);
+  CPPUNIT_ASSERT(!pool.hasWaiterBefore("example.org", 80, &c2));
+}
+
+} // namespace aria2
@@ -0,0 +1,120 @@
+#include "TLSSessionCache.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "wallclock.h"
+
+namespace aria2 {
+
+class TLSSessionCacheTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(TLSSessionCacheTest);
+  CPPUNIT_TEST(testPutAndGet);
+  CPPUNIT_TEST(testExpiry);
+  CPPUNIT_TEST(testLifetime);
+  CPPUNIT_TEST(testEvict);
+  CPPUNIT_TEST(testRemove);
+  CPPUNIT_TEST(testHandshakeCounters);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp() { global::wallclock().reset(); }
+
+  void testPutAndGet();
+  void testExpiry();
+  void testLifetime();
+  void testEvict();
+  void testRemove();
+  void testHandshakeCounters();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TLSSessionCacheTest);
+
+void TLSSessionCacheTest::testPutAndGet()
+{
+  TLSSessionCache cache;
+  cache.put("example.org:443", "session1");
+  CPPUNIT_ASSERT_EQUAL(std::string("session1"), cache.get("example.org:443"));
+  CPPUNIT_ASSERT_EQUAL(std::string(""), cache.get("example.org:8443"));
+
+  cache.put("example.org:443", "session2");
+  CPPUNIT_ASSERT_EQUAL(std::string("session2"), cache.get("example.org:443"));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, cache.size());
+
+  // Empty data is not stored.
+  cache.put("example.net:443", "");
+  CPPUNIT_ASSERT_EQUAL((size_t)1, cache.size());
+}
+
+void TLSSessionCacheTest::testExpiry()
+{
+  TLSSessionCache cache(16, std::chrono::seconds(60));
+  cache.put("example.org:443", "session");
+  global::wallclock().advance(std::chrono::seconds(59));
+  CPPUNIT_ASSERT_EQUAL(std::string("session"), cache.get("example.org:443"));
+  global::wallclock().advance(std::chrono::seconds(1));
+  CPPUNIT_ASSERT_EQUAL(std::string(""), cache.get("example.org:443"));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, cache.size());
+}
+
+void TLSSessionCacheTest::testLifetime()
+{
+  TLSSessionCache cache(16, std::chrono::seconds(60));
+  cache.put("short:443", "session", std::chrono::seconds(10));
+  // Lifetime longer than TTL is capped by TTL.
+  cache.put("long:443", "session", std::chrono::seconds(3600));
+  global::wallclock().advance(std::chrono::seconds(10));
+  CPPUNIT_ASSERT_EQUAL(std::string(""), cache.get("short:443"));
+  CPPUNIT_ASSERT_EQUAL(std::string("session"), cache.get("long:443"));
+  global::wallclock().advance(std::chrono::seconds(50));
+  CPPUNIT_ASSERT_EQUAL(std::string(""), cache.get("long:443"));
+}
+
+void TLSSessionCacheTest::testEvict()
+{
+  TLSSessionCache cache(2, std::chrono::seconds(60));
+  cache.put("a:443", "A");
+  global::wallclock().advance(std::chrono::seconds(1));
+  cache.put("b:443", "B");
+  global::wallclock().advance(std::chrono::seconds(1));
+  // a becomes the most recently used one.
+  cache.get("a:443");
+  global::wallclock().advance(std::chrono::seconds(1));
+  cache.put("c:443", "C");
+  CPPUNIT_ASSERT_EQUAL((size_t)2, cache.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("A"), cache.get("a:443"));
+  CPPUNIT_ASSERT_EQUAL(std::string(""), cache.get("b:443"));
+  CPPUNIT_ASSERT_EQUAL(std::string("C"), cache.get("c:443"));
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, cache.getNumEvicted());
+
+  // Expired entries are evicted before the least recently used one.
+  cache.put("d:443", "D", std::chrono::seconds(1));
+  CPPUNIT_ASSERT_EQUAL((uint64_t)2, cache.getNumEvicted());
+  global::wallclock().advance(std::chrono::seconds(1));
+  cache.put("e:443", "E");
+  CPPUNIT_ASSERT_EQUAL((uint64_t)3, cache.getNumEvicted());
+  CPPUNIT_ASSERT_EQUAL(std::string(""), cache.get("d:443"));
+  CPPUNIT_ASSERT_EQUAL(std::string("E"), cache.get("e:443"));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, cache.size());
+}
+
+void TLSSessionCacheTest::testRemove()
+{
+  TLSSessionCache cache;
+  cache.put("example.org:443", "session");
+  cache.remove("example.org:443");
+  CPPUNIT_ASSERT_EQUAL(std::string(""), cache.get("example.org:443"));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, cache.size());
+}
+
+void TLSSessionCacheTest::testHandshakeCounters()
+{
+  TLSSessionCache cache;
+  cache.addHandshake(false);
+  cache.addHandshake(true);
+  cache.addHandshake(true);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, cache.getNumFullHandshakes());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)2, cache.getNumResumedHandshakes());
+}
+
+} // namespace aria2
@@ -0,0 +1,169 @@
+#include "Benchmark.h"
+
+#include <memory>
+#ifdef __GLIBC__
+#  include <malloc.h>
+#endif // __GLIBC__
+#ifdef HAVE_SYS_RESOURCE_H
+#  include <sys/resource.h>
+#endif // HAVE_SYS_RESOURCE_H
+
+#include "bittorrent_helper.h"
+#include "DownloadContext.h"
+#include "Option.h"
+#include "prefs.h"
+#include "bencode2.h"
+#include "fmt.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+namespace bench {
+
+#if defined(__GLIBC__) &&                                                      \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#  define A2_BENCH_HAVE_MALLINFO2 1
+#endif
+
+namespace {
+// Returns the number of bytes allocated from the heap, or 0 if it is
+// not available.
+int64_t getHeapBytes()
+{
+#ifdef A2_BENCH_HAVE_MALLINFO2
+  return mallinfo2().uordblks;
+#else  // !A2_BENCH_HAVE_MALLINFO2
+  return 0;
+#endif // !A2_BENCH_HAVE_MALLINFO2
+}
+} // namespace
+
+namespace {
+// Returns the peak resident set size of the process in bytes, or 0 if
+// it is not available.  Run the workload alone to get its peak.
+int64_t getMaxRss()
+{
+#if defined(HAVE_SYS_RESOURCE_H) && defined(__linux__)
+  struct rusage ru;
+  if (getrusage(RUSAGE_SELF, &ru) == 0) {
+    return static_cast<int64_t>(ru.ru_maxrss) * 1024;
+  }
+#endif // HAVE_SYS_RESOURCE_H && __linux__
+  return 0;
+}
+} // namespace
+
+namespace {
+// Creates a single file torrent of |numPieces| pieces of 16KiB.
+std::string createTorrent(int64_t numPieces)
+{
+  std::string pieces;
+  pieces.reserve(numPieces * 20);
+  for (int64_t i = 0; i < numPieces; ++i) {
+    pieces.append(20, 'A' + i % 26);
+  }
+  auto info = Dict::g();
+  info->put("name", "huge");
+  info->put("piece length", Integer::g(16_k));
+  info->put("length", Integer::g(numPieces * 16_k));
+  info->put("pieces", std::move(pieces));
+  Dict dict;
+  dict.put("announce", "http://tracker.example.org/announce");
+  dict.put("info", std::move(info));
+  return bencode2::encode(&dict);
+}
+} // namespace
+
+namespace {
+// Loads a torrent of 200000 pieces, which is a 3GiB file in 16KiB
+// pieces, 10 * |scale| times.  heap_bytes is the heap used by the
+// last DownloadContext.
+void loadHugeTorrent(Result& result, int scale)
+{
+  const int64_t numPieces = 200000;
+  auto torrent = createTorrent(numPieces);
+  auto option = std::make_shared<Option>();
+  option->put(PREF_DIR, ".");
+  std::shared_ptr<DownloadContext> dctx;
+  int64_t heapBytes = 0;
+  for (int i = 0; i < 10 * scale; ++i) {
+    dctx.reset();
+    auto heapStart = getHeapBytes();
+    {
+      Measure measure(result);
+      dctx = std::make_shared<DownloadContext>();
+      bittorrent::loadFromMemory(torrent, dctx, option, "default");
+    }
+    heapBytes = getHeapBytes() - heapStart;
+    result.bytes += torrent.size();
+    ++result.items;
+  }
+  result.metrics.push_back(
+      {"pieces", static_cast<int64_t>(dctx->countPieceHash())});
+  result.metrics.push_back({"heap_bytes", heapBytes});
+}
+} // namespace
+
+A2_BENCH_REGISTER("torrent-load-huge", loadHugeTorrent);
+
+namespace {
+// Creates a multi file torrent of |numFiles| files of 16KiB in
+// directories of 100 files.  The torrent is encoded by hand, so that
+// building it does not raise the peak memory usage.
+std::string createMultiFileTorrent(int64_t numFiles)
+{
+  std::string torrent = "d8:announce35:http://tracker.example.org/announce"
+                        "4:infod5:filesl";
+  for (int64_t i = 0; i < numFiles; ++i) {
+    auto dir = fmt("dir%" PRId64, i / 100);
+    auto file = fmt("file%" PRId64, i);
+    torrent += fmt("d6:lengthi16384e4:pathl%lu:%s%lu:%see",
+                   static_cast<unsigned long>(dir.size()), dir.c_str(),
+                   static_cast<unsigned long>(file.size()), file.c_str());
+  }
+  torrent += fmt("e4:name4:many12:piece lengthi16384e6:pieces%" PRId64 ":",
+                 numFiles * 20);
+  torrent.append(numFiles * 20, 'A');
+  torrent += "ee";
+  return torrent;
+}
+} // namespace
+
+namespace {
+// Loads a torrent of 300000 files, which has about 20MB of metainfo,
+// |scale| times.  heap_bytes is the heap used by the last
+// DownloadContext, and max_rss_bytes is the peak memory usage of the
+// process.
+void loadManyFileTorrent(Result& result, int scale)
+{
+  const int64_t numFiles = 300000;
+  auto torrent = createMultiFileTorrent(numFiles);
+  auto option = std::make_shared<Option>();
+  option->put(PREF_DIR, ".");
+  option->put(PREF_MAX_CONNECTION_PER_SERVER, "1");
+  std::shared_ptr<DownloadContext> dctx;
+  int64_t heapBytes = 0;
+  for (int i = 0; i < scale; ++i) {
+    dctx.reset();
+    auto heapStart = getHeapBytes();
+    {
+      Measure measure(result);
+      dctx = std::make_shared<DownloadContext>();
+      bittorrent::loadFromMemory(torrent, dctx, option, "default");
+    }
+    heapBytes = getHeapBytes() - heapStart;
+    result.bytes += torrent.size();
+    ++result.items;
+  }
+  result.metrics.push_back(
+      {"files", static_cast<int64_t>(dctx->getFileEntries().size())});
+  result.metrics.push_back({"heap_bytes", heapBytes});
+  result.metrics.push_back({"max_rss_bytes", getMaxRss()});
+}
+} // namespace
+
+A2_BENCH_REGISTER("torrent-load-many-files", loadManyFileTorrent);
+
+} // namespace bench
+
+} // namespace aria2